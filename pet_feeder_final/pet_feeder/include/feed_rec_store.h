@@ -0,0 +1,45 @@
+#pragma once
+#include <Arduino.h>
+#include <SPIFFS.h>
+#include "feed_rec.h"
+
+// Feed recordings on SPIFFS (feed_rec.h). A recording is written in one
+// go once the feed has settled, so a power cut mid-write loses at most that
+// feed; the replay tool stops at a short read.
+class FeedRecStore {
+ public:
+  bool append(const FeedRecHeader& h, const FeedRecSample* samples) {
+    File f = SPIFFS.open(REC_PATH, FILE_APPEND);
+    if (!f) return false;
+    size_t bytes = h.samples * sizeof(FeedRecSample);
+    bool ok = f.write((const uint8_t*)&h, sizeof(h)) == sizeof(h) &&
+              f.write((const uint8_t*)samples, bytes) == bytes;
+    size_t size = f.size();
+    f.close();
+    if (size >= REC_FILE_MAX) {
+      SPIFFS.remove(REC_OLD_PATH);
+      SPIFFS.rename(REC_PATH, REC_OLD_PATH);
+    }
+    return ok;
+  }
+
+  // Both files, oldest first; a download is their concatenation
+  size_t size() {
+    return fileSize(REC_OLD_PATH) + fileSize(REC_PATH);
+  }
+
+  void clear() {
+    SPIFFS.remove(REC_OLD_PATH);
+    SPIFFS.remove(REC_PATH);
+  }
+
+ private:
+  static size_t fileSize(const char* path) {
+    if (!SPIFFS.exists(path)) return 0;
+    File f = SPIFFS.open(path, FILE_READ);
+    if (!f) return 0;
+    size_t n = f.size();
+    f.close();
+    return n;
+  }
+};
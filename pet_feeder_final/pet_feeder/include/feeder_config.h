@@ -0,0 +1,198 @@
+#pragma once
+#include <stdint.h>
+#include "feeder_features.h"
+#include "dispense.h"
+#include "logger.h"
+#include "serial_proto.h"
+
+// Board configuration for every feeder variant we build.
+//
+// Everything that used to be a scattered #define or global (pins, LCD geometry,
+// slot/log capacity, safety timeouts, the sim-weight switch) lives in one
+// constexpr FeederConfig per variant. The build selects a variant with
+// -DFEEDER_VARIANT=<name> (see platformio.ini) and the templated hardware
+// components in feeder_hw.h are specialized on it, so a headless image never
+// instantiates LCD code and a real-scale image never carries the simulator.
+// Which software features an image carries is set apart from the board, in
+// feeder_features.h.
+
+struct FeederConfig {
+  const char* name;
+
+  // ---- Pins ----
+  uint8_t hx711DtPin;
+  uint8_t hx711SckPin;
+  uint8_t servoPin;
+  uint8_t i2cSdaPin;
+  uint8_t i2cSclPin;
+  uint8_t buttonDisplay;
+  uint8_t buttonSetting;
+  uint8_t buttonUp;
+  uint8_t buttonDown;
+
+  // ---- Weight sensor ----
+  bool    simFakeWeight;       // true in Wokwi: bowl weight is simulated
+  float   calibrationFactor;   // counts per gram until a span capture sets it
+  uint8_t hx711Samples;        // conversions averaged per reading
+
+  // ---- Servo ----
+  int servoCloseAngle;
+  int servoOpenAngle;
+  uint8_t dispenseMode;        // DispenseMode for feeds that do not pick one
+
+  // ---- Display & buttons ----
+  bool    hasLcd;
+  uint8_t lcdAddress;          // If blank, try 0x3F
+  uint8_t lcdCols;
+  uint8_t lcdRows;
+  bool    hasButtons;
+
+  // ---- Schedule & history capacity ----
+  uint8_t slotCount;
+  uint8_t maxFeedLogs;
+
+  // ---- Safety & stuck detection ----
+  // Used until a few feeds are known, then bounds for the limits learned
+  // from them (flow_stats.h).
+  unsigned long feedTimeoutMs;   // safety timeout
+  unsigned long stuckWindowMs;   // no increase for this long -> consider stuck
+  float         minIncreaseG;    // noise floor for "increase"
+
+  // ---- Feed queue ----
+  uint8_t  feedQueueDepth;       // waiting feed commands
+  uint32_t feedMaxWaitMs;        // a command not started by then is dropped
+
+  // ---- Hopper inventory ----
+  float    hopperCapacityG;      // what a full hopper holds
+  uint16_t hopperWarnHours;      // warn when the forecast runs out within this
+
+  // ---- History (SPIFFS, /api/export) ----
+  uint16_t historySampleSecs;    // bowl weight sample interval
+
+  // ---- HTTP admission (admission.h) ----
+  uint16_t httpClientRate;       // requests/s per client IP
+  uint16_t httpClientBurst;      // back-to-back requests per client IP
+  uint8_t  httpTickBudget;       // requests of all clients per 100 ms
+
+  // ---- Diagnostics ----
+  uint16_t traceRecords;         // trace ring size (power of two, 16 B each)
+  uint16_t recordSamples;        // feed recording buffer (12 B each), 0 = off
+  uint16_t serialTxBytes;        // binary serial protocol TX ring (serial_proto.h)
+
+  // ---- Logging (logger.h) ----
+  uint16_t logRecords;           // log ring size (power of two, 64 B each)
+  uint8_t  logTailLines;         // newest lines kept for /api/logs (128 B each)
+  uint8_t  logFlashLevel;        // LogLevel also appended to SPIFFS, LOG_LEVEL_NONE = off
+};
+
+namespace feeder_variants {
+
+// Wokwi simulation (diagram.json): fake bowl weight, full UI.
+constexpr FeederConfig kWokwiSim = {
+  "wokwi-sim",
+  4, 5, 18, 21, 22,
+  12, 13, 14, 15,
+  true, -7050.0f, 5,
+  0, 180, DISPENSE_TRICKLE,
+  true, 0x27, 20, 4, true,
+  3, 10,
+  15000, 4000, 2.0f,
+  4, 300000,
+  2000.0f, 24,
+  60,
+  10, 20, 4,
+  2048, 1536, 4096,
+  64, 32, LOG_LEVEL_INFO
+};
+
+// Real hardware, one bowl: same wiring as the sim, real HX711.
+constexpr FeederConfig kSingleBowl = {
+  "single-bowl",
+  4, 5, 18, 21, 22,
+  12, 13, 14, 15,
+  false, -7050.0f, 5,
+  0, 180, DISPENSE_TRICKLE,
+  true, 0x27, 20, 4, true,
+  3, 10,
+  15000, 4000, 2.0f,
+  4, 300000,
+  2000.0f, 24,
+  60,
+  10, 20, 4,
+  2048, 1536, 4096,
+  64, 32, LOG_LEVEL_WARN
+};
+
+// Multi-bowl station: one dispenser serving more bowls, so more daily slots,
+// a longer history and more time for the larger portions.
+constexpr FeederConfig kMultiBowl = {
+  "multi-bowl",
+  4, 5, 18, 21, 22,
+  12, 13, 14, 15,
+  false, -7050.0f, 5,
+  0, 180, DISPENSE_TRICKLE,
+  true, 0x27, 20, 4, true,
+  6, 20,
+  30000, 4000, 2.0f,
+  8, 300000,
+  4000.0f, 24,
+  60,
+  10, 20, 4,
+  2048, 1536, 4096,
+  64, 32, LOG_LEVEL_WARN
+};
+
+// Headless: no LCD and no buttons, driven only through the HTTP API.
+constexpr FeederConfig kHeadless = {
+  "headless",
+  4, 5, 18, 21, 22,
+  0, 0, 0, 0,
+  false, -7050.0f, 5,
+  0, 180, DISPENSE_TRICKLE,
+  false, 0, 0, 0, false,
+  3, 10,
+  15000, 4000, 2.0f,
+  4, 300000,
+  2000.0f, 24,
+  60,
+  20, 40, 6,
+  2048, 1536, 4096,
+  128, 64, LOG_LEVEL_INFO
+};
+
+}  // namespace feeder_variants
+
+#ifndef FEEDER_VARIANT
+#define FEEDER_VARIANT kWokwiSim
+#endif
+
+// The configuration this image is built for.
+constexpr const FeederConfig& kBoard = feeder_variants::FEEDER_VARIANT;
+
+// Default slot times; slots beyond these start at 00:00.
+constexpr int kDefaultSlotHours[] = {8, 12, 18, 10, 14, 20};
+constexpr int defaultSlotHour(int i) {
+  return i < (int)(sizeof(kDefaultSlotHours) / sizeof(kDefaultSlotHours[0]))
+             ? kDefaultSlotHours[i] : 0;
+}
+
+static_assert(kBoard.slotCount > 0, "at least one feeding slot");
+static_assert(kBoard.maxFeedLogs > 0, "at least one feed log entry");
+static_assert(kBoard.historySampleSecs > 0, "weight history needs a sample interval");
+static_assert(kBoard.feedQueueDepth > 0, "at least one queued feed");
+static_assert(kBoard.dispenseMode < DISPENSE_MODE_COUNT, "unknown dispense profile");
+static_assert(kBoard.httpClientRate > 0 && kBoard.httpClientBurst > 0 && kBoard.httpTickBudget > 0,
+              "HTTP admission limits must let requests through");
+static_assert((kBoard.traceRecords & (kBoard.traceRecords - 1)) == 0,
+              "trace ring size must be a power of two");
+static_assert(kBoard.serialTxBytes >= serialFrameMax(SERIAL_PAYLOAD_MAX),
+              "serial TX ring must hold the largest frame");
+static_assert(kBoard.logRecords > 0 && (kBoard.logRecords & (kBoard.logRecords - 1)) == 0,
+              "log ring size must be a power of two");
+static_assert(kBoard.logTailLines > 0, "/api/logs needs at least one line");
+static_assert(!kBoard.hasLcd || kBoard.lcdRows >= 4, "UI needs a 4-line LCD");
+static_assert(!kBoard.hasLcd || FEEDER_LCD, "this variant has an LCD: build with FEEDER_LCD=1");
+static_assert(!kBoard.hasButtons || FEEDER_BUTTONS,
+              "this variant has buttons: build with FEEDER_BUTTONS=1");
+static_assert(!kBoard.simFakeWeight || FEEDER_SIM,
+              "this variant simulates the scale: build with FEEDER_SIM=1");
@@ -0,0 +1,139 @@
+#pragma once
+
+// Build-time feature switches.
+//
+// Where FeederConfig says what a board has, these say what an image carries:
+// a feature switched off is left out of the build together with the
+// libraries only it includes (lib_ldf_mode = chain+ follows the #if around
+// an #include), so it costs neither flash nor RAM nor boot time. Each is 0
+// or 1, on unless an env in platformio.ini turns it off with -D.
+//
+//   FEEDER_HTTP_API     WiFi, the web server and every /api route
+//   FEEDER_WEB_UI       the page at / (web_ui.h); needs FEEDER_HTTP_API
+//   FEEDER_ADMISSION    HTTP rate limits (admission.h); needs FEEDER_HTTP_API
+//   FEEDER_LCD          the I2C LCD driver
+//   FEEDER_BUTTONS      the four front buttons and the setting UI
+//   FEEDER_SERIAL_PROTO binary serial diagnostics (serial_proto.h); off, the
+//                       port is a plain text console
+//   FEEDER_TRACE        the event trace ring (trace.h)
+//   FEEDER_SIM          the flow simulator behind the Wokwi fake scale
+//   FEEDER_OTA          POST /api/ota updates (ota_image.h); needs
+//                       FEEDER_HTTP_API, and takes none unless the env also
+//                       sets FEEDER_OTA_KEY (the release key's public half,
+//                       64 hex digits from tools/ota_sign.py) and
+//                       FEEDER_OTA_TOKEN (the bearer token callers send)
+//
+// A variant must not ask for hardware support its image leaves out; the
+// static_asserts at the bottom of feeder_config.h catch that.
+
+#ifndef FEEDER_HTTP_API
+#define FEEDER_HTTP_API 1
+#endif
+
+#ifndef FEEDER_WEB_UI
+#define FEEDER_WEB_UI FEEDER_HTTP_API
+#endif
+
+#ifndef FEEDER_ADMISSION
+#define FEEDER_ADMISSION FEEDER_HTTP_API
+#endif
+
+#ifndef FEEDER_LCD
+#define FEEDER_LCD 1
+#endif
+
+#ifndef FEEDER_BUTTONS
+#define FEEDER_BUTTONS 1
+#endif
+
+#ifndef FEEDER_SERIAL_PROTO
+#define FEEDER_SERIAL_PROTO 1
+#endif
+
+#ifndef FEEDER_TRACE
+#define FEEDER_TRACE 1
+#endif
+
+#ifndef FEEDER_SIM
+#define FEEDER_SIM 1
+#endif
+
+#ifndef FEEDER_OTA
+#define FEEDER_OTA FEEDER_HTTP_API
+#endif
+
+#ifndef FEEDER_OTA_KEY
+#define FEEDER_OTA_KEY ""
+#endif
+
+#ifndef FEEDER_OTA_TOKEN
+#define FEEDER_OTA_TOKEN ""
+#endif
+
+#if FEEDER_WEB_UI && !FEEDER_HTTP_API
+#error "FEEDER_WEB_UI needs FEEDER_HTTP_API"
+#endif
+#if FEEDER_ADMISSION && !FEEDER_HTTP_API
+#error "FEEDER_ADMISSION needs FEEDER_HTTP_API"
+#endif
+#if FEEDER_OTA && !FEEDER_HTTP_API
+#error "FEEDER_OTA needs FEEDER_HTTP_API"
+#endif
+
+// What this image carries, for the boot log: a string literal, " http
+// web-ui ...", so it goes out in the log format itself. As a %s argument
+// it would be cut to LOG_ARG_BYTES, shorter than a full build's list.
+#if FEEDER_HTTP_API
+#define FEEDER_FEATURE_HTTP_ " http"
+#else
+#define FEEDER_FEATURE_HTTP_ ""
+#endif
+#if FEEDER_WEB_UI
+#define FEEDER_FEATURE_WEB_UI_ " web-ui"
+#else
+#define FEEDER_FEATURE_WEB_UI_ ""
+#endif
+#if FEEDER_ADMISSION
+#define FEEDER_FEATURE_ADMISSION_ " admission"
+#else
+#define FEEDER_FEATURE_ADMISSION_ ""
+#endif
+#if FEEDER_LCD
+#define FEEDER_FEATURE_LCD_ " lcd"
+#else
+#define FEEDER_FEATURE_LCD_ ""
+#endif
+#if FEEDER_BUTTONS
+#define FEEDER_FEATURE_BUTTONS_ " buttons"
+#else
+#define FEEDER_FEATURE_BUTTONS_ ""
+#endif
+#if FEEDER_SERIAL_PROTO
+#define FEEDER_FEATURE_SERIAL_PROTO_ " serial-proto"
+#else
+#define FEEDER_FEATURE_SERIAL_PROTO_ ""
+#endif
+#if FEEDER_TRACE
+#define FEEDER_FEATURE_TRACE_ " trace"
+#else
+#define FEEDER_FEATURE_TRACE_ ""
+#endif
+#if FEEDER_SIM
+#define FEEDER_FEATURE_SIM_ " sim"
+#else
+#define FEEDER_FEATURE_SIM_ ""
+#endif
+#if FEEDER_OTA
+#define FEEDER_FEATURE_OTA_ " ota"
+#else
+#define FEEDER_FEATURE_OTA_ ""
+#endif
+
+#define FEEDER_FEATURE_LIST                                                    \
+  FEEDER_FEATURE_HTTP_ FEEDER_FEATURE_WEB_UI_ FEEDER_FEATURE_ADMISSION_        \
+  FEEDER_FEATURE_LCD_ FEEDER_FEATURE_BUTTONS_ FEEDER_FEATURE_SERIAL_PROTO_     \
+  FEEDER_FEATURE_TRACE_ FEEDER_FEATURE_SIM_ FEEDER_FEATURE_OTA_
+
+// The boot line, logged with millis() at the end of setup();
+// scripts/size_report.py reads "Boot: ready in N ms" from it
+#define FEEDER_BOOT_LOG_FORMAT "Boot: ready in %lu ms, features:" FEEDER_FEATURE_LIST
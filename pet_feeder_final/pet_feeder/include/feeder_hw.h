@@ -0,0 +1,152 @@
+#pragma once
+#include <Arduino.h>
+#include <type_traits>
+#include <HX711.h>
+#include <ESP32Servo.h>
+#include "feeder_config.h"
+#include "mean_filter.h"
+#if FEEDER_LCD
+#include <LiquidCrystal_I2C.h>
+#endif
+#if FEEDER_SIM
+#include "flow_sim.h"
+#endif
+
+// Hardware components specialized on a FeederConfig.
+// Each alias at the bottom of a section picks the implementation at compile
+// time, so only the parts a variant actually has get instantiated and linked.
+
+// ---- Weight sensor ----
+
+#if FEEDER_SIM
+// Wokwi: bowl weight from the flow simulator, following the gate so partial
+// openings, pulses and food still in the air behave as on a real dispenser.
+template <const FeederConfig& C>
+class SimWeightSensor {
+ public:
+  void begin() { initFlowSim(sim_, kFlow, 0.0f, millis()); }
+
+  // The feeder reports every gate move here
+  void gate(uint8_t openingPct) { flowSimGate(sim_, openingPct, millis()); }
+
+  // A conversion is always ready. After feeding, the weight stays at the
+  // final value.
+  bool poll() {
+    flowSimAdvance(sim_, millis());
+    raw_ = (int32_t)lroundf(sim_.bowlG * C.calibrationFactor);
+    return true;
+  }
+
+  // Counts as an HX711 would report them, zero at an empty bowl
+  int32_t sample() const { return raw_; }
+  int32_t raw() const { return raw_; }
+
+  void reset() { initFlowSim(sim_, kFlow, 0.0f, millis()); }
+
+ private:
+  // 33 g/s wide open like the old fixed +10 g per 0.3 s, landing 300 ms later
+  static constexpr FlowSimParams kFlow = {33.0f, 15, 300, 0.0f, 0};
+  FlowSim sim_;
+  int32_t raw_ = 0;
+};
+#endif
+
+// Real hardware: read actual HX711 units
+template <const FeederConfig& C>
+class Hx711WeightSensor {
+ public:
+  void begin() {
+    scale_.begin(C.hx711DtPin, C.hx711SckPin);
+    initMeanFilter(mean_, ring_, kSamples);
+    delay(200); // small settle
+  }
+
+  // Takes a conversion only if the HX711 has one ready (10 per second), so
+  // the loop never waits on the chip: true if it took one. Offset and scale
+  // are applied by the caller's ScaleCal.
+  bool poll() {
+    if (!scale_.is_ready()) return false;
+    sample_ = scale_.read();
+    raw_ = meanFilterPush(mean_, sample_);
+    return true;
+  }
+
+  // The newest conversion, and the mean of the last hx711Samples of them
+  int32_t sample() const { return sample_; }
+  int32_t raw() const { return raw_; }
+
+  void gate(uint8_t) {}
+
+  void reset() {}
+
+ private:
+  static constexpr int kSamples = C.hx711Samples > 0 ? C.hx711Samples : 1;
+  HX711 scale_;
+  int32_t ring_[kSamples] = {};
+  MeanFilter mean_;
+  int32_t sample_ = 0;
+  int32_t raw_ = 0;
+};
+
+#if FEEDER_SIM
+template <const FeederConfig& C>
+using WeightSensor = typename std::conditional<C.simFakeWeight,
+                                               SimWeightSensor<C>,
+                                               Hx711WeightSensor<C>>::type;
+#else
+template <const FeederConfig& C>
+using WeightSensor = Hx711WeightSensor<C>;
+#endif
+
+// ---- Actuator ----
+
+template <const FeederConfig& C>
+class ServoActuator {
+ public:
+  void begin() {
+    servo_.attach(C.servoPin);
+    servo_.write(C.servoCloseAngle);
+  }
+  void open()  { servo_.write(C.servoOpenAngle); }
+  void close() { servo_.write(C.servoCloseAngle); }
+
+  // 0 = closed, 100 = open; dispense profiles use the travel in between
+  void setOpening(uint8_t pct) {
+    if (pct > 100) pct = 100;
+    servo_.write(C.servoCloseAngle + (C.servoOpenAngle - C.servoCloseAngle) * pct / 100);
+  }
+
+ private:
+  Servo servo_;
+};
+
+// ---- Display ----
+
+#if FEEDER_LCD
+template <const FeederConfig& C>
+class LcdDisplay : public LiquidCrystal_I2C {
+ public:
+  LcdDisplay() : LiquidCrystal_I2C(C.lcdAddress, C.lcdCols, C.lcdRows) {}
+};
+#endif
+
+// Headless: every call is an empty inline and compiles away.
+class NullDisplay {
+ public:
+  void init() {}
+  void backlight() {}
+  void clear() {}
+  void setCursor(uint8_t, uint8_t) {}
+  template <typename T> void print(const T&) {}
+  template <typename T> void print(const T&, int) {}
+};
+
+#if FEEDER_LCD
+template <const FeederConfig& C>
+using Display = typename std::conditional<C.hasLcd,
+                                          LcdDisplay<C>,
+                                          NullDisplay>::type;
+#else
+template <const FeederConfig& C>
+using Display = NullDisplay;
+#endif
@@ -0,0 +1,146 @@
+#pragma once
+#include <Arduino.h>
+#include <SPIFFS.h>
+#include "history_log.h"
+
+// Feed/weight history on SPIFFS: one file per HISTORY_SEGMENT_RECORDS
+// records (see history_log.h), oldest file deleted once there are more than
+// HISTORY_MAX_SEGMENTS. Appends open, write and close, so a power cut costs
+// at most the record being written; begin() cuts that one off, and appends
+// write each record at its offset, so no partial record shifts the ones
+// after it. Reads keep one segment open so an export walks a file
+// sequentially.
+class HistoryStore {
+ public:
+  // Call after SPIFFS.begin(); finds the range already on flash and cuts
+  // off a record torn by a power cut.
+  void begin() {
+    finishRepair();
+    File dir = SPIFFS.open("/hist");
+    bool any = false;
+    uint32_t lo = 0, hi = 0;
+    size_t hiBytes = 0;
+    for (File f = dir.openNextFile(); f; f = dir.openNextFile()) {
+      uint32_t seg;
+      if (!parseHistorySegmentName(f.name(), seg)) continue;
+      if (!any || seg < lo) lo = seg;
+      if (!any || seg > hi) {
+        hi = seg;
+        hiBytes = f.size();
+      }
+      any = true;
+    }
+    oldest_ = any ? lo * HISTORY_SEGMENT_RECORDS : 0;
+    end_ = any ? hi * HISTORY_SEGMENT_RECORDS + hiBytes / sizeof(HistoryRecord) : 0;
+    if (hiBytes % sizeof(HistoryRecord)) cutTornTail(hi, hiBytes - hiBytes % sizeof(HistoryRecord));
+  }
+
+  // Assigns r.seq and appends it
+  bool append(HistoryRecord& r) {
+    r.seq = end_;
+    uint32_t seg = historySegmentOf(r.seq);
+    char path[HISTORY_PATH_MAX];
+    historySegmentPath(path, sizeof(path), seg);
+
+    // At its own offset, not the end of the file: over what a short write
+    // left there, so every record stays where read() looks for it
+    uint32_t offset = historyOffsetOf(r.seq);
+    File f = SPIFFS.open(path, offset == 0 ? FILE_WRITE : "r+");
+    if (!f) return false;
+    bool ok = f.seek(offset) && f.write((const uint8_t*)&r, sizeof(r)) == sizeof(r);
+    f.close();
+    if (!ok) return false;
+
+    end_++;
+    if (historyOffsetOf(r.seq) == 0) dropOldSegments(seg);
+    return true;
+  }
+
+  bool read(uint32_t seq, HistoryRecord& out) {
+    if (seq < oldest_ || seq >= end_) return false;
+    uint32_t seg = historySegmentOf(seq);
+    if (!readFile_ || readSeg_ != seg) {
+      if (readFile_) readFile_.close();
+      char path[HISTORY_PATH_MAX];
+      historySegmentPath(path, sizeof(path), seg);
+      readFile_ = SPIFFS.open(path, FILE_READ);
+      readSeg_ = seg;
+      if (!readFile_) return false;
+    }
+    uint32_t offset = historyOffsetOf(seq);
+    if (readFile_.position() != offset && !readFile_.seek(offset)) return false;
+    return readFile_.read((uint8_t*)&out, sizeof(out)) == sizeof(out);
+  }
+
+  // Done with reading for now (end of an export page)
+  void closeReader() {
+    if (readFile_) readFile_.close();
+  }
+
+  uint32_t oldest() const { return oldest_; }
+  uint32_t end() const { return end_; }  // one past the newest seq
+
+  // HistoryReadFn adapter for historyLowerBound()
+  static bool readFn(uint32_t seq, HistoryRecord& out, void* self) {
+    return static_cast<HistoryStore*>(self)->read(seq, out);
+  }
+
+ private:
+  // SPIFFS cannot shorten a file in place: the whole records are copied to
+  // HISTORY_REPAIR_PATH, which then replaces the segment.
+  void cutTornTail(uint32_t seg, size_t bytes) {
+    char path[HISTORY_PATH_MAX];
+    historySegmentPath(path, sizeof(path), seg);
+    File in = SPIFFS.open(path, FILE_READ);
+    File out = SPIFFS.open(HISTORY_REPAIR_PATH, FILE_WRITE);
+    bool ok = in && out;
+    uint8_t buf[256];
+    for (size_t done = 0; ok && done < bytes;) {
+      size_t n = bytes - done < sizeof(buf) ? bytes - done : sizeof(buf);
+      ok = in.read(buf, n) == n && out.write(buf, n) == n;
+      done += n;
+    }
+    if (in) in.close();
+    if (out) out.close();
+    if (!ok) {
+      SPIFFS.remove(HISTORY_REPAIR_PATH);
+      return;  // appends still write over the torn bytes
+    }
+    SPIFFS.remove(path);
+    SPIFFS.rename(HISTORY_REPAIR_PATH, path);
+  }
+
+  // A repair cut short by a reset: if the segment was already removed the
+  // copy takes its place (its first record says which it was), otherwise
+  // the copy is dropped and begin() repairs again.
+  void finishRepair() {
+    if (!SPIFFS.exists(HISTORY_REPAIR_PATH)) return;
+    File f = SPIFFS.open(HISTORY_REPAIR_PATH, FILE_READ);
+    HistoryRecord first;
+    bool whole = f && f.read((uint8_t*)&first, sizeof(first)) == sizeof(first);
+    if (f) f.close();
+    char path[HISTORY_PATH_MAX];
+    if (whole) historySegmentPath(path, sizeof(path), historySegmentOf(first.seq));
+    if (whole && !SPIFFS.exists(path)) {
+      SPIFFS.rename(HISTORY_REPAIR_PATH, path);
+    } else {
+      SPIFFS.remove(HISTORY_REPAIR_PATH);
+    }
+  }
+
+  void dropOldSegments(uint32_t newest) {
+    while (newest - historySegmentOf(oldest_) >= HISTORY_MAX_SEGMENTS) {
+      uint32_t seg = historySegmentOf(oldest_);
+      if (readFile_ && readSeg_ == seg) readFile_.close();
+      char path[HISTORY_PATH_MAX];
+      historySegmentPath(path, sizeof(path), seg);
+      SPIFFS.remove(path);
+      oldest_ = (seg + 1) * HISTORY_SEGMENT_RECORDS;
+    }
+  }
+
+  uint32_t oldest_ = 0;
+  uint32_t end_ = 0;
+  File     readFile_;
+  uint32_t readSeg_ = 0;
+};
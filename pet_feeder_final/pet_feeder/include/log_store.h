@@ -0,0 +1,52 @@
+#pragma once
+#include <Arduino.h>
+#include <SPIFFS.h>
+
+#define LOG_PATH     "/log/feeder.log"
+#define LOG_OLD_PATH "/log/feeder.old"
+const uint32_t LOG_FILE_MAX = 32 * 1024;  // per file; the older half is kept as LOG_OLD_PATH
+
+// The flash sink of the logger, written by the log task only. Lines are
+// collected in RAM and appended in one write when the buffer fills or on
+// flush(), so a chatty feed costs a handful of flash writes; a power cut
+// loses at most what is buffered.
+class LogStore {
+ public:
+  static const size_t   BUFFER = 1024;
+  static const uint32_t FLUSH_MS = 10000;  // buffered lines reach flash this late at most
+
+  // False when the buffer had to be written and that failed
+  bool add(const char* line, size_t n) {
+    bool ok = true;
+    if (len_ + n + 1 > BUFFER) ok = flush();
+    if (n + 1 > BUFFER) n = BUFFER - 1;
+    memcpy(buf_ + len_, line, n);
+    buf_[len_ + n] = '\n';
+    len_ += n + 1;
+    return ok;
+  }
+
+  bool flush() {
+    if (len_ == 0) return true;
+    File f = SPIFFS.open(LOG_PATH, FILE_APPEND);
+    if (!f) {
+      len_ = 0;
+      return false;
+    }
+    bool ok = f.write((const uint8_t*)buf_, len_) == len_;
+    size_t size = f.size();
+    f.close();
+    len_ = 0;
+    if (size >= LOG_FILE_MAX) {
+      SPIFFS.remove(LOG_OLD_PATH);
+      SPIFFS.rename(LOG_PATH, LOG_OLD_PATH);
+    }
+    return ok;
+  }
+
+  bool pending() const { return len_ > 0; }
+
+ private:
+  char   buf_[BUFFER];
+  size_t len_ = 0;
+};
@@ -0,0 +1,117 @@
+#pragma once
+#include <Arduino.h>
+#include "feeder_config.h"
+#include "serial_proto.h"
+
+// The serial port: the text console until a host sends a command, then the
+// binary protocol of serial_proto.h. Console lines come from the log task
+// (logger.h) through line(); in binary mode each becomes an SP_TEXT frame,
+// so text never lands inside a frame. The loop and the log task both queue
+// frames, so the TX ring is behind a mutex.
+template <const FeederConfig& C>
+class SerialLink {
+ public:
+  // With a UART TX buffer, text writes only wait once it is full
+  static const size_t UART_TX_BUFFER = 1024;
+
+  void begin(unsigned long baud) {
+    initSerialTx(tx_, ring_, sizeof(ring_));
+    initSerialRx(rx_);
+    lock_ = xSemaphoreCreateMutex();
+    Serial.setTxBufferSize(UART_TX_BUFFER);
+    Serial.begin(baud);
+  }
+
+  bool binary() const { return binary_; }
+  const SerialTx& tx() const { return tx_; }
+  const SerialRx& rx() const { return rx_; }
+
+  // Once a pass: hands pending frames to the UART as far as it has room and
+  // returns the next command received, if any (which switches to binary).
+  bool poll(SerialCommand& cmd) {
+    drain();
+#if FEEDER_SERIAL_PROTO
+    SerialFrame f;
+    while (Serial.available() > 0) {
+      if (!serialRxByte(rx_, (uint8_t)Serial.read(), f)) continue;
+      binary_ = true;
+      if (parseSerialCommand(f, cmd)) return true;
+      Guard g(lock_);
+      serialSendAck(tx_, f.seq, f.type, 400, "Unknown command");
+    }
+#endif
+    return false;
+  }
+
+  // SPC_TEXT: what is still queued goes out first, waiting for the UART
+  void textMode() {
+    Guard g(lock_);
+    while (serialTxPending(tx_) > 0) {
+      const uint8_t* p;
+      size_t n = serialTxPeek(tx_, &p);
+      serialTxConsume(tx_, Serial.write(p, n));
+    }
+    binary_ = false;
+  }
+
+  // Frames are only sent in binary mode
+  bool send(uint8_t type, const uint8_t* payload, size_t len) {
+    if (!binary_) return false;
+    Guard g(lock_);
+    return serialSend(tx_, type, payload, len);
+  }
+  void weight(uint32_t ms, int32_t raw, float grams, uint8_t opening, uint8_t flags) {
+    if (!binary_) return;
+    Guard g(lock_);
+    serialSendWeight(tx_, ms, raw, grams, opening, flags);
+  }
+  void state(uint8_t event, uint8_t detail, int slot, float target, float weight) {
+    if (!binary_) return;
+    Guard g(lock_);
+    serialSendState(tx_, millis(), event, detail, slot, target, weight);
+  }
+  void ack(const SerialCommand& cmd, uint16_t status, const char* msg) {
+    if (!binary_) return;
+    Guard g(lock_);
+    serialSendAck(tx_, cmd.seq, cmd.type, status, msg);
+  }
+
+  // One console line, without its line ending (log task only). Text mode
+  // waits for the UART here, off the loop.
+  void line(const char* s, size_t n) {
+    if (!binary_) {
+      Serial.write((const uint8_t*)s, n);
+      Serial.write((const uint8_t*)"\r\n", 2);
+      return;
+    }
+    Guard g(lock_);
+    serialSendText(tx_, s, n);
+  }
+
+ private:
+  struct Guard {
+    explicit Guard(SemaphoreHandle_t m) : m(m) { xSemaphoreTake(m, portMAX_DELAY); }
+    ~Guard() { xSemaphoreGive(m); }
+    SemaphoreHandle_t m;
+  };
+
+  void drain() {
+    Guard g(lock_);
+    int room = Serial.availableForWrite();
+    while (room > 0 && serialTxPending(tx_) > 0) {
+      const uint8_t* p;
+      size_t n = serialTxPeek(tx_, &p);
+      if (n > (size_t)room) n = room;
+      size_t sent = Serial.write(p, n);
+      serialTxConsume(tx_, sent);
+      if (sent < n) break;
+      room -= sent;
+    }
+  }
+
+  uint8_t  ring_[C.serialTxBytes];
+  SerialTx tx_;
+  SerialRx rx_;
+  SemaphoreHandle_t lock_ = nullptr;
+  volatile bool binary_ = false;
+};
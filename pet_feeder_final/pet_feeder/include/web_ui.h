@@ -108,6 +108,8 @@ button:active{transform:translateY(0);box-shadow:0 6px 16px rgba(16,185,129,.35)
     <div class="sub-row">
       <div><span class="chip-label">Feeding</span><br /><span id="feedingState" class="badge-text">Idle</span></div>
       <div><span class="chip-label">Next feed</span><br /><span id="nextTimeLabel">--:--</span></div>
+      <div><span class="chip-label">Hopper</span><br /><span id="hopperLabel">Unknown</span>
+        <button class="btn-secondary" id="refillBtn" style="padding:2px 8px;font-size:11px;">Refilled</button></div>
     </div>
   </div>
   <div class="card" style="margin-top:14px;">
@@ -191,6 +193,9 @@ button:active{transform:translateY(0);box-shadow:0 6px 16px rgba(16,185,129,.35)
 // Track which slot the user is currently editing
 const editingSlot = [false, false, false];
 
+// Last status version applied; /api/status?since= returns only newer sections
+let statusVersion = "";
+
 function renderHistory(items) {
   const list = document.getElementById("historyList");
   if (!list) return;
@@ -218,29 +223,48 @@ function renderHistory(items) {
   });
 }
 
-async function fetchStatus() {
+function renderFeeding(feeding) {
+  document.getElementById("feedingState").textContent =
+    feeding ? "Feeding in progress" : "Idle";
+
+  const bd = document.getElementById("badgeDot");
+  const bt = document.getElementById("badgeText");
+  bd.classList.toggle("busy", feeding);
+  bt.textContent = feeding ? "Servo running" : "Ready to feed";
+}
+
+// Small live poll: weight every tick, full sections only when the version moved
+async function fetchLive() {
   try {
-    const r = await fetch("/api/status");
+    const r = await fetch("/api/live");
     if (!r.ok) throw new Error("HTTP " + r.status);
     const d = await r.json();
 
-    // Weight
     const w = Number(d.weight || 0);
     document.getElementById("weightValue").textContent = w.toFixed(1);
+    renderFeeding(!!d.feedingActive);
 
-    // Feeding state + badge
-    const feeding = !!d.feedingActive;
-    document.getElementById("feedingState").textContent =
-      feeding ? "Feeding in progress" : "Idle";
+    if (d.version !== statusVersion) fetchStatus();
+  } catch (e) {
+    console.error("Live error:", e);
+  }
+}
 
-    const bd = document.getElementById("badgeDot");
-    const bt = document.getElementById("badgeText");
-    bd.classList.toggle("busy", feeding);
-    bt.textContent = feeding ? "Servo running" : "Ready to feed";
+async function fetchStatus() {
+  try {
+    // An empty since= asks for every section plus the current version
+    const r = await fetch("/api/status?since=" + encodeURIComponent(statusVersion));
+    if (r.status === 304) return;
+    if (!r.ok) throw new Error("HTTP " + r.status);
+    const d = await r.json();
 
-    // Next time
-    document.getElementById("nextTimeLabel").textContent =
-      d.nextTime || "None";
+    // Feeding state + badge, next time
+    if (d.feedingActive !== undefined) {
+      renderFeeding(!!d.feedingActive);
+      document.getElementById("nextTimeLabel").textContent =
+        d.nextTime || "None";
+      if (d.hopper) renderHopper(d.hopper);
+    }
 
     // Slots
     if (Array.isArray(d.slots)) {
@@ -267,11 +291,41 @@ async function fetchStatus() {
     if (Array.isArray(d.history)) {
       renderHistory(d.history);
     }
+
+    if (d.version) statusVersion = d.version;
   } catch (e) {
     console.error("Status error:", e);
   }
 }
 
+function renderHopper(h) {
+  const el = document.getElementById("hopperLabel");
+  if (!h.known) {
+    el.textContent = "Unknown";
+    el.style.color = "";
+    return;
+  }
+  let text = Math.round(h.remaining) + " g";
+  if (h.emptyAt !== null) {
+    // The feeder's clock is local time counted as Unix seconds: format as UTC
+    const at = new Date(h.emptyAt * 1000);
+    text += h.remaining < 1 ? " (empty)"
+          : " (empty " + at.toLocaleString([], { timeZone: "UTC", weekday: "short", hour: "2-digit", minute: "2-digit" }) + ")";
+  }
+  el.textContent = text;
+  el.style.color = h.low ? "#f97316" : "";
+}
+
+async function refillHopper() {
+  try {
+    const r = await fetch("/api/hopper/refill", { method: "POST" });
+    if (!r.ok) alert("Refill failed: " + (await r.text()));
+    fetchStatus();
+  } catch (e) {
+    alert("Refill failed (network error)");
+  }
+}
+
 async function resetSystem() {
   try {
     const r = await fetch("/api/reset", { method: "POST" });
@@ -302,6 +356,8 @@ async function manualFeed() {
     const r = await fetch("/api/manual-feed?amount=" + a, { method: "POST" });
     if (!r.ok)
       mEl.textContent = "Error: " + (await r.text());
+    else if (r.status === 202)
+      mEl.textContent = (await r.text()) + " - starts when the current feed ends";
     else
       mEl.textContent = "Feeding started!";
   } catch (e) {
@@ -341,6 +397,8 @@ document.addEventListener("DOMContentLoaded", () => {
   // Manual feed button
   document.getElementById("manualBtn").addEventListener("click", manualFeed);
 
+  document.getElementById("refillBtn").addEventListener("click", refillHopper);
+
   const resetBtn = document.getElementById("resetBtn");
   if (resetBtn) {
     resetBtn.addEventListener("click", resetSystem);
@@ -367,8 +425,8 @@ document.addEventListener("DOMContentLoaded", () => {
   }
 
   // Initial fetch + periodic refresh
-  fetchStatus();
-  setInterval(fetchStatus, 2000); // was 1000ms
+  fetchLive();
+  setInterval(fetchLive, 2000); // was 1000ms
 });
 </script>
 
@@ -0,0 +1,105 @@
+#include "admission.h"
+#include <string.h>
+
+// Longest gap credited at once; any bucket is full by then and the product
+// below cannot overflow.
+static const uint32_t MAX_REFILL_MS = 60000;
+
+void initAdmission(Admission& a, const AdmissionLimits& limits) {
+  memset(&a, 0, sizeof(a));
+  a.limits = limits;
+}
+
+void resetAdmissionCounters(Admission& a) {
+  memset(a.admitted, 0, sizeof(a.admitted));
+  memset(a.rejectedRate, 0, sizeof(a.rejectedRate));
+  memset(a.rejectedBusy, 0, sizeof(a.rejectedBusy));
+  a.evictions = 0;
+}
+
+static void refill(ClientBucket& c, const AdmissionLimits& l, uint32_t nowMs) {
+  uint32_t elapsed = nowMs - c.refilledMs;
+  if (elapsed > MAX_REFILL_MS) elapsed = MAX_REFILL_MS;
+  c.refilledMs = nowMs;
+
+  uint32_t cap = l.burst * 1000u;
+  c.tokensMilli += elapsed * l.ratePerSec;
+  if (c.tokensMilli > cap) c.tokensMilli = cap;
+
+  uint32_t priorityCap = PRIORITY_BURST * 1000u;
+  c.priorityMilli += elapsed * PRIORITY_RATE_PER_SEC;
+  if (c.priorityMilli > priorityCap) c.priorityMilli = priorityCap;
+}
+
+// Bucket for `ip`; an unknown client replaces the least recently seen one and
+// starts with full buckets.
+static ClientBucket& client(Admission& a, uint32_t ip, uint32_t nowMs) {
+  ClientBucket* victim = &a.clients[0];
+  for (int i = 0; i < ADMISSION_CLIENTS; i++) {
+    ClientBucket& c = a.clients[i];
+    if (c.lastUse != 0 && c.ip == ip) {
+      refill(c, a.limits, nowMs);
+      c.lastUse = ++a.uses;
+      return c;
+    }
+    if (c.lastUse < victim->lastUse) victim = &c;
+  }
+  if (victim->lastUse != 0) a.evictions++;
+  victim->ip = ip;
+  victim->tokensMilli = a.limits.burst * 1000u;
+  victim->priorityMilli = PRIORITY_BURST * 1000u;
+  victim->refilledMs = nowMs;
+  victim->lastUse = ++a.uses;
+  return *victim;
+}
+
+AdmitResult admitRequest(Admission& a, uint32_t ip, AdmissionLane lane, uint32_t nowMs,
+                         bool feeding) {
+  if (nowMs - a.tickStartMs >= ADMISSION_TICK_MS) {
+    a.tickStartMs = nowMs;
+    a.tickUsed = 0;
+    a.tickPriorityUsed = 0;
+  }
+
+  ClientBucket& c = client(a, ip, nowMs);
+  bool priority = lane == LANE_PRIORITY;
+
+  uint32_t& tokens = priority ? c.priorityMilli : c.tokensMilli;
+  if (tokens < 1000) {
+    a.rejectedRate[lane]++;
+    return ADMIT_RATE;
+  }
+
+  uint8_t budget = priority ? PRIORITY_TICK_BUDGET : a.limits.tickBudget;
+  if (!priority && feeding) budget = budget > 1 ? budget / 2 : 1;
+  uint8_t& used = priority ? a.tickPriorityUsed : a.tickUsed;
+  if (used >= budget) {
+    a.rejectedBusy[lane]++;
+    return ADMIT_BUSY;
+  }
+
+  tokens -= 1000;
+  used++;
+  a.admitted[lane]++;
+  return ADMIT_OK;
+}
+
+uint32_t admissionRetryAfterSecs(const Admission& a, uint32_t ip, AdmitResult r) {
+  if (r != ADMIT_RATE || a.limits.ratePerSec == 0) return 1;
+  for (int i = 0; i < ADMISSION_CLIENTS; i++) {
+    const ClientBucket& c = a.clients[i];
+    if (c.lastUse == 0 || c.ip != ip || c.tokensMilli >= 1000) continue;
+    uint32_t waitMs = (1000 - c.tokensMilli + a.limits.ratePerSec - 1) / a.limits.ratePerSec;
+    return waitMs > 1000 ? (waitMs + 999) / 1000 : 1;
+  }
+  return 1;
+}
+
+const char* admissionLaneName(AdmissionLane lane) {
+  switch (lane) {
+    case LANE_READ:     return "read";
+    case LANE_WRITE:    return "write";
+    case LANE_PRIORITY: return "priority";
+    default:            return "?";
+  }
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include <stdint.h>
+
+// HTTP admission control: decides, before a handler does any work, whether a
+// request is served or answered with a bare 429.
+//
+// Each client IP has a token bucket (AdmissionLimits.ratePerSec, up to
+// `burst`) shared by its read and write requests, and all clients together
+// may start at most `tickBudget` of those per ADMISSION_TICK_MS, half as many
+// while a feed is being monitored. A script polling in a tight loop therefore
+// gets one cheap rejection per extra request instead of a full handler run,
+// and cannot take more than a bounded share of loop() from feed monitoring.
+//
+// Mutations that must get through (manual feed, reset) use the priority
+// lane: a separate small per-client bucket and a separate per-tick
+// allowance, so they are neither starved by nor counted against reads.
+//
+// Clients are kept in a fixed table; when it is full the least recently seen
+// one is forgotten. Build with -DFEEDER_ADMISSION=0 to serve everything (for
+// A/B runs of tools/loadgen.py --hammer).
+
+#ifndef FEEDER_ADMISSION
+#define FEEDER_ADMISSION 1
+#endif
+
+enum AdmissionLane : uint8_t {
+  LANE_READ,      // pages and GET endpoints
+  LANE_WRITE,     // settings changes
+  LANE_PRIORITY,  // manual feed, reset
+  LANE_COUNT
+};
+
+enum AdmitResult : uint8_t {
+  ADMIT_OK,
+  ADMIT_RATE,   // this client is over its rate
+  ADMIT_BUSY    // the global budget for this tick is used up
+};
+
+const int      ADMISSION_CLIENTS  = 8;
+const uint32_t ADMISSION_TICK_MS  = 100;
+
+// Priority lane, per client and per tick
+const uint16_t PRIORITY_RATE_PER_SEC = 1;
+const uint16_t PRIORITY_BURST        = 4;
+const uint8_t  PRIORITY_TICK_BUDGET  = 2;
+
+struct AdmissionLimits {
+  uint16_t ratePerSec;   // per client, read + write lanes
+  uint16_t burst;
+  uint8_t  tickBudget;   // read + write requests of all clients per tick
+};
+
+struct ClientBucket {
+  uint32_t ip;
+  uint32_t tokensMilli;    // read/write bucket, 1000 = one request
+  uint32_t priorityMilli;  // priority bucket
+  uint32_t refilledMs;
+  uint32_t lastUse;        // 0 = unused entry
+};
+
+struct Admission {
+  AdmissionLimits limits;
+  ClientBucket clients[ADMISSION_CLIENTS];
+  uint32_t uses;
+
+  uint32_t tickStartMs;
+  uint8_t  tickUsed;
+  uint8_t  tickPriorityUsed;
+
+  // Counters since boot / last reset, per lane
+  uint32_t admitted[LANE_COUNT];
+  uint32_t rejectedRate[LANE_COUNT];
+  uint32_t rejectedBusy[LANE_COUNT];
+  uint32_t evictions;     // clients forgotten to make room
+};
+
+void initAdmission(Admission& a, const AdmissionLimits& limits);
+void resetAdmissionCounters(Admission& a);
+
+// Charges the request to `ip` and the current tick if it is admitted.
+// `feeding` halves the read/write tick budget (at least one stays).
+AdmitResult admitRequest(Admission& a, uint32_t ip, AdmissionLane lane, uint32_t nowMs,
+                         bool feeding);
+
+// Seconds for a Retry-After header: when `ip` has a read/write token again,
+// or the next tick (rounded up to 1 s) for ADMIT_BUSY.
+uint32_t admissionRetryAfterSecs(const Admission& a, uint32_t ip, AdmitResult r);
+
+const char* admissionLaneName(AdmissionLane lane);
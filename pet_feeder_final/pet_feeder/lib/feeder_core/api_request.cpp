@@ -0,0 +1,177 @@
+#include "api_request.h"
+#include <stdio.h>
+#include <string.h>
+
+bool parseApiMethod(const char* s, ApiMethod& out) {
+  if (strcmp(s, "GET") == 0) out = API_GET;
+  else if (strcmp(s, "POST") == 0) out = API_POST;
+  else return false;
+  return true;
+}
+
+static int hexValue(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+// Decodes [s, end) onto itself and NUL-terminates it; returns the length
+static size_t decodeInPlace(char* s, const char* end) {
+  char* out = s;
+  const char* in = s;
+  while (in < end) {
+    int hi, lo;
+    if (*in == '%' && end - in >= 3 && (hi = hexValue(in[1])) >= 0 &&
+        (lo = hexValue(in[2])) >= 0) {
+      *out++ = (char)(hi << 4 | lo);
+      in += 3;
+    } else {
+      *out++ = *in == '+' ? ' ' : *in;
+      in++;
+    }
+  }
+  *out = '\0';
+  return out - s;
+}
+
+static void clearArgs(ApiArgs& a) {
+  a.count = 0;
+  a.truncated = false;
+}
+
+void parseApiArgs(ApiArgs& a, char* query) {
+  clearArgs(a);
+  a.arena = nullptr;
+  a.cap = a.used = 0;
+  char* p = query;
+  while (p && *p) {
+    char* end = strchr(p, '&');
+    char* next = end ? end + 1 : nullptr;
+    if (!end) end = p + strlen(p);
+    if (end > p) {
+      if (a.count == API_ARGS_MAX) {
+        a.truncated = true;
+        return;
+      }
+      char* eq = (char*)memchr(p, '=', end - p);
+      char* value = eq ? eq + 1 : end;
+      size_t len = decodeInPlace(value, end);  // value first: its NUL may end the name
+      decodeInPlace(p, eq ? eq : end);
+      a.arg[a.count++] = {p, value, (uint16_t)len};
+    }
+    p = next;
+  }
+}
+
+void initApiArgs(ApiArgs& a, char* arena, size_t cap) {
+  clearArgs(a);
+  a.arena = arena;
+  a.cap = cap > UINT16_MAX ? UINT16_MAX : (uint16_t)cap;
+  a.used = 0;
+}
+
+bool addApiArg(ApiArgs& a, const char* name, size_t nameLen, const char* value, size_t valueLen) {
+  if (a.count == API_ARGS_MAX || nameLen + valueLen + 2 > (size_t)(a.cap - a.used)) {
+    a.truncated = true;
+    return false;
+  }
+  char* n = a.arena + a.used;
+  memcpy(n, name, nameLen);
+  n[nameLen] = '\0';
+  char* v = n + nameLen + 1;
+  memcpy(v, value, valueLen);
+  v[valueLen] = '\0';
+  a.used += nameLen + valueLen + 2;
+  a.arg[a.count++] = {n, v, (uint16_t)valueLen};
+  return true;
+}
+
+const ApiArg* findApiArg(const ApiArgs& a, const char* name) {
+  for (int i = 0; i < a.count; i++) {
+    if (strcmp(a.arg[i].name, name) == 0) return &a.arg[i];
+  }
+  return nullptr;
+}
+
+// Decimal digits of [s, end), at most 19 of them; false on anything else
+static bool parseDigits(const char*& s, const char* end, uint64_t& v, int& digits) {
+  v = 0;
+  digits = 0;
+  while (s < end && *s >= '0' && *s <= '9') {
+    if (++digits > 19) return false;
+    v = v * 10 + (*s++ - '0');
+  }
+  return true;
+}
+
+static bool parseSign(const char*& s, const char* end) {
+  if (s < end && (*s == '-' || *s == '+')) return *s++ == '-';
+  return false;
+}
+
+static bool parseInteger(const ApiArg& arg, int64_t& out) {
+  const char* s = arg.value;
+  const char* end = s + arg.len;
+  bool neg = parseSign(s, end);
+  uint64_t v;
+  int digits;
+  if (!parseDigits(s, end, v, digits) || digits == 0 || s != end) return false;
+  if (v > (uint64_t)INT64_MAX) return false;
+  out = neg ? -(int64_t)v : (int64_t)v;
+  return true;
+}
+
+ArgResult argInt(const ApiArgs& a, const char* name, int32_t lo, int32_t hi, int32_t& out) {
+  const ApiArg* arg = findApiArg(a, name);
+  int64_t v;
+  if (!arg) return ARG_MISSING;
+  if (!parseInteger(*arg, v)) return ARG_INVALID;
+  if (v < lo || v > hi) return ARG_RANGE;
+  out = (int32_t)v;
+  return ARG_OK;
+}
+
+ArgResult argUint(const ApiArgs& a, const char* name, uint32_t lo, uint32_t hi, uint32_t& out) {
+  const ApiArg* arg = findApiArg(a, name);
+  int64_t v;
+  if (!arg) return ARG_MISSING;
+  if (!parseInteger(*arg, v)) return ARG_INVALID;
+  if (v < (int64_t)lo || v > (int64_t)hi) return ARG_RANGE;
+  out = (uint32_t)v;
+  return ARG_OK;
+}
+
+// Integer and fraction digits put together, then one scaling: exact for
+// the grams and minutes the API takes, and no strtod (newlib's allocates)
+ArgResult argFloat(const ApiArgs& a, const char* name, float lo, float hi, float& out) {
+  const ApiArg* arg = findApiArg(a, name);
+  if (!arg) return ARG_MISSING;
+  const char* s = arg->value;
+  const char* end = s + arg->len;
+  bool neg = parseSign(s, end);
+  uint64_t whole, frac = 0;
+  int wholeDigits, fracDigits = 0;
+  if (!parseDigits(s, end, whole, wholeDigits)) return ARG_INVALID;
+  if (s < end && *s == '.') {
+    s++;
+    if (!parseDigits(s, end, frac, fracDigits)) return ARG_INVALID;
+  }
+  if (wholeDigits + fracDigits == 0 || s != end) return ARG_INVALID;
+  double scale = 1;
+  for (int i = 0; i < fracDigits; i++) scale *= 10;
+  double v = (double)whole + (double)frac / scale;
+  if (neg) v = -v;
+  if (v < lo || v > hi) return ARG_RANGE;
+  out = (float)v;
+  return ARG_OK;
+}
+
+void formatArgError(char* out, size_t cap, const char* name, ArgResult r) {
+  switch (r) {
+    case ARG_MISSING: snprintf(out, cap, "Missing %s", name); break;
+    case ARG_INVALID: snprintf(out, cap, "%s must be a number", name); break;
+    case ARG_RANGE:   snprintf(out, cap, "%s out of range", name); break;
+    default:          snprintf(out, cap, "OK"); break;
+  }
+}
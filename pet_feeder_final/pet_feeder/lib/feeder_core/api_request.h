@@ -0,0 +1,108 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "admission.h"
+
+// ---- HTTP API requests: routes and arguments ----
+// Each server's routes are one constexpr table of ApiRoute, sorted by path
+// and method (checked with static_assert(apiRoutesSorted(table))) and found
+// by binary search. A request's arguments are slices of the buffer they
+// arrived in, split and percent-decoded in place, and handlers read them
+// with typed getters that check the text and the range. Nothing here
+// allocates: a request costs its own buffer and one ApiArgs.
+
+enum ApiMethod : uint8_t { API_GET, API_POST };
+
+template <typename Handler>
+struct ApiRoute {
+  const char*   path;
+  ApiMethod     method;
+  AdmissionLane lane;
+  Handler       handler;
+};
+
+constexpr int apiPathCompare(const char* a, const char* b) {
+  while (*a && *a == *b) {
+    a++;
+    b++;
+  }
+  return (int)(unsigned char)*a - (int)(unsigned char)*b;
+}
+
+// Strictly ascending by path, then method: no route is listed twice
+template <typename Handler, size_t N>
+constexpr bool apiRoutesSorted(const ApiRoute<Handler> (&routes)[N]) {
+  for (size_t i = 1; i < N; i++) {
+    int c = apiPathCompare(routes[i - 1].path, routes[i].path);
+    if (c > 0 || (c == 0 && routes[i - 1].method >= routes[i].method)) return false;
+  }
+  return true;
+}
+
+// The route of `method` on `path` (no query), or nullptr
+template <typename Handler, size_t N>
+const ApiRoute<Handler>* findApiRoute(const ApiRoute<Handler> (&routes)[N], ApiMethod method,
+                                      const char* path) {
+  size_t lo = 0, hi = N;
+  while (lo < hi) {
+    size_t mid = (lo + hi) / 2;
+    int c = apiPathCompare(routes[mid].path, path);
+    if (c == 0) c = (int)routes[mid].method - (int)method;
+    if (c == 0) return &routes[mid];
+    if (c < 0) lo = mid + 1;
+    else hi = mid;
+  }
+  return nullptr;
+}
+
+// "GET" / "POST"; false for any other method
+bool parseApiMethod(const char* s, ApiMethod& out);
+
+// ---- Arguments ----
+const int API_ARGS_MAX = 16;
+
+struct ApiArg {
+  const char* name;     // NUL-terminated
+  const char* value;    // NUL-terminated, decoded
+  uint16_t    len;      // of value
+};
+
+struct ApiArgs {
+  ApiArg   arg[API_ARGS_MAX];
+  uint8_t  count;
+  bool     truncated;   // some did not fit; the handler must not run
+  char*    arena;       // addApiArg() copies go here
+  uint16_t cap;
+  uint16_t used;
+};
+
+// Splits "a=1&b=x%20y" in place: '&' and '=' become NULs and each value is
+// decoded (%XX, '+') where it lies, so the slices point into `query`.
+// `query` may be nullptr (no arguments). An argument without '=' has an
+// empty value.
+void parseApiArgs(ApiArgs& a, char* query);
+
+// For a server that hands out arguments one by one (the firmware's
+// WebServer has already decoded them): each is copied into `arena`.
+void initApiArgs(ApiArgs& a, char* arena, size_t cap);
+bool addApiArg(ApiArgs& a, const char* name, size_t nameLen, const char* value, size_t valueLen);
+
+const ApiArg* findApiArg(const ApiArgs& a, const char* name);
+inline bool hasApiArg(const ApiArgs& a, const char* name) { return findApiArg(a, name) != nullptr; }
+
+// Typed getters. `out` is only written on ARG_OK, so it can hold the
+// default of an optional argument: a result above ARG_MISSING is an error.
+// Numbers are plain decimals ("-12", "7.25"): no exponent, hex, or spaces.
+enum ArgResult : uint8_t {
+  ARG_OK,
+  ARG_MISSING,
+  ARG_INVALID,   // not a number of that type
+  ARG_RANGE      // outside [lo, hi]
+};
+
+ArgResult argInt(const ApiArgs& a, const char* name, int32_t lo, int32_t hi, int32_t& out);
+ArgResult argUint(const ApiArgs& a, const char* name, uint32_t lo, uint32_t hi, uint32_t& out);
+ArgResult argFloat(const ApiArgs& a, const char* name, float lo, float hi, float& out);
+
+// "Missing hour", "hour must be a number", "hour out of range"
+void formatArgError(char* out, size_t cap, const char* name, ArgResult r);
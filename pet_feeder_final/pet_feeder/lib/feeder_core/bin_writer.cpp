@@ -0,0 +1,137 @@
+#include "bin_writer.h"
+#include <string.h>
+
+WireFormat negotiateWireFormat(const char* accept) {
+  static const struct {
+    const char* type;
+    WireFormat  format;
+  } kTypes[] = {
+    {"application/json",        WIRE_JSON},
+    {"application/cbor",        WIRE_CBOR},
+    {"application/msgpack",     WIRE_MSGPACK},
+    {"application/x-msgpack",   WIRE_MSGPACK},
+    {"application/vnd.msgpack", WIRE_MSGPACK},
+  };
+
+  WireFormat best = WIRE_JSON;
+  const char* bestAt = nullptr;
+  if (!accept) return best;
+  for (const auto& t : kTypes) {
+    const char* at = strstr(accept, t.type);
+    if (at && (!bestAt || at < bestAt)) {
+      best = t.format;
+      bestAt = at;
+    }
+  }
+  return best;
+}
+
+const char* wireContentType(WireFormat f) {
+  switch (f) {
+    case WIRE_CBOR:    return "application/cbor";
+    case WIRE_MSGPACK: return "application/msgpack";
+    default:           return "application/json";
+  }
+}
+
+void BinWriter::put(uint8_t b) {
+  if (overflow_) return;
+  if (len_ >= cap_) {
+    overflow_ = true;
+    return;
+  }
+  buf_[len_++] = b;
+}
+
+void BinWriter::put(const void* p, size_t n) {
+  if (overflow_) return;
+  if (len_ + n > cap_) {
+    overflow_ = true;
+    return;
+  }
+  memcpy(buf_ + len_, p, n);
+  len_ += n;
+}
+
+void BinWriter::putBE(uint32_t v, int bytes) {
+  for (int i = bytes - 1; i >= 0; --i) put((uint8_t)(v >> (8 * i)));
+}
+
+// CBOR initial byte + argument, shortest form
+void BinWriter::cborHead(uint8_t major, uint32_t v) {
+  uint8_t m = major << 5;
+  if (v < 24) {
+    put(m | v);
+  } else if (v <= 0xFF) {
+    put(m | 24);
+    put((uint8_t)v);
+  } else if (v <= 0xFFFF) {
+    put(m | 25);
+    putBE(v, 2);
+  } else {
+    put(m | 26);
+    putBE(v, 4);
+  }
+}
+
+void BinWriter::map(uint32_t pairs) {
+  if (!msgpack_) return cborHead(5, pairs);
+  if (pairs < 16)          put(0x80 | pairs);
+  else if (pairs <= 0xFFFF) { put(0xDE); putBE(pairs, 2); }
+  else                     { put(0xDF); putBE(pairs, 4); }
+}
+
+void BinWriter::array(uint32_t items) {
+  if (!msgpack_) return cborHead(4, items);
+  if (items < 16)          put(0x90 | items);
+  else if (items <= 0xFFFF) { put(0xDC); putBE(items, 2); }
+  else                     { put(0xDD); putBE(items, 4); }
+}
+
+void BinWriter::uint(uint32_t v) {
+  if (!msgpack_) return cborHead(0, v);
+  if (v < 0x80)            put((uint8_t)v);
+  else if (v <= 0xFF)      { put(0xCC); put((uint8_t)v); }
+  else if (v <= 0xFFFF)    { put(0xCD); putBE(v, 2); }
+  else                     { put(0xCE); putBE(v, 4); }
+}
+
+void BinWriter::sint(int32_t v) {
+  if (v >= 0) return uint((uint32_t)v);
+  if (!msgpack_) return cborHead(1, (uint32_t)(-1 - v));
+  if (v >= -32)            put((uint8_t)v);
+  else if (v >= -128)      { put(0xD0); put((uint8_t)v); }
+  else if (v >= -32768)    { put(0xD1); putBE((uint16_t)v, 2); }
+  else                     { put(0xD2); putBE((uint32_t)v, 4); }
+}
+
+void BinWriter::boolean(bool v) {
+  if (msgpack_) put(v ? 0xC3 : 0xC2);
+  else          put(v ? 0xF5 : 0xF4);
+}
+
+void BinWriter::null() {
+  put(msgpack_ ? 0xC0 : 0xF6);
+}
+
+void BinWriter::str(const char* s) {
+  str(s, strlen(s));
+}
+
+void BinWriter::str(const char* s, size_t n) {
+  if (!msgpack_) {
+    cborHead(3, n);
+  } else if (n < 32) {
+    put(0xA0 | n);
+  } else if (n <= 0xFF) {
+    put(0xD9);
+    put((uint8_t)n);
+  } else if (n <= 0xFFFF) {
+    put(0xDA);
+    putBE(n, 2);
+  } else {
+    put(0xDB);
+    putBE(n, 4);
+  }
+  put(s, n);
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// ---- Wire formats ----
+// JSON stays the default; clients on a bandwidth budget ask for CBOR
+// (RFC 8949) or MessagePack with an Accept header.
+enum WireFormat : uint8_t {
+  WIRE_JSON,
+  WIRE_CBOR,
+  WIRE_MSGPACK
+};
+
+// Earliest supported type named in an Accept header ("application/json",
+// "application/cbor", "application/msgpack", "application/x-msgpack",
+// "application/vnd.msgpack"); q-values are not weighed. WIRE_JSON for
+// anything else or nullptr.
+WireFormat negotiateWireFormat(const char* accept);
+const char* wireContentType(WireFormat f);
+
+// Structure-level encoder for CBOR or MessagePack over a caller-owned buffer.
+// Both formats are written as typed heads with definite lengths, so the
+// caller states map/array sizes up front and each value goes straight into
+// the buffer. Every value takes the shortest encoding. Never allocates; once
+// a write doesn't fit, the writer stays in the overflowed state and ok() is
+// false (same contract as BufWriter).
+class BinWriter {
+ public:
+  BinWriter(uint8_t* buf, size_t cap, WireFormat f)
+      : buf_(buf), cap_(cap), len_(0), overflow_(false), msgpack_(f == WIRE_MSGPACK) {}
+
+  void map(uint32_t pairs);
+  void array(uint32_t items);
+  void uint(uint32_t v);
+  void sint(int32_t v);
+  void boolean(bool v);
+  void null();
+  void str(const char* s);
+  void str(const char* s, size_t n);
+
+  // Convenience for int-keyed maps
+  void key(uint8_t k) { uint(k); }
+
+  size_t length() const { return len_; }
+  bool ok() const { return !overflow_; }
+
+ private:
+  void put(uint8_t b);
+  void put(const void* p, size_t n);
+  void putBE(uint32_t v, int bytes);
+  void cborHead(uint8_t major, uint32_t v);
+
+  uint8_t* buf_;
+  size_t   cap_;
+  size_t   len_;
+  bool     overflow_;
+  bool     msgpack_;
+};
@@ -0,0 +1,28 @@
+#include "buf_writer.h"
+#include <stdio.h>
+#include <string.h>
+
+void BufWriter::print(const char* s) {
+  if (overflow_) return;
+  size_t n = strlen(s);
+  if (len_ + n >= cap_) {
+    overflow_ = true;
+    return;
+  }
+  memcpy(buf_ + len_, s, n + 1);
+  len_ += n;
+}
+
+void BufWriter::printf(const char* fmt, ...) {
+  if (overflow_) return;
+  va_list ap;
+  va_start(ap, fmt);
+  int n = vsnprintf(buf_ + len_, cap_ - len_, fmt, ap);
+  va_end(ap);
+  if (n < 0 || len_ + n >= cap_) {
+    overflow_ = true;
+    buf_[len_] = '\0';
+    return;
+  }
+  len_ += n;
+}
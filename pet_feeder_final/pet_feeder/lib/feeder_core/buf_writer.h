@@ -0,0 +1,25 @@
+#pragma once
+#include <stddef.h>
+#include <stdarg.h>
+
+// printf-style appender over a caller-owned buffer. Never allocates; once a
+// write doesn't fit, the writer stays in the overflowed state and ok() is false.
+class BufWriter {
+ public:
+  BufWriter(char* buf, size_t cap) : buf_(buf), cap_(cap), len_(0), overflow_(cap == 0) {
+    if (cap_) buf_[0] = '\0';
+  }
+
+  void print(const char* s);
+  void printf(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+
+  const char* c_str() const { return buf_; }
+  size_t length() const { return len_; }
+  bool ok() const { return !overflow_; }
+
+ private:
+  char*  buf_;
+  size_t cap_;
+  size_t len_;
+  bool   overflow_;
+};
@@ -0,0 +1,126 @@
+#include "dispense.h"
+#include <string.h>
+
+void startDispense(Dispenser& d, uint8_t mode, uint32_t nowMs) {
+  mode = mode < DISPENSE_MODE_COUNT ? mode : (uint8_t)DISPENSE_FULL;
+  startDispenseProfile(d, kDispenseProfiles[mode], mode, nowMs);
+}
+
+void startDispenseProfile(Dispenser& d, const DispenseProfile& profile, uint8_t mode,
+                          uint32_t nowMs) {
+  d.profile = &profile;
+  d.mode = mode;
+  d.phase = DISPENSE_FLOW;
+  d.opening = profile.openPct;
+  d.agitations = 0;
+  d.movesLeft = 0;
+  d.phaseStartMs = nowMs;
+  d.lastStepMs = nowMs;
+  d.openMs = 0;
+}
+
+void stopDispense(Dispenser& d) {
+  d.phase = DISPENSE_IDLE;
+  d.opening = 0;
+}
+
+// Moves the stuck window on by up to `ms`, never past now
+static void holdWindow(FeedProgress& p, uint32_t ms, uint32_t nowMs) {
+  uint32_t since = nowMs - p.lastChangeMs;
+  p.lastChangeMs += since < ms ? since : ms;
+}
+
+static uint8_t flowOpening(const DispenseProfile& pr, const FeedProgress& p, float weight) {
+  bool fine = pr.trickleBandG > 0 && p.target - weight <= pr.trickleBandG;
+  return fine ? pr.tricklePct : pr.openPct;
+}
+
+uint8_t stepDispense(Dispenser& d, FeedProgress& p, float weight, uint32_t stuckWindowMs,
+                     uint32_t nowMs) {
+  if (!dispenseRunning(d)) {
+    d.opening = 0;
+    return 0;
+  }
+  const DispenseProfile& pr = *d.profile;
+  uint32_t dt = nowMs - d.lastStepMs;
+  d.lastStepMs = nowMs;
+
+  switch (d.phase) {
+    case DISPENSE_FLOW: {
+      // Time at a partial opening counts for its share of full flow
+      uint32_t effective = dt * d.opening / 100;
+      d.openMs += effective;
+      holdWindow(p, dt - effective, nowMs);
+
+      if (pr.agitateMoves > 0 && d.agitations < pr.agitateTries &&
+          nowMs - p.lastChangeMs >= stuckWindowMs / 2) {
+        d.phase = DISPENSE_AGITATE;
+        d.phaseStartMs = nowMs;
+        d.movesLeft = pr.agitateMoves;
+        d.agitations++;
+        d.opening = pr.agitateLowPct;
+      } else if (pr.pulseOnMs > 0 && nowMs - d.phaseStartMs >= pr.pulseOnMs) {
+        d.phase = DISPENSE_SETTLE;
+        d.phaseStartMs = nowMs;
+        d.opening = 0;
+      } else {
+        d.opening = flowOpening(pr, p, weight);
+      }
+      break;
+    }
+
+    case DISPENSE_SETTLE:
+      holdWindow(p, dt, nowMs);
+      if (nowMs - d.phaseStartMs >= pr.pulseOffMs) {
+        d.phase = DISPENSE_FLOW;
+        d.phaseStartMs = nowMs;
+        d.opening = flowOpening(pr, p, weight);
+      }
+      break;
+
+    case DISPENSE_AGITATE:
+      holdWindow(p, dt, nowMs);
+      if (nowMs - d.phaseStartMs >= pr.agitateStepMs) {
+        d.phaseStartMs = nowMs;
+        if (--d.movesLeft == 0) {
+          // A full window to show the bridge is gone
+          d.phase = DISPENSE_FLOW;
+          p.lastChangeMs = nowMs;
+          d.opening = flowOpening(pr, p, weight);
+        } else {
+          d.opening = d.opening == pr.agitateLowPct ? pr.openPct : pr.agitateLowPct;
+        }
+      }
+      break;
+
+    default:
+      break;
+  }
+  return d.opening;
+}
+
+uint32_t dispenseTimeoutMs(uint8_t mode, uint32_t timeoutMs) {
+  return dispenseProfileTimeoutMs(
+      kDispenseProfiles[mode < DISPENSE_MODE_COUNT ? mode : (uint8_t)DISPENSE_FULL], timeoutMs);
+}
+
+uint32_t dispenseProfileTimeoutMs(const DispenseProfile& pr, uint32_t timeoutMs) {
+  uint32_t agitating = (uint32_t)pr.agitateTries * pr.agitateMoves * pr.agitateStepMs;
+  return (uint32_t)((uint64_t)timeoutMs * pr.timeoutPct / 100) + agitating;
+}
+
+static const char* const kModeNames[DISPENSE_MODE_COUNT] = {"full", "trickle", "pulse"};
+
+bool parseDispenseMode(const char* name, uint8_t& out) {
+  for (uint8_t m = 0; m < DISPENSE_MODE_COUNT; m++) {
+    if (strcmp(name, kModeNames[m]) == 0) {
+      out = m;
+      return true;
+    }
+  }
+  return false;
+}
+
+const char* dispenseModeName(uint8_t mode) {
+  return mode < DISPENSE_MODE_COUNT ? kModeNames[mode] : "?";
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include <stdint.h>
+#include "feed_monitor.h"
+
+// Servo dispense profiles, run as a non-blocking motion sequence.
+//
+// The gate opening is a percentage of the servo travel between
+// servoCloseAngle and servoOpenAngle. Every monitor pass calls
+// stepDispense(), which moves the sequence on by the time that passed and
+// returns the opening to command now; nothing waits or delays.
+//
+// A profile combines three behaviours:
+//  - trickle: within trickleBandG of the target the gate drops to
+//    tricklePct, so the food still in the air when the target is read is a
+//    small amount (coarse then fine).
+//  - pulse: open for pulseOnMs, closed for pulseOffMs, so each portion lands
+//    and the scale settles before the next (small portions).
+//  - anti-jam: when nothing has been counted for half the stuck window, the
+//    gate swings between openPct and agitateLowPct a few times to break a
+//    bridge of kibble before the monitor calls it a jam.
+//
+// While the gate is closed on purpose (between pulses, agitating) the stuck
+// window is held, and at a partial opening it runs slower in proportion, so
+// the monitor only judges time the gate was meant to be flowing at full
+// rate. The same "full-open equivalent" time is what flow_stats.h learns
+// rates from.
+
+enum DispenseMode : uint8_t {
+  DISPENSE_FULL,     // wide open until the target (the original behaviour)
+  DISPENSE_TRICKLE,  // wide open, partly open for the last grams
+  DISPENSE_PULSE,    // timed pulses at a partial opening
+  DISPENSE_MODE_COUNT
+};
+
+struct DispenseProfile {
+  uint8_t  openPct;        // opening while flowing
+  uint8_t  tricklePct;     // opening within trickleBandG of the target
+  float    trickleBandG;   // 0 = no trickle
+  uint16_t pulseOnMs;      // 0 = continuous
+  uint16_t pulseOffMs;
+  uint8_t  agitateMoves;   // swings per attempt, 0 = no agitation
+  uint8_t  agitateTries;   // attempts per feed before a jam is declared
+  uint8_t  agitateLowPct;
+  uint16_t agitateStepMs;  // per swing
+  uint16_t timeoutPct;     // feed timeout relative to wide open
+};
+
+// Tuned on the flow simulator (flow_sim.h, test/test_dispense).
+constexpr DispenseProfile kDispenseProfiles[DISPENSE_MODE_COUNT] = {
+  // open trickle band  on   off  agitate: moves tries low step  timeout
+  {  100, 100,    0.0f,   0,    0,         4,    2,    30, 150,   100 },  // full
+  {  100,  35,   12.0f,   0,    0,         4,    2,    30, 150,   180 },  // trickle
+  {   60,  60,    0.0f, 200,  400,         4,    2,    30, 150,   550 }   // pulse
+};
+
+enum DispensePhase : uint8_t {
+  DISPENSE_IDLE,
+  DISPENSE_FLOW,      // gate at the flowing opening
+  DISPENSE_SETTLE,    // closed between pulses
+  DISPENSE_AGITATE
+};
+
+struct Dispenser {
+  const DispenseProfile* profile;
+  uint8_t  mode;          // DispenseMode
+  uint8_t  phase;         // DispensePhase
+  uint8_t  opening;       // commanded opening, %
+  uint8_t  agitations;    // attempts this feed
+  uint8_t  movesLeft;     // in the current attempt
+  uint32_t phaseStartMs;
+  uint32_t lastStepMs;
+  uint32_t openMs;        // full-open equivalent time so far
+};
+
+void startDispense(Dispenser& d, uint8_t mode, uint32_t nowMs);
+// Same with a profile outside the table (offline tuning, tools/replay.cpp);
+// `profile` must outlive the feed.
+void startDispenseProfile(Dispenser& d, const DispenseProfile& profile, uint8_t mode,
+                          uint32_t nowMs);
+void stopDispense(Dispenser& d);
+inline bool dispenseRunning(const Dispenser& d) { return d.phase != DISPENSE_IDLE; }
+
+// Advances the sequence to `nowMs` for the current bowl weight and returns
+// the opening to command. Holds p's stuck window as described above.
+uint8_t stepDispense(Dispenser& d, FeedProgress& p, float weight, uint32_t stuckWindowMs,
+                     uint32_t nowMs);
+
+// Feed timeout for a mode, from the wide-open one: slower profiles and the
+// agitation attempts get their time.
+uint32_t dispenseTimeoutMs(uint8_t mode, uint32_t timeoutMs);
+uint32_t dispenseProfileTimeoutMs(const DispenseProfile& pr, uint32_t timeoutMs);
+
+// "full", "trickle" or "pulse"
+bool parseDispenseMode(const char* name, uint8_t& out);
+const char* dispenseModeName(uint8_t mode);
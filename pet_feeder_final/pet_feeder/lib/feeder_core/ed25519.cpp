@@ -0,0 +1,396 @@
+#include "ed25519.h"
+#include <string.h>
+
+// ---- SHA-512 (FIPS 180-4), for h = H(R || A || M) ----
+
+static const uint64_t K512[80] = {
+  0x428a2f98d728ae22ULL, 0x7137449123ef65cdULL, 0xb5c0fbcfec4d3b2fULL, 0xe9b5dba58189dbbcULL,
+  0x3956c25bf348b538ULL, 0x59f111f1b605d019ULL, 0x923f82a4af194f9bULL, 0xab1c5ed5da6d8118ULL,
+  0xd807aa98a3030242ULL, 0x12835b0145706fbeULL, 0x243185be4ee4b28cULL, 0x550c7dc3d5ffb4e2ULL,
+  0x72be5d74f27b896fULL, 0x80deb1fe3b1696b1ULL, 0x9bdc06a725c71235ULL, 0xc19bf174cf692694ULL,
+  0xe49b69c19ef14ad2ULL, 0xefbe4786384f25e3ULL, 0x0fc19dc68b8cd5b5ULL, 0x240ca1cc77ac9c65ULL,
+  0x2de92c6f592b0275ULL, 0x4a7484aa6ea6e483ULL, 0x5cb0a9dcbd41fbd4ULL, 0x76f988da831153b5ULL,
+  0x983e5152ee66dfabULL, 0xa831c66d2db43210ULL, 0xb00327c898fb213fULL, 0xbf597fc7beef0ee4ULL,
+  0xc6e00bf33da88fc2ULL, 0xd5a79147930aa725ULL, 0x06ca6351e003826fULL, 0x142929670a0e6e70ULL,
+  0x27b70a8546d22ffcULL, 0x2e1b21385c26c926ULL, 0x4d2c6dfc5ac42aedULL, 0x53380d139d95b3dfULL,
+  0x650a73548baf63deULL, 0x766a0abb3c77b2a8ULL, 0x81c2c92e47edaee6ULL, 0x92722c851482353bULL,
+  0xa2bfe8a14cf10364ULL, 0xa81a664bbc423001ULL, 0xc24b8b70d0f89791ULL, 0xc76c51a30654be30ULL,
+  0xd192e819d6ef5218ULL, 0xd69906245565a910ULL, 0xf40e35855771202aULL, 0x106aa07032bbd1b8ULL,
+  0x19a4c116b8d2d0c8ULL, 0x1e376c085141ab53ULL, 0x2748774cdf8eeb99ULL, 0x34b0bcb5e19b48a8ULL,
+  0x391c0cb3c5c95a63ULL, 0x4ed8aa4ae3418acbULL, 0x5b9cca4f7763e373ULL, 0x682e6ff3d6b2b8a3ULL,
+  0x748f82ee5defb2fcULL, 0x78a5636f43172f60ULL, 0x84c87814a1f0ab72ULL, 0x8cc702081a6439ecULL,
+  0x90befffa23631e28ULL, 0xa4506cebde82bde9ULL, 0xbef9a3f7b2c67915ULL, 0xc67178f2e372532bULL,
+  0xca273eceea26619cULL, 0xd186b8c721c0c207ULL, 0xeada7dd6cde0eb1eULL, 0xf57d4f7fee6ed178ULL,
+  0x06f067aa72176fbaULL, 0x0a637dc5a2c898a6ULL, 0x113f9804bef90daeULL, 0x1b710b35131c471bULL,
+  0x28db77f523047d84ULL, 0x32caab7b40c72493ULL, 0x3c9ebe0a15c9bebcULL, 0x431d67c49c100d4cULL,
+  0x4cc5d4becb3e42b6ULL, 0x597f299cfc657e2aULL, 0x5fcb6fab3ad6faecULL, 0x6c44198c4a475817ULL,
+};
+
+static inline uint64_t rotr64(uint64_t x, int n) { return (x >> n) | (x << (64 - n)); }
+
+static void compress512(uint64_t state[8], const uint8_t* p) {
+  uint64_t w[80];
+  for (int i = 0; i < 16; i++) {
+    w[i] = 0;
+    for (int j = 0; j < 8; j++) w[i] = w[i] << 8 | p[8 * i + j];
+  }
+  for (int i = 16; i < 80; i++) {
+    uint64_t s0 = rotr64(w[i - 15], 1) ^ rotr64(w[i - 15], 8) ^ (w[i - 15] >> 7);
+    uint64_t s1 = rotr64(w[i - 2], 19) ^ rotr64(w[i - 2], 61) ^ (w[i - 2] >> 6);
+    w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+  }
+
+  uint64_t a = state[0], b = state[1], c = state[2], d = state[3];
+  uint64_t e = state[4], f = state[5], g = state[6], h = state[7];
+  for (int i = 0; i < 80; i++) {
+    uint64_t t1 = h + (rotr64(e, 14) ^ rotr64(e, 18) ^ rotr64(e, 41)) + ((e & f) ^ (~e & g)) +
+                  K512[i] + w[i];
+    uint64_t t2 = (rotr64(a, 28) ^ rotr64(a, 34) ^ rotr64(a, 39)) + ((a & b) ^ (a & c) ^ (b & c));
+    h = g;
+    g = f;
+    f = e;
+    e = d + t1;
+    d = c;
+    c = b;
+    b = a;
+    a = t1 + t2;
+  }
+  state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+  state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+}
+
+struct Sha512 {
+  uint64_t state[8];
+  uint64_t length;
+  uint8_t  block[128];
+  uint8_t  used;
+};
+
+static void sha512Init(Sha512& s) {
+  static const uint64_t H0[8] = {
+    0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL,
+    0x3c6ef372fe94f82bULL, 0xa54ff53a5f1d36f1ULL,
+    0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL,
+    0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL
+  };
+  memcpy(s.state, H0, sizeof(H0));
+  s.length = 0;
+  s.used = 0;
+}
+
+static void sha512Update(Sha512& s, const uint8_t* p, size_t len) {
+  s.length += len;
+  while (len) {
+    size_t n = 128u - s.used < len ? 128u - s.used : len;
+    memcpy(s.block + s.used, p, n);
+    s.used += n;
+    p += n;
+    len -= n;
+    if (s.used == 128) {
+      compress512(s.state, s.block);
+      s.used = 0;
+    }
+  }
+}
+
+static void sha512Final(Sha512& s, uint8_t out[64]) {
+  uint64_t bits = s.length * 8;
+  s.block[s.used++] = 0x80;
+  if (s.used > 112) {
+    memset(s.block + s.used, 0, 128 - s.used);
+    compress512(s.state, s.block);
+    s.used = 0;
+  }
+  memset(s.block + s.used, 0, 120 - s.used);  // the upper half of the 128-bit length is 0
+  for (int i = 0; i < 8; i++) s.block[120 + i] = (uint8_t)(bits >> (56 - 8 * i));
+  compress512(s.state, s.block);
+  for (int i = 0; i < 8; i++) {
+    for (int j = 0; j < 8; j++) out[8 * i + j] = (uint8_t)(s.state[i] >> (56 - 8 * j));
+  }
+}
+
+// ---- Field arithmetic mod 2^255 - 19, sixteen 16-bit limbs ----
+
+typedef int64_t gf[16];
+
+static const gf GF0 = {0};
+static const gf GF1 = {1};
+static const gf D = {0x78a3, 0x1359, 0x4dca, 0x75eb, 0xd8ab, 0x4141, 0x0a4d, 0x0070,
+                     0xe898, 0x7779, 0x4079, 0x8cc7, 0xfe73, 0x2b6f, 0x6cee, 0x5203};
+static const gf D2 = {0xf159, 0x26b2, 0x9b94, 0xebd6, 0xb156, 0x8283, 0x149a, 0x00e0,
+                      0xd130, 0xeef3, 0x80f2, 0x198e, 0xfce7, 0x56df, 0xd9dc, 0x2406};
+static const gf BX = {0xd51a, 0x8f25, 0x2d60, 0xc956, 0xa7b2, 0x9525, 0xc760, 0x692c,
+                      0xdc5c, 0xfdd6, 0xe231, 0xc0a4, 0x53fe, 0xcd6e, 0x36d3, 0x2169};
+static const gf BY = {0x6658, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666,
+                      0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666};
+static const gf SQRT_M1 = {0xa0b0, 0x4a0e, 0x1b27, 0xc4ee, 0xe478, 0xad2f, 0x1806, 0x2f43,
+                           0xd7a7, 0x3dfb, 0x0099, 0x2b4d, 0xdf0b, 0x4fc1, 0x2480, 0x2b83};
+
+static void set(gf r, const gf a) { memcpy(r, a, sizeof(gf)); }
+
+static void carry(gf o) {
+  for (int i = 0; i < 16; i++) {
+    o[i] += (int64_t)1 << 16;
+    int64_t c = o[i] >> 16;
+    if (i < 15) {
+      o[i + 1] += c - 1;
+    } else {
+      o[0] += 38 * (c - 1);  // 2^256 = 38 mod p
+    }
+    o[i] -= c * 65536;
+  }
+}
+
+static void swapIf(gf p, gf q, int b) {
+  int64_t mask = ~(int64_t)(b - 1);
+  for (int i = 0; i < 16; i++) {
+    int64_t t = mask & (p[i] ^ q[i]);
+    p[i] ^= t;
+    q[i] ^= t;
+  }
+}
+
+static void pack(uint8_t out[32], const gf n) {
+  gf t, m;
+  set(t, n);
+  carry(t);
+  carry(t);
+  carry(t);
+  for (int j = 0; j < 2; j++) {
+    m[0] = t[0] - 0xffed;
+    for (int i = 1; i < 15; i++) {
+      m[i] = t[i] - 0xffff - ((m[i - 1] >> 16) & 1);
+      m[i - 1] &= 0xffff;
+    }
+    m[15] = t[15] - 0x7fff - ((m[14] >> 16) & 1);
+    int b = (int)((m[15] >> 16) & 1);
+    m[14] &= 0xffff;
+    swapIf(t, m, 1 - b);
+  }
+  for (int i = 0; i < 16; i++) {
+    out[2 * i] = (uint8_t)t[i];
+    out[2 * i + 1] = (uint8_t)(t[i] >> 8);
+  }
+}
+
+static void unpack(gf o, const uint8_t n[32]) {
+  for (int i = 0; i < 16; i++) o[i] = n[2 * i] + ((int64_t)n[2 * i + 1] << 8);
+  o[15] &= 0x7fff;
+}
+
+static bool equal(const gf a, const gf b) {
+  uint8_t c[32], d[32];
+  pack(c, a);
+  pack(d, b);
+  return memcmp(c, d, 32) == 0;
+}
+
+static int parity(const gf a) {
+  uint8_t d[32];
+  pack(d, a);
+  return d[0] & 1;
+}
+
+static void add(gf o, const gf a, const gf b) {
+  for (int i = 0; i < 16; i++) o[i] = a[i] + b[i];
+}
+
+static void sub(gf o, const gf a, const gf b) {
+  for (int i = 0; i < 16; i++) o[i] = a[i] - b[i];
+}
+
+static void mul(gf o, const gf a, const gf b) {
+  int64_t t[31] = {0};
+  for (int i = 0; i < 16; i++) {
+    for (int j = 0; j < 16; j++) t[i + j] += a[i] * b[j];
+  }
+  for (int i = 0; i < 15; i++) t[i] += 38 * t[i + 16];
+  for (int i = 0; i < 16; i++) o[i] = t[i];
+  carry(o);
+  carry(o);
+}
+
+static void square(gf o, const gf a) { mul(o, a, a); }
+
+static void invert(gf o, const gf in) {  // in^(p - 2)
+  gf c;
+  set(c, in);
+  for (int a = 253; a >= 0; a--) {
+    square(c, c);
+    if (a != 2 && a != 4) mul(c, c, in);
+  }
+  set(o, c);
+}
+
+static void pow2523(gf o, const gf in) {  // in^((p - 5) / 8)
+  gf c;
+  set(c, in);
+  for (int a = 250; a >= 0; a--) {
+    square(c, c);
+    if (a != 1) mul(c, c, in);
+  }
+  set(o, c);
+}
+
+// ---- Points in extended coordinates (X, Y, Z, T) ----
+
+static void pointAdd(gf p[4], gf q[4]) {
+  gf a, b, c, d, t, e, f, g, h;
+  sub(a, p[1], p[0]);
+  sub(t, q[1], q[0]);
+  mul(a, a, t);
+  add(b, p[0], p[1]);
+  add(t, q[0], q[1]);
+  mul(b, b, t);
+  mul(c, p[3], q[3]);
+  mul(c, c, D2);
+  mul(d, p[2], q[2]);
+  add(d, d, d);
+  sub(e, b, a);
+  sub(f, d, c);
+  add(g, d, c);
+  add(h, b, a);
+  mul(p[0], e, f);
+  mul(p[1], h, g);
+  mul(p[2], g, f);
+  mul(p[3], e, h);
+}
+
+static void pointSwap(gf p[4], gf q[4], int b) {
+  for (int i = 0; i < 4; i++) swapIf(p[i], q[i], b);
+}
+
+static void pointPack(uint8_t out[32], gf p[4]) {
+  gf tx, ty, zi;
+  invert(zi, p[2]);
+  mul(tx, p[0], zi);
+  mul(ty, p[1], zi);
+  pack(out, ty);
+  out[31] ^= parity(tx) << 7;
+}
+
+// p = s * q (q is used up); s is 32 bytes little-endian
+static void scalarMult(gf p[4], gf q[4], const uint8_t s[32]) {
+  set(p[0], GF0);
+  set(p[1], GF1);
+  set(p[2], GF1);
+  set(p[3], GF0);
+  for (int i = 255; i >= 0; i--) {
+    int b = (s[i / 8] >> (i & 7)) & 1;
+    pointSwap(p, q, b);
+    pointAdd(q, p);
+    pointAdd(p, p);
+    pointSwap(p, q, b);
+  }
+}
+
+static void scalarBase(gf p[4], const uint8_t s[32]) {
+  gf q[4];
+  set(q[0], BX);
+  set(q[1], BY);
+  set(q[2], GF1);
+  mul(q[3], BX, BY);
+  scalarMult(p, q, s);
+}
+
+// The negated point of an encoded key; false if it is not on the curve
+static bool unpackNegated(gf r[4], const uint8_t p[32]) {
+  gf t, chk, num, den, den2, den4, den6;
+  set(r[2], GF1);
+  unpack(r[1], p);
+  square(num, r[1]);
+  mul(den, num, D);
+  sub(num, num, r[2]);
+  add(den, r[2], den);
+
+  square(den2, den);
+  square(den4, den2);
+  mul(den6, den4, den2);
+  mul(t, den6, num);
+  mul(t, t, den);
+
+  pow2523(t, t);
+  mul(t, t, num);
+  mul(t, t, den);
+  mul(t, t, den);
+  mul(r[0], t, den);
+
+  square(chk, r[0]);
+  mul(chk, chk, den);
+  if (!equal(chk, num)) mul(r[0], r[0], SQRT_M1);
+  square(chk, r[0]);
+  mul(chk, chk, den);
+  if (!equal(chk, num)) return false;
+
+  if (parity(r[0]) == (p[31] >> 7)) sub(r[0], GF0, r[0]);
+  mul(r[3], r[0], r[1]);
+  return true;
+}
+
+// ---- Scalars mod L = 2^252 + 27742317777372353535851937790883648493 ----
+
+static const int64_t L[32] = {0xed, 0xd3, 0xf5, 0x5c, 0x1a, 0x63, 0x12, 0x58,
+                              0xd6, 0x9c, 0xf7, 0xa2, 0xde, 0xf9, 0xde, 0x14,
+                              0,    0,    0,    0,    0,    0,    0,    0,
+                              0,    0,    0,    0,    0,    0,    0,    0x10};
+
+static void modL(uint8_t r[32], int64_t x[64]) {
+  for (int i = 63; i >= 32; i--) {
+    int64_t c = 0;
+    int j;
+    for (j = i - 32; j < i - 12; j++) {
+      x[j] += c - 16 * x[i] * L[j - (i - 32)];
+      c = (x[j] + 128) >> 8;
+      x[j] -= c * 256;
+    }
+    x[j] += c;
+    x[i] = 0;
+  }
+  int64_t c = 0;
+  for (int j = 0; j < 32; j++) {
+    x[j] += c - (x[31] >> 4) * L[j];
+    c = x[j] >> 8;
+    x[j] &= 255;
+  }
+  for (int j = 0; j < 32; j++) x[j] -= c * L[j];
+  for (int i = 0; i < 32; i++) {
+    x[i + 1] += x[i] >> 8;
+    r[i] = (uint8_t)(x[i] & 255);
+  }
+}
+
+static bool belowL(const uint8_t s[32]) {
+  for (int i = 31; i >= 0; i--) {
+    if (s[i] != L[i]) return s[i] < L[i];
+  }
+  return false;
+}
+
+bool ed25519Verify(const uint8_t sig[ED25519_SIG_BYTES], const uint8_t* msg, size_t len,
+                   const uint8_t key[ED25519_KEY_BYTES]) {
+  const uint8_t* R = sig;
+  const uint8_t* S = sig + 32;
+  if (!belowL(S)) return false;  // RFC 8032 5.1.7: no malleable S
+  gf p[4], q[4];
+  if (!unpackNegated(q, key)) return false;
+
+  Sha512 s;
+  uint8_t h[64];
+  sha512Init(s);
+  sha512Update(s, R, 32);
+  sha512Update(s, key, ED25519_KEY_BYTES);
+  sha512Update(s, msg, len);
+  sha512Final(s, h);
+  int64_t x[64];
+  for (int i = 0; i < 64; i++) x[i] = h[i];
+  uint8_t k[32];
+  modL(k, x);
+
+  // [S]B - [k]A must come out as R
+  scalarMult(p, q, k);
+  scalarBase(q, S);
+  pointAdd(p, q);
+  uint8_t check[32];
+  pointPack(check, p);
+  return memcmp(check, R, 32) == 0;
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// ---- Ed25519 signature check ----
+// RFC 8032 verification only, so OTA images (ota_image.h) are checked the
+// same way on the device and in the host tests. Derived from TweetNaCl:
+// small and slow, about a tenth of a second on the ESP32, once per update.
+// Verification handles public data only, so it need not be constant-time.
+
+const size_t ED25519_KEY_BYTES = 32;
+const size_t ED25519_SIG_BYTES = 64;
+
+// True if `sig` is `key`'s signature of `msg`. A key that is not a point of
+// the curve, or a signature with S out of range, is rejected.
+bool ed25519Verify(const uint8_t sig[ED25519_SIG_BYTES], const uint8_t* msg, size_t len,
+                   const uint8_t key[ED25519_KEY_BYTES]);
@@ -0,0 +1,187 @@
+#include "feed_control.h"
+#include <math.h>
+
+static void clearActive(FeedControl& c) {
+  c.active = false;
+  c.manual = false;
+  c.slot = -1;
+}
+
+void initFeedControl(FeedControl& c, const FeedConfig& cfg, FeedCommand* storage, int depth,
+                     FlowStats& flow, HopperState& hopper, FeedJournal& journal,
+                     const CalCapture& cal, const FeedHooks& hooks) {
+  c.cfg = cfg;
+  c.hooks = hooks;
+  c.flow = &flow;
+  c.hopper = &hopper;
+  c.journal = &journal;
+  c.cal = &cal;
+  initFeedQueue(c.queue, storage, depth);
+  clearActive(c);
+  c.startWeight = 0;
+  c.opening = 0;
+  c.progress = {};
+  c.limits = cfg.limits;
+  c.dispenser = {};
+}
+
+static void save(FeedControl& c, uint8_t what) {
+  if (c.hooks.save) c.hooks.save(c.hooks.ctx, what);
+}
+
+static void moveGate(FeedControl& c, uint8_t pct) {
+  c.opening = pct;
+  c.hooks.gate(c.hooks.ctx, pct);
+}
+
+static void closeGate(FeedControl& c) {
+  stopDispense(c.dispenser);
+  moveGate(c, 0);
+}
+
+// A HIST_FEED record for the history, if the caller keeps one
+static void record(FeedControl& c, bool manual, int slot, uint8_t outcome, float weight,
+                   float target) {
+  if (!c.hooks.record) return;
+  HistoryRecord r = {};
+  r.time = c.hooks.clock(c.hooks.ctx);
+  r.kind = HIST_FEED;
+  r.manual = manual;
+  r.slot = slot;
+  r.outcome = outcome;
+  r.weightDg = (int32_t)lroundf(weight * 10.0f);
+  r.targetDg = (int32_t)lroundf(target * 10.0f);
+  c.hooks.record(c.hooks.ctx, r);
+}
+
+FeedEnqueue requestFeed(FeedControl& c, uint8_t source, int slot, float amount, uint8_t mode,
+                        uint32_t nowMs) {
+  FeedCommand cmd = {};
+  cmd.source     = source;
+  cmd.slotIndex  = slot;
+  cmd.amount     = amount;
+  cmd.enqueuedMs = nowMs;
+  cmd.maxWaitMs  = c.cfg.maxWaitMs;
+  cmd.mode       = mode;
+  return enqueueFeed(c.queue, cmd);
+}
+
+bool feedDispenserFree(const FeedControl& c) {
+  return !c.active && c.cal->step == CAL_NONE && !(c.hooks.held && c.hooks.held(c.hooks.ctx));
+}
+
+bool dispatchFeed(FeedControl& c, float weight, uint32_t nowMs) {
+  if (!feedDispenserFree(c) || c.queue.count == 0) return false;
+
+  FeedCommand cmd;
+  if (!popFeed(c.queue, nowMs, cmd)) return false;
+
+  if (cmd.source == FEED_SRC_SCHEDULED && hopperPredictEmpty(*c.hopper)) {
+    record(c, false, cmd.slotIndex, HIST_SKIPPED_EMPTY, weight, cmd.amount);
+    return false;
+  }
+  startFeed(c, cmd, weight, nowMs);
+  return true;
+}
+
+void startFeed(FeedControl& c, const FeedCommand& cmd, float weight, uint32_t nowMs) {
+  c.active = true;
+  c.manual = cmd.source != FEED_SRC_SCHEDULED;
+  c.slot = c.manual ? -1 : cmd.slotIndex;
+  c.startWeight = weight;
+  startFeedProgress(c.progress, weight, cmd.amount, nowMs);
+  c.limits = deriveFeedLimits(*c.flow, c.cfg.limits, cmd.amount);
+  c.limits.timeoutMs = dispenseTimeoutMs(cmd.mode, c.limits.timeoutMs);
+
+  journalBegin(*c.journal, c.journal->seq + 1, c.hooks.clock(c.hooks.ctx), c.slot, c.manual,
+               weight, cmd.amount);
+  save(c, FEED_SAVE_JOURNAL);
+
+  startDispense(c.dispenser, cmd.mode, nowMs);
+  if (c.hooks.started) c.hooks.started(c.hooks.ctx);
+  moveGate(c, c.dispenser.opening);
+}
+
+static void finishFeed(FeedControl& c, FeedCheck reason, float weight) {
+  FeedOutcome o = {reason, c.manual, c.slot, c.progress.target, weight,
+                   weight - c.startWeight};
+  record(c, o.manual, o.slot, reason, weight, o.target);
+
+  // A feed that reached its target while the model said "empty" proves the
+  // estimate wrong: forget it until the next refill rather than keep
+  // skipping scheduled feeds.
+  uint8_t saved = FEED_SAVE_HOPPER | FEED_SAVE_JOURNAL;
+  bool predictedEmpty = hopperPredictEmpty(*c.hopper);
+  hopperDispensed(*c.hopper, o.dispensed);
+  if (reason == FEED_STUCK) {
+    hopperMarkEmpty(*c.hopper);
+  } else if (reason == FEED_TARGET_REACHED && predictedEmpty) {
+    c.hopper->known = false;
+  }
+  if (learnFlow(*c.flow, c.progress, reason, o.dispensed, c.dispenser.openMs)) {
+    saved |= FEED_SAVE_FLOW;
+  }
+  journalClear(*c.journal);
+  save(c, saved);
+
+  clearActive(c);
+  if (c.hooks.finished) c.hooks.finished(c.hooks.ctx, o);
+}
+
+FeedCheck stepFeed(FeedControl& c, float weight, uint32_t nowMs) {
+  if (!c.active) return FEED_CONTINUE;
+
+  // The profile moves the gate (trickle, pulses, agitation) and holds the
+  // stuck window while it is closed on purpose
+  uint8_t opening = stepDispense(c.dispenser, c.progress, weight, c.limits.stuckWindowMs, nowMs);
+  if (opening != c.opening) moveGate(c, opening);
+
+  FeedCheck check = checkFeedProgress(c.progress, weight, dispenseRunning(c.dispenser), nowMs,
+                                      c.limits);
+  switch (check) {
+    case FEED_CONTINUE:
+      // Progress for the journal; flash only at each quarter of the portion
+      if (journalCheckpoint(*c.journal, weight - c.startWeight)) {
+        save(c, FEED_SAVE_JOURNAL);
+      }
+      break;
+    case FEED_TIMEOUT:
+      if (dispenseRunning(c.dispenser)) closeGate(c);
+      finishFeed(c, check, weight);
+      break;
+    default:
+      closeGate(c);
+      finishFeed(c, check, weight);
+      break;
+  }
+  return check;
+}
+
+bool checkScheduledFeeds(FeedControl& c, const CompiledRule* rules, uint32_t* markers,
+                         int count, uint32_t now, uint32_t nowMs) {
+  bool markersChanged = false;
+  for (int i = 0; i < count; i++) {
+    uint32_t before = markers[i];
+    DueFeed due = checkSlotDue(rules[i], markers[i], now);
+    if (markers[i] != before) markersChanged = true;
+    if (due.kind == DUE_NONE) continue;
+
+    FeedEnqueue queued = FEED_QUEUED;
+    if (due.kind == DUE_ON_TIME || due.kind == DUE_LATE) {
+      queued = requestFeed(c, FEED_SRC_SCHEDULED, i, due.amount, c.cfg.mode, nowMs);
+    }
+    if (c.hooks.due) c.hooks.due(c.hooks.ctx, i, due, queued);
+  }
+  return markersChanged;
+}
+
+void resetFeedControl(FeedControl& c, uint32_t nowMs) {
+  if (c.active) {
+    journalClear(*c.journal);
+    save(c, FEED_SAVE_JOURNAL);
+  }
+  clearActive(c);
+  startFeedProgress(c.progress, 0, 0, nowMs);
+  clearFeedQueue(c.queue);
+  closeGate(c);
+}
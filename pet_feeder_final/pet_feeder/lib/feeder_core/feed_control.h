@@ -0,0 +1,115 @@
+#pragma once
+#include <stdint.h>
+#include "dispense.h"
+#include "feed_journal.h"
+#include "feed_monitor.h"
+#include "feed_queue.h"
+#include "flow_stats.h"
+#include "history_log.h"
+#include "hopper.h"
+#include "scale_cal.h"
+#include "schedule.h"
+
+// ---- Feed orchestration ----
+// A feed from the request to its logged outcome: the queue, the dispenser
+// it feeds, the gate, the journal, and what a finished feed teaches the
+// hopper and flow models. The firmware and tools/fleet_sim run this same
+// code; the servo, flash, history file, display and log are theirs and are
+// reached through FeedHooks.
+//
+// Each loop pass, after reading the scale: checkScheduledFeeds() (with a
+// wall clock), dispatchFeed(), then stepFeed() while a feed is active.
+
+struct FeedConfig {
+  FeedLimits limits;      // configured; each feed derives its own from FlowStats
+  uint32_t   maxWaitMs;   // a queued feed not started by then is dropped
+  uint8_t    mode;        // DispenseMode of scheduled feeds
+};
+
+// What went to flash-worthy state, for FeedHooks::save
+enum FeedSave : uint8_t {
+  FEED_SAVE_JOURNAL = 1 << 0,
+  FEED_SAVE_HOPPER  = 1 << 1,
+  FEED_SAVE_FLOW    = 1 << 2
+};
+
+// How a feed ended, for FeedHooks::finished
+struct FeedOutcome {
+  FeedCheck reason;
+  bool      manual;
+  int       slot;          // -1 for manual / API
+  float     target;        // bowl weight aimed at
+  float     finalWeight;
+  float     dispensed;     // bowl gain over the start
+};
+
+// `gate` and `clock` are required; the others may be nullptr.
+struct FeedHooks {
+  void* ctx;
+  void     (*gate)(void* ctx, uint8_t pct);            // command the gate, % open
+  void     (*save)(void* ctx, uint8_t what);           // FeedSave bits changed
+  uint32_t (*clock)(void* ctx);                        // Unix time; read only for records
+  bool     (*held)(void* ctx);                         // dispenser taken (LCD editing)
+  void     (*record)(void* ctx, const HistoryRecord& r);  // a feed or skip for the history
+  void     (*started)(void* ctx);                      // feed set up, gate about to open
+  void     (*finished)(void* ctx, const FeedOutcome& o);  // feed over, state cleared
+  void     (*due)(void* ctx, int slot, const DueFeed& d, FeedEnqueue queued);  // not DUE_NONE
+};
+
+struct FeedControl {
+  FeedConfig   cfg;
+  FeedHooks    hooks;
+
+  // The caller's, persisted by it on FeedHooks::save
+  FlowStats*   flow;
+  HopperState* hopper;
+  FeedJournal* journal;
+  const CalCapture* cal;      // a capture running holds the dispenser
+
+  FeedQueue    queue;
+  bool         active;        // a feed is in flight
+  bool         manual;        // ... started by hand or over the API
+  int          slot;          // ... for this slot, -1 if manual
+  float        startWeight;   // bowl weight when it started
+  uint8_t      opening;       // commanded gate opening, %
+  FeedProgress progress;      // target + timing of the feed in flight
+  FeedLimits   limits;        // the feed in flight (or the last one)
+  Dispenser    dispenser;     // servo motion of the feed in flight
+};
+
+void initFeedControl(FeedControl& c, const FeedConfig& cfg, FeedCommand* storage, int depth,
+                     FlowStats& flow, HopperState& hopper, FeedJournal& journal,
+                     const CalCapture& cal, const FeedHooks& hooks);
+
+// Queues a feed; dispatchFeed() starts it.
+FeedEnqueue requestFeed(FeedControl& c, uint8_t source, int slot, float amount, uint8_t mode,
+                        uint32_t nowMs);
+
+// Nothing in flight, no calibration capture running and nobody holding
+// the dispenser. A capture averages the scale with the bowl still: food
+// landing during a zero capture would be taken for the empty bowl.
+bool feedDispenserFree(const FeedControl& c);
+
+// Starts the next queued feed if the dispenser is free. A scheduled feed
+// onto a hopper predicted empty is recorded as HIST_SKIPPED_EMPTY instead:
+// it would only end in the stuck detector. Manual and API feeds still run,
+// since someone asked and may have refilled without saying so.
+bool dispatchFeed(FeedControl& c, float weight, uint32_t nowMs);
+
+// Starts `cmd` right away and opens the gate. Feeds add to what is already
+// in the bowl: the target is `weight` + cmd.amount.
+void startFeed(FeedControl& c, const FeedCommand& cmd, float weight, uint32_t nowMs);
+
+// One monitor step of the feed in flight: moves the gate per the profile,
+// checkpoints the journal, and on an outcome shuts the gate and finishes
+// the feed (history, hopper, flow, journal). FEED_CONTINUE while running
+// or when nothing is.
+FeedCheck stepFeed(FeedControl& c, float weight, uint32_t nowMs);
+
+// Queues each slot that came due since its marker. Returns true when a
+// marker moved, for the caller to persist.
+bool checkScheduledFeeds(FeedControl& c, const CompiledRule* rules, uint32_t* markers,
+                         int count, uint32_t now, uint32_t nowMs);
+
+// Shuts the gate, drops the feed in flight (and its journal) and the queue.
+void resetFeedControl(FeedControl& c, uint32_t nowMs);
@@ -0,0 +1,85 @@
+#include "feed_journal.h"
+#include <stddef.h>
+
+// CRC-32 (IEEE, reflected), bitwise: the record is 32 bytes
+static uint32_t crc32(const void* data, size_t len) {
+  const uint8_t* p = static_cast<const uint8_t*>(data);
+  uint32_t crc = 0xFFFFFFFF;
+  for (size_t i = 0; i < len; i++) {
+    crc ^= p[i];
+    for (int b = 0; b < 8; b++) crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+  }
+  return ~crc;
+}
+
+static void seal(FeedJournal& j) {
+  j.crc = crc32(&j, offsetof(FeedJournal, crc));
+}
+
+void journalBegin(FeedJournal& j, uint32_t seq, uint32_t startTime, int slot, bool manual,
+                  float startWeight, float amount, uint8_t resumes) {
+  j.magic = FEED_JOURNAL_MAGIC;
+  j.seq = seq;
+  j.startTime = startTime;
+  j.slot = (int8_t)slot;
+  j.manual = manual;
+  j.resumes = resumes;
+  j.flashQuarter = 0;
+  j.startWeight = startWeight;
+  j.amount = amount;
+  j.dispensed = 0;
+  seal(j);
+}
+
+bool journalCheckpoint(FeedJournal& j, float dispensed) {
+  if (dispensed < j.dispensed) dispensed = j.dispensed;  // the pet ate; keep the high-water mark
+  j.dispensed = dispensed;
+  j.seq++;
+
+  uint8_t quarter = j.amount > 0 ? (uint8_t)(dispensed * 4 / j.amount) : 0;
+  if (quarter > 4) quarter = 4;
+  bool toFlash = quarter > j.flashQuarter;
+  if (toFlash) j.flashQuarter = quarter;
+  seal(j);
+  return toFlash;
+}
+
+void journalClear(FeedJournal& j) {
+  j.magic = 0;
+  j.seq++;
+  seal(j);
+}
+
+bool journalValid(const FeedJournal& j) {
+  return j.magic == FEED_JOURNAL_MAGIC && j.crc == crc32(&j, offsetof(FeedJournal, crc));
+}
+
+const FeedJournal* newestJournal(const FeedJournal& a, const FeedJournal& b) {
+  bool va = journalValid(a), vb = journalValid(b);
+  if (va && vb) return (int32_t)(a.seq - b.seq) >= 0 ? &a : &b;
+  return va ? &a : vb ? &b : nullptr;
+}
+
+JournalResume reconcileJournal(const FeedJournal& j, float bowlWeight, uint32_t now,
+                               uint32_t maxAgeSecs, float minIncreaseG) {
+  JournalResume r = {JOURNAL_NONE, 0, 0};
+  if (!journalValid(j)) return r;
+
+  float gain = bowlWeight - j.startWeight;
+  r.dispensed = gain > j.dispensed ? gain : j.dispensed;
+  if (r.dispensed < 0) r.dispensed = 0;
+
+  float remaining = j.amount - r.dispensed;
+  if (remaining < minIncreaseG) {
+    r.action = JOURNAL_COMPLETE;
+    return r;
+  }
+  if (now < j.startTime || now - j.startTime > maxAgeSecs ||
+      j.resumes >= FEED_JOURNAL_MAX_RESUMES) {
+    r.action = JOURNAL_ABORT;
+    return r;
+  }
+  r.action = JOURNAL_RESUME;
+  r.remaining = remaining;
+  return r;
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <stdint.h>
+
+// ---- Feed journal ----
+// Write-ahead record of the feed in flight, so a reset with the gate open
+// (brownout from a servo current spike, watchdog) is noticed on the next
+// boot instead of silently forgotten.
+//
+// The firmware keeps one copy in RTC memory, which survives brownout,
+// watchdog and panic resets and is updated on every monitor step, and one
+// in flash, which also survives a power cut but is only rewritten at the
+// start, at each quarter of the portion and at the end. Each copy carries
+// a CRC so a half-written or uninitialised record is ignored.
+
+const uint32_t FEED_JOURNAL_MAGIC = 0x464A524E;  // "FJRN"
+const uint8_t  FEED_JOURNAL_MAX_RESUMES = 2;     // then give up: the reset keeps recurring
+
+struct FeedJournal {
+  uint32_t magic;        // FEED_JOURNAL_MAGIC while a feed is in flight
+  uint32_t seq;          // bumped on every update; newest copy wins
+  uint32_t startTime;    // Unix time the feed started
+  int8_t   slot;         // -1 for manual / API
+  uint8_t  manual;
+  uint8_t  resumes;      // times this feed was already resumed after a reset
+  uint8_t  flashQuarter; // quarters of the portion already written to flash
+  float    startWeight;  // bowl weight when the feed started (g)
+  float    amount;       // portion requested (g)
+  float    dispensed;    // bowl gain at the last checkpoint (g)
+  uint32_t crc;          // over everything above
+};
+
+// `resumes` > 0 when this continues an interrupted feed (keep its
+// original start time so the age limit still applies).
+void journalBegin(FeedJournal& j, uint32_t seq, uint32_t startTime, int slot, bool manual,
+                  float startWeight, float amount, uint8_t resumes = 0);
+
+// Records progress. Returns true when the flash copy should be rewritten
+// (a new quarter of the portion has been reached).
+bool journalCheckpoint(FeedJournal& j, float dispensed);
+
+// Feed over: the record no longer describes anything in flight.
+void journalClear(FeedJournal& j);
+
+bool journalValid(const FeedJournal& j);
+
+// Of two copies (RTC, flash), the valid one with the higher seq, or nullptr.
+const FeedJournal* newestJournal(const FeedJournal& a, const FeedJournal& b);
+
+// ---- Boot reconciliation ----
+enum JournalAction : uint8_t {
+  JOURNAL_NONE,      // nothing was in flight
+  JOURNAL_COMPLETE,  // the portion was already in the bowl: log it as done
+  JOURNAL_RESUME,    // dispense `remaining` more
+  JOURNAL_ABORT      // too old or resumed too often: log it as aborted
+};
+
+struct JournalResume {
+  uint8_t action;     // JournalAction
+  float   dispensed;  // best estimate of what the interrupted feed delivered
+  float   remaining;  // JOURNAL_RESUME: grams still to dispense
+};
+
+// Decides what to do with an interrupted feed given the bowl weight now.
+// Dispensed is the larger of the last checkpoint and the bowl's gain over
+// the start weight: the pet may have eaten since, but food never flows
+// back into the hopper. A feed older than `maxAgeSecs` (or with no usable
+// clock, `now` < start) is not resumed, since the pet may have been fed
+// by hand in the meantime.
+JournalResume reconcileJournal(const FeedJournal& j, float bowlWeight, uint32_t now,
+                               uint32_t maxAgeSecs, float minIncreaseG);
@@ -0,0 +1,21 @@
+#include "feed_log.h"
+
+void pushFeedLog(FeedLogEntry* log, int capacity, int& count, const FeedLogEntry& entry) {
+  // Shift older entries down (newest at index 0)
+  for (int i = capacity - 1; i > 0; --i) {
+    log[i] = log[i - 1];
+  }
+  log[0] = entry;
+  log[0].used = true;
+
+  if (count < capacity) {
+    count++;
+  }
+}
+
+void clearFeedLog(FeedLogEntry* log, int capacity, int& count) {
+  count = 0;
+  for (int i = 0; i < capacity; ++i) {
+    log[i].used = false;
+  }
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+// ---- Feed history log ----
+struct FeedLogEntry {
+  bool  used;
+  bool  manual;       // true = manual, false = scheduled slot
+  int   slotIndex;    // -1 for manual
+  int   hour;
+  int   minute;
+  float target;       // target weight (g)
+  float finalWeight;  // final measured weight (g)
+};
+
+// Inserts `entry` at index 0 (newest first), dropping the oldest when full.
+void pushFeedLog(FeedLogEntry* log, int capacity, int& count, const FeedLogEntry& entry);
+
+void clearFeedLog(FeedLogEntry* log, int capacity, int& count);
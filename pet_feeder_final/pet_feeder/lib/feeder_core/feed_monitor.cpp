@@ -0,0 +1,42 @@
+#include "feed_monitor.h"
+
+void startFeedProgress(FeedProgress& p, float bowlWeight, float amount, uint32_t nowMs) {
+  p.target       = bowlWeight + amount;
+  p.startMs      = nowMs;
+  p.lastWeight   = bowlWeight;
+  p.lastChangeMs = nowMs;
+  p.maxGapMs     = 0;
+}
+
+static void countIncrease(FeedProgress& p, float w, uint32_t nowMs) {
+  if (nowMs - p.lastChangeMs > p.maxGapMs) p.maxGapMs = nowMs - p.lastChangeMs;
+  p.lastWeight = w;
+  p.lastChangeMs = nowMs;
+}
+
+FeedCheck checkFeedProgress(FeedProgress& p, float weight, bool feederOpen,
+                            uint32_t nowMs, const FeedLimits& limits) {
+  float w = weight;
+
+  // Close when target reached
+  if (feederOpen && w >= p.target && p.target > 0) {
+    countIncrease(p, w, nowMs);
+    return FEED_TARGET_REACHED;
+  }
+
+  // Stuck detection: weight not increasing enough while open
+  if (feederOpen) {
+    if (w > p.lastWeight + limits.minIncreaseG) {
+      countIncrease(p, w, nowMs);
+    }
+    if (nowMs - p.lastChangeMs > limits.stuckWindowMs) {
+      return FEED_STUCK;
+    }
+  }
+
+  // Safety timeout
+  if (nowMs - p.startMs > limits.timeoutMs) {
+    return FEED_TIMEOUT;
+  }
+  return FEED_CONTINUE;
+}
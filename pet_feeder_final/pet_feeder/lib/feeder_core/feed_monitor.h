@@ -0,0 +1,33 @@
+#pragma once
+#include <stdint.h>
+
+// ---- Safety & stuck detection ----
+struct FeedLimits {
+  uint32_t timeoutMs;      // safety timeout
+  uint32_t stuckWindowMs;  // no increase for this long -> consider stuck
+  float    minIncreaseG;   // noise floor for "increase"
+};
+
+// Progress of the feed in flight (scheduled or manual).
+struct FeedProgress {
+  float    target;         // bowl weight to stop at (g)
+  uint32_t startMs;
+  float    lastWeight;     // last weight that counted as an increase
+  uint32_t lastChangeMs;
+  uint32_t maxGapMs;       // longest wait for an increase so far (flow_stats.h)
+};
+
+enum FeedCheck {
+  FEED_CONTINUE,
+  FEED_TARGET_REACHED,
+  FEED_STUCK,
+  FEED_TIMEOUT
+};
+
+// Begin a feed that adds `amount` grams on top of the current bowl weight.
+void startFeedProgress(FeedProgress& p, float bowlWeight, float amount, uint32_t nowMs);
+
+// One monitor step: target first, then stuck (only while the gate is open),
+// then the overall timeout.
+FeedCheck checkFeedProgress(FeedProgress& p, float weight, bool feederOpen,
+                            uint32_t nowMs, const FeedLimits& limits);
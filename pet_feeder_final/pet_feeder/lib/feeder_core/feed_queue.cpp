@@ -0,0 +1,117 @@
+#include "feed_queue.h"
+
+void initFeedQueue(FeedQueue& q, FeedCommand* storage, int capacity) {
+  q.items = storage;
+  q.capacity = capacity;
+  clearFeedQueue(q);
+}
+
+void clearFeedQueue(FeedQueue& q) {
+  q.count = 0;
+  q.coalesced = 0;
+  q.expired = 0;
+  q.dropped = 0;
+  q.lastWaitMs = 0;
+  q.maxWaitMs = 0;
+}
+
+static void removeAt(FeedQueue& q, int i) {
+  for (int j = i; j < q.count - 1; ++j) {
+    q.items[j] = q.items[j + 1];
+  }
+  q.count--;
+}
+
+// Newest command with the lowest priority, or -1 when empty
+static int evictionCandidate(const FeedQueue& q) {
+  int found = -1;
+  for (int i = 0; i < q.count; ++i) {
+    if (found < 0 || q.items[i].source <= q.items[found].source) found = i;
+  }
+  return found;
+}
+
+FeedEnqueue enqueueFeed(FeedQueue& q, const FeedCommand& cmd) {
+  for (int i = 0; i < q.count; ++i) {
+    FeedCommand& c = q.items[i];
+    if (c.source != cmd.source) continue;
+
+    if (cmd.source == FEED_SRC_SCHEDULED) {
+      if (c.slotIndex != cmd.slotIndex || c.mode != cmd.mode) continue;
+      c.amount += cmd.amount;
+      if (c.merged < 0xFF) c.merged++;
+      q.coalesced++;
+      return FEED_MERGED;
+    }
+    if (c.amount == cmd.amount && c.mode == cmd.mode &&
+        cmd.enqueuedMs - c.enqueuedMs < FEED_DUPLICATE_MS) {
+      q.coalesced++;
+      return FEED_DUPLICATE;
+    }
+  }
+
+  if (q.count >= q.capacity) {
+    int victim = evictionCandidate(q);
+    if (victim < 0 || q.items[victim].source >= cmd.source) {
+      q.dropped++;
+      return FEED_QUEUE_FULL;
+    }
+    removeAt(q, victim);
+    q.dropped++;
+  }
+
+  q.items[q.count] = cmd;
+  q.items[q.count].merged = 0;
+  q.count++;
+  return FEED_QUEUED;
+}
+
+int expireFeeds(FeedQueue& q, uint32_t nowMs) {
+  int removed = 0;
+  for (int i = 0; i < q.count;) {
+    const FeedCommand& c = q.items[i];
+    if (nowMs - c.enqueuedMs > c.maxWaitMs) {
+      removeAt(q, i);
+      removed++;
+    } else {
+      ++i;
+    }
+  }
+  q.expired += removed;
+  return removed;
+}
+
+int nextFeedIndex(const FeedQueue& q) {
+  int best = -1;
+  for (int i = 0; i < q.count; ++i) {
+    if (best < 0 || q.items[i].source > q.items[best].source) best = i;
+  }
+  return best;
+}
+
+bool popFeed(FeedQueue& q, uint32_t nowMs, FeedCommand& out) {
+  expireFeeds(q, nowMs);
+  int i = nextFeedIndex(q);
+  if (i < 0) return false;
+
+  out = q.items[i];
+  removeAt(q, i);
+
+  q.lastWaitMs = nowMs - out.enqueuedMs;
+  if (q.lastWaitMs > q.maxWaitMs) q.maxWaitMs = q.lastWaitMs;
+  return true;
+}
+
+uint32_t oldestFeedWaitMs(const FeedQueue& q, uint32_t nowMs) {
+  // Arrival order, so the first entry is the oldest
+  return q.count > 0 ? nowMs - q.items[0].enqueuedMs : 0;
+}
+
+const char* feedSourceName(uint8_t source) {
+  switch (source) {
+    case FEED_SRC_API:       return "api";
+    case FEED_SRC_SCHEDULED: return "scheduled";
+    case FEED_SRC_MANUAL:    return "manual";
+    default:                 return "?";
+  }
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <stdint.h>
+
+// ---- Feed command queue ----
+// Every feed request (slot fire, button, HTTP) becomes a FeedCommand. The
+// dispenser takes the next one as soon as it is free, so a slot that comes
+// due during another feed runs right after it instead of being lost.
+
+// Ordered by priority, highest last: someone standing at the feeder first,
+// then the schedule, then remote requests.
+enum FeedSource : uint8_t {
+  FEED_SRC_API,
+  FEED_SRC_SCHEDULED,
+  FEED_SRC_MANUAL,
+  FEED_SRC_COUNT
+};
+
+struct FeedCommand {
+  uint8_t  source;      // FeedSource
+  int8_t   slotIndex;   // -1 for manual / API
+  uint8_t  merged;      // how many later requests were folded into this one
+  float    amount;      // grams to add
+  uint32_t enqueuedMs;
+  uint32_t maxWaitMs;   // dropped if not started within this long
+  uint8_t  mode;        // DispenseMode (dispense.h)
+};
+
+// Two manual/API requests for the same amount this close together are one
+// request (double press, HTTP retry).
+const uint32_t FEED_DUPLICATE_MS = 2000;
+
+struct FeedQueue {
+  FeedCommand* items;   // arrival order, caller-owned storage
+  int          capacity;
+  int          count;
+
+  // Counters since boot / last clear
+  uint32_t coalesced;   // merged or duplicate requests
+  uint32_t expired;
+  uint32_t dropped;     // rejected or evicted because the queue was full
+  uint32_t lastWaitMs;  // wait of the most recently started command
+  uint32_t maxWaitMs;
+};
+
+enum FeedEnqueue {
+  FEED_QUEUED,
+  FEED_MERGED,      // scheduled feed added to one of its slot already waiting
+  FEED_DUPLICATE,   // same manual/API request already waiting
+  FEED_QUEUE_FULL   // nothing of lower priority to evict
+};
+
+void initFeedQueue(FeedQueue& q, FeedCommand* storage, int capacity);
+void clearFeedQueue(FeedQueue& q);
+
+// Coalescing: a scheduled feed joins one of the same slot and profile that
+// is still waiting (amounts add up, the earlier wait time is kept), so a
+// slot that comes due again before it ran feeds once. Feeds of different
+// slots stay apart: each is logged, rolled up and dispensed as its own. A
+// manual/API request equal to a waiting one (amount and profile) from the
+// same source within FEED_DUPLICATE_MS is dropped. When full, the newest
+// command of the lowest priority is evicted if the new one outranks it.
+FeedEnqueue enqueueFeed(FeedQueue& q, const FeedCommand& cmd);
+
+// Removes commands that waited longer than their maxWaitMs.
+int expireFeeds(FeedQueue& q, uint32_t nowMs);
+
+// Index of the command to run next (highest priority, oldest first), or -1.
+int nextFeedIndex(const FeedQueue& q);
+
+// Expires, then takes the next command and records its wait.
+bool popFeed(FeedQueue& q, uint32_t nowMs, FeedCommand& out);
+
+// How long the oldest waiting command has waited (0 when empty).
+uint32_t oldestFeedWaitMs(const FeedQueue& q, uint32_t nowMs);
+
+const char* feedSourceName(uint8_t source);
@@ -0,0 +1,254 @@
+#include "feed_rec.h"
+#include <math.h>
+#include <string.h>
+
+void initFeedRecorder(FeedRecorder& r, FeedRecSample* storage, uint32_t capacity) {
+  memset(&r, 0, sizeof(r));
+  r.samples = storage;
+  r.capacity = capacity;
+}
+
+void recBegin(FeedRecorder& r, const FeedRecHeader& h, uint32_t nowMs) {
+  r.header = h;
+  r.header.magic = REC_MAGIC;
+  r.header.outcome = FEED_CONTINUE;
+  r.header.flags = 0;
+  r.header.reserved = 0;
+  r.header.closeMs = 0;
+  r.header.samples = 0;
+  r.startMs = nowMs;
+  r.lastSampleMs = nowMs;
+  r.lastOpening = 0;
+  r.state = r.capacity > 0 ? REC_FEEDING : REC_IDLE;
+}
+
+void recSample(FeedRecorder& r, uint32_t nowMs, int32_t raw, uint8_t opening) {
+  if (r.state != REC_FEEDING && r.state != REC_SETTLING) return;
+  uint32_t n = r.header.samples;
+  if (n > 0 && opening == r.lastOpening && nowMs - r.lastSampleMs < REC_MIN_INTERVAL_MS) return;
+
+  // The last few slots are for settling: a recording without the food
+  // that was in the air cannot tell the overshoot
+  uint32_t reserve = r.capacity / 4 < REC_SETTLE_RESERVE ? r.capacity / 4 : REC_SETTLE_RESERVE;
+  uint32_t ms = nowMs - r.startMs;
+  if (r.state == REC_FEEDING && n >= r.capacity - reserve) {
+    r.header.flags |= REC_TRUNCATED;
+    return;
+  }
+  uint32_t i = n < r.capacity ? n : r.capacity - 1;  // settling when full: keep the newest
+  FeedRecSample& s = r.samples[i];
+  s.ms = ms;
+  s.raw = raw;
+  s.opening = opening;
+  memset(s.reserved, 0, sizeof(s.reserved));
+  if (i == n) r.header.samples++;
+  r.lastSampleMs = nowMs;
+  r.lastOpening = opening;
+
+  if (r.state == REC_SETTLING && ms - r.header.closeMs >= REC_SETTLE_MS) r.state = REC_DONE;
+}
+
+void recClose(FeedRecorder& r, uint8_t outcome, uint32_t nowMs) {
+  if (r.state != REC_FEEDING) return;
+  r.header.outcome = outcome;
+  r.header.closeMs = nowMs - r.startMs;
+  r.state = REC_SETTLING;
+}
+
+uint32_t recSeal(FeedRecorder& r) {
+  if (r.state != REC_SETTLING && r.state != REC_DONE) return 0;
+  if (r.header.samples == 0) return 0;
+  if (r.state == REC_SETTLING) r.header.flags |= REC_UNSETTLED;
+  return sizeof(FeedRecHeader) + r.header.samples * sizeof(FeedRecSample);
+}
+
+// ---- Replay ----
+
+ReplayParams recRecordedParams(const FeedRecHeader& h, uint32_t fallMs, uint8_t deadbandPct) {
+  ReplayParams p;
+  p.limits = {h.timeoutMs, h.stuckWindowMs, h.minIncreaseG};
+  p.mode = h.mode < DISPENSE_MODE_COUNT ? h.mode : (uint8_t)DISPENSE_FULL;
+  p.profile = kDispenseProfiles[p.mode];
+  p.fallMs = fallMs;
+  p.deadbandPct = deadbandPct;
+  return p;
+}
+
+static float sampleWeight(const FeedRecHeader& h, const FeedRecSample& s) {
+  return recWeight(h, s.raw);
+}
+
+void recRecordedResult(const FeedRecHeader& h, const FeedRecSample* s, uint32_t n,
+                       ReplayResult& out) {
+  memset(&out, 0, sizeof(out));
+  out.outcome = h.outcome;
+  out.closeMs = h.closeMs;
+  out.finalG = n > 0 ? sampleWeight(h, s[n - 1]) : h.startWeight;
+  out.errorG = out.finalG - h.target;
+}
+
+// Share of full flow at an opening
+static float flowShare(uint8_t opening, uint8_t deadbandPct) {
+  if (opening <= deadbandPct) return 0;
+  if (opening >= 100) return 1;
+  return (float)(opening - deadbandPct) / (100 - deadbandPct);
+}
+
+// Full-open gate time the recording had released by `ms`: each sample's
+// opening holds until the next one.
+struct ReleasedCursor {
+  uint32_t j;
+  float    released;   // up to s[j].ms
+};
+
+static float releasedAt(const FeedRecSample* s, uint32_t n, uint8_t deadbandPct,
+                        ReleasedCursor& c, uint32_t ms) {
+  if (ms < s[0].ms) return 0;
+  while (c.j + 1 < n && s[c.j + 1].ms <= ms) {
+    c.released += flowShare(s[c.j].opening, deadbandPct) * (s[c.j + 1].ms - s[c.j].ms);
+    c.j++;
+  }
+  return c.released + flowShare(s[c.j].opening, deadbandPct) * (ms - s[c.j].ms);
+}
+
+uint32_t recEstimateFallMs(const FeedRecHeader& h, const FeedRecSample* s, uint32_t n,
+                           uint8_t deadbandPct) {
+  if (n < 2) return 0;
+  uint32_t i = 0;
+  while (i < n && s[i].opening == 0) i++;
+  if (i == n) return 0;
+  uint32_t openMs = s[i].ms;
+  uint8_t opening = s[i].opening;  // the first food went through at this
+
+  // Mean rate, g per full-open ms, to date the first rise back from its size
+  ReleasedCursor c = {0, 0.0f};
+  float total = releasedAt(s, n, deadbandPct, c, s[n - 1].ms);
+  float w0 = sampleWeight(h, s[0]);
+  float rate = total > 0 ? (sampleWeight(h, s[n - 1]) - w0) / total : 0;
+  if (rate <= 0) return 0;
+
+  // A fraction of the noise floor: the first grams, not the first step the
+  // monitor would count
+  float threshold = h.minIncreaseG / 4 > 0.25f ? h.minIncreaseG / 4 : 0.25f;
+  for (; i < n; i++) {
+    float rise = sampleWeight(h, s[i]) - w0;
+    if (rise <= threshold) continue;
+    float share = flowShare(opening, deadbandPct);
+    float since = share > 0 ? rise / (rate * share) : 0;
+    // Never before the previous reading, which showed nothing yet
+    float landedMs = s[i].ms - since;
+    if (i > 0 && landedMs < s[i - 1].ms) landedMs = s[i - 1].ms;
+    float fall = landedMs - openMs;
+    if (fall < 0) return 0;
+    return fall < 1000 ? (uint32_t)lroundf(fall) : 1000;
+  }
+  return 0;
+}
+
+// Recorded bowl weight once `released` ms of full-open gate time had
+// landed, interpolated between readings; past the end, extrapolated at
+// `rate` (g per full-open ms).
+static float recordedWeight(const FeedRecHeader& h, const FeedRecSample* s, uint32_t n,
+                            const ReplayParams& params, float released, float rate,
+                            bool& extrapolated) {
+  ReleasedCursor c = {0, 0.0f};
+  float w = sampleWeight(h, s[0]);
+  float lastLanded = 0;
+  for (uint32_t i = 0; i < n; i++) {
+    float landed = s[i].ms >= params.fallMs
+                       ? releasedAt(s, n, params.deadbandPct, c, s[i].ms - params.fallMs)
+                       : 0.0f;
+    // Half a millisecond of slack for the different summation order
+    if (landed > released + 0.5f) {
+      // Between two readings: a reading is a step of a gram or more at
+      // full flow, about what is in the air when the gate closes
+      if (i == 0 || released <= lastLanded) return w;
+      return w + (sampleWeight(h, s[i]) - w) * (released - lastLanded) / (landed - lastLanded);
+    }
+    w = sampleWeight(h, s[i]);
+    lastLanded = landed;
+  }
+  if (released > lastLanded + 0.5f && rate > 0) {
+    extrapolated = true;
+    w += rate * (released - lastLanded);
+  }
+  return w;
+}
+
+const int REPLAY_HISTORY = 64;  // gate steps kept for the fall delay
+
+struct ReplayStep {
+  uint32_t ms;
+  float    released;   // up to ms
+  uint8_t  opening;    // from ms on
+};
+
+void recReplay(const FeedRecHeader& h, const FeedRecSample* s, uint32_t n,
+               const ReplayParams& params, ReplayResult& out) {
+  memset(&out, 0, sizeof(out));
+  if (n == 0) {
+    out.outcome = FEED_TIMEOUT;
+    return;
+  }
+
+  // Flow past the recording only if the hopper was still delivering
+  float rate = 0;
+  if (h.outcome == FEED_TARGET_REACHED || h.outcome == FEED_TIMEOUT) {
+    ReleasedCursor c = {0, 0.0f};
+    float total = releasedAt(s, n, params.deadbandPct, c, s[n - 1].ms);
+    if (total > 0) rate = (sampleWeight(h, s[n - 1]) - sampleWeight(h, s[0])) / total;
+  }
+  uint32_t interval = n > 1 ? (s[n - 1].ms - s[0].ms) / (n - 1) : 100;
+  if (interval < REC_MIN_INTERVAL_MS) interval = REC_MIN_INTERVAL_MS;
+
+  FeedProgress p;
+  float start = h.startWeight;
+  startFeedProgress(p, start, h.target - start, 0);
+  Dispenser d = {};
+  startDispenseProfile(d, params.profile, params.mode, 0);
+
+  ReplayStep hist[REPLAY_HISTORY];
+  int count = 1;
+  int newest = 0;
+  hist[0] = {0, 0.0f, d.opening};
+
+  uint32_t prevMs = 0;
+  float released = 0;
+  uint8_t opening = d.opening;
+  for (uint32_t k = 0;; k++) {
+    uint32_t t = k < n ? s[k].ms : s[n - 1].ms + (k - n + 1) * interval;
+    if (t < prevMs) continue;
+    released += flowShare(opening, params.deadbandPct) * (t - prevMs);
+    prevMs = t;
+
+    // What the replayed gate had released fallMs ago is in the bowl now
+    float landed = 0;
+    if (t >= params.fallMs) {
+      uint32_t x = t - params.fallMs;
+      int i = newest;
+      for (int left = count - 1; left > 0 && hist[i].ms > x; left--) {
+        i = (i + REPLAY_HISTORY - 1) % REPLAY_HISTORY;
+      }
+      const ReplayStep& e = hist[i];
+      landed = e.released;
+      if (x >= e.ms) landed += flowShare(e.opening, params.deadbandPct) * (x - e.ms);
+    }
+    float w = recordedWeight(h, s, n, params, landed, rate, out.extrapolated);
+
+    uint8_t next = stepDispense(d, p, w, params.limits.stuckWindowMs, t);
+    FeedCheck check = checkFeedProgress(p, w, dispenseRunning(d), t, params.limits);
+    if (check != FEED_CONTINUE) {
+      out.outcome = check;
+      out.closeMs = t;
+      out.finalG = recordedWeight(h, s, n, params, released, rate, out.extrapolated);
+      out.errorG = out.finalG - h.target;
+      out.agitations = d.agitations;
+      return;
+    }
+
+    opening = next;
+    newest = (newest + 1) % REPLAY_HISTORY;
+    hist[newest] = {t, released, opening};
+    if (count < REPLAY_HISTORY) count++;
+  }
+}
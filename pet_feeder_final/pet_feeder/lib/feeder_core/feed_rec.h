@@ -0,0 +1,146 @@
+#pragma once
+#include <stdint.h>
+#include "feed_monitor.h"
+#include "dispense.h"
+
+// Feed recordings: raw scale counts and gate commands of real feeds, so the
+// controller can be tuned offline (tools/replay.cpp) instead of on food.
+//
+// While a feed runs the feeder takes one sample per monitor pass (at most
+// every REC_MIN_INTERVAL_MS unless the gate moved) into caller-owned
+// storage, keeps sampling for REC_SETTLE_MS after the gate closes so the
+// food still in the air is in the recording, and then appends the feed to a
+// file on SPIFFS (feed_rec_store.h, GET /api/recordings). A file is a
+// sequence of feeds, each a FeedRecHeader followed by header.samples
+// FeedRecSamples, little-endian as laid out on the ESP32 and x86 hosts.
+//
+// Replay runs the controller (dispense.h + feed_monitor.h) against a
+// recording. The recording gives the bowl weight as a function of how much
+// full-open gate time had been released (the same measure as
+// Dispenser.openMs), fallMs earlier; replay feeds the controller the weight
+// for the gate time *its* commands released, so a different profile or
+// different limits see the real feed's flow, bridges and settling, and the
+// food in the air when it closes lands as it did. Past the end of the
+// recorded flow the weight is extrapolated at the feed's mean rate.
+// Gate time counts in proportion to the opening above deadbandPct, below
+// which nothing passes. Flow that resumed after the recorded controller
+// agitated resumes at the same point in replay, agitated or not, so replay
+// can judge stuck windows against a real jam but not whether skipping the
+// agitation would have cleared it.
+
+const uint32_t REC_MAGIC           = 0x31524546;  // "FER1"
+const uint32_t REC_MIN_INTERVAL_MS = 50;
+const uint32_t REC_SETTLE_MS       = 2000;
+const uint32_t REC_SETTLE_RESERVE  = 8;           // samples kept free for settling
+
+// header.flags
+const uint8_t REC_TRUNCATED = 0x01;  // storage full before the gate closed
+const uint8_t REC_UNSETTLED = 0x02;  // saved before REC_SETTLE_MS had passed
+
+struct FeedRecHeader {
+  uint32_t magic;
+  uint32_t seq;
+  uint32_t time;           // Unix seconds at the start
+  float    target;         // bowl weight to stop at (g)
+  float    startWeight;
+  float    scale;          // counts per gram
+  int32_t  offset;         // counts at 0 g
+  uint32_t timeoutMs;      // the feed's limits
+  uint32_t stuckWindowMs;
+  float    minIncreaseG;
+  uint8_t  mode;           // DispenseMode
+  uint8_t  outcome;        // FeedCheck that ended it
+  uint8_t  flags;
+  uint8_t  reserved;
+  uint32_t closeMs;        // gate closed, since the start
+  uint32_t samples;
+};
+
+struct FeedRecSample {
+  uint32_t ms;             // since the start
+  int32_t  raw;            // scale counts
+  uint8_t  opening;        // gate command after this reading, %
+  uint8_t  reserved[3];
+};
+
+static_assert(sizeof(FeedRecHeader) == 52, "recording files assume 52-byte headers");
+static_assert(sizeof(FeedRecSample) == 12, "recording files assume 12-byte samples");
+
+// Newest feeds in REC_PATH; past REC_FILE_MAX it becomes REC_OLD_PATH
+// (replacing the one before), so at most twice that is kept.
+#define REC_PATH     "/rec/feeds.bin"
+#define REC_OLD_PATH "/rec/feeds.old"
+const uint32_t REC_FILE_MAX = 96 * 1024;  // ~8000 samples, a dozen feeds or more
+
+// ---- Recording ----
+
+enum RecState : uint8_t {
+  REC_IDLE,
+  REC_FEEDING,
+  REC_SETTLING,   // gate closed, still sampling
+  REC_DONE        // ready to save
+};
+
+struct FeedRecorder {
+  FeedRecHeader  header;
+  FeedRecSample* samples;    // caller-owned
+  uint32_t       capacity;
+  uint32_t       startMs;
+  uint32_t       lastSampleMs;
+  uint8_t        lastOpening;
+  uint8_t        state;      // RecState
+};
+
+void initFeedRecorder(FeedRecorder& r, FeedRecSample* storage, uint32_t capacity);
+
+// Starts a recording; `h` carries the feed's seq, time, target, scale and
+// limits, the rest is filled in here.
+void recBegin(FeedRecorder& r, const FeedRecHeader& h, uint32_t nowMs);
+void recSample(FeedRecorder& r, uint32_t nowMs, int32_t raw, uint8_t opening);
+void recClose(FeedRecorder& r, uint8_t outcome, uint32_t nowMs);
+
+// Completes the header for saving (sample count, REC_UNSETTLED when saved
+// early because the next feed started) and returns the recording's size in
+// bytes, 0 if there is nothing to save.
+uint32_t recSeal(FeedRecorder& r);
+inline void recClear(FeedRecorder& r) { r.state = REC_IDLE; }
+
+// ---- Replay ----
+
+struct ReplayParams {
+  FeedLimits      limits;
+  DispenseProfile profile;
+  uint8_t         mode;      // reported only
+  uint32_t        fallMs;
+  uint8_t         deadbandPct;
+};
+
+struct ReplayResult {
+  uint8_t  outcome;          // FeedCheck
+  uint32_t closeMs;          // gate open to closed
+  float    finalG;           // settled bowl weight
+  float    errorG;           // finalG - target
+  uint8_t  agitations;
+  bool     extrapolated;     // needed flow past the end of the recording
+};
+
+inline float recWeight(const FeedRecHeader& h, int32_t raw) {
+  return h.scale != 0 ? (raw - h.offset) / h.scale : 0.0f;
+}
+
+// The parameters the feed was recorded with (table profile of h.mode).
+ReplayParams recRecordedParams(const FeedRecHeader& h, uint32_t fallMs, uint8_t deadbandPct);
+
+// Delay from the gate opening to the first food landing: the first reading
+// that rose, dated back by its size at the feed's mean rate.
+uint32_t recEstimateFallMs(const FeedRecHeader& h, const FeedRecSample* s, uint32_t n,
+                           uint8_t deadbandPct);
+
+// What actually happened, in replay terms.
+void recRecordedResult(const FeedRecHeader& h, const FeedRecSample* s, uint32_t n,
+                       ReplayResult& out);
+
+// Runs the controller with `params` against the recording (params.fallMs
+// and deadbandPct describe the feeder it was recorded on).
+void recReplay(const FeedRecHeader& h, const FeedRecSample* s, uint32_t n,
+               const ReplayParams& params, ReplayResult& out);
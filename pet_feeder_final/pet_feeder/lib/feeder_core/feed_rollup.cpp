@@ -0,0 +1,71 @@
+#include "feed_rollup.h"
+#include <string.h>
+
+void initFeedRollups(FeedRollups& r) {
+  memset(&r, 0, sizeof(r));
+  for (PeriodRollup& d : r.days) d.period = FEED_ROLLUP_EMPTY;
+  for (PeriodRollup& w : r.weeks) w.period = FEED_ROLLUP_EMPTY;
+  for (SlotRollup& s : r.slots) s.week = FEED_ROLLUP_EMPTY;
+}
+
+void runningAdd(RunningStat& s, float x) {
+  s.n++;
+  float d = x - s.mean;
+  s.mean += d / s.n;
+  s.m2 += d * (x - s.mean);
+}
+
+float runningVariance(const RunningStat& s) {
+  return s.n > 1 ? s.m2 / (s.n - 1) : 0.0f;
+}
+
+static uint16_t bump(uint16_t n) { return n < UINT16_MAX ? n + 1 : n; }
+
+static void addPeriod(PeriodRollup* ring, int size, uint32_t period, bool completed,
+                      float dispensedG) {
+  PeriodRollup& p = ring[period % size];
+  if (p.period != period) p = {period, 0, 0, 0.0f};  // a new day (week) takes the row over
+  p.feeds = bump(p.feeds);
+  if (!completed) p.aborts = bump(p.aborts);
+  p.dispensedG += dispensedG;
+}
+
+void rollupFeed(FeedRollups& r, uint32_t t, int slot, bool completed, float dispensedG,
+                float overshootG) {
+  if (dispensedG < 0) dispensedG = 0;  // the pet ate while it ran
+  uint32_t week = rollupWeek(t);
+  addPeriod(r.days, FEED_ROLLUP_DAYS, rollupDay(t), completed, dispensedG);
+  addPeriod(r.weeks, FEED_ROLLUP_WEEKS, week, completed, dispensedG);
+
+  if (slot >= FEED_ROLLUP_SLOTS) return;
+  SlotRollup& s = r.slots[slot < 0 ? FEED_ROLLUP_MANUAL : slot];
+  s.feeds = bump(s.feeds);
+  s.dispensedG += dispensedG;
+  if (!completed) {
+    s.aborts = bump(s.aborts);
+    return;  // stopped short: its "overshoot" says nothing about the cut-off
+  }
+  if (s.week != week) {
+    s.week = week;
+    s.thisWeek = {};
+  }
+  runningAdd(s.thisWeek, overshootG);
+  runningAdd(s.allTime, overshootG);
+}
+
+static const PeriodRollup* periodAt(const PeriodRollup* ring, int size, uint32_t period) {
+  const PeriodRollup& p = ring[period % size];
+  return p.period == period ? &p : nullptr;
+}
+
+const PeriodRollup* rollupDayAt(const FeedRollups& r, uint32_t t) {
+  return periodAt(r.days, FEED_ROLLUP_DAYS, rollupDay(t));
+}
+
+const PeriodRollup* rollupWeekAt(const FeedRollups& r, uint32_t t) {
+  return periodAt(r.weeks, FEED_ROLLUP_WEEKS, rollupWeek(t));
+}
+
+RunningStat slotWeekOvershoot(const SlotRollup& s, uint32_t t) {
+  return s.week == rollupWeek(t) ? s.thisWeek : RunningStat{};
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <stdint.h>
+#include "feeder_time.h"
+
+// ---- Feed rollups (/api/stats) ----
+// Summaries updated as each feed is logged, so "grams dispensed today" or
+// "slot 2's overshoot this week" is read from a few fixed-size tables
+// rather than worked out from the feed log (ten entries) or the SPIFFS
+// history. Every update and every lookup is O(1).
+//
+// Days and weeks are rings indexed by day (week) number, each row stamped
+// with the one it holds; a row with an older stamp is empty and is reused
+// when its turn comes. Days are local, as the RTC keeps them; weeks start
+// on Monday. Per slot, plus one row for manual and API feeds, the
+// overshoot (final bowl weight minus target) of the feeds that reached
+// their target goes into Welford's running mean and variance, for this
+// week and since the tables were cleared. A feed that ended short of its
+// target (stuck, timed out, abandoned after a reset) counts as an abort.
+
+const int      FEED_ROLLUP_DAYS   = 14;
+const int      FEED_ROLLUP_WEEKS  = 8;
+const int      FEED_ROLLUP_SLOTS  = 16;                 // scheduled slots tracked
+const int      FEED_ROLLUP_MANUAL = FEED_ROLLUP_SLOTS;  // row of manual/API feeds
+const uint32_t FEED_ROLLUP_EMPTY  = 0xFFFFFFFF;         // stamp of an unused row
+
+struct PeriodRollup {
+  uint32_t period;      // day or week number; FEED_ROLLUP_EMPTY = unused
+  uint16_t feeds;
+  uint16_t aborts;
+  float    dispensedG;
+};
+
+// Welford's running mean and variance
+struct RunningStat {
+  uint32_t n;
+  float    mean;
+  float    m2;          // sum of squared deviations from the mean
+};
+
+struct SlotRollup {
+  uint16_t    feeds;
+  uint16_t    aborts;
+  float       dispensedG;
+  uint32_t    week;       // the week `thisWeek` covers
+  RunningStat thisWeek;   // overshoot (g)
+  RunningStat allTime;
+};
+
+struct FeedRollups {
+  PeriodRollup days[FEED_ROLLUP_DAYS];
+  PeriodRollup weeks[FEED_ROLLUP_WEEKS];
+  SlotRollup   slots[FEED_ROLLUP_SLOTS + 1];
+};
+
+inline uint32_t rollupDay(uint32_t t)  { return t / SECS_PER_DAY; }
+inline uint32_t rollupWeek(uint32_t t) { return (t / SECS_PER_DAY + 3) / 7; }  // 1970-01-01 was a Thursday
+inline uint32_t rollupWeekStart(uint32_t week) { return (week * 7 - 3) * SECS_PER_DAY; }
+
+void initFeedRollups(FeedRollups& r);
+
+// One finished feed at local time `t`. `slot` is the slot index, -1 for a
+// manual or API feed; slots past FEED_ROLLUP_SLOTS only reach the day and
+// week totals. `completed`: it reached its target.
+void rollupFeed(FeedRollups& r, uint32_t t, int slot, bool completed, float dispensedG,
+                float overshootG);
+
+// The row of the day (week) holding `t`, or nullptr when nothing was fed then
+const PeriodRollup* rollupDayAt(const FeedRollups& r, uint32_t t);
+const PeriodRollup* rollupWeekAt(const FeedRollups& r, uint32_t t);
+
+// A slot's overshoot this week, empty when its last feed was in an earlier one
+RunningStat slotWeekOvershoot(const SlotRollup& s, uint32_t t);
+
+void  runningAdd(RunningStat& s, float x);
+float runningVariance(const RunningStat& s);  // sample variance, 0 below two values
@@ -0,0 +1,26 @@
+#include "feeder_time.h"
+
+// Days-from-civil / civil-from-days (proleptic Gregorian), valid for 1970..2105.
+
+uint32_t unixTime(int year, int month, int day, int hour, int minute, int second) {
+  int y = year - (month <= 2);
+  int era = y / 400;
+  int yoe = y - era * 400;
+  int doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+  int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  int32_t days = era * 146097 + doe - 719468;
+  return (uint32_t)days * SECS_PER_DAY + hour * SECS_PER_HOUR +
+         minute * SECS_PER_MINUTE + second;
+}
+
+void civilDate(uint32_t t, int& year, int& month, int& day) {
+  int32_t z = t / SECS_PER_DAY + 719468;
+  int era = z / 146097;
+  int doe = z - era * 146097;
+  int yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  int doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  int mp = (5 * doy + 2) / 153;
+  day = doy - (153 * mp + 2) / 5 + 1;
+  month = mp < 10 ? mp + 3 : mp - 9;
+  year = yoe + era * 400 + (month <= 2);
+}
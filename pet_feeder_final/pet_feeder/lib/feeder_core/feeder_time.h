@@ -0,0 +1,19 @@
+#pragma once
+#include <stdint.h>
+
+// Wall-clock helpers on Unix seconds (local time, as the RTC keeps it).
+// Hardware-free so the control logic can run in native tests; on the ESP32
+// these values come from DateTime::unixtime().
+
+const uint32_t SECS_PER_MINUTE = 60;
+const uint32_t SECS_PER_HOUR   = 3600;
+const uint32_t SECS_PER_DAY    = 86400;
+
+uint32_t unixTime(int year, int month, int day, int hour, int minute, int second);
+void     civilDate(uint32_t t, int& year, int& month, int& day);
+
+inline int hourOf(uint32_t t)   { return (t % SECS_PER_DAY) / SECS_PER_HOUR; }
+inline int minuteOf(uint32_t t) { return (t % SECS_PER_HOUR) / SECS_PER_MINUTE; }
+inline int secondOf(uint32_t t) { return t % SECS_PER_MINUTE; }
+inline uint32_t startOfDay(uint32_t t) { return t - t % SECS_PER_DAY; }
+inline int dayOfWeek(uint32_t t) { return (t / SECS_PER_DAY + 4) % 7; }  // 0 = Sunday
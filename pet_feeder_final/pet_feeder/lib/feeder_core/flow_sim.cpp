@@ -0,0 +1,63 @@
+#include "flow_sim.h"
+#include <string.h>
+
+void initFlowSim(FlowSim& s, const FlowSimParams& params, float bowlG, uint32_t nowMs) {
+  memset(&s, 0, sizeof(s));
+  s.params = params;
+  s.bowlG = bowlG;
+  s.nowMs = nowMs;
+}
+
+float flowSimRate(const FlowSimParams& p, uint8_t openingPct) {
+  if (openingPct <= p.minOpenPct) return 0;
+  if (openingPct >= 100) return p.fullRateGps;
+  return p.fullRateGps * (openingPct - p.minOpenPct) / (100 - p.minOpenPct);
+}
+
+float flowSimFalling(const FlowSim& s) {
+  float g = 0;
+  for (int i = 0; i < FLOW_SIM_SLOTS; i++) g += s.falling[i];
+  return g;
+}
+
+static void step(FlowSim& s) {
+  // Land what was due, then release into the slot fallMs ahead
+  s.bowlG += s.falling[s.head];
+  s.falling[s.head] = 0;
+
+  float released = s.bridged ? 0 : flowSimRate(s.params, s.opening) * FLOW_SIM_STEP_MS / 1000.0f;
+  uint32_t fallSteps = s.params.fallMs / FLOW_SIM_STEP_MS;
+  if (fallSteps >= FLOW_SIM_SLOTS) fallSteps = FLOW_SIM_SLOTS - 1;
+  if (fallSteps == 0) {
+    s.bowlG += released;
+  } else {
+    s.falling[(s.head + fallSteps) % FLOW_SIM_SLOTS] += released;
+  }
+  s.head = (s.head + 1) % FLOW_SIM_SLOTS;
+
+  s.sinceBridgeG += released;
+  if (s.params.bridgeEveryG > 0 && s.sinceBridgeG >= s.params.bridgeEveryG) {
+    s.bridged = true;
+    s.swings = 0;
+    s.sinceBridgeG = 0;
+    s.bridges++;
+  }
+}
+
+void flowSimAdvance(FlowSim& s, uint32_t nowMs) {
+  while (nowMs - s.nowMs >= FLOW_SIM_STEP_MS) {
+    step(s);
+    s.nowMs += FLOW_SIM_STEP_MS;
+  }
+}
+
+void flowSimGate(FlowSim& s, uint8_t openingPct, uint32_t nowMs) {
+  flowSimAdvance(s, nowMs);
+  int move = (int)openingPct - (int)s.opening;
+  if (s.bridged && (move >= FLOW_SIM_SWING_PCT || move <= -(int)FLOW_SIM_SWING_PCT) &&
+      ++s.swings >= s.params.bridgeSwings) {
+    s.bridged = false;
+    s.broken++;
+  }
+  s.opening = openingPct;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <stdint.h>
+
+// Simulated hopper, gate and bowl, for the Wokwi weight sensor and the
+// dispense-profile measurements in test/test_dispense.
+//
+// Flow through the gate grows linearly from nothing at minOpenPct to
+// fullRateGps wide open. What passes takes fallMs to land in the bowl, so
+// food is still in the air when the target is read: the overshoot a real
+// dispenser shows. Optionally a bridge forms every bridgeEveryG grams and
+// stops the flow until the gate swings hard enough (bridgeSwings moves of at
+// least FLOW_SIM_SWING_PCT) to break it.
+
+const int      FLOW_SIM_SLOTS     = 32;   // delay line, one slot per step
+const uint32_t FLOW_SIM_STEP_MS   = 25;   // so fallMs is at most 775 ms
+const uint8_t  FLOW_SIM_SWING_PCT = 30;
+
+struct FlowSimParams {
+  float    fullRateGps;
+  uint8_t  minOpenPct;
+  uint16_t fallMs;
+  float    bridgeEveryG;   // 0 = never jams
+  uint8_t  bridgeSwings;
+};
+
+struct FlowSim {
+  FlowSimParams params;
+  float    bowlG;
+  float    falling[FLOW_SIM_SLOTS];  // grams landing in each coming step
+  uint8_t  head;
+  uint8_t  opening;
+  uint32_t nowMs;
+  float    sinceBridgeG;
+  bool     bridged;
+  uint8_t  swings;
+  uint16_t bridges;        // formed / broken so far
+  uint16_t broken;
+};
+
+void initFlowSim(FlowSim& s, const FlowSimParams& params, float bowlG, uint32_t nowMs);
+
+// Runs the simulation up to `nowMs` at the current opening.
+void flowSimAdvance(FlowSim& s, uint32_t nowMs);
+
+// Moves the gate at `nowMs` (advancing to it first).
+void flowSimGate(FlowSim& s, uint8_t openingPct, uint32_t nowMs);
+
+// g/s through the gate at an opening
+float flowSimRate(const FlowSimParams& p, uint8_t openingPct);
+
+// Grams still in the air
+float flowSimFalling(const FlowSim& s);
@@ -0,0 +1,78 @@
+#include "flow_stats.h"
+#include <math.h>
+#include <string.h>
+
+void initFlowStats(FlowStats& s) {
+  memset(&s, 0, sizeof(s));
+}
+
+// Exponentially weighted mean and variance; a plain running average until
+// `n` reaches `window`, so the first samples are not swamped by the zero
+// start.
+static void ewUpdate(float& mean, float& var, uint16_t n, uint16_t window, float x) {
+  float alpha = 1.0f / (n < window ? n : window);
+  float diff = x - mean;
+  float incr = alpha * diff;
+  mean += incr;
+  var = (1.0f - alpha) * (var + diff * incr);
+}
+
+bool learnFlow(FlowStats& s, const FeedProgress& p, FeedCheck outcome, float dispensedG,
+               uint32_t openMs) {
+  if (outcome != FEED_TARGET_REACHED && outcome != FEED_TIMEOUT) return false;
+  if (openMs == 0 || dispensedG <= 0) return false;
+  // A timeout with next to nothing dispensed is a jam, not a slow portion
+  if (outcome == FEED_TIMEOUT && p.maxGapMs == 0) return false;
+
+  if (s.feeds < UINT16_MAX) s.feeds++;
+  ewUpdate(s.rateMean, s.rateVar, s.feeds, FLOW_WINDOW, dispensedG * 1000.0f / openMs);
+  ewUpdate(s.gapMeanMs, s.gapVar, s.feeds, FLOW_WINDOW, (float)p.maxGapMs);
+  return true;
+}
+
+void learnIdleNoise(FlowStats& s, float prevWeight, float weight, float maxStepG) {
+  float step = weight - prevWeight;
+  if (fabsf(step) > maxStepG) return;
+  if (s.noiseSamples < UINT16_MAX) s.noiseSamples++;
+  // Var(a - b) = 2 Var(reading) for independent readings
+  float alpha = 1.0f / (s.noiseSamples < FLOW_NOISE_WINDOW ? s.noiseSamples : FLOW_NOISE_WINDOW);
+  s.noiseVar += alpha * (step * step * 0.5f - s.noiseVar);
+}
+
+float flowP10Rate(const FlowStats& s) {
+  if (s.feeds < FLOW_MIN_FEEDS || s.rateMean <= 0) return 0;
+  float p10 = s.rateMean - FLOW_P10_SIGMAS * sqrtf(s.rateVar);
+  float floor = s.rateMean * FLOW_P10_MIN_FRACTION;
+  return p10 > floor ? p10 : floor;
+}
+
+static uint32_t clampMs(float v, uint32_t lo, uint32_t hi) {
+  if (v <= lo) return lo;
+  if (v >= hi) return hi;
+  return (uint32_t)v;
+}
+
+FeedLimits deriveFeedLimits(const FlowStats& s, const FeedLimits& base, float amount) {
+  float p10 = flowP10Rate(s);
+  if (p10 <= 0) return base;
+
+  FeedLimits l = base;
+
+  if (s.noiseSamples >= FLOW_NOISE_WINDOW) {
+    float minInc = FLOW_NOISE_SIGMAS * sqrtf(s.noiseVar);
+    if (minInc < FLOW_MIN_INCREASE_FLOOR_G) minInc = FLOW_MIN_INCREASE_FLOOR_G;
+    if (minInc < l.minIncreaseG) l.minIncreaseG = minInc;
+  }
+
+  // A window the slow flow cannot fill with one increase would trip on a
+  // healthy feed
+  float window = s.gapMeanMs + FLOW_GAP_SIGMAS * sqrtf(s.gapVar) + FLOW_STUCK_MARGIN_MS;
+  float needed = 2.0f * l.minIncreaseG / p10 * 1000.0f;
+  if (window < needed) window = needed;
+  uint32_t stuckMin = FLOW_STUCK_MIN_MS < base.stuckWindowMs ? FLOW_STUCK_MIN_MS : base.stuckWindowMs;
+  l.stuckWindowMs = clampMs(window, stuckMin, base.stuckWindowMs);
+
+  float timeout = fabsf(amount) / p10 * 1000.0f * FLOW_TIMEOUT_FACTOR + FLOW_TIMEOUT_MARGIN_MS;
+  l.timeoutMs = clampMs(timeout, FLOW_TIMEOUT_MIN_MS, base.timeoutMs * FLOW_TIMEOUT_MAX_FACTOR);
+  return l;
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <stdint.h>
+#include "feed_monitor.h"
+
+// Feed limits learned from this feeder's own feeds.
+//
+// The fixed FeedLimits in feeder_config.h have to suit every hopper, kibble
+// and portion, so they are loose: a jam holds the gate open for the whole
+// stuck window, and a large portion can run into the timeout while food is
+// still flowing. Each finished feed adds its flow rate (g/s) and its longest
+// gap between counted increases to exponentially weighted means and
+// variances; idle readings add to the scale's noise estimate. Once enough
+// feeds have been seen, each feed gets limits derived from them:
+//
+//   minIncrease = FLOW_NOISE_SIGMAS x reading noise
+//   stuckWindow = gap mean + FLOW_GAP_SIGMAS x gap sd + margin
+//                 (at least the time the slow flow needs for minIncrease)
+//   timeout     = portion / p10 flow rate x FLOW_TIMEOUT_FACTOR + margin
+//
+// The configured limits bound the result: minIncrease and stuckWindow only
+// get tighter, the timeout at most FLOW_TIMEOUT_MAX_FACTOR times longer.
+
+const uint16_t FLOW_MIN_FEEDS   = 3;   // fixed limits until then
+const uint16_t FLOW_WINDOW      = 16;  // feeds the averages roughly span
+const uint16_t FLOW_NOISE_WINDOW = 64; // idle readings the noise roughly spans
+
+const float    FLOW_P10_SIGMAS         = 1.2816f;  // normal 10th percentile
+const float    FLOW_P10_MIN_FRACTION   = 0.25f;    // p10 rate never below this x mean
+const float    FLOW_TIMEOUT_FACTOR     = 1.25f;
+const uint32_t FLOW_TIMEOUT_MARGIN_MS  = 3000;     // gate travel, settling
+const uint32_t FLOW_TIMEOUT_MIN_MS     = 5000;
+const uint32_t FLOW_TIMEOUT_MAX_FACTOR = 4;        // x configured timeout
+const float    FLOW_GAP_SIGMAS         = 3.0f;
+const uint32_t FLOW_STUCK_MARGIN_MS    = 300;
+const uint32_t FLOW_STUCK_MIN_MS       = 800;
+const float    FLOW_NOISE_SIGMAS       = 4.0f;
+const float    FLOW_MIN_INCREASE_FLOOR_G = 0.5f;
+
+struct FlowStats {
+  uint16_t feeds;          // feeds learned from (saturates)
+  uint16_t noiseSamples;   // idle reading pairs (saturates)
+  float    rateMean;       // g/s while the gate was open
+  float    rateVar;
+  float    gapMeanMs;      // longest gap between increases, per feed
+  float    gapVar;
+  float    noiseVar;       // variance of one reading (g^2)
+};
+
+void initFlowStats(FlowStats& s);
+
+// Learns from a finished feed that dispensed `dispensedG` in `openMs` of
+// full-open gate time (Dispenser.openMs). Only feeds that reached their
+// target or timed out while food was still flowing count; returns whether
+// this one did.
+bool learnFlow(FlowStats& s, const FeedProgress& p, FeedCheck outcome, float dispensedG,
+               uint32_t openMs);
+
+// Two consecutive readings with nothing feeding. Steps larger than `maxStepG`
+// (the pet eating, the bowl moved) are not noise and are ignored.
+void learnIdleNoise(FlowStats& s, float prevWeight, float weight, float maxStepG);
+
+// 10th-percentile flow rate (g/s), 0 before FLOW_MIN_FEEDS.
+float flowP10Rate(const FlowStats& s);
+
+// Limits for a feed of `amount` grams; `base` until enough feeds are known.
+FeedLimits deriveFeedLimits(const FlowStats& s, const FeedLimits& base, float amount);
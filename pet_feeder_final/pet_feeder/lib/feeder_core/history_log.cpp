@@ -0,0 +1,144 @@
+#include "history_log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bin_writer.h"
+#include "buf_writer.h"
+#include "feed_monitor.h"
+
+void historySegmentPath(char* out, size_t cap, uint32_t segment) {
+  snprintf(out, cap, "/hist/%08lx.bin", (unsigned long)segment);
+}
+
+bool parseHistorySegmentName(const char* name, uint32_t& segment) {
+  const char* base = strrchr(name, '/');
+  base = base ? base + 1 : name;
+  if (strlen(base) != 12 || strcmp(base + 8, ".bin") != 0) return false;
+
+  uint32_t v = 0;
+  for (int i = 0; i < 8; i++) {
+    char c = base[i];
+    int d = (c >= '0' && c <= '9') ? c - '0'
+          : (c >= 'a' && c <= 'f') ? c - 'a' + 10 : -1;
+    if (d < 0) return false;
+    v = (v << 4) | d;
+  }
+  segment = v;
+  return true;
+}
+
+uint32_t historyLowerBound(uint32_t lo, uint32_t hi, uint32_t time,
+                           HistoryReadFn read, void* ctx) {
+  while (lo < hi) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    HistoryRecord r;
+    if (!read(mid, r, ctx)) return hi;  // unreadable: nothing to serve
+    if (r.time < time) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+// ---- Export formats ----
+
+bool parseExportFormat(const char* name, ExportFormat& out) {
+  if (strcmp(name, "ndjson") == 0) { out = EXPORT_NDJSON; return true; }
+  if (strcmp(name, "csv") == 0)    { out = EXPORT_CSV;    return true; }
+  if (strcmp(name, "cbor") == 0)   { out = EXPORT_CBOR;   return true; }
+  if (strcmp(name, "msgpack") == 0) { out = EXPORT_MSGPACK; return true; }
+  return false;
+}
+
+const char* exportContentType(ExportFormat f) {
+  switch (f) {
+    case EXPORT_CSV:     return "text/csv";
+    case EXPORT_CBOR:    return "application/cbor-seq";
+    case EXPORT_MSGPACK: return "application/msgpack";
+    default:             return "application/x-ndjson";
+  }
+}
+
+const char HISTORY_CSV_HEADER[] = "seq,time,kind,manual,slot,outcome,weight,target\n";
+
+// Tenths of a gram as "-12.3"
+static void printDg(BufWriter& w, int32_t dg) {
+  uint32_t mag = dg < 0 ? -(uint32_t)dg : (uint32_t)dg;
+  w.printf("%s%lu.%lu", dg < 0 ? "-" : "", (unsigned long)(mag / 10), (unsigned long)(mag % 10));
+}
+
+static const char* kindName(uint8_t kind) {
+  return kind == HIST_FEED ? "feed" : kind == HIST_WEIGHT ? "weight" : "?";
+}
+
+static const char* outcomeName(uint8_t outcome) {
+  switch (outcome) {
+    case FEED_TARGET_REACHED: return "target";
+    case FEED_STUCK:          return "stuck";
+    case FEED_TIMEOUT:        return "timeout";
+    case HIST_SKIPPED_EMPTY:  return "hopper_empty";
+    case HIST_ABORTED:        return "aborted";
+    default:                  return "other";
+  }
+}
+
+static size_t encodeHistoryRecord(uint8_t* out, size_t cap, const HistoryRecord& r,
+                                  WireFormat format) {
+  BinWriter w(out, cap, format);
+  bool feed = r.kind == HIST_FEED;
+  w.array(8);
+  w.uint(r.seq);
+  w.uint(r.time);
+  w.uint(r.kind);
+  if (feed) {
+    w.uint(r.manual);
+    w.uint(r.slot + 1);
+    w.uint(r.outcome);
+  } else {
+    w.null();
+    w.null();
+    w.null();
+  }
+  w.sint(r.weightDg);
+  if (feed) {
+    w.sint(r.targetDg);
+  } else {
+    w.null();
+  }
+  return w.ok() ? w.length() : 0;
+}
+
+size_t formatHistoryLine(char* out, size_t cap, const HistoryRecord& r, ExportFormat f) {
+  if (f == EXPORT_CBOR || f == EXPORT_MSGPACK) {
+    return encodeHistoryRecord((uint8_t*)out, cap, r, f == EXPORT_CBOR ? WIRE_CBOR : WIRE_MSGPACK);
+  }
+
+  BufWriter w(out, cap);
+  bool feed = r.kind == HIST_FEED;
+
+  if (f == EXPORT_CSV) {
+    w.printf("%lu,%lu,%s,", (unsigned long)r.seq, (unsigned long)r.time, kindName(r.kind));
+    if (feed) {
+      w.printf("%d,%d,%s,", r.manual, r.slot + 1, outcomeName(r.outcome));
+    } else {
+      w.print(",,,");
+    }
+    printDg(w, r.weightDg);
+    w.print(",");
+    if (feed) printDg(w, r.targetDg);
+    w.print("\n");
+  } else {
+    w.printf("{\"seq\":%lu,\"time\":%lu,\"kind\":\"%s\",\"weight\":",
+             (unsigned long)r.seq, (unsigned long)r.time, kindName(r.kind));
+    printDg(w, r.weightDg);
+    if (feed) {
+      w.printf(",\"manual\":%s,\"slot\":%d,\"outcome\":\"%s\",\"target\":",
+               r.manual ? "true" : "false", r.slot + 1, outcomeName(r.outcome));
+      printDg(w, r.targetDg);
+    }
+    w.print("}\n");
+  }
+  return w.ok() ? w.length() : 0;
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// Long-term feed and weight history, as stored on flash and exported by
+// /api/export.
+//
+// Records are fixed-size and numbered by a sequence that never restarts, so
+// record `seq` lives in segment seq / HISTORY_SEGMENT_RECORDS at a known
+// offset: no index is needed to resume an export from a cursor, and deleting
+// the oldest segment keeps every other position valid. Records are appended
+// in time order, which lets a `from` bound be found by binary search.
+
+enum HistoryKind : uint8_t {
+  HIST_FEED   = 1,  // a finished feed
+  HIST_WEIGHT = 2   // periodic bowl weight sample
+};
+
+struct HistoryRecord {
+  uint32_t seq;
+  uint32_t time;      // Unix seconds
+  uint8_t  kind;      // HistoryKind
+  uint8_t  manual;    // HIST_FEED: 1 = manual / API
+  int8_t   slot;      // HIST_FEED: slot index, -1 for manual
+  uint8_t  outcome;   // HIST_FEED: FeedCheck that ended it, or HIST_SKIPPED_EMPTY / HIST_ABORTED
+  int32_t  weightDg;  // bowl weight (feed: final weight), 0.1 g
+  int32_t  targetDg;  // HIST_FEED: target, 0.1 g
+};
+
+// Outcome of a scheduled feed skipped because the hopper was predicted empty
+const uint8_t HIST_SKIPPED_EMPTY = 0x80;
+// Outcome of a feed cut short by a reset and not resumed (feed_journal.h)
+const uint8_t HIST_ABORTED       = 0x81;
+
+static_assert(sizeof(HistoryRecord) == 20, "history files assume 20-byte records");
+
+const uint32_t HISTORY_SEGMENT_RECORDS = 4096;  // 80 KB per segment file
+const uint32_t HISTORY_MAX_SEGMENTS    = 8;     // 640 KB of the 1.2 MB SPIFFS partition
+
+inline uint32_t historySegmentOf(uint32_t seq) { return seq / HISTORY_SEGMENT_RECORDS; }
+inline uint32_t historyOffsetOf(uint32_t seq) {
+  return (seq % HISTORY_SEGMENT_RECORDS) * sizeof(HistoryRecord);
+}
+
+// "/hist/00000003.bin"
+const size_t HISTORY_PATH_MAX = 24;
+void historySegmentPath(char* out, size_t cap, uint32_t segment);
+// Scratch file while a torn segment is cut back (history_store.h); not a
+// segment name, so a scan skips it
+#define HISTORY_REPAIR_PATH "/hist/repair.tmp"
+// Segment number from a file name as listed by the FS ("00000003.bin" or a
+// full path); false for anything else.
+bool parseHistorySegmentName(const char* name, uint32_t& segment);
+
+// Random access to records [oldest, end) for the search below.
+typedef bool (*HistoryReadFn)(uint32_t seq, HistoryRecord& out, void* ctx);
+
+// First seq in [lo, hi) whose time is >= `time` (hi if none).
+uint32_t historyLowerBound(uint32_t lo, uint32_t hi, uint32_t time,
+                           HistoryReadFn read, void* ctx);
+
+// ---- Export formats ----
+enum ExportFormat : uint8_t {
+  EXPORT_NDJSON,
+  EXPORT_CSV,
+  EXPORT_CBOR,     // CBOR sequence (RFC 8742), one array per record
+  EXPORT_MSGPACK   // MessagePack stream, one array per record
+};
+
+// "ndjson", "csv", "cbor" or "msgpack"
+bool parseExportFormat(const char* name, ExportFormat& out);
+const char* exportContentType(ExportFormat f);
+
+// Column line, only on the first page of a CSV export.
+extern const char HISTORY_CSV_HEADER[];
+
+// One line (with '\n') per record; returns its length, 0 if it did not fit.
+// Slots are 1-based as on the LCD, 0 for manual feeds.
+//
+// The binary formats write one array per record instead, in CSV column
+// order with integer fields: [seq, time, kind, manual, slot, outcome,
+// weight 0.1 g, target 0.1 g]. Fields CSV leaves empty are null.
+const size_t HISTORY_LINE_MAX = 160;
+size_t formatHistoryLine(char* out, size_t cap, const HistoryRecord& r, ExportFormat f);
+
+// Records served per /api/export request. Each page ends quickly and says
+// where the next one starts, so an export of any size never holds up loop()
+// for longer than one page.
+const uint32_t EXPORT_PAGE_RECORDS = 128;
@@ -0,0 +1,73 @@
+#include "hopper.h"
+
+void initHopper(HopperState& h, float capacityG) {
+  h.known = false;
+  h.capacityG = capacityG;
+  h.remainingG = 0;
+  h.dispensedG = 0;
+  h.refilledAt = 0;
+}
+
+void hopperRefill(HopperState& h, float grams, uint32_t now) {
+  if (grams <= 0 || grams > h.capacityG) grams = h.capacityG;
+  h.known = true;
+  h.remainingG = grams;
+  h.dispensedG = 0;
+  h.refilledAt = now;
+}
+
+void hopperDispensed(HopperState& h, float grams) {
+  if (grams <= 0) return;
+  h.dispensedG += grams;
+  h.remainingG -= grams;
+  if (h.remainingG < 0) h.remainingG = 0;
+}
+
+void hopperMarkEmpty(HopperState& h) {
+  if (h.known) h.remainingG = 0;
+}
+
+bool hopperPredictEmpty(const HopperState& h) {
+  return h.known && h.remainingG < HOPPER_EMPTY_G;
+}
+
+HopperForecast forecastHopper(const HopperState& h, const CompiledRule* rules, int count,
+                              uint32_t now, uint32_t horizonSecs, uint32_t warnSecs) {
+  HopperForecast f = {NO_FEEDING_TIME, 0, false};
+  if (!h.known) return f;
+  if (hopperPredictEmpty(h)) {
+    f.emptyAt = now;
+    f.low = true;
+    return f;
+  }
+
+  // Next occurrence of every slot; slots firing the same minute all count
+  uint32_t next[HOPPER_MAX_SLOTS];
+  if (count > HOPPER_MAX_SLOTS) count = HOPPER_MAX_SLOTS;
+  for (int i = 0; i < count; i++) {
+    next[i] = ruleNextFire(rules[i], now);
+  }
+
+  uint32_t horizon = now + horizonSecs;
+  float left = h.remainingG;
+  for (int n = 0; n < HOPPER_FORECAST_MAX_FEEDS; n++) {
+    int slot = -1;
+    for (int i = 0; i < count; i++) {
+      if (next[i] != NO_FEEDING_TIME && (slot < 0 || next[i] < next[slot])) slot = i;
+    }
+    if (slot < 0 || next[slot] > horizon) break;
+
+    uint32_t t = next[slot];
+    float portion = rules[slot].portion;
+    if (portion > left) {
+      f.emptyAt = t;
+      break;
+    }
+    left -= portion;
+    f.feedsLeft++;
+    next[slot] = ruleNextFire(rules[slot], t + 60);
+  }
+
+  f.low = f.emptyAt != NO_FEEDING_TIME && f.emptyAt - now <= warnSecs;
+  return f;
+}
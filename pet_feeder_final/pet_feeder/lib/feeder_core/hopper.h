@@ -0,0 +1,51 @@
+#pragma once
+#include <stdint.h>
+#include "schedule.h"
+
+// ---- Hopper inventory ----
+// Food left in the hopper, estimated by subtracting what each feed put in
+// the bowl from the amount declared at the last refill. The estimate only
+// exists after a refill has been reported; until then nothing is predicted
+// and no feed is skipped.
+struct HopperState {
+  bool     known;        // false until the first refill
+  float    capacityG;
+  float    remainingG;
+  float    dispensedG;   // since the last refill
+  uint32_t refilledAt;   // Unix time of the last refill
+};
+
+// Below this the gate would open onto nothing: the feed is skipped.
+const float HOPPER_EMPTY_G = 1.0f;
+
+void initHopper(HopperState& h, float capacityG);
+
+// `grams` <= 0 means filled to capacity; more than capacity is clamped.
+void hopperRefill(HopperState& h, float grams, uint32_t now);
+
+// Bowl weight gained by a finished feed. Negative gains (the pet ate
+// during the feed) count as nothing.
+void hopperDispensed(HopperState& h, float grams);
+
+// The gate was open and nothing arrived: whatever the estimate said, the
+// hopper is empty (or jammed) until the next refill.
+void hopperMarkEmpty(HopperState& h);
+
+// True when a feed started now would find the hopper empty.
+bool hopperPredictEmpty(const HopperState& h);
+
+// ---- Refill prediction ----
+// Walks the compiled schedule forward from `now`, subtracting each
+// occurrence's portion until one can no longer be served in full.
+const int HOPPER_FORECAST_MAX_FEEDS = 512;  // bounds the walk for dense schedules
+const int HOPPER_MAX_SLOTS = 16;
+
+struct HopperForecast {
+  uint32_t emptyAt;    // fire time of the first feed that cannot be served
+                       // in full, or NO_FEEDING_TIME (unknown / beyond horizon)
+  uint16_t feedsLeft;  // occurrences served in full before that
+  bool     low;        // emptyAt within the warning window, or already empty
+};
+
+HopperForecast forecastHopper(const HopperState& h, const CompiledRule* rules, int count,
+                              uint32_t now, uint32_t horizonSecs, uint32_t warnSecs);
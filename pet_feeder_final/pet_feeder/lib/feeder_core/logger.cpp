@@ -0,0 +1,324 @@
+#include "logger.h"
+#include <stdio.h>
+#include <string.h>
+
+static LogRecord*  ring = nullptr;
+static uint32_t    ringMask = 0;
+static LogClockFn  clockFn = nullptr;
+static std::atomic<uint32_t> head(0);  // next slot to claim
+static uint32_t    tail = 0;           // next slot to pop (drain task only)
+static std::atomic<uint32_t> written(0);
+static std::atomic<uint32_t> dropped(0);
+static std::atomic<uint32_t> truncated(0);
+
+void logInit(LogRecord* storage, uint32_t capacity, LogClockFn clock) {
+  for (uint32_t i = 0; i < capacity; i++) storage[i].turn.store(i, std::memory_order_relaxed);
+  ringMask = capacity - 1;
+  clockFn = clock;
+  head.store(0);
+  tail = 0;
+  written.store(0);
+  dropped.store(0);
+  truncated.store(0);
+  std::atomic_thread_fence(std::memory_order_release);
+  ring = storage;
+}
+
+// A slot whose turn equals the claim position is free; the writer that wins
+// the CAS on head fills it and sets turn to pos + 1, which is what the
+// reader waits for. The reader hands it back with turn = pos + capacity.
+void logSubmit(uint8_t level, const char* fmt, const LogArgs& args) {
+  if (!ring) return;
+  uint32_t pos = head.load(std::memory_order_relaxed);
+  LogRecord* r;
+  for (;;) {
+    r = &ring[pos & ringMask];
+    int32_t diff = (int32_t)(r->turn.load(std::memory_order_acquire) - pos);
+    if (diff == 0) {
+      if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+    } else if (diff < 0) {
+      dropped.fetch_add(1, std::memory_order_relaxed);
+      return;
+    } else {
+      pos = head.load(std::memory_order_relaxed);
+    }
+  }
+  r->ms = clockFn ? clockFn() : 0;
+  r->fmt = fmt;
+  r->level = level;
+  memcpy(r->args.data, args.data, args.len);
+  r->args.len = args.len;
+  r->args.count = args.count;
+  r->args.truncated = args.truncated;
+  r->turn.store(pos + 1, std::memory_order_release);
+
+  written.fetch_add(1, std::memory_order_relaxed);
+  if (args.truncated) truncated.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool logPop(LogRecord& out) {
+  if (!ring) return false;
+  LogRecord& r = ring[tail & ringMask];
+  if (r.turn.load(std::memory_order_acquire) != tail + 1) return false;
+  out.ms = r.ms;
+  out.fmt = r.fmt;
+  out.level = r.level;
+  memcpy(out.args.data, r.args.data, r.args.len);
+  out.args.len = r.args.len;
+  out.args.count = r.args.count;
+  out.args.truncated = r.args.truncated;
+  r.turn.store(tail + ringMask + 1, std::memory_order_release);
+  tail++;
+  return true;
+}
+
+LogStats logStats() {
+  LogStats s;
+  s.written = written.load(std::memory_order_relaxed);
+  s.dropped = dropped.load(std::memory_order_relaxed);
+  s.truncated = truncated.load(std::memory_order_relaxed);
+  return s;
+}
+
+const char* logLevelName(uint8_t level) {
+  switch (level) {
+    case LOG_LEVEL_ERROR: return "E";
+    case LOG_LEVEL_WARN:  return "W";
+    case LOG_LEVEL_INFO:  return "I";
+    case LOG_LEVEL_DEBUG: return "D";
+    default:              return "?";
+  }
+}
+
+// ---- Packing ----
+
+static bool reserve(LogArgs& a, size_t n) {
+  if (a.len + n > LOG_ARG_BYTES) {
+    a.truncated = true;
+    return false;
+  }
+  return true;
+}
+
+static void putValue(LogArgs& a, uint8_t tag, const void* v, size_t n) {
+  if (!reserve(a, 1 + n)) return;
+  a.data[a.len] = tag;
+  memcpy(a.data + a.len + 1, v, n);
+  a.len += 1 + n;
+  a.count++;
+}
+
+void logPut(LogArgs& a, int32_t v) { putValue(a, LOG_ARG_INT, &v, sizeof(v)); }
+void logPut(LogArgs& a, uint32_t v) { putValue(a, LOG_ARG_UINT, &v, sizeof(v)); }
+void logPut(LogArgs& a, int64_t v) { putValue(a, LOG_ARG_INT64, &v, sizeof(v)); }
+void logPut(LogArgs& a, uint64_t v) { putValue(a, LOG_ARG_UINT64, &v, sizeof(v)); }
+
+void logPut(LogArgs& a, double v) {
+  float f = (float)v;
+  putValue(a, LOG_ARG_FLOAT, &f, sizeof(f));
+}
+
+void logPut(LogArgs& a, const char* s) {
+  if (!s) s = "(null)";
+  if (!reserve(a, 2)) return;
+  size_t n = strlen(s);
+  size_t room = LOG_ARG_BYTES - a.len - 2;
+  if (n > room) {
+    n = room;
+    a.truncated = true;
+  }
+  a.data[a.len] = LOG_ARG_STR;
+  a.data[a.len + 1] = (uint8_t)n;
+  memcpy(a.data + a.len + 2, s, n);
+  a.len += 2 + n;
+  a.count++;
+}
+
+// ---- Formatting ----
+
+struct ArgReader {
+  const LogArgs& a;
+  size_t pos;
+  uint8_t left;
+};
+
+struct ArgValue {
+  uint8_t  tag;
+  int64_t  i;     // integers, and floats cut to integers
+  double   f;     // floats, and integers widened
+  char     s[LOG_ARG_BYTES];
+};
+
+static bool nextArg(ArgReader& rd, ArgValue& v) {
+  if (rd.left == 0) return false;
+  rd.left--;
+  const uint8_t* p = rd.a.data + rd.pos;
+  v.tag = p[0];
+  v.s[0] = '\0';
+  switch (v.tag) {
+    case LOG_ARG_INT:    { int32_t x;  memcpy(&x, p + 1, 4); v.i = x; rd.pos += 5; break; }
+    case LOG_ARG_UINT:   { uint32_t x; memcpy(&x, p + 1, 4); v.i = x; rd.pos += 5; break; }
+    case LOG_ARG_INT64:  { int64_t x;  memcpy(&x, p + 1, 8); v.i = x; rd.pos += 9; break; }
+    case LOG_ARG_UINT64: { uint64_t x; memcpy(&x, p + 1, 8); v.i = (int64_t)x; rd.pos += 9; break; }
+    case LOG_ARG_FLOAT: {
+      float x;
+      memcpy(&x, p + 1, 4);
+      v.f = x;
+      v.i = (int64_t)x;
+      rd.pos += 5;
+      return true;
+    }
+    case LOG_ARG_STR: {
+      size_t n = p[1];
+      memcpy(v.s, p + 2, n);
+      v.s[n] = '\0';
+      v.i = 0;
+      v.f = 0;
+      rd.pos += 2 + n;
+      return true;
+    }
+    default:
+      rd.left = 0;
+      return false;
+  }
+  v.f = (double)v.i;
+  return true;
+}
+
+struct LineOut {
+  char*  out;
+  size_t cap;
+  size_t len;
+};
+
+static void append(LineOut& o, const char* s, size_t n) {
+  if (o.cap == 0) return;
+  size_t room = o.cap - 1 - o.len;
+  if (n > room) n = room;
+  memcpy(o.out + o.len, s, n);
+  o.len += n;
+  o.out[o.len] = '\0';
+}
+
+static void appendf(LineOut& o, const char* spec, const ArgValue& v, char conv) {
+  char tmp[LOG_LINE_MAX];
+  int n;
+  switch (conv) {
+    case 'd': case 'i':
+      n = snprintf(tmp, sizeof(tmp), spec, (long long)v.i);
+      break;
+    case 'u': case 'x': case 'X': case 'o':
+      n = snprintf(tmp, sizeof(tmp), spec, (unsigned long long)v.i);
+      break;
+    case 'c':
+      n = snprintf(tmp, sizeof(tmp), spec, (int)v.i);
+      break;
+    case 's':
+      n = snprintf(tmp, sizeof(tmp), spec, v.tag == LOG_ARG_STR ? v.s : "?");
+      break;
+    default:  // f F e E g G a A
+      n = snprintf(tmp, sizeof(tmp), spec, v.f);
+      break;
+  }
+  if (n > 0) append(o, tmp, (size_t)n < sizeof(tmp) ? (size_t)n : sizeof(tmp) - 1);
+}
+
+// Walks the format; each conversion is rebuilt with its flags, width and
+// precision but with the length modifier the stored value needs.
+static void formatInto(LineOut& o, const LogRecord& r) {
+  ArgReader rd = {r.args, 0, r.args.count};
+  const char* f = r.fmt ? r.fmt : "";
+  while (*f) {
+    const char* pct = strchr(f, '%');
+    if (!pct) {
+      append(o, f, strlen(f));
+      return;
+    }
+    append(o, f, pct - f);
+    f = pct + 1;
+    if (*f == '%') {
+      append(o, "%", 1);
+      f++;
+      continue;
+    }
+
+    char spec[16] = "%";
+    size_t sl = 1;
+    while (*f && strchr("-+ #0123456789.", *f)) {
+      if (sl < sizeof(spec) - 4) spec[sl++] = *f;
+      f++;
+    }
+    while (*f && strchr("hlLqjzt", *f)) f++;
+    char conv = *f;
+    if (!conv) return;
+    f++;
+
+    bool integer = strchr("diuxXoc", conv) != nullptr;
+    if (!integer && !strchr("sfFeEgGaA", conv)) {
+      append(o, "?", 1);  // %n, %p and the like are not supported
+      continue;
+    }
+    if (conv != 'c' && conv != 's' && integer) {
+      spec[sl++] = 'l';
+      spec[sl++] = 'l';
+    }
+    spec[sl++] = conv;
+    spec[sl] = '\0';
+
+    ArgValue v;
+    if (!nextArg(rd, v)) {
+      append(o, "?", 1);  // cut off by truncation
+      continue;
+    }
+    appendf(o, spec, v, conv);
+  }
+}
+
+size_t logFormat(const LogRecord& r, char* out, size_t cap) {
+  LineOut o = {out, cap, 0};
+  if (cap) out[0] = '\0';
+  formatInto(o, r);
+  return o.len;
+}
+
+size_t logFormatLine(const LogRecord& r, char* out, size_t cap) {
+  LineOut o = {out, cap, 0};
+  if (cap) out[0] = '\0';
+  char prefix[24];
+  int n = snprintf(prefix, sizeof(prefix), "[%5lu.%03lu] %s ", (unsigned long)(r.ms / 1000),
+                   (unsigned long)(r.ms % 1000), logLevelName(r.level));
+  if (n > 0) append(o, prefix, (size_t)n);
+  formatInto(o, r);
+  return o.len;
+}
+
+// ---- Tail ----
+
+void initLogTail(LogTail& t, char (*storage)[LOG_LINE_MAX], uint32_t capacity) {
+  t.lines = storage;
+  t.capacity = capacity;
+  t.next = 1;
+}
+
+void logTailAppend(LogTail& t, const char* line) {
+  if (t.capacity == 0) return;
+  char* slot = t.lines[t.next % t.capacity];
+  strncpy(slot, line, LOG_LINE_MAX - 1);
+  slot[LOG_LINE_MAX - 1] = '\0';
+  t.next++;
+}
+
+size_t logTailRead(const LogTail& t, uint32_t since, char* out, size_t cap, uint32_t& next) {
+  uint32_t seq = since < logTailOldest(t) ? logTailOldest(t) : since;
+  size_t len = 0;
+  for (; seq < t.next; seq++) {
+    const char* line = t.lines[seq % t.capacity];
+    size_t n = strlen(line);
+    if (len + n + 1 > cap) break;
+    memcpy(out + len, line, n);
+    out[len + n] = '\n';
+    len += n + 1;
+  }
+  next = seq;
+  return len;
+}
@@ -0,0 +1,183 @@
+#pragma once
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+// Leveled logging with deferred formatting.
+//
+// LOGE/LOGW/LOGI/LOGD(fmt, ...) take printf formats but do no formatting:
+// the caller copies the format pointer and its arguments into a fixed-size
+// record in a RAM ring and returns. A low-priority task pops the records,
+// formats them (logFormatLine) and hands the lines to the sinks, so a log
+// call on the feed path costs a few dozen stores instead of a wait on the
+// UART.
+//
+// The ring is a bounded multi-producer queue: a writer claims a slot with a
+// compare-and-swap and publishes it with a per-slot sequence number, so any
+// task may log and none ever blocks. When the ring is full the record is
+// dropped and counted (LogStats.dropped). Formats must be string literals
+// (only the pointer is kept); string arguments are copied, and every
+// argument is cut to what fits in LOG_ARG_BYTES (LogStats.truncated).
+// Floating-point arguments are kept as float.
+//
+// Levels above FEEDER_LOG_LEVEL (a LogLevel value as a number, e.g.
+// -DFEEDER_LOG_LEVEL=4 for debug) are compiled away, arguments included.
+// The format is still checked against its arguments.
+
+enum LogLevel : uint8_t {
+  LOG_LEVEL_NONE,
+  LOG_LEVEL_ERROR,
+  LOG_LEVEL_WARN,
+  LOG_LEVEL_INFO,
+  LOG_LEVEL_DEBUG
+};
+
+#ifndef FEEDER_LOG_LEVEL
+#define FEEDER_LOG_LEVEL 3  // LOG_LEVEL_INFO
+#endif
+
+const size_t   LOG_ARG_BYTES = 48;
+const size_t   LOG_LINE_MAX  = 128;   // formatted line, with the prefix
+const uint32_t LOG_DRAIN_MS  = 20;    // drain task period
+
+enum LogArgTag : uint8_t {
+  LOG_ARG_INT,     // int32
+  LOG_ARG_UINT,    // uint32
+  LOG_ARG_INT64,
+  LOG_ARG_UINT64,
+  LOG_ARG_FLOAT,
+  LOG_ARG_STR      // u8 length, then the bytes
+};
+
+// Arguments of one call, packed as tag + value
+struct LogArgs {
+  uint8_t data[LOG_ARG_BYTES];
+  uint8_t len;
+  uint8_t count;
+  bool    truncated;
+};
+
+struct LogRecord {
+  std::atomic<uint32_t> turn;  // ring bookkeeping
+  uint32_t              ms;
+  const char*           fmt;
+  uint8_t               level;
+  LogArgs               args;
+};
+
+struct LogStats {
+  uint32_t written;
+  uint32_t dropped;    // ring full
+  uint32_t truncated;  // arguments cut short
+};
+
+typedef uint32_t (*LogClockFn)();
+
+// `storage` must hold a power-of-two number of records.
+void logInit(LogRecord* storage, uint32_t capacity, LogClockFn clock);
+void logSubmit(uint8_t level, const char* fmt, const LogArgs& args);
+
+// Takes the oldest record (drain task only). False when the ring is empty.
+bool logPop(LogRecord& out);
+
+LogStats logStats();
+const char* logLevelName(uint8_t level);  // "E", "W", "I", "D"
+
+// The message alone, and "[   12.345] W message" (seconds since boot).
+// Both return the length, cut to fit `cap`.
+size_t logFormat(const LogRecord& r, char* out, size_t cap);
+size_t logFormatLine(const LogRecord& r, char* out, size_t cap);
+
+void logPut(LogArgs& a, int32_t v);
+void logPut(LogArgs& a, uint32_t v);
+void logPut(LogArgs& a, int64_t v);
+void logPut(LogArgs& a, uint64_t v);
+void logPut(LogArgs& a, double v);
+void logPut(LogArgs& a, const char* s);
+
+// The integer types printf callers pass, onto the fixed-width ones above
+inline void logPut(LogArgs& a, bool v) { logPut(a, (int32_t)v); }
+inline void logPut(LogArgs& a, char v) { logPut(a, (int32_t)v); }
+inline void logPut(LogArgs& a, signed char v) { logPut(a, (int32_t)v); }
+inline void logPut(LogArgs& a, unsigned char v) { logPut(a, (uint32_t)v); }
+inline void logPut(LogArgs& a, short v) { logPut(a, (int32_t)v); }
+inline void logPut(LogArgs& a, unsigned short v) { logPut(a, (uint32_t)v); }
+inline void logPut(LogArgs& a, float v) { logPut(a, (double)v); }
+inline void logPut(LogArgs& a, char* s) { logPut(a, (const char*)s); }
+template <typename T>
+inline void logPut(LogArgs& a, T v) {
+  static_assert(sizeof(T) <= 8, "unsupported log argument");
+  if (sizeof(T) <= 4) {
+    if (T(-1) < T(0)) logPut(a, (int32_t)v); else logPut(a, (uint32_t)v);
+  } else {
+    if (T(-1) < T(0)) logPut(a, (int64_t)v); else logPut(a, (uint64_t)v);
+  }
+}
+
+template <typename... A>
+inline void logWrite(uint8_t level, const char* fmt, const A&... args) {
+  LogArgs a;
+  a.len = 0;
+  a.count = 0;
+  a.truncated = false;
+  (logPut(a, args), ...);
+  logSubmit(level, fmt, a);
+}
+
+// Never called; lets the compiler check formats against their arguments
+inline void logCheckFormat(const char*, ...) __attribute__((format(printf, 1, 2)));
+inline void logCheckFormat(const char*, ...) {}
+
+#define LOG_AT_(level, fmt, ...)                   \
+  do {                                             \
+    if (false) logCheckFormat(fmt, ##__VA_ARGS__); \
+    logWrite((level), fmt, ##__VA_ARGS__);         \
+  } while (0)
+#define LOG_OFF_(fmt, ...)                         \
+  do {                                             \
+    if (false) logCheckFormat(fmt, ##__VA_ARGS__); \
+  } while (0)
+
+#if FEEDER_LOG_LEVEL >= 1
+#define LOGE(fmt, ...) LOG_AT_(LOG_LEVEL_ERROR, fmt, ##__VA_ARGS__)
+#else
+#define LOGE(fmt, ...) LOG_OFF_(fmt, ##__VA_ARGS__)
+#endif
+#if FEEDER_LOG_LEVEL >= 2
+#define LOGW(fmt, ...) LOG_AT_(LOG_LEVEL_WARN, fmt, ##__VA_ARGS__)
+#else
+#define LOGW(fmt, ...) LOG_OFF_(fmt, ##__VA_ARGS__)
+#endif
+#if FEEDER_LOG_LEVEL >= 3
+#define LOGI(fmt, ...) LOG_AT_(LOG_LEVEL_INFO, fmt, ##__VA_ARGS__)
+#else
+#define LOGI(fmt, ...) LOG_OFF_(fmt, ##__VA_ARGS__)
+#endif
+#if FEEDER_LOG_LEVEL >= 4
+#define LOGD(fmt, ...) LOG_AT_(LOG_LEVEL_DEBUG, fmt, ##__VA_ARGS__)
+#else
+#define LOGD(fmt, ...) LOG_OFF_(fmt, ##__VA_ARGS__)
+#endif
+
+// ---- Tail ----
+// The newest formatted lines, numbered, for GET /api/logs. Not thread-safe:
+// the firmware guards it with a mutex between the drain task and the
+// handler.
+struct LogTail {
+  char     (*lines)[LOG_LINE_MAX];  // caller-owned
+  uint32_t capacity;
+  uint32_t next;                    // seq of the next line; lines are 1-based
+};
+
+void initLogTail(LogTail& t, char (*storage)[LOG_LINE_MAX], uint32_t capacity);
+void logTailAppend(LogTail& t, const char* line);
+
+// Seq of the oldest line still kept
+inline uint32_t logTailOldest(const LogTail& t) {
+  return t.next > t.capacity ? t.next - t.capacity : 1;
+}
+
+// Copies the lines from seq `since` on (from the oldest kept if that is
+// gone), newline-terminated, as far as they fit. Returns the bytes written;
+// `next` is the seq to pass as `since` next time.
+size_t logTailRead(const LogTail& t, uint32_t since, char* out, size_t cap, uint32_t& next);
@@ -0,0 +1,41 @@
+#include "loop_stats.h"
+#include <string.h>
+
+void resetLoopStats(LoopStats& s) {
+  memset(&s, 0, sizeof(s));
+}
+
+void recordLoopStart(LoopStats& s, uint32_t nowUs) {
+  if (s.started) {
+    uint32_t period = nowUs - s.lastUs;
+    if (s.periods == 0 || period < s.minUs) s.minUs = period;
+    if (period > s.maxUs) s.maxUs = period;
+    s.sumUs += period;
+    s.periods++;
+
+    uint32_t b = period / LOOP_BUCKET_US;
+    s.buckets[b < (uint32_t)LOOP_BUCKETS ? b : LOOP_BUCKETS - 1]++;
+  }
+  s.lastUs = nowUs;
+  s.started = true;
+}
+
+uint32_t loopPercentileUs(const LoopStats& s, float q) {
+  if (s.periods == 0) return 0;
+
+  // rank of the sample we want, 1-based
+  uint32_t rank = (uint32_t)(q * s.periods + 0.5f);
+  if (rank < 1) rank = 1;
+  if (rank > s.periods) rank = s.periods;
+
+  uint32_t seen = 0;
+  for (int b = 0; b < LOOP_BUCKETS; b++) {
+    seen += s.buckets[b];
+    if (seen >= rank) {
+      if (b == LOOP_BUCKETS - 1) return s.maxUs;  // open-ended
+      uint32_t edge = (b + 1) * LOOP_BUCKET_US;
+      return edge < s.maxUs ? edge : s.maxUs;
+    }
+  }
+  return s.maxUs;
+}
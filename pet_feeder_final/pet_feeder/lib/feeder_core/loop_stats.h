@@ -0,0 +1,36 @@
+#pragma once
+#include <stdint.h>
+
+// Control-loop period statistics (served by /api/loop).
+//
+// loop() stamps its start every pass; the time between two stamps is one
+// period. Periods go into a fixed histogram of LOOP_BUCKET_US-wide buckets,
+// so percentiles cost no memory per sample. tools/loadgen.py reads these
+// before and under HTTP load to show how much request handling stretches the
+// loop.
+
+const int      LOOP_BUCKETS   = 128;
+const uint32_t LOOP_BUCKET_US = 2000;  // 2 ms buckets, last one is open-ended
+
+struct LoopStats {
+  uint32_t lastUs;
+  bool     started;
+  uint32_t periods;
+  uint32_t minUs;
+  uint32_t maxUs;
+  uint64_t sumUs;
+  uint32_t buckets[LOOP_BUCKETS];
+};
+
+void resetLoopStats(LoopStats& s);
+
+// Call once at the top of every pass; micros() wrap-around is fine.
+void recordLoopStart(LoopStats& s, uint32_t nowUs);
+
+// Upper edge of the bucket holding the q-quantile (0..1), capped at maxUs;
+// 0 with no periods yet.
+uint32_t loopPercentileUs(const LoopStats& s, float q);
+
+inline uint32_t loopMeanUs(const LoopStats& s) {
+  return s.periods ? (uint32_t)(s.sumUs / s.periods) : 0;
+}
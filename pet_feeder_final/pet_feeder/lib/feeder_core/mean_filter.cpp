@@ -0,0 +1,21 @@
+#include "mean_filter.h"
+
+void initMeanFilter(MeanFilter& f, int32_t* storage, int depth) {
+  f.ring = storage;
+  f.depth = depth > 0 ? depth : 1;
+  f.head = 0;
+  f.count = 0;
+  f.sum = 0;
+}
+
+int32_t meanFilterPush(MeanFilter& f, int32_t sample) {
+  if (f.count == f.depth) {
+    f.sum -= f.ring[f.head];
+  } else {
+    f.count++;
+  }
+  f.ring[f.head] = sample;
+  f.sum += sample;
+  if (++f.head == f.depth) f.head = 0;
+  return (int32_t)(f.sum / f.count);
+}
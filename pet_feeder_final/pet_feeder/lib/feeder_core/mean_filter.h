@@ -0,0 +1,20 @@
+#pragma once
+#include <stdint.h>
+
+// ---- Moving mean of load-cell conversions ----
+// The mean of the last `depth` conversions, or of all of them until that
+// many came in, over caller-owned storage. A running sum keeps a push at
+// the same cost whatever the depth.
+
+struct MeanFilter {
+  int32_t* ring;    // caller-owned, `depth` entries
+  int      depth;
+  int      head;    // where the next conversion goes
+  int      count;
+  int64_t  sum;     // of the `count` conversions held
+};
+
+void initMeanFilter(MeanFilter& f, int32_t* storage, int depth);
+
+// Adds a conversion; returns the mean including it (truncated toward zero)
+int32_t meanFilterPush(MeanFilter& f, int32_t sample);
@@ -0,0 +1,311 @@
+#include "ota_image.h"
+#include <string.h>
+
+enum DecodeState : uint8_t {
+  ST_START,     // the first byte tells a packed image from a plain one
+  ST_HEADER,
+  ST_PLAIN,
+  ST_TAG,
+  ST_LENGTH,    // varint part of a long length
+  ST_LITERAL,
+  ST_DISTANCE,  // OTA_OP_COPY
+  ST_OFFSET,    // OTA_OP_BASE
+  ST_DONE
+};
+
+const char* otaResultText(uint8_t result) {
+  switch (result) {
+    case OTA_OK:            return "ok";
+    case OTA_ERR_FORMAT:    return "not a valid image";
+    case OTA_ERR_WINDOW:    return "window too large";
+    case OTA_ERR_BASE:      return "delta base is not the running image";
+    case OTA_ERR_WRITE:     return "flash write failed";
+    case OTA_ERR_DOWNLOAD:  return "download failed";
+    case OTA_ERR_SIZE:      return "wrong image size";
+    case OTA_ERR_HASH:      return "hash mismatch";
+    case OTA_ERR_SIGNATURE: return "bad signature";
+    default:                return "?";
+  }
+}
+
+bool otaTokenMatches(const char* expected, const char* given) {
+  size_t n = strlen(expected);
+  size_t m = strlen(given);
+  uint8_t diff = n == 0 || n != m;
+  for (size_t i = 0; i < m; i++) diff |= (uint8_t)(given[i] ^ expected[n ? i % n : 0]);
+  return diff == 0;
+}
+
+const char* otaImageKindName(uint8_t kind) {
+  switch (kind) {
+    case OTA_IMAGE_FULL:   return "full";
+    case OTA_IMAGE_PACKED: return "packed";
+    case OTA_IMAGE_DELTA:  return "delta";
+    default:               return "none";
+  }
+}
+
+uint8_t otaImageKind(const OtaDecoder& d) {
+  if (d.in == 0) return OTA_IMAGE_NONE;
+  if (!d.packed) return OTA_IMAGE_FULL;
+  return (d.header.flags & OTA_FLAG_DELTA) ? OTA_IMAGE_DELTA : OTA_IMAGE_PACKED;
+}
+
+void initOtaDecoder(OtaDecoder& d, uint8_t* window, uint32_t windowSize, OtaWriteFn write,
+                    OtaReadBaseFn readBase, void* ctx) {
+  memset(&d, 0, sizeof(d));
+  d.window = window;
+  d.windowSize = windowSize;
+  d.write = write;
+  d.readBase = readBase;
+  d.ctx = ctx;
+  d.state = ST_START;
+  d.result = OTA_OK;
+  sha256Init(d.sha);
+}
+
+static bool fail(OtaDecoder& d, uint8_t result) {
+  if (d.result == OTA_OK) d.result = result;
+  return false;
+}
+
+// ---- Output ----
+
+// Hands over the window from the last flush on; called when the ring wraps
+// and at the end, so the range is always contiguous.
+static bool flush(OtaDecoder& d) {
+  uint32_t n = d.out - d.flushed;
+  if (n == 0) return true;
+  const uint8_t* p = d.window + (d.flushed & (d.windowSize - 1));
+  sha256Update(d.sha, p, n);
+  d.flushed = d.out;
+  return d.write(d.ctx, p, n) || fail(d, OTA_ERR_WRITE);
+}
+
+static bool emit(OtaDecoder& d, uint8_t b) {
+  if (d.packed && d.out >= d.header.imageSize) return fail(d, OTA_ERR_SIZE);
+  uint32_t mask = d.windowSize - 1;
+  d.window[d.out & mask] = b;
+  d.out++;
+  return (d.out & mask) != 0 || flush(d);
+}
+
+// ---- Header ----
+
+static uint32_t le32(const uint8_t* p) {
+  return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+// Hashes the first `size` bytes of the running image, with the window (still
+// unused) as the read buffer
+static bool baseMatches(OtaDecoder& d) {
+  Sha256 s;
+  sha256Init(s);
+  for (uint32_t off = 0; off < d.header.baseSize;) {
+    uint32_t n = d.header.baseSize - off;
+    if (n > d.windowSize) n = d.windowSize;
+    if (!d.readBase(d.ctx, off, d.window, n)) return false;
+    sha256Update(s, d.window, n);
+    off += n;
+  }
+  uint8_t sha[SHA256_BYTES];
+  sha256Final(s, sha);
+  return memcmp(sha, d.header.baseSha, SHA256_BYTES) == 0;
+}
+
+static bool parseHeader(OtaDecoder& d) {
+  const uint8_t* p = d.head;
+  OtaHeader& h = d.header;
+  if (le32(p) != OTA_MAGIC || p[4] != OTA_VERSION) return fail(d, OTA_ERR_FORMAT);
+  h.version = p[4];
+  h.flags = p[5];
+  h.windowBits = p[6];
+  h.imageSize = le32(p + 8);
+  memcpy(h.imageSha, p + 12, SHA256_BYTES);
+  h.baseSize = le32(p + 44);
+  memcpy(h.baseSha, p + 48, SHA256_BYTES);
+
+  if (h.imageSize == 0) return fail(d, OTA_ERR_FORMAT);
+  if (h.windowBits > OTA_WINDOW_BITS_MAX || (1u << h.windowBits) > d.windowSize) {
+    return fail(d, OTA_ERR_WINDOW);
+  }
+  if (h.flags & OTA_FLAG_DELTA) {
+    if (!d.readBase || !baseMatches(d)) return fail(d, OTA_ERR_BASE);
+  }
+  return true;
+}
+
+// ---- Ops ----
+
+// Takes one byte of a LEB128 varint into d.varint; `done` after the last.
+// False for one that does not fit 32 bits.
+static bool varintByte(OtaDecoder& d, uint8_t b, bool& done) {
+  if (d.shift > 28 || (d.shift == 28 && (b & 0x70))) return fail(d, OTA_ERR_FORMAT);
+  d.varint |= (uint32_t)(b & 0x7F) << d.shift;
+  d.shift += 7;
+  done = !(b & 0x80);
+  return true;
+}
+
+static void startVarint(OtaDecoder& d, uint8_t state) {
+  d.varint = 0;
+  d.shift = 0;
+  d.state = state;
+}
+
+static void nextOp(OtaDecoder& d) {
+  d.state = d.out == d.header.imageSize ? ST_DONE : ST_TAG;
+}
+
+// The length is known; literals wait for their bytes, copies for their
+// distance or offset
+static void opLength(OtaDecoder& d) {
+  switch (d.op) {
+    case OTA_OP_LITERAL: d.state = ST_LITERAL; break;
+    case OTA_OP_COPY:    startVarint(d, ST_DISTANCE); break;
+    default:             startVarint(d, ST_OFFSET); break;
+  }
+}
+
+static bool runCopy(OtaDecoder& d, uint32_t distance) {
+  uint32_t reach = 1u << d.header.windowBits;
+  if (distance == 0 || distance > reach || distance > d.out) return fail(d, OTA_ERR_FORMAT);
+  uint32_t mask = d.windowSize - 1;
+  for (; d.len > 0; d.len--) {
+    if (!emit(d, d.window[(d.out - distance) & mask])) return false;
+  }
+  return true;
+}
+
+static bool runBase(OtaDecoder& d, uint32_t zigzag) {
+  int64_t delta = (int64_t)(zigzag >> 1) ^ -(int64_t)(zigzag & 1);
+  int64_t from = (int64_t)d.baseCursor + delta;
+  if (!(d.header.flags & OTA_FLAG_DELTA) || from < 0 ||
+      from + d.len > (int64_t)d.header.baseSize) {
+    return fail(d, OTA_ERR_FORMAT);
+  }
+  uint32_t off = (uint32_t)from;
+  uint8_t buf[64];
+  while (d.len > 0) {
+    uint32_t n = d.len < sizeof(buf) ? d.len : sizeof(buf);
+    if (!d.readBase(d.ctx, off, buf, n)) return fail(d, OTA_ERR_BASE);
+    for (uint32_t i = 0; i < n; i++) {
+      if (!emit(d, buf[i])) return false;
+    }
+    off += n;
+    d.len -= n;
+  }
+  d.baseCursor = off;
+  return true;
+}
+
+static bool step(OtaDecoder& d, uint8_t b) {
+  bool done;
+  switch (d.state) {
+    case ST_START:
+      if (b == (OTA_MAGIC & 0xFF)) {
+        d.packed = true;
+        d.state = ST_HEADER;
+        d.head[d.headLen++] = b;
+        return true;
+      }
+      if (b != OTA_APP_IMAGE_MAGIC) return fail(d, OTA_ERR_FORMAT);
+      d.state = ST_PLAIN;
+      return emit(d, b);
+
+    case ST_HEADER:
+      d.head[d.headLen++] = b;
+      if (d.headLen < OTA_HEADER_BYTES) return true;
+      if (!parseHeader(d)) return false;
+      d.state = ST_TAG;
+      return true;
+
+    case ST_PLAIN:
+      return emit(d, b);
+
+    case ST_TAG:
+      d.op = b >> 6;
+      if (d.op > OTA_OP_BASE) return fail(d, OTA_ERR_FORMAT);
+      if ((b & 0x3F) == 0x3F) {
+        startVarint(d, ST_LENGTH);
+        return true;
+      }
+      d.len = (b & 0x3F) + 1;
+      opLength(d);
+      return true;
+
+    case ST_LENGTH:
+      if (!varintByte(d, b, done)) return false;
+      if (done) {
+        if (d.varint > UINT32_MAX - 64) return fail(d, OTA_ERR_FORMAT);
+        d.len = 64 + d.varint;
+        opLength(d);
+      }
+      return true;
+
+    case ST_LITERAL:
+      if (!emit(d, b)) return false;
+      if (--d.len == 0) nextOp(d);
+      return true;
+
+    case ST_DISTANCE:
+      if (!varintByte(d, b, done)) return false;
+      if (done) {
+        if (!runCopy(d, d.varint)) return false;
+        nextOp(d);
+      }
+      return true;
+
+    case ST_OFFSET:
+      if (!varintByte(d, b, done)) return false;
+      if (done) {
+        if (!runBase(d, d.varint)) return false;
+        nextOp(d);
+      }
+      return true;
+
+    default:  // ST_DONE: bytes past the end of the image
+      return fail(d, OTA_ERR_SIZE);
+  }
+}
+
+uint8_t otaDecode(OtaDecoder& d, const uint8_t* data, size_t len) {
+  for (size_t i = 0; i < len && d.result == OTA_OK; i++) {
+    d.in++;
+    step(d, data[i]);
+  }
+  return d.result;
+}
+
+uint8_t otaDecodeFinish(OtaDecoder& d, uint8_t sha[SHA256_BYTES]) {
+  if (d.result != OTA_OK) return d.result;
+  if (d.state == ST_START || d.state == ST_HEADER) {
+    fail(d, OTA_ERR_DOWNLOAD);
+  } else if (d.packed && d.out != d.header.imageSize) {
+    fail(d, OTA_ERR_SIZE);
+  } else if (flush(d)) {
+    sha256Final(d.sha, sha);
+    if (d.packed && memcmp(sha, d.header.imageSha, SHA256_BYTES) != 0) fail(d, OTA_ERR_HASH);
+  }
+  return d.result;
+}
+
+// ---- Trial boots ----
+
+uint8_t otaTrialBoot(OtaTrial& t, uint32_t runningSlot) {
+  if (!t.active) return OTA_TRIAL_NONE;
+  if (t.slot != runningSlot) {
+    t.active = 0;
+    return OTA_TRIAL_NONE;
+  }
+  if (t.boots >= OTA_TRIAL_BOOTS) return OTA_TRIAL_ROLLBACK;
+  t.boots++;
+  return OTA_TRIAL_RUN;
+}
+
+OtaHealth otaHealthCheck(uint32_t uptimeMs, bool needNetwork, bool networkUp) {
+  if (needNetwork && !networkUp) {
+    return uptimeMs >= OTA_NETWORK_MS ? OTA_HEALTH_FAIL : OTA_HEALTH_WAIT;
+  }
+  return uptimeMs >= OTA_HEALTHY_MS ? OTA_HEALTH_OK : OTA_HEALTH_WAIT;
+}
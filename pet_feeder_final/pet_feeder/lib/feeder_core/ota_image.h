@@ -0,0 +1,188 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "ed25519.h"
+#include "sha256.h"
+
+// ---- OTA images ----
+// POST /api/ota?url= downloads a firmware image and streams it into the
+// inactive app slot as it arrives; nothing is buffered beyond a fixed
+// window. The image is either a plain ESP32 app image (.bin, passed through
+// as is) or a packed one from tools/ota_pack.py, unpacked on the fly:
+//
+//   OtaHeader (OTA_HEADER_BYTES, little-endian), then ops until imageSize
+//   bytes are out. An op is a tag byte, type << 6 | n, where n < 63 means a
+//   length of n + 1 and n == 63 a length of 64 + a LEB128 varint:
+//     OTA_OP_LITERAL  the bytes follow
+//     OTA_OP_COPY     varint distance: repeat output from that far back
+//     OTA_OP_BASE     zigzag varint: copy from the running image at the base
+//                     cursor moved by that much; the cursor ends after it
+//
+// Copies reach back at most 1 << windowBits bytes; the decoder keeps that
+// much output in a caller-owned ring, which is also the write buffer, so
+// flash sees window-sized writes. A delta (OTA_FLAG_DELTA) names the image
+// it was made against by size and SHA-256, and the decoder checks the
+// running image against both before writing anything. A packed image must
+// come out at exactly imageSize bytes with imageSha; a plain one is left to
+// the checks of the IDF. Either way the decoder hashes what it wrote, and
+// that hash is what the signature below must cover.
+
+const uint32_t OTA_MAGIC = 0x41544F46;  // "FOTA"
+const uint8_t  OTA_VERSION = 1;
+const size_t   OTA_HEADER_BYTES = 80;
+const uint8_t  OTA_FLAG_DELTA = 0x01;
+const uint8_t  OTA_WINDOW_BITS_MAX = 16;
+const uint8_t  OTA_APP_IMAGE_MAGIC = 0xE9;  // first byte of a plain app image
+
+enum OtaOp : uint8_t {
+  OTA_OP_LITERAL,
+  OTA_OP_COPY,
+  OTA_OP_BASE
+};
+
+enum OtaResult : uint8_t {
+  OTA_OK,
+  OTA_ERR_FORMAT,   // not an image, or ops that break the format
+  OTA_ERR_WINDOW,   // packed with a bigger window than the decoder has
+  OTA_ERR_BASE,     // a delta against another image than the running one
+  OTA_ERR_WRITE,    // the flash write failed
+  OTA_ERR_DOWNLOAD, // the source failed or the transfer broke off
+  OTA_ERR_SIZE,     // more or less than imageSize
+  OTA_ERR_HASH,     // the image came out different
+  OTA_ERR_SIGNATURE // not signed by the release key
+};
+
+const char* otaResultText(uint8_t result);
+
+struct OtaHeader {
+  uint8_t  version;
+  uint8_t  flags;       // OTA_FLAG_* bits
+  uint8_t  windowBits;
+  uint32_t imageSize;
+  uint8_t  imageSha[SHA256_BYTES];
+  uint32_t baseSize;    // delta only
+  uint8_t  baseSha[SHA256_BYTES];
+};
+
+// Takes the next `len` bytes of the image (a multiple of the window, but
+// for the last call). False stops the decoder with OTA_ERR_WRITE.
+typedef bool (*OtaWriteFn)(void* ctx, const uint8_t* data, size_t len);
+// Reads the running image; false for a range it does not have.
+typedef bool (*OtaReadBaseFn)(void* ctx, uint32_t offset, uint8_t* out, size_t len);
+
+struct OtaDecoder {
+  // Set up by initOtaDecoder
+  uint8_t*      window;     // caller-owned, windowSize bytes
+  uint32_t      windowSize; // power of two
+  OtaWriteFn    write;
+  OtaReadBaseFn readBase;   // nullptr: deltas are refused
+  void*         ctx;
+
+  bool      packed;
+  OtaHeader header;
+  uint32_t  in;           // image bytes taken
+  uint32_t  out;          // bytes produced
+  uint32_t  flushed;      // bytes handed to write()
+  uint8_t   result;       // OtaResult, sticky
+
+  // Parser state
+  uint8_t   state;
+  uint8_t   head[OTA_HEADER_BYTES];
+  uint8_t   headLen;
+  uint8_t   op;
+  uint32_t  len;          // bytes the current op still produces
+  uint32_t  varint;
+  uint8_t   shift;
+  uint32_t  baseCursor;
+  Sha256    sha;
+};
+
+void initOtaDecoder(OtaDecoder& d, uint8_t* window, uint32_t windowSize, OtaWriteFn write,
+                    OtaReadBaseFn readBase, void* ctx);
+
+// Takes the next chunk of the download. Returns d.result: OTA_OK to go on,
+// otherwise the first error, and every later call returns it too.
+uint8_t otaDecode(OtaDecoder& d, const uint8_t* data, size_t len);
+
+// After the last chunk: writes what the window still holds and checks the
+// size and hash. `sha` receives the hash of what was written.
+uint8_t otaDecodeFinish(OtaDecoder& d, uint8_t sha[SHA256_BYTES]);
+
+// Header fields once the decoder has seen them
+inline bool otaHeaderKnown(const OtaDecoder& d) { return d.packed && d.headLen == OTA_HEADER_BYTES; }
+
+// ---- Who may update ----
+// Only the holder of the build's FEEDER_OTA_TOKEN may start an update
+// (Authorization: Bearer), so nobody else on the network can make the
+// feeder stop and download. And only an image signed by the release key is
+// booted: sig= is the Ed25519 signature (tools/ota_sign.py) of the SHA-256
+// of the image as written, checked against the public key pinned in the
+// build as FEEDER_OTA_KEY before the boot slot is switched. Neither the
+// caller nor the packed header can vouch for an image, and a build without
+// both values takes no updates.
+
+// Constant-time; an empty `expected` matches nothing
+bool otaTokenMatches(const char* expected, const char* given);
+
+inline bool otaSignatureValid(const uint8_t sha[SHA256_BYTES],
+                              const uint8_t sig[ED25519_SIG_BYTES],
+                              const uint8_t key[ED25519_KEY_BYTES]) {
+  return ed25519Verify(sig, sha, SHA256_BYTES, key);
+}
+
+// ---- Trial boots ----
+// A new image runs on trial: every boot counts against OTA_TRIAL_BOOTS
+// until the health check passes (up for OTA_HEALTHY_MS with the loop
+// running, and on the network if the image has one, since an image that
+// cannot be reached cannot be fixed). A trial that keeps resetting, or
+// fails the check, boots the previous slot again. The record lives in
+// NVS, so this works whether or not the bootloader was built with rollback.
+
+const uint8_t  OTA_TRIAL_BOOTS = 3;
+const uint32_t OTA_HEALTHY_MS  = 60000;
+const uint32_t OTA_NETWORK_MS  = 180000;  // no address by then fails the check
+
+struct OtaTrial {
+  uint8_t  active;     // the running image has not passed the check yet
+  uint8_t  boots;      // boots of it so far
+  uint32_t slot;       // flash offset of the image on trial
+};
+
+enum OtaTrialAction : uint8_t {
+  OTA_TRIAL_NONE,      // not on trial
+  OTA_TRIAL_RUN,       // on trial, run the health check
+  OTA_TRIAL_ROLLBACK   // back to the previous image
+};
+
+// At boot, with the flash offset of the running image. A trial record for
+// another slot (the bootloader already went back) is cleared.
+uint8_t otaTrialBoot(OtaTrial& t, uint32_t runningSlot);
+
+enum OtaHealth : uint8_t {
+  OTA_HEALTH_WAIT,
+  OTA_HEALTH_OK,
+  OTA_HEALTH_FAIL
+};
+
+OtaHealth otaHealthCheck(uint32_t uptimeMs, bool needNetwork, bool networkUp);
+
+// ---- Last update, for GET /api/ota ----
+struct OtaReport {
+  uint8_t  result;       // OtaResult
+  uint8_t  kind;         // OtaImageKind
+  uint32_t transferBytes;
+  uint32_t imageBytes;
+  uint32_t ms;           // download, unpack and write
+};
+
+enum OtaImageKind : uint8_t {
+  OTA_IMAGE_NONE,        // no update yet
+  OTA_IMAGE_FULL,
+  OTA_IMAGE_PACKED,
+  OTA_IMAGE_DELTA
+};
+
+const char* otaImageKindName(uint8_t kind);
+
+// What the decoder was given: OTA_IMAGE_NONE before the first byte
+uint8_t otaImageKind(const OtaDecoder& d);
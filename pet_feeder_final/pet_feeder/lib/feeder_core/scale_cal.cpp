@@ -0,0 +1,142 @@
+#include "scale_cal.h"
+#include <math.h>
+#include <string.h>
+
+void initCalCapture(CalCapture& c) {
+  memset(&c, 0, sizeof(c));
+}
+
+void startCalCapture(CalCapture& c, uint8_t step, float massG) {
+  initCalCapture(c);
+  c.step = step;
+  c.lastStep = step;
+  c.result = CAL_RUNNING;
+  c.massG = massG;
+}
+
+static void restartRun(CalCapture& c, int32_t raw) {
+  c.count = 1;
+  c.sum = raw;
+  c.lo = c.hi = raw;
+}
+
+static bool endCapture(CalCapture& c, uint8_t result) {
+  c.step = CAL_NONE;
+  c.result = result;
+  return true;
+}
+
+bool calCaptureSample(CalCapture& c, ScaleCal& cal, int32_t raw) {
+  if (c.step == CAL_NONE) return false;
+  c.seen++;
+
+  // Only a run of steady conversions counts; a jump starts a new one
+  float band = CAL_STABLE_G * fabsf(cal.countsPerGram);
+  int32_t lo = raw < c.lo ? raw : c.lo;
+  int32_t hi = raw > c.hi ? raw : c.hi;
+  if (c.count == 0 || (float)(hi - lo) > band) {
+    restartRun(c, raw);
+  } else {
+    c.count++;
+    c.sum += raw;
+    c.lo = lo;
+    c.hi = hi;
+  }
+
+  if (c.count < CAL_SAMPLES) {
+    return c.seen >= CAL_MAX_SAMPLES ? endCapture(c, CAL_UNSTABLE) : false;
+  }
+  float mean = (float)c.sum / c.count;
+  if (c.step == CAL_ZERO) {
+    cal.offset = (int32_t)lroundf(mean);
+    return endCapture(c, CAL_OK);
+  }
+  float factor = (mean - cal.offset) / c.massG;
+  float ratio = fabsf(factor / cal.countsPerGram);
+  if (!(c.massG > 0) || ratio < 1.0f / CAL_SPAN_RATIO || ratio > CAL_SPAN_RATIO) {
+    return endCapture(c, CAL_BAD_SPAN);
+  }
+  cal.countsPerGram = factor;
+  return endCapture(c, CAL_OK);
+}
+
+const char* calStepName(uint8_t step) {
+  switch (step) {
+    case CAL_ZERO: return "zero";
+    case CAL_SPAN: return "span";
+    default:       return "none";
+  }
+}
+
+const char* calResultName(uint8_t result) {
+  switch (result) {
+    case CAL_OK:       return "ok";
+    case CAL_RUNNING:  return "running";
+    case CAL_UNSTABLE: return "unstable";
+    case CAL_BAD_SPAN: return "bad span";
+    default:           return "?";
+  }
+}
+
+void initZeroTracker(ZeroTracker& z, uint32_t nowMs) {
+  memset(&z, 0, sizeof(z));
+  z.lastStepMs = nowMs;
+}
+
+bool zeroTrack(ZeroTracker& z, ScaleCal& cal, int32_t raw, bool idle, uint32_t nowMs) {
+  if (!idle) {
+    z.quiet = false;
+    z.holding = false;
+    z.count = 0;
+    return false;
+  }
+  if (!z.quiet) {
+    z.quiet = true;
+    z.quietSinceMs = nowMs;
+  }
+  z.window[z.head] = raw;
+  z.head = (z.head + 1) % ZERO_TRACK_WINDOW;
+  if (z.count < ZERO_TRACK_WINDOW) z.count++;
+  if (z.count < ZERO_TRACK_WINDOW) return false;
+
+  // Stability is checked on every conversion, so no bite goes unseen
+  // between two steps
+  int64_t sum = 0;
+  int32_t lo = z.window[0], hi = z.window[0];
+  for (int32_t v : z.window) {
+    sum += v;
+    if (v < lo) lo = v;
+    if (v > hi) hi = v;
+  }
+  if ((hi - lo) / fabsf(cal.countsPerGram) > ZERO_TRACK_STABLE_G) {
+    z.holding = false;  // something is moving
+    return false;
+  }
+  if (nowMs - z.quietSinceMs < ZERO_TRACK_SETTLE_MS ||
+      nowMs - z.lastStepMs < ZERO_TRACK_INTERVAL_MS) {
+    return false;
+  }
+
+  float w = scaleGrams(cal, (float)sum / ZERO_TRACK_WINDOW);
+  float target = 0;
+  if (w > ZERO_TRACK_ABOVE_G || w < -ZERO_TRACK_BELOW_G) {
+    if (!z.holding || fabsf(w - z.holdG) > ZERO_TRACK_HOLD_G) {
+      z.holding = true;  // a new level: hold it from here
+      z.holdG = w;
+      return false;
+    }
+    target = z.holdG;
+  }
+  float err = w - target;
+  if (fabsf(err) < ZERO_TRACK_DEADBAND_G) return false;
+
+  float step = err > ZERO_TRACK_STEP_G ? ZERO_TRACK_STEP_G
+             : err < -ZERO_TRACK_STEP_G ? -ZERO_TRACK_STEP_G : err;
+  int32_t counts = (int32_t)lroundf(step * cal.countsPerGram);
+  if (counts == 0) return false;
+  cal.offset += counts;
+  z.trackedG += step;
+  z.steps++;
+  z.lastStepMs = nowMs;
+  return true;
+}
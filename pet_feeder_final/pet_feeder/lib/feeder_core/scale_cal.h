@@ -0,0 +1,104 @@
+#pragma once
+#include <stdint.h>
+
+// ---- Load cell calibration and zero tracking (/api/calibration) ----
+// grams = (counts - offset) / countsPerGram, with the bowl on the scale. A
+// zero capture with the bowl empty sets the offset; a span capture with a
+// known mass in it sets counts per gram, whose sign follows the wiring, so
+// readings are signed and a drifted zero reads below nothing instead of
+// being folded back up. A capture averages CAL_SAMPLES conversions that
+// lie within CAL_STABLE_G of each other and takes one per call, so it runs
+// alongside the loop; a reading that will not settle fails it.
+//
+// Zero tracking re-tares slowly while nothing happens: after
+// ZERO_TRACK_SETTLE_MS with no feed and the gate shut, and while windows of
+// ZERO_TRACK_WINDOW conversions stay within ZERO_TRACK_STABLE_G, the offset
+// moves by at most ZERO_TRACK_STEP_G every ZERO_TRACK_INTERVAL_MS so that
+// - a reading within [-ZERO_TRACK_BELOW_G, ZERO_TRACK_ABOVE_G] goes to zero:
+//   an empty bowl that drifted. The band is lopsided: an empty bowl cannot
+//   weigh less than nothing, so a moderate negative reading is drift, while
+//   a positive one may be a few kibbles left;
+// - any other reading stays where it first settled: food nobody touches
+//   does not change weight, so a creep of up to ZERO_TRACK_HOLD_G is drift
+//   too, and the zero is still right when the bowl is next emptied.
+// Movement, or a larger change, starts over from the new level.
+
+struct ScaleCal {
+  int32_t  offset;          // counts with the bowl empty
+  float    countsPerGram;   // signed
+  uint32_t spanTime;        // Unix time of the last span capture, 0 = configured factor
+};
+
+inline float scaleGrams(const ScaleCal& c, float counts) {
+  return (counts - c.offset) / c.countsPerGram;
+}
+
+// ---- Captures ----
+const int   CAL_SAMPLES      = 16;
+const int   CAL_MAX_SAMPLES  = 10 * CAL_SAMPLES;  // then it gives up
+const float CAL_STABLE_G     = 1.0f;
+const float CAL_SPAN_RATIO   = 4.0f;  // a new factor within 4x of the old one
+
+enum CalStep : uint8_t {
+  CAL_NONE,
+  CAL_ZERO,    // bowl empty: sets the offset
+  CAL_SPAN     // known mass in the bowl: sets counts per gram
+};
+
+enum CalResult : uint8_t {
+  CAL_OK,
+  CAL_RUNNING,
+  CAL_UNSTABLE,  // no CAL_SAMPLES steady conversions in CAL_MAX_SAMPLES
+  CAL_BAD_SPAN   // implausible factor: mass missing, or not the one stated
+};
+
+struct CalCapture {
+  uint8_t  step;       // CalStep running, CAL_NONE when idle
+  uint8_t  lastStep;   // of the last capture, for reports
+  uint8_t  result;     // CalResult of the last capture
+  float    massG;      // CAL_SPAN: the known mass
+  uint16_t count;      // steady conversions in a row
+  uint16_t seen;       // conversions taken
+  int64_t  sum;
+  int32_t  lo, hi;
+};
+
+void initCalCapture(CalCapture& c);
+void startCalCapture(CalCapture& c, uint8_t step, float massG);
+
+// One fresh conversion. Returns true when the capture ended; on CAL_OK it
+// has updated `cal` (spanTime is left to the caller, which has the clock).
+bool calCaptureSample(CalCapture& c, ScaleCal& cal, int32_t raw);
+
+const char* calStepName(uint8_t step);
+const char* calResultName(uint8_t result);
+
+// ---- Zero tracking ----
+const int      ZERO_TRACK_WINDOW      = 16;
+const float    ZERO_TRACK_STABLE_G    = 0.5f;
+const float    ZERO_TRACK_ABOVE_G     = 0.5f;
+const float    ZERO_TRACK_BELOW_G     = 30.0f;
+const float    ZERO_TRACK_HOLD_G      = 0.2f;
+const float    ZERO_TRACK_DEADBAND_G  = 0.05f;   // closer than this is zero already
+const float    ZERO_TRACK_STEP_G      = 0.05f;
+const uint32_t ZERO_TRACK_INTERVAL_MS = 2000;    // so at most 1.5 g a minute
+const uint32_t ZERO_TRACK_SETTLE_MS   = 10000;   // after a feed, for the crumbs to land
+
+struct ZeroTracker {
+  int32_t  window[ZERO_TRACK_WINDOW];
+  uint8_t  count;
+  uint8_t  head;
+  bool     quiet;          // idle since quietSinceMs
+  uint32_t quietSinceMs;
+  bool     holding;        // steady at holdG outside the zero band
+  float    holdG;
+  uint32_t lastStepMs;
+  uint32_t steps;          // offset moves so far
+  float    trackedG;       // drift taken out so far, signed
+};
+
+void initZeroTracker(ZeroTracker& z, uint32_t nowMs);
+
+// One fresh conversion; `idle` is no feed, the gate shut and no capture
+// running. Returns true when it moved cal.offset.
+bool zeroTrack(ZeroTracker& z, ScaleCal& cal, int32_t raw, bool idle, uint32_t nowMs);
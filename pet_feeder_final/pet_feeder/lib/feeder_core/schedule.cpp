@@ -0,0 +1,359 @@
+#include "schedule.h"
+#include "feeder_time.h"
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+const uint16_t NO_MINUTE = 0xFFFF;
+
+// ---- Cron subset ----
+
+// One field: comma list of *, a, a-b, with optional /step.
+static bool parseCronField(const char* s, const char* end, int lo, int hi, uint64_t& mask) {
+  mask = 0;
+  while (s < end) {
+    const char* itemEnd = (const char*)memchr(s, ',', end - s);
+    if (!itemEnd) itemEnd = end;
+
+    int a, b, step = 1;
+    bool single = false;
+    const char* p = s;
+    if (*p == '*') {
+      a = lo; b = hi; p++;
+    } else {
+      if (!isdigit((unsigned char)*p)) return false;
+      a = strtol(p, (char**)&p, 10);
+      b = a;
+      single = true;
+      if (p < itemEnd && *p == '-') {
+        p++;
+        if (!isdigit((unsigned char)*p)) return false;
+        b = strtol(p, (char**)&p, 10);
+        single = false;
+      }
+    }
+    if (p < itemEnd && *p == '/') {
+      p++;
+      if (!isdigit((unsigned char)*p)) return false;
+      step = strtol(p, (char**)&p, 10);
+      if (single) b = hi;  // "a/n" = from a to the end
+    }
+    if (p != itemEnd || step <= 0 || a < lo || b > hi || a > b) return false;
+
+    for (int v = a; v <= b; v += step) mask |= 1ULL << v;
+    s = itemEnd < end ? itemEnd + 1 : end;
+  }
+  return mask != 0;
+}
+
+bool parseCron(const char* expr, CompiledRule& out) {
+  const char* fields[5][2];
+  int n = 0;
+  for (const char* p = expr; *p && n <= 5; ) {
+    while (*p == ' ' || *p == '\t') p++;
+    if (!*p) break;
+    const char* start = p;
+    while (*p && *p != ' ' && *p != '\t') p++;
+    if (n == 5) return false;
+    fields[n][0] = start;
+    fields[n][1] = p;
+    n++;
+  }
+  if (n != 5) return false;
+
+  uint64_t minutes, hours, dow;
+  if (!parseCronField(fields[0][0], fields[0][1], 0, 59, minutes)) return false;
+  if (!parseCronField(fields[1][0], fields[1][1], 0, 23, hours)) return false;
+  for (int i = 2; i <= 3; i++) {
+    if (fields[i][1] - fields[i][0] != 1 || *fields[i][0] != '*') return false;
+  }
+  if (!parseCronField(fields[4][0], fields[4][1], 0, 7, dow)) return false;
+  if (dow & (1 << 7)) dow = (dow | 1) & ALL_DAYS;
+
+  out.kind = RULE_CRON;
+  out.minutes = minutes;
+  out.hours = (uint32_t)hours;
+  out.days = (uint8_t)dow;
+  return true;
+}
+
+// ---- Catch-up policy names ----
+
+static const char* const kCatchUpNames[] = {"skip", "late", "proportional"};
+
+const char* catchUpPolicyName(uint8_t policy) {
+  return policy <= CATCHUP_PROPORTIONAL ? kCatchUpNames[policy] : "?";
+}
+
+bool parseCatchUpPolicy(const char* name, uint8_t& policy) {
+  for (uint8_t i = 0; i <= CATCHUP_PROPORTIONAL; i++) {
+    if (strcmp(name, kCatchUpNames[i]) == 0) {
+      policy = i;
+      return true;
+    }
+  }
+  return false;
+}
+
+// ---- Slot edits ----
+
+// Fields separated by one space, as the expression is stored and served:
+// parseCron also splits on tabs, which /api/status would pass into JSON.
+static void normalizeCron(char* cron) {
+  char* out = cron;
+  for (const char* p = cron; *p; ) {
+    while (*p == ' ' || *p == '\t') p++;
+    if (!*p) break;
+    if (out != cron) *out++ = ' ';
+    while (*p && *p != ' ' && *p != '\t') *out++ = *p++;
+  }
+  *out = '\0';
+}
+
+const char* applySlotEdit(FeedingSlot& slot, const SlotEdit& e, CompiledRule& rule) {
+  if (e.hour < 0 || e.hour > 23 || e.minute < 0 || e.minute > 59) return "Invalid time";
+
+  FeedingSlot s = slot;
+  s.hour   = e.hour;
+  s.minute = e.minute;
+  s.weight = e.weight > 0 ? e.weight : 0;
+  s.active = e.weight > 0;
+  int32_t days   = (e.has & SLOT_EDIT_DAYS)   ? e.days     : s.days;
+  int32_t every  = (e.has & SLOT_EDIT_EVERY)  ? e.everyMin : s.everyMin;
+  int32_t until  = (e.has & SLOT_EDIT_UNTIL)  ? e.untilMin : s.untilMin;
+  int32_t splits = (e.has & SLOT_EDIT_SPLITS) ? e.splits   : s.splits;
+  if (days < 1 || days > ALL_DAYS || every < 0 || every >= MINUTES_PER_DAY ||
+      until < 0 || until >= MINUTES_PER_DAY || splits < 0 || splits > 99) {
+    return "Invalid recurrence";
+  }
+  s.days     = days;
+  s.everyMin = every;
+  s.untilMin = until;
+  s.splits   = splits;
+  if (e.has & SLOT_EDIT_CATCHUP) {
+    if (e.catchUp > CATCHUP_PROPORTIONAL) return "Invalid catchUp (skip, late, proportional)";
+    s.catchUp = e.catchUp;
+  }
+  if (e.has & SLOT_EDIT_CATCHUP_MIN) {
+    if (e.catchUpMin < 0 || e.catchUpMin > MINUTES_PER_DAY) return "Invalid catchUpMin";
+    s.catchUpMin = e.catchUpMin;
+  }
+  if (e.has & SLOT_EDIT_CRON) {
+    const char* cron = e.cron ? e.cron : "";
+    if (strlen(cron) >= (size_t)CRON_MAX) return "Cron expression too long";
+    strncpy(s.cron, cron, CRON_MAX);
+    normalizeCron(s.cron);
+  }
+
+  CompiledRule r;
+  if (!compileRule(s, r)) return "Invalid recurrence rule";
+  slot = s;
+  rule = r;
+  return nullptr;
+}
+
+// ---- Compile ----
+
+bool compileRule(const FeedingSlot& slot, CompiledRule& out) {
+  memset(&out, 0, sizeof(out));
+  out.kind = RULE_NONE;
+  if (!slotEnabled(slot)) return true;
+
+  uint8_t days = slot.days & ALL_DAYS;
+  if (days == 0) return false;
+
+  if (slot.catchUp > CATCHUP_PROPORTIONAL) return false;
+
+  CompiledRule r;
+  memset(&r, 0, sizeof(r));
+  r.portion = slot.weight;
+  r.catchUp = slot.catchUp;
+  r.catchUpSecs = slot.catchUpMin * SECS_PER_MINUTE;
+
+  if (slot.cron[0]) {
+    if (!parseCron(slot.cron, r)) return false;
+    r.days &= days;
+    if (r.days == 0) return false;
+    out = r;
+    return true;
+  }
+
+  if (slot.hour < 0 || slot.hour > 23 || slot.minute < 0 || slot.minute > 59) return false;
+  uint16_t first = slot.hour * 60 + slot.minute;
+  uint16_t until = slot.untilMin ? slot.untilMin : MINUTES_PER_DAY - 1;
+  if (until >= MINUTES_PER_DAY) return false;
+
+  r.kind = RULE_TIMES;
+  r.days = days;
+  r.firstMin = first;
+  r.lastMin = first;
+
+  if (slot.splits > 1) {
+    // N portions spread evenly over [first, until]
+    if (until <= first) return false;
+    r.periodMin = (until - first) / (slot.splits - 1);
+    if (r.periodMin == 0) return false;
+    r.lastMin = first + r.periodMin * (slot.splits - 1);
+    r.portion = slot.weight / slot.splits;
+  } else if (slot.everyMin > 0) {
+    if (until < first) return false;
+    r.periodMin = slot.everyMin;
+    r.lastMin = first + (until - first) / r.periodMin * r.periodMin;
+  }
+
+  out = r;
+  return true;
+}
+
+void compileSlots(const FeedingSlot* slots, CompiledRule* out, int count) {
+  for (int i = 0; i < count; i++) {
+    compileRule(slots[i], out[i]);
+  }
+}
+
+// ---- Occurrences ----
+
+// First fire minute >= m0 on a day the rule runs, or NO_MINUTE.
+static uint16_t firstFireFrom(const CompiledRule& r, uint16_t m0) {
+  if (m0 >= MINUTES_PER_DAY) return NO_MINUTE;
+
+  if (r.kind == RULE_TIMES) {
+    if (m0 <= r.firstMin) return r.firstMin;
+    if (r.periodMin == 0) return NO_MINUTE;
+    uint16_t k = (m0 - r.firstMin + r.periodMin - 1) / r.periodMin;
+    uint32_t m = r.firstMin + (uint32_t)k * r.periodMin;
+    return m <= r.lastMin ? m : NO_MINUTE;
+  }
+
+  if (r.kind == RULE_CRON) {
+    int h = m0 / 60;
+    int mm = m0 % 60;
+    if ((r.hours >> h) & 1) {
+      uint64_t rest = r.minutes >> mm;
+      if (rest) return h * 60 + mm + __builtin_ctzll(rest);
+    }
+    uint32_t later = h < 23 ? r.hours & ~((2u << h) - 1) : 0;
+    if (later) return __builtin_ctz(later) * 60 + __builtin_ctzll(r.minutes);
+  }
+  return NO_MINUTE;
+}
+
+// Latest fire minute <= m on a day the rule runs, or NO_MINUTE.
+static uint16_t lastFireUpTo(const CompiledRule& r, uint16_t m) {
+  if (r.kind == RULE_TIMES) {
+    if (m < r.firstMin) return NO_MINUTE;
+    uint16_t top = m < r.lastMin ? m : r.lastMin;
+    if (r.periodMin == 0) return r.firstMin;
+    return r.firstMin + (top - r.firstMin) / r.periodMin * r.periodMin;
+  }
+  if (r.kind == RULE_CRON) {
+    int h = m / 60;
+    int mm = m % 60;
+    if ((r.hours >> h) & 1) {
+      uint64_t upTo = r.minutes & ((2ULL << mm) - 1);
+      if (upTo) return h * 60 + 63 - __builtin_clzll(upTo);
+    }
+    uint32_t earlier = r.hours & ((1u << h) - 1);
+    if (earlier) return (31 - __builtin_clz(earlier)) * 60 + 63 - __builtin_clzll(r.minutes);
+  }
+  return NO_MINUTE;
+}
+
+// Days from `dow` to the next weekday in `days` (1..7).
+static int daysUntilNext(uint8_t days, int dow) {
+  uint16_t twice = days | (days << 7);
+  return __builtin_ctz(twice >> (dow + 1)) + 1;
+}
+
+// Days from `dow` back to the previous weekday in `days` (1..7).
+static int daysSincePrev(uint8_t days, int dow) {
+  uint16_t twice = days | (days << 7);
+  uint16_t below = twice & ((1u << (dow + 7)) - 1);
+  return dow + 7 - (31 - __builtin_clz(below));
+}
+
+bool ruleFiresAt(const CompiledRule& r, uint32_t t) {
+  if (r.kind == RULE_NONE || !((r.days >> dayOfWeek(t)) & 1)) return false;
+  uint16_t m = (t % SECS_PER_DAY) / SECS_PER_MINUTE;
+  return firstFireFrom(r, m) == m;
+}
+
+uint32_t ruleNextFire(const CompiledRule& r, uint32_t now) {
+  if (r.kind == RULE_NONE) return NO_FEEDING_TIME;
+
+  uint32_t today = startOfDay(now);
+  int dow = dayOfWeek(now);
+
+  if ((r.days >> dow) & 1) {
+    // first minute boundary at or after now
+    uint16_t m0 = (now - today + SECS_PER_MINUTE - 1) / SECS_PER_MINUTE;
+    uint16_t m = firstFireFrom(r, m0);
+    if (m != NO_MINUTE) return today + m * SECS_PER_MINUTE;
+  }
+
+  uint32_t day = today + daysUntilNext(r.days, dow) * SECS_PER_DAY;
+  return day + firstFireFrom(r, 0) * SECS_PER_MINUTE;
+}
+
+uint32_t rulePrevFire(const CompiledRule& r, uint32_t now) {
+  if (r.kind == RULE_NONE) return NO_FEEDING_TIME;
+
+  uint32_t today = startOfDay(now);
+  int dow = dayOfWeek(now);
+
+  if ((r.days >> dow) & 1) {
+    uint16_t m = lastFireUpTo(r, (now - today) / SECS_PER_MINUTE);
+    if (m != NO_MINUTE) return today + m * SECS_PER_MINUTE;
+  }
+
+  uint32_t back = daysSincePrev(r.days, dow) * SECS_PER_DAY;
+  if (back > today) return NO_FEEDING_TIME;
+  return today - back + lastFireUpTo(r, MINUTES_PER_DAY - 1) * SECS_PER_MINUTE;
+}
+
+// ---- Slots ----
+
+DueFeed checkSlotDue(const CompiledRule& r, uint32_t& marker, uint32_t now) {
+  DueFeed d = {DUE_NONE, 0, 0};
+  if (marker == NO_MARKER || marker > now) {
+    marker = now;
+    return d;
+  }
+
+  uint32_t fire = rulePrevFire(r, now);
+  if (fire == NO_FEEDING_TIME || fire <= marker) return d;
+
+  marker = fire;
+  d.fireTime = fire;
+  uint32_t late = now - fire;
+
+  if (late < ON_TIME_SECS) {
+    d.kind = DUE_ON_TIME;
+    d.amount = r.portion;
+  } else if (r.catchUp == CATCHUP_SKIP || late > r.catchUpSecs) {
+    d.kind = DUE_SKIPPED;
+  } else if (r.catchUp == CATCHUP_PROPORTIONAL) {
+    d.amount = r.portion * (float)(r.catchUpSecs - late) / r.catchUpSecs;
+    d.kind = d.amount >= 1.0f ? DUE_LATE : DUE_SKIPPED;
+    if (d.kind == DUE_SKIPPED) d.amount = 0;
+  } else {
+    d.kind = DUE_LATE;
+    d.amount = r.portion;
+  }
+  return d;
+}
+
+uint32_t nextFeedingTime(const CompiledRule* rules, int count, uint32_t now, int* slotOut) {
+  uint32_t next = NO_FEEDING_TIME;
+  int slot = -1;
+
+  for (int i = 0; i < count; i++) {
+    uint32_t t = ruleNextFire(rules[i], now);
+    if (t < next) {
+      next = t;
+      slot = i;
+    }
+  }
+  if (slotOut) *slotOut = slot;
+  return next;
+}
@@ -0,0 +1,156 @@
+#pragma once
+#include <stdint.h>
+
+const uint8_t  ALL_DAYS = 0x7F;        // weekday mask, bit 0 = Sunday
+const int      CRON_MAX = 32;
+const uint16_t MINUTES_PER_DAY = 1440;
+const uint32_t NO_FEEDING_TIME = 0xFFFFFFFF;
+
+// ---- Catch-up ----
+// What to do with an occurrence noticed late (power cut, RTC jump, loop
+// stalled). Within ON_TIME_SECS of its fire time every occurrence is on time.
+enum CatchUpPolicy : uint8_t {
+  CATCHUP_SKIP,          // drop it
+  CATCHUP_LATE,          // full portion if no more than catchUpMin late
+  CATCHUP_PROPORTIONAL   // portion shrinks linearly to 0 at catchUpMin late
+};
+
+const uint32_t ON_TIME_SECS = 60;
+const uint16_t CATCHUP_DEFAULT_MIN = 30;
+
+// "skip" / "late" / "proportional"
+const char* catchUpPolicyName(uint8_t policy);
+bool parseCatchUpPolicy(const char* name, uint8_t& policy);
+
+// ---- Slots ----
+// A slot fires every day at hour:minute unless one of the recurrence fields
+// says otherwise. The defaults keep `{active, hour, minute, weight}` meaning
+// exactly what it always did.
+struct FeedingSlot {
+  bool  active;
+  int   hour;
+  int   minute;
+  float weight;  // grams per feed (split slots: total for the window)
+
+  uint8_t  days = ALL_DAYS;    // only on these weekdays
+  uint16_t everyMin = 0;       // >0: repeat every N minutes from hour:minute...
+  uint16_t untilMin = 0;       // ...up to this minute of the day (0 = 23:59)
+  uint8_t  splits = 0;         // >1: weight split into N even portions hour:minute..untilMin
+  char     cron[CRON_MAX] = ""; // "m h * * dow" subset; replaces hour/minute/every
+  uint8_t  catchUp = CATCHUP_LATE;              // CatchUpPolicy
+  uint16_t catchUpMin = CATCHUP_DEFAULT_MIN;    // catch-up window
+};
+
+inline bool slotEnabled(const FeedingSlot& s) { return s.active && s.weight > 0; }
+
+// ---- Compiled rules ----
+// Each slot is compiled once (whenever it changes) into one of two compact
+// forms whose next occurrence is found with a few bit scans, never by
+// stepping through minutes:
+//   RULE_TIMES  fires at firstMin, firstMin + periodMin, ... <= lastMin
+//   RULE_CRON   fires at every (hour, minute) set in the two bitmasks
+// both only on weekdays set in `days`.
+enum RuleKind : uint8_t {
+  RULE_NONE,
+  RULE_TIMES,
+  RULE_CRON
+};
+
+struct CompiledRule {
+  uint8_t  kind;
+  uint8_t  days;
+  uint16_t firstMin;   // minute of day
+  uint16_t lastMin;
+  uint16_t periodMin;  // 0 = once a day
+  uint32_t hours;      // bit h = hour h
+  uint64_t minutes;    // bit m = minute m
+  float    portion;    // grams per fire
+  uint8_t  catchUp;
+  uint32_t catchUpSecs;
+};
+
+// Disabled slots compile to RULE_NONE. Returns false (and RULE_NONE) when the
+// recurrence fields or cron expression are invalid.
+bool compileRule(const FeedingSlot& slot, CompiledRule& out);
+
+// Cron subset: "minute hour * * weekday" with *, a, a-b, */n, a-b/n and
+// comma lists; weekday 0-7 (0 and 7 = Sunday). Day-of-month and month
+// must be "*".
+bool parseCron(const char* expr, CompiledRule& out);
+
+// True when the rule fires at the minute containing `t`.
+bool ruleFiresAt(const CompiledRule& r, uint32_t t);
+
+// Earliest fire time >= `now`, or NO_FEEDING_TIME.
+uint32_t ruleNextFire(const CompiledRule& r, uint32_t now);
+
+// Latest fire time <= `now`, or NO_FEEDING_TIME.
+uint32_t rulePrevFire(const CompiledRule& r, uint32_t now);
+
+void compileSlots(const FeedingSlot* slots, CompiledRule* out, int count);
+
+// ---- Slot edits ----
+// One slot changed through /api/set-slot or a serial command
+// (serial_proto.h). hour, minute and weight are always given; a recurrence
+// field only when its bit is set in `has`, otherwise the slot keeps its
+// current value. Fields are wide so out-of-range input is rejected rather
+// than wrapped.
+enum SlotEditField : uint8_t {
+  SLOT_EDIT_DAYS        = 0x01,
+  SLOT_EDIT_EVERY       = 0x02,
+  SLOT_EDIT_UNTIL       = 0x04,
+  SLOT_EDIT_SPLITS      = 0x08,
+  SLOT_EDIT_CATCHUP     = 0x10,
+  SLOT_EDIT_CATCHUP_MIN = 0x20,
+  SLOT_EDIT_CRON        = 0x40
+};
+
+struct SlotEdit {
+  int32_t     hour;
+  int32_t     minute;
+  float       weight;     // <= 0 disables the slot
+  uint8_t     has;        // SlotEditField bits
+  int32_t     days;
+  int32_t     everyMin;
+  int32_t     untilMin;
+  int32_t     splits;
+  uint8_t     catchUp;    // CatchUpPolicy
+  int32_t     catchUpMin;
+  const char* cron;
+};
+
+// Applies `e` to `slot` and compiles the result into `rule`. Returns
+// nullptr, or why the edit was rejected, in which case neither is changed.
+// A cron expression is stored with its fields separated by single spaces.
+const char* applySlotEdit(FeedingSlot& slot, const SlotEdit& e, CompiledRule& rule);
+
+// ---- Edge-triggered firing ----
+// Each slot keeps a marker: the fire time of the last occurrence it handled
+// (fed or skipped). An occurrence is due when it lies in (marker, now], so
+// nothing is lost between evaluations however far apart they are, and an
+// occurrence is never handled twice. Only the latest missed occurrence
+// counts; a slot never fires a burst to make up for several.
+const uint32_t NO_MARKER = 0;  // never evaluated: start from `now`
+
+enum DueKind : uint8_t {
+  DUE_NONE,
+  DUE_ON_TIME,
+  DUE_LATE,      // caught up, possibly with a reduced portion
+  DUE_SKIPPED    // missed and dropped by the slot's policy
+};
+
+struct DueFeed {
+  uint8_t  kind;       // DueKind
+  uint32_t fireTime;
+  float    amount;     // grams to feed (0 unless ON_TIME / LATE)
+};
+
+// Checks one slot and advances `marker` past the occurrence it reports. If
+// the clock went backwards past the marker, the marker restarts at `now`.
+// The caller persists the marker whenever kind != DUE_NONE.
+DueFeed checkSlotDue(const CompiledRule& r, uint32_t& marker, uint32_t now);
+
+// Earliest fire time of any slot that is not before `now`, or
+// NO_FEEDING_TIME. `slotOut` (optional) receives that slot's index.
+uint32_t nextFeedingTime(const CompiledRule* rules, int count, uint32_t now,
+                         int* slotOut = nullptr);
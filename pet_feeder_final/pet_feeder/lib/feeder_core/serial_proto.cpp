@@ -0,0 +1,288 @@
+#include "serial_proto.h"
+#include <string.h>
+
+uint16_t crc16Ccitt(const uint8_t* data, size_t len, uint16_t crc) {
+  for (size_t i = 0; i < len; i++) {
+    crc ^= (uint16_t)data[i] << 8;
+    for (int b = 0; b < 8; b++) crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+  }
+  return crc;
+}
+
+size_t cobsDecode(uint8_t* buf, size_t len) {
+  size_t r = 0, w = 0;
+  while (r < len) {
+    uint8_t code = buf[r++];
+    if (code == 0 || r + code - 1 > len) return SIZE_MAX;
+    for (uint8_t i = 1; i < code; i++) {
+      if (buf[r] == 0) return SIZE_MAX;
+      buf[w++] = buf[r++];
+    }
+    // A short block stands for a zero, except the last one
+    if (code < 0xFF && r < len) buf[w++] = 0;
+  }
+  return w;
+}
+
+// ---- Sending ----
+
+void initSerialTx(SerialTx& t, uint8_t* storage, uint32_t cap) {
+  memset(&t, 0, sizeof(t));
+  t.buf = storage;
+  t.cap = cap;
+}
+
+// COBS straight into the ring: each block's code byte is reserved when the
+// block starts and filled in once its length is known.
+struct RingEncoder {
+  SerialTx& t;
+  uint32_t  at;
+  uint32_t  codeAt;
+  uint8_t   code;
+
+  void put(uint32_t pos, uint8_t b) { t.buf[pos % t.cap] = b; }
+  void begin() {
+    put(at++, 0);
+    codeAt = at++;
+    code = 1;
+  }
+  void byte(uint8_t b) {
+    if (b == 0) {
+      put(codeAt, code);
+      codeAt = at++;
+      code = 1;
+      return;
+    }
+    put(at++, b);
+    if (++code == 0xFF) {
+      put(codeAt, code);
+      codeAt = at++;
+      code = 1;
+    }
+  }
+  void bytes(const uint8_t* p, size_t n) {
+    for (size_t i = 0; i < n; i++) byte(p[i]);
+  }
+  void end() {
+    put(codeAt, code);
+    put(at++, 0);
+  }
+};
+
+bool serialSend(SerialTx& t, uint8_t type, const uint8_t* payload, size_t len) {
+  if (len > SERIAL_PAYLOAD_MAX || serialFrameMax(len) > t.cap - serialTxPending(t)) {
+    t.dropped++;
+    return false;
+  }
+  uint8_t head[2] = {type, t.seq};
+  uint16_t crc = crc16Ccitt(head, sizeof(head));
+  crc = crc16Ccitt(payload, len, crc);
+  uint8_t tail[2] = {(uint8_t)crc, (uint8_t)(crc >> 8)};
+
+  RingEncoder e = {t, t.head, 0, 0};
+  e.begin();
+  e.bytes(head, sizeof(head));
+  e.bytes(payload, len);
+  e.bytes(tail, sizeof(tail));
+  e.end();
+  t.head = e.at;
+  t.seq++;
+  t.frames++;
+  return true;
+}
+
+size_t serialTxPeek(const SerialTx& t, const uint8_t** data) {
+  uint32_t pending = serialTxPending(t);
+  uint32_t at = t.tail % t.cap;
+  *data = t.buf + at;
+  return pending < t.cap - at ? pending : t.cap - at;
+}
+
+void serialTxConsume(SerialTx& t, size_t n) {
+  uint32_t pending = serialTxPending(t);
+  t.tail += n < pending ? n : pending;
+}
+
+void SerialPayload::put(const void* p, size_t n) {
+  if (overflow_ || n > cap_ - len_) {
+    overflow_ = true;
+    return;
+  }
+  memcpy(buf_ + len_, p, n);
+  len_ += n;
+}
+
+void SerialPayload::u16(uint16_t v) {
+  uint8_t b[2] = {(uint8_t)v, (uint8_t)(v >> 8)};
+  put(b, 2);
+}
+
+void SerialPayload::u32(uint32_t v) {
+  uint8_t b[4] = {(uint8_t)v, (uint8_t)(v >> 8), (uint8_t)(v >> 16), (uint8_t)(v >> 24)};
+  put(b, 4);
+}
+
+void SerialPayload::f32(float v) {
+  uint32_t bits;
+  memcpy(&bits, &v, sizeof(bits));
+  u32(bits);
+}
+
+void SerialPayload::str(const char* s) {
+  str(s, strlen(s));
+}
+
+bool serialSendText(SerialTx& t, const char* s, size_t n) {
+  if (n > SERIAL_PAYLOAD_MAX) n = SERIAL_PAYLOAD_MAX;
+  return serialSend(t, SP_TEXT, (const uint8_t*)s, n);
+}
+
+bool serialSendWeight(SerialTx& t, uint32_t ms, int32_t raw, float grams, uint8_t opening,
+                      uint8_t flags) {
+  uint8_t buf[14];
+  SerialPayload p(buf, sizeof(buf));
+  p.u32(ms);
+  p.i32(raw);
+  p.f32(grams);
+  p.u8(opening);
+  p.u8(flags);
+  return serialSend(t, SP_WEIGHT, p.data(), p.length());
+}
+
+bool serialSendState(SerialTx& t, uint32_t ms, uint8_t event, uint8_t detail, int8_t slot,
+                     float target, float weight) {
+  uint8_t buf[15];
+  SerialPayload p(buf, sizeof(buf));
+  p.u32(ms);
+  p.u8(event);
+  p.u8(detail);
+  p.i8(slot);
+  p.f32(target);
+  p.f32(weight);
+  return serialSend(t, SP_STATE, p.data(), p.length());
+}
+
+bool serialSendAck(SerialTx& t, uint8_t seq, uint8_t type, uint16_t status, const char* msg) {
+  uint8_t buf[4 + 64];
+  SerialPayload p(buf, sizeof(buf));
+  p.u8(seq);
+  p.u8(type);
+  p.u16(status);
+  size_t n = strlen(msg);
+  p.str(msg, n < 64 ? n : 64);
+  return serialSend(t, SP_ACK, p.data(), p.length());
+}
+
+// ---- Receiving ----
+
+void initSerialRx(SerialRx& r) {
+  memset(&r, 0, sizeof(r));
+}
+
+bool serialRxByte(SerialRx& r, uint8_t b, SerialFrame& out) {
+  if (b != 0) {
+    if (r.len < sizeof(r.buf)) {
+      r.buf[r.len++] = b;
+    } else {
+      r.overflow = true;
+    }
+    return false;
+  }
+
+  // Delimiter: back-to-back ones (between frames) delimit nothing
+  uint16_t n = r.len;
+  bool overflow = r.overflow;
+  r.len = 0;
+  r.overflow = false;
+  if (n == 0 && !overflow) return false;
+  size_t len = overflow ? SIZE_MAX : cobsDecode(r.buf, n);
+  if (len == SIZE_MAX || len < 4) {
+    r.bad++;
+    return false;
+  }
+  uint16_t crc = r.buf[len - 2] | (uint16_t)r.buf[len - 1] << 8;
+  if (crc16Ccitt(r.buf, len - 2) != crc) {
+    r.bad++;
+    return false;
+  }
+  r.frames++;
+  out.type = r.buf[0];
+  out.seq = r.buf[1];
+  out.payload = r.buf + 2;
+  out.len = len - 4;
+  return true;
+}
+
+// Little-endian fields off a payload; reading past the end sets !ok
+struct PayloadReader {
+  const uint8_t* p;
+  size_t         len;
+  size_t         at;
+  bool           ok;
+
+  uint32_t uint(int bytes) {
+    if (at + bytes > len) {
+      ok = false;
+      return 0;
+    }
+    uint32_t v = 0;
+    for (int i = 0; i < bytes; i++) v |= (uint32_t)p[at + i] << (8 * i);
+    at += bytes;
+    return v;
+  }
+  uint8_t u8() { return uint(1); }
+  uint16_t u16() { return uint(2); }
+  float f32() {
+    uint32_t bits = uint(4);
+    float v;
+    memcpy(&v, &bits, sizeof(v));
+    return v;
+  }
+};
+
+bool parseSerialCommand(const SerialFrame& f, SerialCommand& out) {
+  memset(&out, 0, sizeof(out));
+  out.type = f.type;
+  out.seq = f.seq;
+  PayloadReader in = {f.payload, f.len, 0, true};
+  switch (f.type) {
+    case SPC_STREAM:
+      out.every = in.u8();
+      break;
+    case SPC_FEED:
+      out.grams = in.f32();
+      out.mode = in.u8();
+      break;
+    case SPC_REFILL:
+      out.grams = in.f32();
+      break;
+    case SPC_SET_SLOT: {
+      SlotEdit& e = out.slot;
+      out.slotIndex = in.u8();
+      e.hour = in.u8();
+      e.minute = in.u8();
+      e.weight = in.f32();
+      e.has = in.u8();
+      e.days = in.u8();
+      e.everyMin = in.u16();
+      e.untilMin = in.u16();
+      e.splits = in.u8();
+      e.catchUp = in.u8();
+      e.catchUpMin = in.u16();
+      size_t n = in.at < f.len ? f.len - in.at : 0;
+      if (n > CRON_MAX) n = CRON_MAX;
+      memcpy(out.cron, f.payload + in.at, n);
+      out.cron[n] = '\0';
+      e.cron = out.cron;
+      break;
+    }
+    case SPC_STATUS:
+    case SPC_LIVE:
+    case SPC_RESET:
+    case SPC_TEXT:
+      break;
+    default:
+      return false;
+  }
+  return in.ok;
+}
@@ -0,0 +1,180 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "schedule.h"
+
+// ---- Serial protocol ----
+// Binary telemetry and control on the UART, so a bench rig can log every
+// scale reading and drive the feeder without WiFi (tools/feeder_serial.py).
+//
+// A frame on the wire is 0x00, COBS(type, seq, payload, crc), 0x00. COBS
+// leaves no zero byte inside a frame, so frames are found by the delimiters
+// alone and a receiver resyncs on the next 0x00 after line noise or a
+// reset. The CRC is CRC-16/CCITT-FALSE over type, seq and payload,
+// little-endian. Payloads are fixed layouts of little-endian integers and
+// IEEE floats, listed with the message types; a trailing string runs to the
+// end of the payload, without a NUL.
+//
+// The device boots with the plain text console and switches to frames when
+// the first valid command arrives, until SPC_TEXT or a reboot; console lines
+// then go out as SP_TEXT frames. Device frames carry a running seq, so a gap
+// on the host is frames dropped for lack of room; a command's seq is the
+// host's own and comes back in its SP_ACK.
+//
+// Sending never waits for the UART: frames are encoded straight into a
+// caller-owned ring, whole or not at all (counted in `dropped`), and the
+// loop hands the UART only what its TX buffer has room for.
+//
+// Build with -DFEEDER_SERIAL_PROTO=0 to keep the port a text console that
+// ignores input.
+
+#ifndef FEEDER_SERIAL_PROTO
+#define FEEDER_SERIAL_PROTO 1
+#endif
+
+enum SerialMsg : uint8_t {
+  // Device to host
+  SP_TEXT   = 0x01,  // console line
+  SP_WEIGHT = 0x02,  // u32 ms, i32 raw counts, f32 g, u8 gate opening %, u8 SerialWeightFlags
+  SP_STATE  = 0x03,  // u32 ms, u8 SerialEvent, u8 detail, i8 slot (-1 manual), f32 target g,
+                     // f32 bowl g
+  SP_ACK    = 0x04,  // u8 command seq, u8 command type, u16 HTTP status, message
+  SP_STATUS = 0x05,  // CBOR document of GET /api/status (status_binary.h)
+  SP_LIVE   = 0x06,  // CBOR document of GET /api/live
+
+  // Host to device, each answered with an SP_ACK carrying the status and
+  // message the HTTP endpoint would have
+  SPC_STREAM   = 0x80,  // u8 every: SP_WEIGHT on every Nth reading, 0 = off
+  SPC_STATUS   = 0x81,  // SP_STATUS, then the ack
+  SPC_LIVE     = 0x82,  // SP_LIVE, then the ack
+  SPC_FEED     = 0x83,  // POST /api/manual-feed: f32 g, u8 DispenseMode (0xFF = board's)
+  SPC_SET_SLOT = 0x84,  // POST /api/set-slot: u8 index, u8 hour, u8 minute, f32 weight,
+                        // u8 SlotEditField bits, u8 days, u16 every, u16 until,
+                        // u8 splits, u8 catchUp, u16 catchUpMin, cron
+  SPC_RESET    = 0x85,  // POST /api/reset
+  SPC_REFILL   = 0x86,  // POST /api/hopper/refill: f32 g (0 = to capacity)
+  SPC_TEXT     = 0x87   // back to the text console
+};
+
+enum SerialEvent : uint8_t {
+  SE_FEED_START,  // detail: DispenseMode
+  SE_FEED_END,    // detail: FeedCheck that ended it
+  SE_RESET
+};
+
+enum SerialWeightFlags : uint8_t {
+  SW_FEEDING = 0x01
+};
+
+const uint8_t SERIAL_MODE_DEFAULT = 0xFF;  // SPC_FEED: the board's profile
+
+const size_t SERIAL_PAYLOAD_MAX = 1024;
+const size_t SERIAL_RX_MAX      = 128;   // largest command, encoded
+
+// Bytes a frame with `payload` bytes takes on the wire, at most
+constexpr size_t serialFrameMax(size_t payload) {
+  return payload + 4 + (payload + 4) / 254 + 1 + 2;
+}
+
+uint16_t crc16Ccitt(const uint8_t* data, size_t len, uint16_t crc = 0xFFFF);
+
+// Decodes one COBS block (delimiters removed) in place. Returns the decoded
+// length, or SIZE_MAX if it is not valid COBS.
+size_t cobsDecode(uint8_t* buf, size_t len);
+
+// ---- Sending ----
+
+struct SerialTx {
+  uint8_t* buf;       // caller-owned
+  uint32_t cap;
+  uint32_t head;      // free-running; bytes head - tail are pending
+  uint32_t tail;
+  uint8_t  seq;
+  uint32_t frames;
+  uint32_t dropped;   // frames that did not fit
+};
+
+void initSerialTx(SerialTx& t, uint8_t* storage, uint32_t cap);
+
+// Frames and queues one message. False (and counted) when the ring has no
+// room for the whole frame.
+bool serialSend(SerialTx& t, uint8_t type, const uint8_t* payload, size_t len);
+
+inline uint32_t serialTxPending(const SerialTx& t) { return t.head - t.tail; }
+
+// The oldest pending bytes that are contiguous in the ring; hand up to the
+// returned count to the UART, then release what it took.
+size_t serialTxPeek(const SerialTx& t, const uint8_t** data);
+void serialTxConsume(SerialTx& t, size_t n);
+
+// Fixed-layout payload over a caller-owned buffer; once a write doesn't fit
+// ok() is false (same contract as BufWriter).
+class SerialPayload {
+ public:
+  SerialPayload(uint8_t* buf, size_t cap) : buf_(buf), cap_(cap), len_(0), overflow_(false) {}
+
+  void u8(uint8_t v) { put(&v, 1); }
+  void i8(int8_t v) { u8((uint8_t)v); }
+  void u16(uint16_t v);
+  void u32(uint32_t v);
+  void i32(int32_t v) { u32((uint32_t)v); }
+  void f32(float v);
+  void str(const char* s, size_t n) { put(s, n); }
+  void str(const char* s);
+
+  const uint8_t* data() const { return buf_; }
+  size_t length() const { return len_; }
+  bool ok() const { return !overflow_; }
+
+ private:
+  void put(const void* p, size_t n);
+
+  uint8_t* buf_;
+  size_t   cap_;
+  size_t   len_;
+  bool     overflow_;
+};
+
+bool serialSendText(SerialTx& t, const char* s, size_t n);
+bool serialSendWeight(SerialTx& t, uint32_t ms, int32_t raw, float grams, uint8_t opening,
+                      uint8_t flags);
+bool serialSendState(SerialTx& t, uint32_t ms, uint8_t event, uint8_t detail, int8_t slot,
+                     float target, float weight);
+bool serialSendAck(SerialTx& t, uint8_t seq, uint8_t type, uint16_t status, const char* msg);
+
+// ---- Receiving ----
+
+struct SerialFrame {
+  uint8_t        type;
+  uint8_t        seq;
+  const uint8_t* payload;
+  uint16_t       len;
+};
+
+struct SerialRx {
+  uint8_t  buf[SERIAL_RX_MAX];
+  uint16_t len;
+  bool     overflow;  // frame longer than buf: skipped up to its delimiter
+  uint32_t frames;
+  uint32_t bad;       // too long, not COBS, too short or CRC mismatch
+};
+
+void initSerialRx(SerialRx& r);
+
+// Takes one received byte. True when it completed a valid frame; `out`
+// points into `r` and stays valid until the next call.
+bool serialRxByte(SerialRx& r, uint8_t b, SerialFrame& out);
+
+struct SerialCommand {
+  uint8_t  type;       // SerialMsg
+  uint8_t  seq;
+  uint8_t  every;      // SPC_STREAM
+  float    grams;      // SPC_FEED, SPC_REFILL
+  uint8_t  mode;       // SPC_FEED
+  uint8_t  slotIndex;  // SPC_SET_SLOT
+  SlotEdit slot;       // slot.cron points into `cron`
+  char     cron[CRON_MAX + 1];  // one longer, so an overlong one is still rejected
+};
+
+// False for unknown types and payloads too short for their type.
+bool parseSerialCommand(const SerialFrame& f, SerialCommand& out);
@@ -0,0 +1,26 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// ---- SHA-256 ----
+// Plain FIPS 180-4, so OTA images are checked the same way on the device
+// and in the host tests; it keeps well ahead of the WiFi.
+
+const size_t SHA256_BYTES = 32;
+
+struct Sha256 {
+  uint32_t state[8];
+  uint64_t length;     // bytes hashed so far
+  uint8_t  block[64];
+  uint8_t  used;       // bytes waiting in block
+};
+
+void sha256Init(Sha256& s);
+void sha256Update(Sha256& s, const void* data, size_t len);
+void sha256Final(Sha256& s, uint8_t out[SHA256_BYTES]);
+
+// Exactly 2 * bytes hex digits (either case) to bytes, e.g. POST /api/ota?sig=
+bool parseHex(const char* hex, uint8_t* out, size_t bytes);
+inline bool parseSha256Hex(const char* hex, uint8_t out[SHA256_BYTES]) {
+  return parseHex(hex, out, SHA256_BYTES);
+}
@@ -0,0 +1,147 @@
+#include "status_binary.h"
+#include <math.h>
+
+static int32_t decigrams(float g) {
+  return (int32_t)lroundf(g * 10.0f);
+}
+
+static void writeVersion(BinWriter& w, const StatusVersions& v) {
+  char token[STATUS_VERSION_MAX];
+  size_t n = formatStatusVersion(token, sizeof(token), v);
+  w.key(SK_VERSION);
+  w.str(token, n);
+}
+
+// ---- Sections ----
+
+static int stateFieldCount(const StatusView& s) {
+  return s.hopper ? 3 : 2;
+}
+
+static void writeStateFields(BinWriter& w, const StatusView& s) {
+  w.key(SK_FEEDING);
+  w.boolean(s.feedingActive);
+  w.key(SK_NEXT);
+  if (s.nextFeed == NO_FEEDING_TIME) {
+    w.null();
+  } else {
+    w.uint(s.nextFeed);
+  }
+
+  if (!s.hopper) return;
+  const HopperState& h = *s.hopper;
+  w.key(SK_HOPPER);
+  if (!h.known) {
+    w.map(1);
+    w.key(HK_KNOWN);
+    w.boolean(false);
+    return;
+  }
+  const HopperForecast& f = *s.hopperForecast;
+  w.map(6);
+  w.key(HK_KNOWN);
+  w.boolean(true);
+  w.key(HK_REMAINING);
+  w.sint(decigrams(h.remainingG));
+  w.key(HK_CAPACITY);
+  w.uint((uint32_t)h.capacityG);
+  w.key(HK_FEEDS_LEFT);
+  w.uint(f.feedsLeft);
+  w.key(HK_EMPTY_AT);
+  if (f.emptyAt == NO_FEEDING_TIME) {
+    w.null();
+  } else {
+    w.uint(f.emptyAt);
+  }
+  w.key(HK_LOW);
+  w.boolean(f.low);
+}
+
+static void writeSlotsField(BinWriter& w, const StatusView& s) {
+  w.key(SK_SLOTS);
+  w.array(s.slotCount);
+  for (int i = 0; i < s.slotCount; i++) {
+    const FeedingSlot& slot = s.slots[i];
+    bool days = slot.days != ALL_DAYS;
+    bool every = slot.everyMin != 0;
+    bool until = slot.untilMin != 0;
+    bool splits = slot.splits > 1;
+    bool cron = slot.cron[0] != '\0';
+    bool catchUp = slot.catchUp != CATCHUP_LATE;
+    bool catchUpMin = slot.catchUpMin != CATCHUP_DEFAULT_MIN;
+
+    w.map(4 + days + every + until + splits + cron + catchUp + catchUpMin);
+    w.key(SLK_ACTIVE);
+    w.boolean(slot.active);
+    w.key(SLK_HOUR);
+    w.uint(slot.hour);
+    w.key(SLK_MINUTE);
+    w.uint(slot.minute);
+    w.key(SLK_WEIGHT);
+    w.sint((int32_t)slot.weight);
+    if (days)       { w.key(SLK_DAYS);        w.uint(slot.days); }
+    if (every)      { w.key(SLK_EVERY);       w.uint(slot.everyMin); }
+    if (until)      { w.key(SLK_UNTIL);       w.uint(slot.untilMin); }
+    if (splits)     { w.key(SLK_SPLITS);      w.uint(slot.splits); }
+    if (cron)       { w.key(SLK_CRON);        w.str(slot.cron); }
+    if (catchUp)    { w.key(SLK_CATCHUP);     w.uint(slot.catchUp); }
+    if (catchUpMin) { w.key(SLK_CATCHUP_MIN); w.uint(slot.catchUpMin); }
+  }
+}
+
+static void writeHistoryField(BinWriter& w, const StatusView& s) {
+  int used = 0;
+  for (int i = 0; i < s.logCount; i++) used += s.log[i].used;
+
+  w.key(SK_HISTORY);
+  w.array(used);
+  for (int i = 0; i < s.logCount; i++) {
+    const FeedLogEntry& e = s.log[i];
+    if (!e.used) continue;
+    w.array(4);
+    w.uint(e.hour * 60 + e.minute);
+    w.uint(e.manual ? 0 : e.slotIndex + 1);
+    w.sint((int32_t)e.target);
+    w.sint((int32_t)e.finalWeight);
+  }
+}
+
+// ---- Documents ----
+
+size_t writeStatusBinary(uint8_t* out, size_t cap, const StatusView& s, WireFormat f) {
+  BinWriter w(out, cap, f);
+  w.map(1 + stateFieldCount(s) + 2);
+  w.key(SK_WEIGHT);
+  w.sint(decigrams(s.weight));
+  writeStateFields(w, s);
+  writeSlotsField(w, s);
+  writeHistoryField(w, s);
+  return w.ok() ? w.length() : 0;
+}
+
+size_t writeStatusDeltaBinary(uint8_t* out, size_t cap, const StatusView& s,
+                              const StatusVersions& v, uint32_t since, WireFormat f) {
+  bool state = v.state > since;
+  bool schedule = v.schedule > since;
+  bool history = v.history > since;
+
+  BinWriter w(out, cap, f);
+  w.map(1 + (state ? stateFieldCount(s) : 0) + schedule + history);
+  writeVersion(w, v);
+  if (state) writeStateFields(w, s);
+  if (schedule) writeSlotsField(w, s);
+  if (history) writeHistoryField(w, s);
+  return w.ok() ? w.length() : 0;
+}
+
+size_t writeLiveBinary(uint8_t* out, size_t cap, float weight, bool feedingActive,
+                       const StatusVersions& v, WireFormat f) {
+  BinWriter w(out, cap, f);
+  w.map(3);
+  w.key(SK_WEIGHT);
+  w.sint(decigrams(weight));
+  w.key(SK_FEEDING);
+  w.boolean(feedingActive);
+  writeVersion(w, v);
+  return w.ok() ? w.length() : 0;
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "bin_writer.h"
+#include "status_json.h"
+
+// CBOR / MessagePack variants of the /api/status and /api/live documents.
+//
+// Same content as the JSON documents, but maps are keyed by small integers
+// instead of names and numbers are integers in the units below, so a poll
+// carries no key text. Sections are optional exactly as in JSON.
+
+enum StatusKey : uint8_t {
+  SK_VERSION = 0,  // "version": token string as in JSON
+  SK_WEIGHT  = 1,  // "weight": int, 0.1 g
+  SK_FEEDING = 2,  // "feedingActive": bool
+  SK_NEXT    = 3,  // "nextTime": Unix time of the next feed, or null
+  SK_HOPPER  = 4,  // "hopper": map of HopperKey
+  SK_SLOTS   = 5,  // "slots": array of maps of SlotKey
+  SK_HISTORY = 6   // "history": array of [minute of day, slot (0 = manual),
+                   //            target g, final g], newest first
+};
+
+enum SlotKey : uint8_t {
+  SLK_ACTIVE      = 0,
+  SLK_HOUR        = 1,
+  SLK_MINUTE      = 2,
+  SLK_WEIGHT      = 3,   // g
+  // Only when they differ from "every day at hour:minute", as in JSON
+  SLK_DAYS        = 4,
+  SLK_EVERY       = 5,
+  SLK_UNTIL       = 6,
+  SLK_SPLITS      = 7,
+  SLK_CRON        = 8,
+  SLK_CATCHUP     = 9,   // CatchUpPolicy number
+  SLK_CATCHUP_MIN = 10
+};
+
+enum HopperKey : uint8_t {
+  HK_KNOWN      = 0,  // only key present while false
+  HK_REMAINING  = 1,  // 0.1 g
+  HK_CAPACITY   = 2,  // g
+  HK_FEEDS_LEFT = 3,
+  HK_EMPTY_AT   = 4,  // Unix time or null
+  HK_LOW        = 5
+};
+
+// Return the length, or 0 if the document did not fit. A binary document
+// is never larger than its JSON counterpart, so the JSON capacities apply.
+size_t writeStatusBinary(uint8_t* out, size_t cap, const StatusView& s, WireFormat f);
+size_t writeStatusDeltaBinary(uint8_t* out, size_t cap, const StatusView& s,
+                              const StatusVersions& v, uint32_t since, WireFormat f);
+size_t writeLiveBinary(uint8_t* out, size_t cap, float weight, bool feedingActive,
+                       const StatusVersions& v, WireFormat f);
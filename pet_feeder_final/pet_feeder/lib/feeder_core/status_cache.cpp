@@ -0,0 +1,89 @@
+#include "status_cache.h"
+#include <math.h>
+#include <stdio.h>
+
+void initStatusCache(StatusCache& c, char* storage, size_t entryCap) {
+  for (int i = 0; i < STATUS_CACHE_ENTRIES; i++) {
+    StatusCacheEntry& e = c.entries[i];
+    e.buf = storage + i * entryCap;
+    e.len = 0;
+    e.clock = 0;
+    e.sections = 0;
+    e.format = WIRE_JSON;
+    e.weightKey = 0;
+    e.lastUse = 0;
+  }
+  c.entryCap = entryCap;
+  c.uses = 0;
+  c.hits = 0;
+  c.misses = 0;
+  c.etag[0] = '\0';
+  c.etagClock = 0;
+}
+
+uint8_t statusSectionsSince(const StatusVersions& v, uint32_t since) {
+  uint8_t sections = 0;
+  if (v.state > since)    sections |= SECTION_STATE;
+  if (v.schedule > since) sections |= SECTION_SCHEDULE;
+  if (v.history > since)  sections |= SECTION_HISTORY;
+  return sections;
+}
+
+const char* statusCacheEtag(StatusCache& c, const StatusVersions& v) {
+  if (c.etag[0] == '\0' || c.etagClock != v.clock) {
+    char token[STATUS_VERSION_MAX];
+    formatStatusVersion(token, sizeof(token), v);
+    snprintf(c.etag, sizeof(c.etag), "\"%s\"", token);
+    c.etagClock = v.clock;
+  }
+  return c.etag;
+}
+
+// Entry for the key, or the least recently used one (len 0) to render into
+static StatusCacheEntry& lookup(StatusCache& c, uint32_t clock, uint8_t sections,
+                                WireFormat format, int32_t weightKey) {
+  StatusCacheEntry* victim = &c.entries[0];
+  for (int i = 0; i < STATUS_CACHE_ENTRIES; i++) {
+    StatusCacheEntry& e = c.entries[i];
+    if (e.len > 0 && e.clock == clock && e.sections == sections && e.format == format &&
+        e.weightKey == weightKey) {
+      c.hits++;
+      e.lastUse = ++c.uses;
+      return e;
+    }
+    if (e.lastUse < victim->lastUse) victim = &e;
+  }
+  c.misses++;
+  victim->len = 0;
+  victim->clock = clock;
+  victim->sections = sections;
+  victim->format = format;
+  victim->weightKey = weightKey;
+  victim->lastUse = ++c.uses;
+  return *victim;
+}
+
+const StatusCacheEntry* statusCacheDelta(StatusCache& c, const StatusView& s,
+                                         const StatusVersions& v, uint32_t since,
+                                         WireFormat f) {
+  StatusCacheEntry& e = lookup(c, v.clock, statusSectionsSince(v, since), f, 0);
+  if (e.len == 0) {
+    e.len = f == WIRE_JSON
+                ? writeStatusDelta(e.buf, c.entryCap, s, v, since)
+                : writeStatusDeltaBinary((uint8_t*)e.buf, c.entryCap, s, v, since, f);
+    if (e.len == 0) return nullptr;
+  }
+  return &e;
+}
+
+const StatusCacheEntry* statusCacheFull(StatusCache& c, const StatusView& s,
+                                        const StatusVersions& v, WireFormat f) {
+  int32_t weightKey = (int32_t)lroundf(s.weight * 10.0f);
+  StatusCacheEntry& e = lookup(c, v.clock, SECTION_FULL, f, weightKey);
+  if (e.len == 0) {
+    e.len = f == WIRE_JSON ? writeStatusJson(e.buf, c.entryCap, s)
+                           : writeStatusBinary((uint8_t*)e.buf, c.entryCap, s, f);
+    if (e.len == 0) return nullptr;
+  }
+  return &e;
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "status_json.h"
+#include "status_binary.h"
+
+// Rendered /api/status documents, shared by every client.
+//
+// A delta document depends only on the version clock and on which sections
+// are newer than the client's `since`, so all dashboards polling after the
+// same change get the same bytes: the first request renders them into a
+// preallocated entry and the rest copy them out with a known length. The
+// legacy full document also carries the live weight and is keyed on it too.
+// Each wire format is cached separately. Entries are replaced least recently
+// used; nothing is allocated.
+
+const int STATUS_CACHE_ENTRIES = 3;  // all sections, latest change, full doc
+
+enum StatusSection : uint8_t {
+  SECTION_STATE    = 1,
+  SECTION_SCHEDULE = 2,
+  SECTION_HISTORY  = 4,
+  SECTION_FULL     = 0x80  // writeStatusJson document
+};
+
+struct StatusCacheEntry {
+  char*    buf;
+  size_t   len;        // 0 = empty
+  uint32_t clock;      // StatusVersions.clock it was rendered at
+  uint8_t  sections;
+  uint8_t  format;     // WireFormat
+  int32_t  weightKey;  // full document: weight in 0.1 g as rendered
+  uint32_t lastUse;
+};
+
+struct StatusCache {
+  StatusCacheEntry entries[STATUS_CACHE_ENTRIES];
+  size_t   entryCap;
+  uint32_t uses;
+  uint32_t hits;
+  uint32_t misses;
+
+  // Quoted ETag for etagClock, re-formatted only when the version moves
+  char     etag[STATUS_VERSION_MAX + 2];
+  uint32_t etagClock;
+};
+
+// `storage` holds STATUS_CACHE_ENTRIES * entryCap bytes.
+void initStatusCache(StatusCache& c, char* storage, size_t entryCap);
+
+// Sections a client holding `since` needs.
+uint8_t statusSectionsSince(const StatusVersions& v, uint32_t since);
+
+const char* statusCacheEtag(StatusCache& c, const StatusVersions& v);
+
+// Cached writeStatusDelta / writeStatusJson output (or their binary
+// counterparts), rendered on a miss. Returns nullptr if the document does
+// not fit an entry.
+const StatusCacheEntry* statusCacheDelta(StatusCache& c, const StatusView& s,
+                                         const StatusVersions& v, uint32_t since,
+                                         WireFormat f = WIRE_JSON);
+const StatusCacheEntry* statusCacheFull(StatusCache& c, const StatusView& s,
+                                        const StatusVersions& v, WireFormat f = WIRE_JSON);
@@ -0,0 +1,344 @@
+#include "status_json.h"
+#include "buf_writer.h"
+#include "feeder_time.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// ---- Sections ----
+
+static void writeStateFields(BufWriter& w, const StatusView& s) {
+  w.printf("\"feedingActive\":%s,", s.feedingActive ? "true" : "false");
+
+  if (s.nextFeed == NO_FEEDING_TIME) {
+    w.print("\"nextTime\":\"None\"");
+  } else {
+    w.printf("\"nextTime\":\"%02d:%02d\"", hourOf(s.nextFeed), minuteOf(s.nextFeed));
+  }
+
+  // Level and forecast; "emptyAt" is Unix time, null beyond the horizon
+  if (s.hopper) {
+    const HopperState& h = *s.hopper;
+    if (!h.known) {
+      w.print(",\"hopper\":{\"known\":false}");
+    } else {
+      const HopperForecast& f = *s.hopperForecast;
+      w.printf(",\"hopper\":{\"known\":true,\"remaining\":%.1f,\"capacity\":%.0f,"
+               "\"feedsLeft\":%u,\"emptyAt\":",
+               h.remainingG, h.capacityG, f.feedsLeft);
+      if (f.emptyAt == NO_FEEDING_TIME) {
+        w.print("null");
+      } else {
+        w.printf("%lu", (unsigned long)f.emptyAt);
+      }
+      w.printf(",\"low\":%s}", f.low ? "true" : "false");
+    }
+  }
+}
+
+static void writeSlotsField(BufWriter& w, const StatusView& s) {
+  w.print("\"slots\":[");
+  for (int i = 0; i < s.slotCount; i++) {
+    const FeedingSlot& slot = s.slots[i];
+    w.printf("{\"active\":%s,\"hour\":%d,\"minute\":%d,\"weight\":%d",
+             slot.active ? "true" : "false", slot.hour, slot.minute, (int)slot.weight);
+    // Recurrence fields only when they differ from "every day at hour:minute"
+    if (slot.days != ALL_DAYS) w.printf(",\"days\":%u", slot.days);
+    if (slot.everyMin)        w.printf(",\"every\":%u", slot.everyMin);
+    if (slot.untilMin)        w.printf(",\"until\":%u", slot.untilMin);
+    if (slot.splits > 1)      w.printf(",\"splits\":%u", slot.splits);
+    if (slot.cron[0])         w.printf(",\"cron\":\"%s\"", slot.cron);
+    if (slot.catchUp != CATCHUP_LATE) {
+      w.printf(",\"catchUp\":\"%s\"", catchUpPolicyName(slot.catchUp));
+    }
+    if (slot.catchUpMin != CATCHUP_DEFAULT_MIN) w.printf(",\"catchUpMin\":%u", slot.catchUpMin);
+    w.print("}");
+    if (i < s.slotCount - 1) w.print(",");
+  }
+  w.print("]");
+}
+
+// history array, newest first
+static void writeHistoryField(BufWriter& w, const StatusView& s) {
+  w.print("\"history\":[");
+  for (int i = 0; i < s.logCount; i++) {
+    const FeedLogEntry& e = s.log[i];
+    if (!e.used) continue;
+
+    w.printf("{\"time\":\"%02d:%02d\",", e.hour, e.minute);
+    if (e.manual) {
+      w.print("\"type\":\"Manual\",");
+    } else {
+      w.printf("\"type\":\"Slot %d\",", e.slotIndex + 1);
+    }
+    w.printf("\"target\":%d,\"final\":%d}", (int)e.target, (int)e.finalWeight);
+    if (i < s.logCount - 1) w.print(",");
+  }
+  w.print("]");
+}
+
+// ---- Documents ----
+
+size_t writeStatusJson(char* out, size_t cap, const StatusView& s) {
+  BufWriter w(out, cap);
+
+  w.printf("{\"weight\":%.1f,", s.weight);
+  writeStateFields(w, s);
+  w.print(",");
+  writeSlotsField(w, s);
+  w.print(",");
+  writeHistoryField(w, s);
+  w.print("}");
+
+  return w.ok() ? w.length() : 0;
+}
+
+size_t writeStatusDelta(char* out, size_t cap, const StatusView& s,
+                        const StatusVersions& v, uint32_t since) {
+  BufWriter w(out, cap);
+  char token[STATUS_VERSION_MAX];
+  formatStatusVersion(token, sizeof(token), v);
+
+  w.printf("{\"version\":\"%s\"", token);
+  if (v.state > since) {
+    w.print(",");
+    writeStateFields(w, s);
+  }
+  if (v.schedule > since) {
+    w.print(",");
+    writeSlotsField(w, s);
+  }
+  if (v.history > since) {
+    w.print(",");
+    writeHistoryField(w, s);
+  }
+  w.print("}");
+
+  return w.ok() ? w.length() : 0;
+}
+
+size_t writeLiveJson(char* out, size_t cap, float weight, bool feedingActive,
+                     const StatusVersions& v) {
+  BufWriter w(out, cap);
+  char token[STATUS_VERSION_MAX];
+  formatStatusVersion(token, sizeof(token), v);
+
+  w.printf("{\"weight\":%.1f,\"feedingActive\":%s,\"version\":\"%s\"}",
+           weight, feedingActive ? "true" : "false", token);
+  return w.ok() ? w.length() : 0;
+}
+
+size_t writeQueueJson(char* out, size_t cap, const FeedQueue& q, bool feedingActive,
+                      uint32_t nowMs) {
+  BufWriter w(out, cap);
+  w.printf("{\"feedingActive\":%s,\"depth\":%d,\"capacity\":%d,"
+           "\"oldestWaitMs\":%lu,\"lastWaitMs\":%lu,\"maxWaitMs\":%lu,"
+           "\"coalesced\":%lu,\"expired\":%lu,\"dropped\":%lu,\"items\":[",
+           feedingActive ? "true" : "false", q.count, q.capacity,
+           (unsigned long)oldestFeedWaitMs(q, nowMs), (unsigned long)q.lastWaitMs,
+           (unsigned long)q.maxWaitMs, (unsigned long)q.coalesced,
+           (unsigned long)q.expired, (unsigned long)q.dropped);
+
+  // Dispatch order: highest priority first, arrival order within a priority
+  bool first = true;
+  for (int src = FEED_SRC_COUNT - 1; src >= 0; --src) {
+    for (int i = 0; i < q.count; ++i) {
+      const FeedCommand& c = q.items[i];
+      if (c.source != src) continue;
+      w.printf("%s{\"source\":\"%s\",\"slot\":%d,\"amount\":%d,\"merged\":%u,\"waitMs\":%lu}",
+               first ? "" : ",", feedSourceName(c.source), c.slotIndex + 1,
+               (int)c.amount, c.merged, (unsigned long)(nowMs - c.enqueuedMs));
+      first = false;
+    }
+  }
+  w.print("]}");
+  return w.ok() ? w.length() : 0;
+}
+
+size_t writeLoopJson(char* out, size_t cap, const LoopStats& s) {
+  BufWriter w(out, cap);
+  w.printf("{\"periods\":%lu,\"minUs\":%lu,\"meanUs\":%lu,\"p50Us\":%lu,"
+           "\"p99Us\":%lu,\"maxUs\":%lu}",
+           (unsigned long)s.periods, (unsigned long)s.minUs, (unsigned long)loopMeanUs(s),
+           (unsigned long)loopPercentileUs(s, 0.50f), (unsigned long)loopPercentileUs(s, 0.99f),
+           (unsigned long)s.maxUs);
+  return w.ok() ? w.length() : 0;
+}
+
+size_t writeAdmissionJson(char* out, size_t cap, const Admission& a) {
+  int clients = 0;
+  for (int i = 0; i < ADMISSION_CLIENTS; i++) {
+    if (a.clients[i].lastUse != 0) clients++;
+  }
+
+  BufWriter w(out, cap);
+  w.printf("{\"enabled\":%s,\"ratePerSec\":%u,\"burst\":%u,\"tickMs\":%lu,"
+           "\"tickBudget\":%u,\"clients\":%d,\"evictions\":%lu,\"lanes\":{",
+           FEEDER_ADMISSION ? "true" : "false", a.limits.ratePerSec, a.limits.burst,
+           (unsigned long)ADMISSION_TICK_MS, a.limits.tickBudget, clients,
+           (unsigned long)a.evictions);
+  for (int lane = 0; lane < LANE_COUNT; lane++) {
+    w.printf("%s\"%s\":{\"admitted\":%lu,\"rate\":%lu,\"busy\":%lu}",
+             lane ? "," : "", admissionLaneName((AdmissionLane)lane),
+             (unsigned long)a.admitted[lane], (unsigned long)a.rejectedRate[lane],
+             (unsigned long)a.rejectedBusy[lane]);
+  }
+  w.print("}}");
+  return w.ok() ? w.length() : 0;
+}
+
+size_t writeFlowJson(char* out, size_t cap, const FlowStats& s, const FeedLimits& current) {
+  BufWriter w(out, cap);
+  w.printf("{\"feeds\":%u,\"rate\":%.2f,\"rateSd\":%.2f,\"p10Rate\":%.2f,"
+           "\"gapMs\":%lu,\"gapSdMs\":%lu,\"noise\":%.2f,\"limits\":{\"timeoutMs\":%lu,"
+           "\"stuckWindowMs\":%lu,\"minIncrease\":%.2f}}",
+           s.feeds, s.rateMean, sqrtf(s.rateVar), flowP10Rate(s),
+           (unsigned long)lroundf(s.gapMeanMs), (unsigned long)lroundf(sqrtf(s.gapVar)),
+           sqrtf(s.noiseVar), (unsigned long)current.timeoutMs,
+           (unsigned long)current.stuckWindowMs, current.minIncreaseG);
+  return w.ok() ? w.length() : 0;
+}
+
+// ---- Versions ----
+
+void initStatusVersions(StatusVersions& v, uint16_t bootId) {
+  v.boot = bootId;
+  v.clock = 1;
+  v.state = v.schedule = v.history = 1;
+}
+
+size_t formatStatusVersion(char* out, size_t cap, const StatusVersions& v) {
+  int n = snprintf(out, cap, "%04x-%lu", v.boot, (unsigned long)v.clock);
+  return n < 0 || (size_t)n >= cap ? 0 : n;
+}
+
+bool parseStatusVersion(const char* token, const StatusVersions& v, uint32_t& since) {
+  if (!token) return false;
+  if (*token == 'W' && token[1] == '/') token += 2;  // weak validator
+  if (*token == '"') token++;
+
+  char* end;
+  unsigned long boot = strtoul(token, &end, 16);
+  if (end == token || *end != '-' || boot != v.boot) return false;
+
+  const char* num = end + 1;
+  unsigned long n = strtoul(num, &end, 10);
+  if (end == num || (*end != '\0' && *end != '"')) return false;
+  if (n > v.clock) return false;  // not from this run
+
+  since = n;
+  return true;
+}
+
+size_t writeSerialJson(char* out, size_t cap, bool binary, const SerialTx& tx,
+                       const SerialRx& rx) {
+  BufWriter w(out, cap);
+  w.printf("{\"enabled\":%s,\"binary\":%s,\"txFrames\":%lu,\"txDropped\":%lu,"
+           "\"txPending\":%lu,\"txCapacity\":%lu,\"rxFrames\":%lu,\"rxBad\":%lu}",
+           FEEDER_SERIAL_PROTO ? "true" : "false", binary ? "true" : "false",
+           (unsigned long)tx.frames, (unsigned long)tx.dropped,
+           (unsigned long)serialTxPending(tx), (unsigned long)tx.cap,
+           (unsigned long)rx.frames, (unsigned long)rx.bad);
+  return w.ok() ? w.length() : 0;
+}
+
+size_t writeOtaJson(char* out, size_t cap, const char* running, const char* next,
+                    const OtaTrial& trial, const OtaReport& last) {
+  BufWriter w(out, cap);
+  w.printf("{\"running\":\"%s\",\"next\":\"%s\",\"trial\":%s,\"trialBoots\":%u,"
+           "\"last\":{\"kind\":\"%s\",\"result\":\"%s\",\"transferBytes\":%lu,"
+           "\"imageBytes\":%lu,\"ms\":%lu}}",
+           running, next, trial.active ? "true" : "false", (unsigned)trial.boots,
+           otaImageKindName(last.kind), otaResultText(last.result),
+           (unsigned long)last.transferBytes, (unsigned long)last.imageBytes,
+           (unsigned long)last.ms);
+  return w.ok() ? w.length() : 0;
+}
+
+size_t writeCalibrationJson(char* out, size_t cap, const ScaleCal& cal, const CalCapture& c,
+                            const ZeroTracker& z) {
+  BufWriter w(out, cap);
+  w.printf("{\"offset\":%ld,\"countsPerGram\":%.2f,\"spanTime\":%lu,"
+           "\"capture\":{\"step\":\"%s\",\"result\":\"%s\",\"massG\":%.1f},"
+           "\"zeroTracking\":{\"steps\":%lu,\"trackedG\":%.2f}}",
+           (long)cal.offset, cal.countsPerGram, (unsigned long)cal.spanTime,
+           calStepName(c.lastStep), c.lastStep == CAL_NONE ? "none" : calResultName(c.result),
+           c.massG, (unsigned long)z.steps, z.trackedG);
+  return w.ok() ? w.length() : 0;
+}
+
+// ---- Rollups ----
+
+static void writeDate(BufWriter& w, uint32_t t) {
+  int y, m, d;
+  civilDate(t, y, m, d);
+  w.printf("\"%04d-%02d-%02d\"", y, m, d);
+}
+
+static void writePeriodTotals(BufWriter& w, const PeriodRollup* p) {
+  w.printf("\"feeds\":%u,\"aborts\":%u,\"grams\":%.1f", p ? p->feeds : 0,
+           p ? p->aborts : 0, p ? p->dispensedG : 0.0f);
+}
+
+static void writeOvershoot(BufWriter& w, const char* name, const RunningStat& s) {
+  w.printf(",\"%s\":{\"n\":%lu,\"mean\":%.2f,\"var\":%.2f}", name, (unsigned long)s.n,
+           s.mean, runningVariance(s));
+}
+
+static void writeSlotRollup(BufWriter& w, const SlotRollup& s, uint32_t now) {
+  w.printf("\"feeds\":%u,\"aborts\":%u,\"grams\":%.1f", s.feeds, s.aborts, s.dispensedG);
+  writeOvershoot(w, "overshoot", s.allTime);
+  writeOvershoot(w, "weekOvershoot", slotWeekOvershoot(s, now));
+}
+
+size_t writeStatsJson(char* out, size_t cap, const FeedRollups& r, int slotCount, uint32_t now) {
+  BufWriter w(out, cap);
+  w.print("{\"date\":");
+  writeDate(w, now);
+  w.print(",\"today\":{");
+  writePeriodTotals(w, rollupDayAt(r, now));
+  w.print("},\"thisWeek\":{\"from\":");
+  writeDate(w, rollupWeekStart(rollupWeek(now)));
+  w.print(",");
+  writePeriodTotals(w, rollupWeekAt(r, now));
+
+  w.print("},\"days\":[");
+  bool first = true;
+  for (int i = 0; i < FEED_ROLLUP_DAYS && now >= i * SECS_PER_DAY; i++) {
+    uint32_t t = now - i * SECS_PER_DAY;
+    const PeriodRollup* p = rollupDayAt(r, t);
+    if (!p) continue;
+    w.print(first ? "{\"date\":" : ",{\"date\":");
+    writeDate(w, t);
+    w.print(",");
+    writePeriodTotals(w, p);
+    w.print("}");
+    first = false;
+  }
+
+  w.print("],\"weeks\":[");
+  first = true;
+  for (int i = 0; i < FEED_ROLLUP_WEEKS && now >= i * 7 * SECS_PER_DAY; i++) {
+    uint32_t t = now - i * 7 * SECS_PER_DAY;
+    const PeriodRollup* p = rollupWeekAt(r, t);
+    if (!p) continue;
+    w.print(first ? "{\"from\":" : ",{\"from\":");
+    writeDate(w, rollupWeekStart(p->period));
+    w.print(",");
+    writePeriodTotals(w, p);
+    w.print("}");
+    first = false;
+  }
+
+  w.print("],\"slots\":[");
+  int rows = slotCount < FEED_ROLLUP_SLOTS ? slotCount : FEED_ROLLUP_SLOTS;
+  for (int i = 0; i < rows; i++) {
+    w.printf("%s{\"slot\":%d,", i ? "," : "", i + 1);
+    writeSlotRollup(w, r.slots[i], now);
+    w.print("}");
+  }
+  w.print("],\"manual\":{");
+  writeSlotRollup(w, r.slots[FEED_ROLLUP_MANUAL], now);
+  w.print("}}");
+  return w.ok() ? w.length() : 0;
+}
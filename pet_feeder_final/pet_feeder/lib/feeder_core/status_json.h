@@ -0,0 +1,125 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "schedule.h"
+#include "feed_log.h"
+#include "feed_queue.h"
+#include "loop_stats.h"
+#include "hopper.h"
+#include "admission.h"
+#include "flow_stats.h"
+#include "serial_proto.h"
+#include "ota_image.h"
+#include "feed_rollup.h"
+#include "scale_cal.h"
+
+// Everything /api/status reports, gathered by the caller.
+struct StatusView {
+  float               weight;
+  bool                feedingActive;
+  uint32_t            nextFeed;     // Unix time or NO_FEEDING_TIME
+  const FeedingSlot*  slots;
+  int                 slotCount;
+  const FeedLogEntry* log;
+  int                 logCount;
+  const HopperState*    hopper;          // nullptr: no "hopper" field
+  const HopperForecast* hopperForecast;
+};
+
+// Per-section change counters. Every change takes the next value of `clock`,
+// so a client holding version N needs exactly the sections newer than N.
+// Versions are only meaningful within one boot; the token a client sees is
+// "<boot>-<clock>" so tokens from before a reboot are recognised as stale.
+struct StatusVersions {
+  uint16_t boot;
+  uint32_t clock;     // newest version handed out
+  uint32_t state;     // feedingActive, nextTime, hopper
+  uint32_t schedule;  // slots
+  uint32_t history;   // feed log
+};
+
+const size_t STATUS_VERSION_MAX = 16;  // "ffff-4294967295"
+
+void initStatusVersions(StatusVersions& v, uint16_t bootId);
+inline void bumpStatusVersion(StatusVersions& v, uint32_t& section) { section = ++v.clock; }
+inline bool statusChangedSince(const StatusVersions& v, uint32_t since) { return v.clock > since; }
+
+size_t formatStatusVersion(char* out, size_t cap, const StatusVersions& v);
+
+// Accepts a token as sent in ?since= or If-None-Match (quotes and W/ allowed).
+// Returns false for malformed tokens or ones from another boot; the caller
+// then answers with every section.
+bool parseStatusVersion(const char* token, const StatusVersions& v, uint32_t& since);
+
+// Worst-case document size for the given capacities.
+constexpr size_t statusJsonCapacity(int slotCount, int logCount) {
+  return 224 + slotCount * 208 + logCount * 80;
+}
+
+// Renders the full /api/status document into `out`. Returns the length, or
+// 0 if it did not fit.
+size_t writeStatusJson(char* out, size_t cap, const StatusView& s);
+
+// {"version":...} plus only the sections that changed after `since`
+// (no weight; that comes from the live document).
+size_t writeStatusDelta(char* out, size_t cap, const StatusView& s,
+                        const StatusVersions& v, uint32_t since);
+
+// Small fixed-shape document for high-rate polling:
+// {"weight":12.3,"feedingActive":false,"version":"1a2b-17"}
+const size_t LIVE_JSON_MAX = 80;
+size_t writeLiveJson(char* out, size_t cap, float weight, bool feedingActive,
+                     const StatusVersions& v);
+
+// /api/queue: depth, wait times and counters, then the waiting commands in
+// the order they will run ("slot" is 1-based as on the LCD, 0 for manual/API).
+constexpr size_t queueJsonCapacity(int queueCapacity) {
+  return 192 + queueCapacity * 96;
+}
+size_t writeQueueJson(char* out, size_t cap, const FeedQueue& q, bool feedingActive,
+                      uint32_t nowMs);
+
+// /api/loop: control-loop period statistics in microseconds.
+const size_t LOOP_JSON_MAX = 160;
+size_t writeLoopJson(char* out, size_t cap, const LoopStats& s);
+
+// /api/admission: limits, clients tracked and per-lane admitted / rejected
+// counts ("rate": over the client's bucket, "busy": over the tick budget).
+const size_t ADMISSION_JSON_MAX = 384;
+size_t writeAdmissionJson(char* out, size_t cap, const Admission& a);
+
+// /api/flow: learned flow statistics (rates in g/s, noise as one reading's
+// standard deviation in g) and the limits in use for the current or last
+// feed.
+const size_t FLOW_JSON_MAX = 256;
+size_t writeFlowJson(char* out, size_t cap, const FlowStats& s, const FeedLimits& current);
+
+// /api/serial: binary protocol state and frame counters (serial_proto.h);
+// "txDropped" frames found the TX ring full, "rxBad" ones failed to decode.
+const size_t SERIAL_JSON_MAX = 192;
+size_t writeSerialJson(char* out, size_t cap, bool binary, const SerialTx& tx,
+                       const SerialRx& rx);
+
+// /api/ota: the app slots, whether the running image is still on trial, and
+// the last update ("transferBytes" downloaded for "imageBytes" written).
+const size_t OTA_JSON_MAX = 256;
+size_t writeOtaJson(char* out, size_t cap, const char* running, const char* next,
+                    const OtaTrial& trial, const OtaReport& last);
+
+// /api/calibration: the load cell's zero ("offset", counts) and span, the
+// last capture ("running" while it is in progress; "spanTime" 0 = the
+// configured factor) and the drift zero tracking has taken out so far.
+const size_t CALIBRATION_JSON_MAX = 256;
+size_t writeCalibrationJson(char* out, size_t cap, const ScaleCal& cal, const CalCapture& c,
+                            const ZeroTracker& z);
+
+// /api/stats: the feed rollups (feed_rollup.h) at local time `now`. "today"
+// and "thisWeek" are the current rows, "days" and "weeks" every row still
+// in its ring (newest first, days without feeds left out), then one entry
+// per slot and one for manual feeds. "overshoot" covers the slot's
+// completed feeds so far, "weekOvershoot" those of this week; "var" is the
+// sample variance in g^2.
+constexpr size_t statsJsonCapacity(int slotCount) {
+  return 256 + (FEED_ROLLUP_DAYS + FEED_ROLLUP_WEEKS) * 80 + (slotCount + 1) * 240;
+}
+size_t writeStatsJson(char* out, size_t cap, const FeedRollups& r, int slotCount, uint32_t now);
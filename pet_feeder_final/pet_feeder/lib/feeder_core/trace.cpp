@@ -0,0 +1,80 @@
+#include "trace.h"
+#include <atomic>
+#include <stdio.h>
+#include <string.h>
+
+static TraceRecord*   ring = nullptr;
+static uint32_t       ringMask = 0;
+static TraceClockFn   clockFn = nullptr;
+static TraceContextFn contextFn = nullptr;
+static std::atomic<uint32_t> nextSeq(0);
+
+static const char* const EVENT_NAMES[TRACE_EVENT_COUNT] = {
+  "?", "loop", "handleClient", "hx711_read", "servo_open", "servo_close",
+  "lcd_flush", "feed_start", "feed_stop", "weight"
+};
+
+void traceInit(TraceRecord* storage, uint32_t capacity, TraceClockFn clock, TraceContextFn context) {
+  memset(storage, 0, capacity * sizeof(TraceRecord));
+  ring = storage;
+  ringMask = capacity - 1;
+  clockFn = clock;
+  contextFn = context;
+  nextSeq.store(0);
+}
+
+void traceRecord(uint16_t event, uint8_t phase, int32_t arg) {
+  if (!ring) return;
+  uint32_t seq = nextSeq.fetch_add(1, std::memory_order_relaxed) + 1;
+  TraceRecord& r = ring[seq & ringMask];
+
+  r.seq = 0;  // mark in progress for concurrent readers
+  std::atomic_signal_fence(std::memory_order_seq_cst);
+  r.timestampUs = clockFn ? clockFn() : 0;
+  r.arg = arg;
+  r.event = event;
+  r.phase = phase;
+  r.context = contextFn ? contextFn() : 0;
+  std::atomic_thread_fence(std::memory_order_release);
+  r.seq = seq;
+}
+
+uint32_t traceWritten() { return nextSeq.load(std::memory_order_relaxed); }
+
+uint32_t traceCapacity() { return ring ? ringMask + 1 : 0; }
+
+uint32_t traceOldest() {
+  uint32_t last = traceWritten();
+  return last > ringMask ? last - ringMask : 1;
+}
+
+uint32_t traceRead(uint32_t fromSeq, TraceRecord* out, uint32_t max) {
+  if (!ring) return 0;
+  uint32_t last = traceWritten();
+  if (fromSeq == 0 || fromSeq > last) return 0;
+
+  uint32_t n = 0;
+  for (uint32_t seq = fromSeq; seq <= last && n < max; seq++, n++) {
+    const TraceRecord& r = ring[seq & ringMask];
+    out[n] = r;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (out[n].seq != seq || r.seq != seq) {
+      memset(&out[n], 0, sizeof(TraceRecord));  // overwritten or in progress
+    }
+  }
+  return n;
+}
+
+const char* traceEventName(uint16_t event) {
+  return event < TRACE_EVENT_COUNT ? EVENT_NAMES[event] : "?";
+}
+
+uint32_t traceNameTable(char* buf, uint32_t cap) {
+  uint32_t len = 0;
+  for (uint16_t id = 1; id < TRACE_EVENT_COUNT; id++) {
+    int n = snprintf(buf + len, cap - len, "%u:%s\n", id, EVENT_NAMES[id]);
+    if (n < 0 || len + n >= cap) break;
+    len += n;
+  }
+  return len;
+}
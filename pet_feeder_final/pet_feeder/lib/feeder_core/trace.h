@@ -0,0 +1,101 @@
+#pragma once
+#include <stdint.h>
+
+// Low-overhead binary event tracing.
+//
+// Fixed-size records (timestamp, event id, phase, arg) go into a RAM ring
+// that any task or ISR may write: a writer claims its slot with one atomic
+// increment and never blocks. /api/trace dumps the ring and
+// tools/trace2chrome.py turns the dump into Chrome trace JSON (chrome://tracing,
+// ui.perfetto.dev). Build with -DFEEDER_TRACE=0 to compile every TRACE_* away.
+
+#ifndef FEEDER_TRACE
+#define FEEDER_TRACE 1
+#endif
+
+enum TraceEvent : uint16_t {
+  TRACE_LOOP = 1,
+  TRACE_HTTP_CLIENT,
+  TRACE_HX711_READ,
+  TRACE_SERVO_OPEN,
+  TRACE_SERVO_CLOSE,
+  TRACE_LCD_FLUSH,
+  TRACE_FEED_START,   // arg = target (g)
+  TRACE_FEED_STOP,    // arg = FeedCheck reason
+  TRACE_WEIGHT,       // counter, arg = weight (0.1 g)
+  TRACE_EVENT_COUNT
+};
+
+enum TracePhase : uint8_t {
+  TRACE_PH_BEGIN   = 'B',
+  TRACE_PH_END     = 'E',
+  TRACE_PH_INSTANT = 'i',
+  TRACE_PH_COUNTER = 'C'
+};
+
+struct TraceRecord {
+  uint32_t seq;        // 1-based write sequence; 0 = never written
+  uint32_t timestampUs;
+  int32_t  arg;
+  uint16_t event;
+  uint8_t  phase;
+  uint8_t  context;    // e.g. CPU core, or 0xFF in an ISR
+};
+
+static_assert(sizeof(TraceRecord) == 16, "trace dump format assumes 16-byte records");
+
+typedef uint32_t (*TraceClockFn)();
+typedef uint8_t  (*TraceContextFn)();
+
+// `storage` must hold a power-of-two number of records.
+void traceInit(TraceRecord* storage, uint32_t capacity, TraceClockFn clock, TraceContextFn context);
+void traceRecord(uint16_t event, uint8_t phase, int32_t arg);
+
+// Sequence numbers of the newest record and of the oldest still in the ring.
+uint32_t traceWritten();
+uint32_t traceOldest();
+uint32_t traceCapacity();
+
+// Copies the records with seq fromSeq, fromSeq+1, ... (at most `max`, up to
+// the newest) and returns how many slots were filled. A record overwritten or
+// half-written while being read comes back zeroed (seq == 0).
+uint32_t traceRead(uint32_t fromSeq, TraceRecord* out, uint32_t max);
+
+const char* traceEventName(uint16_t event);
+
+// ---- Dump format (little-endian) ----
+// TraceDumpHeader, then `nameTableBytes` of "id:name\n" lines, then records.
+struct TraceDumpHeader {
+  char     magic[4];        // "FTRC"
+  uint16_t version;
+  uint16_t recordSize;
+  uint32_t recordCount;
+  uint32_t nameTableBytes;
+};
+
+const uint16_t TRACE_DUMP_VERSION = 1;
+
+// Fills `buf` with the name table; returns its length.
+uint32_t traceNameTable(char* buf, uint32_t cap);
+
+#if FEEDER_TRACE
+class TraceScope {
+ public:
+  explicit TraceScope(uint16_t event, int32_t arg = 0) : event_(event) {
+    traceRecord(event, TRACE_PH_BEGIN, arg);
+  }
+  ~TraceScope() { traceRecord(event_, TRACE_PH_END, 0); }
+ private:
+  uint16_t event_;
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(ev)          TraceScope TRACE_CONCAT(traceScope_, __LINE__)(ev)
+#define TRACE_INSTANT(ev, arg)   traceRecord((ev), TRACE_PH_INSTANT, (arg))
+#define TRACE_COUNTER(ev, value) traceRecord((ev), TRACE_PH_COUNTER, (value))
+#else
+#define TRACE_SCOPE(ev)          do {} while (0)
+#define TRACE_INSTANT(ev, arg)   do {} while (0)
+#define TRACE_COUNTER(ev, value) do {} while (0)
+#endif
@@ -0,0 +1,330 @@
+# Flash/RAM size and boot-time report per PlatformIO env.
+#
+# As a post: extra_script it runs the toolchain's `size -A` on the linked ELF,
+# splits the usage per component (library archive or object) from the linker
+# map, prints a one-line summary and writes $BUILD_DIR/size_report.json along
+# with the feature flags the env was built with (include/feeder_features.h).
+#
+# Run directly:
+#   python scripts/size_report.py                    # one row per env built
+#   python scripts/size_report.py components headless
+#   python scripts/size_report.py boot headless --port /dev/ttyUSB0
+#
+# `boot` resets the board through RTS (the auto-reset circuit of the devkits),
+# reads the "Boot: ready in N ms" line the firmware logs at the end of
+# setup() and stores the median of a few cold boots in that env's report.
+# Flash the env's image first. Needs pyserial.
+
+import json
+import os
+import re
+import subprocess
+import sys
+import time
+
+FLASH_SIZE = 0x160000  # one app slot (app0/app1) in partitions.csv
+DRAM_SIZE = 320 * 1024
+IRAM_SIZE = 128 * 1024
+
+# (report name, macro, macro whose value is the default); keep in step with
+# include/feeder_features.h
+FEATURES = [
+    ("http", "FEEDER_HTTP_API", None),
+    ("web-ui", "FEEDER_WEB_UI", "FEEDER_HTTP_API"),
+    ("admission", "FEEDER_ADMISSION", "FEEDER_HTTP_API"),
+    ("lcd", "FEEDER_LCD", None),
+    ("buttons", "FEEDER_BUTTONS", None),
+    ("serial-proto", "FEEDER_SERIAL_PROTO", None),
+    ("trace", "FEEDER_TRACE", None),
+    ("sim", "FEEDER_SIM", None),
+    ("ota", "FEEDER_OTA", "FEEDER_HTTP_API"),
+]
+
+# Archives reported under one name: the WiFi driver and its blobs are one
+# component as far as the feature flags go
+COMPONENT_GROUPS = {
+    "WiFi": "wifi", "net80211": "wifi", "pp": "wifi", "wpa_supplicant": "wifi",
+    "esp_wifi": "wifi", "phy": "wifi", "coexist": "wifi", "core": "wifi",
+    "lwip": "lwip", "esp_netif": "lwip", "tcpip_adapter": "lwip",
+    "WebServer": "webserver", "FS": "fs", "SPIFFS": "fs", "spiffs": "fs",
+    "LiquidCrystal_I2C": "lcd", "RTClib": "rtc", "HX711": "hx711",
+    "ESP32Servo": "servo", "Wire": "i2c", "Preferences": "nvs", "nvs_flash": "nvs",
+    "FrameworkArduino": "arduino-core", "feeder_core": "feeder_core",
+}
+
+# Input sections of the application object that belong to a feature
+SECTION_COMPONENTS = {".rodata.INDEX_HTML": "web-ui"}
+
+TOP_COMPONENTS = 16  # rows in the components table, the rest is "(other)"
+
+
+def regions(section):
+    """Memories an output section occupies: flash (in the image), iram, dram."""
+    out = []
+    if section.startswith((".iram0", ".dram0.data", ".flash", ".rtc.text", ".rtc.data")):
+        out.append("flash")
+    if section.startswith(".iram0"):
+        out.append("iram")
+    if section.startswith((".dram0.data", ".dram0.bss", ".noinit")):
+        out.append("dram")
+    return out
+
+
+def parse_sections(text):
+    sections = {}
+    for line in text.splitlines():
+        parts = line.split()
+        if len(parts) >= 2 and parts[0].startswith(".") and parts[1].isdigit():
+            sections[parts[0]] = int(parts[1])
+    return sections
+
+
+def summarize(sections):
+    report = {"flash": 0, "iram": 0, "dram": 0}
+    for name, size in sections.items():
+        for region in regions(name):
+            report[region] += size
+    return report
+
+
+INPUT_RE = re.compile(r"^ (\.\S+)(?:\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*))?$")
+CONT_RE = re.compile(r"^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)$")
+ARCHIVE_RE = re.compile(r"([^/\\]+)\.a\(")
+
+
+def component_of(path, section):
+    m = ARCHIVE_RE.search(path)
+    if m:
+        name = m.group(1)
+        if name.startswith("lib"):
+            name = name[3:]
+        return COMPONENT_GROUPS.get(name, name)
+    for prefix, component in SECTION_COMPONENTS.items():
+        if section.startswith(prefix):
+            return component
+    return "app"  # src/*.o
+
+
+def parse_map(text):
+    """Bytes per component and memory from a GNU ld map file."""
+    components = {}
+    started = False
+    output = None
+    pending = None  # input section whose address is on the next line
+
+    def add(section, size, path):
+        if size == 0 or not output:
+            return
+        entry = components.setdefault(component_of(path, section),
+                                      {"flash": 0, "iram": 0, "dram": 0})
+        for region in regions(output):
+            entry[region] += size
+
+    for line in text.splitlines():
+        if not started:
+            started = line.startswith("Linker script and memory map")
+            continue
+        if line and not line[0].isspace():
+            output = line.split()[0]
+            if output == "/DISCARD/":
+                output = None
+            pending = None
+            continue
+        if pending:
+            m = CONT_RE.match(line)
+            if m:
+                add(pending, int(m.group(2), 16), m.group(3))
+            pending = None
+            continue
+        m = INPUT_RE.match(line)
+        if not m:
+            continue
+        if m.group(2) is None:
+            pending = m.group(1)
+        else:
+            add(m.group(1), int(m.group(3), 16), m.group(4))
+    return components
+
+
+def build_features(defines):
+    values = {}
+    for d in defines:
+        if isinstance(d, (tuple, list)):
+            values[d[0]] = str(d[1]) if len(d) > 1 else "1"
+        else:
+            name, _, value = str(d).partition("=")
+            values[name] = value or "1"
+
+    def on(macro, default):
+        value = values.get(macro)
+        if value is None:
+            return on(default, None) if default else True
+        return value.strip() not in ("0", "false")
+
+    return [name for name, macro, default in FEATURES if on(macro, default)]
+
+
+def pct(used, cap):
+    return 100.0 * used / cap if cap else 0.0
+
+
+def format_row(env_name, report):
+    row = "%-16s flash %8d (%5.1f%%)  iram %7d (%5.1f%%)  dram %7d (%5.1f%%)" % (
+        env_name,
+        report["flash"], pct(report["flash"], FLASH_SIZE),
+        report["iram"], pct(report["iram"], IRAM_SIZE),
+        report["dram"], pct(report["dram"], DRAM_SIZE))
+    if "boot_ms" in report:
+        row += "  boot %5d ms" % report["boot_ms"]
+    if "features" in report:
+        row += "  [%s]" % " ".join(report["features"])
+    return row
+
+
+def format_components(report):
+    items = sorted(report.get("components", {}).items(),
+                   key=lambda kv: (-kv[1]["flash"], -kv[1]["dram"], kv[0]))
+    if len(items) > TOP_COMPONENTS:
+        other = {"flash": 0, "iram": 0, "dram": 0}
+        for _, sizes in items[TOP_COMPONENTS:]:
+            for k in other:
+                other[k] += sizes[k]
+        items = items[:TOP_COMPONENTS] + [("(other)", other)]
+    lines = ["%-20s %9s %8s %8s" % ("component", "flash", "iram", "dram")]
+    for name, sizes in items:
+        lines.append("%-20s %9d %8d %8d" % (name, sizes["flash"], sizes["iram"], sizes["dram"]))
+    return "\n".join(lines)
+
+
+def post_build(source, target, env):
+    elf = str(target[0])
+    build_dir = env.subst("$BUILD_DIR")
+    out = subprocess.check_output([env.subst("$SIZETOOL"), "-A", elf],
+                                  universal_newlines=True)
+    report = summarize(parse_sections(out))
+    report["env"] = env.subst("$PIOENV")
+    report["features"] = build_features(env.get("CPPDEFINES", []))
+    map_path = os.path.join(build_dir, "firmware.map")
+    if os.path.isfile(map_path):
+        with open(map_path) as f:
+            report["components"] = parse_map(f.read())
+
+    # A rebuild keeps the boot time measured for the same features
+    path = os.path.join(build_dir, "size_report.json")
+    old = load_report(path)
+    if old and old.get("features") == report["features"] and "boot_ms" in old:
+        report["boot_ms"] = old["boot_ms"]
+    with open(path, "w") as f:
+        json.dump(report, f, indent=2)
+    print("Size report: " + format_row(report["env"], report))
+
+
+def load_report(path):
+    if not os.path.isfile(path):
+        return None
+    with open(path) as f:
+        return json.load(f)
+
+
+def print_all(build_root):
+    rows = []
+    env_names = sorted(os.listdir(build_root)) if os.path.isdir(build_root) else []
+    for env_name in env_names:
+        report = load_report(os.path.join(build_root, env_name, "size_report.json"))
+        if report:
+            rows.append(format_row(env_name, report))
+    if not rows:
+        print("No size reports under %s; build some envs first." % build_root)
+        return 1
+    print("\n".join(rows))
+    return 0
+
+
+def print_components(build_root, env_name):
+    report = load_report(os.path.join(build_root, env_name, "size_report.json"))
+    if not report or "components" not in report:
+        print("No component sizes for %s; build it (the map file comes with the build)." % env_name)
+        return 1
+    print(format_components(report))
+    return 0
+
+
+BOOT_RE = re.compile(r"Boot: ready in (\d+) ms")
+
+
+def measure_boot(port, timeout):
+    """One reset through RTS; returns (firmware ms, host ms from reset)."""
+    port.dtr = False
+    port.rts = True
+    time.sleep(0.1)
+    port.reset_input_buffer()
+    port.rts = False
+    start = time.monotonic()
+    text = b""
+    while time.monotonic() - start < timeout:
+        text += port.read(256)
+        m = BOOT_RE.search(text.decode("ascii", "replace"))
+        if m:
+            return int(m.group(1)), int((time.monotonic() - start) * 1000)
+    return None
+
+
+def record_boot(build_root, env_name, port_name, baud, runs, timeout):
+    path = os.path.join(build_root, env_name, "size_report.json")
+    report = load_report(path)
+    if not report:
+        print("No size report for %s; build it first." % env_name)
+        return 1
+    try:
+        import serial
+    except ImportError:
+        sys.exit("pyserial is needed to measure boot time: pip install pyserial")
+
+    firmware, host = [], []
+    with serial.Serial(port_name, baud, timeout=0.1) as port:
+        for i in range(runs):
+            result = measure_boot(port, timeout)
+            if result is None:
+                print("run %d: no boot line within %.0f s" % (i + 1, timeout))
+                continue
+            print("run %d: ready in %d ms (%d ms from reset, host clock)" % ((i + 1,) + result))
+            firmware.append(result[0])
+            host.append(result[1])
+    if not firmware:
+        return 1
+    report["boot_ms"] = sorted(firmware)[len(firmware) // 2]
+    report["boot_reset_ms"] = sorted(host)[len(host) // 2]
+    with open(path, "w") as f:
+        json.dump(report, f, indent=2)
+    print(format_row(env_name, report))
+    return 0
+
+
+def main(root):
+    import argparse
+    ap = argparse.ArgumentParser(description="Flash/RAM and boot-time report per env.")
+    sub = ap.add_subparsers(dest="cmd")
+    c = sub.add_parser("components", help="flash/IRAM/DRAM per component of one env")
+    c.add_argument("env")
+    b = sub.add_parser("boot", help="measure cold-boot time of the flashed env")
+    b.add_argument("env")
+    b.add_argument("--port", required=True, help="serial port, e.g. /dev/ttyUSB0")
+    b.add_argument("--baud", type=int, default=115200)
+    b.add_argument("--runs", type=int, default=5)
+    b.add_argument("--timeout", type=float, default=30.0, help="seconds per boot")
+    args = ap.parse_args()
+
+    build_root = os.path.join(root, ".pio", "build")
+    if args.cmd == "components":
+        return print_components(build_root, args.env)
+    if args.cmd == "boot":
+        return record_boot(build_root, args.env, args.port, args.baud, args.runs, args.timeout)
+    return print_all(build_root)
+
+
+try:
+    Import("env")  # noqa: F821 (provided by PlatformIO/SCons)
+except NameError:
+    sys.exit(main(os.path.normpath(os.path.join(os.path.dirname(os.path.abspath(__file__)), ".."))))
+else:
+    env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", post_build)  # noqa: F821
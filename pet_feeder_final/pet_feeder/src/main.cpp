@@ -1,925 +1,2236 @@
-// === Pet Feeder v2.0 (ESP32) ===
-// Pins: HX711 DT=4, SCK=5 | Servo=18 | I2C SDA=21, SCL=22 | Buttons: 12/13/14/15 (to GND)
-// Power: ESP32+HX711 @3.3V; RTC+LCD+Servo @5V (common GND)
-
-#include <Wire.h>
-#include <RTClib.h>
-#include <LiquidCrystal_I2C.h>
-#include <ESP32Servo.h>
-#include <HX711.h>
-#include <math.h>  // for fabs()
-
-//web UI
-#include <WiFi.h>
-#include <WebServer.h>
-#include "web_ui.h"
-
-
-// ---- WiFi & Web ----
-const char* WIFI_SSID     = "Wokwi-GUEST";
-const char* WIFI_PASSWORD = "";
-WebServer server(80);
-
-// ---- Pins ----
-#define HX711_DT_PIN   4
-#define HX711_SCK_PIN  5
-#define SERVO_PIN      18
-#define BUTTON_DISPLAY 12
-#define BUTTON_SETTING 13
-#define BUTTON_UP      14
-#define BUTTON_DOWN    15
-
-
-// ---- HW objects ----
-RTC_DS1307 rtc;
-LiquidCrystal_I2C lcd(0x27, 20, 4);   // If blank, try 0x3F
-Servo feedServo;
-HX711 scale;
-
-// ---- State ----
-bool showSlots = false;
-int  currentSlot = 0;
-float currentWeight = 0.0f;
-bool feedingActive = false;
-bool feederOpen = false;
-int  servoCloseAngle = 0;
-int  servoOpenAngle  = 180;
-float calibration_factor = -7050;     // adjust for your load cell
-int  activeFeedingSlot = -1;
-bool rtc_ok = false;
-
-// ---- SIMULATION FLAG (Option A) ----
-// Set to 1 in Wokwi, set to 0 on real hardware.
-#ifndef SIM_FAKE_WEIGHT
-#define SIM_FAKE_WEIGHT 1
-#endif
-
-// Simulated bowl weight (for Wokwi)
-static float simWeight = 0.0f;
-
-// ---- Safety & stuck detection ----
-unsigned long feedingStartMs = 0;
-const unsigned long FEED_TIMEOUT_MS = 15000;      // 15s safety timeout
-float lastWeightDuringFeed = 0;
-unsigned long lastWeightChangeMs = 0;
-const unsigned long STUCK_WINDOW_MS = 4000;       // 4s with no increase -> consider stuck
-const float MIN_INCREASE_G = 2.0;                 // noise floor for "increase"
-
-// ---- Slots ----
-struct FeedingSlot {
-  bool  active;
-  int   hour;
-  int   minute;
-  float weight;  // grams
-};
-
-FeedingSlot slots[3] = {
-  {false,  8, 0, 0},
-  {false, 12, 0, 0},
-  {false, 18, 0, 0}
-};
-
-// ---- Feed history log ----
-struct FeedLogEntry {
-  bool  used;
-  bool  manual;       // true = manual, false = scheduled slot
-  int   slotIndex;    // -1 for manual
-  int   hour;
-  int   minute;
-  float target;       // target weight (g)
-  float finalWeight;  // final measured weight (g)
-};
-
-const int MAX_FEED_LOGS = 10;
-FeedLogEntry feedLog[MAX_FEED_LOGS];
-int feedLogCount = 0;
-
-void addFeedLog(bool manual, int slotIndex, float target, float finalWeight);
-
-
-// ---- Setting UI ----
-enum SettingState {
-  NOT_SETTING,
-  SETTING_HOUR,
-  SETTING_MINUTE,
-  SETTING_WEIGHT,
-  SAVING
-};
-
-SettingState settingState = NOT_SETTING;
-int   tempHour   = 0;
-int   tempMinute = 0;
-float tempWeight = 0;
-
-// ---- Manual feeding mode ----
-bool  manualMode        = false;  // true if current feeding is manual
-float manualTempWeight  = 100;    // default manual amount when choosing (g)
-float currentTargetWeight = 0;    // unified target for scheduled + manual
-
-enum ManualState {
-  MANUAL_IDLE,
-  MANUAL_SET_WEIGHT
-};
-
-ManualState manualState = MANUAL_IDLE;
-
-// ---- Debounce ----
-unsigned long lastButtonPress = 0;
-const unsigned long debounceDelay = 200;
-
-// ---- Trigger guard (fire once per Y/M/D/H/M) ----
-int lastTriggerYear = -1, lastTriggerMonth = -1, lastTriggerDay = -1,
-    lastTriggerHour = -1, lastTriggerMinute = -1;
-
-// ---- Forward decls ----
-void updateDisplay();
-void handleSettingMode();
-void adjustSettingValue(int direction);
-void saveCurrentSlot();
-void checkScheduledFeeding();
-void startFeeding(int slotIndex);
-void startManualFeeding(float weight);
-void openFeeder();
-void closeFeeder();
-void monitorFeeding();
-void finishFeeding();
-DateTime getNextFeedingTime();
-void resetSystemState();
-
-// Forward declarations for API handlers
-void handleStatusApi();
-void handleManualFeedApi();
-void handleSetSlotApi();
-void handleResetApi();
-
-// === OPTION A: weight source wrapper ===
-// Returns either simulated weight (Wokwi) or real HX711 reading (hardware)
-float readWeight(bool feedingActive, bool feederOpen) {
-#if SIM_FAKE_WEIGHT
-  // In Wokwi: simulate bowl weight increase while feeding
-  if (feedingActive && feederOpen) {
-    static unsigned long last = 0;
-    if (millis() - last > 300) {  // every 0.3s
-      simWeight += 10.0f;         // +10 g per step
-      last = millis();
-    }
-  }
-  // After feeding, simWeight stays at the final value.
-  return simWeight;
-#else
-  // On real hardware: read actual HX711 units
-  return scale.get_units(5);
-#endif
-}
-
-void setup() {
-  Serial.begin(115200);
-
-  // Match your wiring (SDA=21, SCL=22)
-  Wire.begin(21, 22);
-
-  pinMode(BUTTON_DISPLAY, INPUT_PULLUP);
-  pinMode(BUTTON_SETTING, INPUT_PULLUP);
-  pinMode(BUTTON_UP,      INPUT_PULLUP);
-  pinMode(BUTTON_DOWN,    INPUT_PULLUP);
-
-  lcd.init();
-  lcd.backlight();
-  lcd.setCursor(0, 0);
-  lcd.print("Pet Feeder v2.0");
-  lcd.setCursor(0, 1);
-  lcd.print("Initializing...");
-
-  rtc_ok = rtc.begin();
-  if (!rtc_ok) {
-    Serial.println("RTC not found! (check 5V & I2C)");
-    lcd.setCursor(0, 2);
-    lcd.print("RTC not found!");
-  } else if (!rtc.isrunning()) {
-    Serial.println("RTC not running, setting compile time...");
-    rtc.adjust(DateTime(F(__DATE__), F(__TIME__)));
-  }
-
-  feedServo.attach(SERVO_PIN);
-  feedServo.write(servoCloseAngle);
-
-  scale.begin(HX711_DT_PIN, HX711_SCK_PIN);
-  delay(200); // small settle
-  scale.set_scale(calibration_factor);
-  scale.tare();
-
-    // --- WiFi setup (Wokwi) ---
-  WiFi.mode(WIFI_STA);
-  WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
-  Serial.print("Connecting to WiFi");
-  while (WiFi.status() != WL_CONNECTED) {
-    delay(500);
-    Serial.print(".");
-  }
-  Serial.println();
-  Serial.print("WiFi connected. IP: ");
-  Serial.println(WiFi.localIP());
-
-
-    // HTTP server routes
-  server.on("/", HTTP_GET, []() {
-  server.send_P(200, "text/html", INDEX_HTML);
-  });
-
-  server.on("/api/status", HTTP_GET, handleStatusApi);
-  server.on("/api/manual-feed", HTTP_POST, handleManualFeedApi);
-  server.on("/api/set-slot", HTTP_POST, handleSetSlotApi);
-  server.on("/api/reset", HTTP_POST, handleResetApi);
-
-  server.begin();
-  Serial.println("HTTP server started.");
-
-
-  delay(800);
-  lcd.clear();
-
-  Serial.println("Pet Feeding System Ready!");
-  Serial.println("RED=Display | GREEN=Setting/Manual | BLUE UP/DOWN=Navigate");
-
-
-}
-
-void loop() {
-  server.handleClient();
-
-  DateTime now = rtc_ok ? rtc.now()
-                        : DateTime(2025, 1, 1, 0, 0, (millis()/1000) % 60);
-
-  // Use wrapper (sim or real)
-  currentWeight = readWeight(feedingActive, feederOpen);
-
-  // Simple debounce guard
-  if (millis() - lastButtonPress < debounceDelay) return;
-
-  // --- BUTTON HANDLING ---
-
-  // RED: display toggle (main <-> slots)
-  if (digitalRead(BUTTON_DISPLAY) == LOW) {
-    if (settingState == NOT_SETTING && manualState == MANUAL_IDLE) {
-      showSlots = !showSlots;
-      updateDisplay();
-      Serial.print("Display mode: ");
-      Serial.println(showSlots ? "Slots" : "Main");
-    }
-    lastButtonPress = millis();
-    return;
-  }
-
-  // GREEN: settings / manual feed
-  if (digitalRead(BUTTON_SETTING) == LOW) {
-
-    // 1) If we are currently choosing manual feed amount -> confirm & start
-    if (manualState == MANUAL_SET_WEIGHT) {
-      startManualFeeding(manualTempWeight);
-      manualState = MANUAL_IDLE;
-    }
-    // 2) If on slots screen -> use normal slot setting mode
-    else if (showSlots) {
-      handleSettingMode();
-    }
-    // 3) If on main screen & not editing slots -> enter manual feed setup
-    else if (settingState == NOT_SETTING && !showSlots) {
-      manualState = MANUAL_SET_WEIGHT;
-      if (manualTempWeight <= 0) manualTempWeight = 100; // default
-      Serial.println("Manual feed setup started");
-      updateDisplay();
-    }
-    // Fallback: normal setting handler
-    else {
-      handleSettingMode();
-    }
-
-    lastButtonPress = millis();
-    return;
-  }
-
-  // UP
-  if (digitalRead(BUTTON_UP) == LOW) {
-
-    if (manualState == MANUAL_SET_WEIGHT) {
-      manualTempWeight += 10;           // +10g per press
-      if (manualTempWeight > 5000) manualTempWeight = 5000; // cap at 5kg
-      updateDisplay();
-    }
-    else if (settingState == NOT_SETTING && showSlots) {
-      currentSlot = (currentSlot - 1 + 3) % 3;
-      updateDisplay();
-      Serial.printf("UP - Selected slot: %d\n", currentSlot + 1);
-    }
-    else if (settingState != NOT_SETTING) {
-      adjustSettingValue(1);
-      updateDisplay();
-    }
-
-    lastButtonPress = millis();
-    return;
-  }
-
-  // DOWN
-  if (digitalRead(BUTTON_DOWN) == LOW) {
-
-    if (manualState == MANUAL_SET_WEIGHT) {
-      manualTempWeight -= 10;       // -10g per press
-      if (manualTempWeight < 0) manualTempWeight = 0;
-      updateDisplay();
-    }
-    else if (settingState == NOT_SETTING && showSlots) {
-      currentSlot = (currentSlot + 1) % 3;
-      updateDisplay();
-      Serial.printf("DOWN - Selected slot: %d\n", currentSlot + 1);
-    }
-    else if (settingState != NOT_SETTING) {
-      adjustSettingValue(-1);
-      updateDisplay();
-    }
-
-    lastButtonPress = millis();
-    return;
-  }
-
-  // --- Main logic ---
-  if (settingState == NOT_SETTING && manualState == MANUAL_IDLE) {
-    checkScheduledFeeding();
-  }
-
-  if (feedingActive) {
-    monitorFeeding();
-  }
-
-  static unsigned long lastScreenUpdate = 0;
-  if (millis() - lastScreenUpdate > 1000) {
-    if (settingState == NOT_SETTING && manualState == MANUAL_IDLE) {
-      updateDisplay();
-    }
-    lastScreenUpdate = millis();
-  }
-
-  delay(50);
-}
-
-// --- Scheduled feeding check ---
-void checkScheduledFeeding() {
-  if (feedingActive) return;
-
-  DateTime now = rtc_ok ? rtc.now()
-                        : DateTime(2025, 1, 1, 0, 0, (millis()/1000) % 60);
-
-  for (int i = 0; i < 3; i++) {
-    if (slots[i].active && slots[i].weight > 0) {
-      if (now.hour() == slots[i].hour &&
-          now.minute() == slots[i].minute &&
-          now.second() <= 1) { // tolerate 0/1 sec
-
-        // Fire once per minute
-        if (!(lastTriggerYear   == now.year()  &&
-              lastTriggerMonth  == now.month() &&
-              lastTriggerDay    == now.day()   &&
-              lastTriggerHour   == now.hour()  &&
-              lastTriggerMinute == now.minute())) {
-
-          lastTriggerYear   = now.year();
-          lastTriggerMonth  = now.month();
-          lastTriggerDay    = now.day();
-          lastTriggerHour   = now.hour();
-          lastTriggerMinute = now.minute();
-
-          startFeeding(i);
-          break;
-        }
-      }
-    }
-  }
-}
-
-// --- Start scheduled feeding ---
-void startFeeding(int slotIndex) {
-  manualMode = false;                 // this is a scheduled feed
-  feedingActive = true;
-  feederOpen = false;
-  activeFeedingSlot = slotIndex;
-
-  // ✅ Scheduled feed also "adds" on top of existing bowl weight
-  currentTargetWeight = fabs(currentWeight) + slots[slotIndex].weight;
-
-  feedingStartMs = millis();
-  lastWeightDuringFeed = fabs(currentWeight);
-  lastWeightChangeMs = millis();
-
-  Serial.printf("Feeding started from SLOT%d\n", slotIndex + 1);
-  Serial.printf("Target weight: %.0fg\n", currentTargetWeight);
-
-  openFeeder();
-  updateDisplay();
-}
-
-// --- Start manual feeding ---
-void startManualFeeding(float weight) {
-  manualMode = true;                 // manual feed
-  feedingActive = true;
-  feederOpen = false;
-  activeFeedingSlot = -1;            // no slot associated
-
-  // ✅ Manual feed is "add this much more":
-  //     target = current bowl weight + requested extra
-  currentTargetWeight = fabs(currentWeight) + weight;
-
-  feedingStartMs = millis();
-  lastWeightDuringFeed = fabs(currentWeight);
-  lastWeightChangeMs = millis();
-
-  Serial.println("Manual feeding started");
-  Serial.printf("Manual target: %.0fg (current %.1f + %.1f)\n",
-                currentTargetWeight, currentWeight, weight);
-
-  openFeeder();
-  updateDisplay();
-}
-
-
-void openFeeder() {
-  feedServo.write(servoOpenAngle);
-  feederOpen = true;
-  Serial.println("Feeder opened (180 deg)");
-}
-
-void closeFeeder() {
-  feedServo.write(servoCloseAngle);
-  feederOpen = false;
-  Serial.println("Feeder closed (0 deg)");
-}
-
-// --- Feeding monitor (scheduled + manual) ---
-void monitorFeeding() {
-  if (!feedingActive) return;
-
-  float target = currentTargetWeight;
-  float w = fabs(currentWeight);
-
-  // Close when target reached
-  if (feederOpen && w >= target && target > 0) {
-    Serial.printf("Target reached: %.1fg >= %.1fg\n", w, target);
-    closeFeeder();
-    finishFeeding();
-    return;
-  }
-
-  // Stuck detection: weight not increasing enough while open
-  if (feederOpen) {
-    if (w > lastWeightDuringFeed + MIN_INCREASE_G) {
-      lastWeightDuringFeed = w;
-      lastWeightChangeMs = millis();
-    }
-    if (millis() - lastWeightChangeMs > STUCK_WINDOW_MS) {
-      Serial.println("No weight increase detected → stopping (stuck?)");
-      closeFeeder();
-      finishFeeding();
-      return;
-    }
-  }
-
-  // Safety timeout
-  if (millis() - feedingStartMs > FEED_TIMEOUT_MS) {
-    Serial.println("Feed timeout reached → stopping");
-    if (feederOpen) closeFeeder();
-    finishFeeding();
-    return;
-  }
-
-  // Occasional log
-  static unsigned long lastPrint = 0;
-  if (millis() - lastPrint > 3000) {
-    Serial.printf("Feeding... %.1fg / %.1fg (t+%lus)\n",
-                  w, target, (millis() - feedingStartMs)/1000);
-    lastPrint = millis();
-  }
-}
-
-void finishFeeding() {
-  // Log BEFORE we reset manualMode / activeFeedingSlot
-  bool wasManual = manualMode;
-  int  slot      = activeFeedingSlot;
-  float target   = currentTargetWeight;
-  float finalW   = fabs(currentWeight);
-
-  addFeedLog(wasManual, slot, target, finalW);
-
-  feedingActive = false;
-  feederOpen = false;
-  manualMode = false;
-  activeFeedingSlot = -1;
-
-  Serial.println("Feeding complete!");
-
-  lcd.clear();
-  lcd.setCursor(0, 1);
-  lcd.print("  Feeding Complete!");
-  delay(3000);
-}
-
-void resetSystemState() {
-  feedingActive = false;
-  feederOpen = false;
-  manualMode = false;
-  activeFeedingSlot = -1;
-  manualState = MANUAL_IDLE;
-  settingState = NOT_SETTING;
-  showSlots = false;
-
-  currentTargetWeight = 0;
-  lastWeightDuringFeed = 0;
-  currentWeight = 0;
-  feedingStartMs = millis();
-  lastWeightChangeMs = millis();
-
-  lastTriggerYear = -1;
-  lastTriggerMonth = -1;
-  lastTriggerDay = -1;
-  lastTriggerHour = -1;
-  lastTriggerMinute = -1;
-
-  slots[0] = {false, 8, 0, 0};
-  slots[1] = {false, 12, 0, 0};
-  slots[2] = {false, 18, 0, 0};
-
-  feedLogCount = 0;
-  for (int i = 0; i < MAX_FEED_LOGS; ++i) {
-    feedLog[i].used = false;
-  }
-
-#if SIM_FAKE_WEIGHT
-  simWeight = 0.0f;
-#else
-  scale.tare();
-#endif
-
-  closeFeeder();
-  updateDisplay();
-}
-
-void handleSettingMode() {
-  if (showSlots && settingState == NOT_SETTING) {
-    settingState = SETTING_HOUR;
-    tempHour   = slots[currentSlot].hour;
-    tempMinute = slots[currentSlot].minute;
-    tempWeight = slots[currentSlot].weight;
-    Serial.println("Setting mode started - Hour");
-  } else if (settingState != NOT_SETTING) {
-    switch (settingState) {
-      case SETTING_HOUR:
-        settingState = SETTING_MINUTE;
-        Serial.println("Setting minute");
-        break;
-      case SETTING_MINUTE:
-        settingState = SETTING_WEIGHT;
-        Serial.println("Setting weight");
-        break;
-      case SETTING_WEIGHT:
-        settingState = SAVING;
-        saveCurrentSlot();
-        Serial.println("Settings saved");
-        break;
-      case SAVING:
-        settingState = NOT_SETTING;
-        Serial.println("Setting mode ended");
-        break;
-    }
-  }
-  updateDisplay();
-}
-
-void adjustSettingValue(int direction) {
-  switch (settingState) {
-    case SETTING_HOUR:
-      tempHour += direction;
-      if (tempHour < 0) tempHour = 23;
-      if (tempHour > 23) tempHour = 0;
-      break;
-    case SETTING_MINUTE:
-      tempMinute += direction;
-      if (tempMinute < 0) tempMinute = 59;
-      if (tempMinute > 59) tempMinute = 0;
-      break;
-    case SETTING_WEIGHT:
-      tempWeight += direction * 100;     // step by 100g
-      if (tempWeight < 0)    tempWeight = 0;
-      if (tempWeight > 9999) tempWeight = 9999;
-      break;
-    default:
-      break;
-  }
-}
-
-void saveCurrentSlot() {
-  slots[currentSlot].hour   = tempHour;
-  slots[currentSlot].minute = tempMinute;
-  slots[currentSlot].weight = tempWeight;
-  slots[currentSlot].active = (tempWeight > 0);
-
-  Serial.printf("Slot %d saved: %02d:%02d, %.0fg\n",
-                currentSlot + 1, tempHour, tempMinute, tempWeight);
-}
-
-DateTime getNextFeedingTime() {
-  DateTime now = rtc_ok ? rtc.now()
-                        : DateTime(2025, 1, 1, 0, 0, (millis()/1000) % 60);
-  DateTime nextFeed(2099, 12, 31, 23, 59, 0);
-
-  for (int i = 0; i < 3; i++) {
-    if (slots[i].active && slots[i].weight > 0) {
-      DateTime t(now.year(), now.month(), now.day(),
-                 slots[i].hour, slots[i].minute, 0);
-      if (t < now) t = t + TimeSpan(1, 0, 0, 0);
-      if (t < nextFeed) nextFeed = t;
-    }
-  }
-  return nextFeed;
-}
-
-void updateDisplay() {
-  DateTime now = rtc_ok ? rtc.now()
-                        : DateTime(2025, 1, 1, 0, 0, (millis()/1000) % 60);
-  lcd.clear();
-
-  // --- Manual feeding weight selection screen ---
-  if (manualState == MANUAL_SET_WEIGHT) {
-    lcd.setCursor(0, 0);
-    lcd.print("  Manual Feeding  ");
-
-    lcd.setCursor(0, 1);
-    lcd.print("Amount: ");
-    lcd.print((int)manualTempWeight);
-    lcd.print("g   ");
-
-    lcd.setCursor(0, 2);
-    lcd.print("UP/DOWN: adjust");
-
-    lcd.setCursor(0, 3);
-    lcd.print("GREEN: start feed");
-    return;  // don't draw other screens
-  }
-
-  if (settingState != NOT_SETTING) {
-    lcd.setCursor(0, 0);
-    lcd.print("Setting SLOT");
-    lcd.print(currentSlot + 1);
-
-    lcd.setCursor(0, 1);
-    lcd.print("Hour: ");
-    if (tempHour < 10) lcd.print("0");
-    lcd.print(tempHour);
-    if (settingState == SETTING_HOUR) lcd.print(" <--");
-
-    lcd.setCursor(0, 2);
-    lcd.print("Min:  ");
-    if (tempMinute < 10) lcd.print("0");
-    lcd.print(tempMinute);
-    if (settingState == SETTING_MINUTE) lcd.print(" <--");
-
-    lcd.setCursor(0, 3);
-    lcd.print("Weight: ");
-    lcd.print((int)tempWeight);
-    lcd.print("g");
-    if (settingState == SETTING_WEIGHT) lcd.print(" <--");
-
-    if (settingState == SAVING) {
-      lcd.clear();
-      lcd.setCursor(0, 1);
-      lcd.print("  Settings Saved!");
-      lcd.setCursor(0, 2);
-      lcd.print("  Press GREEN");
-    }
-
-  } else if (showSlots) {
-    lcd.setCursor(0, 0);
-    lcd.print("SLOTS   ");
-    if (now.hour() < 10) lcd.print("0");
-    lcd.print(now.hour());
-    lcd.print(":");
-    if (now.minute() < 10) lcd.print("0");
-    lcd.print(now.minute());
-
-    for (int i = 0; i < 3; i++) {
-      lcd.setCursor(0, i + 1);
-      lcd.print(i == currentSlot ? ">" : " ");
-      lcd.print("SLOT");
-      lcd.print(i + 1);
-      lcd.print(":");
-      if (slots[i].active && slots[i].weight > 0) {
-        if (slots[i].hour < 10) lcd.print("0");
-        lcd.print(slots[i].hour);
-        lcd.print(":");
-        if (slots[i].minute < 10) lcd.print("0");
-        lcd.print(slots[i].minute);
-        lcd.print(",");
-        lcd.print((int)slots[i].weight);
-        lcd.print("g");
-      } else {
-        lcd.print("Empty");
-      }
-    }
-
-  } else {
-    // --- Main screen ---
-    lcd.setCursor(0, 0);
-    lcd.print("Time: ");
-    if (now.hour() < 10) lcd.print("0");
-    lcd.print(now.hour());
-    lcd.print(":");
-    if (now.minute() < 10) lcd.print("0");
-    lcd.print(now.minute());
-    lcd.print(":");
-    if (now.second() < 10) lcd.print("0");
-    lcd.print(now.second());
-
-    lcd.setCursor(0, 1);
-    lcd.print("Weight: ");
-    lcd.print(currentWeight, 1);
-    lcd.print("g");
-
-    if (feedingActive) {
-      lcd.setCursor(0, 2);
-      lcd.print("Feeding in progress");
-      lcd.setCursor(0, 3);
-      if (manualMode) {
-        lcd.print("Manual Target: ");
-      } else {
-        lcd.print("Target: ");
-      }
-      lcd.print((int)currentTargetWeight);
-      lcd.print("g");
-    } else {
-      lcd.setCursor(0, 2);
-      lcd.print("Next: ");
-      DateTime nextFeed = getNextFeedingTime();
-      if (nextFeed.hour() < 10) lcd.print("0");
-      lcd.print(nextFeed.hour());
-      lcd.print(":");
-      if (nextFeed.minute() < 10) lcd.print("0");
-      lcd.print(nextFeed.minute());
-
-      lcd.setCursor(0, 3);
-      lcd.print("GREEN: Manual feed");
-    }
-  }
-}
-
-void addFeedLog(bool manual, int slotIndex, float target, float finalWeight) {
-  // Shift older entries down (newest at index 0)
-  for (int i = MAX_FEED_LOGS - 1; i > 0; --i) {
-    feedLog[i] = feedLog[i - 1];
-  }
-
-  DateTime now = rtc_ok ? rtc.now()
-                        : DateTime(2025, 1, 1, 0, 0, (millis()/1000) % 60);
-
-  feedLog[0].used        = true;
-  feedLog[0].manual      = manual;
-  feedLog[0].slotIndex   = slotIndex;
-  feedLog[0].hour        = now.hour();
-  feedLog[0].minute      = now.minute();
-  feedLog[0].target      = target;
-  feedLog[0].finalWeight = finalWeight;
-
-  if (feedLogCount < MAX_FEED_LOGS) {
-    feedLogCount++;
-  }
-}
-
-
-void handleStatusApi() {
-  DateTime nextFeed = getNextFeedingTime();
-
-  String json = "{";
-
-  // weight
-  json += "\"weight\":" + String(currentWeight, 1) + ",";
-
-  // feedingActive
-  json += "\"feedingActive\":" + String(feedingActive ? "true" : "false") + ",";
-
-  // nextTime
-  if (nextFeed.year() >= 2099) {
-    json += "\"nextTime\":\"None\",";
-  } else {
-    char buf[6];
-    snprintf(buf, sizeof(buf), "%02d:%02d", nextFeed.hour(), nextFeed.minute());
-    json += "\"nextTime\":\"" + String(buf) + "\",";
-  }
-
-  // slots array
-  json += "\"slots\":[";
-  for (int i = 0; i < 3; i++) {
-    json += "{";
-    json += "\"active\":" + String(slots[i].active ? "true" : "false") + ",";
-    json += "\"hour\":"   + String(slots[i].hour) + ",";
-    json += "\"minute\":" + String(slots[i].minute) + ",";
-    json += "\"weight\":" + String((int)slots[i].weight);
-    json += "}";
-    if (i < 2) json += ",";
-  }
-  json += "],";
-
-  // 🔹 history array (new)
-  json += "\"history\":[";
-  for (int i = 0; i < feedLogCount; i++) {
-    FeedLogEntry &e = feedLog[i];
-    if (!e.used) continue;
-
-    json += "{";
-
-    // time "HH:MM"
-    char tbuf[6];
-    snprintf(tbuf, sizeof(tbuf), "%02d:%02d", e.hour, e.minute);
-    json += "\"time\":\"" + String(tbuf) + "\",";
-
-    // type: "Manual" or "Slot X"
-    json += "\"type\":\"";
-    if (e.manual) {
-      json += "Manual";
-    } else {
-      json += "Slot ";
-      json += String(e.slotIndex + 1);
-    }
-    json += "\",";
-
-    // target / final
-    json += "\"target\":" + String((int)e.target) + ",";
-    json += "\"final\":"  + String((int)e.finalWeight);
-
-    json += "}";
-    if (i < feedLogCount - 1) json += ",";
-  }
-  json += "]";
-
-  json += "}";
-
-  server.send(200, "application/json", json);
-}
-
-void handleResetApi() {
-  resetSystemState();
-  server.send(200, "text/plain", "OK");
-}
-
-
-void handleManualFeedApi() {
-  if (!server.hasArg("amount")) {
-    server.send(400, "text/plain", "Missing amount");
-    return;
-  }
-
-  float amount = server.arg("amount").toFloat();
-  if (amount <= 0) {
-    server.send(400, "text/plain", "Amount must be > 0");
-    return;
-  }
-
-  if (feedingActive) {
-    server.send(409, "text/plain", "Already feeding");
-    return;
-  }
-
-  startManualFeeding(amount);  // your existing function
-  server.send(200, "text/plain", "OK");
-}
-
-void handleSetSlotApi() {
-  if (!server.hasArg("index") ||
-      !server.hasArg("hour")  ||
-      !server.hasArg("minute")||
-      !server.hasArg("weight")) {
-    server.send(400, "text/plain", "Missing parameters");
-    return;
-  }
-
-  int index  = server.arg("index").toInt();
-  int hour   = server.arg("hour").toInt();
-  int minute = server.arg("minute").toInt();
-  float weight = server.arg("weight").toFloat();
-
-  if (index < 0 || index > 2) {
-    server.send(400, "text/plain", "Invalid slot index");
-    return;
-  }
-  if (hour < 0 || hour > 23 || minute < 0 || minute > 59) {
-    server.send(400, "text/plain", "Invalid time");
-    return;
-  }
-  if (weight < 0) weight = 0;
-
-  slots[index].hour   = hour;
-  slots[index].minute = minute;
-  slots[index].weight = weight;
-  slots[index].active = (weight > 0);
-
-  Serial.printf("Slot %d set via Web: %02d:%02d, %.0fg\n",
-                index + 1, hour, minute, weight);
-
-  server.send(200, "text/plain", "OK");
-}
-
+// === Pet Feeder v2.0 (ESP32) ===
+// Pins: HX711 DT=4, SCK=5 | Servo=18 | I2C SDA=21, SCL=22 | Buttons: 12/13/14/15 (to GND)
+// Power: ESP32+HX711 @3.3V; RTC+LCD+Servo @5V (common GND)
+// Pins, capacities and timeouts per board variant: include/feeder_config.h
+
+#include <Wire.h>
+#include <RTClib.h>
+#include <math.h>  // for fabs()
+#include <esp_system.h>  // esp_random(), esp_reset_reason()
+#include <esp_task_wdt.h>
+#include <Preferences.h>
+#include <SPIFFS.h>
+#include "feeder_config.h"
+#include "feeder_hw.h"
+#include "serial_link.h"
+#include "log_store.h"
+
+// Hardware-independent control logic (lib/feeder_core)
+#include "feeder_time.h"
+#include "schedule.h"
+#include "feed_log.h"
+#include "feed_rollup.h"
+#include "feed_monitor.h"
+#include "feed_queue.h"
+#include "feed_control.h"
+#include "status_json.h"
+#include "status_cache.h"
+#include "status_binary.h"
+#include "bin_writer.h"
+#include "trace.h"
+#include "loop_stats.h"
+#include "admission.h"
+#include "api_request.h"
+#include "history_log.h"
+#include "history_store.h"
+#include "feed_rec_store.h"
+#include "hopper.h"
+#include "feed_journal.h"
+#include "flow_stats.h"
+#include "dispense.h"
+#include "scale_cal.h"
+#include "serial_proto.h"
+#include "logger.h"
+
+// Optional parts (feeder_features.h)
+#if FEEDER_HTTP_API
+#include <WiFi.h>
+#include <WebServer.h>
+#endif
+#if FEEDER_WEB_UI
+#include "web_ui.h"
+#endif
+#if FEEDER_OTA
+#include <HTTPClient.h>
+#include <esp_ota_ops.h>
+#include <esp_partition.h>
+#include "ota_image.h"
+#endif
+
+
+#if FEEDER_HTTP_API
+// ---- WiFi & Web ----
+const char* WIFI_SSID     = "Wokwi-GUEST";
+const char* WIFI_PASSWORD = "";
+WebServer server(80);
+#endif
+
+// ---- Pins ----
+#define BUTTON_DISPLAY kBoard.buttonDisplay
+#define BUTTON_SETTING kBoard.buttonSetting
+#define BUTTON_UP      kBoard.buttonUp
+#define BUTTON_DOWN    kBoard.buttonDown
+
+// ---- Capacities ----
+constexpr int SLOT_COUNT    = kBoard.slotCount;
+constexpr int MAX_FEED_LOGS = kBoard.maxFeedLogs;
+
+
+// ---- HW objects ----
+RTC_DS1307 rtc;
+Display<kBoard> lcd;
+ServoActuator<kBoard> feedServo;
+WeightSensor<kBoard> scale;
+
+// ---- Serial console / binary protocol (serial_link.h) ----
+SerialLink<kBoard> console;
+uint8_t serialEvery = 0;     // SPC_STREAM: weight frame every Nth reading, 0 = none
+
+// ---- State ----
+bool showSlots = false;
+int  currentSlot = 0;
+float currentWeight = 0.0f;
+bool rtc_ok = false;
+
+// ---- Safety & stuck detection ----
+// Configured limits; each feed runs with limits learned from earlier feeds
+// within these bounds (flow_stats.h).
+const FeedLimits FEED_LIMITS = {
+  kBoard.feedTimeoutMs, kBoard.stuckWindowMs, kBoard.minIncreaseG
+};
+
+// ---- Slots ----
+FeedingSlot slots[SLOT_COUNT];
+CompiledRule slotRules[SLOT_COUNT];  // recompiled whenever a slot changes
+uint32_t slotMarkers[SLOT_COUNT];    // last occurrence handled (see checkSlotDue)
+
+void resetSlots() {
+  for (int i = 0; i < SLOT_COUNT; i++) {
+    slots[i] = {false, defaultSlotHour(i), 0, 0};
+    slotMarkers[i] = NO_MARKER;
+  }
+  compileSlots(slots, slotRules, SLOT_COUNT);
+}
+
+// ---- Persistent schedule (NVS) ----
+// Slots and markers survive a power cut, so occurrences missed while off are
+// caught up on boot according to each slot's policy.
+Preferences prefs;
+const uint32_t SCHEDULE_STORE_VERSION = 1;  // bump when FeedingSlot changes
+
+void saveSlots() {
+  prefs.putUInt("schedVer", SCHEDULE_STORE_VERSION);
+  prefs.putBytes("slots", slots, sizeof(slots));
+}
+
+void saveMarkers() {
+  prefs.putBytes("markers", slotMarkers, sizeof(slotMarkers));
+}
+
+void loadSchedule() {
+  if (prefs.getUInt("schedVer") != SCHEDULE_STORE_VERSION ||
+      prefs.getBytesLength("slots") != sizeof(slots)) {
+    return;  // nothing stored for this layout: keep defaults
+  }
+  prefs.getBytes("slots", slots, sizeof(slots));
+  if (prefs.getBytesLength("markers") == sizeof(slotMarkers)) {
+    prefs.getBytes("markers", slotMarkers, sizeof(slotMarkers));
+  }
+  compileSlots(slots, slotRules, SLOT_COUNT);
+}
+
+// ---- Feed journal (RTC memory + NVS) ----
+// RTC_NOINIT memory keeps its contents across every reset except power-on;
+// the CRC in the record tells garbage from a real journal.
+RTC_NOINIT_ATTR FeedJournal rtcJournal;
+const uint32_t JOURNAL_MAX_AGE_SECS = 15 * 60;  // older interrupted feeds are not resumed
+const uint32_t TASK_WDT_SECS = 8;               // loop() stalls longer than this reset the chip
+
+void saveJournalFlash() {
+  prefs.putBytes("journal", &rtcJournal, sizeof(rtcJournal));
+}
+
+// ---- Long-term history (SPIFFS) ----
+HistoryStore history;
+
+// ---- Feed recordings (SPIFFS, /api/recordings) ----
+// Raw scale counts and gate commands of every feed, for tools/replay.cpp.
+FeedRecSample recSamples[kBoard.recordSamples > 0 ? kBoard.recordSamples : 1];
+FeedRecorder  recorder;
+FeedRecStore  recStore;
+uint32_t      weightReadMs = 0;  // when currentWeight was read
+bool          weightFresh = false;  // and whether it came from a new conversion
+
+void saveRecording() {
+  if (recSeal(recorder) > 0 && !recStore.append(recorder.header, recorder.samples)) {
+    LOGW("Feed recording not saved");
+  }
+  recClear(recorder);
+}
+
+// ---- Hopper inventory ----
+// Persisted with the schedule so the level survives a reboot.
+static_assert(SLOT_COUNT <= HOPPER_MAX_SLOTS, "hopper forecast walks every slot");
+const uint32_t HOPPER_HORIZON_SECS = 30UL * 24 * 3600;
+HopperState    hopper;
+HopperForecast hopperForecast = {NO_FEEDING_TIME, 0, false};
+uint32_t       hopperForecastSchedule = 0;  // schedule version it was made for
+
+void saveHopper() {
+  prefs.putBytes("hopper", &hopper, sizeof(hopper));
+}
+
+void loadHopper() {
+  initHopper(hopper, kBoard.hopperCapacityG);
+  if (prefs.getBytesLength("hopper") == sizeof(hopper)) {
+    prefs.getBytes("hopper", &hopper, sizeof(hopper));
+    hopper.capacityG = kBoard.hopperCapacityG;
+  }
+}
+
+#if FEEDER_OTA
+// ---- OTA updates (/api/ota, ota_image.h) ----
+// The trial record and the last update's report are kept in NVS, so they
+// outlive the restart into the new image.
+const uint32_t OTA_WINDOW_BYTES = 16 * 1024;  // decoder window, allocated per update
+const uint32_t OTA_STALL_MS     = 10000;      // no data for this long aborts a download
+OtaTrial  otaTrial;
+OtaReport otaReport;
+
+void saveOtaState() {
+  prefs.putBytes("otaTrial", &otaTrial, sizeof(otaTrial));
+  prefs.putBytes("otaReport", &otaReport, sizeof(otaReport));
+}
+
+void loadOtaState() {
+  if (prefs.getBytesLength("otaTrial") == sizeof(otaTrial)) {
+    prefs.getBytes("otaTrial", &otaTrial, sizeof(otaTrial));
+  }
+  if (prefs.getBytesLength("otaReport") == sizeof(otaReport)) {
+    prefs.getBytes("otaReport", &otaReport, sizeof(otaReport));
+  }
+}
+
+// The Arduino core marks a new image valid at startup unless told otherwise;
+// ours is marked once it passes the health check
+bool verifyRollbackLater() { return true; }
+#endif
+
+// ---- Learned flow statistics (/api/flow) ----
+// Saved after each feed that taught something; the idle noise estimate
+// rides along.
+const uint32_t FLOW_STORE_VERSION = 1;  // bump when FlowStats changes
+FlowStats flowStats;
+
+void saveFlowStats() {
+  prefs.putUInt("flowVer", FLOW_STORE_VERSION);
+  prefs.putBytes("flow", &flowStats, sizeof(flowStats));
+}
+
+void loadFlowStats() {
+  initFlowStats(flowStats);
+  if (prefs.getUInt("flowVer") == FLOW_STORE_VERSION &&
+      prefs.getBytesLength("flow") == sizeof(flowStats)) {
+    prefs.getBytes("flow", &flowStats, sizeof(flowStats));
+  }
+}
+
+// ---- Feeds: queue, dispenser, gate (feed_control.h) ----
+// Set up by initFeeder(), with the hooks below checkScheduledFeeding().
+FeedCommand feedQueueStorage[kBoard.feedQueueDepth];
+FeedControl feeder;
+
+// ---- Feed history log ----
+FeedLogEntry feedLog[MAX_FEED_LOGS];
+int feedLogCount = 0;
+
+void addFeedLog(bool manual, int slotIndex, float target, float finalWeight, float dispensed,
+                bool completed);
+
+// ---- Feed rollups (/api/stats) ----
+// Updated by addFeedLog and saved with it, so the week survives a reboot.
+static_assert(SLOT_COUNT <= FEED_ROLLUP_SLOTS, "every slot gets a rollup row");
+const uint32_t ROLLUP_STORE_VERSION = 1;  // bump when FeedRollups changes
+FeedRollups feedRollups;
+
+void saveRollups() {
+  prefs.putUInt("rollupVer", ROLLUP_STORE_VERSION);
+  prefs.putBytes("rollups", &feedRollups, sizeof(feedRollups));
+}
+
+void loadRollups() {
+  initFeedRollups(feedRollups);
+  if (prefs.getUInt("rollupVer") == ROLLUP_STORE_VERSION &&
+      prefs.getBytesLength("rollups") == sizeof(feedRollups)) {
+    prefs.getBytes("rollups", &feedRollups, sizeof(feedRollups));
+  }
+}
+
+// ---- Load cell calibration (/api/calibration) ----
+// Offset and counts per gram, captured on request and followed by zero
+// tracking while the feeder is idle (scale_cal.h). Saved on each capture,
+// and each time tracking has moved the zero CAL_SAVE_DRIFT_G.
+const uint32_t CAL_STORE_VERSION   = 1;  // bump when ScaleCal changes
+const float    CAL_SAVE_DRIFT_G    = 1.0f;
+const uint32_t CAL_BOOT_TIMEOUT_MS = 3000;
+ScaleCal    scaleCal = {0, kBoard.calibrationFactor, 0};
+CalCapture  calCapture;
+ZeroTracker zeroTracker;
+int32_t     calSavedOffset = 0;
+
+void saveCalibration() {
+  prefs.putUInt("calVer", CAL_STORE_VERSION);
+  prefs.putBytes("scaleCal", &scaleCal, sizeof(scaleCal));
+  calSavedOffset = scaleCal.offset;
+}
+
+// False when nothing is stored: the empty bowl has not been zeroed yet
+bool loadCalibration() {
+  scaleCal = {0, kBoard.calibrationFactor, 0};
+  initCalCapture(calCapture);
+  initZeroTracker(zeroTracker, millis());
+  bool stored = prefs.getUInt("calVer") == CAL_STORE_VERSION &&
+                prefs.getBytesLength("scaleCal") == sizeof(scaleCal);
+  if (stored) prefs.getBytes("scaleCal", &scaleCal, sizeof(scaleCal));
+  calSavedOffset = scaleCal.offset;
+  return stored;
+}
+
+
+// ---- Setting UI ----
+enum SettingState {
+  NOT_SETTING,
+  SETTING_HOUR,
+  SETTING_MINUTE,
+  SETTING_WEIGHT,
+  SAVING
+};
+
+SettingState settingState = NOT_SETTING;
+int   tempHour   = 0;
+int   tempMinute = 0;
+float tempWeight = 0;
+
+// ---- Manual feeding mode ----
+float manualTempWeight  = 100;    // default manual amount when choosing (g)
+
+enum ManualState {
+  MANUAL_IDLE,
+  MANUAL_SET_WEIGHT
+};
+
+ManualState manualState = MANUAL_IDLE;
+
+// ---- Debounce ----
+unsigned long lastButtonPress = 0;
+const unsigned long debounceDelay = 200;
+
+// ---- Status section versions (delta /api/status) ----
+StatusVersions statusVersions;
+uint32_t lastReportedNextFeed = NO_FEEDING_TIME;
+
+// Rendered status documents shared by all clients (one render per change)
+char statusCacheStorage[STATUS_CACHE_ENTRIES * statusJsonCapacity(SLOT_COUNT, MAX_FEED_LOGS)];
+StatusCache statusCache;
+
+void markStateChanged()    { bumpStatusVersion(statusVersions, statusVersions.state); }
+void markScheduleChanged() {
+  compileSlots(slots, slotRules, SLOT_COUNT);
+  saveSlots();
+  bumpStatusVersion(statusVersions, statusVersions.schedule);
+}
+void markHistoryChanged()  { bumpStatusVersion(statusVersions, statusVersions.history); }
+
+// ---- Control-loop period stats (/api/loop) ----
+LoopStats loopStats;
+
+#if FEEDER_HTTP_API
+// ---- HTTP admission control (/api/admission) ----
+Admission admission;
+
+// False, with a bare 429 sent, for a request over its client's rate or the
+// tick budget; called before any argument is read.
+bool admit(AdmissionLane lane) {
+#if FEEDER_ADMISSION
+  uint32_t ip = server.client().remoteIP();
+  AdmitResult r = admitRequest(admission, ip, lane, millis(), feeder.active);
+  if (r != ADMIT_OK) {
+    server.sendHeader("Retry-After", String(admissionRetryAfterSecs(admission, ip, r)));
+    server.send(429, "text/plain", r == ADMIT_RATE ? "Too many requests" : "Busy");
+    return false;
+  }
+#else
+  admission.admitted[lane]++;
+#endif
+  return true;
+}
+#endif
+
+// ---- Event trace ring (dumped by /api/trace) ----
+TraceRecord traceStorage[kBoard.traceRecords];
+
+uint32_t traceClock() { return micros(); }
+uint8_t  traceContext() { return xPortInIsrContext() ? 0xFF : xPortGetCoreID(); }
+
+// ---- Log ring, drained by logTask (logger.h) ----
+LogRecord logStorage[kBoard.logRecords];
+char      logTailStorage[kBoard.logTailLines][LOG_LINE_MAX];
+LogTail   logTail;                 // newest lines for /api/logs, under logTailLock
+SemaphoreHandle_t logTailLock;
+LogStore  logStore;                // log task only
+volatile bool logFlashReady = false;  // SPIFFS mounted
+
+const size_t LOGS_PAGE_BYTES = 2048;  // /api/logs response, on the loop stack
+
+uint32_t logClock() { return millis(); }
+
+// ---- Forward decls ----
+DateTime currentTime();
+void updateDisplay();
+bool handleButtons();
+void handleSettingMode();
+void adjustSettingValue(int direction);
+void saveCurrentSlot();
+void initFeeder();
+void checkScheduledFeeding();
+FeedEnqueue queueFeed(uint8_t source, float amount, uint8_t mode = kBoard.dispenseMode);
+bool dispatchQueuedFeed();
+void monitorFeeding();
+uint32_t getNextFeedingTime(int* slotOut = nullptr);
+void resetSystemState();
+
+// API actions shared by the HTTP handlers and the serial commands: the
+// status code and text the HTTP endpoint replies with
+struct ApiReply {
+  uint16_t status;
+  char     msg[48];
+};
+ApiReply manualFeed(float amount, uint8_t mode);
+ApiReply setSlot(int index, const SlotEdit& e, const char* via);
+StatusView statusView();
+
+// Forward declarations for API handlers
+void handleIndexPage(const ApiArgs& args);
+void handleStatusApi(const ApiArgs& args);
+void handleLiveApi(const ApiArgs& args);
+void handleTraceApi(const ApiArgs& args);
+void handleExportApi(const ApiArgs& args);
+void handleRecordingsApi(const ApiArgs& args);
+void handleRecordingsClearApi(const ApiArgs& args);
+void handleManualFeedApi(const ApiArgs& args);
+void handleSetSlotApi(const ApiArgs& args);
+void handleQueueApi(const ApiArgs& args);
+void handleLoopApi(const ApiArgs& args);
+void handleAdmissionApi(const ApiArgs& args);
+void handleCalibrationStatusApi(const ApiArgs& args);
+void handleCalibrationApi(const ApiArgs& args);
+void handleFlowApi(const ApiArgs& args);
+void handleStatsApi(const ApiArgs& args);
+void handleResetApi(const ApiArgs& args);
+void handleHopperRefillApi(const ApiArgs& args);
+void handleSerialApi(const ApiArgs& args);
+void handleLogsApi(const ApiArgs& args);
+void handleOtaApi(const ApiArgs& args);
+void handleOtaStatusApi(const ApiArgs& args);
+void otaBootCheck();
+void otaCheckHealth();
+void handleSerialCommand(const SerialCommand& cmd);
+void recoverInterruptedFeed();
+void armTaskWatchdog();
+void logTask(void*);
+void logBootTime();
+
+#if FEEDER_HTTP_API
+// ---- API routes (api_request.h) ----
+// WebServer keeps no routes of its own: every request falls through to
+// dispatchApi(), which looks it up here. Sorted by path, then method; the
+// build fails otherwise. Manual feed and reset get the priority lane.
+typedef void (*ApiHandler)(const ApiArgs& args);
+
+constexpr ApiRoute<ApiHandler> kApiRoutes[] = {
+#if FEEDER_WEB_UI
+  {"/",                     API_GET,  LANE_READ,     handleIndexPage},
+#endif
+  {"/api/admission",        API_GET,  LANE_READ,     handleAdmissionApi},
+  {"/api/calibration",      API_GET,  LANE_READ,     handleCalibrationStatusApi},
+  {"/api/calibration",      API_POST, LANE_WRITE,    handleCalibrationApi},
+  {"/api/export",           API_GET,  LANE_READ,     handleExportApi},
+  {"/api/flow",             API_GET,  LANE_READ,     handleFlowApi},
+  {"/api/hopper/refill",    API_POST, LANE_WRITE,    handleHopperRefillApi},
+  {"/api/live",             API_GET,  LANE_READ,     handleLiveApi},
+  {"/api/logs",             API_GET,  LANE_READ,     handleLogsApi},
+  {"/api/loop",             API_GET,  LANE_READ,     handleLoopApi},
+  {"/api/manual-feed",      API_POST, LANE_PRIORITY, handleManualFeedApi},
+#if FEEDER_OTA
+  {"/api/ota",              API_GET,  LANE_READ,     handleOtaStatusApi},
+  {"/api/ota",              API_POST, LANE_WRITE,    handleOtaApi},
+#endif
+  {"/api/queue",            API_GET,  LANE_READ,     handleQueueApi},
+  {"/api/recordings",       API_GET,  LANE_READ,     handleRecordingsApi},
+  {"/api/recordings/clear", API_POST, LANE_WRITE,    handleRecordingsClearApi},
+  {"/api/reset",            API_POST, LANE_PRIORITY, handleResetApi},
+  {"/api/serial",           API_GET,  LANE_READ,     handleSerialApi},
+  {"/api/set-slot",         API_POST, LANE_WRITE,    handleSetSlotApi},
+  {"/api/stats",            API_GET,  LANE_READ,     handleStatsApi},
+  {"/api/status",           API_GET,  LANE_READ,     handleStatusApi},
+  {"/api/trace",            API_GET,  LANE_READ,     handleTraceApi},
+};
+static_assert(apiRoutesSorted(kApiRoutes), "kApiRoutes must be sorted by path, then method");
+
+// The request being handled (loop task only). WebServer has split and
+// decoded the arguments already; they are copied here once, and handlers
+// read them typed and range-checked from the copy.
+const size_t API_ARG_BYTES = 512;
+char    apiArgArena[API_ARG_BYTES];
+ApiArgs apiArgs;
+
+void dispatchApi() {
+  const ApiRoute<ApiHandler>* route = nullptr;
+  HTTPMethod m = server.method();
+  if (m == HTTP_GET || m == HTTP_POST) {
+    route = findApiRoute(kApiRoutes, m == HTTP_POST ? API_POST : API_GET, server.uri().c_str());
+  }
+  if (!route) {
+    server.send(404, "text/plain", "Not found");
+    return;
+  }
+  if (!admit(route->lane)) return;
+
+  initApiArgs(apiArgs, apiArgArena, sizeof(apiArgArena));
+  for (int i = 0; i < server.args(); i++) {
+    String name = server.argName(i);
+    if (name == "plain") continue;  // a raw request body; no handler takes one
+    String value = server.arg(i);
+    addApiArg(apiArgs, name.c_str(), name.length(), value.c_str(), value.length());
+  }
+  if (apiArgs.truncated) {
+    server.send(400, "text/plain", "Too many arguments");
+    return;
+  }
+  route->handler(apiArgs);
+}
+
+// 400 with formatArgError()'s text unless `r` is ARG_OK, or ARG_MISSING
+// for an optional argument
+bool argAccepted(ArgResult r, const char* name, bool optional = false) {
+  if (r == ARG_OK || (optional && r == ARG_MISSING)) return true;
+  char msg[48];
+  formatArgError(msg, sizeof(msg), name, r);
+  server.send(400, "text/plain", msg);
+  return false;
+}
+#endif
+
+// RTC time, or a ticking placeholder when the RTC is missing
+DateTime currentTime() {
+  return rtc_ok ? rtc.now()
+                : DateTime(2025, 1, 1, 0, 0, (millis()/1000) % 60);
+}
+
+void recordWeightSample() {
+  if (!rtc_ok) return;  // records are searched by time; skip without a clock
+  HistoryRecord r = {};
+  r.time = currentTime().unixtime();
+  r.kind = HIST_WEIGHT;
+  r.weightDg = (int32_t)lroundf(currentWeight * 10.0f);
+  history.append(r);
+}
+
+// Re-projects the hopper against the schedule; a changed forecast is a
+// state change for clients, and the first "low" is announced once.
+void updateHopperForecast() {
+  HopperForecast f = forecastHopper(hopper, slotRules, SLOT_COUNT, currentTime().unixtime(),
+                                    HOPPER_HORIZON_SECS, kBoard.hopperWarnHours * 3600UL);
+  hopperForecastSchedule = statusVersions.schedule;
+  if (f.emptyAt == hopperForecast.emptyAt && f.feedsLeft == hopperForecast.feedsLeft &&
+      f.low == hopperForecast.low) {
+    return;
+  }
+  if (f.low && !hopperForecast.low) {
+    LOGW("Hopper low (%.0fg left, %u full feeds) - refill soon",
+         hopper.remainingG, f.feedsLeft);
+  }
+  hopperForecast = f;
+  markStateChanged();
+}
+
+void refillHopper(float grams) {
+  hopperRefill(hopper, grams, currentTime().unixtime());
+  saveHopper();
+  markStateChanged();
+  updateHopperForecast();
+  LOGI("Hopper refilled: %.0fg", hopper.remainingG);
+}
+
+// A capture ended: keep what it measured
+void finishCalibration() {
+  LOGI("Calibration %s: %s (offset %ld, %.2f counts/g)", calStepName(calCapture.lastStep),
+       calResultName(calCapture.result), (long)scaleCal.offset, scaleCal.countsPerGram);
+  if (calCapture.result != CAL_OK) return;
+  if (calCapture.lastStep == CAL_SPAN) scaleCal.spanTime = currentTime().unixtime();
+  saveCalibration();
+}
+
+// Each new conversion goes to the capture in progress, or else to zero
+// tracking, which only moves the zero with the feeder idle
+void updateCalibration(int32_t raw) {
+  uint32_t now = millis();
+  if (calCapture.step != CAL_NONE) {
+    zeroTrack(zeroTracker, scaleCal, raw, false, now);
+    if (calCaptureSample(calCapture, scaleCal, raw)) finishCalibration();
+    return;
+  }
+  bool idle = !feeder.active && feeder.opening == 0;
+  if (zeroTrack(zeroTracker, scaleCal, raw, idle, now) &&
+      abs(scaleCal.offset - calSavedOffset) >= CAL_SAVE_DRIFT_G * fabsf(scaleCal.countsPerGram)) {
+    saveCalibration();
+  }
+}
+
+// === OPTION A: weight source wrapper ===
+// Returns either simulated weight (Wokwi) or real HX711 reading (hardware),
+// depending on kBoard.simFakeWeight. Never waits for the HX711: without a
+// new conversion the last one stands.
+float readWeight() {
+  TRACE_SCOPE(TRACE_HX711_READ);
+  weightFresh = scale.poll();
+  if (weightFresh) updateCalibration(scale.sample());
+  return scaleGrams(scaleCal, scale.raw());
+}
+
+// Setup only: waits for a full set of conversions to average, as
+// read_average() used to, so the first reading means something
+void settleWeight() {
+  unsigned long start = millis();
+  for (int n = 0; n < kBoard.hx711Samples && millis() - start < CAL_BOOT_TIMEOUT_MS;) {
+    if (scale.poll()) n++;
+    else delay(5);
+  }
+}
+
+// First boot: zero the empty bowl before anything reads it, as tare() used
+// to on every boot. If it has not settled by the deadline, loop() finishes it.
+void captureBootZero() {
+  startCalCapture(calCapture, CAL_ZERO, 0);
+  unsigned long start = millis();
+  while (calCapture.step != CAL_NONE && millis() - start < CAL_BOOT_TIMEOUT_MS) {
+    if (!scale.poll()) {
+      delay(5);
+      continue;
+    }
+    if (calCaptureSample(calCapture, scaleCal, scale.sample())) finishCalibration();
+  }
+}
+
+// A feed was in flight when the chip reset: reconcile the journal with the
+// bowl and finish the portion, or log the feed as it ended.
+void recoverInterruptedFeed() {
+  FeedJournal stored = {};
+  if (prefs.getBytesLength("journal") == sizeof(stored)) {
+    prefs.getBytes("journal", &stored, sizeof(stored));
+  }
+  const FeedJournal* j = newestJournal(rtcJournal, stored);
+  if (!j) {
+    // Fresh RTC memory: continue the sequence after the flash copy
+    if (stored.seq > rtcJournal.seq) rtcJournal.seq = stored.seq;
+    journalClear(rtcJournal);
+    return;
+  }
+  FeedJournal interrupted = *j;
+
+  currentWeight = readWeight();
+  JournalResume r = reconcileJournal(interrupted, currentWeight, currentTime().unixtime(),
+                                     JOURNAL_MAX_AGE_SECS, kBoard.minIncreaseG);
+  LOGW("Feed interrupted by reset (reason %d): %.1f of %.1fg dispensed",
+       (int)esp_reset_reason(), r.dispensed, interrupted.amount);
+  hopperDispensed(hopper, r.dispensed);
+  saveHopper();
+
+  rtcJournal = interrupted;
+  if (r.action == JOURNAL_RESUME) {
+    LOGI("Resuming: %.1fg to go", r.remaining);
+    FeedCommand cmd = {};
+    cmd.source = interrupted.manual ? FEED_SRC_MANUAL : FEED_SRC_SCHEDULED;
+    cmd.slotIndex = interrupted.slot;
+    cmd.amount = r.remaining;
+    cmd.mode = kBoard.dispenseMode;
+    startFeed(feeder, cmd, currentWeight, millis());
+    // Keep the original start time and count the resume
+    journalBegin(rtcJournal, rtcJournal.seq + 1, interrupted.startTime, interrupted.slot,
+                 interrupted.manual, feeder.startWeight, r.remaining, interrupted.resumes + 1);
+    saveJournalFlash();
+    return;
+  }
+
+  bool complete = r.action == JOURNAL_COMPLETE;
+  LOGI("%s", complete ? "Portion was already delivered" : "Feed abandoned");
+  float target = interrupted.startWeight + interrupted.amount;
+  addFeedLog(interrupted.manual, interrupted.slot, target, currentWeight, r.dispensed, complete);
+
+  HistoryRecord rec = {};
+  rec.time = currentTime().unixtime();
+  rec.kind = HIST_FEED;
+  rec.manual = interrupted.manual;
+  rec.slot = interrupted.slot;
+  rec.outcome = complete ? (uint8_t)FEED_TARGET_REACHED : HIST_ABORTED;
+  rec.weightDg = (int32_t)lroundf(currentWeight * 10.0f);
+  rec.targetDg = (int32_t)lroundf(target * 10.0f);
+  if (rtc_ok) history.append(rec);
+
+  journalClear(rtcJournal);
+  saveJournalFlash();
+}
+
+// Task watchdog on the loop task: a hang anywhere in loop() (I2C, HX711,
+// a handler) resets the chip within TASK_WDT_SECS, and the journal picks
+// up any feed that was in flight.
+void armTaskWatchdog() {
+#if ESP_IDF_VERSION_MAJOR >= 5
+  esp_task_wdt_config_t cfg = {};
+  cfg.timeout_ms = TASK_WDT_SECS * 1000;
+  cfg.trigger_panic = true;
+  esp_task_wdt_reconfigure(&cfg);
+#else
+  esp_task_wdt_init(TASK_WDT_SECS, true);
+#endif
+  esp_task_wdt_add(NULL);
+}
+
+// Formats what the firmware logged and hands each line to the sinks: the
+// serial console, the /api/logs tail and, up to logFlashLevel, the flash
+// log. Errors reach flash straight away; the rest is batched.
+void drainLog() {
+  static uint32_t reportedDrops = 0;
+  static uint32_t lastFlushMs = 0;
+  char line[LOG_LINE_MAX];
+  LogRecord r;
+  while (logPop(r)) {
+    size_t n = logFormatLine(r, line, sizeof(line));
+    console.line(line, n);
+    xSemaphoreTake(logTailLock, portMAX_DELAY);
+    logTailAppend(logTail, line);
+    xSemaphoreGive(logTailLock);
+    if (logFlashReady && r.level <= kBoard.logFlashLevel) {
+      logStore.add(line, n);
+      if (r.level == LOG_LEVEL_ERROR) logStore.flush();
+    }
+  }
+  if (logStore.pending() && millis() - lastFlushMs >= LogStore::FLUSH_MS) {
+    logStore.flush();
+    lastFlushMs = millis();
+  }
+
+  // The ring has room again now; say how much was lost
+  uint32_t dropped = logStats().dropped;
+  if (dropped != reportedDrops) {
+    LOGW("Log ring full: %lu line(s) dropped", (unsigned long)(dropped - reportedDrops));
+    reportedDrops = dropped;
+  }
+}
+
+void logTask(void*) {
+  for (;;) {
+    drainLog();
+    vTaskDelay(pdMS_TO_TICKS(LOG_DRAIN_MS));
+  }
+}
+
+// Time from app start to the end of setup() and the features built in; the
+// ROM and bootloader come before millis() starts. `size_report.py boot`
+// picks this line up to fill in the boot column of the size report.
+void logBootTime() {
+  LOGI(FEEDER_BOOT_LOG_FORMAT, millis());
+}
+
+void setup() {
+  traceInit(traceStorage, kBoard.traceRecords, traceClock, traceContext);
+  initStatusVersions(statusVersions, esp_random() & 0xFFFF);
+  initStatusCache(statusCache, statusCacheStorage,
+                  statusJsonCapacity(SLOT_COUNT, MAX_FEED_LOGS));
+#if FEEDER_HTTP_API
+  initAdmission(admission, {kBoard.httpClientRate, kBoard.httpClientBurst, kBoard.httpTickBudget});
+#endif
+  console.begin(115200);
+  logInit(logStorage, kBoard.logRecords, logClock);
+  initLogTail(logTail, logTailStorage, kBoard.logTailLines);
+  logTailLock = xSemaphoreCreateMutex();
+  // Core 0 next to the WiFi stack, below everything else, so the loop on
+  // core 1 never waits for a log line to go out
+  xTaskCreatePinnedToCore(logTask, "log", 4096, nullptr, tskIDLE_PRIORITY + 1, nullptr, 0);
+
+  // Match your wiring (SDA=21, SCL=22)
+  Wire.begin(kBoard.i2cSdaPin, kBoard.i2cSclPin);
+
+#if FEEDER_BUTTONS
+  if (kBoard.hasButtons) {
+    pinMode(BUTTON_DISPLAY, INPUT_PULLUP);
+    pinMode(BUTTON_SETTING, INPUT_PULLUP);
+    pinMode(BUTTON_UP,      INPUT_PULLUP);
+    pinMode(BUTTON_DOWN,    INPUT_PULLUP);
+  }
+#endif
+
+  resetSlots();
+  prefs.begin("feeder", false);
+#if FEEDER_OTA
+  otaBootCheck();  // first: an image on trial that keeps resetting goes no further
+#endif
+  loadSchedule();
+  loadHopper();
+  loadFlowStats();
+  loadRollups();
+  bool calStored = loadCalibration();
+  if (SPIFFS.begin(true)) {
+    history.begin();
+    logFlashReady = true;
+  } else {
+    LOGE("SPIFFS mount failed: history disabled");
+  }
+  initFeeder();
+  initFeedRecorder(recorder, recSamples, kBoard.recordSamples);
+
+  lcd.init();
+  lcd.backlight();
+  lcd.setCursor(0, 0);
+  lcd.print("Pet Feeder v2.0");
+  lcd.setCursor(0, 1);
+  lcd.print("Initializing...");
+
+  rtc_ok = rtc.begin();
+  if (!rtc_ok) {
+    LOGE("RTC not found! (check 5V & I2C)");
+    lcd.setCursor(0, 2);
+    lcd.print("RTC not found!");
+  } else if (!rtc.isrunning()) {
+    LOGW("RTC not running, setting compile time...");
+    rtc.adjust(DateTime(F(__DATE__), F(__TIME__)));
+  }
+
+  feedServo.begin();
+  scale.begin();
+  if (calStored) settleWeight();
+  else captureBootZero();
+
+#if FEEDER_HTTP_API
+  // --- WiFi setup (Wokwi) ---
+  // Not waited for: the schedule runs from the RTC, and the server answers
+  // once the station has an address.
+  WiFi.onEvent([](WiFiEvent_t, WiFiEventInfo_t) {
+    LOGI("WiFi connected after %lu ms. IP: %s", millis(), WiFi.localIP().toString().c_str());
+  }, ARDUINO_EVENT_WIFI_STA_GOT_IP);
+  WiFi.mode(WIFI_STA);
+  WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+  LOGI("Connecting to WiFi (%s)", WIFI_SSID);
+
+  // HTTP routes are kApiRoutes, dispatched by dispatchApi()
+  server.onNotFound(dispatchApi);
+
+  const char* headerKeys[] = {"If-None-Match", "Accept", "Authorization"};
+  server.collectHeaders(headerKeys, 3);
+
+  server.begin();
+  LOGI("HTTP server started.");
+#endif
+
+  if (kBoard.hasLcd) {
+    delay(800);  // splash
+    lcd.clear();
+  }
+
+  // Last, so a resumed feed is monitored by loop() straight away
+  recoverInterruptedFeed();
+  armTaskWatchdog();
+
+  LOGI("Pet Feeding System Ready! (%s)", kBoard.name);
+  logBootTime();
+  if (kBoard.hasButtons) {
+    LOGI("RED=Display | GREEN=Setting/Manual | BLUE UP/DOWN=Navigate");
+  }
+
+
+}
+
+void loop() {
+  TRACE_SCOPE(TRACE_LOOP);
+  recordLoopStart(loopStats, micros());
+  esp_task_wdt_reset();
+
+#if FEEDER_HTTP_API
+  {
+    TRACE_SCOPE(TRACE_HTTP_CLIENT);
+    server.handleClient();
+  }
+#endif
+  SerialCommand cmd;
+  if (console.poll(cmd)) handleSerialCommand(cmd);
+
+  // Use wrapper (sim or real)
+  currentWeight = readWeight();
+  weightReadMs = millis();
+
+  static uint8_t readingsUnsent = 0;
+  if (weightFresh && serialEvery > 0 && ++readingsUnsent >= serialEvery) {
+    console.weight(weightReadMs, scale.raw(), currentWeight, feeder.opening,
+                   feeder.active ? SW_FEEDING : 0);
+    readingsUnsent = 0;
+  }
+
+  // Reading-to-reading jitter with nothing moving is the scale's noise;
+  // a pass without a new conversion has none to offer
+  static float lastIdleWeight = NAN;
+  if (weightFresh && !feeder.active && feeder.opening == 0) {
+    if (!isnan(lastIdleWeight)) {
+      learnIdleNoise(flowStats, lastIdleWeight, currentWeight, FEED_LIMITS.minIncreaseG);
+    }
+    lastIdleWeight = currentWeight;
+  } else if (feeder.active || feeder.opening > 0) {
+    lastIdleWeight = NAN;
+  }
+
+#if FEEDER_BUTTONS
+  // Simple debounce guard
+  if (millis() - lastButtonPress < debounceDelay) return;
+
+  // --- BUTTON HANDLING ---
+  if (kBoard.hasButtons && handleButtons()) return;
+#endif
+
+  // --- Main logic ---
+  // Due slots are queued even mid-feed or while editing; they run once the
+  // dispenser is free.
+  checkScheduledFeeding();
+  dispatchQueuedFeed();
+
+  if (feeder.active) {
+    monitorFeeding();
+  }
+
+  // After the monitor, so the sample carries the gate command of this pass
+  recSample(recorder, weightReadMs, scale.raw(), feeder.opening);
+  if (recorder.state == REC_DONE) saveRecording();
+
+  static unsigned long lastScreenUpdate = 0;
+  if (millis() - lastScreenUpdate > 1000) {
+    // nextTime moves on as slots pass; clients see it as a state change
+    uint32_t nextFeed = getNextFeedingTime();
+    if (nextFeed != lastReportedNextFeed) {
+      lastReportedNextFeed = nextFeed;
+      markStateChanged();
+      updateHopperForecast();
+    } else if (hopperForecastSchedule != statusVersions.schedule) {
+      updateHopperForecast();
+    }
+
+    if (settingState == NOT_SETTING && manualState == MANUAL_IDLE) {
+      updateDisplay();
+    }
+    lastScreenUpdate = millis();
+
+#if FEEDER_OTA
+    if (otaTrial.active) otaCheckHealth();
+#endif
+
+    static unsigned long lastWeightSample = 0;
+    if (millis() - lastWeightSample >= kBoard.historySampleSecs * 1000UL) {
+      recordWeightSample();
+      lastWeightSample = millis();
+    }
+  }
+
+  delay(50);
+}
+
+#if FEEDER_BUTTONS
+// --- Buttons: returns true when a press was handled this pass ---
+bool handleButtons() {
+  // RED: display toggle (main <-> slots)
+  if (digitalRead(BUTTON_DISPLAY) == LOW) {
+    if (settingState == NOT_SETTING && manualState == MANUAL_IDLE) {
+      showSlots = !showSlots;
+      updateDisplay();
+      LOGD("Display mode: %s", showSlots ? "Slots" : "Main");
+    }
+    lastButtonPress = millis();
+    return true;
+  }
+
+  // GREEN: settings / manual feed
+  if (digitalRead(BUTTON_SETTING) == LOW) {
+
+    // 1) If we are currently choosing manual feed amount -> confirm & start
+    if (manualState == MANUAL_SET_WEIGHT) {
+      manualState = MANUAL_IDLE;
+      queueFeed(FEED_SRC_MANUAL, manualTempWeight);
+      dispatchQueuedFeed();
+    }
+    // 2) If on slots screen -> use normal slot setting mode
+    else if (showSlots) {
+      handleSettingMode();
+    }
+    // 3) If on main screen & not editing slots -> enter manual feed setup
+    else if (settingState == NOT_SETTING && !showSlots) {
+      manualState = MANUAL_SET_WEIGHT;
+      if (manualTempWeight <= 0) manualTempWeight = 100; // default
+      LOGD("Manual feed setup started");
+      updateDisplay();
+    }
+    // Fallback: normal setting handler
+    else {
+      handleSettingMode();
+    }
+
+    lastButtonPress = millis();
+    return true;
+  }
+
+  // UP + DOWN together on the main screen: hopper refilled
+  if (digitalRead(BUTTON_UP) == LOW && digitalRead(BUTTON_DOWN) == LOW) {
+    if (settingState == NOT_SETTING && manualState == MANUAL_IDLE && !showSlots) {
+      refillHopper(0);
+      updateDisplay();
+    }
+    lastButtonPress = millis();
+    return true;
+  }
+
+  // UP
+  if (digitalRead(BUTTON_UP) == LOW) {
+
+    if (manualState == MANUAL_SET_WEIGHT) {
+      manualTempWeight += 10;           // +10g per press
+      if (manualTempWeight > 5000) manualTempWeight = 5000; // cap at 5kg
+      updateDisplay();
+    }
+    else if (settingState == NOT_SETTING && showSlots) {
+      currentSlot = (currentSlot - 1 + SLOT_COUNT) % SLOT_COUNT;
+      updateDisplay();
+      LOGD("UP - Selected slot: %d", currentSlot + 1);
+    }
+    else if (settingState != NOT_SETTING) {
+      adjustSettingValue(1);
+      updateDisplay();
+    }
+
+    lastButtonPress = millis();
+    return true;
+  }
+
+  // DOWN
+  if (digitalRead(BUTTON_DOWN) == LOW) {
+
+    if (manualState == MANUAL_SET_WEIGHT) {
+      manualTempWeight -= 10;       // -10g per press
+      if (manualTempWeight < 0) manualTempWeight = 0;
+      updateDisplay();
+    }
+    else if (settingState == NOT_SETTING && showSlots) {
+      currentSlot = (currentSlot + 1) % SLOT_COUNT;
+      updateDisplay();
+      LOGD("DOWN - Selected slot: %d", currentSlot + 1);
+    }
+    else if (settingState != NOT_SETTING) {
+      adjustSettingValue(-1);
+      updateDisplay();
+    }
+
+    lastButtonPress = millis();
+    return true;
+  }
+
+  return false;
+}
+#endif
+
+// --- Scheduled feeding check ---
+// Edge-triggered: anything that came due since the last check is handled,
+// late occurrences per the slot's catch-up policy.
+void checkScheduledFeeding() {
+  if (!rtc_ok) return;  // no wall clock, no schedule
+
+  if (checkScheduledFeeds(feeder, slotRules, slotMarkers, SLOT_COUNT,
+                          currentTime().unixtime(), millis())) {
+    saveMarkers();
+  }
+}
+
+// --- Feeds (feed_control.h) ---
+// What the feed orchestration does to this board: servo and simulated
+// scale, NVS, the history file, the LCD, the console and the log.
+void logFeedRequest(uint8_t source, float amount, uint8_t mode, FeedEnqueue result) {
+  LOGI("Feed request (%s, %.0fg, %s): %s, %d waiting",
+       feedSourceName(source), amount, dispenseModeName(mode),
+       result == FEED_QUEUED    ? "queued" :
+       result == FEED_MERGED    ? "merged" :
+       result == FEED_DUPLICATE ? "duplicate" : "queue full",
+       feeder.queue.count);
+}
+
+// Commands the gate; the simulated scale follows it
+void feederGate(void*, uint8_t pct) {
+  TRACE_SCOPE(pct > 0 ? TRACE_SERVO_OPEN : TRACE_SERVO_CLOSE);
+  feedServo.setOpening(pct);
+  scale.gate(pct);
+}
+
+void feederSave(void*, uint8_t what) {
+  if (what & FEED_SAVE_JOURNAL) saveJournalFlash();
+  if (what & FEED_SAVE_HOPPER) saveHopper();
+  if (what & FEED_SAVE_FLOW) saveFlowStats();
+}
+
+uint32_t feederClock(void*) {
+  return currentTime().unixtime();
+}
+
+// Someone is editing on the LCD: queued feeds wait
+bool feederHeld(void*) {
+  return settingState != NOT_SETTING || manualState != MANUAL_IDLE;
+}
+
+void feederRecord(void*, const HistoryRecord& r) {
+  if (r.outcome == HIST_SKIPPED_EMPTY) {
+    LOGW("SLOT%d skipped: hopper empty (%.0fg needed) - refill and press Refilled",
+         r.slot + 1, r.targetDg / 10.0f);
+  }
+  HistoryRecord rec = r;  // append() numbers it
+  if (rtc_ok) history.append(rec);
+}
+
+void feederDue(void*, int slot, const DueFeed& due, FeedEnqueue queued) {
+  if (due.kind == DUE_SKIPPED) {
+    LOGW("Slot %d (%02d:%02d) missed, skipped",
+         slot + 1, hourOf(due.fireTime), minuteOf(due.fireTime));
+    return;
+  }
+  if (due.kind == DUE_LATE) {
+    LOGI("Slot %d (%02d:%02d) caught up %lu min late: %.0fg",
+         slot + 1, hourOf(due.fireTime), minuteOf(due.fireTime),
+         (unsigned long)(currentTime().unixtime() - due.fireTime) / 60, due.amount);
+  }
+  logFeedRequest(FEED_SRC_SCHEDULED, due.amount, feeder.cfg.mode, queued);
+}
+
+// Recording of the feed about to open the gate; a previous one still
+// settling is saved as it is
+void beginRecording() {
+  if (recorder.state == REC_SETTLING || recorder.state == REC_DONE) saveRecording();
+  FeedRecHeader h = {};
+  h.seq = rtcJournal.seq;
+  h.time = currentTime().unixtime();
+  h.target = feeder.progress.target;
+  h.startWeight = feeder.startWeight;
+  h.scale = scaleCal.countsPerGram;
+  h.offset = scaleCal.offset;
+  h.timeoutMs = feeder.limits.timeoutMs;
+  h.stuckWindowMs = feeder.limits.stuckWindowMs;
+  h.minIncreaseG = feeder.limits.minIncreaseG;
+  h.mode = feeder.dispenser.mode;
+  recBegin(recorder, h, millis());
+}
+
+void feederStarted(void*) {
+  TRACE_INSTANT(TRACE_FEED_START, (int32_t)feeder.progress.target);
+  markStateChanged();
+  if (feeder.manual) {
+    LOGI("Manual feeding started");
+    LOGI("Manual target: %.0fg (current %.1f + %.1f)", feeder.progress.target,
+         feeder.startWeight, feeder.progress.target - feeder.startWeight);
+  } else {
+    LOGI("Feeding started from SLOT%d", feeder.slot + 1);
+    LOGI("Target weight: %.0fg (timeout %lums, stuck after %lums)", feeder.progress.target,
+         (unsigned long)feeder.limits.timeoutMs, (unsigned long)feeder.limits.stuckWindowMs);
+  }
+
+  beginRecording();
+  console.state(SE_FEED_START, feeder.dispenser.mode, feeder.slot, feeder.progress.target,
+                currentWeight);
+  LOGI("Feeder opening (%s profile, %d%%)",
+       dispenseModeName(feeder.dispenser.mode), feeder.dispenser.opening);
+  updateDisplay();
+}
+
+void feederFinished(void*, const FeedOutcome& o) {
+  TRACE_INSTANT(TRACE_FEED_STOP, o.reason);
+  switch (o.reason) {
+    case FEED_TARGET_REACHED:
+      LOGI("Target reached: %.1fg >= %.1fg", o.finalWeight, o.target);
+      break;
+    case FEED_STUCK:
+      LOGW("No weight increase detected → stopping (stuck?)");
+      break;
+    case FEED_TIMEOUT:
+      LOGW("Feed timeout reached → stopping");
+      break;
+    default:
+      break;
+  }
+  recClose(recorder, o.reason, millis());
+  addFeedLog(o.manual, o.slot, o.target, o.finalWeight, o.dispensed,
+             o.reason == FEED_TARGET_REACHED);
+  console.state(SE_FEED_END, o.reason, o.slot, o.target, o.finalWeight);
+  markStateChanged();
+
+  LOGI("Feeding complete!");
+  updateHopperForecast();
+
+  if (kBoard.hasLcd) {
+    lcd.clear();
+    lcd.setCursor(0, 1);
+    lcd.print("  Feeding Complete!");
+    delay(3000);
+  }
+}
+
+void initFeeder() {
+  FeedHooks hooks = {};
+  hooks.gate = feederGate;
+  hooks.save = feederSave;
+  hooks.clock = feederClock;
+  hooks.held = feederHeld;
+  hooks.record = feederRecord;
+  hooks.started = feederStarted;
+  hooks.finished = feederFinished;
+  hooks.due = feederDue;
+  FeedConfig cfg = {FEED_LIMITS, kBoard.feedMaxWaitMs, kBoard.dispenseMode};
+  initFeedControl(feeder, cfg, feedQueueStorage, kBoard.feedQueueDepth, flowStats, hopper,
+                  rtcJournal, calCapture, hooks);
+}
+
+// --- Feed queue ---
+// Manual and API feeds; scheduled ones come from checkScheduledFeeding()
+FeedEnqueue queueFeed(uint8_t source, float amount, uint8_t mode) {
+  FeedEnqueue result = requestFeed(feeder, source, -1, amount, mode, millis());
+  logFeedRequest(source, amount, mode, result);
+  return result;
+}
+
+// Starts the next queued feed if the dispenser is free
+bool dispatchQueuedFeed() {
+  uint32_t expired = feeder.queue.expired;
+  bool started = dispatchFeed(feeder, currentWeight, millis());
+  if (feeder.queue.expired != expired) {
+    LOGW("%lu queued feed(s) expired", (unsigned long)(feeder.queue.expired - expired));
+  }
+  return started;
+}
+
+// --- Feeding monitor (scheduled + manual) ---
+void monitorFeeding() {
+  if (!feeder.active) return;
+
+  TRACE_COUNTER(TRACE_WEIGHT, (int32_t)(currentWeight * 10));
+  if (stepFeed(feeder, currentWeight, millis()) != FEED_CONTINUE) return;
+
+  // Occasional log
+  static unsigned long lastPrint = 0;
+  if (millis() - lastPrint > 3000) {
+    LOGI("Feeding... %.1fg / %.1fg (t+%lus)", currentWeight, feeder.progress.target,
+         (millis() - feeder.progress.startMs) / 1000);
+    lastPrint = millis();
+  }
+}
+
+void resetSystemState() {
+  resetFeedControl(feeder, millis());
+  manualState = MANUAL_IDLE;
+  settingState = NOT_SETTING;
+  showSlots = false;
+
+  currentWeight = 0;
+  recClear(recorder);
+
+  resetSlots();
+
+  clearFeedLog(feedLog, MAX_FEED_LOGS, feedLogCount);
+  initFeedRollups(feedRollups);
+  saveRollups();
+
+  markStateChanged();
+  markScheduleChanged();
+  markHistoryChanged();
+  saveMarkers();
+
+  // The bowl is taken to be empty again: zero it, as the old tare() did
+  scale.reset();
+  startCalCapture(calCapture, CAL_ZERO, 0);
+
+  console.state(SE_RESET, 0, -1, 0, 0);
+  updateDisplay();
+}
+
+#if FEEDER_BUTTONS
+void handleSettingMode() {
+  if (showSlots && settingState == NOT_SETTING) {
+    settingState = SETTING_HOUR;
+    tempHour   = slots[currentSlot].hour;
+    tempMinute = slots[currentSlot].minute;
+    tempWeight = slots[currentSlot].weight;
+    LOGD("Setting mode started - Hour");
+  } else if (settingState != NOT_SETTING) {
+    switch (settingState) {
+      case SETTING_HOUR:
+        settingState = SETTING_MINUTE;
+        LOGD("Setting minute");
+        break;
+      case SETTING_MINUTE:
+        settingState = SETTING_WEIGHT;
+        LOGD("Setting weight");
+        break;
+      case SETTING_WEIGHT:
+        settingState = SAVING;
+        saveCurrentSlot();
+        LOGD("Settings saved");
+        break;
+      case SAVING:
+        settingState = NOT_SETTING;
+        LOGD("Setting mode ended");
+        break;
+    }
+  }
+  updateDisplay();
+}
+
+void adjustSettingValue(int direction) {
+  switch (settingState) {
+    case SETTING_HOUR:
+      tempHour += direction;
+      if (tempHour < 0) tempHour = 23;
+      if (tempHour > 23) tempHour = 0;
+      break;
+    case SETTING_MINUTE:
+      tempMinute += direction;
+      if (tempMinute < 0) tempMinute = 59;
+      if (tempMinute > 59) tempMinute = 0;
+      break;
+    case SETTING_WEIGHT:
+      tempWeight += direction * 100;     // step by 100g
+      if (tempWeight < 0)    tempWeight = 0;
+      if (tempWeight > 9999) tempWeight = 9999;
+      break;
+    default:
+      break;
+  }
+}
+
+void saveCurrentSlot() {
+  slots[currentSlot].hour   = tempHour;
+  slots[currentSlot].minute = tempMinute;
+  slots[currentSlot].weight = tempWeight;
+  slots[currentSlot].active = (tempWeight > 0);
+  slots[currentSlot].cron[0] = '\0';  // a time set on the LCD replaces any cron rule
+  slotMarkers[currentSlot] = NO_MARKER;  // an edited slot starts from now, no catch-up
+  markScheduleChanged();
+  saveMarkers();
+
+  LOGI("Slot %d saved: %02d:%02d, %.0fg",
+       currentSlot + 1, tempHour, tempMinute, tempWeight);
+}
+#endif
+
+// Unix time of the next slot, or NO_FEEDING_TIME
+uint32_t getNextFeedingTime(int* slotOut) {
+  return nextFeedingTime(slotRules, SLOT_COUNT, currentTime().unixtime(), slotOut);
+}
+
+void updateDisplay() {
+  if (!kBoard.hasLcd) return;
+  TRACE_SCOPE(TRACE_LCD_FLUSH);
+
+  DateTime now = currentTime();
+  lcd.clear();
+
+  // --- Manual feeding weight selection screen ---
+  if (manualState == MANUAL_SET_WEIGHT) {
+    lcd.setCursor(0, 0);
+    lcd.print("  Manual Feeding  ");
+
+    lcd.setCursor(0, 1);
+    lcd.print("Amount: ");
+    lcd.print((int)manualTempWeight);
+    lcd.print("g   ");
+
+    lcd.setCursor(0, 2);
+    lcd.print("UP/DOWN: adjust");
+
+    lcd.setCursor(0, 3);
+    lcd.print("GREEN: start feed");
+    return;  // don't draw other screens
+  }
+
+  if (settingState != NOT_SETTING) {
+    lcd.setCursor(0, 0);
+    lcd.print("Setting SLOT");
+    lcd.print(currentSlot + 1);
+
+    lcd.setCursor(0, 1);
+    lcd.print("Hour: ");
+    if (tempHour < 10) lcd.print("0");
+    lcd.print(tempHour);
+    if (settingState == SETTING_HOUR) lcd.print(" <--");
+
+    lcd.setCursor(0, 2);
+    lcd.print("Min:  ");
+    if (tempMinute < 10) lcd.print("0");
+    lcd.print(tempMinute);
+    if (settingState == SETTING_MINUTE) lcd.print(" <--");
+
+    lcd.setCursor(0, 3);
+    lcd.print("Weight: ");
+    lcd.print((int)tempWeight);
+    lcd.print("g");
+    if (settingState == SETTING_WEIGHT) lcd.print(" <--");
+
+    if (settingState == SAVING) {
+      lcd.clear();
+      lcd.setCursor(0, 1);
+      lcd.print("  Settings Saved!");
+      lcd.setCursor(0, 2);
+      lcd.print("  Press GREEN");
+    }
+
+  } else if (showSlots) {
+    lcd.setCursor(0, 0);
+    lcd.print("SLOTS   ");
+    if (now.hour() < 10) lcd.print("0");
+    lcd.print(now.hour());
+    lcd.print(":");
+    if (now.minute() < 10) lcd.print("0");
+    lcd.print(now.minute());
+
+    // Rows 1..3 show a page of slots around the selected one
+    const int perPage = kBoard.lcdRows - 1;
+    const int first = (currentSlot / perPage) * perPage;
+    for (int row = 0; row < perPage && first + row < SLOT_COUNT; row++) {
+      int i = first + row;
+      lcd.setCursor(0, row + 1);
+      lcd.print(i == currentSlot ? ">" : " ");
+      lcd.print("SLOT");
+      lcd.print(i + 1);
+      lcd.print(":");
+      if (slots[i].active && slots[i].weight > 0) {
+        if (slots[i].hour < 10) lcd.print("0");
+        lcd.print(slots[i].hour);
+        lcd.print(":");
+        if (slots[i].minute < 10) lcd.print("0");
+        lcd.print(slots[i].minute);
+        lcd.print(",");
+        lcd.print((int)slots[i].weight);
+        lcd.print("g");
+      } else {
+        lcd.print("Empty");
+      }
+    }
+
+  } else {
+    // --- Main screen ---
+    lcd.setCursor(0, 0);
+    lcd.print("Time: ");
+    if (now.hour() < 10) lcd.print("0");
+    lcd.print(now.hour());
+    lcd.print(":");
+    if (now.minute() < 10) lcd.print("0");
+    lcd.print(now.minute());
+    lcd.print(":");
+    if (now.second() < 10) lcd.print("0");
+    lcd.print(now.second());
+
+    lcd.setCursor(0, 1);
+    lcd.print("Weight: ");
+    lcd.print(currentWeight, 1);
+    lcd.print("g");
+
+    if (feeder.active) {
+      lcd.setCursor(0, 2);
+      lcd.print("Feeding in progress");
+      lcd.setCursor(0, 3);
+      if (feeder.manual) {
+        lcd.print("Manual Target: ");
+      } else {
+        lcd.print("Target: ");
+      }
+      lcd.print((int)feeder.progress.target);
+      lcd.print("g");
+    } else {
+      lcd.setCursor(0, 2);
+      lcd.print("Next: ");
+      int nextSlot = -1;
+      uint32_t nextFeed = getNextFeedingTime(&nextSlot);
+      if (nextFeed == NO_FEEDING_TIME) {
+        lcd.print("None");
+      } else {
+        // "Next: Mon 08:00 20g"
+        static const char* const kDayNames[] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+        lcd.print(kDayNames[dayOfWeek(nextFeed)]);
+        lcd.print(" ");
+        if (hourOf(nextFeed) < 10) lcd.print("0");
+        lcd.print(hourOf(nextFeed));
+        lcd.print(":");
+        if (minuteOf(nextFeed) < 10) lcd.print("0");
+        lcd.print(minuteOf(nextFeed));
+        lcd.print(" ");
+        lcd.print((int)slotRules[nextSlot].portion);
+        lcd.print("g");
+      }
+
+      lcd.setCursor(0, 3);
+      // Refill prompt replaces the hint until UP+DOWN reports a refill
+      if (hopperPredictEmpty(hopper)) {
+        lcd.print("Hopper EMPTY");
+      } else if (hopperForecast.low) {
+        lcd.print("Hopper low: ");
+        lcd.print((int)hopper.remainingG);
+        lcd.print("g");
+      } else {
+        lcd.print("GREEN: Manual feed");
+      }
+    }
+  }
+}
+
+void addFeedLog(bool manual, int slotIndex, float target, float finalWeight, float dispensed,
+                bool completed) {
+  DateTime now = currentTime();
+
+  FeedLogEntry e;
+  e.used        = true;
+  e.manual      = manual;
+  e.slotIndex   = slotIndex;
+  e.hour        = now.hour();
+  e.minute      = now.minute();
+  e.target      = target;
+  e.finalWeight = finalWeight;
+  pushFeedLog(feedLog, MAX_FEED_LOGS, feedLogCount, e);
+  rollupFeed(feedRollups, now.unixtime(), manual ? -1 : slotIndex, completed, dispensed,
+             finalWeight - target);
+  saveRollups();
+  markHistoryChanged();
+}
+
+
+StatusView statusView() {
+  StatusView view;
+  view.weight        = currentWeight;
+  view.feedingActive = feeder.active;
+  view.nextFeed      = getNextFeedingTime();
+  view.slots         = slots;
+  view.slotCount     = SLOT_COUNT;
+  view.log           = feedLog;
+  view.logCount      = feedLogCount;
+  view.hopper         = &hopper;
+  view.hopperForecast = &hopperForecast;
+  return view;
+}
+
+#if FEEDER_HTTP_API
+#if FEEDER_WEB_UI
+void handleIndexPage(const ApiArgs&) {
+  server.send_P(200, "text/html", INDEX_HTML);
+}
+#endif
+
+// Encoding the client asked for with Accept (JSON unless CBOR/MessagePack)
+WireFormat requestedWireFormat() {
+  return server.hasHeader("Accept") ? negotiateWireFormat(server.header("Accept").c_str())
+                                    : WIRE_JSON;
+}
+
+// Full document, or with ?since=<version> / If-None-Match only the sections
+// that changed after that version (304 when none did). JSON, CBOR or
+// MessagePack by Accept (status_binary.h). Each answer carries the ETag of
+// the current version.
+void handleStatusApi(const ApiArgs& args) {
+  WireFormat wire = requestedWireFormat();
+  server.sendHeader("Vary", "Accept");
+  // On the full document too: a client's first fetch gets the validator
+  // for its first conditional request
+  server.sendHeader("ETag", statusCacheEtag(statusCache, statusVersions));
+  server.sendHeader("Cache-Control", "no-cache");
+
+  const ApiArg* sinceArg = findApiArg(args, "since");
+  bool delta = sinceArg || server.hasHeader("If-None-Match");
+  uint32_t since = 0;
+  if (delta) {
+    String etag = sinceArg ? String() : server.header("If-None-Match");
+    const char* token = sinceArg ? sinceArg->value : etag.c_str();
+    if (!parseStatusVersion(token, statusVersions, since)) since = 0;
+
+    if (since > 0 && !statusChangedSince(statusVersions, since)) {
+      server.send(304);
+      return;
+    }
+  }
+
+  StatusView view = statusView();
+
+  // Rendered once per change; later requests reuse the bytes and length
+  const StatusCacheEntry* doc =
+      delta ? statusCacheDelta(statusCache, view, statusVersions, since, wire)
+            : statusCacheFull(statusCache, view, statusVersions, wire);
+  if (!doc) {
+    server.send(500, "text/plain", "Status too large");
+    return;
+  }
+  server.send_P(200, wireContentType(wire), doc->buf, doc->len);
+}
+
+// Weight + feeding flag + current version, for high-rate polling
+void handleLiveApi(const ApiArgs&) {
+  WireFormat wire = requestedWireFormat();
+  server.sendHeader("Cache-Control", "no-cache");
+  server.sendHeader("Vary", "Accept");
+  if (wire != WIRE_JSON) {
+    uint8_t doc[LIVE_JSON_MAX];
+    size_t n = writeLiveBinary(doc, sizeof(doc), currentWeight, feeder.active, statusVersions, wire);
+    server.send_P(200, wireContentType(wire), (const char*)doc, n);
+    return;
+  }
+  char json[LIVE_JSON_MAX];
+  writeLiveJson(json, sizeof(json), currentWeight, feeder.active, statusVersions);
+  server.send(200, "application/json", json);
+}
+
+void handleResetApi(const ApiArgs&) {
+  resetSystemState();
+  server.send(200, "text/plain", "OK");
+}
+
+
+void handleManualFeedApi(const ApiArgs& args) {
+  float amount = 0;
+  if (!argAccepted(argFloat(args, "amount", -kBoard.hopperCapacityG, kBoard.hopperCapacityG, amount),
+                   "amount")) {
+    return;
+  }
+  if (amount <= 0) {
+    server.send(400, "text/plain", "Amount must be > 0");
+    return;
+  }
+
+  uint8_t mode = kBoard.dispenseMode;
+  const ApiArg* profile = findApiArg(args, "profile");
+  if (profile && !parseDispenseMode(profile->value, mode)) {
+    server.send(400, "text/plain", "profile must be full, trickle or pulse");
+    return;
+  }
+
+  ApiReply r = manualFeed(amount, mode);
+  server.send(r.status, "text/plain", r.msg);
+}
+#endif
+
+// Queues an API feed (HTTP or serial); it runs now when the dispenser is
+// idle, otherwise waits its turn
+ApiReply manualFeed(float amount, uint8_t mode) {
+  ApiReply r = {200, "OK"};
+  bool startsNow = feedDispenserFree(feeder) && feeder.queue.count == 0;
+  FeedEnqueue result = queueFeed(FEED_SRC_API, amount, mode);
+  if (result == FEED_QUEUE_FULL) {
+    r.status = 503;
+    snprintf(r.msg, sizeof(r.msg), "Feed queue full");
+    return r;
+  }
+  dispatchQueuedFeed();
+
+  if (!startsNow) {
+    r.status = 202;
+    snprintf(r.msg, sizeof(r.msg), "%s (%d waiting)",
+             result == FEED_DUPLICATE ? "Already queued" : "Queued", feeder.queue.count);
+  }
+  return r;
+}
+
+#if FEEDER_HTTP_API
+// Loop period stats; ?reset=1 starts a new measurement window after replying
+void handleLoopApi(const ApiArgs& args) {
+  char json[LOOP_JSON_MAX];
+  writeLoopJson(json, sizeof(json), loopStats);
+  server.send(200, "application/json", json);
+  if (hasApiArg(args, "reset")) resetLoopStats(loopStats);
+}
+
+// Admission limits and per-lane counters; ?reset=1 clears the counters
+// after reading them.
+void handleAdmissionApi(const ApiArgs& args) {
+  char json[ADMISSION_JSON_MAX];
+  writeAdmissionJson(json, sizeof(json), admission);
+  server.send(200, "application/json", json);
+  if (hasApiArg(args, "reset")) resetAdmissionCounters(admission);
+}
+
+// Learned flow statistics and the limits of the current / last feed
+void handleFlowApi(const ApiArgs&) {
+  char json[FLOW_JSON_MAX];
+  writeFlowJson(json, sizeof(json), flowStats, feeder.limits);
+  server.send(200, "application/json", json);
+}
+
+void replyCalibration(int status) {
+  char json[CALIBRATION_JSON_MAX];
+  writeCalibrationJson(json, sizeof(json), scaleCal, calCapture, zeroTracker);
+  server.send(status, "application/json", json);
+}
+
+void handleCalibrationStatusApi(const ApiArgs&) {
+  replyCalibration(200);
+}
+
+// POST /api/calibration?step=zero - with the bowl empty, sets the zero.
+// POST /api/calibration?step=span&mass=<g> - with that known mass in the
+// bowl (10 g up to the hopper's capacity), sets counts per gram. Replies
+// 202: the capture takes the next conversions (about two seconds of
+// steady readings) and GET shows how it went.
+void handleCalibrationApi(const ApiArgs& args) {
+  const ApiArg* step = findApiArg(args, "step");
+  if (!step) {
+    server.send(400, "text/plain", "Missing step");
+    return;
+  }
+  uint8_t s = CAL_NONE;
+  float mass = 0;
+  if (strcmp(step->value, "zero") == 0) {
+    s = CAL_ZERO;
+  } else if (strcmp(step->value, "span") == 0) {
+    s = CAL_SPAN;
+    if (!argAccepted(argFloat(args, "mass", 10, kBoard.hopperCapacityG, mass), "mass")) return;
+  } else {
+    server.send(400, "text/plain", "step must be zero or span");
+    return;
+  }
+  if (feeder.active || feeder.opening > 0) {
+    server.send(409, "text/plain", "Feeding, try again later");
+    return;
+  }
+  if (calCapture.step != CAL_NONE) {
+    server.send(409, "text/plain", "Calibration already running");
+    return;
+  }
+  startCalCapture(calCapture, s, mass);
+  LOGI("Calibration %s started", calStepName(s));
+  replyCalibration(202);
+}
+
+// Feed rollups: today, this week, per slot (feed_rollup.h). No history is
+// read; the tables are kept current as feeds are logged.
+void handleStatsApi(const ApiArgs&) {
+  static char json[statsJsonCapacity(SLOT_COUNT)];
+  writeStatsJson(json, sizeof(json), feedRollups, SLOT_COUNT, currentTime().unixtime());
+  server.send(200, "application/json", json);
+}
+
+void handleQueueApi(const ApiArgs&) {
+  static char json[queueJsonCapacity(kBoard.feedQueueDepth)];
+  writeQueueJson(json, sizeof(json), feeder.queue, feeder.active, millis());
+  server.send(200, "application/json", json);
+}
+
+// Reads an optional recurrence field; an absent one keeps its current value
+bool slotEditField(const ApiArgs& args, const char* name, int32_t lo, int32_t hi,
+                   SlotEdit& e, uint8_t field, int32_t& out) {
+  ArgResult r = argInt(args, name, lo, hi, out);
+  if (r == ARG_OK) e.has |= field;
+  return argAccepted(r, name, true);
+}
+
+void handleSetSlotApi(const ApiArgs& args) {
+  int32_t index = 0;
+  SlotEdit e = {};
+  if (!argAccepted(argInt(args, "index", 0, SLOT_COUNT - 1, index), "index") ||
+      !argAccepted(argInt(args, "hour", 0, 23, e.hour), "hour") ||
+      !argAccepted(argInt(args, "minute", 0, 59, e.minute), "minute") ||
+      !argAccepted(argFloat(args, "weight", -kBoard.hopperCapacityG, kBoard.hopperCapacityG,
+                            e.weight), "weight") ||
+      !slotEditField(args, "days", 1, ALL_DAYS, e, SLOT_EDIT_DAYS, e.days) ||
+      !slotEditField(args, "every", 0, MINUTES_PER_DAY - 1, e, SLOT_EDIT_EVERY, e.everyMin) ||
+      !slotEditField(args, "until", 0, MINUTES_PER_DAY - 1, e, SLOT_EDIT_UNTIL, e.untilMin) ||
+      !slotEditField(args, "splits", 0, 99, e, SLOT_EDIT_SPLITS, e.splits) ||
+      !slotEditField(args, "catchUpMin", 0, MINUTES_PER_DAY, e, SLOT_EDIT_CATCHUP_MIN,
+                     e.catchUpMin)) {
+    return;
+  }
+  if (const ApiArg* catchUp = findApiArg(args, "catchUp")) {
+    if (!parseCatchUpPolicy(catchUp->value, e.catchUp)) {
+      server.send(400, "text/plain", "Invalid catchUp (skip, late, proportional)");
+      return;
+    }
+    e.has |= SLOT_EDIT_CATCHUP;
+  }
+  if (const ApiArg* cron = findApiArg(args, "cron")) {
+    e.has |= SLOT_EDIT_CRON;
+    e.cron = cron->value;
+  }
+
+  ApiReply r = setSlot(index, e, "Web");
+  server.send(r.status, "text/plain", r.msg);
+}
+#endif
+
+// One slot edited over HTTP or serial (`via` is for the log)
+ApiReply setSlot(int index, const SlotEdit& e, const char* via) {
+  ApiReply r = {200, "OK"};
+  if (index < 0 || index >= SLOT_COUNT) {
+    r.status = 400;
+    snprintf(r.msg, sizeof(r.msg), "Invalid slot index");
+    return r;
+  }
+  const char* error = applySlotEdit(slots[index], e, slotRules[index]);
+  if (error) {
+    r.status = 400;
+    snprintf(r.msg, sizeof(r.msg), "%s", error);
+    return r;
+  }
+
+  const FeedingSlot& slot = slots[index];
+  slotMarkers[index] = NO_MARKER;  // an edited slot starts from now, no catch-up
+  markScheduleChanged();
+  saveMarkers();
+
+  LOGI("Slot %d set via %s: %02d:%02d, %.0fg%s%s",
+       index + 1, via, slot.hour, slot.minute, slot.weight,
+       slot.cron[0] ? ", cron " : "", slot.cron);
+  return r;
+}
+
+#if FEEDER_HTTP_API
+// Binary dump of the trace ring; convert with tools/trace2chrome.py
+void handleTraceApi(const ApiArgs&) {
+  static char names[256];
+  uint32_t namesLen = traceNameTable(names, sizeof(names));
+
+  uint32_t first = traceOldest();
+  uint32_t last  = traceWritten();
+  uint32_t count = last >= first ? last - first + 1 : 0;
+
+  TraceDumpHeader hdr = {{'F', 'T', 'R', 'C'}, TRACE_DUMP_VERSION,
+                         sizeof(TraceRecord), count, namesLen};
+
+  server.setContentLength(sizeof(hdr) + namesLen + count * sizeof(TraceRecord));
+  server.send(200, "application/octet-stream", "");
+  server.sendContent((const char*)&hdr, sizeof(hdr));
+  server.sendContent(names, namesLen);
+
+  TraceRecord chunk[32];
+  for (uint32_t seq = first; seq <= last && count > 0; ) {
+    uint32_t want = last - seq + 1;
+    if (want > 32) want = 32;
+    uint32_t n = traceRead(seq, chunk, want);
+    if (n == 0) break;
+    server.sendContent((const char*)chunk, n * sizeof(TraceRecord));
+    seq += n;
+  }
+}
+
+// Feed recordings, oldest first; replay them with tools/replay.cpp
+void handleRecordingsApi(const ApiArgs&) {
+  server.setContentLength(recStore.size());
+  server.sendHeader("Content-Disposition", "attachment; filename=feeds.rec");
+  server.send(200, "application/octet-stream", "");
+  const char* paths[] = {REC_OLD_PATH, REC_PATH};
+  char chunk[512];
+  for (const char* path : paths) {
+    if (!SPIFFS.exists(path)) continue;
+    File f = SPIFFS.open(path, FILE_READ);
+    size_t n;
+    while (f && (n = f.read((uint8_t*)chunk, sizeof(chunk))) > 0) server.sendContent(chunk, n);
+    f.close();
+  }
+}
+
+void handleRecordingsClearApi(const ApiArgs&) {
+  recStore.clear();
+  server.send(200, "text/plain", "OK");
+}
+
+// History export, ?format=ndjson|csv|cbor|msgpack&from=&to= (Unix seconds,
+// inclusive). Without ?format=, an Accept of CBOR or MessagePack selects it.
+// One page of EXPORT_PAGE_RECORDS per request, streamed chunked from flash;
+// X-Next-Cursor is where the next page starts (pass it as ?cursor=) and is
+// absent on the last page. See tools/export_history.py.
+void handleExportApi(const ApiArgs& args) {
+  ExportFormat fmt = EXPORT_NDJSON;
+  if (const ApiArg* format = findApiArg(args, "format")) {
+    if (!parseExportFormat(format->value, fmt)) {
+      server.send(400, "text/plain", "format must be ndjson, csv, cbor or msgpack");
+      return;
+    }
+  } else {
+    WireFormat wire = requestedWireFormat();
+    if (wire == WIRE_CBOR) fmt = EXPORT_CBOR;
+    if (wire == WIRE_MSGPACK) fmt = EXPORT_MSGPACK;
+  }
+  uint32_t from = 0, to = UINT32_MAX, cursor = 0;
+  ArgResult cursorArg = argUint(args, "cursor", 0, UINT32_MAX, cursor);
+  if (!argAccepted(argUint(args, "from", 0, UINT32_MAX, from), "from", true) ||
+      !argAccepted(argUint(args, "to", 0, UINT32_MAX, to), "to", true) ||
+      !argAccepted(cursorArg, "cursor", true)) {
+    return;
+  }
+  bool resumed = cursorArg == ARG_OK;
+
+  uint32_t start;
+  if (resumed) {
+    start = cursor;
+    if (start < history.oldest()) start = history.oldest();  // rotated away meanwhile
+  } else {
+    start = historyLowerBound(history.oldest(), history.end(), from,
+                              HistoryStore::readFn, &history);
+  }
+  uint32_t end = history.end();
+  uint32_t pageEnd = start + EXPORT_PAGE_RECORDS < end ? start + EXPORT_PAGE_RECORDS : end;
+
+  // The cursor goes out before the body, so decide now whether there is more
+  HistoryRecord r;
+  bool more = pageEnd < end && history.read(pageEnd, r) && r.time <= to;
+  if (more) server.sendHeader("X-Next-Cursor", String(pageEnd));
+
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, exportContentType(fmt), "");
+  if (fmt == EXPORT_CSV && !resumed) server.sendContent(HISTORY_CSV_HEADER);
+
+  static char chunk[1024];
+  size_t used = 0;
+  for (uint32_t seq = start; seq < pageEnd && history.read(seq, r); seq++) {
+    if (r.time < from) continue;
+    if (r.time > to) break;
+    if (used + HISTORY_LINE_MAX > sizeof(chunk)) {
+      server.sendContent(chunk, used);
+      used = 0;
+    }
+    used += formatHistoryLine(chunk + used, sizeof(chunk) - used, r, fmt);
+  }
+  if (used > 0) server.sendContent(chunk, used);
+  server.sendContent("");
+  history.closeReader();
+}
+
+// POST /api/hopper/refill[?grams=] - hopper refilled (default: to capacity)
+void handleHopperRefillApi(const ApiArgs& args) {
+  float grams = 0;
+  if (!argAccepted(argFloat(args, "grams", -kBoard.hopperCapacityG, kBoard.hopperCapacityG, grams),
+                   "grams", true)) {
+    return;
+  }
+  if (grams < 0) {
+    server.send(400, "text/plain", "grams must be >= 0");
+    return;
+  }
+  refillHopper(grams);
+  server.send(200, "text/plain", "Hopper refilled");
+}
+
+// Binary protocol state and counters (serial_proto.h)
+void handleSerialApi(const ApiArgs&) {
+  char json[SERIAL_JSON_MAX];
+  writeSerialJson(json, sizeof(json), console.binary(), console.tx(), console.rx());
+  server.send(200, "application/json", json);
+}
+
+// Newest console lines as text, oldest first. ?since=<seq> returns the
+// lines from there on; X-Log-Next is the seq to ask for next (a full page
+// means there may be more), X-Log-Dropped counts lines lost to a full ring.
+// ?file=1 downloads the flash log instead (flushed every few seconds).
+void handleLogsApi(const ApiArgs& args) {
+  if (hasApiArg(args, "file")) {
+    server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    server.send(200, "text/plain", "");
+    const char* paths[] = {LOG_OLD_PATH, LOG_PATH};
+    char chunk[512];
+    for (const char* path : paths) {
+      if (!SPIFFS.exists(path)) continue;
+      File f = SPIFFS.open(path, FILE_READ);
+      size_t n;
+      while (f && (n = f.read((uint8_t*)chunk, sizeof(chunk))) > 0) server.sendContent(chunk, n);
+      f.close();
+    }
+    server.sendContent("");
+    return;
+  }
+
+  uint32_t since = 0;
+  if (!argAccepted(argUint(args, "since", 0, UINT32_MAX, since), "since", true)) return;
+  char body[LOGS_PAGE_BYTES];
+  uint32_t next;
+  xSemaphoreTake(logTailLock, portMAX_DELAY);
+  size_t n = logTailRead(logTail, since, body, sizeof(body), next);
+  xSemaphoreGive(logTailLock);
+  server.sendHeader("X-Log-Next", String(next));
+  server.sendHeader("X-Log-Dropped", String(logStats().dropped));
+  server.setContentLength(n);
+  server.send(200, "text/plain", "");
+  server.sendContent(body, n);
+}
+#endif
+
+#if FEEDER_OTA
+// ---- OTA updates ----
+
+// Boots the other app slot, the image this one replaced, and restarts
+void otaRollback(const char* why) {
+  LOGE("OTA: %s, rolling back", why);
+  otaTrial.active = 0;
+  saveOtaState();
+  const esp_partition_t* previous = esp_ota_get_next_update_partition(NULL);
+  if (previous) esp_ota_set_boot_partition(previous);
+  delay(200);  // let the log task get the line out
+  ESP.restart();
+}
+
+// At boot: counts a trial boot, or gives up on the image
+void otaBootCheck() {
+  loadOtaState();
+  const esp_partition_t* running = esp_ota_get_running_partition();
+  uint8_t action = otaTrialBoot(otaTrial, running->address);
+  saveOtaState();
+  if (action == OTA_TRIAL_ROLLBACK) {
+    otaRollback("new image keeps resetting");
+  } else if (action == OTA_TRIAL_RUN) {
+    LOGW("OTA: %s on trial, boot %u of %u", running->label, otaTrial.boots, OTA_TRIAL_BOOTS);
+  } else {
+    // Nothing on trial (flashed over USB, or passed before): a bootloader
+    // built with rollback must not take it back either
+    esp_ota_mark_app_valid_cancel_rollback();
+  }
+}
+
+// Once a second while on trial
+void otaCheckHealth() {
+  OtaHealth h = otaHealthCheck(millis(), true, WiFi.status() == WL_CONNECTED);
+  if (h == OTA_HEALTH_WAIT) return;
+  if (h == OTA_HEALTH_FAIL) otaRollback("no network");
+  otaTrial.active = 0;
+  saveOtaState();
+  esp_ota_mark_app_valid_cancel_rollback();
+  LOGI("OTA: new image healthy after %u boot(s)", otaTrial.boots);
+}
+
+// Where the decoder's output goes: the inactive slot, opened on the first
+// write, when the size of a packed image is known
+struct OtaTarget {
+  const esp_partition_t* slot;
+  const esp_partition_t* running;  // what deltas copy from
+  const OtaDecoder*      decoder;
+  esp_ota_handle_t       handle;
+  bool                   begun;
+  int                    contentLength;
+};
+
+bool otaWrite(void* ctx, const uint8_t* data, size_t len) {
+  OtaTarget& t = *(OtaTarget*)ctx;
+  if (!t.begun) {
+#ifdef OTA_WITH_SEQUENTIAL_WRITES
+    size_t size = OTA_WITH_SEQUENTIAL_WRITES;  // erases as it goes, no stall up front
+#else
+    size_t size = otaHeaderKnown(*t.decoder) ? t.decoder->header.imageSize : t.contentLength;
+#endif
+    if (esp_ota_begin(t.slot, size, &t.handle) != ESP_OK) return false;
+    t.begun = true;
+  }
+  esp_task_wdt_reset();  // a flash write with its erases takes a while
+  return esp_ota_write(t.handle, data, len) == ESP_OK;
+}
+
+bool otaReadBase(void* ctx, uint32_t offset, uint8_t* out, size_t len) {
+  OtaTarget& t = *(OtaTarget*)ctx;
+  return offset + len <= t.running->size &&
+         esp_partition_read(t.running, offset, out, len) == ESP_OK;
+}
+
+uint16_t otaHttpStatus(uint8_t result) {
+  switch (result) {
+    case OTA_OK:           return 200;
+    case OTA_ERR_DOWNLOAD: return 502;
+    case OTA_ERR_WRITE:    return 500;
+    default:               return 422;
+  }
+}
+
+void replyOtaStatus(uint16_t status) {
+  const esp_partition_t* next = esp_ota_get_next_update_partition(NULL);
+  char json[OTA_JSON_MAX];
+  writeOtaJson(json, sizeof(json), esp_ota_get_running_partition()->label,
+               next ? next->label : "", otaTrial, otaReport);
+  server.send(status, "application/json", json);
+}
+
+void handleOtaStatusApi(const ApiArgs&) {
+  replyOtaStatus(200);
+}
+
+// POST /api/ota?url=<image>&sig=<hex> with "Authorization: Bearer <token>"
+// - downloads a plain, packed or delta image (tools/ota_pack.py) into the
+// inactive slot and restarts into it on trial, if sig= is the release key's
+// signature of what was written (ota_image.h). The loop stands still
+// meanwhile, so it is refused during a feed; a slot that comes due goes by
+// its catch-up policy. See tools/ota_push.py.
+void handleOtaApi(const ApiArgs& args) {
+  uint8_t key[ED25519_KEY_BYTES];
+  if (!parseHex(FEEDER_OTA_KEY, key, sizeof(key)) || FEEDER_OTA_TOKEN[0] == '\0') {
+    server.send(403, "text/plain", "No FEEDER_OTA_KEY/FEEDER_OTA_TOKEN in this build");
+    return;
+  }
+  String auth = server.header("Authorization");
+  if (!auth.startsWith("Bearer ") || !otaTokenMatches(FEEDER_OTA_TOKEN, auth.c_str() + 7)) {
+    server.sendHeader("WWW-Authenticate", "Bearer");
+    server.send(401, "text/plain", "Unauthorized");
+    return;
+  }
+  const ApiArg* url = findApiArg(args, "url");
+  const ApiArg* sigArg = findApiArg(args, "sig");
+  if (!url || !sigArg) {
+    server.send(400, "text/plain", "Missing url or sig");
+    return;
+  }
+  uint8_t sig[ED25519_SIG_BYTES];
+  if (!parseHex(sigArg->value, sig, sizeof(sig))) {
+    server.send(400, "text/plain", "sig must be 128 hex digits");
+    return;
+  }
+  if (feeder.active) {
+    server.send(409, "text/plain", "Feeding, try again later");
+    return;
+  }
+  if (otaTrial.active) {
+    server.send(409, "text/plain", "Running image is still on trial");
+    return;
+  }
+  OtaTarget t = {};
+  t.slot = esp_ota_get_next_update_partition(NULL);
+  t.running = esp_ota_get_running_partition();
+  if (!t.slot) {
+    server.send(500, "text/plain", "No OTA slot");
+    return;
+  }
+  uint8_t* window = (uint8_t*)malloc(OTA_WINDOW_BYTES);
+  if (!window) {
+    server.send(503, "text/plain", "Out of memory");
+    return;
+  }
+
+  LOGI("OTA: %s -> %s", url->value, t.slot->label);
+  uint32_t start = millis();
+  OtaDecoder dec;
+  initOtaDecoder(dec, window, OTA_WINDOW_BYTES, otaWrite, otaReadBase, &t);
+  t.decoder = &dec;
+
+  HTTPClient http;
+  uint8_t result = OTA_ERR_DOWNLOAD;
+  int code = http.begin(url->value) ? http.GET() : -1;
+  t.contentLength = code == HTTP_CODE_OK ? http.getSize() : -1;
+  if (t.contentLength > 0) {  // the body is read raw, so chunked replies are refused
+    WiFiClient* stream = http.getStreamPtr();
+    uint8_t buf[1024];
+    int left = t.contentLength;
+    uint32_t lastData = millis();
+    while (left > 0 && dec.result == OTA_OK && millis() - lastData < OTA_STALL_MS) {
+      esp_task_wdt_reset();
+      int avail = stream->available();
+      if (avail <= 0) {
+        if (!stream->connected()) break;
+        delay(1);
+        continue;
+      }
+      size_t n = stream->readBytes(buf, avail < (int)sizeof(buf) ? avail : sizeof(buf));
+      otaDecode(dec, buf, n);
+      left -= n;
+      lastData = millis();
+    }
+    uint8_t sha[SHA256_BYTES];
+    if (left > 0 && dec.result == OTA_OK) {
+      result = OTA_ERR_DOWNLOAD;  // broke off or stalled
+    } else {
+      result = otaDecodeFinish(dec, sha);
+    }
+    esp_task_wdt_reset();
+    if (result == OTA_OK && !otaSignatureValid(sha, sig, key)) result = OTA_ERR_SIGNATURE;
+  } else {
+    LOGW("OTA: download failed (%d)", code);
+  }
+  http.end();
+  free(window);
+
+  if (t.begun) {
+    // esp_ota_end checks the app image itself (magic, segments, digest)
+    if (result != OTA_OK) {
+      esp_ota_abort(t.handle);
+    } else if (esp_ota_end(t.handle) != ESP_OK) {
+      result = OTA_ERR_FORMAT;
+    }
+  }
+  otaReport.result = result;
+  otaReport.kind = otaImageKind(dec);
+  otaReport.transferBytes = dec.in;
+  otaReport.imageBytes = dec.out;
+  otaReport.ms = millis() - start;
+  LOGI("OTA: %s image, %lu bytes in, %lu out, %lu ms: %s", otaImageKindName(otaReport.kind),
+       (unsigned long)dec.in, (unsigned long)dec.out, (unsigned long)otaReport.ms,
+       otaResultText(result));
+
+  if (result == OTA_OK && esp_ota_set_boot_partition(t.slot) == ESP_OK) {
+    otaTrial = {1, 0, t.slot->address};
+    saveOtaState();
+    replyOtaStatus(200);
+    delay(200);  // the reply out before the restart
+    ESP.restart();
+    return;
+  }
+  if (result == OTA_OK) otaReport.result = OTA_ERR_WRITE;
+  saveOtaState();
+  replyOtaStatus(otaHttpStatus(otaReport.result));
+}
+#endif
+
+// The HTTP API over the serial port; see tools/feeder_serial.py
+void handleSerialCommand(const SerialCommand& cmd) {
+  ApiReply r = {200, "OK"};
+  switch (cmd.type) {
+    case SPC_STREAM:
+      serialEvery = cmd.every;
+      break;
+    case SPC_STATUS: {
+      const StatusCacheEntry* doc =
+          statusCacheFull(statusCache, statusView(), statusVersions, WIRE_CBOR);
+      if (!doc || doc->len > SERIAL_PAYLOAD_MAX) {
+        r = {500, "Status too large"};
+      } else if (!console.send(SP_STATUS, (const uint8_t*)doc->buf, doc->len)) {
+        r = {503, "Serial TX ring full"};
+      }
+      break;
+    }
+    case SPC_LIVE: {
+      uint8_t doc[LIVE_JSON_MAX];
+      size_t n = writeLiveBinary(doc, sizeof(doc), currentWeight, feeder.active, statusVersions,
+                                 WIRE_CBOR);
+      if (!console.send(SP_LIVE, doc, n)) r = {503, "Serial TX ring full"};
+      break;
+    }
+    case SPC_FEED: {
+      uint8_t mode = cmd.mode == SERIAL_MODE_DEFAULT ? kBoard.dispenseMode : cmd.mode;
+      if (!(cmd.grams > 0)) {
+        r = {400, "Amount must be > 0"};
+      } else if (mode >= DISPENSE_MODE_COUNT) {
+        r = {400, "profile must be full, trickle or pulse"};
+      } else {
+        r = manualFeed(cmd.grams, mode);
+      }
+      break;
+    }
+    case SPC_SET_SLOT:
+      r = setSlot(cmd.slotIndex, cmd.slot, "serial");
+      break;
+    case SPC_RESET:
+      resetSystemState();
+      break;
+    case SPC_REFILL:
+      if (cmd.grams < 0) {
+        r = {400, "grams must be >= 0"};
+      } else {
+        refillHopper(cmd.grams);
+        r = {200, "Hopper refilled"};
+      }
+      break;
+    case SPC_TEXT:
+      console.ack(cmd, r.status, r.msg);
+      console.textMode();
+      return;
+  }
+  console.ack(cmd, r.status, r.msg);
+}
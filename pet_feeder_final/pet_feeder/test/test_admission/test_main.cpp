@@ -0,0 +1,165 @@
+// Per-client token buckets, tick budget and priority lane (admission.h).
+#include <unity.h>
+#include <string.h>
+#include "admission.h"
+#include "status_json.h"
+
+static Admission a;
+static const AdmissionLimits LIMITS = {10, 4, 3};  // 10/s, burst 4, 3 per tick
+
+static const uint32_t IP_A = 0x0A00A8C0;
+static const uint32_t IP_B = 0x0B00A8C0;
+
+void setUp() {
+  initAdmission(a, LIMITS);
+}
+
+void tearDown() {}
+
+void test_burst_then_rate_limited() {
+  a.limits.tickBudget = 100;  // only the client bucket limits here
+  for (int i = 0; i < LIMITS.burst; i++) {
+    TEST_ASSERT_EQUAL(ADMIT_OK, admitRequest(a, IP_A, LANE_READ, 1000, false));
+  }
+  TEST_ASSERT_EQUAL(ADMIT_RATE, admitRequest(a, IP_A, LANE_READ, 1000, false));
+  TEST_ASSERT_EQUAL_UINT32(4, a.admitted[LANE_READ]);
+  TEST_ASSERT_EQUAL_UINT32(1, a.rejectedRate[LANE_READ]);
+}
+
+void test_bucket_refills_at_rate() {
+  a.limits.tickBudget = 100;
+  for (int i = 0; i < 4; i++) admitRequest(a, IP_A, LANE_READ, 1000, false);
+  TEST_ASSERT_EQUAL(ADMIT_RATE, admitRequest(a, IP_A, LANE_READ, 1050, false));
+  TEST_ASSERT_EQUAL(ADMIT_OK, admitRequest(a, IP_A, LANE_READ, 1100, false));  // +1 token
+  TEST_ASSERT_EQUAL(ADMIT_RATE, admitRequest(a, IP_A, LANE_READ, 1150, false));
+}
+
+void test_clients_have_separate_buckets() {
+  a.limits.tickBudget = 100;
+  for (int i = 0; i < 4; i++) admitRequest(a, IP_A, LANE_READ, 1000, false);
+  TEST_ASSERT_EQUAL(ADMIT_RATE, admitRequest(a, IP_A, LANE_WRITE, 1000, false));
+  TEST_ASSERT_EQUAL(ADMIT_OK, admitRequest(a, IP_B, LANE_WRITE, 1000, false));
+}
+
+void test_tick_budget_shared_by_clients() {
+  TEST_ASSERT_EQUAL(ADMIT_OK, admitRequest(a, IP_A, LANE_READ, 1000, false));
+  TEST_ASSERT_EQUAL(ADMIT_OK, admitRequest(a, IP_B, LANE_READ, 1010, false));
+  TEST_ASSERT_EQUAL(ADMIT_OK, admitRequest(a, IP_A, LANE_WRITE, 1020, false));
+  TEST_ASSERT_EQUAL(ADMIT_BUSY, admitRequest(a, IP_B, LANE_READ, 1030, false));
+  TEST_ASSERT_EQUAL_UINT32(1, a.rejectedBusy[LANE_READ]);
+
+  // A busy rejection does not cost the client a token (3 left + 20 ms of refill)
+  TEST_ASSERT_EQUAL_UINT32(IP_B, a.clients[1].ip);
+  TEST_ASSERT_EQUAL_UINT32(3200, a.clients[1].tokensMilli);
+  TEST_ASSERT_EQUAL(ADMIT_OK, admitRequest(a, IP_B, LANE_READ, 1000 + ADMISSION_TICK_MS, false));
+}
+
+void test_feeding_halves_tick_budget() {
+  a.limits.tickBudget = 4;
+  TEST_ASSERT_EQUAL(ADMIT_OK, admitRequest(a, IP_A, LANE_READ, 1000, true));
+  TEST_ASSERT_EQUAL(ADMIT_OK, admitRequest(a, IP_B, LANE_READ, 1000, true));
+  TEST_ASSERT_EQUAL(ADMIT_BUSY, admitRequest(a, IP_B, LANE_READ, 1000, true));
+
+  a.limits.tickBudget = 1;  // never below one
+  TEST_ASSERT_EQUAL(ADMIT_OK, admitRequest(a, IP_A, LANE_READ, 2000, true));
+}
+
+void test_priority_lane_not_starved_by_reads() {
+  a.limits.tickBudget = 100;
+  for (int i = 0; i < 4; i++) admitRequest(a, IP_A, LANE_READ, 1000, false);
+  a.limits.tickBudget = 4;
+  TEST_ASSERT_EQUAL(ADMIT_RATE, admitRequest(a, IP_A, LANE_READ, 1000, false));
+  TEST_ASSERT_EQUAL(ADMIT_OK, admitRequest(a, IP_A, LANE_PRIORITY, 1000, false));
+  TEST_ASSERT_EQUAL(ADMIT_OK, admitRequest(a, IP_B, LANE_PRIORITY, 1000, false));
+  // Its own per-tick allowance
+  TEST_ASSERT_EQUAL(ADMIT_BUSY, admitRequest(a, IP_B, LANE_PRIORITY, 1000, false));
+  TEST_ASSERT_EQUAL_UINT32(2, a.admitted[LANE_PRIORITY]);
+  TEST_ASSERT_EQUAL_UINT32(1, a.rejectedBusy[LANE_PRIORITY]);
+}
+
+void test_priority_lane_is_rate_limited_too() {
+  uint32_t t = 1000;
+  for (int i = 0; i < PRIORITY_BURST; i++) {
+    TEST_ASSERT_EQUAL(ADMIT_OK, admitRequest(a, IP_A, LANE_PRIORITY, t, false));
+    t += ADMISSION_TICK_MS;
+  }
+  // 400 ms at 1/s is not a whole token yet
+  TEST_ASSERT_EQUAL(ADMIT_RATE, admitRequest(a, IP_A, LANE_PRIORITY, t, false));
+  TEST_ASSERT_EQUAL(ADMIT_OK, admitRequest(a, IP_A, LANE_PRIORITY, 1000 + 1000, false));
+}
+
+void test_least_recent_client_evicted() {
+  a.limits.tickBudget = 100;
+  for (int i = 0; i < ADMISSION_CLIENTS; i++) {
+    admitRequest(a, IP_A + i, LANE_READ, 1000, false);
+  }
+  admitRequest(a, IP_A, LANE_READ, 1000, false);  // IP_A + 1 is now the oldest
+  TEST_ASSERT_EQUAL_UINT32(0, a.evictions);
+
+  admitRequest(a, IP_B + 100, LANE_READ, 1000, false);
+  TEST_ASSERT_EQUAL_UINT32(1, a.evictions);
+  for (int i = 0; i < ADMISSION_CLIENTS; i++) {
+    TEST_ASSERT_NOT_EQUAL(IP_A + 1, a.clients[i].ip);
+  }
+}
+
+void test_retry_after() {
+  a.limits.tickBudget = 100;
+  a.limits.ratePerSec = 1;
+  for (int i = 0; i < 4; i++) admitRequest(a, IP_A, LANE_READ, 1000, false);
+  AdmitResult r = admitRequest(a, IP_A, LANE_READ, 1000, false);
+  TEST_ASSERT_EQUAL(ADMIT_RATE, r);
+  TEST_ASSERT_EQUAL_UINT32(1, admissionRetryAfterSecs(a, IP_A, r));
+
+  a.limits.ratePerSec = 0;  // never refills: still a sane header
+  TEST_ASSERT_EQUAL_UINT32(1, admissionRetryAfterSecs(a, IP_A, r));
+  TEST_ASSERT_EQUAL_UINT32(1, admissionRetryAfterSecs(a, IP_A, ADMIT_BUSY));
+}
+
+void test_millis_wrap() {
+  a.limits.tickBudget = 100;
+  for (int i = 0; i < 4; i++) admitRequest(a, IP_A, LANE_READ, 0xFFFFFF00, false);
+  TEST_ASSERT_EQUAL(ADMIT_RATE, admitRequest(a, IP_A, LANE_READ, 0xFFFFFF00, false));
+  TEST_ASSERT_EQUAL(ADMIT_OK, admitRequest(a, IP_A, LANE_READ, 0x00000010, false));
+}
+
+void test_admission_json() {
+  admitRequest(a, IP_A, LANE_READ, 1000, false);
+  admitRequest(a, IP_A, LANE_PRIORITY, 1000, false);
+  a.rejectedRate[LANE_WRITE] = 7;
+  char buf[ADMISSION_JSON_MAX];
+  TEST_ASSERT_GREATER_THAN(0, writeAdmissionJson(buf, sizeof(buf), a));
+  TEST_ASSERT_NOT_NULL(strstr(buf, "\"ratePerSec\":10,\"burst\":4,\"tickMs\":100,"
+                                   "\"tickBudget\":3,\"clients\":1,"));
+  TEST_ASSERT_NOT_NULL(strstr(buf, "\"read\":{\"admitted\":1,\"rate\":0,\"busy\":0}"));
+  TEST_ASSERT_NOT_NULL(strstr(buf, "\"write\":{\"admitted\":0,\"rate\":7,\"busy\":0}"));
+  TEST_ASSERT_NOT_NULL(strstr(buf, "\"priority\":{\"admitted\":1,"));
+
+  // Worst case still fits
+  for (int i = 0; i < LANE_COUNT; i++) {
+    a.admitted[i] = a.rejectedRate[i] = a.rejectedBusy[i] = 0xFFFFFFFF;
+  }
+  a.evictions = 0xFFFFFFFF;
+  a.limits = {65535, 65535, 255};
+  TEST_ASSERT_GREATER_THAN(0, writeAdmissionJson(buf, sizeof(buf), a));
+
+  resetAdmissionCounters(a);
+  TEST_ASSERT_EQUAL_UINT32(0, a.admitted[LANE_READ]);
+  TEST_ASSERT_EQUAL_UINT32(0, a.evictions);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_burst_then_rate_limited);
+  RUN_TEST(test_bucket_refills_at_rate);
+  RUN_TEST(test_clients_have_separate_buckets);
+  RUN_TEST(test_tick_budget_shared_by_clients);
+  RUN_TEST(test_feeding_halves_tick_budget);
+  RUN_TEST(test_priority_lane_not_starved_by_reads);
+  RUN_TEST(test_priority_lane_is_rate_limited_too);
+  RUN_TEST(test_least_recent_client_evicted);
+  RUN_TEST(test_retry_after);
+  RUN_TEST(test_millis_wrap);
+  RUN_TEST(test_admission_json);
+  return UNITY_END();
+}
@@ -0,0 +1,180 @@
+// Route table lookup and in-place argument parsing (api_request.h).
+#include <unity.h>
+#include <string.h>
+#include "api_request.h"
+
+typedef int RouteId;
+
+static constexpr ApiRoute<RouteId> ROUTES[] = {
+  {"/api/admission",       API_GET,  LANE_READ,     1},
+  {"/api/hopper/refill",   API_POST, LANE_WRITE,    2},
+  {"/api/manual-feed",     API_POST, LANE_PRIORITY, 3},
+  {"/api/ota",             API_GET,  LANE_READ,     4},
+  {"/api/ota",             API_POST, LANE_WRITE,    5},
+  {"/api/recordings",      API_GET,  LANE_READ,     6},
+  {"/api/recordings/clear", API_POST, LANE_WRITE,   7},
+  {"/api/status",          API_GET,  LANE_READ,     8},
+};
+static_assert(apiRoutesSorted(ROUTES), "test table is sorted");
+
+static constexpr ApiRoute<RouteId> UNSORTED[] = {
+  {"/api/status", API_GET, LANE_READ, 1},
+  {"/api/ota",    API_GET, LANE_READ, 2},
+};
+static_assert(!apiRoutesSorted(UNSORTED), "out of order");
+
+static constexpr ApiRoute<RouteId> DUPLICATE[] = {
+  {"/api/ota", API_POST, LANE_WRITE, 1},
+  {"/api/ota", API_POST, LANE_WRITE, 2},
+};
+static_assert(!apiRoutesSorted(DUPLICATE), "listed twice");
+
+static ApiArgs args;
+static char buf[256];
+
+static void parse(const char* query) {
+  strcpy(buf, query);
+  parseApiArgs(args, buf);
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_route_lookup_by_path_and_method() {
+  for (const ApiRoute<RouteId>& r : ROUTES) {
+    const ApiRoute<RouteId>* found = findApiRoute(ROUTES, r.method, r.path);
+    TEST_ASSERT_NOT_NULL(found);
+    TEST_ASSERT_EQUAL_INT(r.handler, found->handler);
+  }
+  TEST_ASSERT_EQUAL_INT(4, findApiRoute(ROUTES, API_GET, "/api/ota")->handler);
+  TEST_ASSERT_EQUAL_INT(5, findApiRoute(ROUTES, API_POST, "/api/ota")->handler);
+  TEST_ASSERT_NULL(findApiRoute(ROUTES, API_GET, "/api/manual-feed"));
+  TEST_ASSERT_NULL(findApiRoute(ROUTES, API_GET, "/api/recording"));
+  TEST_ASSERT_NULL(findApiRoute(ROUTES, API_GET, "/api/status/"));
+  TEST_ASSERT_NULL(findApiRoute(ROUTES, API_GET, ""));
+}
+
+void test_method_names() {
+  ApiMethod m;
+  TEST_ASSERT_TRUE(parseApiMethod("POST", m));
+  TEST_ASSERT_EQUAL(API_POST, m);
+  TEST_ASSERT_FALSE(parseApiMethod("HEAD", m));
+  TEST_ASSERT_FALSE(parseApiMethod("get", m));
+}
+
+// Slices point into the buffer; nothing is copied
+void test_query_is_split_in_place() {
+  parse("index=1&hour=7&flag&&empty=");
+  TEST_ASSERT_EQUAL_UINT8(4, args.count);
+  TEST_ASSERT_FALSE(args.truncated);
+  TEST_ASSERT_EQUAL_STRING("index", args.arg[0].name);
+  TEST_ASSERT_EQUAL_STRING("1", args.arg[0].value);
+  TEST_ASSERT_TRUE(args.arg[1].value >= buf && args.arg[1].value < buf + sizeof(buf));
+  TEST_ASSERT_TRUE(hasApiArg(args, "flag"));
+  TEST_ASSERT_EQUAL_STRING("", findApiArg(args, "flag")->value);
+  TEST_ASSERT_EQUAL_UINT16(0, findApiArg(args, "empty")->len);
+  TEST_ASSERT_FALSE(hasApiArg(args, "minute"));
+
+  parseApiArgs(args, nullptr);
+  TEST_ASSERT_EQUAL_UINT8(0, args.count);
+}
+
+void test_values_are_percent_decoded() {
+  parse("cron=15%2C45+6-22%2F2+*+*+0%2C6&url=http%3a%2F%2Fh%2Fa.bin&bad=%4&n%61me=x");
+  TEST_ASSERT_EQUAL_STRING("15,45 6-22/2 * * 0,6", findApiArg(args, "cron")->value);
+  TEST_ASSERT_EQUAL_UINT16(20, findApiArg(args, "cron")->len);
+  TEST_ASSERT_EQUAL_STRING("http://h/a.bin", findApiArg(args, "url")->value);
+  TEST_ASSERT_EQUAL_STRING("%4", findApiArg(args, "bad")->value);  // kept as sent
+  TEST_ASSERT_TRUE(hasApiArg(args, "name"));
+}
+
+void test_too_many_arguments_truncates() {
+  char q[200] = "";
+  for (int i = 0; i <= API_ARGS_MAX; i++) strcat(q, "a=1&");
+  parse(q);
+  TEST_ASSERT_TRUE(args.truncated);
+  TEST_ASSERT_EQUAL_UINT8(API_ARGS_MAX, args.count);
+}
+
+void test_copied_arguments_fill_the_arena() {
+  char arena[16];
+  initApiArgs(args, arena, sizeof(arena));
+  TEST_ASSERT_TRUE(addApiArg(args, "hour", 4, "7", 1));
+  TEST_ASSERT_TRUE(addApiArg(args, "min", 3, "30", 2));  // 7 + 7 bytes used
+  TEST_ASSERT_FALSE(addApiArg(args, "x", 1, "1", 1));
+  TEST_ASSERT_TRUE(args.truncated);
+  int32_t v = 0;
+  TEST_ASSERT_EQUAL(ARG_OK, argInt(args, "min", 0, 59, v));
+  TEST_ASSERT_EQUAL_INT32(30, v);
+}
+
+void test_integers_are_checked() {
+  parse("a=42&b=-7&c=%2B3&d=12x&e=&f=-&g=99999999999999999999&h=4294967295&i=08");
+  int32_t v = -1;
+  TEST_ASSERT_EQUAL(ARG_OK, argInt(args, "a", 0, 100, v));
+  TEST_ASSERT_EQUAL_INT32(42, v);
+  TEST_ASSERT_EQUAL(ARG_OK, argInt(args, "b", -10, 10, v));
+  TEST_ASSERT_EQUAL_INT32(-7, v);
+  TEST_ASSERT_EQUAL(ARG_OK, argInt(args, "c", 0, 10, v));
+  TEST_ASSERT_EQUAL_INT32(3, v);
+  TEST_ASSERT_EQUAL(ARG_OK, argInt(args, "i", 0, 23, v));
+  TEST_ASSERT_EQUAL_INT32(8, v);
+
+  v = 5;
+  TEST_ASSERT_EQUAL(ARG_RANGE, argInt(args, "a", 0, 23, v));
+  TEST_ASSERT_EQUAL(ARG_INVALID, argInt(args, "d", 0, 100, v));
+  TEST_ASSERT_EQUAL(ARG_INVALID, argInt(args, "e", 0, 100, v));
+  TEST_ASSERT_EQUAL(ARG_INVALID, argInt(args, "f", 0, 100, v));
+  TEST_ASSERT_EQUAL(ARG_INVALID, argInt(args, "g", 0, 100, v));
+  TEST_ASSERT_EQUAL(ARG_MISSING, argInt(args, "z", 0, 100, v));
+  TEST_ASSERT_EQUAL_INT32(5, v);  // untouched unless ARG_OK
+
+  uint32_t u = 0;
+  TEST_ASSERT_EQUAL(ARG_OK, argUint(args, "h", 0, UINT32_MAX, u));
+  TEST_ASSERT_EQUAL_UINT32(4294967295u, u);
+  TEST_ASSERT_EQUAL(ARG_RANGE, argUint(args, "b", 0, UINT32_MAX, u));
+}
+
+void test_floats_are_checked() {
+  parse("a=45.5&b=-0.25&c=.5&d=7.&e=1e3&f=.&g=nan&h=12");
+  float f = 0;
+  TEST_ASSERT_EQUAL(ARG_OK, argFloat(args, "a", 0, 1000, f));
+  TEST_ASSERT_EQUAL_FLOAT(45.5f, f);
+  TEST_ASSERT_EQUAL(ARG_OK, argFloat(args, "b", -1, 1, f));
+  TEST_ASSERT_EQUAL_FLOAT(-0.25f, f);
+  TEST_ASSERT_EQUAL(ARG_OK, argFloat(args, "c", 0, 1, f));
+  TEST_ASSERT_EQUAL_FLOAT(0.5f, f);
+  TEST_ASSERT_EQUAL(ARG_OK, argFloat(args, "d", 0, 10, f));
+  TEST_ASSERT_EQUAL_FLOAT(7.0f, f);
+  TEST_ASSERT_EQUAL(ARG_OK, argFloat(args, "h", 0, 100, f));
+  TEST_ASSERT_EQUAL_FLOAT(12.0f, f);
+
+  TEST_ASSERT_EQUAL(ARG_INVALID, argFloat(args, "e", 0, 1e6f, f));
+  TEST_ASSERT_EQUAL(ARG_INVALID, argFloat(args, "f", 0, 1, f));
+  TEST_ASSERT_EQUAL(ARG_INVALID, argFloat(args, "g", 0, 1, f));
+  TEST_ASSERT_EQUAL(ARG_RANGE, argFloat(args, "b", 0, 1, f));
+}
+
+void test_error_messages() {
+  char msg[48];
+  formatArgError(msg, sizeof(msg), "hour", ARG_MISSING);
+  TEST_ASSERT_EQUAL_STRING("Missing hour", msg);
+  formatArgError(msg, sizeof(msg), "hour", ARG_INVALID);
+  TEST_ASSERT_EQUAL_STRING("hour must be a number", msg);
+  formatArgError(msg, sizeof(msg), "hour", ARG_RANGE);
+  TEST_ASSERT_EQUAL_STRING("hour out of range", msg);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_route_lookup_by_path_and_method);
+  RUN_TEST(test_method_names);
+  RUN_TEST(test_query_is_split_in_place);
+  RUN_TEST(test_values_are_percent_decoded);
+  RUN_TEST(test_too_many_arguments_truncates);
+  RUN_TEST(test_copied_arguments_fill_the_arena);
+  RUN_TEST(test_integers_are_checked);
+  RUN_TEST(test_floats_are_checked);
+  RUN_TEST(test_error_messages);
+  return UNITY_END();
+}
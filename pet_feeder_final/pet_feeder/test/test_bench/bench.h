@@ -0,0 +1,77 @@
+#pragma once
+#include <chrono>
+#include <stdio.h>
+#include <stddef.h>
+#include "sha256.h"
+
+// Tiny micro-benchmark harness for the native test env.
+// Allocations are counted by the operator new override in test_main.cpp.
+
+extern size_t g_allocCount;
+
+struct BenchResult {
+  const char* name;
+  double nsPerOp;
+  double vsReference;  // ns/op over the reference kernel's, timed alongside
+  double allocsPerOp;
+};
+
+const int BENCH_RUNS = 7;
+
+// One timed run of the reference kernel: ns to hash a 64-byte block, a
+// fixed piece of plain integer work from lib/feeder_core
+inline double referenceRun() {
+  static uint8_t block[64];
+  uint8_t out[SHA256_BYTES];
+  const int n = 20000;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < n; i++) {
+    Sha256 s;
+    sha256Init(s);
+    sha256Update(s, block, sizeof(block) - 9);  // one compression with the padding
+    sha256Final(s, out);
+    block[i & 31] = out[0];
+  }
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(end - start).count() / n;
+}
+
+// Calls fn() `iters` times after a short warm-up, BENCH_RUNS times over,
+// each run followed by one of the reference kernel, and reports the
+// fastest run's ns/op, the lowest ratio of a run to the reference run next
+// to it, and the heap allocations/op of all runs. The ratio is what limits
+// hold: it does not depend on the host's speed, and noise that slows a
+// kernel run down but not its neighbour only lifts the runs it hits, so a
+// kernel fails only when every run of it came out slow.
+template <typename Fn>
+BenchResult runBench(const char* name, long iters, Fn fn) {
+  for (long i = 0; i < iters / 10 + 1; i++) fn();
+
+  size_t allocsBefore = g_allocCount;
+  double best = 0, ratio = 0;
+  for (int run = 0; run < BENCH_RUNS; run++) {
+    auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < iters; i++) fn();
+    auto end = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(end - start).count() / iters;
+    size_t allocs = g_allocCount;
+    double r = referenceRun();
+    g_allocCount = allocs;
+    if (run == 0 || ns < best) best = ns;
+    if (run == 0 || ns / r < ratio) ratio = ns / r;
+  }
+
+  BenchResult r;
+  r.name = name;
+  r.nsPerOp = best;
+  r.vsReference = ratio;
+  r.allocsPerOp = double(g_allocCount - allocsBefore) / ((double)iters * BENCH_RUNS);
+  printf("[bench] %-24s %10.1f ns/op %8.2f allocs/op\n", r.name, r.nsPerOp, r.allocsPerOp);
+  return r;
+}
+
+// Keeps the optimizer from dropping a benchmarked result.
+template <typename T>
+inline void doNotOptimize(const T& value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+// Regression thresholds for test_bench (native, -O2): each kernel's ns/op
+// as measured, with the reference kernel (referenceRun() in bench.h) at
+// BENCH_REFERENCE_NS on the same host. A run scales the baselines by how
+// fast the reference runs right then, so they follow the host (another
+// machine, or a CPU clocked up or down), and fails a kernel more than
+// BENCH_TOLERANCE slower than its baseline, or one that starts allocating.
+// The baselines are medians of 40 runs; single runs land up to a quarter
+// above them on a quiet host, and a shared CI runner is noisier still.
+// Re-baseline from the "x baseline" lines of
+// `pio test -e native -f test_bench -v` when a kernel is deliberately made
+// faster or slower.
+
+const double BENCH_TOLERANCE    = 1.5;
+const double BENCH_REFERENCE_NS = 289;
+
+// Full /api/status document: 3 slots, 10 history entries
+const double BENCH_STATUS_JSON_NS      = 2760;
+// Same document as CBOR or MessagePack (status_binary.h)
+const double BENCH_STATUS_CBOR_NS      = 266;
+const double BENCH_STATUS_MSGPACK_NS   = 244;
+// Delta document + ETag served from the shared status cache
+const double BENCH_STATUS_CACHE_HIT_NS = 5.25;
+// checkSlotDue per slot + nextFeedingTime over 3 compiled rules (daily, interval, cron)
+const double BENCH_SCHEDULE_NS         = 42;
+// One checkFeedProgress() step
+const double BENCH_FEED_MONITOR_NS     = 2.57;
+// A second of HX711 conversions (10) into the moving mean, depth 5
+const double BENCH_MEAN_FILTER_NS      = 28.3;
+// POST /api/set-slot: route lookup, query split and decoded in place, 9 typed fields
+const double BENCH_API_REQUEST_NS      = 329;
+
+const double BENCH_MAX_ALLOCS_PER_OP   = 0;
@@ -0,0 +1,235 @@
+// Micro-benchmarks for the control path with regression thresholds.
+// Run with `pio test -e native -f test_bench -v` to see the ns/op table.
+#include <unity.h>
+#include <new>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "bench_limits.h"
+#include "feeder_time.h"
+#include "schedule.h"
+#include "feed_log.h"
+#include "feed_monitor.h"
+#include "mean_filter.h"
+#include "status_json.h"
+#include "status_cache.h"
+#include "status_binary.h"
+#include "api_request.h"
+
+size_t g_allocCount = 0;
+
+void* operator new(size_t n) {
+  g_allocCount++;
+  void* p = malloc(n);
+  if (!p) throw std::bad_alloc();
+  return p;
+}
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+static FeedingSlot slots[3];
+static FeedLogEntry log_[10];
+static int logCount;
+
+void setUp() {
+  slots[0] = {true,   8, 0, 50};
+  slots[1] = {true,  12, 0, 80};
+  slots[2] = {true,  18, 30, 120};
+  logCount = 0;
+  clearFeedLog(log_, 10, logCount);
+  for (int i = 0; i < 10; i++) {
+    FeedLogEntry e = {};
+    e.manual = (i % 3 == 0);
+    e.slotIndex = e.manual ? -1 : i % 3;
+    e.hour = 8 + i; e.minute = 5 * i;
+    e.target = 100 + i; e.finalWeight = 98 + i;
+    pushFeedLog(log_, 10, logCount, e);
+  }
+}
+
+void tearDown() {}
+
+// Holds r to its baseline, relative to the reference kernel
+static void checkLimits(const BenchResult& r, double baselineNs) {
+  double vsBaseline = r.vsReference * BENCH_REFERENCE_NS / baselineNs;
+  printf("[bench] %-24s %10.3fx baseline\n", r.name, vsBaseline);
+  char msg[96];
+  snprintf(msg, sizeof(msg), "%s regressed: %.2fx baseline > %.2fx", r.name, vsBaseline,
+           BENCH_TOLERANCE);
+  TEST_ASSERT_TRUE_MESSAGE(vsBaseline <= BENCH_TOLERANCE, msg);
+  snprintf(msg, sizeof(msg), "%s allocates: %.2f/op", r.name, r.allocsPerOp);
+  TEST_ASSERT_TRUE_MESSAGE(r.allocsPerOp <= BENCH_MAX_ALLOCS_PER_OP, msg);
+}
+
+void bench_status_json() {
+  static char out[statusJsonCapacity(3, 10)];
+  StatusView view = {42.5f, false, unixTime(2025, 1, 1, 18, 30, 0), slots, 3, log_, logCount, nullptr, nullptr};
+  BenchResult r = runBench("status_json", 20000, [&]() {
+    doNotOptimize(writeStatusJson(out, sizeof(out), view));
+  });
+  checkLimits(r, BENCH_STATUS_JSON_NS);
+}
+
+// Same document in the compact encodings; prints the size next to JSON's
+static void benchStatusBinary(const char* name, WireFormat f, double baselineNs) {
+  static char json[statusJsonCapacity(3, 10)];
+  static uint8_t out[statusJsonCapacity(3, 10)];
+  StatusView view = {42.5f, false, unixTime(2025, 1, 1, 18, 30, 0), slots, 3, log_, logCount, nullptr, nullptr};
+  size_t jsonLen = writeStatusJson(json, sizeof(json), view);
+  size_t len = writeStatusBinary(out, sizeof(out), view, f);
+  printf("[bench] %-24s %10zu bytes (json %zu, %.0f%%)\n", name, len, jsonLen,
+         100.0 * len / jsonLen);
+  TEST_ASSERT_TRUE(len > 0 && len < jsonLen);
+
+  BenchResult r = runBench(name, 200000, [&]() {
+    doNotOptimize(writeStatusBinary(out, sizeof(out), view, f));
+  });
+  checkLimits(r, baselineNs);
+}
+
+void bench_status_cbor() {
+  benchStatusBinary("status_cbor", WIRE_CBOR, BENCH_STATUS_CBOR_NS);
+}
+
+void bench_status_msgpack() {
+  benchStatusBinary("status_msgpack", WIRE_MSGPACK, BENCH_STATUS_MSGPACK_NS);
+}
+
+// What the N-th dashboard polling after a change costs: a cache hit
+void bench_status_cache_hit() {
+  static char storage[STATUS_CACHE_ENTRIES * statusJsonCapacity(3, 10)];
+  StatusCache cache;
+  initStatusCache(cache, storage, statusJsonCapacity(3, 10));
+  StatusVersions v;
+  initStatusVersions(v, 0xbeef);
+  bumpStatusVersion(v, v.state);
+  bumpStatusVersion(v, v.history);
+  StatusView view = {42.5f, false, unixTime(2025, 1, 1, 18, 30, 0), slots, 3, log_, logCount, nullptr, nullptr};
+  uint32_t since = v.state;
+  BenchResult r = runBench("status_cache_hit", 1000000, [&]() {
+    const StatusCacheEntry* e = statusCacheDelta(cache, view, v, since);
+    doNotOptimize(e->len);
+    doNotOptimize(statusCacheEtag(cache, v));
+  });
+  checkLimits(r, BENCH_STATUS_CACHE_HIT_NS);
+}
+
+void bench_schedule_lookup() {
+  // One plain daily slot, one weekday interval rule, one cron rule
+  FeedingSlot mixed[3] = {slots[0], slots[1], {true, 0, 0, 25}};
+  mixed[1].days = 0x3E;
+  mixed[1].everyMin = 90;
+  mixed[1].untilMin = 20 * 60;
+  strcpy(mixed[2].cron, "15,45 6-22/2 * * 0,6");
+  CompiledRule rules[3];
+  compileSlots(mixed, rules, 3);
+
+  uint32_t t = unixTime(2025, 1, 1, 0, 0, 0);
+  uint32_t markers[3] = {t, t, t};
+  BenchResult r = runBench("schedule_lookup", 1000000, [&]() {
+    t += 7;
+    for (int i = 0; i < 3; i++) doNotOptimize(checkSlotDue(rules[i], markers[i], t).amount);
+    doNotOptimize(nextFeedingTime(rules, 3, t));
+  });
+  checkLimits(r, BENCH_SCHEDULE_NS);
+}
+
+void bench_feed_monitor_step() {
+  const FeedLimits limits = {15000, 4000, 2.0f};
+  FeedProgress p;
+  startFeedProgress(p, 0, 1e9f, 0);
+  uint32_t now = 0;
+  float w = 0;
+  BenchResult r = runBench("feed_monitor_step", 1000000, [&]() {
+    now += 50;
+    w += 0.5f;
+    doNotOptimize(checkFeedProgress(p, w, true, now % 10000, limits));
+  });
+  checkLimits(r, BENCH_FEED_MONITOR_NS);
+}
+
+// A second of HX711 conversions into the moving mean, at the boards' depth
+void bench_mean_filter() {
+  int32_t ring[5];
+  MeanFilter f;
+  initMeanFilter(f, ring, 5);
+  int32_t raw = 84000;
+  BenchResult r = runBench("mean_filter", 100000, [&]() {
+    for (int i = 0; i < 10; i++) {
+      raw += (raw & 7) - 3;
+      doNotOptimize(meanFilterPush(f, raw));
+    }
+  });
+  checkLimits(r, BENCH_MEAN_FILTER_NS);
+}
+
+// One POST /api/set-slot as it arrives: route lookup among the firmware's
+// routes, the query split and decoded in place, every field read typed and
+// range-checked into a SlotEdit
+void bench_api_request() {
+  static constexpr ApiRoute<int> routes[] = {
+    {"/",                      API_GET,  LANE_READ,     0},
+    {"/api/admission",         API_GET,  LANE_READ,     1},
+    {"/api/export",            API_GET,  LANE_READ,     2},
+    {"/api/flow",              API_GET,  LANE_READ,     3},
+    {"/api/hopper/refill",     API_POST, LANE_WRITE,    4},
+    {"/api/live",              API_GET,  LANE_READ,     5},
+    {"/api/logs",              API_GET,  LANE_READ,     6},
+    {"/api/loop",              API_GET,  LANE_READ,     7},
+    {"/api/manual-feed",       API_POST, LANE_PRIORITY, 8},
+    {"/api/ota",               API_GET,  LANE_READ,     9},
+    {"/api/ota",               API_POST, LANE_WRITE,    10},
+    {"/api/queue",             API_GET,  LANE_READ,     11},
+    {"/api/recordings",        API_GET,  LANE_READ,     12},
+    {"/api/recordings/clear",  API_POST, LANE_WRITE,    13},
+    {"/api/reset",             API_POST, LANE_PRIORITY, 14},
+    {"/api/serial",            API_GET,  LANE_READ,     15},
+    {"/api/set-slot",          API_POST, LANE_WRITE,    16},
+    {"/api/stats",             API_GET,  LANE_READ,     17},
+    {"/api/status",            API_GET,  LANE_READ,     18},
+    {"/api/trace",             API_GET,  LANE_READ,     19},
+  };
+  static_assert(apiRoutesSorted(routes), "bench routes sorted");
+  static const char request[] =
+      "/api/set-slot?index=1&hour=07&minute=30&weight=45.5&days=62&every=90&until=1200"
+      "&catchUp=late&cron=15%2C45+6-22%2F2+*+*+0%2C6";
+  char target[sizeof(request)];
+  ApiArgs args;
+  BenchResult r = runBench("api_request", 1000000, [&]() {
+    memcpy(target, request, sizeof(request));
+    char* query = strchr(target, '?');
+    *query++ = '\0';
+    const ApiRoute<int>* route = findApiRoute(routes, API_POST, target);
+    parseApiArgs(args, query);
+    int32_t index = 0;
+    SlotEdit e = {};
+    bool ok = route && !args.truncated &&
+              argInt(args, "index", 0, 2, index) == ARG_OK &&
+              argInt(args, "hour", 0, 23, e.hour) == ARG_OK &&
+              argInt(args, "minute", 0, 59, e.minute) == ARG_OK &&
+              argFloat(args, "weight", 0, 5000, e.weight) == ARG_OK &&
+              argInt(args, "days", 1, ALL_DAYS, e.days) == ARG_OK &&
+              argInt(args, "every", 0, MINUTES_PER_DAY - 1, e.everyMin) == ARG_OK &&
+              argInt(args, "until", 0, MINUTES_PER_DAY - 1, e.untilMin) == ARG_OK &&
+              parseCatchUpPolicy(findApiArg(args, "catchUp")->value, e.catchUp);
+    e.cron = findApiArg(args, "cron")->value;
+    TEST_ASSERT_TRUE(ok);
+    doNotOptimize(e);
+    doNotOptimize(index);
+  });
+  checkLimits(r, BENCH_API_REQUEST_NS);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(bench_status_json);
+  RUN_TEST(bench_status_cbor);
+  RUN_TEST(bench_status_msgpack);
+  RUN_TEST(bench_status_cache_hit);
+  RUN_TEST(bench_schedule_lookup);
+  RUN_TEST(bench_feed_monitor_step);
+  RUN_TEST(bench_mean_filter);
+  RUN_TEST(bench_api_request);
+  return UNITY_END();
+}
+
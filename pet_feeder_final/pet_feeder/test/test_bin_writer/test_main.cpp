@@ -0,0 +1,130 @@
+// CBOR / MessagePack encoder and Accept negotiation (bin_writer.h).
+// Expected bytes are the examples from RFC 8949 Appendix A and the
+// MessagePack spec.
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include "bin_writer.h"
+
+static uint8_t buf[64];
+
+static void assertBytes(const char* hex, const BinWriter& w) {
+  uint8_t want[64];
+  size_t n = strlen(hex) / 2;
+  for (size_t i = 0; i < n; i++) {
+    unsigned v;
+    sscanf(hex + 2 * i, "%2x", &v);
+    want[i] = (uint8_t)v;
+  }
+  TEST_ASSERT_TRUE(w.ok());
+  TEST_ASSERT_EQUAL_size_t(n, w.length());
+  TEST_ASSERT_EQUAL_MEMORY(want, buf, n);
+}
+
+#define ENCODE(fmt, hex, call) \
+  do {                         \
+    BinWriter w(buf, sizeof(buf), fmt); \
+    w.call;                    \
+    assertBytes(hex, w);       \
+  } while (0)
+
+void setUp() {
+  memset(buf, 0, sizeof(buf));
+}
+
+void tearDown() {}
+
+void test_cbor_integers() {
+  ENCODE(WIRE_CBOR, "00", uint(0));
+  ENCODE(WIRE_CBOR, "17", uint(23));
+  ENCODE(WIRE_CBOR, "1818", uint(24));
+  ENCODE(WIRE_CBOR, "18ff", uint(255));
+  ENCODE(WIRE_CBOR, "190100", uint(256));
+  ENCODE(WIRE_CBOR, "1a000f4240", uint(1000000));
+  ENCODE(WIRE_CBOR, "20", sint(-1));
+  ENCODE(WIRE_CBOR, "3863", sint(-100));
+  ENCODE(WIRE_CBOR, "3903e7", sint(-1000));
+  ENCODE(WIRE_CBOR, "3a7fffffff", sint(INT32_MIN));
+}
+
+void test_cbor_simple_and_containers() {
+  ENCODE(WIRE_CBOR, "f4", boolean(false));
+  ENCODE(WIRE_CBOR, "f5", boolean(true));
+  ENCODE(WIRE_CBOR, "f6", null());
+  ENCODE(WIRE_CBOR, "6449455446", str("IETF"));
+  ENCODE(WIRE_CBOR, "60", str(""));
+  ENCODE(WIRE_CBOR, "a2", map(2));
+  ENCODE(WIRE_CBOR, "9819", array(25));
+}
+
+void test_msgpack_integers() {
+  ENCODE(WIRE_MSGPACK, "00", uint(0));
+  ENCODE(WIRE_MSGPACK, "7f", uint(127));
+  ENCODE(WIRE_MSGPACK, "cc80", uint(128));
+  ENCODE(WIRE_MSGPACK, "cd0100", uint(256));
+  ENCODE(WIRE_MSGPACK, "ce00010000", uint(65536));
+  ENCODE(WIRE_MSGPACK, "ff", sint(-1));
+  ENCODE(WIRE_MSGPACK, "e0", sint(-32));
+  ENCODE(WIRE_MSGPACK, "d0df", sint(-33));
+  ENCODE(WIRE_MSGPACK, "d1ff7f", sint(-129));
+  ENCODE(WIRE_MSGPACK, "d2ffff63c0", sint(-40000));
+}
+
+void test_msgpack_simple_and_containers() {
+  ENCODE(WIRE_MSGPACK, "c2", boolean(false));
+  ENCODE(WIRE_MSGPACK, "c3", boolean(true));
+  ENCODE(WIRE_MSGPACK, "c0", null());
+  ENCODE(WIRE_MSGPACK, "a449455446", str("IETF"));
+  ENCODE(WIRE_MSGPACK, "82", map(2));
+  ENCODE(WIRE_MSGPACK, "de0010", map(16));
+  ENCODE(WIRE_MSGPACK, "9f", array(15));
+  ENCODE(WIRE_MSGPACK, "dc0010", array(16));
+
+  char s32[33];
+  memset(s32, 'x', 32);
+  s32[32] = '\0';
+  BinWriter w(buf, sizeof(buf), WIRE_MSGPACK);
+  w.str(s32);
+  TEST_ASSERT_EQUAL_size_t(34, w.length());
+  TEST_ASSERT_EQUAL_HEX8(0xd9, buf[0]);
+  TEST_ASSERT_EQUAL_HEX8(32, buf[1]);
+}
+
+void test_overflow_is_sticky() {
+  BinWriter w(buf, 2, WIRE_CBOR);
+  w.uint(1);
+  TEST_ASSERT_TRUE(w.ok());
+  w.uint(256);  // 3 bytes, 1 left
+  TEST_ASSERT_FALSE(w.ok());
+  w.uint(2);
+  TEST_ASSERT_FALSE(w.ok());
+
+  BinWriter s(buf, 4, WIRE_MSGPACK);
+  s.str("IETF");
+  TEST_ASSERT_FALSE(s.ok());
+}
+
+void test_accept_negotiation() {
+  TEST_ASSERT_EQUAL(WIRE_JSON, negotiateWireFormat(nullptr));
+  TEST_ASSERT_EQUAL(WIRE_JSON, negotiateWireFormat("*/*"));
+  TEST_ASSERT_EQUAL(WIRE_CBOR, negotiateWireFormat("application/cbor"));
+  TEST_ASSERT_EQUAL(WIRE_MSGPACK, negotiateWireFormat("application/msgpack"));
+  TEST_ASSERT_EQUAL(WIRE_MSGPACK, negotiateWireFormat("application/x-msgpack, */*;q=0.1"));
+  TEST_ASSERT_EQUAL(WIRE_MSGPACK, negotiateWireFormat("application/vnd.msgpack"));
+  TEST_ASSERT_EQUAL(WIRE_JSON, negotiateWireFormat("application/json, application/cbor"));
+  TEST_ASSERT_EQUAL(WIRE_CBOR, negotiateWireFormat("application/cbor, application/json"));
+  TEST_ASSERT_EQUAL_STRING("application/cbor", wireContentType(WIRE_CBOR));
+  TEST_ASSERT_EQUAL_STRING("application/msgpack", wireContentType(WIRE_MSGPACK));
+  TEST_ASSERT_EQUAL_STRING("application/json", wireContentType(WIRE_JSON));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_cbor_integers);
+  RUN_TEST(test_cbor_simple_and_containers);
+  RUN_TEST(test_msgpack_integers);
+  RUN_TEST(test_msgpack_simple_and_containers);
+  RUN_TEST(test_overflow_is_sticky);
+  RUN_TEST(test_accept_negotiation);
+  return UNITY_END();
+}
@@ -0,0 +1,237 @@
+// Dispense profiles (dispense.h) on the flow simulator (flow_sim.h).
+// Run with `pio test -e native -f test_dispense -v` to see the table of
+// throughput and accuracy per profile.
+#include <unity.h>
+#include <math.h>
+#include <stdio.h>
+#include "dispense.h"
+#include "flow_sim.h"
+
+static const FeedLimits LIMITS = {15000, 4000, 2.0f};
+static const uint32_t READ_MS = 100;  // one scale reading per monitor pass
+
+// Kibble through a servo gate: 15 g/s wide open, 300 ms to the bowl
+static const FlowSimParams FREE_FLOW = {15.0f, 15, 300, 0.0f, 0};
+// Same hopper, bridging every 25 g until shaken twice
+static const FlowSimParams BRIDGING  = {15.0f, 15, 300, 25.0f, 2};
+
+static const uint8_t LEGACY = 0xFF;  // open / monitor / close, no sequencer
+
+void setUp() {}
+void tearDown() {}
+
+struct Run {
+  FeedCheck outcome;
+  uint32_t  ms;          // gate opened to closed
+  float     error;       // final bowl weight - target, after settling
+  uint8_t   agitations;
+};
+
+static Run runFeed(uint8_t mode, float amount, const FlowSimParams& params) {
+  FlowSim sim;
+  initFlowSim(sim, params, 0.0f, 0);
+  FeedProgress p;
+  startFeedProgress(p, 0.0f, amount, 0);
+  FeedLimits limits = LIMITS;
+
+  Dispenser d = {};
+  if (mode == LEGACY) {
+    flowSimGate(sim, 100, 0);
+  } else {
+    limits.timeoutMs = dispenseTimeoutMs(mode, LIMITS.timeoutMs);
+    startDispense(d, mode, 0);
+    flowSimGate(sim, d.opening, 0);
+  }
+
+  Run r = {};
+  for (uint32_t t = READ_MS;; t += READ_MS) {
+    flowSimAdvance(sim, t);
+    bool open = sim.opening > 0;
+    if (mode != LEGACY) {
+      uint8_t opening = stepDispense(d, p, sim.bowlG, limits.stuckWindowMs, t);
+      if (opening != sim.opening) flowSimGate(sim, opening, t);
+      open = dispenseRunning(d);
+    }
+    FeedCheck c = checkFeedProgress(p, sim.bowlG, open, t, limits);
+    if (c != FEED_CONTINUE) {
+      flowSimGate(sim, 0, t);
+      flowSimAdvance(sim, t + 1000);
+      r.outcome = c;
+      r.ms = t;
+      r.error = sim.bowlG - amount;
+      r.agitations = d.agitations;
+      return r;
+    }
+  }
+}
+
+static const char* modeName(uint8_t mode) {
+  return mode == LEGACY ? "legacy" : dispenseModeName(mode);
+}
+
+static const char* outcomeName(FeedCheck c) {
+  return c == FEED_TARGET_REACHED ? "target" : c == FEED_STUCK ? "stuck" : "timeout";
+}
+
+static void report(const char* hopper, uint8_t mode, float amount, const Run& r) {
+  printf("  %-9s %-8s %5.0f g  %-7s %6.1f s  %5.1f g/s  %+6.1f g (%+5.1f%%)  %u agitations\n",
+         hopper, modeName(mode), amount, outcomeName(r.outcome), r.ms / 1000.0f,
+         (amount + r.error) * 1000.0f / r.ms, r.error, 100.0f * r.error / amount, r.agitations);
+}
+
+void test_profile_table() {
+  const uint8_t modes[] = {LEGACY, DISPENSE_FULL, DISPENSE_TRICKLE, DISPENSE_PULSE};
+  const float amounts[] = {10.0f, 30.0f, 100.0f};
+  printf("\n  hopper    profile  portion  outcome     time   throughput  error           jams\n");
+  for (float a : amounts) {
+    for (uint8_t m : modes) report("free", m, a, runFeed(m, a, FREE_FLOW));
+  }
+  for (uint8_t m : modes) report("bridging", m, 60.0f, runFeed(m, 60.0f, BRIDGING));
+}
+
+void test_full_profile_matches_legacy_on_free_flow() {
+  Run legacy = runFeed(LEGACY, 30.0f, FREE_FLOW);
+  Run full = runFeed(DISPENSE_FULL, 30.0f, FREE_FLOW);
+  TEST_ASSERT_EQUAL_INT(legacy.outcome, full.outcome);
+  TEST_ASSERT_EQUAL_UINT32(legacy.ms, full.ms);
+  TEST_ASSERT_EQUAL_FLOAT(legacy.error, full.error);
+  TEST_ASSERT_EQUAL_UINT8(0, full.agitations);
+}
+
+void test_trickle_cuts_overshoot() {
+  float amounts[] = {30.0f, 100.0f};
+  for (float a : amounts) {
+    Run legacy = runFeed(LEGACY, a, FREE_FLOW);
+    Run trickle = runFeed(DISPENSE_TRICKLE, a, FREE_FLOW);
+    TEST_ASSERT_EQUAL_INT(FEED_TARGET_REACHED, trickle.outcome);
+    TEST_ASSERT_TRUE(fabsf(trickle.error) < legacy.error / 2);
+    // Fine phase costs a few seconds at most
+    TEST_ASSERT_TRUE(trickle.ms < legacy.ms + 4000);
+  }
+}
+
+void test_pulse_accurate_for_small_portion() {
+  Run legacy = runFeed(LEGACY, 10.0f, FREE_FLOW);
+  Run pulse = runFeed(DISPENSE_PULSE, 10.0f, FREE_FLOW);
+  TEST_ASSERT_EQUAL_INT(FEED_TARGET_REACHED, pulse.outcome);
+  TEST_ASSERT_TRUE(fabsf(pulse.error) < legacy.error / 2);
+  TEST_ASSERT_TRUE(fabsf(pulse.error) <= 2.0f);
+}
+
+void test_agitation_clears_bridge_before_jam() {
+  Run legacy = runFeed(LEGACY, 60.0f, BRIDGING);
+  TEST_ASSERT_EQUAL_INT(FEED_STUCK, legacy.outcome);
+
+  uint8_t modes[] = {DISPENSE_FULL, DISPENSE_TRICKLE};
+  for (uint8_t m : modes) {
+    Run r = runFeed(m, 60.0f, BRIDGING);
+    TEST_ASSERT_EQUAL_INT(FEED_TARGET_REACHED, r.outcome);
+    TEST_ASSERT_TRUE(r.agitations >= 1);
+  }
+}
+
+void test_real_jam_still_declared_after_tries() {
+  // Bridge that never breaks
+  FlowSimParams solid = BRIDGING;
+  solid.bridgeSwings = 255;
+  Run r = runFeed(DISPENSE_FULL, 60.0f, solid);
+  TEST_ASSERT_EQUAL_INT(FEED_STUCK, r.outcome);
+  TEST_ASSERT_EQUAL_UINT8(kDispenseProfiles[DISPENSE_FULL].agitateTries, r.agitations);
+}
+
+void test_window_held_while_closed_and_at_partial_opening() {
+  FeedProgress p;
+  startFeedProgress(p, 0.0f, 50.0f, 0);
+  Dispenser d;
+  startDispense(d, DISPENSE_PULSE, 0);
+  const DispenseProfile& pr = kDispenseProfiles[DISPENSE_PULSE];
+
+  // Pulse on at openPct: the window runs at openPct speed
+  stepDispense(d, p, 0.0f, 100000, pr.pulseOnMs);
+  TEST_ASSERT_EQUAL_UINT8(DISPENSE_SETTLE, d.phase);
+  TEST_ASSERT_EQUAL_UINT8(0, d.opening);
+  TEST_ASSERT_EQUAL_UINT32(pr.pulseOnMs * (100 - pr.openPct) / 100, p.lastChangeMs);
+  TEST_ASSERT_EQUAL_UINT32(pr.pulseOnMs * pr.openPct / 100, d.openMs);
+
+  // Closed: held entirely
+  uint32_t before = p.lastChangeMs;
+  stepDispense(d, p, 0.0f, 100000, pr.pulseOnMs + pr.pulseOffMs);
+  TEST_ASSERT_EQUAL_UINT32(before + pr.pulseOffMs, p.lastChangeMs);
+  TEST_ASSERT_EQUAL_UINT8(DISPENSE_FLOW, d.phase);
+  TEST_ASSERT_EQUAL_UINT8(pr.openPct, d.opening);
+}
+
+void test_window_never_moves_past_now() {
+  FeedProgress p;
+  startFeedProgress(p, 0.0f, 50.0f, 0);
+  Dispenser d;
+  startDispense(d, DISPENSE_PULSE, 0);
+  const DispenseProfile& pr = kDispenseProfiles[DISPENSE_PULSE];
+  stepDispense(d, p, 0.0f, 100000, pr.pulseOnMs);
+  p.lastChangeMs = pr.pulseOnMs + 50;  // an increase counted mid-settle
+  stepDispense(d, p, 0.0f, 100000, pr.pulseOnMs + 100);
+  TEST_ASSERT_EQUAL_UINT32(pr.pulseOnMs + 100, p.lastChangeMs);
+}
+
+void test_trickle_near_target() {
+  FeedProgress p;
+  startFeedProgress(p, 0.0f, 50.0f, 0);
+  Dispenser d;
+  startDispense(d, DISPENSE_TRICKLE, 0);
+  const DispenseProfile& pr = kDispenseProfiles[DISPENSE_TRICKLE];
+  TEST_ASSERT_EQUAL_UINT8(pr.openPct, stepDispense(d, p, 10.0f, 4000, 100));
+  p.lastChangeMs = 100;
+  TEST_ASSERT_EQUAL_UINT8(pr.tricklePct, stepDispense(d, p, 50.0f - pr.trickleBandG, 4000, 200));
+}
+
+void test_stop_and_modes() {
+  Dispenser d;
+  startDispense(d, 99, 0);  // unknown: full
+  TEST_ASSERT_EQUAL_UINT8(DISPENSE_FULL, d.mode);
+  TEST_ASSERT_TRUE(dispenseRunning(d));
+  stopDispense(d);
+  TEST_ASSERT_FALSE(dispenseRunning(d));
+  TEST_ASSERT_EQUAL_UINT8(0, d.opening);
+
+  uint8_t m = 0;
+  TEST_ASSERT_TRUE(parseDispenseMode("pulse", m));
+  TEST_ASSERT_EQUAL_UINT8(DISPENSE_PULSE, m);
+  TEST_ASSERT_FALSE(parseDispenseMode("slam", m));
+  TEST_ASSERT_EQUAL_STRING("trickle", dispenseModeName(DISPENSE_TRICKLE));
+
+  const DispenseProfile& pr = kDispenseProfiles[DISPENSE_PULSE];
+  TEST_ASSERT_EQUAL_UINT32(15000 * pr.timeoutPct / 100 +
+                               pr.agitateTries * pr.agitateMoves * pr.agitateStepMs,
+                           dispenseTimeoutMs(DISPENSE_PULSE, 15000));
+}
+
+void test_flow_sim_delay_and_rate() {
+  FlowSim s;
+  initFlowSim(s, FREE_FLOW, 5.0f, 0);
+  flowSimGate(s, 100, 0);
+  flowSimAdvance(s, 300);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 5.0f, s.bowlG);  // nothing landed yet
+  flowSimAdvance(s, 1300);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 20.0f, s.bowlG);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 4.5f, flowSimFalling(s));
+
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, flowSimRate(FREE_FLOW, 15));
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, 15.0f * 42 / 85, flowSimRate(FREE_FLOW, 57));
+  TEST_ASSERT_EQUAL_FLOAT(15.0f, flowSimRate(FREE_FLOW, 100));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_profile_table);
+  RUN_TEST(test_full_profile_matches_legacy_on_free_flow);
+  RUN_TEST(test_trickle_cuts_overshoot);
+  RUN_TEST(test_pulse_accurate_for_small_portion);
+  RUN_TEST(test_agitation_clears_bridge_before_jam);
+  RUN_TEST(test_real_jam_still_declared_after_tries);
+  RUN_TEST(test_window_held_while_closed_and_at_partial_opening);
+  RUN_TEST(test_window_never_moves_past_now);
+  RUN_TEST(test_trickle_near_target);
+  RUN_TEST(test_stop_and_modes);
+  RUN_TEST(test_flow_sim_delay_and_rate);
+  return UNITY_END();
+}
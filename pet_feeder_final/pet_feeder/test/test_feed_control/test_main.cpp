@@ -0,0 +1,235 @@
+// Feed orchestration (feed_control.h) against the flow simulator, with the
+// hooks recording what the firmware would have done.
+#include <unity.h>
+#include <math.h>
+#include "feed_control.h"
+#include "feeder_time.h"
+#include "flow_sim.h"
+
+static const FeedConfig CFG = {{15000, 4000, 2.0f}, 60000, DISPENSE_FULL};
+static const uint32_t READ_MS = 100;
+static const uint32_t T0 = unixTime(2025, 1, 6, 7, 59, 0);
+
+// 15 g/s wide open, 300 ms to the bowl
+static const FlowSimParams FREE_FLOW = {15.0f, 15, 300, 0.0f, 0};
+static const FlowSimParams NO_FOOD   = {0.0f, 15, 300, 0.0f, 0};
+
+static FeedCommand storage[4];
+static FeedControl c;
+static FlowStats flow;
+static HopperState hopper;
+static FeedJournal journal;
+static CalCapture cal;
+static FlowSim sim;
+static uint32_t ms;
+
+// What the hooks saw
+static bool held;
+static uint8_t saves;
+static int records;
+static HistoryRecord lastRecord;
+static int started;
+static int finished;
+static FeedOutcome lastOutcome;
+static int dues;
+
+static void gate(void*, uint8_t pct) { flowSimGate(sim, pct, ms); }
+static void save(void*, uint8_t what) { saves |= what; }
+static uint32_t unixClock(void*) { return T0 + ms / 1000; }
+static bool isHeld(void*) { return held; }
+static void record(void*, const HistoryRecord& r) {
+  records++;
+  lastRecord = r;
+}
+static void onStarted(void*) { started++; }
+static void onFinished(void*, const FeedOutcome& o) {
+  finished++;
+  lastOutcome = o;
+}
+static void onDue(void*, int, const DueFeed&, FeedEnqueue) { dues++; }
+
+// One loop pass: scale, dispatch, monitor
+static FeedCheck pass() {
+  ms += READ_MS;
+  flowSimAdvance(sim, ms);
+  dispatchFeed(c, sim.bowlG, ms);
+  return stepFeed(c, sim.bowlG, ms);
+}
+
+// Passes until the feed in flight ends; its outcome
+static FeedCheck runFeed() {
+  for (int i = 0; i < 1000; i++) {
+    FeedCheck check = pass();
+    if (check != FEED_CONTINUE) return check;
+  }
+  return FEED_CONTINUE;
+}
+
+void setUp() {
+  ms = 0;
+  held = false;
+  saves = 0;
+  records = started = finished = dues = 0;
+  initFlowSim(sim, FREE_FLOW, 0.0f, 0);
+  initFlowStats(flow);
+  initHopper(hopper, 1000.0f);
+  journal = {};
+  initCalCapture(cal);
+  FeedHooks hooks = {};
+  hooks.gate = gate;
+  hooks.save = save;
+  hooks.clock = unixClock;
+  hooks.held = isHeld;
+  hooks.record = record;
+  hooks.started = onStarted;
+  hooks.finished = onFinished;
+  hooks.due = onDue;
+  initFeedControl(c, CFG, storage, 4, flow, hopper, journal, cal, hooks);
+}
+void tearDown() {}
+
+// Request to outcome: gate, journal, history, hopper and flow all follow
+void test_feed_runs_to_target() {
+  hopperRefill(hopper, 0, T0);
+  TEST_ASSERT_EQUAL(FEED_QUEUED, requestFeed(c, FEED_SRC_API, -1, 30.0f, DISPENSE_FULL, ms));
+  pass();
+  TEST_ASSERT_TRUE(c.active);
+  TEST_ASSERT_TRUE(c.manual);
+  TEST_ASSERT_EQUAL_INT(1, started);
+  TEST_ASSERT_EQUAL_UINT8(100, c.opening);
+  TEST_ASSERT_TRUE(journalValid(journal));
+  TEST_ASSERT_EQUAL_FLOAT(30.0f, journal.amount);
+
+  TEST_ASSERT_EQUAL(FEED_TARGET_REACHED, runFeed());
+  TEST_ASSERT_FALSE(c.active);
+  TEST_ASSERT_EQUAL_UINT8(0, c.opening);
+  TEST_ASSERT_EQUAL_UINT8(0, sim.opening);
+  TEST_ASSERT_FALSE(journalValid(journal));
+  TEST_ASSERT_EQUAL_UINT8(FEED_SAVE_JOURNAL | FEED_SAVE_HOPPER | FEED_SAVE_FLOW, saves);
+
+  TEST_ASSERT_EQUAL_INT(1, finished);
+  TEST_ASSERT_EQUAL(FEED_TARGET_REACHED, lastOutcome.reason);
+  TEST_ASSERT_EQUAL_INT(-1, lastOutcome.slot);
+  TEST_ASSERT_FLOAT_WITHIN(1.0f, 30.0f, lastOutcome.dispensed);
+  TEST_ASSERT_EQUAL_INT(1, records);
+  TEST_ASSERT_EQUAL_UINT8(FEED_TARGET_REACHED, lastRecord.outcome);
+  TEST_ASSERT_EQUAL_INT32(300, lastRecord.targetDg);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 1000.0f - lastOutcome.dispensed, hopper.remainingG);
+  TEST_ASSERT_EQUAL_UINT16(1, flow.feeds);
+}
+
+// A slot that comes due is queued with the configured profile and its slot
+void test_due_slot_is_fed() {
+  FeedingSlot slots[1] = {{true, 8, 0, 20.0f}};
+  CompiledRule rules[1];
+  uint32_t markers[1] = {NO_MARKER};
+  compileSlots(slots, rules, 1);
+
+  TEST_ASSERT_TRUE(checkScheduledFeeds(c, rules, markers, 1, T0, ms));  // marker set
+  TEST_ASSERT_EQUAL_INT(0, c.queue.count);
+  checkScheduledFeeds(c, rules, markers, 1, T0 + 60, ms);
+  TEST_ASSERT_EQUAL_INT(1, dues);
+  TEST_ASSERT_EQUAL_INT(1, c.queue.count);
+
+  TEST_ASSERT_EQUAL(FEED_TARGET_REACHED, runFeed());
+  TEST_ASSERT_FALSE(lastOutcome.manual);
+  TEST_ASSERT_EQUAL_INT(0, lastOutcome.slot);
+  TEST_ASSERT_EQUAL_INT8(0, lastRecord.slot);
+}
+
+// An empty hopper skips a scheduled feed on the record, but not a manual one
+void test_empty_hopper_skips_scheduled_only() {
+  hopperRefill(hopper, 0, T0);
+  hopperMarkEmpty(hopper);
+  requestFeed(c, FEED_SRC_SCHEDULED, 1, 20.0f, DISPENSE_FULL, ms);
+  pass();
+  TEST_ASSERT_FALSE(c.active);
+  TEST_ASSERT_EQUAL_INT(0, started);
+  TEST_ASSERT_EQUAL_INT(1, records);
+  TEST_ASSERT_EQUAL_UINT8(HIST_SKIPPED_EMPTY, lastRecord.outcome);
+  TEST_ASSERT_EQUAL_INT8(1, lastRecord.slot);
+  TEST_ASSERT_EQUAL_INT32(200, lastRecord.targetDg);
+
+  requestFeed(c, FEED_SRC_MANUAL, -1, 20.0f, DISPENSE_FULL, ms);
+  pass();
+  TEST_ASSERT_TRUE(c.active);
+}
+
+// Nothing starts while the dispenser is held, or while a feed is in flight
+void test_queued_feed_waits_for_dispenser() {
+  held = true;
+  requestFeed(c, FEED_SRC_API, -1, 20.0f, DISPENSE_FULL, ms);
+  for (int i = 0; i < 10; i++) pass();
+  TEST_ASSERT_FALSE(c.active);
+  TEST_ASSERT_FALSE(feedDispenserFree(c));
+  held = false;
+  pass();
+  TEST_ASSERT_TRUE(c.active);
+
+  requestFeed(c, FEED_SRC_MANUAL, -1, 10.0f, DISPENSE_FULL, ms);
+  pass();
+  TEST_ASSERT_EQUAL_INT(1, started);
+  TEST_ASSERT_EQUAL_INT(1, c.queue.count);
+  runFeed();
+  pass();
+  TEST_ASSERT_EQUAL_INT(2, started);
+  TEST_ASSERT_EQUAL_INT(0, c.queue.count);
+}
+
+// A zero capture (as after a reset) and a feed that comes due during it:
+// the feed waits for the capture, which sees only the still bowl
+void test_calibration_capture_holds_feeds() {
+  ScaleCal sc = {0, 1.0f, 0};
+  startCalCapture(cal, CAL_ZERO, 0);
+  requestFeed(c, FEED_SRC_SCHEDULED, 0, 20.0f, DISPENSE_FULL, ms);
+  TEST_ASSERT_FALSE(feedDispenserFree(c));
+  while (cal.step != CAL_NONE) {
+    pass();
+    TEST_ASSERT_FALSE(c.active);
+    TEST_ASSERT_EQUAL_UINT8(0, sim.opening);
+    calCaptureSample(cal, sc, (int32_t)lroundf(sim.bowlG));
+  }
+  TEST_ASSERT_EQUAL(CAL_OK, cal.result);
+  TEST_ASSERT_EQUAL_INT32(0, sc.offset);
+
+  pass();
+  TEST_ASSERT_TRUE(c.active);
+  TEST_ASSERT_EQUAL(FEED_TARGET_REACHED, runFeed());
+}
+
+// Nothing arriving: the gate shuts and the hopper is taken to be empty
+void test_stuck_feed_marks_hopper_empty() {
+  initFlowSim(sim, NO_FOOD, 0.0f, 0);
+  hopperRefill(hopper, 0, T0);
+  requestFeed(c, FEED_SRC_API, -1, 20.0f, DISPENSE_FULL, ms);
+  TEST_ASSERT_EQUAL(FEED_STUCK, runFeed());
+  TEST_ASSERT_EQUAL_UINT8(0, sim.opening);
+  TEST_ASSERT_TRUE(hopperPredictEmpty(hopper));
+  TEST_ASSERT_EQUAL_INT(0, flow.feeds);
+}
+
+// A reset drops the feed in flight, its journal and the queue
+void test_reset_drops_everything() {
+  requestFeed(c, FEED_SRC_API, -1, 50.0f, DISPENSE_FULL, ms);
+  requestFeed(c, FEED_SRC_MANUAL, -1, 10.0f, DISPENSE_FULL, ms);
+  pass();
+  TEST_ASSERT_TRUE(c.active);
+  resetFeedControl(c, ms);
+  TEST_ASSERT_FALSE(c.active);
+  TEST_ASSERT_EQUAL_INT(0, c.queue.count);
+  TEST_ASSERT_EQUAL_UINT8(0, sim.opening);
+  TEST_ASSERT_FALSE(journalValid(journal));
+  TEST_ASSERT_EQUAL_INT(0, finished);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_feed_runs_to_target);
+  RUN_TEST(test_due_slot_is_fed);
+  RUN_TEST(test_empty_hopper_skips_scheduled_only);
+  RUN_TEST(test_queued_feed_waits_for_dispenser);
+  RUN_TEST(test_calibration_capture_holds_feeds);
+  RUN_TEST(test_stuck_feed_marks_hopper_empty);
+  RUN_TEST(test_reset_drops_everything);
+  return UNITY_END();
+}
@@ -0,0 +1,117 @@
+// Write-ahead journal of the feed in flight and boot reconciliation (feed_journal.h).
+#include <unity.h>
+#include <string.h>
+#include "feed_journal.h"
+
+static const uint32_t T0 = 1735718400;
+static const uint32_t MAX_AGE = 15 * 60;
+static FeedJournal j;
+
+void setUp() {
+  memset(&j, 0xA5, sizeof(j));  // uninitialised RTC memory
+}
+
+void tearDown() {}
+
+void test_garbage_is_not_a_journal() {
+  TEST_ASSERT_FALSE(journalValid(j));
+  JournalResume r = reconcileJournal(j, 50, T0, MAX_AGE, 2.0f);
+  TEST_ASSERT_EQUAL(JOURNAL_NONE, r.action);
+}
+
+void test_begin_checkpoint_clear() {
+  journalBegin(j, 7, T0, 1, false, 10, 40);
+  TEST_ASSERT_TRUE(journalValid(j));
+  TEST_ASSERT_EQUAL_INT8(1, j.slot);
+
+  journalCheckpoint(j, 5);
+  TEST_ASSERT_TRUE(journalValid(j));
+  TEST_ASSERT_EQUAL_UINT32(8, j.seq);
+
+  j.dispensed = 30;  // torn write: CRC no longer matches
+  TEST_ASSERT_FALSE(journalValid(j));
+
+  journalBegin(j, 9, T0, 1, false, 10, 40);
+  journalClear(j);
+  TEST_ASSERT_FALSE(journalValid(j));
+}
+
+void test_checkpoint_flashes_each_quarter_once() {
+  journalBegin(j, 1, T0, 0, false, 0, 40);
+  TEST_ASSERT_FALSE(journalCheckpoint(j, 5));
+  TEST_ASSERT_TRUE(journalCheckpoint(j, 10));
+  TEST_ASSERT_FALSE(journalCheckpoint(j, 12));
+  TEST_ASSERT_TRUE(journalCheckpoint(j, 31));   // straight to the third quarter
+  TEST_ASSERT_FALSE(journalCheckpoint(j, 29));  // pet ate: high-water mark kept
+  TEST_ASSERT_EQUAL_FLOAT(31, j.dispensed);
+  TEST_ASSERT_TRUE(journalCheckpoint(j, 45));
+  TEST_ASSERT_FALSE(journalCheckpoint(j, 50));
+}
+
+void test_newest_valid_copy_wins() {
+  FeedJournal rtc, flash;
+  journalBegin(flash, 10, T0, 0, false, 0, 40);
+  rtc = flash;
+  journalCheckpoint(rtc, 12);
+  TEST_ASSERT_EQUAL_PTR(&rtc, newestJournal(rtc, flash));
+  TEST_ASSERT_EQUAL_PTR(&rtc, newestJournal(flash, rtc));
+
+  memset(&rtc, 0, sizeof(rtc));  // power cut: RTC memory lost
+  TEST_ASSERT_EQUAL_PTR(&flash, newestJournal(rtc, flash));
+
+  journalClear(flash);
+  TEST_ASSERT_NULL(newestJournal(rtc, flash));
+}
+
+void test_resume_remaining_portion() {
+  journalBegin(j, 1, T0, 2, false, 10, 40);
+  journalCheckpoint(j, 15);
+  // Bowl agrees with the checkpoint
+  JournalResume r = reconcileJournal(j, 25, T0 + 30, MAX_AGE, 2.0f);
+  TEST_ASSERT_EQUAL(JOURNAL_RESUME, r.action);
+  TEST_ASSERT_EQUAL_FLOAT(15, r.dispensed);
+  TEST_ASSERT_EQUAL_FLOAT(25, r.remaining);
+
+  // More arrived after the last checkpoint (food still falling at the reset)
+  r = reconcileJournal(j, 30, T0 + 30, MAX_AGE, 2.0f);
+  TEST_ASSERT_EQUAL_FLOAT(20, r.dispensed);
+  TEST_ASSERT_EQUAL_FLOAT(20, r.remaining);
+
+  // Pet ate since: the checkpoint still counts, not the lower bowl
+  r = reconcileJournal(j, 12, T0 + 30, MAX_AGE, 2.0f);
+  TEST_ASSERT_EQUAL_FLOAT(15, r.dispensed);
+  TEST_ASSERT_EQUAL_FLOAT(25, r.remaining);
+}
+
+void test_already_delivered_is_complete() {
+  journalBegin(j, 1, T0, 0, true, 0, 40);
+  JournalResume r = reconcileJournal(j, 39, T0 + 5, MAX_AGE, 2.0f);
+  TEST_ASSERT_EQUAL(JOURNAL_COMPLETE, r.action);
+  // Even long after, a delivered portion is logged as done
+  r = reconcileJournal(j, 41, T0 + 3600, MAX_AGE, 2.0f);
+  TEST_ASSERT_EQUAL(JOURNAL_COMPLETE, r.action);
+}
+
+void test_stale_or_repeated_resets_abort() {
+  journalBegin(j, 1, T0, 0, false, 0, 40);
+  TEST_ASSERT_EQUAL(JOURNAL_ABORT, reconcileJournal(j, 0, T0 + MAX_AGE + 1, MAX_AGE, 2.0f).action);
+  TEST_ASSERT_EQUAL(JOURNAL_ABORT, reconcileJournal(j, 0, T0 - 60, MAX_AGE, 2.0f).action);
+
+  journalBegin(j, 2, T0, 0, false, 0, 40, FEED_JOURNAL_MAX_RESUMES);
+  TEST_ASSERT_EQUAL(JOURNAL_ABORT, reconcileJournal(j, 0, T0 + 10, MAX_AGE, 2.0f).action);
+
+  journalBegin(j, 3, T0, 0, false, 0, 40, FEED_JOURNAL_MAX_RESUMES - 1);
+  TEST_ASSERT_EQUAL(JOURNAL_RESUME, reconcileJournal(j, 0, T0 + 10, MAX_AGE, 2.0f).action);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_garbage_is_not_a_journal);
+  RUN_TEST(test_begin_checkpoint_clear);
+  RUN_TEST(test_checkpoint_flashes_each_quarter_once);
+  RUN_TEST(test_newest_valid_copy_wins);
+  RUN_TEST(test_resume_remaining_portion);
+  RUN_TEST(test_already_delivered_is_complete);
+  RUN_TEST(test_stale_or_repeated_resets_abort);
+  return UNITY_END();
+}
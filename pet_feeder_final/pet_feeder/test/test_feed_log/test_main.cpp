@@ -0,0 +1,67 @@
+// Newest-first ordering and capacity of the feed history (feed_log.h).
+#include <unity.h>
+#include "feed_log.h"
+
+static const int CAP = 4;
+static FeedLogEntry log_[CAP];
+static int count;
+
+static FeedLogEntry entry(int slot, float target) {
+  FeedLogEntry e = {};
+  e.manual = slot < 0;
+  e.slotIndex = slot;
+  e.hour = 8;
+  e.minute = slot < 0 ? 0 : slot;
+  e.target = target;
+  e.finalWeight = target;
+  return e;
+}
+
+void setUp() {
+  count = 0;
+  clearFeedLog(log_, CAP, count);
+}
+
+void tearDown() {}
+
+void test_newest_first() {
+  pushFeedLog(log_, CAP, count, entry(0, 10));
+  pushFeedLog(log_, CAP, count, entry(1, 20));
+  pushFeedLog(log_, CAP, count, entry(-1, 30));
+  TEST_ASSERT_EQUAL_INT(3, count);
+  TEST_ASSERT_TRUE(log_[0].manual);
+  TEST_ASSERT_EQUAL_FLOAT(30, log_[0].target);
+  TEST_ASSERT_EQUAL_INT(1, log_[1].slotIndex);
+  TEST_ASSERT_EQUAL_INT(0, log_[2].slotIndex);
+  TEST_ASSERT_FALSE(log_[3].used);
+}
+
+void test_marks_entries_used() {
+  pushFeedLog(log_, CAP, count, entry(2, 10));
+  TEST_ASSERT_TRUE(log_[0].used);
+}
+
+void test_full_log_drops_oldest() {
+  for (int i = 0; i < CAP + 2; i++) {
+    pushFeedLog(log_, CAP, count, entry(i, 10.0f * i));
+  }
+  TEST_ASSERT_EQUAL_INT(CAP, count);
+  TEST_ASSERT_EQUAL_INT(5, log_[0].slotIndex);
+  TEST_ASSERT_EQUAL_INT(2, log_[CAP - 1].slotIndex);
+}
+
+void test_clear_empties_log() {
+  pushFeedLog(log_, CAP, count, entry(0, 10));
+  clearFeedLog(log_, CAP, count);
+  TEST_ASSERT_EQUAL_INT(0, count);
+  for (int i = 0; i < CAP; i++) TEST_ASSERT_FALSE(log_[i].used);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_newest_first);
+  RUN_TEST(test_marks_entries_used);
+  RUN_TEST(test_full_log_drops_oldest);
+  RUN_TEST(test_clear_empties_log);
+  return UNITY_END();
+}
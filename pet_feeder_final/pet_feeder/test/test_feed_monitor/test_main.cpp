@@ -0,0 +1,103 @@
+// Target / stuck / timeout decisions of the feed monitor (feed_monitor.h).
+#include <unity.h>
+#include "feed_monitor.h"
+
+static const FeedLimits LIMITS = {15000, 4000, 2.0f};
+static FeedProgress p;
+
+void setUp() {
+  startFeedProgress(p, 20.0f, 50.0f, 1000);
+}
+
+void tearDown() {}
+
+void test_start_adds_on_top_of_bowl() {
+  TEST_ASSERT_EQUAL_FLOAT(70.0f, p.target);
+  TEST_ASSERT_EQUAL_FLOAT(20.0f, p.lastWeight);
+  TEST_ASSERT_EQUAL_UINT32(1000, p.startMs);
+  TEST_ASSERT_EQUAL_UINT32(1000, p.lastChangeMs);
+}
+
+// A zero that drifted below nothing still gets the portion asked for
+void test_start_keeps_negative_drift() {
+  startFeedProgress(p, -3.0f, 50.0f, 0);
+  TEST_ASSERT_EQUAL_FLOAT(47.0f, p.target);
+  TEST_ASSERT_EQUAL_FLOAT(-3.0f, p.lastWeight);
+}
+
+void test_target_reached_only_while_open() {
+  TEST_ASSERT_EQUAL_INT(FEED_CONTINUE,       checkFeedProgress(p, 70.0f, false, 1100, LIMITS));
+  TEST_ASSERT_EQUAL_INT(FEED_TARGET_REACHED, checkFeedProgress(p, 70.0f, true,  1100, LIMITS));
+  TEST_ASSERT_EQUAL_INT(FEED_TARGET_REACHED, checkFeedProgress(p, 90.0f, true,  1100, LIMITS));
+}
+
+void test_zero_target_never_counts_as_reached() {
+  startFeedProgress(p, 0.0f, 0.0f, 1000);
+  TEST_ASSERT_EQUAL_INT(FEED_CONTINUE, checkFeedProgress(p, 0.0f, true, 1100, LIMITS));
+}
+
+void test_stuck_after_window_without_increase() {
+  TEST_ASSERT_EQUAL_INT(FEED_CONTINUE, checkFeedProgress(p, 20.0f, true, 5000, LIMITS));
+  TEST_ASSERT_EQUAL_INT(FEED_STUCK,    checkFeedProgress(p, 20.0f, true, 5001, LIMITS));
+}
+
+void test_increase_below_noise_floor_does_not_reset_window() {
+  TEST_ASSERT_EQUAL_INT(FEED_CONTINUE, checkFeedProgress(p, 21.5f, true, 3000, LIMITS));
+  TEST_ASSERT_EQUAL_INT(FEED_STUCK,    checkFeedProgress(p, 22.0f, true, 5001, LIMITS));
+}
+
+void test_real_increase_resets_window() {
+  TEST_ASSERT_EQUAL_INT(FEED_CONTINUE, checkFeedProgress(p, 25.0f, true, 4500, LIMITS));
+  TEST_ASSERT_EQUAL_FLOAT(25.0f, p.lastWeight);
+  TEST_ASSERT_EQUAL_INT(FEED_CONTINUE, checkFeedProgress(p, 25.0f, true, 8500, LIMITS));
+  TEST_ASSERT_EQUAL_INT(FEED_STUCK,    checkFeedProgress(p, 25.0f, true, 8501, LIMITS));
+}
+
+void test_longest_gap_between_increases() {
+  checkFeedProgress(p, 25.0f, true, 2500, LIMITS);   // 1500 ms after start
+  checkFeedProgress(p, 26.0f, true, 3000, LIMITS);   // below noise floor
+  checkFeedProgress(p, 30.0f, true, 3200, LIMITS);   // 700 ms
+  TEST_ASSERT_EQUAL_UINT32(1500, p.maxGapMs);
+  TEST_ASSERT_EQUAL_INT(FEED_TARGET_REACHED, checkFeedProgress(p, 70.0f, true, 5200, LIMITS));
+  TEST_ASSERT_EQUAL_UINT32(2000, p.maxGapMs);  // the last stretch counts too
+}
+
+void test_no_stuck_detection_while_closed() {
+  TEST_ASSERT_EQUAL_INT(FEED_CONTINUE, checkFeedProgress(p, 20.0f, false, 9000, LIMITS));
+}
+
+void test_timeout_after_limit() {
+  // Keep the weight rising so stuck detection never trips
+  float w = 20.0f;
+  for (unsigned long t = 1000; t <= 16000; t += 500) {
+    w += 1.5f;
+    TEST_ASSERT_EQUAL_INT(FEED_CONTINUE, checkFeedProgress(p, w, true, t, LIMITS));
+  }
+  TEST_ASSERT_EQUAL_INT(FEED_TIMEOUT, checkFeedProgress(p, w + 3, true, 16001, LIMITS));
+}
+
+void test_timeout_applies_when_closed() {
+  TEST_ASSERT_EQUAL_INT(FEED_TIMEOUT, checkFeedProgress(p, 20.0f, false, 16001, LIMITS));
+}
+
+void test_millis_wraparound() {
+  startFeedProgress(p, 0.0f, 50.0f, 0xFFFFFF00UL);
+  TEST_ASSERT_EQUAL_INT(FEED_CONTINUE, checkFeedProgress(p, 10.0f, true, 0x00000100UL, LIMITS));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_start_adds_on_top_of_bowl);
+  RUN_TEST(test_start_keeps_negative_drift);
+  RUN_TEST(test_target_reached_only_while_open);
+  RUN_TEST(test_zero_target_never_counts_as_reached);
+  RUN_TEST(test_stuck_after_window_without_increase);
+  RUN_TEST(test_increase_below_noise_floor_does_not_reset_window);
+  RUN_TEST(test_real_increase_resets_window);
+  RUN_TEST(test_longest_gap_between_increases);
+  RUN_TEST(test_no_stuck_detection_while_closed);
+  RUN_TEST(test_timeout_after_limit);
+  RUN_TEST(test_timeout_applies_when_closed);
+  RUN_TEST(test_millis_wraparound);
+  return UNITY_END();
+}
@@ -0,0 +1,139 @@
+// Priority, coalescing and expiry of the feed command queue (feed_queue.h).
+#include <unity.h>
+#include "feed_queue.h"
+
+static const int CAP = 4;
+static const uint32_t WAIT = 60000;
+static FeedCommand storage[CAP];
+static FeedQueue q;
+
+static FeedCommand cmd(uint8_t source, int slot, float amount, uint32_t atMs) {
+  FeedCommand c = {};
+  c.source = source;
+  c.slotIndex = slot;
+  c.amount = amount;
+  c.enqueuedMs = atMs;
+  c.maxWaitMs = WAIT;
+  return c;
+}
+
+void setUp() {
+  initFeedQueue(q, storage, CAP);
+}
+
+void tearDown() {}
+
+void test_priority_then_arrival_order() {
+  enqueueFeed(q, cmd(FEED_SRC_API, -1, 10, 0));
+  enqueueFeed(q, cmd(FEED_SRC_SCHEDULED, 0, 20, 1));
+  enqueueFeed(q, cmd(FEED_SRC_API, -1, 30, 2));
+  enqueueFeed(q, cmd(FEED_SRC_MANUAL, -1, 40, 3));
+
+  FeedCommand out;
+  float order[] = {40, 20, 10, 30};
+  for (float amount : order) {
+    TEST_ASSERT_TRUE(popFeed(q, 100, out));
+    TEST_ASSERT_EQUAL_FLOAT(amount, out.amount);
+  }
+  TEST_ASSERT_FALSE(popFeed(q, 100, out));
+}
+
+void test_scheduled_feeds_of_a_slot_merge() {
+  TEST_ASSERT_EQUAL_INT(FEED_QUEUED, enqueueFeed(q, cmd(FEED_SRC_SCHEDULED, 0, 20, 0)));
+  TEST_ASSERT_EQUAL_INT(FEED_MERGED, enqueueFeed(q, cmd(FEED_SRC_SCHEDULED, 0, 30, 500)));
+  TEST_ASSERT_EQUAL_INT(1, q.count);
+  TEST_ASSERT_EQUAL_UINT32(1, q.coalesced);
+
+  FeedCommand out;
+  TEST_ASSERT_TRUE(popFeed(q, 1000, out));
+  TEST_ASSERT_EQUAL_FLOAT(50, out.amount);
+  TEST_ASSERT_EQUAL_INT(0, out.slotIndex);
+  TEST_ASSERT_EQUAL_UINT8(1, out.merged);
+  TEST_ASSERT_EQUAL_UINT32(1000, q.lastWaitMs);  // earlier wait kept
+}
+
+// Each slot keeps its own portion and profile, for its log and rollup row
+void test_scheduled_feeds_of_other_slots_stay_apart() {
+  FeedCommand pulse = cmd(FEED_SRC_SCHEDULED, 1, 30, 500);
+  pulse.mode = 2;
+  TEST_ASSERT_EQUAL_INT(FEED_QUEUED, enqueueFeed(q, cmd(FEED_SRC_SCHEDULED, 0, 20, 0)));
+  TEST_ASSERT_EQUAL_INT(FEED_QUEUED, enqueueFeed(q, pulse));
+  TEST_ASSERT_EQUAL_INT(2, q.count);
+  TEST_ASSERT_EQUAL_UINT32(0, q.coalesced);
+
+  FeedCommand out;
+  TEST_ASSERT_TRUE(popFeed(q, 1000, out));
+  TEST_ASSERT_EQUAL_INT(0, out.slotIndex);
+  TEST_ASSERT_EQUAL_FLOAT(20, out.amount);
+  TEST_ASSERT_TRUE(popFeed(q, 1000, out));
+  TEST_ASSERT_EQUAL_INT(1, out.slotIndex);
+  TEST_ASSERT_EQUAL_FLOAT(30, out.amount);
+  TEST_ASSERT_EQUAL_UINT8(2, out.mode);
+  TEST_ASSERT_EQUAL_UINT8(0, out.merged);
+}
+
+void test_duplicate_request_dropped_only_within_window() {
+  TEST_ASSERT_EQUAL_INT(FEED_QUEUED, enqueueFeed(q, cmd(FEED_SRC_API, -1, 50, 0)));
+  TEST_ASSERT_EQUAL_INT(FEED_DUPLICATE, enqueueFeed(q, cmd(FEED_SRC_API, -1, 50, 100)));
+  TEST_ASSERT_EQUAL_INT(FEED_QUEUED, enqueueFeed(q, cmd(FEED_SRC_API, -1, 60, 200)));
+  TEST_ASSERT_EQUAL_INT(FEED_QUEUED, enqueueFeed(q, cmd(FEED_SRC_API, -1, 50, FEED_DUPLICATE_MS)));
+  TEST_ASSERT_EQUAL_INT(FEED_QUEUED, enqueueFeed(q, cmd(FEED_SRC_MANUAL, -1, 50, 100)));
+  TEST_ASSERT_EQUAL_INT(4, q.count);
+}
+
+void test_same_amount_other_profile_not_duplicate() {
+  TEST_ASSERT_EQUAL_INT(FEED_QUEUED, enqueueFeed(q, cmd(FEED_SRC_API, -1, 50, 0)));
+  FeedCommand pulse = cmd(FEED_SRC_API, -1, 50, 100);
+  pulse.mode = 2;
+  TEST_ASSERT_EQUAL_INT(FEED_QUEUED, enqueueFeed(q, pulse));
+  TEST_ASSERT_EQUAL_INT(FEED_DUPLICATE, enqueueFeed(q, pulse));
+}
+
+void test_expired_commands_skipped() {
+  enqueueFeed(q, cmd(FEED_SRC_MANUAL, -1, 10, 0));
+  enqueueFeed(q, cmd(FEED_SRC_API, -1, 20, 30000));
+
+  FeedCommand out;
+  TEST_ASSERT_TRUE(popFeed(q, WAIT + 1, out));
+  TEST_ASSERT_EQUAL_FLOAT(20, out.amount);
+  TEST_ASSERT_EQUAL_UINT32(1, q.expired);
+  TEST_ASSERT_EQUAL_UINT32(WAIT + 1 - 30000, q.lastWaitMs);
+}
+
+void test_full_queue_evicts_lower_priority() {
+  for (int i = 0; i < CAP; i++) {
+    enqueueFeed(q, cmd(FEED_SRC_API, -1, 10.0f + i, i * FEED_DUPLICATE_MS));
+  }
+  TEST_ASSERT_EQUAL_INT(FEED_QUEUE_FULL, enqueueFeed(q, cmd(FEED_SRC_API, -1, 99, 10000)));
+  TEST_ASSERT_EQUAL_INT(FEED_QUEUED, enqueueFeed(q, cmd(FEED_SRC_SCHEDULED, 0, 5, 10000)));
+  TEST_ASSERT_EQUAL_INT(CAP, q.count);
+  TEST_ASSERT_EQUAL_UINT32(2, q.dropped);
+
+  // the newest API request made room
+  for (int i = 0; i < q.count; i++) TEST_ASSERT_NOT_EQUAL(13, (int)q.items[i].amount);
+  TEST_ASSERT_EQUAL_INT(FEED_SRC_SCHEDULED, q.items[nextFeedIndex(q)].source);
+}
+
+void test_wait_times_across_millis_wrap() {
+  uint32_t t0 = 0xFFFFFF00;
+  enqueueFeed(q, cmd(FEED_SRC_API, -1, 10, t0));
+  TEST_ASSERT_EQUAL_UINT32(0x200, oldestFeedWaitMs(q, t0 + 0x200));
+
+  FeedCommand out;
+  TEST_ASSERT_TRUE(popFeed(q, t0 + 0x200, out));
+  TEST_ASSERT_EQUAL_UINT32(0x200, q.maxWaitMs);
+  TEST_ASSERT_EQUAL_UINT32(0, oldestFeedWaitMs(q, t0 + 0x300));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_priority_then_arrival_order);
+  RUN_TEST(test_scheduled_feeds_of_a_slot_merge);
+  RUN_TEST(test_scheduled_feeds_of_other_slots_stay_apart);
+  RUN_TEST(test_duplicate_request_dropped_only_within_window);
+  RUN_TEST(test_same_amount_other_profile_not_duplicate);
+  RUN_TEST(test_expired_commands_skipped);
+  RUN_TEST(test_full_queue_evicts_lower_priority);
+  RUN_TEST(test_wait_times_across_millis_wrap);
+  return UNITY_END();
+}
@@ -0,0 +1,258 @@
+// Feed recorder and offline replay (feed_rec.h), on feeds recorded from the
+// flow simulator so every replay can be checked against what the simulated
+// hopper really does with the replayed settings.
+#include <unity.h>
+#include <math.h>
+#include <stdio.h>
+#include "feed_rec.h"
+#include "flow_sim.h"
+
+static const FeedLimits LIMITS = {15000, 4000, 2.0f};
+static const uint32_t READ_MS = 100;
+static const float    SCALE   = -420.0f;  // counts per gram, sign as wired
+static const int32_t  OFFSET  = 8000;
+static const float    BOWL    = 5.0f;     // already in the bowl
+
+static const FlowSimParams FREE_FLOW = {15.0f, 15, 300, 0.0f, 0};
+static const FlowSimParams BRIDGING  = {15.0f, 15, 300, 25.0f, 2};
+
+static FeedRecSample storage[2048];
+static FeedRecorder rec;
+
+void setUp() {
+  initFeedRecorder(rec, storage, 2048);
+}
+
+void tearDown() {}
+
+struct SimFeed {
+  FeedCheck outcome;
+  uint32_t  closeMs;
+  float     finalG;   // settled
+};
+
+// The firmware loop on the simulator: read, step the profile, check, then
+// sample for the recorder (when given) with the gate command of this pass.
+static SimFeed simFeed(const DispenseProfile& pr, uint8_t mode, float amount,
+                       const FlowSimParams& params, FeedRecorder* r) {
+  FlowSim sim;
+  initFlowSim(sim, params, BOWL, 0);
+  FeedProgress p;
+  startFeedProgress(p, BOWL, amount, 0);
+  FeedLimits limits = LIMITS;
+  limits.timeoutMs = dispenseProfileTimeoutMs(pr, LIMITS.timeoutMs);
+  Dispenser d = {};
+  startDispenseProfile(d, pr, mode, 0);
+  flowSimGate(sim, d.opening, 0);
+
+  if (r) {
+    FeedRecHeader h = {};
+    h.seq = 1;
+    h.target = p.target;
+    h.startWeight = BOWL;
+    h.scale = SCALE;
+    h.offset = OFFSET;
+    h.timeoutMs = limits.timeoutMs;
+    h.stuckWindowMs = limits.stuckWindowMs;
+    h.minIncreaseG = limits.minIncreaseG;
+    h.mode = mode;
+    recBegin(*r, h, 0);
+  }
+
+  SimFeed out = {};
+  bool feeding = true;
+  for (uint32_t t = 0;; t += READ_MS) {
+    flowSimAdvance(sim, t);
+    // A little reading noise, +-0.05 g
+    float w = sim.bowlG + ((int)((t / READ_MS * 7919) % 11) - 5) * 0.01f;
+    if (feeding) {
+      uint8_t opening = stepDispense(d, p, w, limits.stuckWindowMs, t);
+      if (opening != sim.opening) flowSimGate(sim, opening, t);
+      FeedCheck c = checkFeedProgress(p, w, dispenseRunning(d), t, limits);
+      if (c != FEED_CONTINUE) {
+        flowSimGate(sim, 0, t);
+        feeding = false;
+        out.outcome = c;
+        out.closeMs = t;
+        if (r) recClose(*r, c, t);
+      }
+    }
+    if (r) recSample(*r, t, (int32_t)lroundf(w * SCALE) + OFFSET, sim.opening);
+    if (!feeding && t >= out.closeMs + REC_SETTLE_MS) {
+      out.finalG = sim.bowlG;
+      return out;
+    }
+  }
+}
+
+static SimFeed simFeed(uint8_t mode, float amount, const FlowSimParams& params, FeedRecorder* r) {
+  return simFeed(kDispenseProfiles[mode], mode, amount, params, r);
+}
+
+static ReplayParams paramsFor(const DispenseProfile& pr, uint8_t mode) {
+  ReplayParams p = recRecordedParams(rec.header, recEstimateFallMs(rec.header, storage, rec.header.samples, FREE_FLOW.minOpenPct),
+                                     FREE_FLOW.minOpenPct);
+  p.profile = pr;
+  p.mode = mode;
+  p.limits.timeoutMs = dispenseProfileTimeoutMs(pr, LIMITS.timeoutMs);
+  return p;
+}
+
+void test_recording_covers_feed_and_settling() {
+  SimFeed f = simFeed(DISPENSE_TRICKLE, 30.0f, FREE_FLOW, &rec);
+  TEST_ASSERT_EQUAL_UINT8(REC_DONE, rec.state);
+  TEST_ASSERT_EQUAL_UINT32(REC_MAGIC, rec.header.magic);
+  TEST_ASSERT_EQUAL_UINT8(FEED_TARGET_REACHED, rec.header.outcome);
+  TEST_ASSERT_EQUAL_UINT32(f.closeMs, rec.header.closeMs);
+  TEST_ASSERT_EQUAL_UINT8(0, rec.header.flags);
+
+  uint32_t n = rec.header.samples;
+  TEST_ASSERT_EQUAL_UINT32(f.closeMs / READ_MS + REC_SETTLE_MS / READ_MS + 1, n);
+  TEST_ASSERT_EQUAL_UINT32(f.closeMs + REC_SETTLE_MS, storage[n - 1].ms);
+  TEST_ASSERT_EQUAL_UINT8(100, storage[0].opening);
+  TEST_ASSERT_EQUAL_UINT8(0, storage[n - 1].opening);
+  TEST_ASSERT_FLOAT_WITHIN(0.06f, f.finalG, fabsf(recWeight(rec.header, storage[n - 1].raw)));
+  TEST_ASSERT_EQUAL_UINT32(sizeof(FeedRecHeader) + n * sizeof(FeedRecSample), recSeal(rec));
+}
+
+void test_samples_throttled_unless_gate_moves() {
+  FeedRecHeader h = {};
+  recBegin(rec, h, 1000);
+  recSample(rec, 1000, 1, 100);
+  recSample(rec, 1000 + REC_MIN_INTERVAL_MS - 1, 2, 100);  // too soon
+  recSample(rec, 1000 + REC_MIN_INTERVAL_MS - 1, 3, 35);   // gate moved
+  recSample(rec, 1000 + 2 * REC_MIN_INTERVAL_MS, 4, 35);
+  TEST_ASSERT_EQUAL_UINT32(3, rec.header.samples);
+  TEST_ASSERT_EQUAL_INT32(3, storage[1].raw);
+  TEST_ASSERT_EQUAL_UINT32(2 * REC_MIN_INTERVAL_MS, storage[2].ms);
+}
+
+void test_full_storage_keeps_room_to_settle() {
+  initFeedRecorder(rec, storage, 40);
+  SimFeed f = simFeed(DISPENSE_FULL, 60.0f, FREE_FLOW, &rec);
+  TEST_ASSERT_EQUAL_UINT8(REC_DONE, rec.state);
+  TEST_ASSERT_TRUE(rec.header.flags & REC_TRUNCATED);
+  TEST_ASSERT_EQUAL_UINT32(40, rec.header.samples);
+  // The settled weight made it in
+  TEST_ASSERT_EQUAL_UINT32(f.closeMs + REC_SETTLE_MS, storage[39].ms);
+}
+
+void test_seal_states() {
+  FeedRecHeader h = {};
+  TEST_ASSERT_EQUAL_UINT32(0, recSeal(rec));  // idle
+  recBegin(rec, h, 0);
+  recSample(rec, 0, 1, 100);
+  TEST_ASSERT_EQUAL_UINT32(0, recSeal(rec));  // still feeding
+  recClose(rec, FEED_STUCK, 500);
+  recSample(rec, 600, 2, 0);
+  // Next feed before settling finished
+  TEST_ASSERT_EQUAL_UINT32(sizeof(FeedRecHeader) + 2 * sizeof(FeedRecSample), recSeal(rec));
+  TEST_ASSERT_TRUE(rec.header.flags & REC_UNSETTLED);
+  recClear(rec);
+  TEST_ASSERT_EQUAL_UINT8(REC_IDLE, rec.state);
+}
+
+void test_fall_delay_estimate() {
+  simFeed(DISPENSE_FULL, 30.0f, FREE_FLOW, &rec);
+  uint32_t fall = recEstimateFallMs(rec.header, storage, rec.header.samples, FREE_FLOW.minOpenPct);
+  TEST_ASSERT_UINT32_WITHIN(READ_MS / 4, FREE_FLOW.fallMs, fall);
+}
+
+void test_replay_reproduces_recording() {
+  const uint8_t modes[] = {DISPENSE_FULL, DISPENSE_TRICKLE, DISPENSE_PULSE};
+  for (uint8_t m : modes) {
+    setUp();
+    simFeed(m, 30.0f, FREE_FLOW, &rec);
+    uint32_t n = rec.header.samples;
+    ReplayResult recorded, replayed;
+    recRecordedResult(rec.header, storage, n, recorded);
+    recReplay(rec.header, storage, n,
+              recRecordedParams(rec.header, recEstimateFallMs(rec.header, storage, n, FREE_FLOW.minOpenPct),
+                                FREE_FLOW.minOpenPct),
+              replayed);
+    TEST_ASSERT_EQUAL_UINT8(recorded.outcome, replayed.outcome);
+    TEST_ASSERT_UINT32_WITHIN(200, recorded.closeMs, replayed.closeMs);
+    TEST_ASSERT_FLOAT_WITHIN(0.6f, recorded.errorG, replayed.errorG);
+    TEST_ASSERT_FALSE(replayed.extrapolated);
+  }
+}
+
+// Record with one profile, replay another, compare with the simulator
+// actually running that profile. (A portion the free flow crosses between
+// readings: exactly on one, rounding decides which reading sees it.)
+static const float PORTION = 32.0f;
+
+void test_replay_predicts_other_profiles() {
+  const uint8_t modes[] = {DISPENSE_FULL, DISPENSE_TRICKLE, DISPENSE_PULSE};
+  printf("\n  recorded  replayed  portion  predicted         simulated\n");
+  for (uint8_t from : modes) {
+    for (uint8_t to : modes) {
+      if (from == to) continue;
+      setUp();
+      simFeed(from, PORTION, FREE_FLOW, &rec);
+      SimFeed truth = simFeed(to, PORTION, FREE_FLOW, nullptr);
+      ReplayResult r;
+      recReplay(rec.header, storage, rec.header.samples, paramsFor(kDispenseProfiles[to], to), r);
+      float truthError = truth.finalG - (BOWL + PORTION);
+      printf("  %-8s  %-8s  %5.0f g  %5.1f s %+5.1f g   %5.1f s %+5.1f g\n",
+             dispenseModeName(from), dispenseModeName(to), PORTION, r.closeMs / 1000.0f, r.errorG,
+             truth.closeMs / 1000.0f, truthError);
+      TEST_ASSERT_EQUAL_UINT8(truth.outcome, r.outcome);
+      TEST_ASSERT_UINT32_WITHIN(600, truth.closeMs, r.closeMs);
+      TEST_ASSERT_FLOAT_WITHIN(1.0f, truthError, r.errorG);
+    }
+  }
+}
+
+void test_replay_tuning_against_bridging_feed() {
+  simFeed(DISPENSE_TRICKLE, 60.0f, BRIDGING, &rec);
+  TEST_ASSERT_EQUAL_UINT8(FEED_TARGET_REACHED, rec.header.outcome);
+
+  // Without agitation and with a shorter stuck window the recorded bridge
+  // ends the feed, as it does on the hopper
+  DispenseProfile still = kDispenseProfiles[DISPENSE_TRICKLE];
+  still.agitateMoves = 0;
+  ReplayParams params = paramsFor(still, DISPENSE_TRICKLE);
+  params.limits.stuckWindowMs = 1500;
+  ReplayResult r;
+  recReplay(rec.header, storage, rec.header.samples, params, r);
+  TEST_ASSERT_EQUAL_UINT8(FEED_STUCK, r.outcome);
+  TEST_ASSERT_EQUAL_UINT8(0, r.agitations);
+  // Stopped at the bridge, about 25 g in
+  TEST_ASSERT_FLOAT_WITHIN(2.0f, BOWL + BRIDGING.bridgeEveryG, r.finalG);
+}
+
+void test_replay_extrapolates_past_recording() {
+  simFeed(DISPENSE_FULL, 30.0f, FREE_FLOW, &rec);
+  FeedRecHeader bigger = rec.header;
+  bigger.target += 10.0f;
+  ReplayResult r;
+  recReplay(bigger, storage, bigger.samples,
+            recRecordedParams(bigger, recEstimateFallMs(bigger, storage, bigger.samples, FREE_FLOW.minOpenPct),
+                              FREE_FLOW.minOpenPct),
+            r);
+  TEST_ASSERT_TRUE(r.extrapolated);
+  TEST_ASSERT_EQUAL_UINT8(FEED_TARGET_REACHED, r.outcome);
+  TEST_ASSERT_TRUE(r.finalG >= bigger.target);
+
+  // A stuck feed gives nothing more
+  FeedRecHeader stuck = rec.header;
+  stuck.outcome = FEED_STUCK;
+  stuck.target += 10.0f;
+  recReplay(stuck, storage, stuck.samples, recRecordedParams(stuck, 300, FREE_FLOW.minOpenPct), r);
+  TEST_ASSERT_EQUAL_UINT8(FEED_STUCK, r.outcome);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_recording_covers_feed_and_settling);
+  RUN_TEST(test_samples_throttled_unless_gate_moves);
+  RUN_TEST(test_full_storage_keeps_room_to_settle);
+  RUN_TEST(test_seal_states);
+  RUN_TEST(test_fall_delay_estimate);
+  RUN_TEST(test_replay_reproduces_recording);
+  RUN_TEST(test_replay_predicts_other_profiles);
+  RUN_TEST(test_replay_tuning_against_bridging_feed);
+  RUN_TEST(test_replay_extrapolates_past_recording);
+  return UNITY_END();
+}
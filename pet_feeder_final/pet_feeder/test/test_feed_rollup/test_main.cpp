@@ -0,0 +1,136 @@
+// Feed rollups: day/week rings and per-slot overshoot (lib/feeder_core/feed_rollup.h).
+#include <unity.h>
+#include <math.h>
+#include "feed_rollup.h"
+
+static FeedRollups r;
+
+// Monday 2025-01-06
+static const uint32_t MONDAY = 1736121600;
+
+void setUp() {
+  initFeedRollups(r);
+}
+
+void tearDown() {}
+
+static uint32_t at(int day, int hour) {
+  return MONDAY + day * SECS_PER_DAY + hour * SECS_PER_HOUR;
+}
+
+void test_empty_tables_have_no_rows() {
+  TEST_ASSERT_NULL(rollupDayAt(r, MONDAY));
+  TEST_ASSERT_NULL(rollupWeekAt(r, MONDAY));
+  TEST_ASSERT_EQUAL_UINT32(0, slotWeekOvershoot(r.slots[0], MONDAY).n);
+}
+
+void test_day_totals_and_aborts() {
+  rollupFeed(r, at(0, 8), 0, true, 40.0f, 1.0f);
+  rollupFeed(r, at(0, 18), 1, false, 12.0f, -28.0f);
+  rollupFeed(r, at(0, 20), -1, true, 25.0f, 0.5f);
+
+  const PeriodRollup* today = rollupDayAt(r, at(0, 23));
+  TEST_ASSERT_NOT_NULL(today);
+  TEST_ASSERT_EQUAL_UINT16(3, today->feeds);
+  TEST_ASSERT_EQUAL_UINT16(1, today->aborts);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 77.0f, today->dispensedG);
+  TEST_ASSERT_NULL(rollupDayAt(r, at(1, 0)));
+
+  TEST_ASSERT_EQUAL_UINT16(1, r.slots[1].aborts);
+  TEST_ASSERT_EQUAL_UINT32(0, r.slots[1].allTime.n);  // short feeds have no overshoot
+  TEST_ASSERT_EQUAL_UINT16(1, r.slots[FEED_ROLLUP_MANUAL].feeds);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.5f, r.slots[FEED_ROLLUP_MANUAL].allTime.mean);
+}
+
+void test_weeks_start_on_monday() {
+  rollupFeed(r, at(-1, 12), 0, true, 10.0f, 0.0f);  // Sunday
+  rollupFeed(r, at(0, 0), 0, true, 20.0f, 0.0f);    // Monday, midnight
+  rollupFeed(r, at(6, 23), 0, true, 30.0f, 0.0f);   // Sunday again
+
+  const PeriodRollup* last = rollupWeekAt(r, at(-1, 0));
+  const PeriodRollup* week = rollupWeekAt(r, at(3, 0));
+  TEST_ASSERT_NOT_NULL(last);
+  TEST_ASSERT_NOT_NULL(week);
+  TEST_ASSERT_EQUAL_UINT16(1, last->feeds);
+  TEST_ASSERT_EQUAL_UINT16(2, week->feeds);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 50.0f, week->dispensedG);
+  TEST_ASSERT_EQUAL_UINT32(MONDAY, rollupWeekStart(rollupWeek(at(6, 23))));
+}
+
+// A ring row goes to the newest period that maps to it
+void test_rings_reuse_rows_of_old_periods() {
+  rollupFeed(r, at(0, 8), 0, true, 10.0f, 0.0f);
+  rollupFeed(r, at(FEED_ROLLUP_DAYS, 8), 0, true, 15.0f, 0.0f);
+  TEST_ASSERT_NULL(rollupDayAt(r, at(0, 8)));
+  const PeriodRollup* d = rollupDayAt(r, at(FEED_ROLLUP_DAYS, 9));
+  TEST_ASSERT_NOT_NULL(d);
+  TEST_ASSERT_EQUAL_UINT16(1, d->feeds);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 15.0f, d->dispensedG);
+
+  rollupFeed(r, at(7 * FEED_ROLLUP_WEEKS, 8), 0, true, 5.0f, 0.0f);
+  TEST_ASSERT_NULL(rollupWeekAt(r, at(0, 8)));
+  TEST_ASSERT_EQUAL_UINT16(1, rollupWeekAt(r, at(7 * FEED_ROLLUP_WEEKS, 8))->feeds);
+  TEST_ASSERT_EQUAL_UINT16(3, r.slots[0].feeds);  // slot totals never roll over
+}
+
+// Running mean and variance agree with the two-pass ones
+void test_overshoot_mean_and_variance() {
+  const float x[] = {1.5f, -0.5f, 2.0f, 0.0f, 3.5f, 1.0f};
+  const int n = sizeof(x) / sizeof(x[0]);
+  float sum = 0;
+  for (int i = 0; i < n; i++) {
+    rollupFeed(r, at(i % 3, 8), 2, true, 30.0f, x[i]);
+    sum += x[i];
+  }
+  float mean = sum / n, ss = 0;
+  for (int i = 0; i < n; i++) ss += (x[i] - mean) * (x[i] - mean);
+
+  const RunningStat& s = r.slots[2].allTime;
+  TEST_ASSERT_EQUAL_UINT32(n, s.n);
+  TEST_ASSERT_FLOAT_WITHIN(1e-4f, mean, s.mean);
+  TEST_ASSERT_FLOAT_WITHIN(1e-4f, ss / (n - 1), runningVariance(s));
+
+  RunningStat one = {};
+  runningAdd(one, 4.0f);
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, runningVariance(one));
+}
+
+void test_week_overshoot_starts_over_each_week() {
+  rollupFeed(r, at(0, 8), 0, true, 30.0f, 2.0f);
+  rollupFeed(r, at(2, 8), 0, true, 30.0f, 4.0f);
+  TEST_ASSERT_EQUAL_UINT32(2, slotWeekOvershoot(r.slots[0], at(6, 0)).n);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 3.0f, slotWeekOvershoot(r.slots[0], at(6, 0)).mean);
+
+  // Read in the next week before any feed there: nothing yet
+  TEST_ASSERT_EQUAL_UINT32(0, slotWeekOvershoot(r.slots[0], at(7, 0)).n);
+
+  rollupFeed(r, at(8, 8), 0, true, 30.0f, -1.0f);
+  RunningStat week = slotWeekOvershoot(r.slots[0], at(8, 9));
+  TEST_ASSERT_EQUAL_UINT32(1, week.n);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, -1.0f, week.mean);
+  TEST_ASSERT_EQUAL_UINT32(3, r.slots[0].allTime.n);
+}
+
+void test_slots_past_the_table_count_in_totals_only() {
+  rollupFeed(r, at(0, 8), FEED_ROLLUP_SLOTS, true, 30.0f, 1.0f);
+  TEST_ASSERT_EQUAL_UINT16(1, rollupDayAt(r, at(0, 8))->feeds);
+  TEST_ASSERT_EQUAL_UINT16(0, r.slots[FEED_ROLLUP_MANUAL].feeds);
+}
+
+void test_negative_dispensed_counts_as_zero() {
+  rollupFeed(r, at(0, 8), 0, false, -3.0f, -20.0f);
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, rollupDayAt(r, at(0, 8))->dispensedG);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_empty_tables_have_no_rows);
+  RUN_TEST(test_day_totals_and_aborts);
+  RUN_TEST(test_weeks_start_on_monday);
+  RUN_TEST(test_rings_reuse_rows_of_old_periods);
+  RUN_TEST(test_overshoot_mean_and_variance);
+  RUN_TEST(test_week_overshoot_starts_over_each_week);
+  RUN_TEST(test_slots_past_the_table_count_in_totals_only);
+  RUN_TEST(test_negative_dispensed_counts_as_zero);
+  return UNITY_END();
+}
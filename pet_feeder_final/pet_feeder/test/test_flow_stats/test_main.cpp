@@ -0,0 +1,166 @@
+// Flow statistics and the feed limits derived from them (flow_stats.h).
+#include <unity.h>
+#include "flow_stats.h"
+
+static const FeedLimits BASE = {15000, 4000, 2.0f};
+static FlowStats s;
+
+void setUp() {
+  initFlowStats(s);
+}
+
+void tearDown() {}
+
+// Runs a feed through the monitor: `rate` g/s in `stepMs` samples until the
+// target, a jam or the timeout. Returns the outcome and the grams dispensed.
+static FeedCheck runFeed(const FeedLimits& l, float amount, float rate, uint32_t stepMs,
+                         uint32_t jamAfterMs, float& dispensed, uint32_t& endMs) {
+  FeedProgress p;
+  startFeedProgress(p, 10.0f, amount, 0);
+  float w = 10.0f;
+  for (uint32_t t = stepMs;; t += stepMs) {
+    if (t <= jamAfterMs) w += rate * stepMs / 1000.0f;
+    FeedCheck c = checkFeedProgress(p, w, true, t, l);
+    if (c != FEED_CONTINUE) {
+      dispensed = w - 10.0f;
+      endMs = t;
+      if (c != FEED_STUCK) learnFlow(s, p, c, dispensed, t);
+      return c;
+    }
+  }
+}
+
+static void learnFeeds(int n, float amount, float rate) {
+  float dispensed;
+  uint32_t end;
+  for (int i = 0; i < n; i++) {
+    runFeed(deriveFeedLimits(s, BASE, amount), amount, rate, 100, UINT32_MAX, dispensed, end);
+  }
+}
+
+void test_fixed_limits_until_enough_feeds() {
+  learnFeeds(FLOW_MIN_FEEDS - 1, 30.0f, 5.0f);
+  FeedLimits l = deriveFeedLimits(s, BASE, 30.0f);
+  TEST_ASSERT_EQUAL_UINT32(BASE.timeoutMs, l.timeoutMs);
+  TEST_ASSERT_EQUAL_UINT32(BASE.stuckWindowMs, l.stuckWindowMs);
+  TEST_ASSERT_EQUAL_FLOAT(BASE.minIncreaseG, l.minIncreaseG);
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, flowP10Rate(s));
+}
+
+void test_rate_mean_and_variance() {
+  FeedProgress p;
+  float rates[] = {4.0f, 6.0f, 5.0f};
+  for (float r : rates) {
+    startFeedProgress(p, 0.0f, 10.0f * r, 0);
+    p.maxGapMs = 500;
+    TEST_ASSERT_TRUE(learnFlow(s, p, FEED_TARGET_REACHED, 10.0f * r, 10000));
+  }
+  TEST_ASSERT_EQUAL_UINT16(3, s.feeds);
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, 5.0f, s.rateMean);
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, 2.0f / 3.0f, s.rateVar);  // population variance
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 5.0f - 1.2816f * 0.8165f, flowP10Rate(s));
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, 500.0f, s.gapMeanMs);
+}
+
+void test_jams_and_empty_timeouts_are_not_learned() {
+  FeedProgress p;
+  startFeedProgress(p, 0.0f, 50.0f, 0);
+  TEST_ASSERT_FALSE(learnFlow(s, p, FEED_STUCK, 3.0f, 5000));
+  TEST_ASSERT_FALSE(learnFlow(s, p, FEED_TIMEOUT, 0.5f, 15000));  // nothing ever counted
+  TEST_ASSERT_FALSE(learnFlow(s, p, FEED_TARGET_REACHED, 50.0f, 0));
+  TEST_ASSERT_EQUAL_UINT16(0, s.feeds);
+
+  p.maxGapMs = 400;  // flowing, just a big portion
+  TEST_ASSERT_TRUE(learnFlow(s, p, FEED_TIMEOUT, 40.0f, 15000));
+}
+
+void test_large_portion_completes_instead_of_timing_out() {
+  // 5 g/s: 100 g takes 20 s, past the fixed 15 s timeout
+  float dispensed;
+  uint32_t end;
+  TEST_ASSERT_EQUAL_INT(FEED_TIMEOUT,
+                        runFeed(BASE, 100.0f, 5.0f, 100, UINT32_MAX, dispensed, end));
+
+  initFlowStats(s);
+  learnFeeds(5, 30.0f, 5.0f);
+  FeedLimits l = deriveFeedLimits(s, BASE, 100.0f);
+  TEST_ASSERT_GREATER_THAN_UINT32(20000, l.timeoutMs);
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32(BASE.timeoutMs * FLOW_TIMEOUT_MAX_FACTOR, l.timeoutMs);
+  TEST_ASSERT_EQUAL_INT(FEED_TARGET_REACHED,
+                        runFeed(l, 100.0f, 5.0f, 100, UINT32_MAX, dispensed, end));
+}
+
+void test_small_portion_gets_shorter_timeout() {
+  learnFeeds(5, 30.0f, 5.0f);
+  FeedLimits l = deriveFeedLimits(s, BASE, 10.0f);
+  TEST_ASSERT_LESS_THAN_UINT32(BASE.timeoutMs, l.timeoutMs);
+  TEST_ASSERT_GREATER_OR_EQUAL_UINT32(FLOW_TIMEOUT_MIN_MS, l.timeoutMs);
+}
+
+void test_jam_detected_sooner() {
+  learnFeeds(5, 30.0f, 5.0f);
+  FeedLimits l = deriveFeedLimits(s, BASE, 50.0f);
+  TEST_ASSERT_LESS_THAN_UINT32(BASE.stuckWindowMs, l.stuckWindowMs);
+
+  float dispensed;
+  uint32_t fixedEnd, learnedEnd;
+  TEST_ASSERT_EQUAL_INT(FEED_STUCK, runFeed(BASE, 50.0f, 5.0f, 100, 2000, dispensed, fixedEnd));
+  TEST_ASSERT_EQUAL_INT(FEED_STUCK, runFeed(l, 50.0f, 5.0f, 100, 2000, dispensed, learnedEnd));
+  TEST_ASSERT_LESS_THAN_UINT32(fixedEnd - 1000, learnedEnd);  // at least a second less open
+}
+
+void test_slow_flow_keeps_window_reachable() {
+  learnFeeds(5, 10.0f, 0.8f);  // 2 g takes 2.5 s
+  FeedLimits l = deriveFeedLimits(s, BASE, 10.0f);
+  float dispensed;
+  uint32_t end;
+  TEST_ASSERT_EQUAL_INT(FEED_TARGET_REACHED, runFeed(l, 10.0f, 0.8f, 100, UINT32_MAX, dispensed, end));
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32(BASE.stuckWindowMs, l.stuckWindowMs);
+}
+
+void test_noise_sets_min_increase() {
+  learnFeeds(5, 30.0f, 5.0f);
+  // Not enough idle readings yet
+  learnIdleNoise(s, 10.0f, 10.4f, BASE.minIncreaseG);
+  TEST_ASSERT_EQUAL_FLOAT(BASE.minIncreaseG, deriveFeedLimits(s, BASE, 30.0f).minIncreaseG);
+
+  // 0.2 g steps: variance of a reading 0.02, sd 0.14 g, 4 sd = 0.57 g
+  initFlowStats(s);
+  learnFeeds(5, 30.0f, 5.0f);
+  for (int i = 0; i < FLOW_NOISE_WINDOW; i++) {
+    learnIdleNoise(s, 10.0f, i % 2 ? 10.2f : 9.8f, BASE.minIncreaseG);
+  }
+  TEST_ASSERT_FLOAT_WITHIN(0.0005f, 0.02f, s.noiseVar);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.566f, deriveFeedLimits(s, BASE, 30.0f).minIncreaseG);
+
+  // A quiet scale stops at the floor
+  initFlowStats(s);
+  learnFeeds(5, 30.0f, 5.0f);
+  for (int i = 0; i < FLOW_NOISE_WINDOW; i++) learnIdleNoise(s, 10.0f, 10.05f, BASE.minIncreaseG);
+  TEST_ASSERT_EQUAL_FLOAT(FLOW_MIN_INCREASE_FLOOR_G, deriveFeedLimits(s, BASE, 30.0f).minIncreaseG);
+}
+
+void test_noise_ignores_big_steps_and_never_exceeds_base() {
+  learnFeeds(5, 30.0f, 5.0f);
+  for (int i = 0; i < FLOW_NOISE_WINDOW; i++) learnIdleNoise(s, 10.0f, 40.0f, BASE.minIncreaseG);
+  TEST_ASSERT_EQUAL_UINT16(0, s.noiseSamples);
+
+  for (int i = 0; i < FLOW_NOISE_WINDOW; i++) {
+    learnIdleNoise(s, i % 2 ? 11.0f : 9.0f, i % 2 ? 9.0f : 11.0f, 5.0f);
+  }
+  TEST_ASSERT_EQUAL_FLOAT(BASE.minIncreaseG, deriveFeedLimits(s, BASE, 30.0f).minIncreaseG);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_fixed_limits_until_enough_feeds);
+  RUN_TEST(test_rate_mean_and_variance);
+  RUN_TEST(test_jams_and_empty_timeouts_are_not_learned);
+  RUN_TEST(test_large_portion_completes_instead_of_timing_out);
+  RUN_TEST(test_small_portion_gets_shorter_timeout);
+  RUN_TEST(test_jam_detected_sooner);
+  RUN_TEST(test_slow_flow_keeps_window_reachable);
+  RUN_TEST(test_noise_sets_min_increase);
+  RUN_TEST(test_noise_ignores_big_steps_and_never_exceeds_base);
+  return UNITY_END();
+}
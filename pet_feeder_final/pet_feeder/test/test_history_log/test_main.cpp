@@ -0,0 +1,214 @@
+// Segment naming, time search and export lines for the history log (history_log.h).
+#include <unity.h>
+#include <string.h>
+#include "history_log.h"
+#include "feed_monitor.h"
+
+// In-memory stand-in for the SPIFFS store: records [base, base + n)
+struct FakeStore {
+  HistoryRecord recs[64];
+  uint32_t base;
+  uint32_t n;
+  uint32_t reads;
+};
+static FakeStore store;
+
+static bool readFake(uint32_t seq, HistoryRecord& out, void* ctx) {
+  FakeStore* s = static_cast<FakeStore*>(ctx);
+  s->reads++;
+  if (seq < s->base || seq >= s->base + s->n) return false;
+  out = s->recs[seq - s->base];
+  return true;
+}
+
+static void fill(uint32_t base, uint32_t n, uint32_t t0, uint32_t step) {
+  store.base = base;
+  store.n = n;
+  store.reads = 0;
+  for (uint32_t i = 0; i < n; i++) {
+    HistoryRecord r = {};
+    r.seq = base + i;
+    r.time = t0 + i * step;
+    r.kind = HIST_WEIGHT;
+    store.recs[i] = r;
+  }
+}
+
+void setUp() {
+  memset(&store, 0, sizeof(store));
+}
+
+void tearDown() {}
+
+void test_segment_path_round_trip() {
+  char path[HISTORY_PATH_MAX];
+  historySegmentPath(path, sizeof(path), 0x1a2b);
+  TEST_ASSERT_EQUAL_STRING("/hist/00001a2b.bin", path);
+
+  uint32_t seg = 0;
+  TEST_ASSERT_TRUE(parseHistorySegmentName(path, seg));
+  TEST_ASSERT_EQUAL_UINT32(0x1a2b, seg);
+  TEST_ASSERT_TRUE(parseHistorySegmentName("00000007.bin", seg));
+  TEST_ASSERT_EQUAL_UINT32(7, seg);
+
+  TEST_ASSERT_FALSE(parseHistorySegmentName("/hist/7.bin", seg));
+  TEST_ASSERT_FALSE(parseHistorySegmentName("/hist/0000000g.bin", seg));
+  TEST_ASSERT_FALSE(parseHistorySegmentName("/hist/00000007.txt", seg));
+}
+
+void test_segment_and_offset() {
+  TEST_ASSERT_EQUAL_UINT32(0, historySegmentOf(HISTORY_SEGMENT_RECORDS - 1));
+  TEST_ASSERT_EQUAL_UINT32(1, historySegmentOf(HISTORY_SEGMENT_RECORDS));
+  TEST_ASSERT_EQUAL_UINT32(0, historyOffsetOf(HISTORY_SEGMENT_RECORDS));
+  TEST_ASSERT_EQUAL_UINT32(3 * sizeof(HistoryRecord), historyOffsetOf(HISTORY_SEGMENT_RECORDS + 3));
+}
+
+void test_lower_bound_finds_first_at_or_after() {
+  fill(100, 50, 1000, 60);  // 1000, 1060, ...
+
+  TEST_ASSERT_EQUAL_UINT32(100, historyLowerBound(100, 150, 0, readFake, &store));
+  TEST_ASSERT_EQUAL_UINT32(100, historyLowerBound(100, 150, 1000, readFake, &store));
+  TEST_ASSERT_EQUAL_UINT32(101, historyLowerBound(100, 150, 1001, readFake, &store));
+  TEST_ASSERT_EQUAL_UINT32(110, historyLowerBound(100, 150, 1600, readFake, &store));
+  TEST_ASSERT_EQUAL_UINT32(150, historyLowerBound(100, 150, 999999, readFake, &store));
+}
+
+void test_lower_bound_reads_logarithmically() {
+  fill(0, 64, 0, 10);
+  store.reads = 0;
+  historyLowerBound(0, 64, 333, readFake, &store);
+  TEST_ASSERT_TRUE(store.reads <= 7);
+}
+
+void test_lower_bound_equal_times() {
+  fill(0, 8, 500, 0);
+  TEST_ASSERT_EQUAL_UINT32(0, historyLowerBound(0, 8, 500, readFake, &store));
+  TEST_ASSERT_EQUAL_UINT32(8, historyLowerBound(0, 8, 501, readFake, &store));
+}
+
+void test_lower_bound_empty_range() {
+  TEST_ASSERT_EQUAL_UINT32(5, historyLowerBound(5, 5, 0, readFake, &store));
+  TEST_ASSERT_EQUAL_UINT32(0, store.reads);
+}
+
+static HistoryRecord feedRecord() {
+  HistoryRecord r = {};
+  r.seq = 42;
+  r.time = 1700000000;
+  r.kind = HIST_FEED;
+  r.manual = 0;
+  r.slot = 1;
+  r.outcome = FEED_TARGET_REACHED;
+  r.weightDg = 203;
+  r.targetDg = 200;
+  return r;
+}
+
+void test_ndjson_lines() {
+  char line[HISTORY_LINE_MAX];
+  HistoryRecord r = feedRecord();
+  size_t n = formatHistoryLine(line, sizeof(line), r, EXPORT_NDJSON);
+  TEST_ASSERT_EQUAL_STRING("{\"seq\":42,\"time\":1700000000,\"kind\":\"feed\",\"weight\":20.3,"
+                           "\"manual\":false,\"slot\":2,\"outcome\":\"target\",\"target\":20.0}\n", line);
+  TEST_ASSERT_EQUAL(strlen(line), n);
+
+  HistoryRecord w = {};
+  w.seq = 43;
+  w.time = 1700000060;
+  w.kind = HIST_WEIGHT;
+  w.weightDg = -4;
+  formatHistoryLine(line, sizeof(line), w, EXPORT_NDJSON);
+  TEST_ASSERT_EQUAL_STRING("{\"seq\":43,\"time\":1700000060,\"kind\":\"weight\",\"weight\":-0.4}\n", line);
+}
+
+void test_csv_lines() {
+  char line[HISTORY_LINE_MAX];
+  HistoryRecord r = feedRecord();
+  r.manual = 1;
+  r.slot = -1;
+  r.outcome = FEED_STUCK;
+  formatHistoryLine(line, sizeof(line), r, EXPORT_CSV);
+  TEST_ASSERT_EQUAL_STRING("42,1700000000,feed,1,0,stuck,20.3,20.0\n", line);
+
+  HistoryRecord w = {};
+  w.seq = 43;
+  w.time = 1700000060;
+  w.kind = HIST_WEIGHT;
+  w.weightDg = 1234;
+  formatHistoryLine(line, sizeof(line), w, EXPORT_CSV);
+  TEST_ASSERT_EQUAL_STRING("43,1700000060,weight,,,,123.4,\n", line);
+  r.manual = 0;
+  r.slot = 0;
+  r.outcome = HIST_SKIPPED_EMPTY;
+  formatHistoryLine(line, sizeof(line), r, EXPORT_CSV);
+  TEST_ASSERT_EQUAL_STRING("42,1700000000,feed,0,1,hopper_empty,20.3,20.0\n", line);
+}
+
+void test_binary_records() {
+  uint8_t line[HISTORY_LINE_MAX];
+  HistoryRecord r = feedRecord();
+  // [42, 1700000000, 1, 0, 2, 1, 203, 200]
+  uint8_t cbor[] = {0x88, 0x18, 0x2a, 0x1a, 0x65, 0x53, 0xf1, 0x00, 0x01, 0x00, 0x02, 0x01,
+                    0x18, 0xcb, 0x18, 0xc8};
+  size_t n = formatHistoryLine((char*)line, sizeof(line), r, EXPORT_CBOR);
+  TEST_ASSERT_EQUAL_size_t(sizeof(cbor), n);
+  TEST_ASSERT_EQUAL_MEMORY(cbor, line, n);
+
+  HistoryRecord w = {};
+  w.seq = 43;
+  w.time = 1700000060;
+  w.kind = HIST_WEIGHT;
+  w.weightDg = -4;
+  // [43, 1700000060, 2, nil, nil, nil, -4, nil]
+  uint8_t msgpack[] = {0x98, 0x2b, 0xce, 0x65, 0x53, 0xf1, 0x3c, 0x02, 0xc0, 0xc0, 0xc0,
+                       0xfc, 0xc0};
+  n = formatHistoryLine((char*)line, sizeof(line), w, EXPORT_MSGPACK);
+  TEST_ASSERT_EQUAL_size_t(sizeof(msgpack), n);
+  TEST_ASSERT_EQUAL_MEMORY(msgpack, line, n);
+}
+
+void test_line_fits_worst_case() {
+  char line[HISTORY_LINE_MAX];
+  HistoryRecord r = feedRecord();
+  r.seq = UINT32_MAX;
+  r.time = UINT32_MAX;
+  r.manual = 1;
+  r.slot = 127;
+  r.outcome = FEED_TIMEOUT;
+  r.weightDg = INT32_MIN;
+  r.targetDg = INT32_MIN;
+  TEST_ASSERT_TRUE(formatHistoryLine(line, sizeof(line), r, EXPORT_NDJSON) > 0);
+  TEST_ASSERT_TRUE(formatHistoryLine(line, sizeof(line), r, EXPORT_CSV) > 0);
+  TEST_ASSERT_EQUAL(0, formatHistoryLine(line, 20, r, EXPORT_NDJSON));
+}
+
+void test_export_format_names() {
+  ExportFormat f = EXPORT_CSV;
+  TEST_ASSERT_TRUE(parseExportFormat("ndjson", f));
+  TEST_ASSERT_EQUAL(EXPORT_NDJSON, f);
+  TEST_ASSERT_TRUE(parseExportFormat("csv", f));
+  TEST_ASSERT_EQUAL(EXPORT_CSV, f);
+  TEST_ASSERT_TRUE(parseExportFormat("cbor", f));
+  TEST_ASSERT_EQUAL(EXPORT_CBOR, f);
+  TEST_ASSERT_TRUE(parseExportFormat("msgpack", f));
+  TEST_ASSERT_EQUAL(EXPORT_MSGPACK, f);
+  TEST_ASSERT_FALSE(parseExportFormat("json", f));
+  TEST_ASSERT_EQUAL_STRING("text/csv", exportContentType(EXPORT_CSV));
+  TEST_ASSERT_EQUAL_STRING("application/x-ndjson", exportContentType(EXPORT_NDJSON));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_segment_path_round_trip);
+  RUN_TEST(test_segment_and_offset);
+  RUN_TEST(test_lower_bound_finds_first_at_or_after);
+  RUN_TEST(test_lower_bound_reads_logarithmically);
+  RUN_TEST(test_lower_bound_equal_times);
+  RUN_TEST(test_lower_bound_empty_range);
+  RUN_TEST(test_ndjson_lines);
+  RUN_TEST(test_csv_lines);
+  RUN_TEST(test_binary_records);
+  RUN_TEST(test_line_fits_worst_case);
+  RUN_TEST(test_export_format_names);
+  return UNITY_END();
+}
@@ -0,0 +1,5 @@
+// Host stand-in: history_store.h needs nothing of Arduino.h but the types.
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
@@ -0,0 +1,96 @@
+// In-memory SPIFFS for history_store.h: flat files under their full path,
+// opened with the fopen modes the store uses. writeBudget cuts writes short
+// the way a power cut or a full partition does.
+#pragma once
+#include <map>
+#include <string>
+#include <vector>
+#include "Arduino.h"
+
+#define FILE_READ   "r"
+#define FILE_WRITE  "w"
+#define FILE_APPEND "a"
+
+typedef std::map<std::string, std::vector<uint8_t>> FakeFiles;
+
+class File {
+ public:
+  File() {}
+  File(FakeFiles* fs, const std::string& path, size_t pos)
+      : fs_(fs), path_(path), pos_(pos), open_(true) {}
+  File(FakeFiles* fs, const std::string& dir) : fs_(fs), path_(dir), open_(true), dir_(true) {}
+
+  operator bool() const { return open_; }
+  void close() { open_ = false; }
+  const char* name() const { return path_.c_str(); }
+  size_t size() const { return data().size(); }
+  size_t position() const { return pos_; }
+
+  bool seek(uint32_t pos) {
+    if (pos > size()) return false;
+    pos_ = pos;
+    return true;
+  }
+
+  size_t read(uint8_t* buf, size_t n) {
+    size_t left = size() - pos_;
+    if (n > left) n = left;
+    memcpy(buf, data().data() + pos_, n);
+    pos_ += n;
+    return n;
+  }
+
+  size_t write(const uint8_t* buf, size_t n);
+
+  File openNextFile() {
+    auto it = fs_->upper_bound(last_);
+    if (it == fs_->end() || it->first.compare(0, path_.size() + 1, path_ + "/") != 0) return File();
+    last_ = it->first;
+    return File(fs_, it->first, 0);
+  }
+
+ private:
+  std::vector<uint8_t>& data() const { return (*fs_)[path_]; }
+
+  FakeFiles*  fs_ = nullptr;
+  std::string path_;
+  size_t      pos_ = 0;
+  bool        open_ = false;
+  bool        dir_ = false;
+  std::string last_;
+};
+
+class FakeSPIFFS {
+ public:
+  FakeFiles files;
+  long      writeBudget = -1;  // bytes still written, -1 = all
+
+  File open(const char* path, const char* mode = FILE_READ) {
+    std::string p(path);
+    if (p == "/hist") return File(&files, p);
+    bool exists = files.count(p) != 0;
+    if (mode[0] == 'r' && !exists) return File();
+    if (mode[0] == 'w') files[p].clear();
+    return File(&files, p, mode[0] == 'a' ? files[p].size() : 0);
+  }
+  bool exists(const char* path) { return files.count(path) != 0; }
+  bool remove(const char* path) { return files.erase(path) != 0; }
+  bool rename(const char* from, const char* to) {
+    if (!files.count(from) || files.count(to)) return false;
+    files[to] = files[from];
+    files.erase(from);
+    return true;
+  }
+};
+
+inline FakeSPIFFS SPIFFS;
+
+inline size_t File::write(const uint8_t* buf, size_t n) {
+  if (SPIFFS.writeBudget >= 0 && (long)n > SPIFFS.writeBudget) n = SPIFFS.writeBudget;
+  if (SPIFFS.writeBudget >= 0) SPIFFS.writeBudget -= n;
+  std::vector<uint8_t>& d = data();
+  if (pos_ + n > d.size()) d.resize(pos_ + n);
+  memcpy(d.data() + pos_, buf, n);
+  pos_ += n;
+  return n;
+}
@@ -0,0 +1,114 @@
+// Segment files of the history store (history_store.h) on an in-memory
+// SPIFFS: torn and short writes must not shift the records after them.
+#include <unity.h>
+#include "history_store.h"
+
+static HistoryStore store;
+
+static HistoryRecord weightAt(uint32_t time) {
+  HistoryRecord r = {};
+  r.time = time;
+  r.kind = HIST_WEIGHT;
+  r.weightDg = (int32_t)time;
+  return r;
+}
+
+static void append(uint32_t n, uint32_t t0) {
+  for (uint32_t i = 0; i < n; i++) {
+    HistoryRecord r = weightAt(t0 + i);
+    TEST_ASSERT_TRUE(store.append(r));
+  }
+}
+
+static const std::vector<uint8_t>& segment(uint32_t seg) {
+  char path[HISTORY_PATH_MAX];
+  historySegmentPath(path, sizeof(path), seg);
+  return SPIFFS.files[path];
+}
+
+// Every seq in the store reads back as the record written for it
+static void assertReadsBack() {
+  for (uint32_t seq = store.oldest(); seq < store.end(); seq++) {
+    HistoryRecord r;
+    TEST_ASSERT_TRUE(store.read(seq, r));
+    TEST_ASSERT_EQUAL_UINT32(seq, r.seq);
+    TEST_ASSERT_EQUAL_INT32((int32_t)r.time, r.weightDg);
+  }
+  store.closeReader();
+}
+
+void setUp() {
+  SPIFFS.files.clear();
+  SPIFFS.writeBudget = -1;
+  store = HistoryStore();
+  store.begin();
+}
+void tearDown() {}
+
+void test_begin_finds_the_range() {
+  append(HISTORY_SEGMENT_RECORDS + 5, 1000);
+  store = HistoryStore();
+  store.begin();
+  TEST_ASSERT_EQUAL_UINT32(0, store.oldest());
+  TEST_ASSERT_EQUAL_UINT32(HISTORY_SEGMENT_RECORDS + 5, store.end());
+  assertReadsBack();
+}
+
+// A power cut mid-record: begin() cuts it off and the next record takes
+// its place
+void test_torn_tail_is_cut_off() {
+  append(3, 1000);
+  SPIFFS.writeBudget = 7;
+  HistoryRecord torn = weightAt(1003);
+  store.append(torn);
+  TEST_ASSERT_EQUAL_UINT32(3 * sizeof(HistoryRecord) + 7, segment(0).size());
+
+  store = HistoryStore();  // reboot
+  SPIFFS.writeBudget = -1;
+  store.begin();
+  TEST_ASSERT_EQUAL_UINT32(3, store.end());
+  TEST_ASSERT_EQUAL_UINT32(3 * sizeof(HistoryRecord), segment(0).size());
+  TEST_ASSERT_FALSE(SPIFFS.exists(HISTORY_REPAIR_PATH));
+
+  append(2, 2000);
+  TEST_ASSERT_EQUAL_UINT32(5 * sizeof(HistoryRecord), segment(0).size());
+  assertReadsBack();
+}
+
+// A short write without a reset: the failed record is not counted and the
+// next one is written over its remains
+void test_short_write_is_overwritten() {
+  append(2, 1000);
+  SPIFFS.writeBudget = 11;
+  HistoryRecord r = weightAt(1002);
+  TEST_ASSERT_FALSE(store.append(r));
+  TEST_ASSERT_EQUAL_UINT32(2, store.end());
+
+  SPIFFS.writeBudget = -1;
+  append(3, 1002);
+  TEST_ASSERT_EQUAL_UINT32(5, store.end());
+  TEST_ASSERT_EQUAL_UINT32(5 * sizeof(HistoryRecord), segment(0).size());
+  assertReadsBack();
+}
+
+// A reset between removing the torn segment and renaming the copy
+void test_interrupted_repair_is_finished() {
+  append(4, 1000);
+  SPIFFS.files[HISTORY_REPAIR_PATH] = segment(0);
+  SPIFFS.files.erase("/hist/00000000.bin");
+
+  store = HistoryStore();
+  store.begin();
+  TEST_ASSERT_EQUAL_UINT32(4, store.end());
+  TEST_ASSERT_FALSE(SPIFFS.exists(HISTORY_REPAIR_PATH));
+  assertReadsBack();
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_begin_finds_the_range);
+  RUN_TEST(test_torn_tail_is_cut_off);
+  RUN_TEST(test_short_write_is_overwritten);
+  RUN_TEST(test_interrupted_repair_is_finished);
+  return UNITY_END();
+}
@@ -0,0 +1,133 @@
+// Hopper inventory and refill forecast (hopper.h).
+#include <unity.h>
+#include "feeder_time.h"
+#include "hopper.h"
+
+static HopperState h;
+static FeedingSlot slots[3];
+static CompiledRule rules[3];
+
+static const uint32_t DAY = 24 * 3600;
+static const uint32_t NOW = 1735718400;  // 2025-01-01 08:00
+
+void setUp() {
+  initHopper(h, 1000);
+  slots[0] = {true,   8, 0, 50};
+  slots[1] = {false, 12, 0, 0};
+  slots[2] = {true,  18, 0, 100};
+  compileSlots(slots, rules, 3);
+}
+
+void tearDown() {}
+
+void test_unknown_until_first_refill() {
+  TEST_ASSERT_FALSE(h.known);
+  TEST_ASSERT_FALSE(hopperPredictEmpty(h));
+  hopperMarkEmpty(h);
+  TEST_ASSERT_FALSE(hopperPredictEmpty(h));
+
+  HopperForecast f = forecastHopper(h, rules, 3, NOW, 30 * DAY, DAY);
+  TEST_ASSERT_EQUAL_UINT32(NO_FEEDING_TIME, f.emptyAt);
+  TEST_ASSERT_FALSE(f.low);
+}
+
+void test_refill_clamps_to_capacity() {
+  hopperRefill(h, 0, 123);
+  TEST_ASSERT_TRUE(h.known);
+  TEST_ASSERT_EQUAL_FLOAT(1000, h.remainingG);
+  TEST_ASSERT_EQUAL_UINT32(123, h.refilledAt);
+  hopperRefill(h, 5000, 124);
+  TEST_ASSERT_EQUAL_FLOAT(1000, h.remainingG);
+  hopperRefill(h, 300, 125);
+  TEST_ASSERT_EQUAL_FLOAT(300, h.remainingG);
+}
+
+void test_dispensed_subtracts_and_floors() {
+  hopperRefill(h, 100, 0);
+  hopperDispensed(h, 30);
+  hopperDispensed(h, -5);  // pet ate during the feed
+  TEST_ASSERT_EQUAL_FLOAT(70, h.remainingG);
+  TEST_ASSERT_EQUAL_FLOAT(30, h.dispensedG);
+  TEST_ASSERT_FALSE(hopperPredictEmpty(h));
+
+  hopperDispensed(h, 90);
+  TEST_ASSERT_EQUAL_FLOAT(0, h.remainingG);
+  TEST_ASSERT_TRUE(hopperPredictEmpty(h));
+}
+
+void test_stuck_marks_empty() {
+  hopperRefill(h, 0, 0);
+  hopperMarkEmpty(h);
+  TEST_ASSERT_TRUE(hopperPredictEmpty(h));
+  HopperForecast f = forecastHopper(h, rules, 3, NOW, 30 * DAY, DAY);
+  TEST_ASSERT_EQUAL_UINT32(NOW, f.emptyAt);
+  TEST_ASSERT_TRUE(f.low);
+}
+
+void test_forecast_walks_schedule() {
+  // 150 g/day: 08:00 50 g, 18:00 100 g. 420 g covers two days and the
+  // next 08:00 (370 used); the 18:00 on day three needs 100 with 50 left.
+  uint32_t now = unixTime(2025, 1, 1, 7, 0, 0);
+  hopperRefill(h, 420, now);
+  HopperForecast f = forecastHopper(h, rules, 3, now, 30 * DAY, DAY);
+  TEST_ASSERT_EQUAL_UINT32(unixTime(2025, 1, 3, 18, 0, 0), f.emptyAt);
+  TEST_ASSERT_EQUAL_UINT16(5, f.feedsLeft);
+  TEST_ASSERT_FALSE(f.low);  // 2 days 11 h away
+
+  f = forecastHopper(h, rules, 3, now, 30 * DAY, 3 * DAY);
+  TEST_ASSERT_TRUE(f.low);
+}
+
+void test_forecast_counts_slots_at_the_same_minute() {
+  slots[1] = {true, 8, 0, 50};  // second slot also at 08:00
+  compileSlots(slots, rules, 3);
+  uint32_t now = unixTime(2025, 1, 1, 7, 0, 0);
+  hopperRefill(h, 99, now);
+  HopperForecast f = forecastHopper(h, rules, 3, now, 30 * DAY, DAY);
+  TEST_ASSERT_EQUAL_UINT32(unixTime(2025, 1, 1, 8, 0, 0), f.emptyAt);
+  TEST_ASSERT_EQUAL_UINT16(1, f.feedsLeft);
+  TEST_ASSERT_TRUE(f.low);
+}
+
+void test_forecast_beyond_horizon_or_no_schedule() {
+  uint32_t now = unixTime(2025, 1, 1, 7, 0, 0);
+  hopperRefill(h, 1000, now);
+  HopperForecast f = forecastHopper(h, rules, 3, now, 2 * DAY, DAY);
+  TEST_ASSERT_EQUAL_UINT32(NO_FEEDING_TIME, f.emptyAt);
+  TEST_ASSERT_EQUAL_UINT16(4, f.feedsLeft);
+  TEST_ASSERT_FALSE(f.low);
+
+  slots[0].active = false;
+  slots[2].active = false;
+  compileSlots(slots, rules, 3);
+  f = forecastHopper(h, rules, 3, now, 30 * DAY, DAY);
+  TEST_ASSERT_EQUAL_UINT32(NO_FEEDING_TIME, f.emptyAt);
+  TEST_ASSERT_EQUAL_UINT16(0, f.feedsLeft);
+}
+
+void test_forecast_walk_is_bounded() {
+  // Every minute, 0.1 g: the walk stops at HOPPER_FORECAST_MAX_FEEDS
+  FeedingSlot dense = {true, 0, 0, 1};
+  dense.everyMin = 1;
+  dense.splits = 1;
+  CompiledRule r;
+  TEST_ASSERT_TRUE(compileRule(dense, r));
+  r.portion = 0.1f;
+  hopperRefill(h, 1000, 0);
+  HopperForecast f = forecastHopper(h, &r, 1, unixTime(2025, 1, 1, 0, 0, 30), 30 * DAY, DAY);
+  TEST_ASSERT_EQUAL_UINT32(NO_FEEDING_TIME, f.emptyAt);
+  TEST_ASSERT_EQUAL_UINT16(HOPPER_FORECAST_MAX_FEEDS, f.feedsLeft);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_unknown_until_first_refill);
+  RUN_TEST(test_refill_clamps_to_capacity);
+  RUN_TEST(test_dispensed_subtracts_and_floors);
+  RUN_TEST(test_stuck_marks_empty);
+  RUN_TEST(test_forecast_walks_schedule);
+  RUN_TEST(test_forecast_counts_slots_at_the_same_minute);
+  RUN_TEST(test_forecast_beyond_horizon_or_no_schedule);
+  RUN_TEST(test_forecast_walk_is_bounded);
+  return UNITY_END();
+}
@@ -0,0 +1,153 @@
+// Deferred log records, formatting, level filtering and the tail (logger.h).
+#define FEEDER_LOG_LEVEL 3  // info: LOGD is compiled out
+#include <unity.h>
+#include <string.h>
+#include <thread>
+#include "feeder_features.h"
+#include "logger.h"
+
+static LogRecord storage[8];
+static uint32_t fakeClock;
+
+static uint32_t clockFn() { return fakeClock; }
+
+void setUp() {
+  fakeClock = 12345;
+  logInit(storage, 8, clockFn);
+}
+
+void tearDown() {}
+
+static const char* popLine() {
+  static char line[LOG_LINE_MAX];
+  LogRecord r;
+  if (!logPop(r)) return nullptr;
+  logFormatLine(r, line, sizeof(line));
+  return line;
+}
+
+void test_formats_when_drained() {
+  char name[16] = "breakfast";
+  LOGI("Feed request: %s, %.1fg (slot %d)", name, 42.25f, 3);
+  strcpy(name, "overwritten");  // the string was copied
+  LOGW("Hopper %u%% full, %ld left", 7u, -5L);
+  TEST_ASSERT_EQUAL_STRING("[   12.345] I Feed request: breakfast, 42.2g (slot 3)", popLine());
+  TEST_ASSERT_EQUAL_STRING("[   12.345] W Hopper 7% full, -5 left", popLine());
+  TEST_ASSERT_NULL(popLine());
+  TEST_ASSERT_EQUAL_UINT32(2, logStats().written);
+}
+
+void test_flags_width_and_precision_kept() {
+  LOGI("%02d:%02d|%-4s|%5.2f|%x|%c", 7, 5, "ab", 3.14159, 255u, 'k');
+  TEST_ASSERT_EQUAL_STRING("[   12.345] I 07:05|ab  | 3.14|ff|k", popLine());
+}
+
+// Levels above FEEDER_LOG_LEVEL never evaluate their arguments
+static int evaluated;
+static int sideEffect() { return ++evaluated; }
+
+void test_disabled_level_compiles_away() {
+  evaluated = 0;
+  LOGD("debug %d", sideEffect());
+  TEST_ASSERT_EQUAL_INT(0, evaluated);
+  TEST_ASSERT_NULL(popLine());
+  LOGE("error %d", sideEffect());
+  TEST_ASSERT_EQUAL_INT(1, evaluated);
+  TEST_ASSERT_EQUAL_STRING("[   12.345] E error 1", popLine());
+}
+
+void test_full_ring_drops_and_counts() {
+  for (int i = 0; i < 11; i++) LOGI("n=%d", i);
+  TEST_ASSERT_EQUAL_UINT32(8, logStats().written);
+  TEST_ASSERT_EQUAL_UINT32(3, logStats().dropped);
+  // The oldest are kept; after draining there is room again
+  TEST_ASSERT_EQUAL_STRING("[   12.345] I n=0", popLine());
+  for (int i = 1; i < 8; i++) TEST_ASSERT_NOT_NULL(popLine());
+  TEST_ASSERT_NULL(popLine());
+  LOGI("again");
+  TEST_ASSERT_EQUAL_STRING("[   12.345] I again", popLine());
+}
+
+void test_long_arguments_truncated() {
+  const char* big = "0123456789012345678901234567890123456789012345678901234567890123";
+  LOGI("%s|%d", big, 99);
+  char line[LOG_LINE_MAX];
+  LogRecord r;
+  TEST_ASSERT_TRUE(logPop(r));
+  TEST_ASSERT_TRUE(r.args.truncated);
+  logFormat(r, line, sizeof(line));
+  TEST_ASSERT_EQUAL_STRING("0123456789012345678901234567890123456789012345|?", line);
+  TEST_ASSERT_EQUAL_UINT32(1, logStats().truncated);
+}
+
+// The boot line of a full build: every feature built in, nothing cut
+void test_boot_line_lists_every_feature() {
+  LOGI(FEEDER_BOOT_LOG_FORMAT, 812ul);
+  TEST_ASSERT_EQUAL_STRING("[   12.345] I Boot: ready in 812 ms, features: http web-ui admission "
+                           "lcd buttons serial-proto trace sim ota", popLine());
+  TEST_ASSERT_EQUAL_UINT32(0, logStats().truncated);
+}
+
+// Writers on several threads: every record arrives whole, once
+void test_concurrent_writers() {
+  static LogRecord big[256];
+  logInit(big, 256, clockFn);
+  const int perThread = 50;
+  std::thread a([] { for (int i = 0; i < perThread; i++) LOGI("a %d", i); });
+  std::thread b([] { for (int i = 0; i < perThread; i++) LOGI("b %d", i); });
+  a.join();
+  b.join();
+  int nextA = 0, nextB = 0;
+  char msg[LOG_LINE_MAX];
+  LogRecord r;
+  while (logPop(r)) {
+    logFormat(r, msg, sizeof(msg));
+    int n;
+    if (sscanf(msg, "a %d", &n) == 1) TEST_ASSERT_EQUAL_INT(nextA++, n);
+    else if (sscanf(msg, "b %d", &n) == 1) TEST_ASSERT_EQUAL_INT(nextB++, n);
+    else TEST_FAIL_MESSAGE(msg);
+  }
+  TEST_ASSERT_EQUAL_INT(perThread, nextA);
+  TEST_ASSERT_EQUAL_INT(perThread, nextB);
+  TEST_ASSERT_EQUAL_UINT32(0, logStats().dropped);
+}
+
+void test_tail_reads_from_seq() {
+  static char lines[3][LOG_LINE_MAX];
+  LogTail t;
+  initLogTail(t, lines, 3);
+  char out[256];
+  uint32_t next;
+  TEST_ASSERT_EQUAL_UINT32(0, logTailRead(t, 0, out, sizeof(out), next));
+  TEST_ASSERT_EQUAL_UINT32(1, next);
+
+  logTailAppend(t, "one");
+  logTailAppend(t, "two");
+  size_t n = logTailRead(t, 2, out, sizeof(out), next);
+  TEST_ASSERT_EQUAL_STRING_LEN("two\n", out, n);
+  TEST_ASSERT_EQUAL_UINT32(3, next);
+
+  logTailAppend(t, "three");
+  logTailAppend(t, "four");  // "one" is gone
+  n = logTailRead(t, 1, out, sizeof(out), next);
+  TEST_ASSERT_EQUAL_STRING_LEN("two\nthree\nfour\n", out, n);
+  TEST_ASSERT_EQUAL_UINT32(5, next);
+
+  // Stops at the last whole line that fits
+  n = logTailRead(t, 2, out, 9, next);
+  TEST_ASSERT_EQUAL_STRING_LEN("two\n", out, n);
+  TEST_ASSERT_EQUAL_UINT32(3, next);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_formats_when_drained);
+  RUN_TEST(test_flags_width_and_precision_kept);
+  RUN_TEST(test_disabled_level_compiles_away);
+  RUN_TEST(test_full_ring_drops_and_counts);
+  RUN_TEST(test_long_arguments_truncated);
+  RUN_TEST(test_boot_line_lists_every_feature);
+  RUN_TEST(test_concurrent_writers);
+  RUN_TEST(test_tail_reads_from_seq);
+  return UNITY_END();
+}
@@ -0,0 +1,62 @@
+// Control-loop period histogram and percentiles (loop_stats.h).
+#include <unity.h>
+#include "loop_stats.h"
+
+static LoopStats s;
+
+void setUp() {
+  resetLoopStats(s);
+}
+
+void tearDown() {}
+
+void test_first_stamp_is_not_a_period() {
+  recordLoopStart(s, 1000);
+  TEST_ASSERT_EQUAL_UINT32(0, s.periods);
+  TEST_ASSERT_EQUAL_UINT32(0, loopPercentileUs(s, 0.5f));
+  TEST_ASSERT_EQUAL_UINT32(0, loopMeanUs(s));
+}
+
+void test_min_mean_max() {
+  uint32_t t = 0;
+  recordLoopStart(s, t);
+  uint32_t periods[] = {50000, 51000, 49000, 80000};
+  for (uint32_t p : periods) recordLoopStart(s, t += p);
+  TEST_ASSERT_EQUAL_UINT32(4, s.periods);
+  TEST_ASSERT_EQUAL_UINT32(49000, s.minUs);
+  TEST_ASSERT_EQUAL_UINT32(80000, s.maxUs);
+  TEST_ASSERT_EQUAL_UINT32(57500, loopMeanUs(s));
+}
+
+void test_percentiles_use_bucket_upper_edge() {
+  uint32_t t = 0;
+  recordLoopStart(s, t);
+  for (int i = 0; i < 99; i++) recordLoopStart(s, t += 50500);  // bucket 25
+  recordLoopStart(s, t += 120000);                              // bucket 60
+  TEST_ASSERT_EQUAL_UINT32(52000, loopPercentileUs(s, 0.50f));
+  TEST_ASSERT_EQUAL_UINT32(52000, loopPercentileUs(s, 0.99f));
+  TEST_ASSERT_EQUAL_UINT32(120000, loopPercentileUs(s, 1.0f));  // capped at max
+}
+
+void test_long_periods_land_in_last_bucket() {
+  recordLoopStart(s, 0);
+  recordLoopStart(s, 3000000);
+  TEST_ASSERT_EQUAL_UINT32(1, s.buckets[LOOP_BUCKETS - 1]);
+  TEST_ASSERT_EQUAL_UINT32(3000000, loopPercentileUs(s, 0.99f));
+}
+
+void test_micros_wrap() {
+  recordLoopStart(s, 0xFFFFF000);
+  recordLoopStart(s, 0x00001000);
+  TEST_ASSERT_EQUAL_UINT32(0x2000, s.maxUs);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_first_stamp_is_not_a_period);
+  RUN_TEST(test_min_mean_max);
+  RUN_TEST(test_percentiles_use_bucket_upper_edge);
+  RUN_TEST(test_long_periods_land_in_last_bucket);
+  RUN_TEST(test_micros_wrap);
+  return UNITY_END();
+}
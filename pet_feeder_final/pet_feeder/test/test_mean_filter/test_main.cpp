@@ -0,0 +1,48 @@
+// Moving mean of load-cell conversions (mean_filter.h).
+#include <unity.h>
+#include "mean_filter.h"
+
+static int32_t storage[5];
+static MeanFilter f;
+
+void setUp() { initMeanFilter(f, storage, 5); }
+void tearDown() {}
+
+// Until the ring is full, the mean of what came in so far
+void test_mean_of_first_conversions() {
+  TEST_ASSERT_EQUAL_INT32(10, meanFilterPush(f, 10));
+  TEST_ASSERT_EQUAL_INT32(15, meanFilterPush(f, 20));
+  TEST_ASSERT_EQUAL_INT32(20, meanFilterPush(f, 30));
+}
+
+// Then of the last `depth`: the oldest drops out
+void test_oldest_drops_out() {
+  for (int32_t v = 1; v <= 5; v++) meanFilterPush(f, v * 100);
+  TEST_ASSERT_EQUAL_INT32(300, meanFilterPush(f, 100));  // 200..500 and 100
+  for (int i = 0; i < 5; i++) meanFilterPush(f, -7);
+  TEST_ASSERT_EQUAL_INT32(-7, meanFilterPush(f, -7));
+}
+
+// Raw HX711 counts near the 24-bit limits add up without overflowing
+void test_large_counts() {
+  for (int i = 0; i < 5; i++) meanFilterPush(f, 8388607);
+  TEST_ASSERT_EQUAL_INT32(8388607, meanFilterPush(f, 8388607));
+  TEST_ASSERT_EQUAL_INT32(5033164, meanFilterPush(f, -8388608));  // (4 * max + min) / 5
+}
+
+// A depth of one passes conversions through
+void test_depth_one_is_passthrough() {
+  int32_t one[1];
+  initMeanFilter(f, one, 1);
+  TEST_ASSERT_EQUAL_INT32(5, meanFilterPush(f, 5));
+  TEST_ASSERT_EQUAL_INT32(-9, meanFilterPush(f, -9));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_mean_of_first_conversions);
+  RUN_TEST(test_oldest_drops_out);
+  RUN_TEST(test_large_counts);
+  RUN_TEST(test_depth_one_is_passthrough);
+  return UNITY_END();
+}
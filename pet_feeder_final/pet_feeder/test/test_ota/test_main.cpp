@@ -0,0 +1,393 @@
+// OTA image decoding, SHA-256, signatures and trial boots (lib/feeder_core/ota_image.h).
+#include <unity.h>
+#include <string.h>
+#include <vector>
+#include "ota_image.h"
+
+typedef std::vector<uint8_t> Bytes;
+
+// What the decoder wrote, and the image it reads deltas against
+static Bytes written;
+static std::vector<size_t> writeSizes;
+static Bytes base;
+static bool failWrites;
+
+static bool writeOut(void*, const uint8_t* data, size_t len) {
+  if (failWrites) return false;
+  written.insert(written.end(), data, data + len);
+  writeSizes.push_back(len);
+  return true;
+}
+
+static bool readBase(void*, uint32_t offset, uint8_t* out, size_t len) {
+  if (offset + len > base.size()) return false;
+  memcpy(out, base.data() + offset, len);
+  return true;
+}
+
+static uint8_t window[256];
+static OtaDecoder dec;
+
+void setUp() {
+  written.clear();
+  writeSizes.clear();
+  base.clear();
+  failWrites = false;
+  initOtaDecoder(dec, window, sizeof(window), writeOut, readBase, nullptr);
+}
+
+void tearDown() {}
+
+static void sha(const Bytes& b, uint8_t out[SHA256_BYTES]) {
+  Sha256 s;
+  sha256Init(s);
+  sha256Update(s, b.data(), b.size());
+  sha256Final(s, out);
+}
+
+// Builds packed images op by op, as tools/ota_pack.py writes them
+struct Packer {
+  Bytes v;
+
+  void u32(uint32_t x) {
+    for (int i = 0; i < 4; i++) v.push_back((uint8_t)(x >> (8 * i)));
+  }
+  void header(const Bytes& image, uint8_t windowBits, const Bytes* deltaBase = nullptr) {
+    u32(OTA_MAGIC);
+    v.push_back(OTA_VERSION);
+    v.push_back(deltaBase ? OTA_FLAG_DELTA : 0);
+    v.push_back(windowBits);
+    v.push_back(0);
+    u32((uint32_t)image.size());
+    uint8_t h[SHA256_BYTES] = {};
+    sha(image, h);
+    v.insert(v.end(), h, h + SHA256_BYTES);
+    memset(h, 0, sizeof(h));
+    if (deltaBase) sha(*deltaBase, h);
+    u32(deltaBase ? (uint32_t)deltaBase->size() : 0);
+    v.insert(v.end(), h, h + SHA256_BYTES);
+  }
+  void varint(uint32_t x) {
+    while (x >= 0x80) {
+      v.push_back((uint8_t)(x | 0x80));
+      x >>= 7;
+    }
+    v.push_back((uint8_t)x);
+  }
+  void op(uint8_t type, uint32_t len) {
+    if (len <= 63) {
+      v.push_back((uint8_t)(type << 6 | (len - 1)));
+    } else {
+      v.push_back((uint8_t)(type << 6 | 63));
+      varint(len - 64);
+    }
+  }
+  void literal(const Bytes& image, size_t from, uint32_t len) {
+    op(OTA_OP_LITERAL, len);
+    v.insert(v.end(), image.begin() + from, image.begin() + from + len);
+  }
+  void copy(uint32_t len, uint32_t distance) {
+    op(OTA_OP_COPY, len);
+    varint(distance);
+  }
+  void fromBase(uint32_t len, int32_t move) {
+    op(OTA_OP_BASE, len);
+    varint((uint32_t)((move << 1) ^ (move >> 31)));
+  }
+};
+
+// Feeds `in` in chunks of `chunk` bytes and finishes
+static uint8_t decodeAll(const Bytes& in, size_t chunk, uint8_t out[SHA256_BYTES]) {
+  for (size_t i = 0; i < in.size(); i += chunk) {
+    size_t n = in.size() - i < chunk ? in.size() - i : chunk;
+    if (otaDecode(dec, in.data() + i, n) != OTA_OK) return dec.result;
+  }
+  return otaDecodeFinish(dec, out);
+}
+
+static Bytes pattern(size_t n, uint32_t seed) {
+  Bytes b(n);
+  for (size_t i = 0; i < n; i++) {
+    seed = seed * 1103515245 + 12345;
+    b[i] = (uint8_t)(seed >> 16);
+  }
+  return b;
+}
+
+void test_sha256_reference_values() {
+  uint8_t h[SHA256_BYTES];
+  const char* abc = "abc";
+  sha(Bytes(abc, abc + 3), h);
+  const uint8_t expectAbc[4] = {0xba, 0x78, 0x16, 0xbf};
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(expectAbc, h, 4);
+  TEST_ASSERT_EQUAL_HEX8(0xad, h[31]);
+
+  // Two blocks, hashed in odd pieces
+  const char* msg = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+  Sha256 s;
+  sha256Init(s);
+  for (size_t i = 0, n = strlen(msg); i < n; i += 5) sha256Update(s, msg + i, n - i < 5 ? n - i : 5);
+  sha256Final(s, h);
+  const uint8_t expectTwo[4] = {0x24, 0x8d, 0x6a, 0x61};
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(expectTwo, h, 4);
+  TEST_ASSERT_EQUAL_HEX8(0xc1, h[31]);
+
+  // As /api/ota?sha256= takes it
+  uint8_t parsed[SHA256_BYTES];
+  TEST_ASSERT_TRUE(parseSha256Hex(
+      "248D6A61D20638B8E5C026930C3E6039A33CE45964FF2167F6ECEDD419DB06C1", parsed));
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(h, parsed, SHA256_BYTES);
+  TEST_ASSERT_FALSE(parseSha256Hex("248d6a61", parsed));
+  TEST_ASSERT_FALSE(parseSha256Hex(
+      "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1ff", parsed));
+  TEST_ASSERT_FALSE(parseSha256Hex(
+      "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06cx", parsed));
+}
+
+void test_plain_image_passes_through_in_window_writes() {
+  Bytes image = pattern(1000, 1);
+  image[0] = OTA_APP_IMAGE_MAGIC;
+  uint8_t h[SHA256_BYTES], expect[SHA256_BYTES];
+  TEST_ASSERT_EQUAL_UINT8(OTA_IMAGE_NONE, otaImageKind(dec));
+  TEST_ASSERT_EQUAL_UINT8(OTA_OK, decodeAll(image, 97, h));
+  TEST_ASSERT_TRUE(written == image);
+  sha(image, expect);
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(expect, h, SHA256_BYTES);
+  TEST_ASSERT_EQUAL_UINT32(4, writeSizes.size());
+  TEST_ASSERT_EQUAL_UINT32(sizeof(window), writeSizes[0]);
+  TEST_ASSERT_EQUAL_UINT8(OTA_IMAGE_FULL, otaImageKind(dec));
+}
+
+void test_not_an_image_is_refused() {
+  Bytes junk = {'<', 'h', 't', 'm', 'l', '>'};
+  uint8_t h[SHA256_BYTES];
+  TEST_ASSERT_EQUAL_UINT8(OTA_ERR_FORMAT, decodeAll(junk, 6, h));
+  TEST_ASSERT_EQUAL_UINT32(0, written.size());
+}
+
+// Literals, an overlapping copy (a run) and a long copy across ring wraps,
+// fed a byte at a time
+void test_packed_image_unpacks() {
+  Bytes image = pattern(40, 2);
+  image.insert(image.end(), 100, 0xFF);                    // run
+  Bytes tail(image.begin(), image.begin() + 140);
+  for (int i = 0; i < 5; i++) image.insert(image.end(), tail.begin(), tail.end());
+
+  Packer p;
+  p.header(image, 8);
+  p.literal(image, 0, 41);
+  p.copy(99, 1);
+  p.copy(5 * 140, 140);
+  uint8_t h[SHA256_BYTES];
+  TEST_ASSERT_EQUAL_UINT8(OTA_OK, decodeAll(p.v, 1, h));
+  TEST_ASSERT_EQUAL_UINT32(image.size(), written.size());
+  TEST_ASSERT_TRUE(written == image);
+  TEST_ASSERT_TRUE(dec.in < image.size() / 4);
+  TEST_ASSERT_EQUAL_UINT8(OTA_IMAGE_PACKED, otaImageKind(dec));
+}
+
+// Base copies move a cursor: forward over a change, and back
+void test_delta_copies_from_running_image() {
+  base = pattern(600, 3);
+  Bytes image(base.begin(), base.begin() + 200);              // same start
+  image.insert(image.end(), {1, 2, 3, 4});                    // inserted
+  image.insert(image.end(), base.begin() + 210, base.end());  // 10 dropped
+  image.insert(image.end(), base.begin() + 100, base.begin() + 150);  // moved back
+
+  Packer p;
+  p.header(image, 8, &base);
+  p.fromBase(200, 0);
+  p.literal(image, 200, 4);
+  p.fromBase(390, 10);
+  p.fromBase(50, -500);
+  uint8_t h[SHA256_BYTES];
+  TEST_ASSERT_EQUAL_UINT8(OTA_OK, decodeAll(p.v, 13, h));
+  TEST_ASSERT_TRUE(written == image);
+  TEST_ASSERT_TRUE(p.v.size() < 100);
+  TEST_ASSERT_EQUAL_UINT8(OTA_IMAGE_DELTA, otaImageKind(dec));
+}
+
+void test_delta_against_other_image_writes_nothing() {
+  Bytes made = pattern(300, 4);
+  base = pattern(300, 5);
+  Packer p;
+  p.header(made, 8, &made);
+  p.fromBase(300, 0);
+  uint8_t h[SHA256_BYTES];
+  TEST_ASSERT_EQUAL_UINT8(OTA_ERR_BASE, decodeAll(p.v, 64, h));
+  TEST_ASSERT_EQUAL_UINT32(0, written.size());
+
+  // And a decoder that cannot read the running image refuses deltas
+  base = made;
+  initOtaDecoder(dec, window, sizeof(window), writeOut, nullptr, nullptr);
+  TEST_ASSERT_EQUAL_UINT8(OTA_ERR_BASE, decodeAll(p.v, 64, h));
+}
+
+void test_window_larger_than_decoder_is_refused() {
+  Bytes image = pattern(10, 6);
+  Packer p;
+  p.header(image, 9);  // 512 > 256
+  p.literal(image, 0, 10);
+  uint8_t h[SHA256_BYTES];
+  TEST_ASSERT_EQUAL_UINT8(OTA_ERR_WINDOW, decodeAll(p.v, 64, h));
+}
+
+void test_corrupt_images_fail() {
+  Bytes image = pattern(100, 7);
+  uint8_t h[SHA256_BYTES];
+
+  Packer hash;
+  hash.header(image, 8);
+  Bytes other = image;
+  other[50] ^= 1;
+  hash.literal(other, 0, 100);
+  TEST_ASSERT_EQUAL_UINT8(OTA_ERR_HASH, decodeAll(hash.v, 64, h));
+
+  setUp();
+  Packer cut;
+  cut.header(image, 8);
+  cut.literal(image, 0, 60);
+  TEST_ASSERT_EQUAL_UINT8(OTA_ERR_SIZE, decodeAll(cut.v, 64, h));
+
+  setUp();
+  Packer extra;
+  extra.header(image, 8);
+  extra.literal(image, 0, 100);
+  extra.v.push_back(0);
+  TEST_ASSERT_EQUAL_UINT8(OTA_ERR_SIZE, decodeAll(extra.v, 64, h));
+
+  setUp();
+  Packer far;
+  far.header(image, 8);
+  far.literal(image, 0, 10);
+  far.copy(90, 11);  // before the start
+  TEST_ASSERT_EQUAL_UINT8(OTA_ERR_FORMAT, decodeAll(far.v, 64, h));
+
+  setUp();
+  Packer header;
+  header.header(image, 8);
+  header.v.resize(40);  // the download broke off
+  TEST_ASSERT_EQUAL_UINT8(OTA_ERR_DOWNLOAD, decodeAll(header.v, 64, h));
+}
+
+void test_write_failure_stops_decoder() {
+  Bytes image = pattern(600, 8);
+  image[0] = OTA_APP_IMAGE_MAGIC;
+  failWrites = true;
+  TEST_ASSERT_EQUAL_UINT8(OTA_ERR_WRITE, otaDecode(dec, image.data(), image.size()));
+  TEST_ASSERT_EQUAL_UINT32(sizeof(window), dec.in);  // stopped at the first write
+  TEST_ASSERT_EQUAL_UINT8(OTA_ERR_WRITE, otaDecode(dec, image.data(), 1));
+}
+
+static void hex(const char* h, uint8_t* out, size_t bytes) {
+  TEST_ASSERT_TRUE(parseHex(h, out, bytes));
+}
+
+// Key 00 01 .. 1f (tools/ota_sign.py); the image as written is 300 bytes
+static const char* OTA_TEST_KEY = "03a107bff3ce10be1d70dd18e74bc09967e4d6309ba50d5f1ddc8664125531b8";
+static const char* OTA_TEST_SIG =
+    "8cb4cc805ad838c6e694b11d41daa00a31f1aa7f1f2e81ce356f7a0340d5fad4"
+    "4fcb47c705a39f8a6f1f5ccef26b6f7621fbf2e51f9f11d4b17dc7f1156cec0f";
+
+// RFC 8032 7.1, test 1
+void test_ed25519_reference_signature() {
+  uint8_t key[ED25519_KEY_BYTES], sig[ED25519_SIG_BYTES];
+  hex("d75a980182b10ab7d54bfed3c964073a0ee172f3daa62325af021a68f707511a", key, sizeof(key));
+  hex("e5564300c360ac729086e2cc806e828a84877f1eb8e5d974d873e065224901555fb8821590a33bac"
+      "c61e39701cf9b46bd25bf5f0595bbe24655141438e7a100b", sig, sizeof(sig));
+  TEST_ASSERT_TRUE(ed25519Verify(sig, nullptr, 0, key));
+
+  uint8_t m = 0x72;
+  TEST_ASSERT_FALSE(ed25519Verify(sig, &m, 1, key));
+  sig[0] ^= 1;  // R
+  TEST_ASSERT_FALSE(ed25519Verify(sig, nullptr, 0, key));
+
+  // A message over several SHA-512 blocks (bytes 0..255, three times)
+  uint8_t msg[768];
+  for (size_t i = 0; i < sizeof(msg); i++) msg[i] = (uint8_t)i;
+  hex(OTA_TEST_KEY, key, sizeof(key));
+  hex("d2853b807fbf1e017a0e545d17618405c58a3a436090fb9b9dd5671d776d7060"
+      "45da805db2a06c75a24c44d739de76fcd93426a6dee1d120e7ea45c657b6b601", sig, sizeof(sig));
+  TEST_ASSERT_TRUE(ed25519Verify(sig, msg, sizeof(msg), key));
+}
+
+
+void test_signature_covers_the_written_image() {
+  Bytes image(300);
+  for (size_t i = 0; i < image.size(); i++) image[i] = (uint8_t)(i * 7);
+  image[0] = OTA_APP_IMAGE_MAGIC;
+  uint8_t key[ED25519_KEY_BYTES], sig[ED25519_SIG_BYTES], sha[SHA256_BYTES];
+  hex(OTA_TEST_KEY, key, sizeof(key));
+  hex(OTA_TEST_SIG, sig, sizeof(sig));
+
+  otaDecode(dec, image.data(), image.size());
+  TEST_ASSERT_EQUAL_UINT8(OTA_OK, otaDecodeFinish(dec, sha));
+  TEST_ASSERT_TRUE(otaSignatureValid(sha, sig, key));
+
+  // One byte different, another key, or S pushed past L
+  sha[7] ^= 0x10;
+  TEST_ASSERT_FALSE(otaSignatureValid(sha, sig, key));
+  sha[7] ^= 0x10;
+  uint8_t other[ED25519_KEY_BYTES];
+  hex("d75a980182b10ab7d54bfed3c964073a0ee172f3daa62325af021a68f707511a", other, sizeof(other));
+  TEST_ASSERT_FALSE(otaSignatureValid(sha, sig, other));
+  sig[63] |= 0xf0;
+  TEST_ASSERT_FALSE(otaSignatureValid(sha, sig, key));
+
+  // y = 2 is no point of the curve
+  uint8_t bad[ED25519_KEY_BYTES] = {2};
+  hex(OTA_TEST_SIG, sig, sizeof(sig));
+  TEST_ASSERT_FALSE(otaSignatureValid(sha, sig, bad));
+}
+
+void test_token_must_match_exactly() {
+  TEST_ASSERT_TRUE(otaTokenMatches("s3cret", "s3cret"));
+  TEST_ASSERT_FALSE(otaTokenMatches("s3cret", "s3cre"));
+  TEST_ASSERT_FALSE(otaTokenMatches("s3cret", "s3crets"));
+  TEST_ASSERT_FALSE(otaTokenMatches("s3cret", "S3cret"));
+  TEST_ASSERT_FALSE(otaTokenMatches("s3cret", ""));
+  TEST_ASSERT_FALSE(otaTokenMatches("", ""));  // no token configured
+}
+
+void test_trial_rolls_back_after_repeated_boots() {
+  OtaTrial t = {1, 0, 0x170000};
+  for (int i = 0; i < OTA_TRIAL_BOOTS; i++) {
+    TEST_ASSERT_EQUAL_UINT8(OTA_TRIAL_RUN, otaTrialBoot(t, 0x170000));
+  }
+  TEST_ASSERT_EQUAL_UINT8(OTA_TRIAL_ROLLBACK, otaTrialBoot(t, 0x170000));
+
+  // The bootloader already went back: nothing left to try
+  OtaTrial gone = {1, 1, 0x170000};
+  TEST_ASSERT_EQUAL_UINT8(OTA_TRIAL_NONE, otaTrialBoot(gone, 0x10000));
+  TEST_ASSERT_EQUAL_UINT8(0, gone.active);
+
+  OtaTrial none = {0, 0, 0};
+  TEST_ASSERT_EQUAL_UINT8(OTA_TRIAL_NONE, otaTrialBoot(none, 0x10000));
+}
+
+void test_health_check_waits_for_network() {
+  TEST_ASSERT_EQUAL_UINT8(OTA_HEALTH_WAIT, otaHealthCheck(OTA_HEALTHY_MS - 1, false, false));
+  TEST_ASSERT_EQUAL_UINT8(OTA_HEALTH_OK, otaHealthCheck(OTA_HEALTHY_MS, false, false));
+  TEST_ASSERT_EQUAL_UINT8(OTA_HEALTH_WAIT, otaHealthCheck(OTA_HEALTHY_MS, true, false));
+  TEST_ASSERT_EQUAL_UINT8(OTA_HEALTH_OK, otaHealthCheck(OTA_HEALTHY_MS, true, true));
+  TEST_ASSERT_EQUAL_UINT8(OTA_HEALTH_FAIL, otaHealthCheck(OTA_NETWORK_MS, true, false));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_sha256_reference_values);
+  RUN_TEST(test_plain_image_passes_through_in_window_writes);
+  RUN_TEST(test_not_an_image_is_refused);
+  RUN_TEST(test_packed_image_unpacks);
+  RUN_TEST(test_delta_copies_from_running_image);
+  RUN_TEST(test_delta_against_other_image_writes_nothing);
+  RUN_TEST(test_window_larger_than_decoder_is_refused);
+  RUN_TEST(test_corrupt_images_fail);
+  RUN_TEST(test_write_failure_stops_decoder);
+  RUN_TEST(test_ed25519_reference_signature);
+  RUN_TEST(test_signature_covers_the_written_image);
+  RUN_TEST(test_token_must_match_exactly);
+  RUN_TEST(test_trial_rolls_back_after_repeated_boots);
+  RUN_TEST(test_health_check_waits_for_network);
+  return UNITY_END();
+}
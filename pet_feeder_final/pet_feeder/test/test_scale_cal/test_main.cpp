@@ -0,0 +1,163 @@
+// Known-mass calibration and zero tracking (scale_cal.h).
+#include <unity.h>
+#include "scale_cal.h"
+
+static const float CPG = -7050.0f;  // the configured factor: wired negative
+static const int32_t ZERO = 84000;
+
+static ScaleCal cal;
+static CalCapture cap;
+static ZeroTracker zt;
+
+// Raw counts of `grams` on a scale whose true zero is `zero`
+static int32_t counts(float grams, int32_t zero = ZERO, float cpg = CPG) {
+  return zero + (int32_t)(grams * cpg);
+}
+
+// Feeds conversions until the capture ends; returns how many it took
+static int capture(float grams, int32_t zero = ZERO, float cpg = CPG) {
+  for (int i = 1; i <= CAL_MAX_SAMPLES; i++) {
+    float wobble = (i % 3 - 1) * 0.2f;
+    if (calCaptureSample(cap, cal, counts(grams + wobble, zero, cpg))) return i;
+  }
+  return -1;
+}
+
+// Idle conversions of `grams` every 100 ms from `fromMs` for `forMs`
+static uint32_t idle(float grams, int32_t zero, uint32_t fromMs, uint32_t forMs) {
+  for (uint32_t t = fromMs; t < fromMs + forMs; t += 100) {
+    zeroTrack(zt, cal, counts(grams, zero), true, t);
+  }
+  return fromMs + forMs;
+}
+
+void setUp() {
+  cal = {0, CPG, 0};
+  initCalCapture(cap);
+  initZeroTracker(zt, 0);
+}
+void tearDown() {}
+
+void test_grams_are_signed() {
+  cal.offset = ZERO;
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 25.0f, scaleGrams(cal, counts(25)));
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, -3.0f, scaleGrams(cal, counts(-3)));
+}
+
+void test_zero_capture_sets_offset() {
+  startCalCapture(cap, CAL_ZERO, 0);
+  TEST_ASSERT_EQUAL(CAL_RUNNING, cap.result);
+  TEST_ASSERT_EQUAL_INT(CAL_SAMPLES, capture(0));
+  TEST_ASSERT_EQUAL(CAL_OK, cap.result);
+  TEST_ASSERT_EQUAL(CAL_NONE, cap.step);
+  TEST_ASSERT_EQUAL(CAL_ZERO, cap.lastStep);
+  TEST_ASSERT_FLOAT_WITHIN(200.0f, (float)ZERO, (float)cal.offset);
+  TEST_ASSERT_FALSE(calCaptureSample(cap, cal, 0));  // nothing running
+}
+
+// Sign and size of the factor both come from the mass
+void test_span_capture_sets_factor() {
+  cal.offset = ZERO;
+  startCalCapture(cap, CAL_SPAN, 100);
+  TEST_ASSERT_EQUAL_INT(CAL_SAMPLES, capture(100, ZERO, 6500.0f));
+  TEST_ASSERT_EQUAL(CAL_OK, cap.result);
+  TEST_ASSERT_FLOAT_WITHIN(20.0f, 6500.0f, cal.countsPerGram);
+  TEST_ASSERT_FLOAT_WITHIN(0.1f, 100.0f, scaleGrams(cal, counts(100, ZERO, 6500.0f)));
+}
+
+void test_span_without_the_mass_is_rejected() {
+  cal.offset = ZERO;
+  startCalCapture(cap, CAL_SPAN, 100);
+  capture(2);  // the mass is not on the scale
+  TEST_ASSERT_EQUAL(CAL_BAD_SPAN, cap.result);
+  TEST_ASSERT_EQUAL_FLOAT(CPG, cal.countsPerGram);
+}
+
+// A jump restarts the run; a reading that never settles gives up
+void test_unsteady_reading_restarts_then_fails() {
+  startCalCapture(cap, CAL_ZERO, 0);
+  for (int i = 0; i < CAL_SAMPLES - 1; i++) calCaptureSample(cap, cal, counts(0));
+  calCaptureSample(cap, cal, counts(5));
+  TEST_ASSERT_EQUAL(CAL_RUNNING, cap.result);
+  TEST_ASSERT_EQUAL_UINT16(1, cap.count);
+
+  startCalCapture(cap, CAL_ZERO, 0);
+  int n = 0;
+  while (!calCaptureSample(cap, cal, counts(n % 2 ? 3 : 0))) n++;
+  TEST_ASSERT_EQUAL(CAL_UNSTABLE, cap.result);
+  TEST_ASSERT_EQUAL_UINT16(CAL_MAX_SAMPLES, cap.seen);
+  TEST_ASSERT_EQUAL_INT32(0, cal.offset);
+}
+
+// Negative drift is taken out a step at a time, once settled
+void test_zero_tracking_follows_drift() {
+  cal.offset = ZERO;
+  int32_t drifted = counts(-1.0f);  // zero now reads -1 g
+  uint32_t t = idle(0, drifted, 0, ZERO_TRACK_SETTLE_MS - 200);
+  TEST_ASSERT_EQUAL_UINT32(0, zt.steps);
+
+  t = idle(0, drifted, t, 5000);
+  TEST_ASSERT_EQUAL_UINT32(3, zt.steps);  // at 10, 12 and 14 s
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, -3 * ZERO_TRACK_STEP_G, zt.trackedG);
+
+  idle(0, drifted, t, 60000);
+  TEST_ASSERT_FLOAT_WITHIN(ZERO_TRACK_DEADBAND_G, 0.0f, scaleGrams(cal, drifted));
+}
+
+void test_zero_tracking_needs_idle_and_stable() {
+  cal.offset = ZERO;
+  int32_t drifted = counts(-1.0f);
+  uint32_t t = idle(0, drifted, 0, 20000);
+  uint32_t steps = zt.steps;
+
+  for (int i = 0; i < 50; i++, t += 100) zeroTrack(zt, cal, drifted, false, t);  // feeding
+  t = idle(0, drifted, t, ZERO_TRACK_SETTLE_MS - 200);
+  TEST_ASSERT_EQUAL_UINT32(steps, zt.steps);
+
+  int32_t before = cal.offset;
+  for (int i = 0; i < 300; i++, t += 100) {  // a paw on the bowl
+    zeroTrack(zt, cal, counts(i % 2 ? -1.5f : -0.5f), true, t);
+  }
+  TEST_ASSERT_EQUAL_INT32(before, cal.offset);
+}
+
+// Food left in the bowl and a lifted bowl are not drift
+void test_zero_tracking_band() {
+  cal.offset = ZERO;
+  idle(8.0f, ZERO, 0, 60000);
+  TEST_ASSERT_EQUAL_UINT32(0, zt.steps);
+  idle(-250.0f, ZERO, 60000, 60000);
+  TEST_ASSERT_EQUAL_UINT32(0, zt.steps);
+  TEST_ASSERT_EQUAL_INT32(ZERO, cal.offset);
+}
+
+// With food in the bowl a slow creep is drift; a bite starts over
+void test_zero_tracking_holds_a_steady_bowl() {
+  cal.offset = ZERO;
+  uint32_t t = idle(40.0f, ZERO, 0, 12000);  // settles and holds 40 g
+  int32_t zero = ZERO;
+  for (int i = 1; i <= 3000; i++) {  // +1.5 g over 5 minutes
+    zero = ZERO + (int32_t)(i * 0.0005f * CPG);
+    t = idle(40.0f, zero, t, 100);
+  }
+  t = idle(40.0f, zero, t, 30000);
+  TEST_ASSERT_FLOAT_WITHIN(0.1f, 40.0f, scaleGrams(cal, counts(40.0f, zero)));
+
+  idle(30.0f, zero, t, 60000);  // the pet ate 10 g
+  TEST_ASSERT_FLOAT_WITHIN(0.1f, 30.0f, scaleGrams(cal, counts(30.0f, zero)));
+  TEST_ASSERT_FLOAT_WITHIN(0.1f, 0.0f, scaleGrams(cal, zero));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_grams_are_signed);
+  RUN_TEST(test_zero_capture_sets_offset);
+  RUN_TEST(test_span_capture_sets_factor);
+  RUN_TEST(test_span_without_the_mass_is_rejected);
+  RUN_TEST(test_unsteady_reading_restarts_then_fails);
+  RUN_TEST(test_zero_tracking_follows_drift);
+  RUN_TEST(test_zero_tracking_needs_idle_and_stable);
+  RUN_TEST(test_zero_tracking_band);
+  RUN_TEST(test_zero_tracking_holds_a_steady_bowl);
+  return UNITY_END();
+}
@@ -0,0 +1,448 @@
+// Edge-triggered firing with catch-up, next-feeding-time lookup and
+// recurrence rules (lib/feeder_core/schedule.h).
+#include <unity.h>
+#include <string.h>
+#include "feeder_time.h"
+#include "schedule.h"
+
+static FeedingSlot slots[3];
+static CompiledRule rules[3];
+static uint32_t markers[3];
+
+static uint32_t at(int y, int mo, int d, int h, int mi, int s) {
+  return unixTime(y, mo, d, h, mi, s);
+}
+
+void setUp() {
+  slots[0] = {false,  8, 0, 0};
+  slots[1] = {false, 12, 0, 0};
+  slots[2] = {false, 18, 0, 0};
+  for (uint32_t& m : markers) m = at(2025, 1, 1, 0, 0, 0);
+}
+
+void tearDown() {}
+
+// First slot that feeds at `now`, or -1
+static int due(uint32_t now) {
+  compileSlots(slots, rules, 3);
+  for (int i = 0; i < 3; i++) {
+    if (checkSlotDue(rules[i], markers[i], now).amount > 0) return i;
+  }
+  return -1;
+}
+
+static uint32_t next(uint32_t now) {
+  compileSlots(slots, rules, 3);
+  return nextFeedingTime(rules, 3, now);
+}
+
+static CompiledRule compiled(const FeedingSlot& slot) {
+  CompiledRule r;
+  TEST_ASSERT_TRUE(compileRule(slot, r));
+  return r;
+}
+
+static FeedingSlot cronSlot(const char* expr, float weight) {
+  FeedingSlot s = {true, 0, 0, weight};
+  strncpy(s.cron, expr, CRON_MAX - 1);
+  return s;
+}
+
+void test_unix_time_round_trip() {
+  uint32_t t = at(2024, 2, 29, 23, 59, 58);
+  int y, mo, d;
+  civilDate(t, y, mo, d);
+  TEST_ASSERT_EQUAL_INT(2024, y);
+  TEST_ASSERT_EQUAL_INT(2, mo);
+  TEST_ASSERT_EQUAL_INT(29, d);
+  TEST_ASSERT_EQUAL_INT(23, hourOf(t));
+  TEST_ASSERT_EQUAL_INT(59, minuteOf(t));
+  TEST_ASSERT_EQUAL_INT(58, secondOf(t));
+  TEST_ASSERT_EQUAL_UINT32(1704067200u, at(2024, 1, 1, 0, 0, 0));
+  TEST_ASSERT_EQUAL_INT(1, dayOfWeek(at(2024, 1, 1, 12, 0, 0)));  // Monday
+}
+
+void test_due_slot_fires_from_its_minute() {
+  slots[1] = {true, 12, 0, 50};
+  TEST_ASSERT_EQUAL_INT(-1, due(at(2025, 1, 1, 11, 59, 59)));
+  TEST_ASSERT_EQUAL_INT(1,  due(at(2025, 1, 1, 12, 0, 1)));
+}
+
+void test_due_slot_not_lost_between_evaluations() {
+  slots[1] = {true, 12, 0, 50};
+  TEST_ASSERT_EQUAL_INT(-1, due(at(2025, 1, 1, 11, 59, 0)));
+  TEST_ASSERT_EQUAL_INT(1,  due(at(2025, 1, 1, 12, 0, 7)));
+}
+
+void test_fires_once_per_occurrence() {
+  slots[0] = {true, 8, 0, 50};
+  TEST_ASSERT_EQUAL_INT(0,  due(at(2025, 1, 1, 8, 0, 0)));
+  TEST_ASSERT_EQUAL_INT(-1, due(at(2025, 1, 1, 8, 0, 0)));
+  TEST_ASSERT_EQUAL_INT(-1, due(at(2025, 1, 1, 8, 0, 1)));
+  TEST_ASSERT_EQUAL_INT(-1, due(at(2025, 1, 1, 9, 0, 0)));
+  // Same slot fires again the next day
+  TEST_ASSERT_EQUAL_INT(0,  due(at(2025, 1, 2, 8, 0, 0)));
+}
+
+void test_rewound_marker_allows_refire() {
+  slots[0] = {true, 8, 0, 50};
+  TEST_ASSERT_EQUAL_INT(0, due(at(2025, 1, 1, 8, 0, 0)));
+  markers[0] = at(2025, 1, 1, 7, 0, 0);
+  TEST_ASSERT_EQUAL_INT(0, due(at(2025, 1, 1, 8, 0, 1)));
+}
+
+void test_inactive_or_empty_slots_never_fire() {
+  slots[0] = {false, 8, 0, 50};
+  slots[1] = {true,  8, 0, 0};
+  TEST_ASSERT_EQUAL_INT(-1, due(at(2025, 1, 1, 8, 0, 0)));
+}
+
+void test_same_minute_slots_both_fire() {
+  slots[0] = {true, 8, 0, 50};
+  slots[2] = {true, 8, 0, 70};
+  TEST_ASSERT_EQUAL_INT(0,  due(at(2025, 1, 1, 8, 0, 0)));
+  TEST_ASSERT_EQUAL_INT(2,  due(at(2025, 1, 1, 8, 0, 1)));
+  TEST_ASSERT_EQUAL_INT(-1, due(at(2025, 1, 1, 8, 0, 2)));
+}
+
+void test_unset_marker_starts_now() {
+  slots[0] = {true, 8, 0, 50};
+  markers[0] = NO_MARKER;
+  compileSlots(slots, rules, 3);
+  DueFeed d = checkSlotDue(rules[0], markers[0], at(2025, 1, 1, 8, 0, 30));
+  TEST_ASSERT_EQUAL_INT(DUE_NONE, d.kind);
+  TEST_ASSERT_EQUAL_UINT32(at(2025, 1, 1, 8, 0, 30), markers[0]);
+}
+
+void test_clock_moved_back_restarts_marker() {
+  slots[0] = {true, 8, 0, 50};
+  markers[0] = at(2025, 1, 2, 8, 0, 0);
+  TEST_ASSERT_EQUAL_INT(-1, due(at(2025, 1, 1, 7, 0, 0)));
+  TEST_ASSERT_EQUAL_UINT32(at(2025, 1, 1, 7, 0, 0), markers[0]);
+  TEST_ASSERT_EQUAL_INT(0, due(at(2025, 1, 1, 8, 0, 0)));
+}
+
+static DueFeed lateBy(uint8_t policy, uint16_t windowMin, uint32_t lateSecs) {
+  FeedingSlot s = {true, 8, 0, 60};
+  s.catchUp = policy;
+  s.catchUpMin = windowMin;
+  CompiledRule r = compiled(s);
+  uint32_t marker = at(2025, 1, 1, 7, 0, 0);
+  DueFeed d = checkSlotDue(r, marker, at(2025, 1, 1, 8, 0, 0) + lateSecs);
+  if (d.kind != DUE_NONE) TEST_ASSERT_EQUAL_UINT32(at(2025, 1, 1, 8, 0, 0), marker);
+  return d;
+}
+
+void test_catch_up_skip() {
+  TEST_ASSERT_EQUAL_INT(DUE_ON_TIME, lateBy(CATCHUP_SKIP, 30, 59).kind);
+  DueFeed d = lateBy(CATCHUP_SKIP, 30, 60);
+  TEST_ASSERT_EQUAL_INT(DUE_SKIPPED, d.kind);
+  TEST_ASSERT_EQUAL_FLOAT(0, d.amount);
+}
+
+void test_catch_up_late_within_window() {
+  DueFeed d = lateBy(CATCHUP_LATE, 30, 30 * 60);
+  TEST_ASSERT_EQUAL_INT(DUE_LATE, d.kind);
+  TEST_ASSERT_EQUAL_FLOAT(60, d.amount);
+  TEST_ASSERT_EQUAL_UINT32(at(2025, 1, 1, 8, 0, 0), d.fireTime);
+  TEST_ASSERT_EQUAL_INT(DUE_SKIPPED, lateBy(CATCHUP_LATE, 30, 30 * 60 + 1).kind);
+}
+
+void test_catch_up_proportional() {
+  DueFeed d = lateBy(CATCHUP_PROPORTIONAL, 60, 15 * 60);
+  TEST_ASSERT_EQUAL_INT(DUE_LATE, d.kind);
+  TEST_ASSERT_EQUAL_FLOAT(45, d.amount);
+  TEST_ASSERT_EQUAL_FLOAT(60, lateBy(CATCHUP_PROPORTIONAL, 60, 30).amount);  // on time
+  TEST_ASSERT_EQUAL_INT(DUE_SKIPPED, lateBy(CATCHUP_PROPORTIONAL, 60, 59 * 60 + 30).kind);  // < 1 g
+}
+
+void test_catch_up_policy_names() {
+  uint8_t p = 0xFF;
+  TEST_ASSERT_TRUE(parseCatchUpPolicy("proportional", p));
+  TEST_ASSERT_EQUAL_UINT8(CATCHUP_PROPORTIONAL, p);
+  TEST_ASSERT_EQUAL_STRING("skip", catchUpPolicyName(CATCHUP_SKIP));
+  TEST_ASSERT_FALSE(parseCatchUpPolicy("later", p));
+  TEST_ASSERT_EQUAL_UINT8(CATCHUP_PROPORTIONAL, p);
+
+  FeedingSlot s = {true, 8, 0, 50};
+  s.catchUp = 3;
+  CompiledRule r;
+  TEST_ASSERT_FALSE(compileRule(s, r));
+}
+
+void test_only_latest_missed_occurrence_counts() {
+  // every 30 min from 06:00, evaluated again only at 09:10
+  slots[0] = {true, 6, 0, 20};
+  slots[0].everyMin = 30;
+  compileSlots(slots, rules, 3);
+  markers[0] = at(2025, 1, 1, 6, 0, 0);
+  DueFeed d = checkSlotDue(rules[0], markers[0], at(2025, 1, 1, 9, 10, 0));
+  TEST_ASSERT_EQUAL_INT(DUE_LATE, d.kind);
+  TEST_ASSERT_EQUAL_UINT32(at(2025, 1, 1, 9, 0, 0), d.fireTime);
+  d = checkSlotDue(rules[0], markers[0], at(2025, 1, 1, 9, 10, 1));
+  TEST_ASSERT_EQUAL_INT(DUE_NONE, d.kind);
+}
+
+void test_prev_fire() {
+  CompiledRule r = compiled(cronSlot("15,45 9,20 * * 1-5", 40));
+  // Monday 2025-01-06
+  TEST_ASSERT_EQUAL_UINT32(at(2025, 1, 6, 9, 45, 0),  rulePrevFire(r, at(2025, 1, 6, 9, 45, 0)));
+  TEST_ASSERT_EQUAL_UINT32(at(2025, 1, 6, 9, 15, 0),  rulePrevFire(r, at(2025, 1, 6, 9, 44, 59)));
+  TEST_ASSERT_EQUAL_UINT32(at(2025, 1, 6, 9, 45, 0),  rulePrevFire(r, at(2025, 1, 6, 20, 14, 0)));
+  // Monday before 09:15 -> Friday 20:45
+  TEST_ASSERT_EQUAL_UINT32(at(2025, 1, 3, 20, 45, 0), rulePrevFire(r, at(2025, 1, 6, 9, 0, 0)));
+
+  FeedingSlot s = {true, 6, 0, 20};
+  s.everyMin = 90;
+  s.untilMin = 21 * 60;
+  r = compiled(s);
+  TEST_ASSERT_EQUAL_UINT32(at(2025, 1, 1, 10, 30, 0), rulePrevFire(r, at(2025, 1, 1, 11, 59, 0)));
+  TEST_ASSERT_EQUAL_UINT32(at(2025, 1, 1, 21, 0, 0),  rulePrevFire(r, at(2025, 1, 1, 23, 0, 0)));
+  TEST_ASSERT_EQUAL_UINT32(at(2024, 12, 31, 21, 0, 0), rulePrevFire(r, at(2025, 1, 1, 5, 0, 0)));
+}
+
+void test_next_time_none_when_no_slots() {
+  TEST_ASSERT_EQUAL_UINT32(NO_FEEDING_TIME, next(at(2025, 1, 1, 9, 0, 0)));
+}
+
+void test_next_time_later_today() {
+  slots[0] = {true,  8, 0, 50};
+  slots[2] = {true, 18, 30, 50};
+  TEST_ASSERT_EQUAL_UINT32(at(2025, 1, 1, 18, 30, 0),
+                           next(at(2025, 1, 1, 9, 0, 0)));
+}
+
+void test_next_time_wraps_to_tomorrow() {
+  slots[0] = {true, 8, 0, 50};
+  TEST_ASSERT_EQUAL_UINT32(at(2025, 1, 2, 8, 0, 0),
+                           next(at(2025, 1, 1, 9, 0, 0)));
+}
+
+void test_next_time_wraps_across_month_and_year() {
+  slots[1] = {true, 6, 15, 50};
+  TEST_ASSERT_EQUAL_UINT32(at(2026, 1, 1, 6, 15, 0),
+                           next(at(2025, 12, 31, 23, 0, 0)));
+  TEST_ASSERT_EQUAL_UINT32(at(2024, 3, 1, 6, 15, 0),
+                           next(at(2024, 2, 29, 7, 0, 0)));
+}
+
+void test_next_time_same_minute_after_second_zero_is_tomorrow() {
+  slots[0] = {true, 8, 0, 50};
+  TEST_ASSERT_EQUAL_UINT32(at(2025, 1, 1, 8, 0, 0),
+                           next(at(2025, 1, 1, 8, 0, 0)));
+  TEST_ASSERT_EQUAL_UINT32(at(2025, 1, 2, 8, 0, 0),
+                           next(at(2025, 1, 1, 8, 0, 1)));
+}
+
+// 2025-01-06 is a Monday
+void test_weekday_mask_skips_other_days() {
+  slots[0] = {true, 8, 0, 50};
+  slots[0].days = 0x3E;  // Mon-Fri
+  TEST_ASSERT_EQUAL_INT(-1, due(at(2025, 1, 5, 8, 0, 0)));  // Sunday
+  TEST_ASSERT_EQUAL_INT(0,  due(at(2025, 1, 6, 8, 0, 0)));  // Monday
+  // Friday after the slot -> next is Monday
+  TEST_ASSERT_EQUAL_UINT32(at(2025, 1, 13, 8, 0, 0), next(at(2025, 1, 10, 9, 0, 0)));
+}
+
+void test_single_weekday_waits_a_full_week() {
+  slots[0] = {true, 8, 0, 50};
+  slots[0].days = 1 << 1;  // Monday only
+  TEST_ASSERT_EQUAL_UINT32(at(2025, 1, 13, 8, 0, 0), next(at(2025, 1, 6, 8, 0, 1)));
+}
+
+void test_interval_rule() {
+  slots[0] = {true, 6, 0, 20};
+  slots[0].everyMin = 90;
+  slots[0].untilMin = 21 * 60 + 45;
+  CompiledRule r = compiled(slots[0]);
+  TEST_ASSERT_EQUAL_INT(RULE_TIMES, r.kind);
+  TEST_ASSERT_EQUAL_UINT16(21 * 60, r.lastMin);  // last whole period before until
+
+  TEST_ASSERT_EQUAL_UINT32(at(2025, 1, 1, 7, 30, 0), ruleNextFire(r, at(2025, 1, 1, 6, 0, 1)));
+  TEST_ASSERT_EQUAL_UINT32(at(2025, 1, 1, 9, 0, 0),  ruleNextFire(r, at(2025, 1, 1, 9, 0, 0)));
+  TEST_ASSERT_EQUAL_UINT32(at(2025, 1, 1, 21, 0, 0), ruleNextFire(r, at(2025, 1, 1, 19, 31, 0)));
+  TEST_ASSERT_EQUAL_UINT32(at(2025, 1, 2, 6, 0, 0),  ruleNextFire(r, at(2025, 1, 1, 21, 0, 1)));
+  TEST_ASSERT_TRUE(ruleFiresAt(r, at(2025, 1, 1, 10, 30, 0)));
+  TEST_ASSERT_FALSE(ruleFiresAt(r, at(2025, 1, 1, 10, 0, 0)));
+  TEST_ASSERT_FALSE(ruleFiresAt(r, at(2025, 1, 1, 22, 0, 0)));
+}
+
+void test_interval_without_until_runs_to_end_of_day() {
+  slots[0] = {true, 0, 0, 20};
+  slots[0].everyMin = 8 * 60;
+  CompiledRule r = compiled(slots[0]);
+  TEST_ASSERT_EQUAL_UINT32(at(2025, 1, 1, 16, 0, 0), ruleNextFire(r, at(2025, 1, 1, 9, 0, 0)));
+  TEST_ASSERT_EQUAL_UINT32(at(2025, 1, 2, 0, 0, 0),  ruleNextFire(r, at(2025, 1, 1, 16, 0, 1)));
+}
+
+void test_split_portions_across_window() {
+  slots[0] = {true, 8, 0, 90};
+  slots[0].untilMin = 10 * 60;
+  slots[0].splits = 3;
+  CompiledRule r = compiled(slots[0]);
+  TEST_ASSERT_EQUAL_FLOAT(30.0f, r.portion);
+  TEST_ASSERT_TRUE(ruleFiresAt(r, at(2025, 1, 1, 8, 0, 0)));
+  TEST_ASSERT_TRUE(ruleFiresAt(r, at(2025, 1, 1, 9, 0, 0)));
+  TEST_ASSERT_TRUE(ruleFiresAt(r, at(2025, 1, 1, 10, 0, 0)));
+  TEST_ASSERT_FALSE(ruleFiresAt(r, at(2025, 1, 1, 11, 0, 0)));
+}
+
+void test_invalid_rules_rejected() {
+  FeedingSlot s = {true, 8, 0, 50};
+  CompiledRule r;
+  s.days = 0;
+  TEST_ASSERT_FALSE(compileRule(s, r));
+  TEST_ASSERT_EQUAL_INT(RULE_NONE, r.kind);
+  s.days = ALL_DAYS;
+  s.splits = 3;
+  s.untilMin = 8 * 60;  // split needs a window
+  TEST_ASSERT_FALSE(compileRule(s, r));
+  s.splits = 0;
+  s.everyMin = 30;
+  s.untilMin = 7 * 60;  // before the start
+  TEST_ASSERT_FALSE(compileRule(s, r));
+}
+
+void test_slot_edit_keeps_absent_fields() {
+  FeedingSlot s = {true, 8, 0, 50};
+  s.everyMin = 60;
+  s.untilMin = 12 * 60;
+  CompiledRule r = {};
+  SlotEdit e = {};
+  e.hour = 9;
+  e.minute = 15;
+  e.weight = 40;
+  e.has = SLOT_EDIT_CATCHUP;
+  e.catchUp = CATCHUP_SKIP;
+  TEST_ASSERT_NULL(applySlotEdit(s, e, r));
+  TEST_ASSERT_EQUAL_INT(9, s.hour);
+  TEST_ASSERT_EQUAL_UINT16(60, s.everyMin);
+  TEST_ASSERT_EQUAL_UINT16(12 * 60, s.untilMin);
+  TEST_ASSERT_EQUAL_UINT8(CATCHUP_SKIP, s.catchUp);
+  TEST_ASSERT_EQUAL_INT(RULE_TIMES, r.kind);
+  TEST_ASSERT_EQUAL_UINT16(9 * 60 + 15, r.firstMin);
+
+  e.weight = 0;  // disables
+  TEST_ASSERT_NULL(applySlotEdit(s, e, r));
+  TEST_ASSERT_FALSE(s.active);
+  TEST_ASSERT_EQUAL_INT(RULE_NONE, r.kind);
+}
+
+void test_slot_edit_rejected_leaves_slot() {
+  FeedingSlot s = {true, 8, 0, 50};
+  CompiledRule r = compiled(s);
+  SlotEdit e = {};
+  e.hour = 24;
+  e.weight = 50;
+  TEST_ASSERT_EQUAL_STRING("Invalid time", applySlotEdit(s, e, r));
+  e.hour = 10;
+  e.has = SLOT_EDIT_EVERY;
+  e.everyMin = -5;
+  TEST_ASSERT_EQUAL_STRING("Invalid recurrence", applySlotEdit(s, e, r));
+  e.has = SLOT_EDIT_CATCHUP;
+  e.catchUp = 7;
+  TEST_ASSERT_NOT_NULL(applySlotEdit(s, e, r));
+  e.has = SLOT_EDIT_CRON;
+  e.cron = "0 8 1 * *";  // day of month unsupported
+  TEST_ASSERT_EQUAL_STRING("Invalid recurrence rule", applySlotEdit(s, e, r));
+  TEST_ASSERT_EQUAL_INT(8, s.hour);
+  TEST_ASSERT_EQUAL_STRING("", s.cron);
+  TEST_ASSERT_EQUAL_UINT16(8 * 60, r.firstMin);
+}
+
+void test_cron_parse() {
+  CompiledRule r;
+  TEST_ASSERT_TRUE(parseCron("30 8,12-13 * * 1-5", r));
+  TEST_ASSERT_EQUAL_UINT32((1u << 8) | (1u << 12) | (1u << 13), r.hours);
+  TEST_ASSERT_TRUE(r.minutes == (1ULL << 30));
+  TEST_ASSERT_EQUAL_UINT8(0x3E, r.days);
+
+  TEST_ASSERT_TRUE(parseCron("*/15 */6 * * *", r));
+  TEST_ASSERT_TRUE(r.minutes == ((1ULL << 0) | (1ULL << 15) | (1ULL << 30) | (1ULL << 45)));
+  TEST_ASSERT_EQUAL_UINT32((1u << 0) | (1u << 6) | (1u << 12) | (1u << 18), r.hours);
+  TEST_ASSERT_EQUAL_UINT8(ALL_DAYS, r.days);
+
+  TEST_ASSERT_TRUE(parseCron("5/20 7 * * 0,7", r));
+  TEST_ASSERT_TRUE(r.minutes == ((1ULL << 5) | (1ULL << 25) | (1ULL << 45)));
+  TEST_ASSERT_EQUAL_UINT8(0x01, r.days);
+}
+
+void test_cron_rejects_unsupported() {
+  CompiledRule r;
+  TEST_ASSERT_FALSE(parseCron("0 8 1 * *", r));     // day of month
+  TEST_ASSERT_FALSE(parseCron("0 8 * 1 *", r));     // month
+  TEST_ASSERT_FALSE(parseCron("60 8 * * *", r));
+  TEST_ASSERT_FALSE(parseCron("0 24 * * *", r));
+  TEST_ASSERT_FALSE(parseCron("0 8 * *", r));
+  TEST_ASSERT_FALSE(parseCron("0 8 * * * *", r));
+  TEST_ASSERT_FALSE(parseCron("0 8-6 * * *", r));
+  TEST_ASSERT_FALSE(parseCron("0 8 * * mon", r));
+  TEST_ASSERT_FALSE(parseCron("0 8,\" * * *", r));
+}
+
+void test_cron_next_fire() {
+  CompiledRule r = compiled(cronSlot("30 8,18 * * 1-5", 40));
+  // Monday 08:30:00 exactly, then 18:30, then Tuesday
+  TEST_ASSERT_EQUAL_UINT32(at(2025, 1, 6, 8, 30, 0),  ruleNextFire(r, at(2025, 1, 6, 7, 0, 0)));
+  TEST_ASSERT_EQUAL_UINT32(at(2025, 1, 6, 18, 30, 0), ruleNextFire(r, at(2025, 1, 6, 8, 30, 1)));
+  TEST_ASSERT_EQUAL_UINT32(at(2025, 1, 7, 8, 30, 0),  ruleNextFire(r, at(2025, 1, 6, 19, 0, 0)));
+  // Friday evening -> Monday morning
+  TEST_ASSERT_EQUAL_UINT32(at(2025, 1, 13, 8, 30, 0), ruleNextFire(r, at(2025, 1, 10, 18, 31, 0)));
+  TEST_ASSERT_TRUE(ruleFiresAt(r, at(2025, 1, 6, 18, 30, 0)));
+  TEST_ASSERT_FALSE(ruleFiresAt(r, at(2025, 1, 5, 18, 30, 0)));
+}
+
+void test_cron_same_hour_later_minute() {
+  CompiledRule r = compiled(cronSlot("0,45 9 * * *", 40));
+  TEST_ASSERT_EQUAL_UINT32(at(2025, 1, 1, 9, 45, 0), ruleNextFire(r, at(2025, 1, 1, 9, 10, 0)));
+  TEST_ASSERT_EQUAL_UINT32(at(2025, 1, 2, 9, 0, 0),  ruleNextFire(r, at(2025, 1, 1, 9, 46, 0)));
+}
+
+void test_cron_slot_fires_via_due() {
+  slots[2] = cronSlot("0 */4 * * *", 25);
+  TEST_ASSERT_EQUAL_INT(2,  due(at(2025, 1, 1, 4, 0, 0)));
+  TEST_ASSERT_EQUAL_INT(-1, due(at(2025, 1, 1, 5, 0, 0)));
+  int slot = -1;
+  compileSlots(slots, rules, 3);
+  TEST_ASSERT_EQUAL_UINT32(at(2025, 1, 1, 8, 0, 0),
+                           nextFeedingTime(rules, 3, at(2025, 1, 1, 5, 0, 0), &slot));
+  TEST_ASSERT_EQUAL_INT(2, slot);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_unix_time_round_trip);
+  RUN_TEST(test_due_slot_fires_from_its_minute);
+  RUN_TEST(test_due_slot_not_lost_between_evaluations);
+  RUN_TEST(test_fires_once_per_occurrence);
+  RUN_TEST(test_rewound_marker_allows_refire);
+  RUN_TEST(test_inactive_or_empty_slots_never_fire);
+  RUN_TEST(test_same_minute_slots_both_fire);
+  RUN_TEST(test_unset_marker_starts_now);
+  RUN_TEST(test_clock_moved_back_restarts_marker);
+  RUN_TEST(test_catch_up_skip);
+  RUN_TEST(test_catch_up_late_within_window);
+  RUN_TEST(test_catch_up_proportional);
+  RUN_TEST(test_catch_up_policy_names);
+  RUN_TEST(test_only_latest_missed_occurrence_counts);
+  RUN_TEST(test_prev_fire);
+  RUN_TEST(test_next_time_none_when_no_slots);
+  RUN_TEST(test_next_time_later_today);
+  RUN_TEST(test_next_time_wraps_to_tomorrow);
+  RUN_TEST(test_next_time_wraps_across_month_and_year);
+  RUN_TEST(test_next_time_same_minute_after_second_zero_is_tomorrow);
+  RUN_TEST(test_weekday_mask_skips_other_days);
+  RUN_TEST(test_single_weekday_waits_a_full_week);
+  RUN_TEST(test_interval_rule);
+  RUN_TEST(test_interval_without_until_runs_to_end_of_day);
+  RUN_TEST(test_split_portions_across_window);
+  RUN_TEST(test_invalid_rules_rejected);
+  RUN_TEST(test_slot_edit_keeps_absent_fields);
+  RUN_TEST(test_slot_edit_rejected_leaves_slot);
+  RUN_TEST(test_cron_parse);
+  RUN_TEST(test_cron_rejects_unsupported);
+  RUN_TEST(test_cron_next_fire);
+  RUN_TEST(test_cron_same_hour_later_minute);
+  RUN_TEST(test_cron_slot_fires_via_due);
+  return UNITY_END();
+}
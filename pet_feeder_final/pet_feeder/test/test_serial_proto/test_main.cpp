@@ -0,0 +1,256 @@
+// Serial framing, TX ring and command decoding (lib/feeder_core/serial_proto.h).
+#include <unity.h>
+#include <string.h>
+#include "serial_proto.h"
+#include "dispense.h"
+
+static uint8_t ring[256];
+static SerialTx tx;
+static SerialRx rx;
+
+void setUp() {
+  initSerialTx(tx, ring, sizeof(ring));
+  initSerialRx(rx);
+}
+
+void tearDown() {}
+
+// Moves everything pending from the ring into the receiver, as the UART
+// would; returns the frames received (kept in `frames`, payloads copied).
+static uint8_t payloads[8][SERIAL_RX_MAX];
+static SerialFrame frames[8];
+
+static int deliver(SerialTx& from, SerialRx& to) {
+  int got = 0;
+  const uint8_t* p;
+  size_t n;
+  while ((n = serialTxPeek(from, &p)) > 0) {
+    for (size_t i = 0; i < n; i++) {
+      SerialFrame f;
+      if (serialRxByte(to, p[i], f) && got < 8) {
+        memcpy(payloads[got], f.payload, f.len);
+        frames[got] = f;
+        frames[got].payload = payloads[got];
+        got++;
+      }
+    }
+    serialTxConsume(from, n);
+  }
+  return got;
+}
+
+static float f32At(const uint8_t* p) {
+  float v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+void test_crc_reference_value() {
+  TEST_ASSERT_EQUAL_HEX16(0x29B1, crc16Ccitt((const uint8_t*)"123456789", 9));
+}
+
+void test_weight_sample_round_trip() {
+  TEST_ASSERT_TRUE(serialSendWeight(tx, 123456, -40000, 12.5f, 42, SW_FEEDING));
+  TEST_ASSERT_EQUAL_INT(1, deliver(tx, rx));
+  TEST_ASSERT_EQUAL_UINT8(SP_WEIGHT, frames[0].type);
+  TEST_ASSERT_EQUAL_UINT8(0, frames[0].seq);
+  TEST_ASSERT_EQUAL_UINT16(14, frames[0].len);
+  const uint8_t* p = frames[0].payload;
+  TEST_ASSERT_EQUAL_UINT32(123456, p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24);
+  int32_t raw;
+  memcpy(&raw, p + 4, 4);
+  TEST_ASSERT_EQUAL_INT32(-40000, raw);
+  TEST_ASSERT_EQUAL_FLOAT(12.5f, f32At(p + 8));
+  TEST_ASSERT_EQUAL_UINT8(42, p[12]);
+  TEST_ASSERT_EQUAL_UINT8(SW_FEEDING, p[13]);
+}
+
+void test_frame_never_contains_zero() {
+  uint8_t zeros[40] = {};
+  TEST_ASSERT_TRUE(serialSend(tx, SP_TEXT, zeros, sizeof(zeros)));
+  const uint8_t* p;
+  size_t n = serialTxPeek(tx, &p);
+  TEST_ASSERT_EQUAL_UINT8(0, p[0]);
+  TEST_ASSERT_EQUAL_UINT8(0, p[n - 1]);
+  for (size_t i = 1; i + 1 < n; i++) TEST_ASSERT_NOT_EQUAL(0, p[i]);
+  TEST_ASSERT_EQUAL_INT(1, deliver(tx, rx));
+  TEST_ASSERT_EQUAL_UINT16(40, frames[0].len);
+  TEST_ASSERT_EQUAL_UINT8(0, frames[0].payload[39]);
+}
+
+// Runs of 254+ non-zero bytes split into several COBS blocks
+void test_long_run_decodes() {
+  static uint8_t big[1024], storage[1200];
+  for (size_t i = 0; i < sizeof(big); i++) big[i] = (i % 300 == 299) ? 0 : (uint8_t)(i % 251 + 1);
+  SerialTx t;
+  initSerialTx(t, storage, sizeof(storage));
+  TEST_ASSERT_TRUE(serialSend(t, SP_STATUS, big, sizeof(big)));
+  TEST_ASSERT_TRUE(serialTxPending(t) <= serialFrameMax(sizeof(big)));
+
+  const uint8_t* p;
+  size_t n = serialTxPeek(t, &p);
+  static uint8_t block[1200];
+  memcpy(block, p + 1, n - 2);  // between the delimiters
+  size_t len = cobsDecode(block, n - 2);
+  TEST_ASSERT_EQUAL_UINT32(sizeof(big) + 4, len);
+  TEST_ASSERT_EQUAL_UINT8(SP_STATUS, block[0]);
+  TEST_ASSERT_EQUAL_MEMORY(big, block + 2, sizeof(big));
+}
+
+void test_full_ring_drops_whole_frames() {
+  int sent = 0;
+  while (serialSendWeight(tx, sent, 0, 0, 0, 0)) sent++;
+  TEST_ASSERT_TRUE(sent > 5);
+  TEST_ASSERT_EQUAL_UINT32(1, tx.dropped);
+  TEST_ASSERT_EQUAL_UINT32(sent, tx.frames);
+  // Every frame that went in comes out intact
+  int got = 0;
+  const uint8_t* p;
+  size_t n;
+  while ((n = serialTxPeek(tx, &p)) > 0) {
+    for (size_t i = 0; i < n; i++) {
+      SerialFrame f;
+      if (serialRxByte(rx, p[i], f)) got++;
+    }
+    serialTxConsume(tx, n);
+  }
+  TEST_ASSERT_EQUAL_INT(sent, got);
+  TEST_ASSERT_EQUAL_UINT32(0, rx.bad);
+}
+
+// Partial drains and wrap-around keep frames whole and in order
+void test_ring_wraps() {
+  for (int i = 0; i < 100; i++) {
+    TEST_ASSERT_TRUE(serialSendState(tx, i, SE_FEED_END, FEED_STUCK, -1, 50, 20));
+    // Hand the UART a few bytes at a time
+    while (serialTxPending(tx) > 0) {
+      const uint8_t* p;
+      size_t n = serialTxPeek(tx, &p);
+      if (n > 7) n = 7;
+      for (size_t k = 0; k < n; k++) {
+        SerialFrame f;
+        if (serialRxByte(rx, p[k], f)) {
+          TEST_ASSERT_EQUAL_UINT8(SP_STATE, f.type);
+          TEST_ASSERT_EQUAL_UINT8((uint8_t)i, f.seq);
+          TEST_ASSERT_EQUAL_UINT8(i, f.payload[0]);
+        }
+      }
+      serialTxConsume(tx, n);
+    }
+  }
+  TEST_ASSERT_EQUAL_UINT32(100, rx.frames);
+  TEST_ASSERT_EQUAL_UINT32(0, rx.bad);
+}
+
+// Console text and a corrupted frame are counted and skipped; the next
+// frame after the delimiter is received
+void test_resyncs_after_noise() {
+  const char* text = "Feeder closed (0 deg)\r\n";
+  SerialFrame f;
+  for (const char* c = text; *c; c++) TEST_ASSERT_FALSE(serialRxByte(rx, *c, f));
+
+  serialSendText(tx, "one", 3);
+  ring[3] ^= 0x20;  // inside the first frame
+  serialSendText(tx, "two", 3);
+  TEST_ASSERT_EQUAL_INT(1, deliver(tx, rx));
+  TEST_ASSERT_EQUAL_STRING_LEN("two", (const char*)frames[0].payload, 3);
+  TEST_ASSERT_EQUAL_UINT32(2, rx.bad);  // the text, the corrupted frame
+
+  // Longer than the receive buffer
+  for (int i = 0; i < 300; i++) serialRxByte(rx, 'x', f);
+  TEST_ASSERT_FALSE(serialRxByte(rx, 0, f));
+  TEST_ASSERT_EQUAL_UINT32(3, rx.bad);
+}
+
+// Commands are framed the same way in the other direction
+static bool command(uint8_t type, const SerialPayload& p, SerialCommand& out) {
+  SerialTx host;
+  uint8_t storage[128];
+  initSerialTx(host, storage, sizeof(storage));
+  host.seq = 77;
+  serialSend(host, type, p.data(), p.length());
+  if (deliver(host, rx) != 1) return false;
+  return parseSerialCommand(frames[0], out);
+}
+
+void test_parse_feed_and_refill() {
+  uint8_t buf[16];
+  SerialPayload p(buf, sizeof(buf));
+  p.f32(25.0f);
+  p.u8(DISPENSE_PULSE);
+  SerialCommand c;
+  TEST_ASSERT_TRUE(command(SPC_FEED, p, c));
+  TEST_ASSERT_EQUAL_UINT8(SPC_FEED, c.type);
+  TEST_ASSERT_EQUAL_UINT8(77, c.seq);
+  TEST_ASSERT_EQUAL_FLOAT(25.0f, c.grams);
+  TEST_ASSERT_EQUAL_UINT8(DISPENSE_PULSE, c.mode);
+
+  SerialPayload shortFeed(buf, sizeof(buf));
+  shortFeed.f32(25.0f);
+  TEST_ASSERT_FALSE(command(SPC_FEED, shortFeed, c));
+
+  SerialPayload refill(buf, sizeof(buf));
+  refill.f32(1500.0f);
+  TEST_ASSERT_TRUE(command(SPC_REFILL, refill, c));
+  TEST_ASSERT_EQUAL_FLOAT(1500.0f, c.grams);
+
+  SerialPayload none(buf, sizeof(buf));
+  TEST_ASSERT_TRUE(command(SPC_RESET, none, c));
+  TEST_ASSERT_FALSE(command(SP_WEIGHT, none, c));  // not a command
+}
+
+void test_parse_set_slot() {
+  uint8_t buf[64];
+  SerialPayload p(buf, sizeof(buf));
+  p.u8(2);
+  p.u8(7);
+  p.u8(30);
+  p.f32(45.0f);
+  p.u8(SLOT_EDIT_DAYS | SLOT_EDIT_CRON);
+  p.u8(0x3E);
+  p.u16(0);
+  p.u16(0);
+  p.u8(0);
+  p.u8(0);
+  p.u16(0);
+  p.str("30 7 * * 1-5");
+  SerialCommand c;
+  TEST_ASSERT_TRUE(command(SPC_SET_SLOT, p, c));
+  TEST_ASSERT_EQUAL_UINT8(2, c.slotIndex);
+  TEST_ASSERT_EQUAL_INT(7, c.slot.hour);
+  TEST_ASSERT_EQUAL_INT(30, c.slot.minute);
+  TEST_ASSERT_EQUAL_FLOAT(45.0f, c.slot.weight);
+  TEST_ASSERT_EQUAL_INT(0x3E, c.slot.days);
+  TEST_ASSERT_EQUAL_STRING("30 7 * * 1-5", c.slot.cron);
+
+  FeedingSlot slot = {false, 0, 0, 0};
+  CompiledRule rule;
+  TEST_ASSERT_NULL(applySlotEdit(slot, c.slot, rule));
+  TEST_ASSERT_EQUAL_INT(RULE_CRON, rule.kind);
+}
+
+void test_ack_carries_command() {
+  TEST_ASSERT_TRUE(serialSendAck(tx, 9, SPC_FEED, 202, "Queued (1 waiting)"));
+  TEST_ASSERT_EQUAL_INT(1, deliver(tx, rx));
+  const uint8_t* p = frames[0].payload;
+  TEST_ASSERT_EQUAL_UINT8(9, p[0]);
+  TEST_ASSERT_EQUAL_UINT8(SPC_FEED, p[1]);
+  TEST_ASSERT_EQUAL_UINT16(202, p[2] | p[3] << 8);
+  TEST_ASSERT_EQUAL_UINT16(4 + 18, frames[0].len);
+  TEST_ASSERT_EQUAL_STRING_LEN("Queued (1 waiting)", (const char*)p + 4, 18);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_crc_reference_value);
+  RUN_TEST(test_weight_sample_round_trip);
+  RUN_TEST(test_frame_never_contains_zero);
+  RUN_TEST(test_long_run_decodes);
+  RUN_TEST(test_full_ring_drops_whole_frames);
+  RUN_TEST(test_ring_wraps);
+  RUN_TEST(test_resyncs_after_noise);
+  RUN_TEST(test_parse_feed_and_refill);
+  RUN_TEST(test_parse_set_slot);
+  RUN_TEST(test_ack_carries_command);
+  return UNITY_END();
+}
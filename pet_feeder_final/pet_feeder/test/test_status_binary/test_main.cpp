@@ -0,0 +1,226 @@
+// CBOR / MessagePack status documents (status_binary.h).
+#include <unity.h>
+#include <string.h>
+#include "feeder_time.h"
+#include "status_binary.h"
+
+static FeedingSlot slots[3];
+static FeedLogEntry log_[10];
+static int logCount;
+static StatusView view;
+static StatusVersions versions;
+static uint8_t out[statusJsonCapacity(3, 10)];
+static char json[statusJsonCapacity(3, 10)];
+
+// ---- Minimal readers: enough to walk the documents and check values ----
+
+struct Item {
+  int      type;   // 'u' uint, 'n' negative, 's' str, 'a' array, 'm' map, 'b' bool, 'z' null
+  uint32_t arg;    // value, length or count
+  size_t   next;   // offset after the head (and string bytes)
+};
+
+static uint32_t be(const uint8_t* p, int n) {
+  uint32_t v = 0;
+  for (int i = 0; i < n; i++) v = (v << 8) | p[i];
+  return v;
+}
+
+static Item readCbor(const uint8_t* p, size_t at) {
+  uint8_t ib = p[at++];
+  uint8_t major = ib >> 5, info = ib & 31;
+  Item it = {0, 0, 0};
+  if (major == 7) {
+    it.type = info == 22 ? 'z' : 'b';
+    it.arg = info == 21;
+    it.next = at;
+    return it;
+  }
+  if (info < 24)       it.arg = info;
+  else if (info == 24) { it.arg = p[at]; at += 1; }
+  else if (info == 25) { it.arg = be(p + at, 2); at += 2; }
+  else                 { it.arg = be(p + at, 4); at += 4; }
+  static const int kTypes[] = {'u', 'n', '?', 's', 'a', 'm'};
+  it.type = kTypes[major];
+  it.next = at + (it.type == 's' ? it.arg : 0);
+  return it;
+}
+
+static Item readMsgpack(const uint8_t* p, size_t at) {
+  uint8_t b = p[at++];
+  Item it = {0, 0, 0};
+  if (b < 0x80)                 { it.type = 'u'; it.arg = b; }
+  else if (b >= 0xe0)           { it.type = 'n'; it.arg = (uint32_t)(-1 - (int8_t)b); }
+  else if ((b & 0xf0) == 0x80)  { it.type = 'm'; it.arg = b & 15; }
+  else if ((b & 0xf0) == 0x90)  { it.type = 'a'; it.arg = b & 15; }
+  else if ((b & 0xe0) == 0xa0)  { it.type = 's'; it.arg = b & 31; }
+  else if (b == 0xc0)           { it.type = 'z'; }
+  else if (b == 0xc2 || b == 0xc3) { it.type = 'b'; it.arg = b == 0xc3; }
+  else if (b == 0xcc)           { it.type = 'u'; it.arg = p[at]; at += 1; }
+  else if (b == 0xcd)           { it.type = 'u'; it.arg = be(p + at, 2); at += 2; }
+  else if (b == 0xce)           { it.type = 'u'; it.arg = be(p + at, 4); at += 4; }
+  else if (b == 0xd0)           { it.type = 'n'; it.arg = (uint32_t)(-1 - (int8_t)p[at]); at += 1; }
+  else if (b == 0xd1)           { it.type = 'n'; it.arg = (uint32_t)(-1 - (int16_t)be(p + at, 2)); at += 2; }
+  else if (b == 0xd9)           { it.type = 's'; it.arg = p[at]; at += 1; }
+  else if (b == 0xdc)           { it.type = 'a'; it.arg = be(p + at, 2); at += 2; }
+  else                          { it.type = '?'; }
+  it.next = at + (it.type == 's' ? it.arg : 0);
+  return it;
+}
+
+static Item readItem(WireFormat f, size_t at) {
+  return f == WIRE_CBOR ? readCbor(out, at) : readMsgpack(out, at);
+}
+
+// Offset past the complete item at `at`
+static size_t skip(WireFormat f, size_t at) {
+  Item it = readItem(f, at);
+  TEST_ASSERT_NOT_EQUAL('?', it.type);
+  size_t next = it.next;
+  uint32_t children = it.type == 'a' ? it.arg : it.type == 'm' ? 2 * it.arg : 0;
+  for (uint32_t i = 0; i < children; i++) next = skip(f, next);
+  return next;
+}
+
+// Offset of the value for integer `key` in the top-level map, 0 if absent
+static size_t findKey(WireFormat f, uint32_t key) {
+  Item m = readItem(f, 0);
+  TEST_ASSERT_EQUAL('m', m.type);
+  size_t at = m.next;
+  for (uint32_t i = 0; i < m.arg; i++) {
+    Item k = readItem(f, at);
+    if (k.type == 'u' && k.arg == key) return k.next;
+    at = skip(f, k.next);
+  }
+  return 0;
+}
+
+void setUp() {
+  slots[0] = {true,   8, 0, 50};
+  slots[1] = {false, 12, 0, 0};
+  slots[2] = {true,  18, 30, 120};
+  logCount = 0;
+  clearFeedLog(log_, 10, logCount);
+  for (int i = 0; i < 10; i++) {
+    FeedLogEntry e = {};
+    e.manual = (i % 3 == 0);
+    e.slotIndex = e.manual ? -1 : i % 3;
+    e.hour = 8 + i; e.minute = 5 * i;
+    e.target = 100 + i; e.finalWeight = 98 + i;
+    pushFeedLog(log_, 10, logCount, e);
+  }
+
+  view = {};
+  view.weight        = 12.34f;
+  view.feedingActive = false;
+  view.nextFeed      = unixTime(2025, 1, 1, 18, 30, 0);
+  view.slots         = slots;
+  view.slotCount     = 3;
+  view.log           = log_;
+  view.logCount      = logCount;
+  initStatusVersions(versions, 0x1a2b);
+}
+
+void tearDown() {}
+
+void test_live_document_bytes() {
+  uint8_t expectCbor[] = {0xa3, 0x01, 0x18, 0x7b, 0x02, 0xf4, 0x00,
+                          0x66, '1', 'a', '2', 'b', '-', '1'};
+  size_t n = writeLiveBinary(out, sizeof(out), 12.34f, false, versions, WIRE_CBOR);
+  TEST_ASSERT_EQUAL_size_t(sizeof(expectCbor), n);
+  TEST_ASSERT_EQUAL_MEMORY(expectCbor, out, n);
+
+  uint8_t expectMsgpack[] = {0x83, 0x01, 0x7b, 0x02, 0xc2, 0x00,
+                             0xa6, '1', 'a', '2', 'b', '-', '1'};
+  n = writeLiveBinary(out, sizeof(out), 12.34f, false, versions, WIRE_MSGPACK);
+  TEST_ASSERT_EQUAL_size_t(sizeof(expectMsgpack), n);
+  TEST_ASSERT_EQUAL_MEMORY(expectMsgpack, out, n);
+}
+
+static void checkFullDocument(WireFormat f) {
+  size_t n = writeStatusBinary(out, sizeof(out), view, f);
+  TEST_ASSERT_GREATER_THAN(0, n);
+  TEST_ASSERT_EQUAL_size_t(n, skip(f, 0));  // well-formed, nothing trailing
+
+  Item weight = readItem(f, findKey(f, SK_WEIGHT));
+  TEST_ASSERT_EQUAL('u', weight.type);
+  TEST_ASSERT_EQUAL_UINT32(123, weight.arg);
+
+  Item next = readItem(f, findKey(f, SK_NEXT));
+  TEST_ASSERT_EQUAL_UINT32(unixTime(2025, 1, 1, 18, 30, 0), next.arg);
+
+  Item slotsArr = readItem(f, findKey(f, SK_SLOTS));
+  TEST_ASSERT_EQUAL('a', slotsArr.type);
+  TEST_ASSERT_EQUAL_UINT32(3, slotsArr.arg);
+  Item slot0 = readItem(f, slotsArr.next);
+  TEST_ASSERT_EQUAL('m', slot0.type);
+  TEST_ASSERT_EQUAL_UINT32(4, slot0.arg);  // defaults only
+
+  Item hist = readItem(f, findKey(f, SK_HISTORY));
+  TEST_ASSERT_EQUAL_UINT32(10, hist.arg);
+  Item entry = readItem(f, hist.next);
+  TEST_ASSERT_EQUAL_UINT32(4, entry.arg);
+  Item minute = readItem(f, entry.next);
+  TEST_ASSERT_EQUAL_UINT32(17 * 60 + 45, minute.arg);  // newest first
+
+  TEST_ASSERT_EQUAL(0, findKey(f, SK_HOPPER));
+  TEST_ASSERT_EQUAL(0, findKey(f, SK_VERSION));
+}
+
+void test_full_document_cbor() {
+  checkFullDocument(WIRE_CBOR);
+}
+
+void test_full_document_msgpack() {
+  checkFullDocument(WIRE_MSGPACK);
+}
+
+void test_smaller_than_json() {
+  size_t j = writeStatusJson(json, sizeof(json), view);
+  size_t c = writeStatusBinary(out, sizeof(out), view, WIRE_CBOR);
+  size_t m = writeStatusBinary(out, sizeof(out), view, WIRE_MSGPACK);
+  TEST_ASSERT_TRUE(c < j / 2);
+  TEST_ASSERT_TRUE(m < j / 2);
+}
+
+void test_delta_sections_and_hopper() {
+  HopperState h;
+  initHopper(h, 2000);
+  hopperRefill(h, 1500, 0);
+  HopperForecast fc = {NO_FEEDING_TIME, 9, false};
+  view.hopper = &h;
+  view.hopperForecast = &fc;
+  bumpStatusVersion(versions, versions.state);
+  uint32_t since = versions.state - 1;
+
+  const WireFormat formats[] = {WIRE_CBOR, WIRE_MSGPACK};
+  for (WireFormat f : formats) {
+    size_t n = writeStatusDeltaBinary(out, sizeof(out), view, versions, since, f);
+    TEST_ASSERT_EQUAL_size_t(n, skip(f, 0));
+    TEST_ASSERT_EQUAL_UINT32(4, readItem(f, 0).arg);  // version + state fields
+    TEST_ASSERT_NOT_EQUAL(0, findKey(f, SK_VERSION));
+    TEST_ASSERT_EQUAL(0, findKey(f, SK_SLOTS));
+    TEST_ASSERT_EQUAL(0, findKey(f, SK_HISTORY));
+
+    Item hopper = readItem(f, findKey(f, SK_HOPPER));
+    TEST_ASSERT_EQUAL('m', hopper.type);
+    TEST_ASSERT_EQUAL_UINT32(6, hopper.arg);
+    TEST_ASSERT_EQUAL('u', readItem(f, findKey(f, SK_NEXT)).type);
+  }
+}
+
+void test_overflow_returns_zero() {
+  TEST_ASSERT_EQUAL(0, writeStatusBinary(out, 16, view, WIRE_CBOR));
+  TEST_ASSERT_EQUAL(0, writeStatusBinary(out, 16, view, WIRE_MSGPACK));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_live_document_bytes);
+  RUN_TEST(test_full_document_cbor);
+  RUN_TEST(test_full_document_msgpack);
+  RUN_TEST(test_smaller_than_json);
+  RUN_TEST(test_delta_sections_and_hopper);
+  RUN_TEST(test_overflow_returns_zero);
+  return UNITY_END();
+}
@@ -0,0 +1,133 @@
+// Shared rendered status documents (status_cache.h).
+#include <unity.h>
+#include <string.h>
+#include "feeder_time.h"
+#include "status_cache.h"
+
+static const size_t ENTRY_CAP = statusJsonCapacity(3, 10);
+static char storage[STATUS_CACHE_ENTRIES * ENTRY_CAP];
+static StatusCache cache;
+static FeedingSlot slots[3];
+static FeedLogEntry log_[10];
+static StatusView view;
+static StatusVersions v;
+
+void setUp() {
+  slots[0] = {true,   8, 0, 50};
+  slots[1] = {false, 12, 0, 0};
+  slots[2] = {true,  18, 30, 120};
+  int count = 0;
+  clearFeedLog(log_, 10, count);
+  view = {12.34f, false, unixTime(2025, 1, 1, 18, 30, 0), slots, 3, log_, 0, nullptr, nullptr};
+  initStatusVersions(v, 0xbeef);
+  initStatusCache(cache, storage, ENTRY_CAP);
+}
+
+void tearDown() {}
+
+void test_same_request_renders_once() {
+  const StatusCacheEntry* a = statusCacheDelta(cache, view, v, 0);
+  TEST_ASSERT_NOT_NULL(a);
+  char expected[ENTRY_CAP];
+  TEST_ASSERT_EQUAL_size_t(writeStatusDelta(expected, sizeof(expected), view, v, 0), a->len);
+  TEST_ASSERT_EQUAL_STRING(expected, a->buf);
+
+  slots[0].weight = 999;  // not a versioned change: the cached bytes stay
+  const StatusCacheEntry* b = statusCacheDelta(cache, view, v, 0);
+  TEST_ASSERT_EQUAL_PTR(a, b);
+  TEST_ASSERT_EQUAL_STRING(expected, b->buf);
+  TEST_ASSERT_EQUAL_UINT32(1, cache.misses);
+  TEST_ASSERT_EQUAL_UINT32(1, cache.hits);
+}
+
+void test_equivalent_since_values_share_an_entry() {
+  bumpStatusVersion(v, v.state);     // 2
+  bumpStatusVersion(v, v.schedule);  // 3
+  bumpStatusVersion(v, v.history);   // 4
+  // 3 and anything between history's previous and current version need history only
+  const StatusCacheEntry* a = statusCacheDelta(cache, view, v, 3);
+  TEST_ASSERT_EQUAL_UINT8(SECTION_HISTORY, a->sections);
+  statusCacheDelta(cache, view, v, 3);
+  TEST_ASSERT_EQUAL_UINT32(1, cache.hits);
+  TEST_ASSERT_EQUAL_UINT8(SECTION_STATE | SECTION_SCHEDULE | SECTION_HISTORY,
+                          statusSectionsSince(v, 0));
+}
+
+void test_version_change_rerenders() {
+  const StatusCacheEntry* a = statusCacheDelta(cache, view, v, 0);
+  TEST_ASSERT_NOT_NULL(strstr(a->buf, "\"feedingActive\":false"));
+  view.feedingActive = true;
+  bumpStatusVersion(v, v.state);
+  const StatusCacheEntry* b = statusCacheDelta(cache, view, v, 0);
+  TEST_ASSERT_NOT_NULL(strstr(b->buf, "\"feedingActive\":true"));
+  TEST_ASSERT_EQUAL_UINT32(2, cache.misses);
+}
+
+void test_full_document_keyed_on_weight() {
+  const StatusCacheEntry* a = statusCacheFull(cache, view, v);
+  TEST_ASSERT_NOT_NULL(strstr(a->buf, "\"weight\":12.3,"));
+  view.weight = 12.31f;  // same rendered value
+  statusCacheFull(cache, view, v);
+  TEST_ASSERT_EQUAL_UINT32(1, cache.hits);
+  view.weight = 15.0f;
+  const StatusCacheEntry* b = statusCacheFull(cache, view, v);
+  TEST_ASSERT_NOT_NULL(strstr(b->buf, "\"weight\":15.0,"));
+}
+
+void test_least_recently_used_entry_replaced() {
+  bumpStatusVersion(v, v.state);
+  bumpStatusVersion(v, v.history);
+  const StatusCacheEntry* all = statusCacheDelta(cache, view, v, 0);
+  statusCacheDelta(cache, view, v, v.state);  // history only
+  statusCacheFull(cache, view, v);
+  statusCacheDelta(cache, view, v, 0);        // touch "all"
+  view.weight = 50;
+  statusCacheFull(cache, view, v);            // evicts history-only
+  TEST_ASSERT_EQUAL_PTR(all, statusCacheDelta(cache, view, v, 0));
+  uint32_t misses = cache.misses;
+  statusCacheDelta(cache, view, v, v.state);
+  TEST_ASSERT_EQUAL_UINT32(misses + 1, cache.misses);
+}
+
+void test_formats_cached_separately() {
+  const StatusCacheEntry* j = statusCacheDelta(cache, view, v, 0);
+  const StatusCacheEntry* c = statusCacheDelta(cache, view, v, 0, WIRE_CBOR);
+  TEST_ASSERT_TRUE(j != c);
+  TEST_ASSERT_EQUAL_UINT32(2, cache.misses);
+
+  uint8_t expected[ENTRY_CAP];
+  size_t n = writeStatusDeltaBinary(expected, sizeof(expected), view, v, 0, WIRE_CBOR);
+  TEST_ASSERT_EQUAL_size_t(n, c->len);
+  TEST_ASSERT_EQUAL_MEMORY(expected, c->buf, n);
+
+  TEST_ASSERT_EQUAL_PTR(c, statusCacheDelta(cache, view, v, 0, WIRE_CBOR));
+  TEST_ASSERT_EQUAL_PTR(j, statusCacheDelta(cache, view, v, 0));
+  TEST_ASSERT_EQUAL_UINT32(2, cache.hits);
+}
+
+void test_etag_follows_version() {
+  TEST_ASSERT_EQUAL_STRING("\"beef-1\"", statusCacheEtag(cache, v));
+  bumpStatusVersion(v, v.schedule);
+  TEST_ASSERT_EQUAL_STRING("\"beef-2\"", statusCacheEtag(cache, v));
+}
+
+void test_too_small_entry_returns_null() {
+  StatusCache tiny;
+  char small[STATUS_CACHE_ENTRIES * 16];
+  initStatusCache(tiny, small, 16);
+  TEST_ASSERT_NULL(statusCacheDelta(tiny, view, v, 0));
+  TEST_ASSERT_NULL(statusCacheDelta(tiny, view, v, 0));  // not cached as empty
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_same_request_renders_once);
+  RUN_TEST(test_equivalent_since_values_share_an_entry);
+  RUN_TEST(test_version_change_rerenders);
+  RUN_TEST(test_full_document_keyed_on_weight);
+  RUN_TEST(test_least_recently_used_entry_replaced);
+  RUN_TEST(test_formats_cached_separately);
+  RUN_TEST(test_etag_follows_version);
+  RUN_TEST(test_too_small_entry_returns_null);
+  return UNITY_END();
+}
@@ -0,0 +1,424 @@
+// JSON document served by /api/status (status_json.h).
+#include <unity.h>
+#include <string.h>
+#include "feeder_time.h"
+#include "status_json.h"
+
+static FeedingSlot slots[3];
+static FeedLogEntry log_[10];
+static int logCount;
+static StatusView view;
+static char out[statusJsonCapacity(3, 10)];
+
+void setUp() {
+  slots[0] = {true,   8, 0, 50};
+  slots[1] = {false, 12, 0, 0};
+  slots[2] = {true,  18, 30, 120};
+  logCount = 0;
+  clearFeedLog(log_, 10, logCount);
+
+  view.weight        = 12.34f;
+  view.feedingActive = false;
+  view.nextFeed      = unixTime(2025, 1, 1, 18, 30, 0);
+  view.slots         = slots;
+  view.slotCount     = 3;
+  view.log           = log_;
+  view.logCount      = logCount;
+  view.hopper        = nullptr;
+  view.hopperForecast = nullptr;
+}
+
+void tearDown() {}
+
+void test_status_without_history() {
+  size_t n = writeStatusJson(out, sizeof(out), view);
+  TEST_ASSERT_EQUAL_STRING(
+      "{\"weight\":12.3,\"feedingActive\":false,\"nextTime\":\"18:30\","
+      "\"slots\":[{\"active\":true,\"hour\":8,\"minute\":0,\"weight\":50},"
+      "{\"active\":false,\"hour\":12,\"minute\":0,\"weight\":0},"
+      "{\"active\":true,\"hour\":18,\"minute\":30,\"weight\":120}],"
+      "\"history\":[]}",
+      out);
+  TEST_ASSERT_EQUAL_size_t(strlen(out), n);
+}
+
+void test_status_with_history() {
+  FeedLogEntry e = {};
+  e.manual = false; e.slotIndex = 0; e.hour = 8; e.minute = 0;
+  e.target = 62.4f; e.finalWeight = 64.9f;
+  pushFeedLog(log_, 10, logCount, e);
+  e.manual = true; e.slotIndex = -1; e.hour = 9; e.minute = 5;
+  e.target = 100; e.finalWeight = 98;
+  pushFeedLog(log_, 10, logCount, e);
+  view.logCount = logCount;
+  view.feedingActive = true;
+  view.nextFeed = NO_FEEDING_TIME;
+
+  writeStatusJson(out, sizeof(out), view);
+  const char* history = strstr(out, "\"history\"");
+  TEST_ASSERT_NOT_NULL(history);
+  TEST_ASSERT_EQUAL_STRING(
+      "\"history\":[{\"time\":\"09:05\",\"type\":\"Manual\",\"target\":100,\"final\":98},"
+      "{\"time\":\"08:00\",\"type\":\"Slot 1\",\"target\":62,\"final\":64}]}",
+      history);
+  TEST_ASSERT_NOT_NULL(strstr(out, "\"feedingActive\":true,\"nextTime\":\"None\","));
+}
+
+void test_full_history_fits_capacity() {
+  FeedLogEntry e = {};
+  e.slotIndex = 2; e.hour = 23; e.minute = 59; e.target = 9999; e.finalWeight = 9999;
+  for (int i = 0; i < 12; i++) pushFeedLog(log_, 10, logCount, e);
+  for (int i = 0; i < 3; i++) {
+    slots[i] = {true, 23, 59, 9999};
+    slots[i].days = 0x3E;
+    slots[i].everyMin = 1439;
+    slots[i].untilMin = 1439;
+    slots[i].splits = 99;
+    memset(slots[i].cron, '*', CRON_MAX - 1);
+    slots[i].cron[CRON_MAX - 1] = '\0';
+    slots[i].catchUp = CATCHUP_PROPORTIONAL;
+    slots[i].catchUpMin = 65535;
+  }
+  view.logCount = logCount;
+  view.weight = -9999.9f;
+  TEST_ASSERT_GREATER_THAN(0, writeStatusJson(out, sizeof(out), view));
+}
+
+void test_slot_rule_fields_only_when_set() {
+  slots[0].days = 0x3E;
+  slots[0].everyMin = 90;
+  slots[0].untilMin = 20 * 60;
+  slots[2].splits = 3;
+  slots[2].untilMin = 21 * 60;
+  strcpy(slots[1].cron, "0 */4 * * *");
+  slots[1].catchUp = CATCHUP_SKIP;
+  slots[2].catchUpMin = 90;
+  writeStatusJson(out, sizeof(out), view);
+  TEST_ASSERT_NOT_NULL(strstr(out,
+      "{\"active\":true,\"hour\":8,\"minute\":0,\"weight\":50,"
+      "\"days\":62,\"every\":90,\"until\":1200},"
+      "{\"active\":false,\"hour\":12,\"minute\":0,\"weight\":0,\"cron\":\"0 */4 * * *\",\"catchUp\":\"skip\"},"
+      "{\"active\":true,\"hour\":18,\"minute\":30,\"weight\":120,\"until\":1260,\"splits\":3,\"catchUpMin\":90}]"));
+}
+
+// A cron rule sent with tabs between its fields is served as valid JSON
+void test_tab_separated_cron_served_with_spaces() {
+  SlotEdit e = {};
+  e.hour = 12;
+  e.weight = 30;
+  e.has = SLOT_EDIT_CRON;
+  e.cron = "\t15,45\t6-22/2 *  *\t0,6 ";
+  CompiledRule rule;
+  TEST_ASSERT_NULL(applySlotEdit(slots[1], e, rule));
+  writeStatusJson(out, sizeof(out), view);
+  TEST_ASSERT_NULL(strchr(out, '\t'));
+  TEST_ASSERT_NOT_NULL(strstr(out, ",\"cron\":\"15,45 6-22/2 * * 0,6\"}"));
+}
+
+void test_overflow_returns_zero() {
+  char small[32];
+  TEST_ASSERT_EQUAL_size_t(0, writeStatusJson(small, sizeof(small), view));
+}
+
+void test_hopper_fields_in_state() {
+  HopperState h;
+  initHopper(h, 2000);
+  HopperForecast f = {NO_FEEDING_TIME, 0, false};
+  view.hopper = &h;
+  view.hopperForecast = &f;
+
+  writeStatusJson(out, sizeof(out), view);
+  TEST_ASSERT_NOT_NULL(strstr(out, "\"nextTime\":\"18:30\",\"hopper\":{\"known\":false},\"slots\""));
+
+  hopperRefill(h, 1500, 0);
+  hopperDispensed(h, 12.34f);
+  f.emptyAt = unixTime(2025, 1, 3, 8, 0, 0);
+  f.feedsLeft = 7;
+  f.low = true;
+  writeStatusJson(out, sizeof(out), view);
+  TEST_ASSERT_NOT_NULL(strstr(out,
+      "\"hopper\":{\"known\":true,\"remaining\":1487.7,\"capacity\":2000,"
+      "\"feedsLeft\":7,\"emptyAt\":1735891200,\"low\":true}"));
+
+  f.emptyAt = NO_FEEDING_TIME;
+  f.low = false;
+  writeStatusJson(out, sizeof(out), view);
+  TEST_ASSERT_NOT_NULL(strstr(out, "\"emptyAt\":null,\"low\":false}"));
+}
+
+void test_version_token_round_trip() {
+  StatusVersions v;
+  initStatusVersions(v, 0x1a2b);
+  bumpStatusVersion(v, v.history);
+  char token[STATUS_VERSION_MAX];
+  formatStatusVersion(token, sizeof(token), v);
+  TEST_ASSERT_EQUAL_STRING("1a2b-2", token);
+
+  uint32_t since = 99;
+  TEST_ASSERT_TRUE(parseStatusVersion("1a2b-1", v, since));
+  TEST_ASSERT_EQUAL_UINT32(1, since);
+  TEST_ASSERT_TRUE(parseStatusVersion("\"1a2b-2\"", v, since));
+  TEST_ASSERT_EQUAL_UINT32(2, since);
+  TEST_ASSERT_TRUE(parseStatusVersion("W/\"1a2b-2\"", v, since));
+}
+
+void test_version_token_rejects_other_boot_or_garbage() {
+  StatusVersions v;
+  initStatusVersions(v, 0x1a2b);
+  uint32_t since = 0;
+  TEST_ASSERT_FALSE(parseStatusVersion("0001-1", v, since));
+  TEST_ASSERT_FALSE(parseStatusVersion("1a2b-5", v, since));  // newer than clock
+  TEST_ASSERT_FALSE(parseStatusVersion("1a2b", v, since));
+  TEST_ASSERT_FALSE(parseStatusVersion("", v, since));
+  TEST_ASSERT_FALSE(parseStatusVersion("1a2b-1x", v, since));
+  TEST_ASSERT_FALSE(parseStatusVersion(nullptr, v, since));
+}
+
+void test_delta_contains_only_changed_sections() {
+  StatusVersions v;
+  initStatusVersions(v, 0x00ff);
+  uint32_t since = v.clock;
+  TEST_ASSERT_FALSE(statusChangedSince(v, since));
+
+  bumpStatusVersion(v, v.schedule);
+  TEST_ASSERT_TRUE(statusChangedSince(v, since));
+  writeStatusDelta(out, sizeof(out), view, v, since);
+  TEST_ASSERT_EQUAL_STRING(
+      "{\"version\":\"00ff-2\","
+      "\"slots\":[{\"active\":true,\"hour\":8,\"minute\":0,\"weight\":50},"
+      "{\"active\":false,\"hour\":12,\"minute\":0,\"weight\":0},"
+      "{\"active\":true,\"hour\":18,\"minute\":30,\"weight\":120}]}",
+      out);
+
+  since = v.clock;
+  bumpStatusVersion(v, v.state);
+  writeStatusDelta(out, sizeof(out), view, v, since);
+  TEST_ASSERT_EQUAL_STRING(
+      "{\"version\":\"00ff-3\",\"feedingActive\":false,\"nextTime\":\"18:30\"}", out);
+}
+
+void test_delta_from_zero_has_every_section() {
+  StatusVersions v;
+  initStatusVersions(v, 1);
+  writeStatusDelta(out, sizeof(out), view, v, 0);
+  TEST_ASSERT_NOT_NULL(strstr(out, "\"feedingActive\""));
+  TEST_ASSERT_NOT_NULL(strstr(out, "\"slots\""));
+  TEST_ASSERT_NOT_NULL(strstr(out, "\"history\""));
+  TEST_ASSERT_NULL(strstr(out, "\"weight\":12.3"));
+}
+
+void test_live_document() {
+  StatusVersions v;
+  initStatusVersions(v, 0xbeef);
+  char live[LIVE_JSON_MAX];
+  TEST_ASSERT_GREATER_THAN(0, writeLiveJson(live, sizeof(live), -0.04f, true, v));
+  TEST_ASSERT_EQUAL_STRING(
+      "{\"weight\":-0.0,\"feedingActive\":true,\"version\":\"beef-1\"}", live);
+  v.clock = 0xFFFFFFFF;
+  TEST_ASSERT_GREATER_THAN(0, writeLiveJson(live, sizeof(live), -99999.9f, false, v));
+}
+
+void test_queue_document_in_dispatch_order() {
+  FeedCommand storage[3];
+  FeedQueue q;
+  initFeedQueue(q, storage, 3);
+  FeedCommand c = {};
+  c.maxWaitMs = 60000;
+  c.source = FEED_SRC_API;       c.slotIndex = -1; c.amount = 30; c.enqueuedMs = 1000;
+  enqueueFeed(q, c);
+  c.source = FEED_SRC_SCHEDULED; c.slotIndex = 1;  c.amount = 20; c.enqueuedMs = 2000;
+  enqueueFeed(q, c);
+  enqueueFeed(q, c);
+
+  char json[queueJsonCapacity(3)];
+  TEST_ASSERT_GREATER_THAN(0, writeQueueJson(json, sizeof(json), q, true, 5000));
+  TEST_ASSERT_EQUAL_STRING(
+      "{\"feedingActive\":true,\"depth\":2,\"capacity\":3,"
+      "\"oldestWaitMs\":4000,\"lastWaitMs\":0,\"maxWaitMs\":0,"
+      "\"coalesced\":1,\"expired\":0,\"dropped\":0,\"items\":["
+      "{\"source\":\"scheduled\",\"slot\":2,\"amount\":40,\"merged\":1,\"waitMs\":3000},"
+      "{\"source\":\"api\",\"slot\":0,\"amount\":30,\"merged\":0,\"waitMs\":4000}]}",
+      json);
+}
+
+void test_full_queue_document_fits_capacity() {
+  FeedCommand storage[8];
+  FeedQueue q;
+  initFeedQueue(q, storage, 8);
+  q.coalesced = q.expired = q.dropped = q.lastWaitMs = q.maxWaitMs = 0xFFFFFFFF;
+  for (int i = 0; i < 8; i++) {
+    FeedCommand c = {FEED_SRC_MANUAL, -1, 0, -99999.0f - i, 1, 60000, 0};
+    enqueueFeed(q, c);
+  }
+  q.items[0].merged = 255;
+  char json[queueJsonCapacity(8)];
+  TEST_ASSERT_GREATER_THAN(0, writeQueueJson(json, sizeof(json), q, false, 0));
+}
+
+void test_loop_document() {
+  LoopStats ls;
+  resetLoopStats(ls);
+  char json[LOOP_JSON_MAX];
+  TEST_ASSERT_GREATER_THAN(0, writeLoopJson(json, sizeof(json), ls));
+  TEST_ASSERT_EQUAL_STRING(
+      "{\"periods\":0,\"minUs\":0,\"meanUs\":0,\"p50Us\":0,\"p99Us\":0,\"maxUs\":0}", json);
+  ls.periods = ls.minUs = ls.maxUs = 0xFFFFFFFF;
+  ls.sumUs = 0xFFFFFFFFFFFFFFFFull;
+  ls.buckets[LOOP_BUCKETS - 1] = 0xFFFFFFFF;
+  TEST_ASSERT_GREATER_THAN(0, writeLoopJson(json, sizeof(json), ls));
+}
+
+void test_flow_document() {
+  FlowStats fs;
+  initFlowStats(fs);
+  fs.feeds = 5;
+  fs.rateMean = 5.0f;
+  fs.rateVar = 0.25f;
+  fs.gapMeanMs = 480.4f;
+  fs.gapVar = 400.0f;
+  fs.noiseVar = 0.01f;
+  FeedLimits l = {10500, 860, 0.5f};
+  char json[FLOW_JSON_MAX];
+  TEST_ASSERT_GREATER_THAN(0, writeFlowJson(json, sizeof(json), fs, l));
+  TEST_ASSERT_EQUAL_STRING(
+      "{\"feeds\":5,\"rate\":5.00,\"rateSd\":0.50,\"p10Rate\":4.36,\"gapMs\":480,"
+      "\"gapSdMs\":20,\"noise\":0.10,\"limits\":{\"timeoutMs\":10500,"
+      "\"stuckWindowMs\":860,\"minIncrease\":0.50}}", json);
+
+  // Far beyond any real feeder still fits
+  fs.feeds = 65535;
+  fs.rateMean = fs.rateVar = fs.gapMeanMs = fs.gapVar = fs.noiseVar = 1e9f;
+  l = {0xFFFFFFFF, 0xFFFFFFFF, 1e9f};
+  TEST_ASSERT_GREATER_THAN(0, writeFlowJson(json, sizeof(json), fs, l));
+}
+
+void test_serial_document_fits() {
+  static uint8_t ring[64];
+  SerialTx tx;
+  SerialRx rx;
+  initSerialTx(tx, ring, sizeof(ring));
+  initSerialRx(rx);
+  serialSendText(tx, "hi", 2);
+  char json[SERIAL_JSON_MAX];
+  TEST_ASSERT_GREATER_THAN(0, writeSerialJson(json, sizeof(json), true, tx, rx));
+  TEST_ASSERT_EQUAL_STRING(
+      "{\"enabled\":true,\"binary\":true,\"txFrames\":1,\"txDropped\":0,\"txPending\":9,"
+      "\"txCapacity\":64,\"rxFrames\":0,\"rxBad\":0}", json);
+
+  tx.frames = tx.dropped = tx.cap = rx.frames = rx.bad = 0xFFFFFFFF;
+  TEST_ASSERT_GREATER_THAN(0, writeSerialJson(json, sizeof(json), false, tx, rx));
+}
+
+void test_ota_document_fits() {
+  OtaTrial trial = {1, 2, 0x170000};
+  OtaReport last = {OTA_OK, OTA_IMAGE_DELTA, 27695, 126120, 5400};
+  char json[OTA_JSON_MAX];
+  TEST_ASSERT_GREATER_THAN(0, writeOtaJson(json, sizeof(json), "app1", "app0", trial, last));
+  TEST_ASSERT_EQUAL_STRING(
+      "{\"running\":\"app1\",\"next\":\"app0\",\"trial\":true,\"trialBoots\":2,"
+      "\"last\":{\"kind\":\"delta\",\"result\":\"ok\",\"transferBytes\":27695,"
+      "\"imageBytes\":126120,\"ms\":5400}}", json);
+
+  // Longest labels (16 chars), result text and counters
+  last = {OTA_ERR_BASE, OTA_IMAGE_PACKED, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF};
+  trial.boots = 255;
+  TEST_ASSERT_GREATER_THAN(0, writeOtaJson(json, sizeof(json), "0123456789abcdef",
+                                           "0123456789abcdef", trial, last));
+}
+
+void test_calibration_document_fits() {
+  ScaleCal cal = {84312, 6532.25f, 1736150400};
+  CalCapture c;
+  startCalCapture(c, CAL_SPAN, 100.0f);
+  ZeroTracker z;
+  initZeroTracker(z, 0);
+  z.steps = 12;
+  z.trackedG = -0.6f;
+  char json[CALIBRATION_JSON_MAX];
+  TEST_ASSERT_GREATER_THAN(0, writeCalibrationJson(json, sizeof(json), cal, c, z));
+  TEST_ASSERT_EQUAL_STRING(
+      "{\"offset\":84312,\"countsPerGram\":6532.25,\"spanTime\":1736150400,"
+      "\"capture\":{\"step\":\"span\",\"result\":\"running\",\"massG\":100.0},"
+      "\"zeroTracking\":{\"steps\":12,\"trackedG\":-0.60}}", json);
+
+  // Widest counters, and a factor far beyond any load cell
+  cal = {INT32_MIN, -1e9f, 0xFFFFFFFF};
+  c.result = CAL_UNSTABLE;
+  c.massG = -1e9f;
+  z.steps = 0xFFFFFFFF;
+  z.trackedG = -1e9f;
+  TEST_ASSERT_GREATER_THAN(0, writeCalibrationJson(json, sizeof(json), cal, c, z));
+}
+
+void test_stats_document() {
+  static FeedRollups r;
+  initFeedRollups(r);
+  uint32_t monday = unixTime(2025, 1, 6, 8, 0, 0);
+  rollupFeed(r, monday - SECS_PER_DAY, 0, true, 40.0f, 1.0f);  // Sunday, the week before
+  rollupFeed(r, monday, 0, true, 42.0f, 3.0f);
+  rollupFeed(r, monday + 3600, -1, false, 5.0f, -15.0f);
+
+  static char json[statsJsonCapacity(2)];
+  TEST_ASSERT_GREATER_THAN(0, writeStatsJson(json, sizeof(json), r, 2, monday + 7200));
+  TEST_ASSERT_EQUAL_STRING(
+      "{\"date\":\"2025-01-06\",\"today\":{\"feeds\":2,\"aborts\":1,\"grams\":47.0},"
+      "\"thisWeek\":{\"from\":\"2025-01-06\",\"feeds\":2,\"aborts\":1,\"grams\":47.0},"
+      "\"days\":[{\"date\":\"2025-01-06\",\"feeds\":2,\"aborts\":1,\"grams\":47.0},"
+      "{\"date\":\"2025-01-05\",\"feeds\":1,\"aborts\":0,\"grams\":40.0}],"
+      "\"weeks\":[{\"from\":\"2025-01-06\",\"feeds\":2,\"aborts\":1,\"grams\":47.0},"
+      "{\"from\":\"2024-12-30\",\"feeds\":1,\"aborts\":0,\"grams\":40.0}],"
+      "\"slots\":[{\"slot\":1,\"feeds\":2,\"aborts\":0,\"grams\":82.0,"
+      "\"overshoot\":{\"n\":2,\"mean\":2.00,\"var\":2.00},"
+      "\"weekOvershoot\":{\"n\":1,\"mean\":3.00,\"var\":0.00}},"
+      "{\"slot\":2,\"feeds\":0,\"aborts\":0,\"grams\":0.0,"
+      "\"overshoot\":{\"n\":0,\"mean\":0.00,\"var\":0.00},"
+      "\"weekOvershoot\":{\"n\":0,\"mean\":0.00,\"var\":0.00}}],"
+      "\"manual\":{\"feeds\":1,\"aborts\":1,\"grams\":5.0,"
+      "\"overshoot\":{\"n\":0,\"mean\":0.00,\"var\":0.00},"
+      "\"weekOvershoot\":{\"n\":0,\"mean\":0.00,\"var\":0.00}}}", json);
+}
+
+// Every row in use, every counter at its widest
+void test_full_stats_document_fits_capacity() {
+  static FeedRollups r;
+  initFeedRollups(r);
+  uint32_t now = unixTime(2099, 12, 31, 12, 0, 0);
+  for (int i = 0; i < FEED_ROLLUP_WEEKS * 7; i++) {
+    rollupFeed(r, now - i * SECS_PER_DAY, i % FEED_ROLLUP_SLOTS, true, 1.0f, -1.0f);
+  }
+  for (PeriodRollup& p : r.days) p.feeds = p.aborts = 65535, p.dispensedG = 9999999.0f;
+  for (PeriodRollup& p : r.weeks) p.feeds = p.aborts = 65535, p.dispensedG = 9999999.0f;
+  for (SlotRollup& s : r.slots) {
+    s.feeds = s.aborts = 65535;
+    s.dispensedG = 9999999.0f;
+    s.allTime = s.thisWeek = {0xFFFFFFFF, -9999.99f, 9999999.0f};
+  }
+  static char json[statsJsonCapacity(FEED_ROLLUP_SLOTS)];
+  TEST_ASSERT_GREATER_THAN(0, writeStatsJson(json, sizeof(json), r, FEED_ROLLUP_SLOTS, now));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_status_without_history);
+  RUN_TEST(test_status_with_history);
+  RUN_TEST(test_full_history_fits_capacity);
+  RUN_TEST(test_slot_rule_fields_only_when_set);
+  RUN_TEST(test_tab_separated_cron_served_with_spaces);
+  RUN_TEST(test_overflow_returns_zero);
+  RUN_TEST(test_hopper_fields_in_state);
+  RUN_TEST(test_version_token_round_trip);
+  RUN_TEST(test_version_token_rejects_other_boot_or_garbage);
+  RUN_TEST(test_delta_contains_only_changed_sections);
+  RUN_TEST(test_delta_from_zero_has_every_section);
+  RUN_TEST(test_live_document);
+  RUN_TEST(test_queue_document_in_dispatch_order);
+  RUN_TEST(test_full_queue_document_fits_capacity);
+  RUN_TEST(test_loop_document);
+  RUN_TEST(test_flow_document);
+  RUN_TEST(test_serial_document_fits);
+  RUN_TEST(test_ota_document_fits);
+  RUN_TEST(test_calibration_document_fits);
+  RUN_TEST(test_stats_document);
+  RUN_TEST(test_full_stats_document_fits_capacity);
+  return UNITY_END();
+}
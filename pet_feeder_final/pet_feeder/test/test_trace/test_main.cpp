@@ -0,0 +1,99 @@
+// Trace ring ordering, wrap-around and dump helpers (trace.h).
+#include <unity.h>
+#include <string.h>
+#include "trace.h"
+
+static TraceRecord storage[8];
+static uint32_t fakeClock;
+
+static uint32_t clockFn() { return fakeClock; }
+static uint8_t contextFn() { return 1; }
+
+void setUp() {
+  fakeClock = 1000;
+  traceInit(storage, 8, clockFn, contextFn);
+}
+
+void tearDown() {}
+
+void test_records_in_write_order() {
+  traceRecord(TRACE_LOOP, TRACE_PH_BEGIN, 0);
+  fakeClock = 1500;
+  traceRecord(TRACE_LOOP, TRACE_PH_END, 0);
+
+  TraceRecord out[8];
+  TEST_ASSERT_EQUAL_UINT32(2, traceWritten());
+  TEST_ASSERT_EQUAL_UINT32(1, traceOldest());
+  TEST_ASSERT_EQUAL_UINT32(2, traceRead(traceOldest(), out, 8));
+  TEST_ASSERT_EQUAL_UINT32(1, out[0].seq);
+  TEST_ASSERT_EQUAL_UINT32(1000, out[0].timestampUs);
+  TEST_ASSERT_EQUAL_UINT8(TRACE_PH_BEGIN, out[0].phase);
+  TEST_ASSERT_EQUAL_UINT32(1500, out[1].timestampUs);
+  TEST_ASSERT_EQUAL_UINT8(TRACE_PH_END, out[1].phase);
+  TEST_ASSERT_EQUAL_UINT8(1, out[1].context);
+}
+
+void test_ring_keeps_newest_capacity_records() {
+  for (int i = 0; i < 20; i++) {
+    traceRecord(TRACE_WEIGHT, TRACE_PH_COUNTER, i);
+  }
+  TraceRecord out[8];
+  TEST_ASSERT_EQUAL_UINT32(13, traceOldest());
+  TEST_ASSERT_EQUAL_UINT32(8, traceRead(traceOldest(), out, 8));
+  for (int i = 0; i < 8; i++) {
+    TEST_ASSERT_EQUAL_UINT32(13 + i, out[i].seq);
+    TEST_ASSERT_EQUAL_INT32(12 + i, out[i].arg);
+  }
+}
+
+void test_overwritten_records_read_as_zero() {
+  for (int i = 0; i < 10; i++) traceRecord(TRACE_LOOP, TRACE_PH_INSTANT, i);
+  TraceRecord out[4];
+  // seq 1 and 2 are gone (their slots hold 9 and 10)
+  TEST_ASSERT_EQUAL_UINT32(4, traceRead(1, out, 4));
+  TEST_ASSERT_EQUAL_UINT32(0, out[0].seq);
+  TEST_ASSERT_EQUAL_UINT32(0, out[1].seq);
+  TEST_ASSERT_EQUAL_UINT32(3, out[2].seq);
+}
+
+void test_read_past_end_is_empty() {
+  traceRecord(TRACE_LOOP, TRACE_PH_INSTANT, 0);
+  TraceRecord out[4];
+  TEST_ASSERT_EQUAL_UINT32(0, traceRead(2, out, 4));
+  TEST_ASSERT_EQUAL_UINT32(0, traceRead(0, out, 4));
+}
+
+void test_scope_emits_begin_end_pair() {
+#if FEEDER_TRACE
+  {
+    TRACE_SCOPE(TRACE_SERVO_OPEN);
+    fakeClock = 1200;
+  }
+  TraceRecord out[2];
+  TEST_ASSERT_EQUAL_UINT32(2, traceRead(1, out, 2));
+  TEST_ASSERT_EQUAL_UINT16(TRACE_SERVO_OPEN, out[0].event);
+  TEST_ASSERT_EQUAL_UINT8(TRACE_PH_BEGIN, out[0].phase);
+  TEST_ASSERT_EQUAL_UINT16(TRACE_SERVO_OPEN, out[1].event);
+  TEST_ASSERT_EQUAL_UINT8(TRACE_PH_END, out[1].phase);
+  TEST_ASSERT_EQUAL_UINT32(1200, out[1].timestampUs);
+#endif
+}
+
+void test_name_table_lists_events() {
+  char buf[256];
+  uint32_t n = traceNameTable(buf, sizeof(buf));
+  TEST_ASSERT_EQUAL_size_t(strlen(buf), n);
+  TEST_ASSERT_EQUAL_STRING_LEN("1:loop\n2:handleClient\n", buf, 22);
+  TEST_ASSERT_EQUAL_STRING("hx711_read", traceEventName(TRACE_HX711_READ));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_records_in_write_order);
+  RUN_TEST(test_ring_keeps_newest_capacity_records);
+  RUN_TEST(test_overwritten_records_read_as_zero);
+  RUN_TEST(test_read_past_end_is_empty);
+  RUN_TEST(test_scope_emits_begin_end_pair);
+  RUN_TEST(test_name_table_lists_events);
+  return UNITY_END();
+}
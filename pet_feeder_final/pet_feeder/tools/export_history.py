@@ -0,0 +1,71 @@
+#!/usr/bin/env python3
+"""Download the feed/weight history from /api/export into one file.
+
+    python tools/export_history.py http://feeder.local -o history.ndjson
+    python tools/export_history.py http://localhost:8180 --format csv \\
+        --from 2025-06-01 --to 2025-07-01 -o june.csv
+
+The feeder serves one page per request and names the next one in the
+X-Next-Cursor header; this follows the cursors until a page comes back
+without one.
+"""
+
+import argparse
+import datetime
+import sys
+import urllib.parse
+import urllib.request
+
+
+def to_unix(text):
+    if text.isdigit():
+        return int(text)
+    dt = datetime.datetime.fromisoformat(text)
+    if dt.tzinfo is None:
+        dt = dt.replace(tzinfo=datetime.timezone.utc)
+    return int(dt.timestamp())
+
+
+def export(base, fmt, start, end, out):
+    params = {"format": fmt}
+    if start is not None:
+        params["from"] = start
+    if end is not None:
+        params["to"] = end
+
+    pages = 0
+    total = 0
+    while True:
+        url = base.rstrip("/") + "/api/export?" + urllib.parse.urlencode(params)
+        with urllib.request.urlopen(url, timeout=30) as r:
+            body = r.read()
+            cursor = r.headers.get("X-Next-Cursor")
+        out.write(body)
+        pages += 1
+        total += len(body)
+        if not cursor:
+            return pages, total
+        params["cursor"] = cursor
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__,
+                                 formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("base", help="feeder URL, e.g. http://localhost:8180")
+    ap.add_argument("--format", choices=["ndjson", "csv", "cbor", "msgpack"], default="ndjson")
+    ap.add_argument("--from", dest="start", help="Unix seconds or ISO date (UTC)")
+    ap.add_argument("--to", dest="end", help="Unix seconds or ISO date (UTC), inclusive")
+    ap.add_argument("-o", "--output", default="-", help="output file (default stdout)")
+    args = ap.parse_args()
+
+    start = to_unix(args.start) if args.start else None
+    end = to_unix(args.end) if args.end else None
+    out = sys.stdout.buffer if args.output == "-" else open(args.output, "wb")
+    pages, total = export(args.base, args.format, start, end, out)
+    if out is not sys.stdout.buffer:
+        out.close()
+    print("%d pages, %d bytes" % (pages, total), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,365 @@
+#!/usr/bin/env python3
+"""Talk to the feeder over its serial port with the binary protocol
+(lib/feeder_core/serial_proto.h): capture weight readings, or send the
+commands the HTTP API has. Needs pyserial for a live port.
+
+    python tools/feeder_serial.py /dev/ttyUSB0 capture -o feed.csv --raw feed.bin
+    python tools/feeder_serial.py /dev/ttyUSB0 feed 25 --profile pulse
+    python tools/feeder_serial.py /dev/ttyUSB0 set-slot 0 07:30 40 --cron "30 7 * * 1-5"
+    python tools/feeder_serial.py /dev/ttyUSB0 status
+    python tools/feeder_serial.py /dev/ttyUSB0 text         # back to the text console
+    python tools/feeder_serial.py feed.bin decode -o feed.csv
+
+The feeder switches to frames on the first command it receives, so every
+subcommand starts by sending one. `capture` streams every reading (or every
+--every'th) as CSV (ms, raw, grams, opening, feeding) until Ctrl-C or
+--seconds; console lines, state changes and frames lost on the way are
+reported on stderr. --raw keeps the bytes as received for `decode`.
+"""
+
+import argparse
+import json
+import struct
+import sys
+import time
+
+SP_TEXT, SP_WEIGHT, SP_STATE, SP_ACK, SP_STATUS, SP_LIVE = range(1, 7)
+SPC_STREAM, SPC_STATUS, SPC_LIVE, SPC_FEED, SPC_SET_SLOT, SPC_RESET, SPC_REFILL, SPC_TEXT = \
+    range(0x80, 0x88)
+
+EVENTS = ["feed-start", "feed-end", "reset"]
+MODES = ["full", "trickle", "pulse"]
+OUTCOMES = ["continue", "target", "stuck", "timeout"]
+CATCH_UP = ["skip", "late", "proportional"]
+MODE_DEFAULT = 0xFF
+
+SLOT_EDIT_DAYS, SLOT_EDIT_EVERY, SLOT_EDIT_UNTIL, SLOT_EDIT_SPLITS = 0x01, 0x02, 0x04, 0x08
+SLOT_EDIT_CATCHUP, SLOT_EDIT_CATCHUP_MIN, SLOT_EDIT_CRON = 0x10, 0x20, 0x40
+
+
+def crc16(data, crc=0xFFFF):
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+        crc &= 0xFFFF
+    return crc
+
+
+def cobs_encode(data):
+    out = bytearray([0])
+    code_at, code = 0, 1
+    for b in data:
+        if b == 0:
+            out[code_at] = code
+            code_at, code = len(out), 1
+            out.append(0)
+            continue
+        out.append(b)
+        code += 1
+        if code == 0xFF:
+            out[code_at] = code
+            code_at, code = len(out), 1
+            out.append(0)
+    out[code_at] = code
+    return bytes(out)
+
+
+def cobs_decode(block):
+    out = bytearray()
+    i = 0
+    while i < len(block):
+        code = block[i]
+        if code == 0 or i + code > len(block):
+            return None
+        out += block[i + 1:i + code]
+        i += code
+        if code < 0xFF and i < len(block):
+            out.append(0)
+    return bytes(out)
+
+
+def frame(msg_type, seq, payload=b""):
+    body = bytes([msg_type, seq]) + payload
+    return b"\0" + cobs_encode(body + struct.pack("<H", crc16(body))) + b"\0"
+
+
+class Decoder:
+    """Splits received bytes into frames; what is not a frame is text (the
+    console before the feeder switched) or noise."""
+
+    def __init__(self):
+        self.pending = bytearray()
+        self.last_seq = None
+        self.lost = 0
+        self.bad = 0
+
+    def feed(self, data):
+        """Yields (type, seq, payload) per frame and (None, None, text) per
+        chunk of console text."""
+        self.pending += data
+        while True:
+            end = self.pending.find(b"\0")
+            if end < 0:
+                return
+            chunk = bytes(self.pending[:end])
+            del self.pending[:end + 1]
+            if not chunk:
+                continue
+            body = cobs_decode(chunk)
+            if body is None or len(body) < 4 or \
+                    crc16(body[:-2]) != struct.unpack("<H", body[-2:])[0]:
+                text = chunk.decode("utf-8", "replace")
+                if text.strip() and text.replace("\r", "").replace("\n", "").isprintable():
+                    yield None, None, text
+                else:
+                    self.bad += 1
+                continue
+            msg_type, seq = body[0], body[1]
+            if msg_type < 0x80:
+                if self.last_seq is not None:
+                    self.lost += (seq - self.last_seq - 1) & 0xFF
+                self.last_seq = seq
+            yield msg_type, seq, body[2:-2]
+
+
+def decode_cbor(data, i=0):
+    """The subset BinWriter writes: ints, strings, arrays, maps, bools, null."""
+    head = data[i]
+    major, info = head >> 5, head & 0x1F
+    i += 1
+    if major == 7:
+        return {20: False, 21: True, 22: None}.get(info), i
+    if info < 24:
+        value = info
+    else:
+        size = {24: 1, 25: 2, 26: 4, 27: 8}[info]
+        value = int.from_bytes(data[i:i + size], "big")
+        i += size
+    if major == 0:
+        return value, i
+    if major == 1:
+        return -1 - value, i
+    if major in (2, 3):
+        raw = data[i:i + value]
+        return (raw.decode() if major == 3 else raw.hex()), i + value
+    if major == 4:
+        items = []
+        for _ in range(value):
+            item, i = decode_cbor(data, i)
+            items.append(item)
+        return items, i
+    if major == 5:
+        result = {}
+        for _ in range(value):
+            key, i = decode_cbor(data, i)
+            result[key], i = decode_cbor(data, i)
+        return result, i
+    raise ValueError("unsupported CBOR major type %d" % major)
+
+
+def describe(msg_type, payload):
+    if msg_type == SP_TEXT:
+        return payload.decode("utf-8", "replace")
+    if msg_type == SP_STATE:
+        ms, event, detail, slot, target, weight = struct.unpack("<IBBbff", payload[:15])
+        name = EVENTS[event] if event < len(EVENTS) else str(event)
+        if event == 0:
+            detail = MODES[detail] if detail < len(MODES) else detail
+        elif event == 1:
+            detail = OUTCOMES[detail] if detail < len(OUTCOMES) else detail
+        else:
+            return "[%10.3f s] %s" % (ms / 1000.0, name)
+        who = "manual" if slot < 0 else "slot %d" % (slot + 1)
+        return "[%10.3f s] %s %s (%s): target %.1f g, bowl %.1f g" % (
+            ms / 1000.0, name, detail, who, target, weight)
+    if msg_type == SP_ACK:
+        seq, cmd, status = struct.unpack("<BBH", payload[:4])
+        return "ack 0x%02x #%d: %d %s" % (cmd, seq, status, payload[4:].decode("utf-8", "replace"))
+    if msg_type in (SP_STATUS, SP_LIVE):
+        return json.dumps(decode_cbor(payload)[0])
+    return "frame 0x%02x (%d bytes)" % (msg_type, len(payload))
+
+
+def weight_row(payload):
+    ms, raw, grams, opening, flags = struct.unpack("<IifBB", payload[:14])
+    return "%d,%d,%.2f,%d,%d\n" % (ms, raw, grams, opening, flags & 1)
+
+
+CSV_HEADER = "ms,raw,grams,opening,feeding\n"
+
+
+class Link:
+    def __init__(self, port, baud):
+        try:
+            import serial
+        except ImportError:
+            sys.exit("pyserial is needed for a live port: pip install pyserial")
+        self.port = serial.Serial(port, baud, timeout=0.1)
+        self.decoder = Decoder()
+        self.seq = int(time.time()) & 0xFF
+        self.raw = None
+
+    def send(self, msg_type, payload=b""):
+        self.seq = (self.seq + 1) & 0xFF
+        self.port.write(frame(msg_type, self.seq, payload))
+        return self.seq
+
+    def frames(self):
+        data = self.port.read(4096)
+        if data and self.raw:
+            self.raw.write(data)
+        return self.decoder.feed(data)
+
+    def call(self, msg_type, payload=b"", timeout=3.0):
+        """Sends a command; returns (status, message, document or None)."""
+        seq = self.send(msg_type, payload)
+        doc = None
+        deadline = time.time() + timeout
+        while time.time() < deadline:
+            for t, s, body in self.frames():
+                if t in (SP_STATUS, SP_LIVE):
+                    doc = decode_cbor(body)[0]
+                elif t == SP_ACK and body[0] == seq and body[1] == msg_type:
+                    status = struct.unpack("<H", body[2:4])[0]
+                    return status, body[4:].decode("utf-8", "replace"), doc
+                elif t == SP_TEXT:
+                    print(body.decode("utf-8", "replace"), file=sys.stderr)
+        sys.exit("no answer from the feeder (wrong port or baud rate?)")
+
+
+def capture(link, args, out):
+    link.raw = open(args.raw, "wb") if args.raw else None
+    status, msg, _ = link.call(SPC_STREAM, bytes([args.every]))
+    if status != 200:
+        sys.exit("stream: %d %s" % (status, msg))
+    out.write(CSV_HEADER)
+    samples = 0
+    end = time.time() + args.seconds if args.seconds else None
+    try:
+        while end is None or time.time() < end:
+            for t, _, body in link.frames():
+                if t == SP_WEIGHT:
+                    out.write(weight_row(body))
+                    samples += 1
+                elif t is not None:
+                    print(describe(t, body), file=sys.stderr)
+    except KeyboardInterrupt:
+        pass
+    link.call(SPC_STREAM, bytes([0]))
+    print("%d readings, %d frames lost, %d bad" % (samples, link.decoder.lost, link.decoder.bad),
+          file=sys.stderr)
+
+
+def decode_file(path, out):
+    decoder = Decoder()
+    out.write(CSV_HEADER)
+    with open(path, "rb") as f:
+        for t, _, body in decoder.feed(f.read()):
+            if t == SP_WEIGHT:
+                out.write(weight_row(body))
+            elif t is None:
+                print(body.rstrip(), file=sys.stderr)
+            else:
+                print(describe(t, body), file=sys.stderr)
+    print("%d frames lost, %d bad" % (decoder.lost, decoder.bad), file=sys.stderr)
+
+
+def slot_payload(args):
+    hour, minute = (int(x) for x in args.time.split(":"))
+    has, days, every, until, splits, catch_up, catch_up_min = 0, 0, 0, 0, 0, 0, 0
+    if args.days is not None:
+        has, days = has | SLOT_EDIT_DAYS, args.days
+    if args.every is not None:
+        has, every = has | SLOT_EDIT_EVERY, args.every
+    if args.until is not None:
+        has, until = has | SLOT_EDIT_UNTIL, args.until
+    if args.splits is not None:
+        has, splits = has | SLOT_EDIT_SPLITS, args.splits
+    if args.catch_up is not None:
+        has, catch_up = has | SLOT_EDIT_CATCHUP, CATCH_UP.index(args.catch_up)
+    if args.catch_up_min is not None:
+        has, catch_up_min = has | SLOT_EDIT_CATCHUP_MIN, args.catch_up_min
+    cron = b""
+    if args.cron is not None:
+        has, cron = has | SLOT_EDIT_CRON, args.cron.encode()
+    return struct.pack("<BBBfBBHHBBH", args.index, hour, minute, args.weight, has, days, every,
+                       until, splits, catch_up, catch_up_min) + cron
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__,
+                                 formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("port", help="serial port, or the capture file for decode")
+    ap.add_argument("--baud", type=int, default=115200)
+    sub = ap.add_subparsers(dest="command", required=True)
+
+    p = sub.add_parser("capture", help="stream weight readings as CSV")
+    p.add_argument("--every", type=int, default=1, help="every Nth reading (1-255)")
+    p.add_argument("--seconds", type=float, help="stop after this long")
+    p.add_argument("--raw", help="also keep the received bytes in this file")
+    p.add_argument("-o", "--output", default="-")
+
+    p = sub.add_parser("decode", help="decode a file of received bytes")
+    p.add_argument("-o", "--output", default="-")
+
+    sub.add_parser("status", help="GET /api/status (CBOR keys, status_binary.h)")
+    sub.add_parser("live", help="GET /api/live")
+
+    p = sub.add_parser("feed", help="POST /api/manual-feed")
+    p.add_argument("amount", type=float, help="grams")
+    p.add_argument("--profile", choices=MODES)
+
+    p = sub.add_parser("set-slot", help="POST /api/set-slot")
+    p.add_argument("index", type=int, help="slot, from 0")
+    p.add_argument("time", help="HH:MM")
+    p.add_argument("weight", type=float, help="grams, 0 disables")
+    p.add_argument("--days", type=int, help="weekday mask, bit 0 = Sunday")
+    p.add_argument("--every", type=int, help="repeat every N minutes")
+    p.add_argument("--until", type=int, help="minute of day to repeat until")
+    p.add_argument("--splits", type=int)
+    p.add_argument("--catch-up", choices=CATCH_UP)
+    p.add_argument("--catch-up-min", type=int)
+    p.add_argument("--cron")
+
+    sub.add_parser("reset", help="POST /api/reset")
+    p = sub.add_parser("refill", help="POST /api/hopper/refill")
+    p.add_argument("--grams", type=float, default=0, help="default: to capacity")
+    sub.add_parser("text", help="switch the port back to the text console")
+    args = ap.parse_args()
+
+    if args.command in ("capture", "decode"):
+        out = sys.stdout if args.output == "-" else open(args.output, "w", newline="")
+        if args.command == "decode":
+            decode_file(args.port, out)
+        else:
+            capture(Link(args.port, args.baud), args, out)
+        if out is not sys.stdout:
+            out.close()
+        return
+
+    link = Link(args.port, args.baud)
+    if args.command == "status":
+        call = (SPC_STATUS, b"")
+    elif args.command == "live":
+        call = (SPC_LIVE, b"")
+    elif args.command == "feed":
+        mode = MODES.index(args.profile) if args.profile else MODE_DEFAULT
+        call = (SPC_FEED, struct.pack("<fB", args.amount, mode))
+    elif args.command == "set-slot":
+        call = (SPC_SET_SLOT, slot_payload(args))
+    elif args.command == "reset":
+        call = (SPC_RESET, b"")
+    elif args.command == "refill":
+        call = (SPC_REFILL, struct.pack("<f", args.grams))
+    else:
+        call = (SPC_TEXT, b"")
+    status, msg, doc = link.call(*call)
+    if doc is not None:
+        print(json.dumps(doc, indent=2))
+    print("%d %s" % (status, msg), file=sys.stderr)
+    sys.exit(0 if 200 <= status < 300 else 1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,1276 @@
+// Fleet simulator: hundreds of virtual feeders in one Linux process, to try
+// central monitoring and dashboards against a fleet without the boards, and
+// as a scaling benchmark of the control logic in lib/feeder_core.
+//
+//   g++ -std=gnu++17 -O2 -pthread -Iinclude -Ilib/feeder_core -o fleet_sim
+//       tools/fleet_sim.cpp lib/feeder_core/*.cpp
+//   ./fleet_sim -n 200                       # ports 9000-9199, 60x real time
+//   ./fleet_sim -n 1000 --speed 0 --port 0 --duration 30   # benchmark only
+//   python tools/loadgen.py http://localhost:9000 -n 20
+//
+// Each instance runs the pass of src/main.cpp's loop() over the same
+// modules, and feeds through the firmware's own orchestration
+// (feed_control.h): slot rules and markers, the feed queue, the dispense
+// profile and feed monitor, the journal, learned flow limits, the hopper
+// model, the feed log and the status versions and cache. Its scale is a flow simulator (flow_sim.h)
+// with its own rate, fall time and, for some, jams; its clock starts at a
+// random time of day and advances PASS_MS per pass; after a feed the pet
+// eats the bowl empty some minutes later. Instances share nothing.
+//
+// The bowl sits on a load cell that gives one conversion per pass, read
+// through the instance's calibration (scale_cal.h) with zero tracking as
+// in main.cpp. The cell's zero drifts at a rate drawn from +-DRIFT g/h
+// (--drift DRIFT) and its counts per gram differ from the configured factor
+// by up to --span-error PCT percent; --calibrate GRAMS runs a span capture
+// with that reference mass on the scale at start, --zero-track 0 turns
+// tracking off. The stats then show how close feeds come to the portion
+// asked for (what landed in the bowl, per feed that reached its target)
+// and how far the idle bowl reading is from its true weight.
+//
+// With --port P instance i serves HTTP on P + i: GET /api/status (?since=),
+// /api/live, /api/queue, /api/flow, /api/stats, /api/admission and
+// /api/calibration, POST /api/manual-feed (?amount=&profile=),
+// /api/hopper/refill (?grams=) and /api/calibration (?step=zero|span&mass=;
+// the mass is put on the scale for the capture), behind the same admission
+// limits as the firmware. Bodies are the
+// firmware's (status_json.h); connections close after one reply. The page
+// (web_ui.h) is not served.
+//
+// POST /api/ota?url=&sig= fetches an image over plain HTTP and unpacks it
+// with the firmware's decoder (ota_image.h) into the instance's other slot,
+// blocking its pass as the download blocks the firmware's loop; an image
+// signed by --ota-key becomes the running one, on trial until the health
+// check passes. As on the board, the request needs "Authorization: Bearer
+// <--ota-token>", and without both options no update is taken. GET /api/ota reports it, with the transfer and image bytes and
+// the real time taken. --ota-image FILE is the image every instance starts
+// out running, the base deltas are made against (tools/ota_pack.py --base);
+// tools/ota_push.py drives it.
+//
+// A pool of --threads workers runs the fleet in rounds: each round every
+// instance gets one pass (its HTTP requests, then its loop), claimed from a
+// shared counter so a busy instance does not hold up a thread's share.
+// Rounds start every PASS_MS / --speed of real time (--speed 0: back to
+// back). Every --report seconds, and at the end, the fleet's stats: speed
+// achieved, passes/s, CPU per instance (thread CPU time of its passes, as a
+// share of one core), the cost of one pass, HTTP requests, feeds and their
+// outcomes. Memory per instance is its state (sizeof) and the growth of the
+// process RSS over creating the fleet, divided by its size. --json FILE
+// writes the final figures; --stats-port serves them as GET /fleet.
+//
+// Options: -n COUNT, --port P (0 = no HTTP), --threads T, --speed X,
+// --duration SECS (0 = until Ctrl-C), --feed-every MIN (slot 1 repeats every
+// MIN minutes, 0 = daily slots only), --report SECS, --seed N, --json FILE,
+// --stats-port P, --ota-image FILE, --ota-key HEX, --ota-token T,
+// --drift G_PER_H, --span-error PCT, --calibrate GRAMS, --zero-track 0|1.
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "feeder_config.h"
+#include "feeder_time.h"
+#include "schedule.h"
+#include "feed_queue.h"
+#include "feed_control.h"
+#include "feed_monitor.h"
+#include "dispense.h"
+#include "flow_sim.h"
+#include "flow_stats.h"
+#include "hopper.h"
+#include "feed_log.h"
+#include "feed_rollup.h"
+#include "status_json.h"
+#include "status_cache.h"
+#include "admission.h"
+#include "api_request.h"
+#include "ota_image.h"
+#include "scale_cal.h"
+
+constexpr int SLOT_COUNT    = kBoard.slotCount;
+constexpr int MAX_FEED_LOGS = kBoard.maxFeedLogs;
+constexpr size_t STATUS_CAP = statusJsonCapacity(SLOT_COUNT, MAX_FEED_LOGS);
+
+const uint32_t PASS_MS             = FLOW_SIM_STEP_MS;   // virtual time per loop pass
+const uint32_t HOPPER_HORIZON_SECS = 30UL * 24 * 3600;   // as in main.cpp
+const int      MAX_CONNS           = 4;                  // open requests per instance
+const size_t   REQUEST_MAX         = 1024;
+const uint32_t REQUEST_TIMEOUT_MS  = 2000;               // real time
+const int      CLAIM_CHUNK         = 8;                  // instances per counter claim
+const uint32_t OTA_SLOT_BYTES      = 0x160000;           // app0/app1 in partitions.csv
+const uint32_t OTA_WINDOW_BYTES    = 16 * 1024;          // as in main.cpp
+const int      OTA_TIMEOUT_SECS    = 10;                 // per read of the download
+
+typedef std::vector<uint8_t> Bytes;
+
+const FeedLimits FEED_LIMITS = {kBoard.feedTimeoutMs, kBoard.stuckWindowMs, kBoard.minIncreaseG};
+
+struct Options {
+  int      count = 100;
+  int      port = 9000;
+  int      threads = 0;          // hardware threads
+  double   speed = 60;
+  double   durationSecs = 0;
+  int      feedEveryMin = 30;
+  double   reportSecs = 10;
+  uint32_t seed = 1;
+  const char* json = nullptr;
+  int      statsPort = 0;
+  std::shared_ptr<const Bytes> otaImage;  // --ota-image, shared by the fleet
+  const char* otaKey = "";       // as FEEDER_OTA_KEY
+  const char* otaToken = "";     // as FEEDER_OTA_TOKEN
+  float    driftGPerHour = 0;
+  float    spanErrorPct = 0;
+  float    calibrateG = 0;       // 0 = keep the configured factor
+  bool     zeroTracking = true;
+};
+
+static uint64_t realNowNs() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static uint64_t threadCpuNs() {
+  timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static uint64_t startNs;
+static uint32_t realMs() { return (uint32_t)((realNowNs() - startNs) / 1000000); }
+
+// xorshift32: each instance draws from its own
+static uint32_t nextRandom(uint32_t& s) {
+  s ^= s << 13;
+  s ^= s >> 17;
+  s ^= s << 5;
+  return s;
+}
+static float uniform(uint32_t& s, float lo, float hi) {
+  return lo + (hi - lo) * (nextRandom(s) >> 8) / 16777216.0f;
+}
+
+struct Conn {
+  int      fd = -1;
+  uint32_t ip;
+  uint32_t openedMs;
+  size_t   len;
+  char     buf[REQUEST_MAX];
+};
+
+// One feeder: what main.cpp keeps in globals, plus its scale and server
+struct VirtualFeeder {
+  int      id;
+  uint32_t rng;
+  int      listenFd = -1;
+  Conn     conns[MAX_CONNS];
+
+  // Clock and scale
+  uint32_t ms;            // millis()
+  uint32_t unixBase;      // Unix time at ms = 0
+  FlowSim  scale;
+  float    weight;        // currentWeight
+  float    lastIdleWeight;
+  uint32_t eatAtMs;       // 0 = bowl left alone
+
+  // Load cell: counts = cellZero + grams * cellCpg, which the feeder only
+  // knows through its calibration
+  double      cellZero;
+  double      cellDriftPerPass;
+  float       cellCpg;
+  float       refMassG;     // reference mass on the scale, for a span capture
+  ScaleCal    cal;
+  CalCapture  calCapture;
+  ZeroTracker zeroTracker;
+  bool        zeroTracking;
+
+  // Schedule
+  FeedingSlot  slots[SLOT_COUNT];
+  CompiledRule rules[SLOT_COUNT];
+  uint32_t     markers[SLOT_COUNT];
+
+  // Feeds
+  FeedCommand  queueStorage[kBoard.feedQueueDepth];
+  FeedControl  feed;
+  FeedJournal  journal;     // RAM only: nothing survives an instance
+  float        askedG;
+  float        startTrueG;  // bowl and air before the feed, for its accuracy
+
+  // Learned and reported state
+  FlowStats      flow;
+  HopperState    hopper;
+  HopperForecast forecast;
+  FeedLogEntry   log[MAX_FEED_LOGS];
+  int            logCount;
+  FeedRollups    rollups;
+  StatusVersions versions;
+  uint32_t       lastNextFeed;
+  StatusCache    cache;
+  char           cacheStorage[STATUS_CACHE_ENTRIES * STATUS_CAP];
+  Admission      admission;
+
+  // OTA slots: the running image (shared with the fleet until an update
+  // replaces it) and the one /api/ota writes
+  std::shared_ptr<const Bytes> otaRunning;
+  Bytes          otaNext;
+  uint8_t        otaSlot;     // running: 0 = app0, 1 = app1
+  uint32_t       otaBootMs;   // ms when it started running
+  OtaTrial       otaTrial;
+  OtaReport      otaReport;
+  const char*    otaKey;
+  const char*    otaToken;
+  const char*    bearer;      // of the request being handled, nullptr if none
+
+  // Counters, read by the main thread between rounds
+  uint64_t cpuNs;
+  uint64_t maxPassNs;
+  uint32_t passes;
+  uint32_t requests;
+  uint32_t rejected;     // 429
+  uint32_t outcomes[4];  // FeedCheck
+  double   absErrorG;
+  double   deliveredErrG;    // landed - asked, feeds that reached their target
+  double   deliveredSqErrG;
+  uint32_t deliveredFeeds;
+  double   zeroSqErrG;       // (reading - bowl)^2, idle, once a second
+  uint32_t zeroSamples;
+};
+
+static uint32_t unixNow(const VirtualFeeder& f) { return f.unixBase + f.ms / 1000; }
+
+static void markStateChanged(VirtualFeeder& f) {
+  bumpStatusVersion(f.versions, f.versions.state);
+}
+
+static void updateHopperForecast(VirtualFeeder& f) {
+  HopperForecast fc = forecastHopper(f.hopper, f.rules, SLOT_COUNT, unixNow(f),
+                                     HOPPER_HORIZON_SECS, kBoard.hopperWarnHours * 3600UL);
+  if (fc.emptyAt == f.forecast.emptyAt && fc.feedsLeft == f.forecast.feedsLeft &&
+      fc.low == f.forecast.low) {
+    return;
+  }
+  f.forecast = fc;
+  markStateChanged(f);
+}
+
+static void refillHopper(VirtualFeeder& f, float grams) {
+  hopperRefill(f.hopper, grams, unixNow(f));
+  markStateChanged(f);
+  updateHopperForecast(f);
+}
+
+// ---- Feeds: the firmware's orchestration (feed_control.h) on an instance ----
+
+static void feedGate(void* ctx, uint8_t pct) {
+  VirtualFeeder& f = *(VirtualFeeder*)ctx;
+  flowSimGate(f.scale, pct, f.ms);
+}
+
+static uint32_t feedClock(void* ctx) { return unixNow(*(VirtualFeeder*)ctx); }
+
+// No history file here; a record is still news to a client
+static void feedRecord(void* ctx, const HistoryRecord&) {
+  VirtualFeeder& f = *(VirtualFeeder*)ctx;
+  bumpStatusVersion(f.versions, f.versions.history);
+}
+
+static void feedStarted(void* ctx) {
+  VirtualFeeder& f = *(VirtualFeeder*)ctx;
+  f.askedG = f.feed.progress.target - f.feed.startWeight;
+  f.startTrueG = f.scale.bowlG + flowSimFalling(f.scale);
+  markStateChanged(f);
+}
+
+static void feedFinished(void* ctx, const FeedOutcome& o) {
+  VirtualFeeder& f = *(VirtualFeeder*)ctx;
+  FeedLogEntry e;
+  e.used        = true;
+  e.manual      = o.manual;
+  e.slotIndex   = o.slot;
+  e.hour        = hourOf(unixNow(f));
+  e.minute      = minuteOf(unixNow(f));
+  e.target      = o.target;
+  e.finalWeight = o.finalWeight;
+  pushFeedLog(f.log, MAX_FEED_LOGS, f.logCount, e);
+  rollupFeed(f.rollups, unixNow(f), o.slot, o.reason == FEED_TARGET_REACHED, o.dispensed,
+             o.finalWeight - o.target);
+
+  f.outcomes[o.reason]++;
+  f.absErrorG += fabsf(o.finalWeight - o.target);
+  if (o.reason == FEED_TARGET_REACHED) {
+    float err = f.scale.bowlG + flowSimFalling(f.scale) - f.startTrueG - f.askedG;
+    f.deliveredErrG += err;
+    f.deliveredSqErrG += err * err;
+    f.deliveredFeeds++;
+  }
+  f.eatAtMs = f.ms + (5 + nextRandom(f.rng) % 20) * 60000;
+  markStateChanged(f);
+  updateHopperForecast(f);
+}
+
+static void initFeeder(VirtualFeeder& f, int id, const Options& o) {
+  f.id = id;
+  f.rng = o.seed * 2654435761u + id * 40503u + 1;
+  f.ms = 0;
+  f.unixBase = unixTime(2025, 1, 6, 0, 0, 0) + nextRandom(f.rng) % SECS_PER_DAY;
+
+  FlowSimParams p = {uniform(f.rng, 25.0f, 40.0f), 15,
+                     (uint16_t)(200 + nextRandom(f.rng) % 250), 0.0f, 0};
+  if (nextRandom(f.rng) % 10 == 0) {  // one in ten jams now and then
+    p.bridgeEveryG = uniform(f.rng, 80.0f, 200.0f);
+    p.bridgeSwings = 2;
+  }
+  initFlowSim(f.scale, p, 0.0f, f.ms);
+  f.weight = 0;
+  f.lastIdleWeight = NAN;
+  f.eatAtMs = 0;
+
+  // The boot zero matches the cell; the configured factor is off by the
+  // span error until a span capture
+  f.cellCpg = kBoard.calibrationFactor * (1.0f + uniform(f.rng, -1, 1) * o.spanErrorPct / 100);
+  f.cellZero = uniform(f.rng, -200000.0f, 200000.0f);
+  f.cellDriftPerPass =
+      uniform(f.rng, -1, 1) * o.driftGPerHour * f.cellCpg * PASS_MS / 3600000.0;
+  f.cal = {(int32_t)lround(f.cellZero), kBoard.calibrationFactor, 0};
+  initCalCapture(f.calCapture);
+  initZeroTracker(f.zeroTracker, f.ms);
+  f.zeroTracking = o.zeroTracking;
+  f.refMassG = 0;
+  if (o.calibrateG > 0) {
+    f.refMassG = o.calibrateG;
+    startCalCapture(f.calCapture, CAL_SPAN, o.calibrateG);
+  }
+
+  for (int i = 0; i < SLOT_COUNT; i++) {
+    f.slots[i] = {true, defaultSlotHour(i), (int)(nextRandom(f.rng) % 60),
+                  (float)(20 + nextRandom(f.rng) % 41)};
+    f.markers[i] = NO_MARKER;
+  }
+  if (o.feedEveryMin > 0) {
+    f.slots[0].hour = 0;
+    f.slots[0].minute = nextRandom(f.rng) % o.feedEveryMin;
+    f.slots[0].everyMin = o.feedEveryMin;
+  }
+  compileSlots(f.slots, f.rules, SLOT_COUNT);
+
+  initFlowStats(f.flow);
+  initHopper(f.hopper, kBoard.hopperCapacityG);
+  f.journal = {};
+  FeedHooks hooks = {};
+  hooks.ctx = &f;
+  hooks.gate = feedGate;
+  hooks.clock = feedClock;
+  hooks.record = feedRecord;
+  hooks.started = feedStarted;
+  hooks.finished = feedFinished;
+  FeedConfig cfg = {FEED_LIMITS, kBoard.feedMaxWaitMs, kBoard.dispenseMode};
+  initFeedControl(f.feed, cfg, f.queueStorage, kBoard.feedQueueDepth, f.flow, f.hopper,
+                  f.journal, f.calCapture, hooks);
+  f.askedG = f.startTrueG = 0;
+  f.forecast = {NO_FEEDING_TIME, 0, false};
+  clearFeedLog(f.log, MAX_FEED_LOGS, f.logCount);
+  initFeedRollups(f.rollups);
+  initStatusVersions(f.versions, nextRandom(f.rng) & 0xFFFF);
+  f.lastNextFeed = NO_FEEDING_TIME;
+  initStatusCache(f.cache, f.cacheStorage, STATUS_CAP);
+  initAdmission(f.admission, {kBoard.httpClientRate, kBoard.httpClientBurst, kBoard.httpTickBudget});
+  refillHopper(f, 0);
+
+  f.otaRunning = o.otaImage;
+  f.otaKey = o.otaKey;
+  f.otaToken = o.otaToken;
+  f.otaSlot = 0;
+  f.otaBootMs = 0;
+  f.otaTrial = {};
+  f.otaReport = {};
+
+  f.cpuNs = f.maxPassNs = 0;
+  f.passes = f.requests = f.rejected = 0;
+  memset(f.outcomes, 0, sizeof(f.outcomes));
+  f.absErrorG = 0;
+  f.deliveredErrG = f.deliveredSqErrG = f.zeroSqErrG = 0;
+  f.deliveredFeeds = f.zeroSamples = 0;
+}
+
+// ---- The loop of src/main.cpp ----
+
+// One conversion of the drifting cell, through the feeder's calibration:
+// updateCalibration() and readWeight() in main.cpp
+static void readScale(VirtualFeeder& f) {
+  f.cellZero += f.cellDriftPerPass;
+  float grams = f.scale.bowlG + f.refMassG + uniform(f.rng, -0.2f, 0.2f);
+  int32_t raw = (int32_t)lround(f.cellZero + grams * f.cellCpg);
+  if (f.calCapture.step != CAL_NONE) {
+    zeroTrack(f.zeroTracker, f.cal, raw, false, f.ms);
+    if (calCaptureSample(f.calCapture, f.cal, raw)) {
+      if (f.calCapture.result == CAL_OK && f.calCapture.lastStep == CAL_SPAN) {
+        f.cal.spanTime = unixNow(f);
+      }
+      f.refMassG = 0;
+    }
+  } else if (f.zeroTracking) {
+    zeroTrack(f.zeroTracker, f.cal, raw, !f.feed.active && f.feed.opening == 0, f.ms);
+  }
+  f.weight = scaleGrams(f.cal, raw);
+}
+
+static void loopPass(VirtualFeeder& f) {
+  f.ms += PASS_MS;
+  flowSimAdvance(f.scale, f.ms);
+  readScale(f);
+
+  if (!f.feed.active && f.feed.opening == 0) {
+    if (!isnan(f.lastIdleWeight)) {
+      learnIdleNoise(f.flow, f.lastIdleWeight, f.weight, FEED_LIMITS.minIncreaseG);
+    }
+    f.lastIdleWeight = f.weight;
+  } else {
+    f.lastIdleWeight = NAN;
+  }
+
+  // The pet, and the owner topping up the hopper
+  if (f.eatAtMs != 0 && !f.feed.active && (int32_t)(f.ms - f.eatAtMs) >= 0) {
+    f.scale.bowlG *= uniform(f.rng, 0.0f, 0.1f);
+    f.eatAtMs = 0;
+  }
+  if (!f.feed.active && f.hopper.remainingG < kBoard.hopperCapacityG * 0.1f) refillHopper(f, 0);
+
+  checkScheduledFeeds(f.feed, f.rules, f.markers, SLOT_COUNT, unixNow(f), f.ms);
+  dispatchFeed(f.feed, f.weight, f.ms);
+  if (f.feed.active) stepFeed(f.feed, f.weight, f.ms);
+
+  if (f.ms % 1000 < PASS_MS) {
+    // The network is always up here, so only the uptime counts
+    if (f.otaTrial.active && otaHealthCheck(f.ms - f.otaBootMs, true, true) == OTA_HEALTH_OK) {
+      f.otaTrial.active = 0;
+    }
+    uint32_t next = nextFeedingTime(f.rules, SLOT_COUNT, unixNow(f));
+    if (next != f.lastNextFeed) {
+      f.lastNextFeed = next;
+      markStateChanged(f);
+      updateHopperForecast(f);
+    }
+    if (!f.feed.active && f.feed.opening == 0 && f.refMassG == 0) {
+      float e = f.weight - f.scale.bowlG;
+      f.zeroSqErrG += e * e;
+      f.zeroSamples++;
+    }
+  }
+}
+
+// ---- HTTP ----
+
+static int listenOn(int port) {
+  int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd < 0) return -1;
+  int one = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  sockaddr_in a = {};
+  a.sin_family = AF_INET;
+  a.sin_addr.s_addr = htonl(INADDR_ANY);
+  a.sin_port = htons(port);
+  if (bind(fd, (sockaddr*)&a, sizeof(a)) < 0 || listen(fd, 16) < 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+static const char* reasonPhrase(int status) {
+  switch (status) {
+    case 200: return "OK";
+    case 202: return "Accepted";
+    case 304: return "Not Modified";
+    case 400: return "Bad Request";
+    case 401: return "Unauthorized";
+    case 403: return "Forbidden";
+    case 404: return "Not Found";
+    case 409: return "Conflict";
+    case 422: return "Unprocessable Entity";
+    case 429: return "Too Many Requests";
+    case 500: return "Internal Server Error";
+    case 502: return "Bad Gateway";
+    case 503: return "Service Unavailable";
+    default:  return "";
+  }
+}
+
+static void reply(int fd, int status, const char* type, const char* body, size_t len,
+                  const char* extra = "") {
+  char head[256];
+  int n = snprintf(head, sizeof(head),
+                   "HTTP/1.1 %d %s\r\nContent-Type: %s\r\nContent-Length: %zu\r\n"
+                   "Cache-Control: no-cache\r\nConnection: close\r\n%s\r\n",
+                   status, reasonPhrase(status), type, len, extra);
+  send(fd, head, n, MSG_NOSIGNAL);
+  if (len) send(fd, body, len, MSG_NOSIGNAL);
+}
+
+static void replyText(int fd, int status, const char* text) {
+  reply(fd, status, "text/plain", text, strlen(text));
+}
+
+// 400 with formatArgError()'s text unless `r` is ARG_OK, or ARG_MISSING
+// for an optional argument
+static bool argAccepted(int fd, ArgResult r, const char* name, bool optional = false) {
+  if (r == ARG_OK || (optional && r == ARG_MISSING)) return true;
+  char msg[48];
+  formatArgError(msg, sizeof(msg), name, r);
+  replyText(fd, 400, msg);
+  return false;
+}
+
+static StatusView statusView(VirtualFeeder& f) {
+  StatusView v;
+  v.weight         = f.weight;
+  v.feedingActive  = f.feed.active;
+  v.nextFeed       = nextFeedingTime(f.rules, SLOT_COUNT, unixNow(f));
+  v.slots          = f.slots;
+  v.slotCount      = SLOT_COUNT;
+  v.log            = f.log;
+  v.logCount       = f.logCount;
+  v.hopper         = &f.hopper;
+  v.hopperForecast = &f.forecast;
+  return v;
+}
+
+// ---- OTA (/api/ota) ----
+
+static bool otaWrite(void* ctx, const uint8_t* data, size_t len) {
+  Bytes& next = ((VirtualFeeder*)ctx)->otaNext;
+  if (next.size() + len > OTA_SLOT_BYTES) return false;
+  next.insert(next.end(), data, data + len);
+  return true;
+}
+
+static bool otaReadBase(void* ctx, uint32_t offset, uint8_t* out, size_t len) {
+  const Bytes* running = ((VirtualFeeder*)ctx)->otaRunning.get();
+  if (!running || offset + len > running->size()) return false;
+  memcpy(out, running->data() + offset, len);
+  return true;
+}
+
+// Blocking GET of an http:// URL into the decoder, what HTTPClient does on
+// the board. The reply must carry a Content-Length.
+static uint8_t otaDownload(const char* url, OtaDecoder& d) {
+  if (strncmp(url, "http://", 7) != 0) return OTA_ERR_DOWNLOAD;
+  const char* host = url + 7;
+  const char* path = strchr(host, '/');
+  std::string hostPort(host, path ? path - host : strlen(host));
+  std::string name = hostPort, port = "80";
+  size_t colon = hostPort.rfind(':');
+  if (colon != std::string::npos) {
+    name = hostPort.substr(0, colon);
+    port = hostPort.substr(colon + 1);
+  }
+  addrinfo hints = {}, *ai = nullptr;
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  if (getaddrinfo(name.c_str(), port.c_str(), &hints, &ai) != 0) return OTA_ERR_DOWNLOAD;
+  int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  timeval tv = {OTA_TIMEOUT_SECS, 0};
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+  bool connected = fd >= 0 && connect(fd, ai->ai_addr, ai->ai_addrlen) == 0;
+  freeaddrinfo(ai);
+  if (!connected) {
+    if (fd >= 0) close(fd);
+    return OTA_ERR_DOWNLOAD;
+  }
+
+  char buf[4096];
+  int n = snprintf(buf, sizeof(buf), "GET %s HTTP/1.1\r\nHost: %s\r\nConnection: close\r\n\r\n",
+                   path ? path : "/", hostPort.c_str());
+  send(fd, buf, n, MSG_NOSIGNAL);
+
+  // Head first, then the body through the decoder as it arrives
+  size_t used = 0;
+  char* body = nullptr;
+  while (!body && used < sizeof(buf) - 1) {
+    ssize_t r = recv(fd, buf + used, sizeof(buf) - 1 - used, 0);
+    if (r <= 0) break;
+    used += r;
+    buf[used] = '\0';
+    body = strstr(buf, "\r\n\r\n");
+  }
+  int status = 0;
+  const char* length = body ? strcasestr(buf, "\r\nContent-Length:") : nullptr;
+  if (!body || sscanf(buf, "HTTP/%*s %d", &status) != 1 || status != 200 || !length ||
+      length > body) {
+    close(fd);
+    return OTA_ERR_DOWNLOAD;
+  }
+  long left = atol(length + 17);
+  body += 4;
+  size_t have = used - (body - buf);
+  otaDecode(d, (const uint8_t*)body, have);
+  left -= have;
+  while (left > 0 && d.result == OTA_OK) {
+    ssize_t r = recv(fd, buf, sizeof(buf), 0);
+    if (r <= 0) break;
+    otaDecode(d, (const uint8_t*)buf, r);
+    left -= r;
+  }
+  close(fd);
+  if (left > 0 && d.result == OTA_OK) return OTA_ERR_DOWNLOAD;  // broke off
+  return d.result;
+}
+
+static void replyOta(VirtualFeeder& f, int fd, int status) {
+  static const char* labels[] = {"app0", "app1"};
+  char json[OTA_JSON_MAX];
+  size_t n = writeOtaJson(json, sizeof(json), labels[f.otaSlot], labels[f.otaSlot ^ 1],
+                          f.otaTrial, f.otaReport);
+  reply(fd, status, "application/json", json, n);
+}
+
+static void handleOtaStatus(VirtualFeeder& f, int fd, const ApiArgs&) {
+  replyOta(f, fd, 200);
+}
+
+// POST /api/ota, as handleOtaApi() in main.cpp
+static void handleOta(VirtualFeeder& f, int fd, const ApiArgs& args) {
+  uint8_t key[ED25519_KEY_BYTES];
+  if (!parseHex(f.otaKey, key, sizeof(key)) || f.otaToken[0] == '\0') {
+    replyText(fd, 403, "No --ota-key/--ota-token given");
+    return;
+  }
+  if (!f.bearer || !otaTokenMatches(f.otaToken, f.bearer)) {
+    reply(fd, 401, "text/plain", "Unauthorized", 12, "WWW-Authenticate: Bearer\r\n");
+    return;
+  }
+  const ApiArg* url = findApiArg(args, "url");
+  const ApiArg* sigArg = findApiArg(args, "sig");
+  if (!url || !sigArg) {
+    replyText(fd, 400, "Missing url or sig");
+    return;
+  }
+  uint8_t sig[ED25519_SIG_BYTES];
+  if (!parseHex(sigArg->value, sig, sizeof(sig))) {
+    replyText(fd, 400, "sig must be 128 hex digits");
+    return;
+  }
+  if (f.feed.active) {
+    replyText(fd, 409, "Feeding, try again later");
+    return;
+  }
+  if (f.otaTrial.active) {
+    replyText(fd, 409, "Running image is still on trial");
+    return;
+  }
+
+  uint32_t start = realMs();
+  std::unique_ptr<uint8_t[]> window(new uint8_t[OTA_WINDOW_BYTES]);
+  OtaDecoder dec;
+  initOtaDecoder(dec, window.get(), OTA_WINDOW_BYTES, otaWrite, otaReadBase, &f);
+  f.otaNext.clear();
+  uint8_t result = otaDownload(url->value, dec);
+  uint8_t sha[SHA256_BYTES];
+  if (result == OTA_OK) result = otaDecodeFinish(dec, sha);
+  if (result == OTA_OK && !otaSignatureValid(sha, sig, key)) result = OTA_ERR_SIGNATURE;
+
+  f.otaReport.result = result;
+  f.otaReport.kind = otaImageKind(dec);
+  f.otaReport.transferBytes = dec.in;
+  f.otaReport.imageBytes = dec.out;
+  f.otaReport.ms = realMs() - start;
+  if (result == OTA_OK) {
+    // The restart: the other slot runs, on trial
+    f.otaRunning = std::make_shared<const Bytes>(std::move(f.otaNext));
+    f.otaSlot ^= 1;
+    f.otaBootMs = f.ms;
+    f.otaTrial = {1, 1, f.otaSlot};
+  }
+  f.otaNext = Bytes();
+  replyOta(f, fd, result == OTA_OK ? 200 : result == OTA_ERR_DOWNLOAD ? 502
+                  : result == OTA_ERR_WRITE ? 500 : 422);
+}
+
+// ---- API routes, as kApiRoutes in main.cpp ----
+
+static void handleStatus(VirtualFeeder& f, int fd, const ApiArgs& args) {
+  uint32_t since = 0;
+  const ApiArg* sinceArg = findApiArg(args, "since");
+  bool delta = sinceArg != nullptr;
+  if (delta && !parseStatusVersion(sinceArg->value, f.versions, since)) since = 0;
+  if (delta && since > 0 && !statusChangedSince(f.versions, since)) {
+    reply(fd, 304, "application/json", "", 0);
+    return;
+  }
+  StatusView view = statusView(f);
+  const StatusCacheEntry* doc = delta ? statusCacheDelta(f.cache, view, f.versions, since)
+                                      : statusCacheFull(f.cache, view, f.versions);
+  if (!doc) replyText(fd, 500, "Status too large");
+  else reply(fd, 200, "application/json", doc->buf, doc->len);
+}
+
+static void handleLive(VirtualFeeder& f, int fd, const ApiArgs&) {
+  char json[LIVE_JSON_MAX];
+  size_t n = writeLiveJson(json, sizeof(json), f.weight, f.feed.active, f.versions);
+  reply(fd, 200, "application/json", json, n);
+}
+
+static void handleQueue(VirtualFeeder& f, int fd, const ApiArgs&) {
+  char json[queueJsonCapacity(kBoard.feedQueueDepth)];
+  size_t n = writeQueueJson(json, sizeof(json), f.feed.queue, f.feed.active, f.ms);
+  reply(fd, 200, "application/json", json, n);
+}
+
+static void handleFlow(VirtualFeeder& f, int fd, const ApiArgs&) {
+  char json[FLOW_JSON_MAX];
+  size_t n = writeFlowJson(json, sizeof(json), f.flow, f.feed.limits);
+  reply(fd, 200, "application/json", json, n);
+}
+
+static void handleStats(VirtualFeeder& f, int fd, const ApiArgs&) {
+  char json[statsJsonCapacity(SLOT_COUNT)];
+  size_t n = writeStatsJson(json, sizeof(json), f.rollups, SLOT_COUNT, unixNow(f));
+  reply(fd, 200, "application/json", json, n);
+}
+
+static void handleAdmission(VirtualFeeder& f, int fd, const ApiArgs&) {
+  char json[ADMISSION_JSON_MAX];
+  size_t n = writeAdmissionJson(json, sizeof(json), f.admission);
+  reply(fd, 200, "application/json", json, n);
+}
+
+static void handleManualFeed(VirtualFeeder& f, int fd, const ApiArgs& args) {
+  float amount = 0;
+  if (!argAccepted(fd, argFloat(args, "amount", -kBoard.hopperCapacityG, kBoard.hopperCapacityG,
+                                amount), "amount")) {
+    return;
+  }
+  if (amount <= 0) {
+    replyText(fd, 400, "Amount must be > 0");
+    return;
+  }
+  uint8_t mode = kBoard.dispenseMode;
+  const ApiArg* profile = findApiArg(args, "profile");
+  if (profile && !parseDispenseMode(profile->value, mode)) {
+    replyText(fd, 400, "profile must be full, trickle or pulse");
+    return;
+  }
+  bool startsNow = feedDispenserFree(f.feed) && f.feed.queue.count == 0;
+  FeedEnqueue result = requestFeed(f.feed, FEED_SRC_API, -1, amount, mode, f.ms);
+  if (result == FEED_QUEUE_FULL) {
+    replyText(fd, 503, "Feed queue full");
+    return;
+  }
+  dispatchFeed(f.feed, f.weight, f.ms);
+  char msg[48] = "OK";
+  if (!startsNow) {
+    snprintf(msg, sizeof(msg), "%s (%d waiting)",
+             result == FEED_DUPLICATE ? "Already queued" : "Queued", f.feed.queue.count);
+  }
+  replyText(fd, startsNow ? 200 : 202, msg);
+}
+
+static void handleHopperRefill(VirtualFeeder& f, int fd, const ApiArgs& args) {
+  float grams = 0;
+  if (!argAccepted(fd, argFloat(args, "grams", -kBoard.hopperCapacityG, kBoard.hopperCapacityG,
+                                grams), "grams", true)) {
+    return;
+  }
+  if (grams < 0) {
+    replyText(fd, 400, "grams must be >= 0");
+    return;
+  }
+  refillHopper(f, grams);
+  replyText(fd, 200, "Hopper refilled");
+}
+
+static void replyCalibration(VirtualFeeder& f, int fd, int status) {
+  char json[CALIBRATION_JSON_MAX];
+  size_t n = writeCalibrationJson(json, sizeof(json), f.cal, f.calCapture, f.zeroTracker);
+  reply(fd, status, "application/json", json, n);
+}
+
+static void handleCalibrationStatus(VirtualFeeder& f, int fd, const ApiArgs&) {
+  replyCalibration(f, fd, 200);
+}
+
+// As main.cpp; the owner puts the mass on for a span capture and takes it
+// off when it ends
+static void handleCalibration(VirtualFeeder& f, int fd, const ApiArgs& args) {
+  const ApiArg* step = findApiArg(args, "step");
+  if (!step) {
+    replyText(fd, 400, "Missing step");
+    return;
+  }
+  uint8_t s = CAL_NONE;
+  float mass = 0;
+  if (strcmp(step->value, "zero") == 0) {
+    s = CAL_ZERO;
+  } else if (strcmp(step->value, "span") == 0) {
+    s = CAL_SPAN;
+    if (!argAccepted(fd, argFloat(args, "mass", 10, kBoard.hopperCapacityG, mass), "mass")) return;
+  } else {
+    replyText(fd, 400, "step must be zero or span");
+    return;
+  }
+  if (f.feed.active || f.feed.opening != 0) {
+    replyText(fd, 409, "Feeding, try again later");
+    return;
+  }
+  if (f.calCapture.step != CAL_NONE) {
+    replyText(fd, 409, "Calibration already running");
+    return;
+  }
+  startCalCapture(f.calCapture, s, mass);
+  f.refMassG = mass;
+  replyCalibration(f, fd, 202);
+}
+
+typedef void (*SimHandler)(VirtualFeeder& f, int fd, const ApiArgs& args);
+
+static constexpr ApiRoute<SimHandler> SIM_ROUTES[] = {
+  {"/api/admission",     API_GET,  LANE_READ,     handleAdmission},
+  {"/api/calibration",   API_GET,  LANE_READ,     handleCalibrationStatus},
+  {"/api/calibration",   API_POST, LANE_WRITE,    handleCalibration},
+  {"/api/flow",          API_GET,  LANE_READ,     handleFlow},
+  {"/api/hopper/refill", API_POST, LANE_WRITE,    handleHopperRefill},
+  {"/api/live",          API_GET,  LANE_READ,     handleLive},
+  {"/api/manual-feed",   API_POST, LANE_PRIORITY, handleManualFeed},
+  {"/api/ota",           API_GET,  LANE_READ,     handleOtaStatus},
+  {"/api/ota",           API_POST, LANE_WRITE,    handleOta},
+  {"/api/queue",         API_GET,  LANE_READ,     handleQueue},
+  {"/api/stats",         API_GET,  LANE_READ,     handleStats},
+  {"/api/status",        API_GET,  LANE_READ,     handleStatus},
+};
+static_assert(apiRoutesSorted(SIM_ROUTES), "SIM_ROUTES must be sorted by path, then method");
+
+// The request line is split in place: method, path and the query's
+// arguments all end up as slices of c.buf
+static void handleRequest(VirtualFeeder& f, Conn& c) {
+  char* method = c.buf;
+  char* path = strchr(method, ' ');
+  char* end = path ? strpbrk(path + 1, " \r\n") : nullptr;
+  ApiMethod m;
+  if (!end) {
+    replyText(c.fd, 400, "Bad request");
+    return;
+  }
+  // The bearer token, cut out of the headers that follow the request line
+  char* auth = strcasestr(end, "\r\nAuthorization: Bearer ");
+  f.bearer = auth ? auth + 24 : nullptr;
+  if (auth) auth[24 + strcspn(auth + 24, "\r\n")] = '\0';
+  *path++ = '\0';
+  *end = '\0';
+  char* query = strchr(path, '?');
+  if (query) *query++ = '\0';
+  const ApiRoute<SimHandler>* route =
+      parseApiMethod(method, m) ? findApiRoute(SIM_ROUTES, m, path) : nullptr;
+  if (!route) {
+    replyText(c.fd, 404, "Not found");
+    return;
+  }
+
+  f.requests++;
+  AdmitResult admit = admitRequest(f.admission, c.ip, route->lane, realMs(), f.feed.active);
+  if (admit != ADMIT_OK) {
+    f.rejected++;
+    char retry[40];
+    snprintf(retry, sizeof(retry), "Retry-After: %u\r\n",
+             (unsigned)admissionRetryAfterSecs(f.admission, c.ip, admit));
+    const char* text = admit == ADMIT_RATE ? "Too many requests" : "Busy";
+    reply(c.fd, 429, "text/plain", text, strlen(text), retry);
+    return;
+  }
+
+  ApiArgs args;
+  parseApiArgs(args, query);
+  if (args.truncated) {
+    replyText(c.fd, 400, "Too many arguments");
+    return;
+  }
+  route->handler(f, c.fd, args);
+}
+
+static void closeConn(Conn& c) {
+  close(c.fd);
+  c.fd = -1;
+}
+
+// Accepts and answers what arrived since the last pass; never waits
+static void serviceHttp(VirtualFeeder& f) {
+  if (f.listenFd < 0) return;
+  for (Conn& c : f.conns) {
+    if (c.fd >= 0) continue;
+    sockaddr_in peer;
+    socklen_t pl = sizeof(peer);
+    int fd = accept4(f.listenFd, (sockaddr*)&peer, &pl, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0) break;
+    c.fd = fd;
+    c.ip = ntohl(peer.sin_addr.s_addr);
+    c.openedMs = realMs();
+    c.len = 0;
+    c.buf[0] = '\0';
+  }
+  for (Conn& c : f.conns) {
+    if (c.fd < 0) continue;
+    ssize_t n = recv(c.fd, c.buf + c.len, sizeof(c.buf) - 1 - c.len, 0);
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+      closeConn(c);
+      continue;
+    }
+    if (n > 0) {
+      c.len += n;
+      c.buf[c.len] = '\0';
+    }
+    if (strstr(c.buf, "\r\n\r\n") || c.len == sizeof(c.buf) - 1) {
+      handleRequest(f, c);
+      closeConn(c);
+    } else if (realMs() - c.openedMs > REQUEST_TIMEOUT_MS) {
+      closeConn(c);
+    }
+  }
+}
+
+// ---- Thread pool ----
+
+class Pool {
+ public:
+  Pool(std::vector<std::unique_ptr<VirtualFeeder>>& fleet, int threads) : fleet_(fleet) {
+    for (int i = 0; i < threads; i++) workers_.emplace_back([this] { work(); });
+  }
+
+  ~Pool() {
+    {
+      std::lock_guard<std::mutex> l(m_);
+      stop_ = true;
+    }
+    start_.notify_all();
+    for (std::thread& t : workers_) t.join();
+  }
+
+  // One pass of every instance; returns when all are done
+  void round() {
+    {
+      std::lock_guard<std::mutex> l(m_);
+      next_.store(0);
+      busy_ = (int)workers_.size();
+      round_++;
+    }
+    start_.notify_all();
+    std::unique_lock<std::mutex> l(m_);
+    done_.wait(l, [this] { return busy_ == 0; });
+  }
+
+ private:
+  void work() {
+    uint64_t seen = 0;
+    int n = (int)fleet_.size();
+    for (;;) {
+      {
+        std::unique_lock<std::mutex> l(m_);
+        start_.wait(l, [&] { return stop_ || round_ != seen; });
+        if (stop_) return;
+        seen = round_;
+      }
+      int first;
+      while ((first = next_.fetch_add(CLAIM_CHUNK)) < n) {
+        for (int i = first; i < std::min(first + CLAIM_CHUNK, n); i++) {
+          VirtualFeeder& f = *fleet_[i];
+          uint64_t t0 = threadCpuNs();
+          serviceHttp(f);
+          loopPass(f);
+          uint64_t dt = threadCpuNs() - t0;
+          f.cpuNs += dt;
+          if (dt > f.maxPassNs) f.maxPassNs = dt;
+          f.passes++;
+        }
+      }
+      std::lock_guard<std::mutex> l(m_);
+      if (--busy_ == 0) done_.notify_one();
+    }
+  }
+
+  std::vector<std::unique_ptr<VirtualFeeder>>& fleet_;
+  std::vector<std::thread> workers_;
+  std::mutex m_;
+  std::condition_variable start_, done_;
+  std::atomic<int> next_{0};
+  uint64_t round_ = 0;
+  int busy_ = 0;
+  bool stop_ = false;
+};
+
+// ---- Fleet stats ----
+
+struct FleetStats {
+  double   realSecs;
+  double   virtualSecs;
+  uint64_t passes;
+  uint64_t cpuNs;
+  double   maxInstanceCpu;  // share of one core
+  uint64_t maxPassNs;
+  uint64_t requests;
+  uint64_t rejected;
+  uint64_t outcomes[4];
+  double   absErrorG;
+  double   deliveredErrG;
+  double   deliveredSqErrG;
+  uint64_t deliveredFeeds;
+  double   zeroSqErrG;
+  uint64_t zeroSamples;
+  size_t   stateBytes;
+  double   rssBytes;        // per instance
+};
+
+static long rssBytes() {
+  FILE* f = fopen("/proc/self/statm", "r");
+  if (!f) return 0;
+  long pages = 0, rss = 0;
+  if (fscanf(f, "%ld %ld", &pages, &rss) != 2) rss = 0;
+  fclose(f);
+  return rss * sysconf(_SC_PAGESIZE);
+}
+
+static FleetStats gather(const std::vector<std::unique_ptr<VirtualFeeder>>& fleet,
+                         double realSecs, double rssPerInstance) {
+  FleetStats s = {};
+  s.realSecs = realSecs;
+  s.virtualSecs = fleet.empty() ? 0 : fleet[0]->ms / 1000.0;
+  for (const auto& f : fleet) {
+    s.passes += f->passes;
+    s.cpuNs += f->cpuNs;
+    if (realSecs > 0) s.maxInstanceCpu = std::max(s.maxInstanceCpu, f->cpuNs / 1e9 / realSecs);
+    s.maxPassNs = std::max(s.maxPassNs, f->maxPassNs);
+    s.requests += f->requests;
+    s.rejected += f->rejected;
+    for (int k = 0; k < 4; k++) s.outcomes[k] += f->outcomes[k];
+    s.absErrorG += f->absErrorG;
+    s.deliveredErrG += f->deliveredErrG;
+    s.deliveredSqErrG += f->deliveredSqErrG;
+    s.deliveredFeeds += f->deliveredFeeds;
+    s.zeroSqErrG += f->zeroSqErrG;
+    s.zeroSamples += f->zeroSamples;
+  }
+  s.stateBytes = sizeof(VirtualFeeder);
+  s.rssBytes = rssPerInstance;
+  return s;
+}
+
+static uint64_t feedsDone(const FleetStats& s) {
+  return s.outcomes[FEED_TARGET_REACHED] + s.outcomes[FEED_STUCK] + s.outcomes[FEED_TIMEOUT];
+}
+
+// Of the feeds that reached their target: mean and RMS of landed - asked
+static double deliveredMeanG(const FleetStats& s) {
+  return s.deliveredFeeds ? s.deliveredErrG / s.deliveredFeeds : 0;
+}
+static double deliveredRmsG(const FleetStats& s) {
+  return s.deliveredFeeds ? sqrt(s.deliveredSqErrG / s.deliveredFeeds) : 0;
+}
+// RMS of the idle reading's error, noise included
+static double zeroRmsG(const FleetStats& s) {
+  return s.zeroSamples ? sqrt(s.zeroSqErrG / s.zeroSamples) : 0;
+}
+
+static void printStats(const FleetStats& s, int count) {
+  double cpuShare = s.realSecs > 0 ? s.cpuNs / 1e9 / s.realSecs / count : 0;
+  uint64_t feeds = feedsDone(s);
+  printf("%7.0fs  x%-6.1f %8.0f passes/s  cpu/inst %6.3f%% (max %.3f%%)  pass %6.1f us "
+         "(max %5.0f)  http %6.1f/s (%llu x 429)  feeds %llu (%llu/%llu/%llu) |err| %.2f g  "
+         "landed %+.2f g (rms %.2f)  idle rms %.2f g\n",
+         s.realSecs, s.realSecs > 0 ? s.virtualSecs / s.realSecs : 0,
+         s.realSecs > 0 ? s.passes / s.realSecs : 0, cpuShare * 100, s.maxInstanceCpu * 100,
+         s.passes ? s.cpuNs / 1e3 / s.passes : 0, s.maxPassNs / 1e3,
+         s.realSecs > 0 ? s.requests / s.realSecs : 0, (unsigned long long)s.rejected,
+         (unsigned long long)feeds, (unsigned long long)s.outcomes[FEED_TARGET_REACHED],
+         (unsigned long long)s.outcomes[FEED_STUCK],
+         (unsigned long long)s.outcomes[FEED_TIMEOUT], feeds ? s.absErrorG / feeds : 0,
+         deliveredMeanG(s), deliveredRmsG(s), zeroRmsG(s));
+  fflush(stdout);
+}
+
+static size_t writeStatsJson(char* out, size_t cap, const FleetStats& s, int count, int threads) {
+  uint64_t feeds = feedsDone(s);
+  int n = snprintf(out, cap,
+                   "{\"instances\":%d,\"threads\":%d,\"realSecs\":%.1f,\"virtualSecs\":%.1f,"
+                   "\"passes\":%llu,\"passesPerSec\":%.0f,\"cpuPerInstancePct\":%.4f,"
+                   "\"maxInstanceCpuPct\":%.4f,\"passUs\":%.2f,\"maxPassUs\":%.1f,"
+                   "\"stateBytes\":%zu,\"rssBytesPerInstance\":%.0f,\"requests\":%llu,"
+                   "\"rejected\":%llu,\"feeds\":%llu,\"reached\":%llu,\"stuck\":%llu,"
+                   "\"timeout\":%llu,\"meanAbsErrorG\":%.3f,\"landedErrorG\":%.3f,"
+                   "\"landedRmsG\":%.3f,\"idleRmsG\":%.3f}\n",
+                   count, threads, s.realSecs, s.virtualSecs, (unsigned long long)s.passes,
+                   s.realSecs > 0 ? s.passes / s.realSecs : 0,
+                   s.realSecs > 0 ? s.cpuNs / 1e9 / s.realSecs / count * 100 : 0,
+                   s.maxInstanceCpu * 100, s.passes ? s.cpuNs / 1e3 / s.passes : 0,
+                   s.maxPassNs / 1e3, s.stateBytes, s.rssBytes,
+                   (unsigned long long)s.requests, (unsigned long long)s.rejected,
+                   (unsigned long long)feeds, (unsigned long long)s.outcomes[FEED_TARGET_REACHED],
+                   (unsigned long long)s.outcomes[FEED_STUCK],
+                   (unsigned long long)s.outcomes[FEED_TIMEOUT], feeds ? s.absErrorG / feeds : 0,
+                   deliveredMeanG(s), deliveredRmsG(s), zeroRmsG(s));
+  return n > 0 && (size_t)n < cap ? n : 0;
+}
+
+// GET /fleet on --stats-port, answered between rounds
+static void serviceStats(int fd, const char* json, size_t len) {
+  int c;
+  while ((c = accept4(fd, nullptr, nullptr, SOCK_CLOEXEC)) >= 0) {
+    timeval tv = {0, 200000};
+    setsockopt(c, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    char req[512];
+    ssize_t n = recv(c, req, sizeof(req) - 1, 0);
+    req[n > 0 ? n : 0] = '\0';
+    if (strncmp(req, "GET /fleet", 10) == 0) reply(c, 200, "application/json", json, len);
+    else replyText(c, 404, "Not found");
+    close(c);
+  }
+}
+
+static volatile sig_atomic_t stopping = 0;
+static void onSignal(int) { stopping = 1; }
+
+// The whole file, or exits
+static std::shared_ptr<const Bytes> readImage(const char* path) {
+  FILE* in = fopen(path, "rb");
+  if (!in) {
+    fprintf(stderr, "%s: %s\n", path, strerror(errno));
+    exit(1);
+  }
+  auto image = std::make_shared<Bytes>();
+  uint8_t chunk[4096];
+  size_t n;
+  while ((n = fread(chunk, 1, sizeof(chunk), in)) > 0) image->insert(image->end(), chunk, chunk + n);
+  fclose(in);
+  return image;
+}
+
+static void usage() {
+  fprintf(stderr,
+          "usage: fleet_sim [-n COUNT] [--port P] [--threads T] [--speed X] [--duration SECS]\n"
+          "                 [--feed-every MIN] [--report SECS] [--seed N] [--json FILE]\n"
+          "                 [--stats-port P] [--ota-image FILE] [--ota-key HEX]\n"
+          "                 [--ota-token T] [--drift G_PER_H] [--span-error PCT]\n"
+          "                 [--calibrate GRAMS] [--zero-track 0|1]\n");
+  exit(2);
+}
+
+int main(int argc, char** argv) {
+  Options o;
+  for (int i = 1; i < argc; i++) {
+    std::string a = argv[i];
+    if (i + 1 >= argc) usage();
+    const char* v = argv[++i];
+    if (a == "-n")                o.count = atoi(v);
+    else if (a == "--port")       o.port = atoi(v);
+    else if (a == "--threads")    o.threads = atoi(v);
+    else if (a == "--speed")      o.speed = atof(v);
+    else if (a == "--duration")   o.durationSecs = atof(v);
+    else if (a == "--feed-every") o.feedEveryMin = atoi(v);
+    else if (a == "--report")     o.reportSecs = atof(v);
+    else if (a == "--seed")       o.seed = strtoul(v, nullptr, 10);
+    else if (a == "--json")       o.json = v;
+    else if (a == "--stats-port") o.statsPort = atoi(v);
+    else if (a == "--ota-image")  o.otaImage = readImage(v);
+    else if (a == "--ota-key")    o.otaKey = v;
+    else if (a == "--ota-token")  o.otaToken = v;
+    else if (a == "--drift")      o.driftGPerHour = atof(v);
+    else if (a == "--span-error") o.spanErrorPct = atof(v);
+    else if (a == "--calibrate")  o.calibrateG = atof(v);
+    else if (a == "--zero-track") o.zeroTracking = atoi(v) != 0;
+    else usage();
+  }
+  if (o.count <= 0 || o.speed < 0 || o.feedEveryMin < 0 || o.driftGPerHour < 0 ||
+      o.spanErrorPct < 0 || o.spanErrorPct >= 100 || o.calibrateG < 0) {
+    usage();
+  }
+  if (o.threads <= 0) o.threads = std::max(1u, std::thread::hardware_concurrency());
+  startNs = realNowNs();
+  signal(SIGINT, onSignal);
+  signal(SIGTERM, onSignal);
+
+  long rssBefore = rssBytes();
+  std::vector<std::unique_ptr<VirtualFeeder>> fleet;
+  fleet.reserve(o.count);
+  for (int i = 0; i < o.count; i++) {
+    fleet.emplace_back(new VirtualFeeder());
+    initFeeder(*fleet.back(), i, o);
+    if (o.port > 0) {
+      fleet.back()->listenFd = listenOn(o.port + i);
+      if (fleet.back()->listenFd < 0) {
+        fprintf(stderr, "port %d: %s\n", o.port + i, strerror(errno));
+        return 1;
+      }
+    }
+  }
+  double rssPerInstance = (double)(rssBytes() - rssBefore) / o.count;
+  int statsFd = -1;
+  if (o.statsPort > 0 && (statsFd = listenOn(o.statsPort)) < 0) {
+    fprintf(stderr, "stats port %d: %s\n", o.statsPort, strerror(errno));
+    return 1;
+  }
+
+  printf("%d feeders (%s), %d threads, %s, state %zu B, RSS +%.0f B per instance\n", o.count,
+         kBoard.name, o.threads, o.speed > 0 ? "paced" : "flat out", sizeof(VirtualFeeder),
+         rssPerInstance);
+  if (o.port > 0) printf("HTTP on ports %d-%d\n", o.port, o.port + o.count - 1);
+
+  Pool pool(fleet, o.threads);
+  uint64_t roundNs = o.speed > 0 ? (uint64_t)(PASS_MS * 1e6 / o.speed) : 0;
+  uint64_t runStart = realNowNs(), nextRound = runStart, nextReport = runStart;
+  uint64_t reportNs = (uint64_t)(o.reportSecs * 1e9), endNs = (uint64_t)(o.durationSecs * 1e9);
+  char json[1024];
+  size_t jsonLen = 0;
+  while (!stopping) {
+    pool.round();
+    uint64_t now = realNowNs();
+    if (endNs && now - runStart >= endNs) break;
+    if (reportNs && now >= nextReport + reportNs) {
+      nextReport = now;
+      printStats(gather(fleet, (now - runStart) / 1e9, rssPerInstance), o.count);
+    }
+    if (statsFd >= 0) {
+      FleetStats s = gather(fleet, (now - runStart) / 1e9, rssPerInstance);
+      jsonLen = writeStatsJson(json, sizeof(json), s, o.count, o.threads);
+      serviceStats(statsFd, json, jsonLen);
+    }
+    if (roundNs) {
+      nextRound += roundNs;
+      if (nextRound > now) {
+        timespec ts = {(time_t)((nextRound - now) / 1000000000ull),
+                       (long)((nextRound - now) % 1000000000ull)};
+        nanosleep(&ts, nullptr);
+      } else if (now - nextRound > 1000000000ull) {
+        nextRound = now;  // more than a second behind: stop trying to catch up
+      }
+    }
+  }
+
+  FleetStats s = gather(fleet, (realNowNs() - runStart) / 1e9, rssPerInstance);
+  printf("\n");
+  printStats(s, o.count);
+  if (o.json) {
+    jsonLen = writeStatsJson(json, sizeof(json), s, o.count, o.threads);
+    FILE* f = fopen(o.json, "w");
+    if (!f || fwrite(json, 1, jsonLen, f) != jsonLen) {
+      fprintf(stderr, "%s: cannot write\n", o.json);
+      return 1;
+    }
+    fclose(f);
+  }
+  for (auto& f : fleet) {
+    for (Conn& c : f->conns) if (c.fd >= 0) close(c.fd);
+    if (f->listenFd >= 0) close(f->listenFd);
+  }
+  return 0;
+}
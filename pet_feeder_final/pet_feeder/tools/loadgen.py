@@ -0,0 +1,291 @@
+#!/usr/bin/env python3
+"""Simulate N dashboard clients against a running feeder.
+
+    python tools/loadgen.py                          # Wokwi forward, 10 clients
+    python tools/loadgen.py http://192.168.1.50 -n 30 -d 120 --json run.json
+    python tools/loadgen.py -n 5 --hammer 4           # plus 4 runaway scripts
+
+Each virtual client behaves like include/web_ui.h in a browser tab: it loads
+the page once, polls /api/live on its own 2 s timer (started at a random
+offset, like tabs opened at different times) and fetches
+/api/status?since=<version> only when the live version moved. Optionally it
+also re-saves a slot (idempotent) or asks for a manual feed now and then.
+Manual feeds dispense real food on hardware, so they are off by default.
+
+--hammer N adds N scripts requesting --hammer-path back to back with no
+pause, the case admission control (lib/feeder_core/admission.h) is for:
+their excess should come back as 429 while the dashboards and the loop
+period stay close to the run without them. Comparing against an image built
+with -DFEEDER_ADMISSION=0 shows what the limits buy; /api/admission counts
+are printed after the run.
+
+Reports per-endpoint p50/p99/max latency, error rate and share of 429s,
+then the control-loop period from /api/loop: once idle (baseline) and once
+under load, so the cost of serving the clients shows up as loop jitter.
+
+Point this at Wokwi's localhost:8180 forward (wokwi.toml), a device on the
+LAN or one instance of tools/fleet_sim.cpp (which has no /api/loop, so the
+loop period is skipped there; the fleet simulator reports pass costs).
+"""
+
+import argparse
+import json
+import random
+import sys
+import threading
+import time
+import urllib.error
+import urllib.request
+
+DASHBOARD_POLL_S = 2.0  # setInterval(fetchLive, 2000) in web_ui.h
+
+
+class Recorder:
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.samples = {}  # label -> list of (latency_ms, ok, status)
+
+    def add(self, label, latency_ms, ok, status):
+        with self.lock:
+            self.samples.setdefault(label, []).append((latency_ms, ok, status))
+
+
+def request(base, path, timeout, method="GET"):
+    """Returns (status, body, latency_ms); status 0 on a network error."""
+    req = urllib.request.Request(base + path, method=method,
+                                 data=b"" if method == "POST" else None)
+    start = time.perf_counter()
+    try:
+        with urllib.request.urlopen(req, timeout=timeout) as r:
+            body = r.read()
+            status = r.status
+    except urllib.error.HTTPError as e:
+        body = e.read()
+        status = e.code
+    except (urllib.error.URLError, OSError):
+        body = b""
+        status = 0
+    return status, body, (time.perf_counter() - start) * 1000.0
+
+
+class Dashboard(threading.Thread):
+    def __init__(self, index, args, rec, stop):
+        super().__init__(daemon=True)
+        self.index = index
+        self.args = args
+        self.rec = rec
+        self.stop = stop
+        self.version = ""
+        self.slot = None
+        self.rng = random.Random(index)
+
+    def call(self, label, path, method="GET", ok_codes=(200,)):
+        status, body, ms = request(self.args.url, path, self.args.timeout, method)
+        self.rec.add(label, ms, status in ok_codes, status)
+        return status, body
+
+    def fetch_status(self):
+        status, body = self.call("status", "/api/status?since=" + self.version,
+                                 ok_codes=(200, 304))
+        if status != 200:
+            return
+        try:
+            doc = json.loads(body)
+        except ValueError:
+            return
+        if doc.get("slots"):
+            self.slot = doc["slots"][0]
+        self.version = doc.get("version", self.version)
+
+    def fetch_live(self):
+        status, body = self.call("live", "/api/live")
+        if status != 200:
+            return
+        try:
+            version = json.loads(body).get("version", "")
+        except ValueError:
+            return
+        if version != self.version:
+            self.fetch_status()
+
+    def maybe_act(self):
+        a = self.args
+        if a.save_every > 0 and self.slot and self.rng.random() < a.poll / a.save_every:
+            s = self.slot
+            self.call("set-slot", "/api/set-slot?index=0&hour=%d&minute=%d&weight=%d"
+                      % (s["hour"], s["minute"], s["weight"]), method="POST")
+        if a.feed_every > 0 and self.rng.random() < a.poll / a.feed_every:
+            self.call("manual-feed", "/api/manual-feed?amount=%d" % a.feed_amount,
+                      method="POST", ok_codes=(200, 202))
+
+    def run(self):
+        # Tabs open at different times, so timers are not in phase
+        if self.stop.wait(self.rng.uniform(0, self.args.poll)):
+            return
+        self.call("page", "/")
+        self.fetch_live()
+
+        next_tick = time.monotonic() + self.args.poll
+        while not self.stop.is_set():
+            # setInterval semantics: fixed rate, late ticks fire immediately
+            if self.stop.wait(max(0.0, next_tick - time.monotonic())):
+                break
+            next_tick += self.args.poll
+            self.fetch_live()
+            self.maybe_act()
+
+
+class Hammer(threading.Thread):
+    """A runaway script: the same request again as soon as the last one ends."""
+
+    def __init__(self, args, rec, stop):
+        super().__init__(daemon=True)
+        self.args = args
+        self.rec = rec
+        self.stop = stop
+
+    def run(self):
+        a = self.args
+        method = "POST" if a.hammer_post else "GET"
+        while not self.stop.is_set():
+            status, _, ms = request(a.url, a.hammer_path, a.timeout, method)
+            self.rec.add("hammer", ms, status in (200, 202, 304, 429), status)
+
+
+def percentile(sorted_values, q):
+    if not sorted_values:
+        return 0.0
+    rank = max(1, min(len(sorted_values), int(round(q * len(sorted_values)))))
+    return sorted_values[rank - 1]
+
+
+def summarize(samples):
+    lat = sorted(ms for ms, _, _ in samples)
+    errors = sum(1 for _, ok, _ in samples if not ok)
+    rejected = sum(1 for _, _, status in samples if status == 429)
+    return {
+        "requests": len(samples),
+        "errorRate": errors / len(samples) if samples else 0.0,
+        "rejectedRate": rejected / len(samples) if samples else 0.0,
+        "p50Ms": percentile(lat, 0.50),
+        "p99Ms": percentile(lat, 0.99),
+        "maxMs": lat[-1] if lat else 0.0,
+    }
+
+
+def get_json(base, path, timeout, tries=5):
+    """GET a JSON document, waiting out 429s from our own load."""
+    for _ in range(tries):
+        status, body, _ = request(base, path, timeout)
+        if status != 429:
+            break
+        time.sleep(1)
+    if status != 200:
+        return None
+    try:
+        return json.loads(body)
+    except ValueError:
+        return None
+
+
+def loop_stats(base, timeout, reset=False):
+    return get_json(base, "/api/loop" + ("?reset=1" if reset else ""), timeout)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    ap.add_argument("url", nargs="?", default="http://localhost:8180",
+                    help="feeder base URL (default: Wokwi forward)")
+    ap.add_argument("-n", "--clients", type=int, default=10)
+    ap.add_argument("-d", "--duration", type=float, default=60, help="seconds under load")
+    ap.add_argument("--baseline", type=float, default=10,
+                    help="idle seconds to measure loop jitter first (0 = skip)")
+    ap.add_argument("--poll", type=float, default=DASHBOARD_POLL_S)
+    ap.add_argument("--save-every", type=float, default=120,
+                    help="mean seconds between slot re-saves per client (0 = never)")
+    ap.add_argument("--feed-every", type=float, default=0,
+                    help="mean seconds between manual feeds per client (0 = never)")
+    ap.add_argument("--feed-amount", type=int, default=5)
+    ap.add_argument("--hammer", type=int, default=0,
+                    help="runaway clients requesting back to back (default 0)")
+    ap.add_argument("--hammer-path", default="/api/status")
+    ap.add_argument("--hammer-post", action="store_true", help="hammer with POST")
+    ap.add_argument("--timeout", type=float, default=5)
+    ap.add_argument("--json", help="also write the results here")
+    args = ap.parse_args()
+    args.url = args.url.rstrip("/")
+
+    baseline = None
+    if args.baseline > 0 and loop_stats(args.url, args.timeout, reset=True) is not None:
+        print("Measuring idle loop for %.0fs..." % args.baseline)
+        time.sleep(args.baseline)
+        baseline = loop_stats(args.url, args.timeout, reset=True)
+
+    print("Running %d dashboards%s for %.0fs against %s" % (
+        args.clients, " + %d hammering %s" % (args.hammer, args.hammer_path) if args.hammer else "",
+        args.duration, args.url))
+    rec = Recorder()
+    stop = threading.Event()
+    clients = [Dashboard(i, args, rec, stop) for i in range(args.clients)]
+    clients += [Hammer(args, rec, stop) for _ in range(args.hammer)]
+    loop_stats(args.url, args.timeout, reset=True)
+    get_json(args.url, "/api/admission?reset=1", args.timeout)
+    start = time.monotonic()
+    for c in clients:
+        c.start()
+    try:
+        time.sleep(args.duration)
+    except KeyboardInterrupt:
+        pass
+    stop.set()
+    elapsed = time.monotonic() - start
+    for c in clients:
+        c.join(args.timeout + 1)
+    loaded = loop_stats(args.url, args.timeout)
+    admission = get_json(args.url, "/api/admission", args.timeout)
+
+    results = {"clients": args.clients, "seconds": elapsed, "endpoints": {}}
+    all_samples = []
+    print("\n%-12s %8s %7s %7s %9s %9s %9s" % (
+        "endpoint", "requests", "err%", "429%", "p50 ms", "p99 ms", "max ms"))
+    for label in sorted(rec.samples):
+        s = summarize(rec.samples[label])
+        all_samples += rec.samples[label]
+        results["endpoints"][label] = s
+        print("%-12s %8d %6.1f%% %6.1f%% %9.1f %9.1f %9.1f" % (
+            label, s["requests"], 100 * s["errorRate"], 100 * s["rejectedRate"],
+            s["p50Ms"], s["p99Ms"], s["maxMs"]))
+    total = summarize(all_samples)
+    results["total"] = total
+    print("%-12s %8d %6.1f%% %6.1f%% %9.1f %9.1f %9.1f   (%.1f req/s)" % (
+        "total", total["requests"], 100 * total["errorRate"], 100 * total["rejectedRate"],
+        total["p50Ms"], total["p99Ms"], total["maxMs"],
+        total["requests"] / elapsed if elapsed else 0))
+
+    if admission:
+        results["admission"] = admission
+        print("\nadmission (%s)  %9s %9s %9s" % (
+            "on" if admission.get("enabled") else "off", "admitted", "rate", "busy"))
+        for lane, c in admission.get("lanes", {}).items():
+            print("%-15s %9d %9d %9d" % (lane, c["admitted"], c["rate"], c["busy"]))
+
+    if loaded is None:
+        print("\n/api/loop not available: no loop jitter figures")
+    else:
+        results["loop"] = {"idle": baseline, "load": loaded}
+        print("\nloop period   %9s %9s %9s" % ("p50 ms", "p99 ms", "max ms"))
+        for name, st in (("idle", baseline), ("under load", loaded)):
+            if st:
+                print("%-13s %9.1f %9.1f %9.1f" % (
+                    name, st["p50Us"] / 1000, st["p99Us"] / 1000, st["maxUs"] / 1000))
+        if baseline:
+            print("p99 stretch   %+9.1f ms" % ((loaded["p99Us"] - baseline["p99Us"]) / 1000))
+
+    if args.json:
+        with open(args.json, "w") as f:
+            json.dump(results, f, indent=2)
+    return 1 if total["requests"] == 0 else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
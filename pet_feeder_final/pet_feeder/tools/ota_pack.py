@@ -0,0 +1,219 @@
+#!/usr/bin/env python3
+"""Pack a firmware image for POST /api/ota (lib/feeder_core/ota_image.h).
+
+    python tools/ota_pack.py .pio/build/single_bowl/firmware.bin -o new.fota
+    python tools/ota_pack.py new.bin --base running.bin -o new.delta
+
+Without --base the image is LZ77-compressed against itself; with --base it
+is a delta that also copies from the image the feeder runs now (the .bin
+it was flashed with), so an update that changed little costs little to
+send. Copies reach back at most 1 << --window-bits bytes, which must not be
+more than the feeder's OTA window (16 KB). The packed file is unpacked
+again here and compared before it is written.
+"""
+
+import argparse
+import hashlib
+import struct
+import sys
+import time
+
+MAGIC = 0x41544F46  # "FOTA"
+VERSION = 1
+FLAG_DELTA = 0x01
+OP_LITERAL, OP_COPY, OP_BASE = 0, 1, 2
+
+MIN_COPY = 4          # shorter matches cost more than the literal bytes
+MIN_BASE = 6
+CHAIN = 24            # window candidates tried per position
+BASE_CANDIDATES = 8
+KEY = 4               # bytes hashed to find window matches
+BASE_KEY = 8
+
+
+def varint(x):
+    out = bytearray()
+    while x >= 0x80:
+        out.append((x & 0x7F) | 0x80)
+        x >>= 7
+    out.append(x)
+    return out
+
+
+def op(kind, length):
+    if length <= 63:
+        return bytearray([kind << 6 | (length - 1)])
+    return bytearray([kind << 6 | 63]) + varint(length - 64)
+
+
+def match_len(a, ai, b, bi, limit):
+    n = 0
+    while n + 32 <= limit and a[ai + n:ai + n + 32] == b[bi + n:bi + n + 32]:
+        n += 32
+    while n < limit and a[ai + n] == b[bi + n]:
+        n += 1
+    return n
+
+
+def index_base(base):
+    """Positions of every BASE_KEY-byte string in the base, the last few kept."""
+    table = {}
+    for i in range(0, len(base) - BASE_KEY + 1):
+        key = base[i:i + BASE_KEY]
+        hits = table.get(key)
+        if hits is None:
+            table[key] = [i]
+        elif len(hits) < BASE_CANDIDATES:
+            hits.append(i)
+    return table
+
+
+def pack(image, base=None, window_bits=14):
+    window = 1 << window_bits
+    out = bytearray(struct.pack("<IBBBBI", MAGIC, VERSION, FLAG_DELTA if base else 0,
+                                window_bits, 0, len(image)))
+    out += hashlib.sha256(image).digest()
+    out += struct.pack("<I", len(base) if base else 0)
+    out += hashlib.sha256(base).digest() if base else bytes(32)
+
+    base_table = index_base(base) if base else {}
+    chains = {}
+    cursor = 0
+    literal = bytearray()
+
+    def flush_literal():
+        if literal:
+            out.extend(op(OP_LITERAL, len(literal)))
+            out.extend(literal)
+            literal.clear()
+
+    i = 0
+    n = len(image)
+    while i < n:
+        best_len, best = 0, None
+        limit = n - i
+
+        # Straight on from the last base copy first: most of a rebuilt
+        # firmware is where it was, give or take a shift
+        if base:
+            if cursor < len(base):
+                l = match_len(image, i, base, cursor, min(limit, len(base) - cursor))
+                if l >= MIN_BASE:
+                    best_len, best = l, ("base", cursor)
+            for pos in base_table.get(image[i:i + BASE_KEY], ()):
+                l = match_len(image, i, base, pos, min(limit, len(base) - pos))
+                if l > best_len + 2:
+                    best_len, best = l, ("base", pos)
+
+        key = image[i:i + KEY]
+        hits = chains.get(key)
+        if hits:
+            for pos in reversed(hits[-CHAIN:]):
+                if i - pos > window:
+                    break
+                l = match_len(image, i, image, pos, limit)
+                if l > best_len:
+                    best_len, best = l, ("copy", pos)
+
+        if best and best_len >= (MIN_BASE if best[0] == "base" else MIN_COPY):
+            flush_literal()
+            if best[0] == "base":
+                move = best[1] - cursor
+                out.extend(op(OP_BASE, best_len))
+                out.extend(varint(move * 2 if move >= 0 else -move * 2 - 1))  # zigzag
+                cursor = best[1] + best_len
+            else:
+                out.extend(op(OP_COPY, best_len))
+                out.extend(varint(i - best[1]))
+            step = best_len
+        else:
+            literal.append(image[i])
+            step = 1
+
+        for j in range(i, min(i + step, n - KEY + 1)):
+            chains.setdefault(image[j:j + KEY], []).append(j)
+        i += step
+
+    flush_literal()
+    return bytes(out)
+
+
+def unpack(data, base=None):
+    """Reference decoder, the same steps as otaDecode()."""
+    magic, version, flags, window_bits, _, size = struct.unpack_from("<IBBBBI", data)
+    if magic != MAGIC or version != VERSION:
+        raise ValueError("not a packed image")
+    image_sha = data[12:44]
+    base_size = struct.unpack_from("<I", data, 44)[0]
+    if flags & FLAG_DELTA:
+        if base is None or len(base) != base_size or hashlib.sha256(base).digest() != data[48:80]:
+            raise ValueError("delta against another base")
+    out = bytearray()
+    pos = 80
+    cursor = 0
+
+    def read_varint():
+        nonlocal pos
+        x = shift = 0
+        while True:
+            b = data[pos]
+            pos += 1
+            x |= (b & 0x7F) << shift
+            shift += 7
+            if not b & 0x80:
+                return x
+
+    while len(out) < size:
+        tag = data[pos]
+        pos += 1
+        kind, length = tag >> 6, (tag & 0x3F) + 1
+        if length == 64:
+            length = 64 + read_varint()
+        if kind == OP_LITERAL:
+            out += data[pos:pos + length]
+            pos += length
+        elif kind == OP_COPY:
+            dist = read_varint()
+            if dist == 0 or dist > (1 << window_bits) or dist > len(out):
+                raise ValueError("copy out of the window")
+            for _ in range(length):
+                out.append(out[-dist])
+        else:
+            z = read_varint()
+            cursor += (z >> 1) ^ -(z & 1)
+            out += base[cursor:cursor + length]
+            cursor += length
+    if pos != len(data) or len(out) != size or hashlib.sha256(out).digest() != image_sha:
+        raise ValueError("image does not unpack")
+    return bytes(out)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__,
+                                 formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("image", help="firmware .bin to send")
+    ap.add_argument("--base", help="the .bin the feeder runs now: write a delta")
+    ap.add_argument("--window-bits", type=int, default=14, choices=range(8, 15))
+    ap.add_argument("-o", "--output", required=True)
+    args = ap.parse_args()
+
+    with open(args.image, "rb") as f:
+        image = f.read()
+    base = None
+    if args.base:
+        with open(args.base, "rb") as f:
+            base = f.read()
+
+    start = time.time()
+    packed = pack(image, base, args.window_bits)
+    secs = time.time() - start
+    unpack(packed, base)
+    with open(args.output, "wb") as f:
+        f.write(packed)
+    print("%s: %d -> %d bytes (%.1f%%), %s, %.1f s" % (
+        args.output, len(image), len(packed), 100.0 * len(packed) / len(image),
+        "delta" if base else "compressed", secs), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,198 @@
+#!/usr/bin/env python3
+"""Update a feeder over POST /api/ota from a local HTTP server.
+
+    python tools/ota_push.py http://192.168.1.50 new.bin --key ota_key.hex --token T
+    python tools/ota_push.py http://192.168.1.50 new.bin --base old.bin ...  # delta
+    python tools/ota_push.py http://localhost:9000 new.bin --base old.bin --mode all ...
+
+The image is packed here (tools/ota_pack.py), served from a one-off HTTP
+server on this machine and pulled by the feeder, which unpacks it into its
+inactive app slot and restarts into it. The run then waits until the new
+image is up and has passed its health check (GET /api/ota: "trial" false).
+Every update is signed with the release key (--key, tools/ota_sign.py) and
+sent with the feeder's bearer token (--token, its FEEDER_OTA_TOKEN).
+
+--mode full sends the .bin as it is, packed compresses it, delta also
+copies from --base, the image the feeder runs now. --mode all pushes each
+in turn, putting --base back (as a full image, not measured) before each
+one, and prints how the transfer and the time compare with the full image.
+On a board every update costs a restart and a minute of trial; against
+tools/fleet_sim.cpp (--ota-image old.bin) it takes seconds.
+
+Reported per update: bytes on the wire, the feeder's own time to download,
+unpack and write ("ms" of /api/ota), the time until the new image answered
+and until it was healthy, as seen from here.
+"""
+
+import argparse
+import http.server
+import json
+import os
+import socket
+import sys
+import threading
+import time
+import urllib.error
+import urllib.parse
+import urllib.request
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import ota_pack  # noqa: E402
+import ota_sign  # noqa: E402
+
+MODES = ("full", "packed", "delta")
+
+
+class ImageServer:
+    """Serves named byte strings with a Content-Length, which the feeder needs."""
+
+    def __init__(self, host, port):
+        files = self.files = {}
+
+        class Handler(http.server.BaseHTTPRequestHandler):
+            def do_GET(self):
+                body = files.get(self.path)
+                if body is None:
+                    self.send_error(404)
+                    return
+                self.send_response(200)
+                self.send_header("Content-Type", "application/octet-stream")
+                self.send_header("Content-Length", str(len(body)))
+                self.end_headers()
+                self.wfile.write(body)
+
+            def log_message(self, *args):
+                pass
+
+        self.httpd = http.server.ThreadingHTTPServer(("", port), Handler)
+        self.base = "http://%s:%d" % (host, self.httpd.server_address[1])
+        threading.Thread(target=self.httpd.serve_forever, daemon=True).start()
+
+    def add(self, name, data):
+        self.files["/" + name] = data
+        return self.base + "/" + name
+
+
+def local_address(device_url):
+    """The address of this machine on the route to the feeder."""
+    host = urllib.parse.urlparse(device_url).hostname
+    if host in ("localhost", "127.0.0.1"):
+        return "127.0.0.1"
+    with socket.socket(socket.AF_INET, socket.SOCK_DGRAM) as s:
+        s.connect((host, 80))
+        return s.getsockname()[0]
+
+
+def api(device, path, method="GET", timeout=120, token=None):
+    """Returns (status, parsed JSON or text); status 0 when unreachable."""
+    headers = {"Authorization": "Bearer " + token} if token else {}
+    req = urllib.request.Request(device + path, method=method, headers=headers,
+                                 data=b"" if method == "POST" else None)
+    try:
+        with urllib.request.urlopen(req, timeout=timeout) as r:
+            status, body = r.status, r.read()
+    except urllib.error.HTTPError as e:
+        status, body = e.code, e.read()
+    except (urllib.error.URLError, OSError):
+        return 0, None
+    try:
+        return status, json.loads(body)
+    except ValueError:
+        return status, body.decode("utf-8", "replace")
+
+
+def wait_healthy(device, old_running, timeout):
+    """Seconds until the other slot answered, and until it left its trial."""
+    start = time.monotonic()
+    up = None
+    while time.monotonic() - start < timeout:
+        status, body = api(device, "/api/ota", timeout=5)
+        if status == 200 and isinstance(body, dict) and body["running"] != old_running:
+            if up is None:
+                up = time.monotonic() - start
+            if not body["trial"]:
+                return up, time.monotonic() - start
+        time.sleep(0.5)
+    return up, None
+
+
+def push(device, server, name, data, sig, token, timeout):
+    """One update; returns the /api/ota report and the host-side times."""
+    status, before = api(device, "/api/ota")
+    if status != 200:
+        sys.exit("%s/api/ota: %s" % (device, before if status else "unreachable"))
+    query = {"url": server.add(name, data), "sig": sig.hex()}
+    start = time.monotonic()
+    status, body = api(device, "/api/ota?" + urllib.parse.urlencode(query), "POST",
+                       token=token)
+    sent = time.monotonic() - start
+    if status != 200:
+        sys.exit("update with %s failed (%d): %s" % (name, status, body))
+    up, healthy = wait_healthy(device, before["running"], timeout)
+    return body["last"], sent, up, healthy
+
+
+def prepare(mode, image, base, window_bits):
+    """(file name, bytes to send) of one mode."""
+    if mode == "full":
+        return "image.bin", image
+    start = time.time()
+    packed = ota_pack.pack(image, base if mode == "delta" else None, window_bits)
+    print("packed %s in %.1f s" % (mode, time.time() - start), file=sys.stderr)
+    return "image." + mode, packed
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__,
+                                 formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("device", help="feeder base URL, e.g. http://192.168.1.50")
+    ap.add_argument("image", help="firmware .bin to install")
+    ap.add_argument("--base", help="the .bin the feeder runs now")
+    ap.add_argument("--key", required=True, help="release key (tools/ota_sign.py new-key)")
+    ap.add_argument("--token", required=True, help="the feeder's FEEDER_OTA_TOKEN")
+    ap.add_argument("--mode", choices=MODES + ("all",),
+                    help="default: delta with --base, else packed")
+    ap.add_argument("--window-bits", type=int, default=14, choices=range(8, 15))
+    ap.add_argument("--serve-port", type=int, default=0, help="image server port (default: any)")
+    ap.add_argument("--timeout", type=float, default=300, help="seconds to wait for health")
+    args = ap.parse_args()
+
+    device = args.device.rstrip("/")
+    with open(args.image, "rb") as f:
+        image = f.read()
+    base = None
+    if args.base:
+        with open(args.base, "rb") as f:
+            base = f.read()
+    mode = args.mode or ("delta" if base else "packed")
+    if mode in ("delta", "all") and base is None:
+        sys.exit("--mode %s needs --base" % mode)
+
+    seed = ota_sign.read_key(args.key)
+    sig = ota_sign.image_signature(seed, image)  # the same image, however it is sent
+    server = ImageServer(local_address(device), args.serve_port)
+    modes = MODES if mode == "all" else (mode,)
+    rows = []
+    for i, m in enumerate(modes):
+        if mode == "all" and i > 0:
+            print("restoring the base image", file=sys.stderr)
+            push(device, server, "base.bin", base, ota_sign.image_signature(seed, base),
+                 args.token, args.timeout)
+        name, data = prepare(m, image, base, args.window_bits)
+        last, sent, up, healthy = push(device, server, name, data, sig, args.token, args.timeout)
+        rows.append((m, last, sent, up, healthy))
+        print("%s: %s" % (m, last["result"]), file=sys.stderr)
+
+    full = len(image)
+    print("%-7s %10s %7s %9s %9s %9s %9s" % ("mode", "transfer", "of full", "device",
+                                             "request", "answers", "healthy"))
+    for m, last, sent, up, healthy in rows:
+        print("%-7s %10d %6.1f%% %7d ms %7.1f s %7s %9s" % (
+            m, last["transferBytes"], 100.0 * last["transferBytes"] / full, last["ms"], sent,
+            "%.1f s" % up if up is not None else "-",
+            "%.1f s" % healthy if healthy is not None else "timeout"))
+    return 0 if all(r[4] is not None for r in rows) else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
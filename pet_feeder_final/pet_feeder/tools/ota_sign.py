@@ -0,0 +1,140 @@
+#!/usr/bin/env python3
+"""Release key and signatures for POST /api/ota (lib/feeder_core/ed25519.h).
+
+    python tools/ota_sign.py new-key ota_key.hex
+    python tools/ota_sign.py public ota_key.hex
+    python tools/ota_sign.py sign ota_key.hex firmware.bin
+
+A feeder takes an image only with an Ed25519 signature by the release key
+over the SHA-256 of the image as written to flash, i.e. of the plain .bin,
+however it is sent (full, packed or delta). new-key writes a private key
+(32 random bytes as hex; keep it out of the repository) and prints the
+public half, which goes into the build as FEEDER_OTA_KEY; sign prints the
+signature for the sig= argument. tools/ota_push.py signs by itself given
+--key.
+
+Plain RFC 8032 in Python, so no crypto package is needed; signing is slow
+(a fraction of a second) but only happens once per release.
+"""
+
+import argparse
+import hashlib
+import os
+import sys
+
+P = 2 ** 255 - 19
+L = 2 ** 252 + 27742317777372353535851937790883648493
+D = -121665 * pow(121666, P - 2, P) % P
+SQRT_M1 = pow(2, (P - 1) // 4, P)
+
+
+def _recover_x(y, sign):
+    xx = (y * y - 1) * pow(D * y * y + 1, P - 2, P)
+    x = pow(xx, (P + 3) // 8, P)
+    if (x * x - xx) % P:
+        x = x * SQRT_M1 % P
+    if x & 1 != sign:
+        x = P - x
+    return x
+
+
+_BY = 4 * pow(5, P - 2, P) % P
+_B = (_recover_x(_BY, 0), _BY, 1, _recover_x(_BY, 0) * _BY % P)
+
+
+def _add(p, q):
+    a = (p[1] - p[0]) * (q[1] - q[0]) % P
+    b = (p[1] + p[0]) * (q[1] + q[0]) % P
+    c = 2 * p[3] * q[3] * D % P
+    d = 2 * p[2] * q[2] % P
+    e, f, g, h = b - a, d - c, d + c, b + a
+    return (e * f % P, g * h % P, f * g % P, e * h % P)
+
+
+def _mul(s, p):
+    q = (0, 1, 1, 0)
+    while s:
+        if s & 1:
+            q = _add(q, p)
+        p = _add(p, p)
+        s >>= 1
+    return q
+
+
+def _encode(p):
+    zi = pow(p[2], P - 2, P)
+    x, y = p[0] * zi % P, p[1] * zi % P
+    return (y | (x & 1) << 255).to_bytes(32, "little")
+
+
+def _sha512_int(*parts):
+    return int.from_bytes(hashlib.sha512(b"".join(parts)).digest(), "little")
+
+
+def _expand(seed):
+    h = hashlib.sha512(seed).digest()
+    a = int.from_bytes(h[:32], "little")
+    a &= (1 << 254) - 8
+    a |= 1 << 254
+    return a, h[32:]
+
+
+def public_key(seed):
+    a, _ = _expand(seed)
+    return _encode(_mul(a, _B))
+
+
+def sign(seed, msg):
+    a, prefix = _expand(seed)
+    pub = _encode(_mul(a, _B))
+    r = _sha512_int(prefix, msg) % L
+    big_r = _encode(_mul(r, _B))
+    k = _sha512_int(big_r, pub, msg) % L
+    s = (r + k * a) % L
+    return big_r + s.to_bytes(32, "little")
+
+
+def image_signature(seed, image):
+    """The sig= of an image: the release key's signature of its SHA-256."""
+    return sign(seed, hashlib.sha256(image).digest())
+
+
+def read_key(path):
+    with open(path) as f:
+        seed = bytes.fromhex(f.read().strip())
+    if len(seed) != 32:
+        sys.exit("%s: not an OTA key (64 hex digits)" % path)
+    return seed
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__,
+                                 formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = ap.add_subparsers(dest="cmd", required=True)
+    p = sub.add_parser("new-key", help="write a new private key, print the public one")
+    p.add_argument("key")
+    p = sub.add_parser("public", help="print the public key for FEEDER_OTA_KEY")
+    p.add_argument("key")
+    p = sub.add_parser("sign", help="print the sig= of a plain .bin")
+    p.add_argument("key")
+    p.add_argument("image")
+    args = ap.parse_args()
+
+    if args.cmd == "new-key":
+        if os.path.exists(args.key):
+            sys.exit("%s exists" % args.key)
+        seed = os.urandom(32)
+        fd = os.open(args.key, os.O_WRONLY | os.O_CREAT | os.O_EXCL, 0o600)
+        with os.fdopen(fd, "w") as f:
+            f.write(seed.hex() + "\n")
+        print(public_key(seed).hex())
+    elif args.cmd == "public":
+        print(public_key(read_key(args.key)).hex())
+    else:
+        with open(args.image, "rb") as f:
+            print(image_signature(read_key(args.key), f.read()).hex())
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
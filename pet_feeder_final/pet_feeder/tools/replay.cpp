@@ -0,0 +1,222 @@
+// Replay feed recordings (GET /api/recordings) through the controller in
+// lib/feeder_core, to try dispense profiles and feed limits against real
+// feeds before flashing them (feed_rec.h explains the model).
+//
+//   curl -o feeds.rec http://feeder.local/api/recordings
+//   g++ -std=gnu++17 -O2 -Ilib/feeder_core -o replay tools/replay.cpp
+//       lib/feeder_core/{feed_rec,dispense,feed_monitor}.cpp
+//   ./replay feeds.rec                  # recorded settings: should match
+//   ./replay --mode pulse feeds.rec older.rec
+//   ./replay --trickle-band 8 --trickle-pct 30 --stuck-ms 2500 feeds.rec
+//
+// Profile options start from the table profile of --mode (default: each
+// feed's own): --open, --trickle-pct, --trickle-band, --pulse-on,
+// --pulse-off, --agitate (moves, 0 = off), --tries. Limits default to the
+// feed's recorded ones: --stuck-ms, --min-inc, --timeout-ms (else the
+// recorded timeout rescaled for the profile). The feeder: --fall-ms (else
+// estimated per feed) and --deadband (opening % below which nothing flows,
+// default 0).
+//
+// Prints every feed recorded vs replayed, then the mean and worst error,
+// the mean overshoot and the mean time to target of each.
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <string>
+#include <vector>
+#include "feed_rec.h"
+
+struct Options {
+  int mode = -1;  // the feed's own
+  int openPct = -1, tricklePct = -1, pulseOnMs = -1, pulseOffMs = -1;
+  int agitateMoves = -1, agitateTries = -1;
+  float trickleBandG = -1;
+  long stuckMs = -1, timeoutMs = -1, fallMs = -1;
+  float minIncreaseG = -1;
+  int deadbandPct = 0;
+};
+
+struct Feed {
+  FeedRecHeader header;
+  std::vector<FeedRecSample> samples;
+};
+
+static bool loadFile(const char* path, std::vector<Feed>& feeds) {
+  FILE* f = fopen(path, "rb");
+  if (!f) {
+    fprintf(stderr, "%s: cannot open\n", path);
+    return false;
+  }
+  long offset = 0;
+  for (;;) {
+    Feed feed;
+    size_t got = fread(&feed.header, 1, sizeof(feed.header), f);
+    if (got == 0) break;
+    if (got < sizeof(feed.header) || feed.header.magic != REC_MAGIC) {
+      fprintf(stderr, "%s: no feed at offset %ld, stopping\n", path, offset);
+      break;
+    }
+    feed.samples.resize(feed.header.samples);
+    size_t bytes = feed.header.samples * sizeof(FeedRecSample);
+    if (fread(feed.samples.data(), 1, bytes, f) < bytes) {
+      fprintf(stderr, "%s: feed %u cut short (power cut while saving?), stopping\n", path,
+              (unsigned)feed.header.seq);
+      break;
+    }
+    offset += sizeof(feed.header) + bytes;
+    feeds.push_back(std::move(feed));
+  }
+  fclose(f);
+  return true;
+}
+
+// Timeout for `pr` from a feed recorded with the table profile of `mode`
+static uint32_t rescaleTimeout(uint32_t recorded, uint8_t mode, const DispenseProfile& pr) {
+  const DispenseProfile& was = kDispenseProfiles[mode < DISPENSE_MODE_COUNT ? mode : 0];
+  uint32_t agitating = (uint32_t)was.agitateTries * was.agitateMoves * was.agitateStepMs;
+  uint32_t base = recorded > agitating ? recorded - agitating : recorded;
+  return dispenseProfileTimeoutMs(pr, (uint32_t)((uint64_t)base * 100 / was.timeoutPct));
+}
+
+static ReplayParams paramsFor(const Feed& feed, const Options& o) {
+  const FeedRecHeader& h = feed.header;
+  uint32_t fall = o.fallMs >= 0 ? (uint32_t)o.fallMs
+                                : recEstimateFallMs(h, feed.samples.data(), h.samples, o.deadbandPct);
+  ReplayParams p = recRecordedParams(h, fall, o.deadbandPct);
+  bool changed = false;
+  if (o.mode >= 0) {
+    p.mode = o.mode;
+    p.profile = kDispenseProfiles[o.mode];
+    changed = p.mode != h.mode;
+  }
+  DispenseProfile& pr = p.profile;
+  if (o.openPct >= 0)      { pr.openPct = o.openPct; changed = true; }
+  if (o.tricklePct >= 0)   { pr.tricklePct = o.tricklePct; changed = true; }
+  if (o.trickleBandG >= 0) { pr.trickleBandG = o.trickleBandG; changed = true; }
+  if (o.pulseOnMs >= 0)    { pr.pulseOnMs = o.pulseOnMs; changed = true; }
+  if (o.pulseOffMs >= 0)   { pr.pulseOffMs = o.pulseOffMs; changed = true; }
+  if (o.agitateMoves >= 0) { pr.agitateMoves = o.agitateMoves; changed = true; }
+  if (o.agitateTries >= 0) { pr.agitateTries = o.agitateTries; changed = true; }
+
+  if (o.timeoutMs >= 0) {
+    p.limits.timeoutMs = o.timeoutMs;
+  } else if (changed) {
+    p.limits.timeoutMs = rescaleTimeout(h.timeoutMs, h.mode, pr);
+  }
+  if (o.stuckMs >= 0) p.limits.stuckWindowMs = o.stuckMs;
+  if (o.minIncreaseG >= 0) p.limits.minIncreaseG = o.minIncreaseG;
+  return p;
+}
+
+static const char* outcomeName(uint8_t c) {
+  switch (c) {
+    case FEED_TARGET_REACHED: return "target";
+    case FEED_STUCK:          return "stuck";
+    case FEED_TIMEOUT:        return "timeout";
+    default:                  return "?";
+  }
+}
+
+struct Summary {
+  int      feeds = 0;
+  int      outcomes[4] = {0, 0, 0, 0};
+  double   absError = 0, worstError = 0, overshoot = 0;
+  double   targetMs = 0;
+
+  void add(const ReplayResult& r) {
+    feeds++;
+    if (r.outcome < 4) outcomes[r.outcome]++;
+    absError += fabs(r.errorG);
+    if (fabs(r.errorG) > fabs(worstError)) worstError = r.errorG;
+    if (r.errorG > 0) overshoot += r.errorG;
+    if (r.outcome == FEED_TARGET_REACHED) targetMs += r.closeMs;
+  }
+
+  void print(const char* name) const {
+    int reached = outcomes[FEED_TARGET_REACHED];
+    printf("  %-9s %8.2f g %+8.2f g %8.2f g %8.2f s   %d/%d/%d\n", name,
+           feeds ? absError / feeds : 0.0, worstError, feeds ? overshoot / feeds : 0.0,
+           reached ? targetMs / reached / 1000.0 : 0.0, reached, outcomes[FEED_STUCK],
+           outcomes[FEED_TIMEOUT]);
+  }
+};
+
+static void usage() {
+  fprintf(stderr,
+          "usage: replay [--mode full|trickle|pulse] [--open PCT] [--trickle-pct PCT]\n"
+          "              [--trickle-band G] [--pulse-on MS] [--pulse-off MS] [--agitate N]\n"
+          "              [--tries N] [--stuck-ms MS] [--min-inc G] [--timeout-ms MS]\n"
+          "              [--fall-ms MS] [--deadband PCT] feeds.rec...\n");
+  exit(2);
+}
+
+int main(int argc, char** argv) {
+  Options o;
+  std::vector<std::string> files;
+  for (int i = 1; i < argc; i++) {
+    std::string a = argv[i];
+    if (a.rfind("--", 0) != 0) {
+      files.push_back(a);
+      continue;
+    }
+    if (i + 1 >= argc) usage();
+    const char* v = argv[++i];
+    uint8_t m;
+    if (a == "--mode" && parseDispenseMode(v, m)) o.mode = m;
+    else if (a == "--open")         o.openPct = atoi(v);
+    else if (a == "--trickle-pct")  o.tricklePct = atoi(v);
+    else if (a == "--trickle-band") o.trickleBandG = atof(v);
+    else if (a == "--pulse-on")     o.pulseOnMs = atoi(v);
+    else if (a == "--pulse-off")    o.pulseOffMs = atoi(v);
+    else if (a == "--agitate")      o.agitateMoves = atoi(v);
+    else if (a == "--tries")        o.agitateTries = atoi(v);
+    else if (a == "--stuck-ms")     o.stuckMs = atol(v);
+    else if (a == "--min-inc")      o.minIncreaseG = atof(v);
+    else if (a == "--timeout-ms")   o.timeoutMs = atol(v);
+    else if (a == "--fall-ms")      o.fallMs = atol(v);
+    else if (a == "--deadband")     o.deadbandPct = atoi(v);
+    else usage();
+  }
+  if (files.empty()) usage();
+
+  std::vector<Feed> feeds;
+  for (const std::string& f : files) {
+    if (!loadFile(f.c_str(), feeds)) return 1;
+  }
+  if (feeds.empty()) {
+    fprintf(stderr, "no feeds recorded\n");
+    return 1;
+  }
+
+  printf("   seq  started (UTC)     target  profile    recorded                  "
+         "replayed\n");
+  Summary recorded, replayed;
+  for (const Feed& feed : feeds) {
+    const FeedRecHeader& h = feed.header;
+    ReplayParams params = paramsFor(feed, o);
+    ReplayResult was, now;
+    recRecordedResult(h, feed.samples.data(), h.samples, was);
+    recReplay(h, feed.samples.data(), h.samples, params, now);
+    recorded.add(was);
+    replayed.add(now);
+
+    char when[32];
+    time_t t = h.time;
+    strftime(when, sizeof(when), "%Y-%m-%d %H:%M", gmtime(&t));
+    printf("  %4u  %s  %6.1f  %-7s->%-7s %-7s %5.1f s %+6.1f g   %-7s %5.1f s %+6.1f g %s%s%s\n",
+           (unsigned)h.seq, when, h.target, dispenseModeName(h.mode),
+           dispenseModeName(params.mode), outcomeName(was.outcome), was.closeMs / 1000.0f,
+           was.errorG, outcomeName(now.outcome), now.closeMs / 1000.0f, now.errorG,
+           (h.flags & REC_TRUNCATED) ? " truncated" : "",
+           (h.flags & REC_UNSETTLED) ? " unsettled" : "",
+           now.extrapolated ? " extrapolated" : "");
+  }
+
+  printf("\n  %-9s %10s %10s %10s %10s   %s\n", "", "mean |err|", "worst", "overshoot",
+         "to target", "target/stuck/timeout");
+  recorded.print("recorded");
+  replayed.print("replayed");
+  return 0;
+}
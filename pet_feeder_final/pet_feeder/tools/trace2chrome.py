@@ -0,0 +1,98 @@
+#!/usr/bin/env python3
+"""Convert a /api/trace dump into Chrome trace JSON.
+
+    python tools/trace2chrome.py http://localhost:8180/api/trace -o trace.json
+    python tools/trace2chrome.py dump.bin -o trace.json
+
+Open the result in chrome://tracing or https://ui.perfetto.dev. Each CPU core
+is a thread row; ISR records go on their own row. micros() wraps every ~71
+minutes, so timestamps are unwrapped in sequence order.
+"""
+
+import argparse
+import json
+import struct
+import sys
+import urllib.request
+
+HEADER = struct.Struct("<4sHHII")
+RECORD = struct.Struct("<IIiHBB")
+ISR_CONTEXT = 0xFF
+
+
+def load(source):
+    if source.startswith("http://") or source.startswith("https://"):
+        with urllib.request.urlopen(source, timeout=10) as r:
+            return r.read()
+    with open(source, "rb") as f:
+        return f.read()
+
+
+def parse(blob):
+    magic, version, record_size, count, names_len = HEADER.unpack_from(blob, 0)
+    if magic != b"FTRC":
+        raise ValueError("not a feeder trace dump")
+    if version != 1 or record_size != RECORD.size:
+        raise ValueError("unsupported dump version %d / record size %d"
+                         % (version, record_size))
+
+    offset = HEADER.size
+    names = {}
+    for line in blob[offset:offset + names_len].decode().splitlines():
+        event_id, _, name = line.partition(":")
+        names[int(event_id)] = name
+    offset += names_len
+
+    records = []
+    for i in range(count):
+        rec = RECORD.unpack_from(blob, offset + i * RECORD.size)
+        if rec[0] != 0:  # seq 0 = slot overwritten while dumping
+            records.append(rec)
+    records.sort(key=lambda r: r[0])
+    return names, records
+
+
+def to_chrome(names, records):
+    events = []
+    wrap = 0
+    prev_ts = None
+    for seq, ts, arg, event_id, phase, context in records:
+        if prev_ts is not None and ts < prev_ts and prev_ts - ts > 1 << 31:
+            wrap += 1 << 32
+        prev_ts = ts
+
+        name = names.get(event_id, "event%d" % event_id)
+        tid = "isr" if context == ISR_CONTEXT else "core%d" % context
+        ev = {"name": name, "ph": chr(phase), "ts": ts + wrap,
+              "pid": 1, "tid": tid}
+        if chr(phase) == "C":  # counters carry tenths (e.g. 0.1 g)
+            ev["args"] = {name: arg / 10.0}
+        elif chr(phase) == "i":
+            ev["s"] = "t"
+            ev["args"] = {"arg": arg, "seq": seq}
+        elif arg:
+            ev["args"] = {"arg": arg}
+        events.append(ev)
+
+    return {"traceEvents": events, "displayTimeUnit": "ms"}
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__,
+                                 formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("source", help="dump file or /api/trace URL")
+    ap.add_argument("-o", "--output", default="-", help="output JSON (default stdout)")
+    args = ap.parse_args()
+
+    names, records = parse(load(args.source))
+    doc = to_chrome(names, records)
+    out = sys.stdout if args.output == "-" else open(args.output, "w")
+    json.dump(doc, out)
+    if out is not sys.stdout:
+        out.close()
+        print("%d events -> %s" % (len(doc["traceEvents"]), args.output),
+              file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()